@@ -15,5 +15,6 @@
 
 void kernel_neon_begin(void);
 void kernel_neon_end(void);
+bool kernel_neon_yield(void);
 
 #endif /* ! __ASM_NEON_H */
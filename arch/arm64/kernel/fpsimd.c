@@ -16,6 +16,7 @@
 #include <linux/cpu.h>
 #include <linux/cpu_pm.h>
 #include <linux/ctype.h>
+#include <linux/debugfs.h>
 #include <linux/kernel.h>
 #include <linux/linkage.h>
 #include <linux/irqflags.h>
@@ -26,6 +27,7 @@
 #include <linux/ptrace.h>
 #include <linux/sched/signal.h>
 #include <linux/sched/task_stack.h>
+#include <linux/seq_file.h>
 #include <linux/signal.h>
 #include <linux/slab.h>
 #include <linux/stddef.h>
@@ -1468,10 +1470,18 @@ void do_sme_acc(unsigned long esr, struct pt_regs *regs)
 
 /*
  * Trapped FP/ASIMD access.
+ *
+ * EL0 FP/ASIMD access is never trapped: the userland FPSIMD state is
+ * restored eagerly on return to userspace, and only when it isn't already
+ * live in the registers (see TIF_FOREIGN_FPSTATE above). Leaving the
+ * registers of a previous task in place behind an access trap would be
+ * exposed to the "lazy FP" class of speculative side channels, and it
+ * would break the invariant that a clear TIF_FOREIGN_FPSTATE means the
+ * registers hold current's state, which fpsimd_save(), kernel mode NEON
+ * and KVM all rely on.
  */
 void do_fpsimd_acc(unsigned long esr, struct pt_regs *regs)
 {
-	/* TODO: implement lazy context saving/restoring */
 	WARN_ON(1);
 }
 
@@ -1811,6 +1821,9 @@ void fpsimd_save_and_flush_cpu_state(void)
  * Kernel-side NEON support functions
  */
 
+/* Number of kernel mode NEON sections entered on each CPU */
+static DEFINE_PER_CPU(unsigned long, kernel_neon_sections);
+
 /*
  * kernel_neon_begin(): obtain the CPU FPSIMD registers for use by the calling
  * context
@@ -1838,6 +1851,8 @@ void kernel_neon_begin(void)
 
 	/* Invalidate any task state remaining in the fpsimd regs: */
 	fpsimd_flush_cpu_state();
+
+	__this_cpu_inc(kernel_neon_sections);
 }
 EXPORT_SYMBOL(kernel_neon_begin);
 
@@ -1859,6 +1874,65 @@ void kernel_neon_end(void)
 }
 EXPORT_SYMBOL(kernel_neon_end);
 
+/*
+ * kernel_neon_yield(): offer a preemption point inside a NEON section
+ *
+ * Callers processing many short buffers can hold the FPSIMD registers
+ * across the whole batch with a single kernel_neon_begin()/kernel_neon_end()
+ * pair, and call this between buffers. The user state is only saved once
+ * per batch, while the batch doesn't delay rescheduling or pending softirqs
+ * for longer than a single buffer.
+ *
+ * If a reschedule or softirq is due, the registers are given back, the task
+ * may be scheduled out, and the registers are claimed again. In that case
+ * true is returned and the caller must assume the FPSIMD register contents
+ * are lost.
+ *
+ * The task is only scheduled out if the caller's context is preemptible once
+ * the registers are given back. Callers holding a spinlock, or running in
+ * softirq context, only let pending softirqs run where that is possible.
+ */
+bool kernel_neon_yield(void)
+{
+	if (!system_supports_fpsimd())
+		return false;
+
+	if (!need_resched() && !local_softirq_pending())
+		return false;
+
+	kernel_neon_end();
+	if (preemptible())
+		cond_resched();
+	kernel_neon_begin();
+
+	return true;
+}
+EXPORT_SYMBOL(kernel_neon_yield);
+
+#ifdef CONFIG_DEBUG_FS
+static int kernel_neon_sections_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		seq_printf(m, "cpu%d %lu\n", cpu,
+			   per_cpu(kernel_neon_sections, cpu));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(kernel_neon_sections);
+
+static int __init kernel_neon_debugfs_init(void)
+{
+	if (system_supports_fpsimd())
+		debugfs_create_file("kernel_neon_sections", 0444, NULL, NULL,
+				    &kernel_neon_sections_fops);
+
+	return 0;
+}
+late_initcall(kernel_neon_debugfs_init);
+#endif /* CONFIG_DEBUG_FS */
+
 #ifdef CONFIG_EFI
 
 static DEFINE_PER_CPU(struct user_fpsimd_state, efi_fpsimd_state);
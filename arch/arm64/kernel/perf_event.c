@@ -890,7 +890,26 @@ static irqreturn_t armv8pmu_handle_irq(struct arm_pmu *cpu_pmu)
 static int armv8pmu_get_single_idx(struct pmu_hw_events *cpuc,
 				    struct arm_pmu *cpu_pmu)
 {
-	int idx;
+	int idx, pair;
+
+	/*
+	 * Prefer a counter whose chaining partner is already busy (or
+	 * doesn't exist), so that free even/odd pairs are left for chained
+	 * events. Otherwise a group mixing 32-bit and 64-bit events can fail
+	 * to schedule, and get multiplexed, while enough counters are free.
+	 */
+	for (idx = ARMV8_IDX_COUNTER0; idx < cpu_pmu->num_events; idx++) {
+		if (test_bit(idx, cpuc->used_mask))
+			continue;
+
+		pair = (idx - ARMV8_IDX_COUNTER0) & 1 ? idx - 1 : idx + 1;
+		if (pair < cpu_pmu->num_events &&
+		    !test_bit(pair, cpuc->used_mask))
+			continue;
+
+		if (!test_and_set_bit(idx, cpuc->used_mask))
+			return idx;
+	}
 
 	for (idx = ARMV8_IDX_COUNTER0; idx < cpu_pmu->num_events; idx++) {
 		if (!test_and_set_bit(idx, cpuc->used_mask))
@@ -20,6 +20,7 @@
 #include "blk-mq-debugfs.h"
 #include "blk-mq-sched.h"
 #include "blk-mq-tag.h"
+#include "blk-stat.h"
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/kyber.h>
@@ -75,6 +76,21 @@ static const u64 kyber_latency_targets[] = {
 	[KYBER_DISCARD] = 5ULL * NSEC_PER_SEC,
 };
 
+/*
+ * With auto_lat enabled, the read and write targets are derived from blk-stat
+ * data instead: the mean device latency in the least loaded window seen so far
+ * is taken as the device's unloaded latency, and the target is a multiple of
+ * it. The baseline drifts up by 1/8 per window with samples so that a device
+ * which got slower will be re-learned. Under sustained load every window is a
+ * loaded one, so the drift is capped: the baseline never goes past the value
+ * that gives KYBER_AUTO_LAT_MAX_MULT times the default target.
+ */
+#define KYBER_AUTO_LAT_WINDOW_MSEC	1000
+#define KYBER_AUTO_LAT_MIN_SAMPLES	32
+#define KYBER_AUTO_LAT_MULT		4
+#define KYBER_AUTO_LAT_MAX_MULT		2
+#define KYBER_AUTO_LAT_MIN_NSEC		(100 * NSEC_PER_USEC)
+
 /*
  * Batch size (number of requests we'll dispatch in a row) for each scheduling
  * domain.
@@ -178,6 +194,11 @@ struct kyber_queue_data {
 
 	/* Target latencies in nanoseconds. */
 	u64 latency_targets[KYBER_OTHER];
+
+	/* Latency target auto-calibration, for KYBER_READ and KYBER_WRITE. */
+	struct blk_stat_callback *lat_cb;
+	bool auto_lat;
+	u64 lat_baseline[KYBER_DISCARD];
 };
 
 struct kyber_hctx_data {
@@ -356,6 +377,44 @@ static void kyber_timer_fn(struct timer_list *t)
 	}
 }
 
+static int kyber_lat_bucket(const struct request *rq)
+{
+	unsigned int sched_domain = kyber_sched_domain(rq->cmd_flags);
+
+	return sched_domain < KYBER_DISCARD ? sched_domain : -1;
+}
+
+static void kyber_lat_timer_fn(struct blk_stat_callback *cb)
+{
+	struct kyber_queue_data *kqd = cb->data;
+	unsigned int sched_domain;
+
+	for (sched_domain = 0; sched_domain < KYBER_DISCARD; sched_domain++) {
+		struct blk_rq_stat *stat = &cb->stat[sched_domain];
+		u64 base = kqd->lat_baseline[sched_domain];
+		u64 max_base;
+
+		if (stat->nr_samples < KYBER_AUTO_LAT_MIN_SAMPLES)
+			continue;
+
+		max_base = kyber_latency_targets[sched_domain] *
+			   KYBER_AUTO_LAT_MAX_MULT / KYBER_AUTO_LAT_MULT;
+
+		base += base >> 3;
+		if (!base || stat->mean < base)
+			base = stat->mean;
+		base = min(base, max_base);
+		kqd->lat_baseline[sched_domain] = base;
+
+		kqd->latency_targets[sched_domain] =
+			max_t(u64, base * KYBER_AUTO_LAT_MULT,
+			      KYBER_AUTO_LAT_MIN_NSEC);
+	}
+
+	if (READ_ONCE(kqd->auto_lat))
+		blk_stat_activate_msecs(cb, KYBER_AUTO_LAT_WINDOW_MSEC);
+}
+
 static struct kyber_queue_data *kyber_queue_data_alloc(struct request_queue *q)
 {
 	struct kyber_queue_data *kqd;
@@ -376,6 +435,12 @@ static struct kyber_queue_data *kyber_queue_data_alloc(struct request_queue *q)
 
 	timer_setup(&kqd->timer, kyber_timer_fn, 0);
 
+	kqd->lat_cb = blk_stat_alloc_callback(kyber_lat_timer_fn,
+					      kyber_lat_bucket, KYBER_DISCARD,
+					      kqd);
+	if (!kqd->lat_cb)
+		goto err_percpu;
+
 	for (i = 0; i < KYBER_NUM_DOMAINS; i++) {
 		WARN_ON(!kyber_depth[i]);
 		WARN_ON(!kyber_batch_size[i]);
@@ -397,6 +462,8 @@ static struct kyber_queue_data *kyber_queue_data_alloc(struct request_queue *q)
 	return kqd;
 
 err_buckets:
+	blk_stat_free_callback(kqd->lat_cb);
+err_percpu:
 	free_percpu(kqd->cpu_latency);
 err_kqd:
 	kfree(kqd);
@@ -420,6 +487,7 @@ static int kyber_init_sched(struct request_queue *q, struct elevator_type *e)
 	}
 
 	blk_stat_enable_accounting(q);
+	blk_stat_add_callback(q, kqd->lat_cb);
 
 	blk_queue_flag_clear(QUEUE_FLAG_SQ_SCHED, q);
 
@@ -435,6 +503,9 @@ static void kyber_exit_sched(struct elevator_queue *e)
 	int i;
 
 	del_timer_sync(&kqd->timer);
+	WRITE_ONCE(kqd->auto_lat, false);
+	blk_stat_remove_callback(kqd->q, kqd->lat_cb);
+	blk_stat_free_callback(kqd->lat_cb);
 	blk_stat_disable_accounting(kqd->q);
 
 	for (i = 0; i < KYBER_NUM_DOMAINS; i++)
@@ -889,10 +960,44 @@ KYBER_LAT_SHOW_STORE(KYBER_READ, read);
 KYBER_LAT_SHOW_STORE(KYBER_WRITE, write);
 #undef KYBER_LAT_SHOW_STORE
 
+static ssize_t kyber_auto_lat_show(struct elevator_queue *e, char *page)
+{
+	struct kyber_queue_data *kqd = e->elevator_data;
+
+	return sprintf(page, "%d\n", kqd->auto_lat);
+}
+
+static ssize_t kyber_auto_lat_store(struct elevator_queue *e,
+				    const char *page, size_t count)
+{
+	struct kyber_queue_data *kqd = e->elevator_data;
+	bool enable;
+	int ret;
+
+	ret = kstrtobool(page, &enable);
+	if (ret)
+		return ret;
+
+	if (enable == kqd->auto_lat)
+		return count;
+
+	WRITE_ONCE(kqd->auto_lat, enable);
+	if (enable) {
+		memset(kqd->lat_baseline, 0, sizeof(kqd->lat_baseline));
+		blk_stat_activate_msecs(kqd->lat_cb,
+					KYBER_AUTO_LAT_WINDOW_MSEC);
+	} else {
+		blk_stat_deactivate(kqd->lat_cb);
+	}
+
+	return count;
+}
+
 #define KYBER_LAT_ATTR(op) __ATTR(op##_lat_nsec, 0644, kyber_##op##_lat_show, kyber_##op##_lat_store)
 static struct elv_fs_entry kyber_sched_attrs[] = {
 	KYBER_LAT_ATTR(read),
 	KYBER_LAT_ATTR(write),
+	__ATTR(auto_lat, 0644, kyber_auto_lat_show, kyber_auto_lat_store),
 	__ATTR_NULL
 };
 #undef KYBER_LAT_ATTR
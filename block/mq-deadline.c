@@ -92,6 +92,7 @@ struct deadline_data {
 	enum dd_data_dir last_dir;
 	unsigned int batching;		/* number of sequential requests made */
 	unsigned int starved;		/* times reads have starved writes */
+	sector_t write_window_start;	/* window of the current write batch */
 
 	/*
 	 * settings that change how the i/o scheduler behaves
@@ -102,6 +103,7 @@ struct deadline_data {
 	int front_merges;
 	u32 async_depth;
 	int prio_aging_expire;
+	int write_window_kb;
 
 	spinlock_t lock;
 	spinlock_t zone_lock;
@@ -324,6 +326,43 @@ static struct request *deadline_skip_seq_writes(struct deadline_data *dd,
 	return rq;
 }
 
+/*
+ * Flash-aware write batching: with write_window_kb set, the LBA space is
+ * split into aligned windows standing in for the erase blocks of an
+ * eMMC or SD device. A write batch starts at the lowest queued write of
+ * its window and keeps going until the window is drained, so that writes
+ * from different submitters to the same erase block reach the FTL
+ * together. Zoned devices keep their own write ordering rules.
+ */
+static bool deadline_write_windowed(struct deadline_data *dd,
+				    struct request *rq)
+{
+	return dd->write_window_kb && !blk_queue_is_zoned(rq->q);
+}
+
+static bool deadline_in_write_window(struct deadline_data *dd,
+				     struct request *rq)
+{
+	return blk_rq_pos(rq) - dd->write_window_start <
+		((sector_t)dd->write_window_kb << 1);
+}
+
+static struct request *deadline_write_window_first(struct deadline_data *dd,
+						   struct request *rq)
+{
+	sector_t pos = blk_rq_pos(rq), idx = pos;
+	struct request *prev;
+
+	dd->write_window_start = pos -
+		sector_div(idx, (u32)dd->write_window_kb << 1);
+
+	while ((prev = deadline_earlier_request(rq)) &&
+	       blk_rq_pos(prev) >= dd->write_window_start)
+		rq = prev;
+
+	return rq;
+}
+
 /*
  * For the specified data direction, return the next request to
  * dispatch using arrival ordered lists.
@@ -448,6 +487,11 @@ static struct request *__dd_dispatch_request(struct deadline_data *dd,
 		/* we have a next request are still entitled to batch */
 		goto dispatch_request;
 
+	/* a flash-aware write batch only ends at its window boundary */
+	if (rq && dd->last_dir == DD_WRITE && deadline_write_windowed(dd, rq) &&
+	    deadline_in_write_window(dd, rq))
+		goto dispatch_request;
+
 	/*
 	 * at this point we are not running a batch. select the appropriate
 	 * data direction (read / write)
@@ -509,6 +553,9 @@ static struct request *__dd_dispatch_request(struct deadline_data *dd,
 	if (!rq)
 		return NULL;
 
+	if (data_dir == DD_WRITE && deadline_write_windowed(dd, rq))
+		rq = deadline_write_window_first(dd, rq);
+
 	dd->last_dir = data_dir;
 	dd->batching = 0;
 
@@ -943,6 +990,7 @@ SHOW_INT(deadline_writes_starved_show, dd->writes_starved);
 SHOW_INT(deadline_front_merges_show, dd->front_merges);
 SHOW_INT(deadline_async_depth_show, dd->async_depth);
 SHOW_INT(deadline_fifo_batch_show, dd->fifo_batch);
+SHOW_INT(deadline_write_window_kb_show, dd->write_window_kb);
 #undef SHOW_INT
 #undef SHOW_JIFFIES
 
@@ -973,6 +1021,7 @@ STORE_INT(deadline_writes_starved_store, &dd->writes_starved, INT_MIN, INT_MAX);
 STORE_INT(deadline_front_merges_store, &dd->front_merges, 0, 1);
 STORE_INT(deadline_async_depth_store, &dd->async_depth, 1, INT_MAX);
 STORE_INT(deadline_fifo_batch_store, &dd->fifo_batch, 0, INT_MAX);
+STORE_INT(deadline_write_window_kb_store, &dd->write_window_kb, 0, INT_MAX);
 #undef STORE_FUNCTION
 #undef STORE_INT
 #undef STORE_JIFFIES
@@ -988,6 +1037,7 @@ static struct elv_fs_entry deadline_attrs[] = {
 	DD_ATTR(async_depth),
 	DD_ATTR(fifo_batch),
 	DD_ATTR(prio_aging_expire),
+	DD_ATTR(write_window_kb),
 	__ATTR_NULL
 };
 
@@ -61,6 +61,7 @@ struct driver_private {
 	struct klist_node knode_bus;
 	struct module_kobject *mkobj;
 	struct device_driver *driver;
+	atomic64_t probe_time_ns;	/* Time spent in probe, all devices */
 };
 #define to_driver(obj) container_of(obj, struct driver_private, kobj)
 
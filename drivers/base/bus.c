@@ -583,6 +583,14 @@ static ssize_t uevent_store(struct device_driver *drv, const char *buf,
 }
 static DRIVER_ATTR_WO(uevent);
 
+static ssize_t probe_time_us_show(struct device_driver *drv, char *buf)
+{
+	return sysfs_emit(buf, "%llu\n",
+			  div_u64(atomic64_read(&drv->p->probe_time_ns),
+				  NSEC_PER_USEC));
+}
+static DRIVER_ATTR_RO(probe_time_us);
+
 /**
  * bus_add_driver - Add a driver to the bus.
  * @drv: driver.
@@ -626,6 +634,11 @@ int bus_add_driver(struct device_driver *drv)
 		printk(KERN_ERR "%s: uevent attr (%s) failed\n",
 			__func__, drv->name);
 	}
+	error = driver_create_file(drv, &driver_attr_probe_time_us);
+	if (error) {
+		printk(KERN_ERR "%s: probe_time_us attr (%s) failed\n",
+			__func__, drv->name);
+	}
 	error = driver_add_groups(drv, bus->drv_groups);
 	if (error) {
 		/* How the hell do we get out of this pickle? Give up */
@@ -671,6 +684,7 @@ void bus_remove_driver(struct device_driver *drv)
 	if (!drv->suppress_bind_attrs)
 		remove_bind_files(drv);
 	driver_remove_groups(drv, drv->bus->drv_groups);
+	driver_remove_file(drv, &driver_attr_probe_time_us);
 	driver_remove_file(drv, &driver_attr_uevent);
 	klist_remove(&drv->p->knode_bus);
 	pr_debug("bus: '%s': remove driver %s\n", drv->bus->name, drv->name);
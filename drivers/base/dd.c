@@ -763,6 +763,7 @@ EXPORT_SYMBOL_GPL(wait_for_device_probe);
 
 static int __driver_probe_device(struct device_driver *drv, struct device *dev)
 {
+	ktime_t calltime;
 	int ret = 0;
 
 	if (dev->p->dead || !device_is_registered(dev))
@@ -779,10 +780,13 @@ static int __driver_probe_device(struct device_driver *drv, struct device *dev)
 		pm_runtime_get_sync(dev->parent);
 
 	pm_runtime_barrier(dev);
+	calltime = ktime_get();
 	if (initcall_debug)
 		ret = really_probe_debug(dev, drv);
 	else
 		ret = really_probe(dev, drv);
+	atomic64_add(ktime_to_ns(ktime_sub(ktime_get(), calltime)),
+		     &drv->p->probe_time_ns);
 	pm_request_idle(dev);
 
 	if (dev->parent)
@@ -138,6 +138,7 @@ static void loop_global_unlock(struct loop_device *lo, bool global)
 
 static int max_part;
 static int part_shift;
+static bool auto_dio;
 
 static loff_t get_size(loff_t offset, loff_t sizelimit, struct file *file)
 {
@@ -1081,7 +1082,8 @@ static int loop_configure(struct loop_device *lo, fmode_t mode,
 
 	if (config->block_size)
 		bsize = config->block_size;
-	else if ((lo->lo_backing_file->f_flags & O_DIRECT) && inode->i_sb->s_bdev)
+	else if (((lo->lo_backing_file->f_flags & O_DIRECT) || auto_dio) &&
+		 inode->i_sb->s_bdev)
 		/* In case of direct I/O, match underlying block size */
 		bsize = bdev_logical_block_size(inode->i_sb->s_bdev);
 	else
@@ -1094,6 +1096,9 @@ static int loop_configure(struct loop_device *lo, fmode_t mode,
 	loop_config_discard(lo);
 	loop_update_rotational(lo);
 	loop_update_dio(lo);
+	/* use direct I/O whenever the backing file allows it */
+	if (auto_dio && !lo->use_dio)
+		__loop_update_dio(lo, true);
 	loop_sysfs_init(lo);
 
 	size = get_loop_size(lo, file);
@@ -1787,6 +1792,8 @@ module_param(max_loop, int, 0444);
 MODULE_PARM_DESC(max_loop, "Maximum number of loop devices");
 module_param(max_part, int, 0444);
 MODULE_PARM_DESC(max_part, "Maximum number of partitions per loop device");
+module_param(auto_dio, bool, 0644);
+MODULE_PARM_DESC(auto_dio, "Use direct I/O to the backing file when its alignment allows");
 
 static int hw_queue_depth = LOOP_DEFAULT_HW_Q_DEPTH;
 
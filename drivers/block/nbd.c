@@ -186,6 +186,12 @@ static void nbd_requeue_cmd(struct nbd_cmd *cmd)
 
 #define NBD_COOKIE_BITS 32
 
+/*
+ * Write payloads with up to this many bvecs go out in a single sendmsg,
+ * larger ones are sent one segment at a time.
+ */
+#define NBD_SEND_BVECS	16
+
 static u64 nbd_cmd_handle(struct nbd_cmd *cmd)
 {
 	struct request *req = blk_mq_rq_from_pdu(cmd);
@@ -559,6 +565,10 @@ static int nbd_send_cmd(struct nbd_device *nbd, struct nbd_cmd *cmd, int index)
 	struct kvec iov = {.iov_base = &request, .iov_len = sizeof(request)};
 	struct iov_iter from;
 	unsigned long size = blk_rq_bytes(req);
+	struct bio_vec bvecs[NBD_SEND_BVECS];
+	struct req_iterator rq_iter;
+	struct bio_vec bvec;
+	unsigned int nr_bvecs = 0;
 	struct bio *bio;
 	u64 handle;
 	u32 type;
@@ -639,11 +649,30 @@ static int nbd_send_cmd(struct nbd_device *nbd, struct nbd_cmd *cmd, int index)
 	if (type != NBD_CMD_WRITE)
 		goto out;
 
+	/*
+	 * Hand the whole payload to the socket at once when it is small enough
+	 * to describe on the stack, that saves a sendmsg call per segment.
+	 */
+	rq_for_each_bvec(bvec, req, rq_iter) {
+		if (nr_bvecs < NBD_SEND_BVECS)
+			bvecs[nr_bvecs] = bvec;
+		nr_bvecs++;
+	}
+	if (nr_bvecs <= NBD_SEND_BVECS) {
+		dev_dbg(nbd_to_dev(nbd), "request %p: sending %lu bytes data\n",
+			req, size - skip);
+		iov_iter_bvec(&from, ITER_SOURCE, bvecs, nr_bvecs, size);
+		iov_iter_advance(&from, skip);
+		result = sock_xmit(nbd, index, 1, &from, 0, &sent);
+		if (result < 0)
+			goto send_data_failed;
+		goto out;
+	}
+
 	bio = req->bio;
 	while (bio) {
 		struct bio *next = bio->bi_next;
 		struct bvec_iter iter;
-		struct bio_vec bvec;
 
 		bio_for_each_segment(bvec, bio, iter) {
 			bool is_last = !next && bio_iter_last(bvec, iter);
@@ -661,22 +690,8 @@ static int nbd_send_cmd(struct nbd_device *nbd, struct nbd_cmd *cmd, int index)
 				skip = 0;
 			}
 			result = sock_xmit(nbd, index, 1, &from, flags, &sent);
-			if (result < 0) {
-				if (was_interrupted(result)) {
-					/* We've already sent the header, we
-					 * have no choice but to set pending and
-					 * return BUSY.
-					 */
-					nsock->pending = req;
-					nsock->sent = sent;
-					set_bit(NBD_CMD_REQUEUED, &cmd->flags);
-					return BLK_STS_RESOURCE;
-				}
-				dev_err(disk_to_dev(nbd->disk),
-					"Send data failed (result %d)\n",
-					result);
-				return -EAGAIN;
-			}
+			if (result < 0)
+				goto send_data_failed;
 			/*
 			 * The completion might already have come in,
 			 * so break for the last one instead of letting
@@ -693,6 +708,20 @@ static int nbd_send_cmd(struct nbd_device *nbd, struct nbd_cmd *cmd, int index)
 	nsock->pending = NULL;
 	nsock->sent = 0;
 	return 0;
+
+send_data_failed:
+	if (was_interrupted(result)) {
+		/* We've already sent the header, we have no choice but to set
+		 * pending and return BUSY.
+		 */
+		nsock->pending = req;
+		nsock->sent = sent;
+		set_bit(NBD_CMD_REQUEUED, &cmd->flags);
+		return BLK_STS_RESOURCE;
+	}
+	dev_err(disk_to_dev(nbd->disk), "Send data failed (result %d)\n",
+		result);
+	return -EAGAIN;
 }
 
 static int nbd_read_reply(struct nbd_device *nbd, int index,
@@ -42,6 +42,7 @@
 #include <linux/mm.h>
 #include <asm/page.h>
 #include <linux/task_work.h>
+#include <linux/kref.h>
 #include <uapi/linux/ublk_cmd.h>
 
 #define UBLK_MINORS		(1U << MINORBITS)
@@ -51,7 +52,8 @@
 		| UBLK_F_URING_CMD_COMP_IN_TASK \
 		| UBLK_F_NEED_GET_DATA \
 		| UBLK_F_USER_RECOVERY \
-		| UBLK_F_USER_RECOVERY_REISSUE)
+		| UBLK_F_USER_RECOVERY_REISSUE \
+		| UBLK_F_USER_COPY)
 
 /* All UBLK_PARAM_TYPE_* should be included here */
 #define UBLK_PARAM_TYPE_ALL (UBLK_PARAM_TYPE_BASIC | UBLK_PARAM_TYPE_DISCARD)
@@ -59,6 +61,7 @@
 struct ublk_rq_data {
 	struct llist_node node;
 	struct callback_head work;
+	struct kref ref;
 };
 
 struct ublk_uring_cmd_pdu {
@@ -279,6 +282,60 @@ static inline bool ublk_can_use_task_work(const struct ublk_queue *ubq)
 	return false;
 }
 
+static inline bool ublk_support_user_copy(const struct ublk_queue *ubq)
+{
+	if (ubq->flags & UBLK_F_USER_COPY)
+		return true;
+	return false;
+}
+
+/*
+ * With UBLK_F_USER_COPY, the request pages may be copied by any task that
+ * has the char device open, including io-wq workers of the daemon's ring,
+ * so the request is pinned by a reference for the duration of each copy.
+ */
+static inline bool ublk_need_req_ref(const struct ublk_queue *ubq)
+{
+	return ublk_support_user_copy(ubq);
+}
+
+static inline void ublk_init_req_ref(const struct ublk_queue *ubq,
+		struct request *req)
+{
+	if (ublk_need_req_ref(ubq)) {
+		struct ublk_rq_data *data = blk_mq_rq_to_pdu(req);
+
+		kref_init(&data->ref);
+	}
+}
+
+static inline bool ublk_get_req_ref(const struct ublk_queue *ubq,
+		struct request *req)
+{
+	if (ublk_need_req_ref(ubq)) {
+		struct ublk_rq_data *data = blk_mq_rq_to_pdu(req);
+
+		return kref_get_unless_zero(&data->ref);
+	}
+
+	return true;
+}
+
+static void ublk_complete_rq(struct kref *ref);
+static void __ublk_complete_rq(struct request *req);
+
+static inline void ublk_put_req_ref(const struct ublk_queue *ubq,
+		struct request *req)
+{
+	if (ublk_need_req_ref(ubq)) {
+		struct ublk_rq_data *data = blk_mq_rq_to_pdu(req);
+
+		kref_put(&data->ref, ublk_complete_rq);
+	} else {
+		__ublk_complete_rq(req);
+	}
+}
+
 static inline bool ublk_need_get_data(const struct ublk_queue *ubq)
 {
 	if (ubq->flags & UBLK_F_NEED_GET_DATA)
@@ -470,6 +527,11 @@ static int ublk_map_io(const struct ublk_queue *ubq, const struct request *req,
 		struct ublk_io *io)
 {
 	const unsigned int rq_bytes = blk_rq_bytes(req);
+
+	/* ublksrv copies the data itself via the char device */
+	if (ublk_support_user_copy(ubq))
+		return rq_bytes;
+
 	/*
 	 * no zero copy, we delay copy WRITE request data into ublksrv
 	 * context and the big benefit is that pinning pages in current
@@ -499,6 +561,9 @@ static int ublk_unmap_io(const struct ublk_queue *ubq,
 {
 	const unsigned int rq_bytes = blk_rq_bytes(req);
 
+	if (ublk_support_user_copy(ubq))
+		return rq_bytes;
+
 	if (req_op(req) == REQ_OP_READ && ublk_rq_has_data(req)) {
 		struct ublk_map_data data = {
 			.ubq	=	ubq,
@@ -591,7 +656,7 @@ static inline bool ubq_daemon_is_dying(struct ublk_queue *ubq)
 }
 
 /* todo: handle partial completion */
-static void ublk_complete_rq(struct request *req)
+static void __ublk_complete_rq(struct request *req)
 {
 	struct ublk_queue *ubq = req->mq_hctx->driver_data;
 	struct ublk_io *io = &ubq->ios[req->tag];
@@ -634,6 +699,15 @@ static void ublk_complete_rq(struct request *req)
 		__blk_mq_end_request(req, BLK_STS_OK);
 }
 
+static void ublk_complete_rq(struct kref *ref)
+{
+	struct ublk_rq_data *data = container_of(ref, struct ublk_rq_data,
+			ref);
+	struct request *req = blk_mq_rq_from_pdu(data);
+
+	__ublk_complete_rq(req);
+}
+
 /*
  * Since __ublk_rq_task_work always fails requests immediately during
  * exiting, __ublk_fail_req() is only called from abort context during
@@ -649,10 +723,15 @@ static void __ublk_fail_req(struct ublk_queue *ubq, struct ublk_io *io,
 
 	if (!(io->flags & UBLK_IO_FLAG_ABORTED)) {
 		io->flags |= UBLK_IO_FLAG_ABORTED;
-		if (ublk_queue_can_use_recovery_reissue(ubq))
+		if (ublk_queue_can_use_recovery_reissue(ubq)) {
 			blk_mq_requeue_request(req, false);
-		else
+		} else if (ublk_need_req_ref(ubq)) {
+			/* let any copy in progress finish before ending it */
+			io->res = -EIO;
+			ublk_put_req_ref(ubq, req);
+		} else {
 			blk_mq_end_request(req, BLK_STS_IOERR);
+		}
 	}
 }
 
@@ -763,6 +842,7 @@ static inline void __ublk_rq_task_work(struct request *req,
 			mapped_bytes >> 9;
 	}
 
+	ublk_init_req_ref(ubq, req);
 	ubq_complete_io_cmd(io, UBLK_IO_RES_OK, issue_flags);
 }
 
@@ -975,7 +1055,7 @@ static void ublk_commit_completion(struct ublk_device *ub,
 	req = blk_mq_tag_to_rq(ub->tag_set.tags[qid], tag);
 
 	if (req && likely(!blk_should_fake_timeout(req->q)))
-		ublk_complete_rq(req);
+		ublk_put_req_ref(ubq, req);
 }
 
 /*
@@ -1265,9 +1345,14 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 		 */
 		if (io->flags & UBLK_IO_FLAG_OWNED_BY_SRV)
 			goto out;
-		/* FETCH_RQ has to provide IO buffer if NEED GET DATA is not enabled */
-		if (!ub_cmd->addr && !ublk_need_get_data(ubq))
+		if (ublk_support_user_copy(ubq)) {
+			/* ublksrv reads/writes request pages via char device */
+			if (ub_cmd->addr)
+				goto out;
+		} else if (!ub_cmd->addr && !ublk_need_get_data(ubq)) {
+			/* FETCH_RQ has to provide IO buffer if NEED GET DATA is not enabled */
 			goto out;
+		}
 		io->cmd = cmd;
 		io->flags |= UBLK_IO_FLAG_ACTIVE;
 		io->addr = ub_cmd->addr;
@@ -1280,8 +1365,13 @@ static int __ublk_ch_uring_cmd(struct io_uring_cmd *cmd,
 		 * COMMIT_AND_FETCH_REQ has to provide IO buffer if NEED GET DATA is
 		 * not enabled or it is Read IO.
 		 */
-		if (!ub_cmd->addr && (!ublk_need_get_data(ubq) || req_op(req) == REQ_OP_READ))
+		if (ublk_support_user_copy(ubq)) {
+			if (ub_cmd->addr)
+				goto out;
+		} else if (!ub_cmd->addr && (!ublk_need_get_data(ubq) ||
+					req_op(req) == REQ_OP_READ)) {
 			goto out;
+		}
 		if (!(io->flags & UBLK_IO_FLAG_OWNED_BY_SRV))
 			goto out;
 		io->addr = ub_cmd->addr;
@@ -1326,11 +1416,159 @@ static int ublk_ch_uring_cmd(struct io_uring_cmd *cmd, unsigned int issue_flags)
 	return __ublk_ch_uring_cmd(cmd, issue_flags, &ub_cmd);
 }
 
+static inline u16 ublk_pos_to_hwq(loff_t pos)
+{
+	return ((pos - UBLKSRV_IO_BUF_OFFSET) >> UBLK_QID_OFF) &
+		UBLK_QID_BITS_MASK;
+}
+
+static inline u16 ublk_pos_to_tag(loff_t pos)
+{
+	return ((pos - UBLKSRV_IO_BUF_OFFSET) >> UBLK_TAG_OFF) &
+		UBLK_TAG_BITS_MASK;
+}
+
+static inline unsigned int ublk_pos_to_buf_off(loff_t pos)
+{
+	return (pos - UBLKSRV_IO_BUF_OFFSET) & UBLK_IO_BUF_BITS_MASK;
+}
+
+/* copy between request pages starting at @offset and user iter */
+static size_t ublk_copy_rq_pages(const struct request *req,
+		unsigned int offset, struct iov_iter *uiter, int dir)
+{
+	struct req_iterator iter;
+	struct bio_vec bv;
+	size_t done = 0;
+
+	rq_for_each_segment(bv, req, iter) {
+		size_t len;
+
+		if (offset >= bv.bv_len) {
+			offset -= bv.bv_len;
+			continue;
+		}
+		bv.bv_offset += offset;
+		bv.bv_len -= offset;
+		offset = 0;
+
+		if (dir == ITER_DEST)
+			len = copy_page_to_iter(bv.bv_page, bv.bv_offset,
+					bv.bv_len, uiter);
+		else
+			len = copy_page_from_iter(bv.bv_page, bv.bv_offset,
+					bv.bv_len, uiter);
+		done += len;
+		if (len != bv.bv_len || !iov_iter_count(uiter))
+			break;
+	}
+	return done;
+}
+
+/*
+ * The copy may run from any task, e.g. an io-wq worker the daemon's ring
+ * punted the read or write to, and may race with the request being
+ * committed or aborted. So the request is pinned by a reference, which
+ * the caller drops with ublk_put_req_ref() once the copy is done.
+ */
+static struct request *ublk_check_and_get_req(struct kiocb *iocb,
+		int dir, unsigned int *off)
+{
+	struct ublk_device *ub = iocb->ki_filp->private_data;
+	struct ublk_queue *ubq;
+	struct request *req;
+	unsigned int buf_off;
+	u16 tag, q_id;
+
+	if (iocb->ki_pos < UBLKSRV_IO_BUF_OFFSET ||
+	    iocb->ki_pos >= UBLKSRV_IO_BUF_OFFSET + UBLKSRV_IO_BUF_TOTAL_SIZE)
+		return ERR_PTR(-EINVAL);
+
+	q_id = ublk_pos_to_hwq(iocb->ki_pos);
+	tag = ublk_pos_to_tag(iocb->ki_pos);
+	buf_off = ublk_pos_to_buf_off(iocb->ki_pos);
+
+	if (q_id >= ub->dev_info.nr_hw_queues)
+		return ERR_PTR(-EINVAL);
+
+	ubq = ublk_get_queue(ub, q_id);
+	if (!ublk_support_user_copy(ubq))
+		return ERR_PTR(-EACCES);
+
+	if (tag >= ubq->q_depth)
+		return ERR_PTR(-EINVAL);
+
+	req = blk_mq_tag_to_rq(ub->tag_set.tags[q_id], tag);
+	if (!req)
+		return ERR_PTR(-EINVAL);
+
+	if (!ublk_get_req_ref(ubq, req))
+		return ERR_PTR(-EINVAL);
+
+	if (!blk_mq_request_started(req) || req->tag != tag)
+		goto fail_put;
+
+	if (!(ubq->ios[tag].flags & UBLK_IO_FLAG_OWNED_BY_SRV))
+		goto fail_put;
+
+	if (!ublk_rq_has_data(req))
+		goto fail_put;
+
+	/* ublksrv reads WRITE data, and writes READ data */
+	if (dir == ITER_DEST && req_op(req) != REQ_OP_WRITE)
+		goto fail_put;
+	if (dir == ITER_SOURCE && req_op(req) != REQ_OP_READ)
+		goto fail_put;
+
+	if (buf_off > blk_rq_bytes(req))
+		goto fail_put;
+
+	*off = buf_off;
+	return req;
+fail_put:
+	ublk_put_req_ref(ubq, req);
+	return ERR_PTR(-EINVAL);
+}
+
+static ssize_t ublk_ch_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct request *req;
+	unsigned int off;
+	ssize_t ret;
+
+	req = ublk_check_and_get_req(iocb, ITER_DEST, &off);
+	if (IS_ERR(req))
+		return PTR_ERR(req);
+
+	ret = ublk_copy_rq_pages(req, off, to, ITER_DEST);
+	ublk_put_req_ref(req->mq_hctx->driver_data, req);
+
+	return ret;
+}
+
+static ssize_t ublk_ch_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct request *req;
+	unsigned int off;
+	ssize_t ret;
+
+	req = ublk_check_and_get_req(iocb, ITER_SOURCE, &off);
+	if (IS_ERR(req))
+		return PTR_ERR(req);
+
+	ret = ublk_copy_rq_pages(req, off, from, ITER_SOURCE);
+	ublk_put_req_ref(req->mq_hctx->driver_data, req);
+
+	return ret;
+}
+
 static const struct file_operations ublk_ch_fops = {
 	.owner = THIS_MODULE,
 	.open = ublk_ch_open,
 	.release = ublk_ch_release,
 	.llseek = no_llseek,
+	.read_iter = ublk_ch_read_iter,
+	.write_iter = ublk_ch_write_iter,
 	.uring_cmd = ublk_ch_uring_cmd,
 	.mmap = ublk_ch_mmap,
 };
@@ -1702,6 +1940,14 @@ static int ublk_ctrl_add_dev(struct io_uring_cmd *cmd)
 	/* We are not ready to support zero copy */
 	ub->dev_info.flags &= ~UBLK_F_SUPPORT_ZERO_COPY;
 
+	/* ublksrv does the copy itself, so it never needs to provide data */
+	if (ub->dev_info.flags & UBLK_F_USER_COPY) {
+		ub->dev_info.flags &= ~UBLK_F_NEED_GET_DATA;
+		ub->dev_info.max_io_buf_bytes = min_t(unsigned int,
+				ub->dev_info.max_io_buf_bytes,
+				UBLK_IO_BUF_BITS_MASK + 1);
+	}
+
 	ub->dev_info.nr_hw_queues = min_t(unsigned int,
 			ub->dev_info.nr_hw_queues, nr_cpu_ids);
 	ublk_align_max_io_size(ub);
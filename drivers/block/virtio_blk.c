@@ -408,6 +408,7 @@ static bool virtblk_add_req_batch(struct virtio_blk_vq *vq,
 
 	spin_lock_irqsave(&vq->lock, flags);
 
+	virtqueue_add_batch_start(vq->vq);
 	while (!rq_list_empty(*rqlist)) {
 		struct request *req = rq_list_pop(rqlist);
 		struct virtblk_req *vbr = blk_mq_rq_to_pdu(req);
@@ -419,6 +420,7 @@ static bool virtblk_add_req_batch(struct virtio_blk_vq *vq,
 			blk_mq_requeue_request(req, true);
 		}
 	}
+	virtqueue_add_batch_end(vq->vq);
 
 	kick = virtqueue_kick_prepare(vq->vq);
 	spin_unlock_irqrestore(&vq->lock, flags);
@@ -21,6 +21,7 @@
 #include <linux/sched/signal.h>
 #include <linux/miscdevice.h>
 #include <linux/module.h>
+#include <linux/percpu.h>
 #include <linux/random.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
@@ -28,6 +29,22 @@
 
 #define RNG_MODULE_NAME		"hw_random"
 
+/*
+ * Largest read asked from a driver at once, and how much of what a
+ * /dev/hwrng reader didn't consume is kept per CPU for the next reads.
+ */
+#define RNG_BATCH_SIZE		512
+#define RNG_POOL_SIZE		256
+#define RNG_POOL_CHUNK		64
+
+struct rng_pool {
+	spinlock_t lock;	/* Protects avail and buf */
+	unsigned int avail;
+	u8 buf[RNG_POOL_SIZE];
+};
+
+static DEFINE_PER_CPU(struct rng_pool, rng_pools);
+
 static struct hwrng *current_rng;
 /* the current rng has been explicitly chosen by user via sysfs */
 static int cur_rng_set_by_user;
@@ -62,6 +79,62 @@ static size_t rng_buffer_size(void)
 	return SMP_CACHE_BYTES < 32 ? 32 : SMP_CACHE_BYTES;
 }
 
+/*
+ * Size the device reads to what the reader asked for, so that large reads
+ * don't go through the driver one cache line at a time.
+ */
+static size_t rng_read_size(size_t size)
+{
+	size = round_up(size, rng_buffer_size());
+
+	return clamp_t(size_t, size, rng_buffer_size(), RNG_BATCH_SIZE);
+}
+
+/*
+ * The pools let readers consume the leftovers of an earlier device read
+ * without taking reading_mutex. Bytes handed out are wiped from the pool.
+ */
+static size_t rng_pool_get(u8 *buf, size_t len)
+{
+	struct rng_pool *pool = raw_cpu_ptr(&rng_pools);
+
+	spin_lock(&pool->lock);
+	len = min_t(size_t, len, pool->avail);
+	pool->avail -= len;
+	memcpy(buf, pool->buf + pool->avail, len);
+	memzero_explicit(pool->buf + pool->avail, len);
+	spin_unlock(&pool->lock);
+
+	return len;
+}
+
+static size_t rng_pool_put(const u8 *buf, size_t len)
+{
+	struct rng_pool *pool = raw_cpu_ptr(&rng_pools);
+
+	spin_lock(&pool->lock);
+	len = min_t(size_t, len, RNG_POOL_SIZE - pool->avail);
+	memcpy(pool->buf + pool->avail, buf, len);
+	pool->avail += len;
+	spin_unlock(&pool->lock);
+
+	return len;
+}
+
+static void rng_pools_flush(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct rng_pool *pool = per_cpu_ptr(&rng_pools, cpu);
+
+		spin_lock(&pool->lock);
+		memzero_explicit(pool->buf, pool->avail);
+		pool->avail = 0;
+		spin_unlock(&pool->lock);
+	}
+}
+
 static void add_early_randomness(struct hwrng *rng)
 {
 	int bytes_read;
@@ -117,6 +190,9 @@ static void drop_current_rng(void)
 	/* decrease last reference for triggering the cleanup */
 	kref_put(&current_rng->ref, cleanup_rng);
 	current_rng = NULL;
+
+	/* Don't keep serving data from an rng that isn't current anymore */
+	rng_pools_flush();
 }
 
 /* Returns ERR_PTR(), NULL or refcounted hwrng */
@@ -211,12 +287,27 @@ static inline int rng_get_data(struct hwrng *rng, u8 *buffer, size_t size,
 static ssize_t rng_dev_read(struct file *filp, char __user *buf,
 			    size_t size, loff_t *offp)
 {
+	u8 pool_buf[RNG_POOL_CHUNK];
 	ssize_t ret = 0;
 	int err = 0;
 	int bytes_read, len;
 	struct hwrng *rng;
 
 	while (size) {
+		len = rng_pool_get(pool_buf, min_t(size_t, size,
+						   sizeof(pool_buf)));
+		if (len) {
+			err = copy_to_user(buf + ret, pool_buf, len) ?
+			      -EFAULT : 0;
+			memzero_explicit(pool_buf, len);
+			if (err)
+				goto out;
+
+			size -= len;
+			ret += len;
+			continue;
+		}
+
 		rng = get_current_rng();
 		if (IS_ERR(rng)) {
 			err = PTR_ERR(rng);
@@ -233,7 +324,7 @@ static ssize_t rng_dev_read(struct file *filp, char __user *buf,
 		}
 		if (!data_avail) {
 			bytes_read = rng_get_data(rng, rng_buffer,
-				rng_buffer_size(),
+				rng_read_size(size),
 				!(filp->f_flags & O_NONBLOCK));
 			if (bytes_read < 0) {
 				err = bytes_read;
@@ -259,9 +350,16 @@ static ssize_t rng_dev_read(struct file *filp, char __user *buf,
 				err = -EFAULT;
 				goto out_unlock_reading;
 			}
+			memzero_explicit(rng_buffer + data_avail, len);
 
 			size -= len;
 			ret += len;
+
+			/* Leave what's left to the next reads on this CPU */
+			len = rng_pool_put(rng_buffer, data_avail);
+			memmove(rng_buffer, rng_buffer + len, data_avail - len);
+			memzero_explicit(rng_buffer + data_avail - len, len);
+			data_avail -= len;
 		}
 
 		mutex_unlock(&reading_mutex);
@@ -504,8 +602,13 @@ static int hwrng_fillfn(void *unused)
 		if (IS_ERR(rng) || !rng)
 			break;
 		mutex_lock(&reading_mutex);
+		/*
+		 * Until the crng is seeded, random.c takes everything we give
+		 * it without throttling, so feed it in large batches.
+		 */
 		rc = rng_get_data(rng, rng_fillbuf,
-				  rng_buffer_size(), 1);
+				  rng_is_initialized() ? rng_buffer_size() :
+				  RNG_BATCH_SIZE, 1);
 		if (current_quality != rng->quality)
 			rng->quality = current_quality; /* obsolete */
 		quality = rng->quality;
@@ -688,14 +791,17 @@ EXPORT_SYMBOL_GPL(hwrng_yield);
 
 static int __init hwrng_modinit(void)
 {
-	int ret;
+	int cpu, ret;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(&rng_pools, cpu)->lock);
 
 	/* kmalloc makes this safe for virt_to_page() in virtio_rng.c */
-	rng_buffer = kmalloc(rng_buffer_size(), GFP_KERNEL);
+	rng_buffer = kmalloc(RNG_BATCH_SIZE, GFP_KERNEL);
 	if (!rng_buffer)
 		return -ENOMEM;
 
-	rng_fillbuf = kmalloc(rng_buffer_size(), GFP_KERNEL);
+	rng_fillbuf = kmalloc(RNG_BATCH_SIZE, GFP_KERNEL);
 	if (!rng_fillbuf) {
 		kfree(rng_buffer);
 		return -ENOMEM;
@@ -714,6 +820,7 @@ static void __exit hwrng_modexit(void)
 {
 	mutex_lock(&rng_mutex);
 	BUG_ON(current_rng);
+	rng_pools_flush();
 	kfree(rng_buffer);
 	kfree(rng_fillbuf);
 	mutex_unlock(&rng_mutex);
@@ -124,6 +124,7 @@ static void rk_rng_read_regs(struct rk_rng *rng, u32 offset, void *buf,
 
 static int rk_rng_v1_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 {
+	size_t len, read = 0;
 	int ret = 0;
 	u32 reg_ctrl = 0;
 	struct rk_rng *rk_rng = container_of(rng, struct rk_rng, rng);
@@ -138,22 +139,31 @@ static int rk_rng_v1_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 	reg_ctrl = CRYPTO_V1_OSC_ENABLE | CRYPTO_V1_TRNG_SAMPLE_PERIOD(100);
 	rk_rng_writel(rk_rng, reg_ctrl, CRYPTO_V1_TRNG_CTRL);
 
-	reg_ctrl = HIWORD_UPDATE(CRYPTO_V1_RNG_START, CRYPTO_V1_RNG_START, 0);
-
-	rk_rng_writel(rk_rng, reg_ctrl, CRYPTO_V1_CTRL);
-
-	ret = readl_poll_timeout(rk_rng->mem + CRYPTO_V1_CTRL, reg_ctrl,
-				 !(reg_ctrl & CRYPTO_V1_RNG_START),
-				 ROCKCHIP_POLL_PERIOD_US,
-				 ROCKCHIP_POLL_TIMEOUT_US);
-	if (ret < 0)
-		goto out;
-
-	ret = min_t(size_t, max, RK_MAX_RNG_BYTE);
-
-	rk_rng_read_regs(rk_rng, CRYPTO_V1_TRNG_DOUT_0, buf, ret);
+	/*
+	 * Run as many conversions as fit in the buffer while the block is
+	 * powered, rather than one per call.
+	 */
+	while (read < max) {
+		reg_ctrl = HIWORD_UPDATE(CRYPTO_V1_RNG_START,
+					 CRYPTO_V1_RNG_START, 0);
+
+		rk_rng_writel(rk_rng, reg_ctrl, CRYPTO_V1_CTRL);
+
+		ret = readl_poll_timeout(rk_rng->mem + CRYPTO_V1_CTRL,
+					 reg_ctrl,
+					 !(reg_ctrl & CRYPTO_V1_RNG_START),
+					 ROCKCHIP_POLL_PERIOD_US,
+					 ROCKCHIP_POLL_TIMEOUT_US);
+		if (ret < 0)
+			break;
+
+		len = min_t(size_t, max - read, RK_MAX_RNG_BYTE);
+		rk_rng_read_regs(rk_rng, CRYPTO_V1_TRNG_DOUT_0, buf + read,
+				 len);
+		read += len;
+	}
+	ret = read ? read : ret;
 
-out:
 	/* close TRNG */
 	rk_rng_writel(rk_rng, HIWORD_UPDATE(0, CRYPTO_V1_RNG_START, 0),
 		      CRYPTO_V1_CTRL);
@@ -166,6 +176,7 @@ static int rk_rng_v1_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 
 static int rk_rng_v2_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 {
+	size_t len, read = 0;
 	int ret = 0;
 	u32 reg_ctrl = 0;
 	struct rk_rng *rk_rng = container_of(rng, struct rk_rng, rng);
@@ -184,21 +195,28 @@ static int rk_rng_v2_read(struct hwrng *rng, void *buf, size_t max, bool wait)
 	reg_ctrl |= CRYPTO_V2_RNG_ENABLE;
 	reg_ctrl |= CRYPTO_V2_RNG_START;
 
-	rk_rng_writel(rk_rng, HIWORD_UPDATE(reg_ctrl, 0xffff, 0),
-			CRYPTO_V2_RNG_CTL);
-
-	ret = readl_poll_timeout(rk_rng->mem + CRYPTO_V2_RNG_CTL, reg_ctrl,
-				 !(reg_ctrl & CRYPTO_V2_RNG_START),
-				 ROCKCHIP_POLL_PERIOD_US,
-				 ROCKCHIP_POLL_TIMEOUT_US);
-	if (ret < 0)
-		goto out;
-
-	ret = min_t(size_t, max, RK_MAX_RNG_BYTE);
-
-	rk_rng_read_regs(rk_rng, CRYPTO_V2_RNG_DOUT_0, buf, ret);
+	/* See rk_rng_v1_read() */
+	while (read < max) {
+		u32 reg_status;
+
+		rk_rng_writel(rk_rng, HIWORD_UPDATE(reg_ctrl, 0xffff, 0),
+			      CRYPTO_V2_RNG_CTL);
+
+		ret = readl_poll_timeout(rk_rng->mem + CRYPTO_V2_RNG_CTL,
+					 reg_status,
+					 !(reg_status & CRYPTO_V2_RNG_START),
+					 ROCKCHIP_POLL_PERIOD_US,
+					 ROCKCHIP_POLL_TIMEOUT_US);
+		if (ret < 0)
+			break;
+
+		len = min_t(size_t, max - read, RK_MAX_RNG_BYTE);
+		rk_rng_read_regs(rk_rng, CRYPTO_V2_RNG_DOUT_0, buf + read,
+				 len);
+		read += len;
+	}
+	ret = read ? read : ret;
 
-out:
 	/* close TRNG */
 	rk_rng_writel(rk_rng, HIWORD_UPDATE(0, 0xffff, 0), CRYPTO_V2_RNG_CTL);
 
@@ -324,6 +342,7 @@ static const struct dev_pm_ops rk_rng_pm_ops = {
 static struct platform_driver rk_rng_driver = {
 	.driver	= {
 		.name	= "rockchip-rng",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 #ifdef CONFIG_PM
 		.pm	= &rk_rng_pm_ops,
 #endif
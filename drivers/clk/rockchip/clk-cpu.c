@@ -272,11 +272,14 @@ struct clk *rockchip_clk_register_cpuclk(const char *name,
 	/* only allow rate changes when we have a rate table */
 	init.flags = (nrates > 0) ? CLK_SET_RATE_PARENT : 0;
 
-	/* disallow automatic parent changes by ccf */
+	/*
+	 * Disallow automatic parent changes by ccf. The rate can be cached:
+	 * the notifier only touches the dividers around rate changes of the
+	 * parent, and they are back to their final value by the time ccf
+	 * recalculates this clock after the POST_RATE_CHANGE notification.
+	 */
 	init.flags |= CLK_SET_RATE_NO_REPARENT;
 
-	init.flags |= CLK_GET_RATE_NOCACHE;
-
 	cpuclk->reg_base = reg_base;
 	cpuclk->lock = lock;
 	cpuclk->reg_data = reg_data;
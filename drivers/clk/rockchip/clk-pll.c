@@ -686,6 +686,29 @@ static int rockchip_rk3399_pll_set_params(struct rockchip_clk_pll *pll,
 	rockchip_rk3399_pll_get_params(pll, &cur);
 	cur.rate = 0;
 
+	/*
+	 * The post dividers sit behind the VCO, so when only they change a
+	 * locked VCO stays locked and there is no need to go through slow
+	 * mode and wait for the lock again. The rate tables have several of
+	 * those pairs, e.g. 408, 816 and 1632MHz all run the VCO at 1632MHz.
+	 * The output may glitch while the dividers switch, so this is
+	 * only done for the PLLs that ask for it.
+	 */
+	if ((pll->flags & ROCKCHIP_PLL_FAST_POSTDIV) &&
+	    rate->refdiv == cur.refdiv && rate->fbdiv == cur.fbdiv &&
+	    rate->dsmpd == cur.dsmpd && (cur.dsmpd || rate->frac == cur.frac) &&
+	    (readl_relaxed(pll->reg_base + RK3399_PLLCON(2)) &
+	     RK3399_PLLCON2_LOCK_STATUS)) {
+		writel_relaxed(HIWORD_UPDATE(rate->postdiv1,
+					     RK3399_PLLCON1_POSTDIV1_MASK,
+					     RK3399_PLLCON1_POSTDIV1_SHIFT) |
+			       HIWORD_UPDATE(rate->postdiv2,
+					     RK3399_PLLCON1_POSTDIV2_MASK,
+					     RK3399_PLLCON1_POSTDIV2_SHIFT),
+			       pll->reg_base + RK3399_PLLCON(1));
+		return 0;
+	}
+
 	cur_parent = pll_mux_ops->get_parent(&pll_mux->hw);
 	if (cur_parent == PLL_MODE_NORM) {
 		pll_mux_ops->set_parent(&pll_mux->hw, PLL_MODE_SLOW);
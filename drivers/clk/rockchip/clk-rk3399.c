@@ -217,9 +217,9 @@ PNAME(mux_clk_testout2_2io_p)	= { "clk_testout2", "clk_32k_suspend_pmu" };
 
 static struct rockchip_pll_clock rk3399_pll_clks[] __initdata = {
 	[lpll] = PLL(pll_rk3399, PLL_APLLL, "lpll", mux_pll_p, 0, RK3399_PLL_CON(0),
-		     RK3399_PLL_CON(3), 8, 31, 0, rk3399_pll_rates),
+		     RK3399_PLL_CON(3), 8, 31, ROCKCHIP_PLL_FAST_POSTDIV, rk3399_pll_rates),
 	[bpll] = PLL(pll_rk3399, PLL_APLLB, "bpll", mux_pll_p, 0, RK3399_PLL_CON(8),
-		     RK3399_PLL_CON(11), 8, 31, 0, rk3399_pll_rates),
+		     RK3399_PLL_CON(11), 8, 31, ROCKCHIP_PLL_FAST_POSTDIV, rk3399_pll_rates),
 	[dpll] = PLL(pll_rk3399, PLL_DPLL, "dpll", mux_pll_p, 0, RK3399_PLL_CON(16),
 		     RK3399_PLL_CON(19), 8, 31, 0, NULL),
 	[cpll] = PLL(pll_rk3399, PLL_CPLL, "cpll", mux_pll_p, 0, RK3399_PLL_CON(24),
@@ -328,6 +328,9 @@ struct rockchip_pll_rate_table {
  * Flags:
  * ROCKCHIP_PLL_SYNC_RATE - check rate parameters to match against the
  *	rate_table parameters and ajust them if necessary.
+ * ROCKCHIP_PLL_FAST_POSTDIV - when only the post dividers change, update
+ *	them without going through slow mode. Only for PLLs whose consumers
+ *	are moved off them around rate changes anyway, like the cpuclk ones.
  */
 struct rockchip_pll_clock {
 	unsigned int		id;
@@ -345,6 +348,7 @@ struct rockchip_pll_clock {
 };
 
 #define ROCKCHIP_PLL_SYNC_RATE		BIT(0)
+#define ROCKCHIP_PLL_FAST_POSTDIV	BIT(1)
 
 #define PLL(_type, _id, _name, _pnames, _flags, _con, _mode, _mshift,	\
 		_lshift, _pflags, _rtable)				\
@@ -76,10 +76,12 @@ static const struct of_device_id allowlist[] __initconst = {
 	{ .compatible = "rockchip,rk3328", },
 	{ .compatible = "rockchip,rk3366", },
 	{ .compatible = "rockchip,rk3368", },
+#if !IS_ENABLED(CONFIG_ARM_ROCKCHIP_CPUFREQ_NVMEM)
 	{ .compatible = "rockchip,rk3399",
 	  .data = &(struct cpufreq_dt_platform_data)
 		{ .have_governor_per_policy = true, },
 	},
+#endif
 
 	{ .compatible = "st-ericsson,u8500", },
 	{ .compatible = "st-ericsson,u8540", },
@@ -154,6 +156,10 @@ static const struct of_device_id blocklist[] __initconst = {
 	{ .compatible = "qcom,sm8250", },
 	{ .compatible = "qcom,sm8350", },
 
+#if IS_ENABLED(CONFIG_ARM_ROCKCHIP_CPUFREQ_NVMEM)
+	{ .compatible = "rockchip,rk3399", },
+#endif
+
 	{ .compatible = "st,stih407", },
 	{ .compatible = "st,stih410", },
 	{ .compatible = "st,stih418", },
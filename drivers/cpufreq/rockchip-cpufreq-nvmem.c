@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip CPUFreq nvmem based driver
+ *
+ * Reads the leakage of each CPU cluster from the efuse and selects the
+ * matching OPP voltages before registering cpufreq-dt, see
+ * drivers/soc/rockchip/opp.c for the OPP table description.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/bits.h>
+#include <linux/cpu.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/platform_device.h>
+#include <linux/pm_opp.h>
+#include <linux/slab.h>
+#include <soc/rockchip/rockchip_opp.h>
+
+#include "cpufreq-dt.h"
+
+#define MAX_NAME_LEN	4
+
+static struct platform_device *cpufreq_dt_pdev, *rockchip_cpufreq_pdev;
+
+/*
+ * Returns the OPP config token, 0 if the OPP table of the CPU isn't binned
+ * or a negative error code.
+ */
+static int rockchip_cpufreq_set_bin(struct device *cpu_dev)
+{
+	struct dev_pm_opp_config config = {};
+	unsigned int supported_hw;
+	char name[MAX_NAME_LEN];
+	int bin, token;
+
+	bin = rockchip_opp_get_leakage_bin(cpu_dev);
+	if (bin == -ENOENT)
+		return 0;
+	if (bin < 0)
+		return bin;
+
+	snprintf(name, MAX_NAME_LEN, "L%d", bin);
+	supported_hw = BIT(bin);
+
+	config.prop_name = name;
+	config.supported_hw = &supported_hw;
+	config.supported_hw_count = 1;
+
+	token = dev_pm_opp_set_config(cpu_dev, &config);
+	if (token > 0)
+		dev_info(cpu_dev, "using leakage bin %d\n", bin);
+
+	return token;
+}
+
+static int rockchip_cpufreq_nvmem_probe(struct platform_device *pdev)
+{
+	const struct of_device_id *match = dev_get_platdata(&pdev->dev);
+	const struct cpufreq_dt_platform_data *pdata = match->data;
+	unsigned int cpu;
+	int *opp_tokens;
+	int ret;
+
+	opp_tokens = kcalloc(num_possible_cpus(), sizeof(*opp_tokens),
+			     GFP_KERNEL);
+	if (!opp_tokens)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct device *cpu_dev = get_cpu_device(cpu);
+
+		if (!cpu_dev) {
+			ret = -ENODEV;
+			goto free_opp;
+		}
+
+		opp_tokens[cpu] = rockchip_cpufreq_set_bin(cpu_dev);
+		if (opp_tokens[cpu] < 0) {
+			ret = dev_err_probe(cpu_dev, opp_tokens[cpu],
+					    "Failed to select leakage bin\n");
+			goto free_opp;
+		}
+	}
+
+	cpufreq_dt_pdev = platform_device_register_data(NULL, "cpufreq-dt", -1,
+							pdata, sizeof(*pdata));
+	if (!IS_ERR(cpufreq_dt_pdev)) {
+		platform_set_drvdata(pdev, opp_tokens);
+		return 0;
+	}
+
+	ret = PTR_ERR(cpufreq_dt_pdev);
+	pr_err("Failed to register platform device\n");
+
+free_opp:
+	for_each_possible_cpu(cpu)
+		dev_pm_opp_clear_config(opp_tokens[cpu]);
+	kfree(opp_tokens);
+
+	return ret;
+}
+
+static int rockchip_cpufreq_nvmem_remove(struct platform_device *pdev)
+{
+	int *opp_tokens = platform_get_drvdata(pdev);
+	unsigned int cpu;
+
+	platform_device_unregister(cpufreq_dt_pdev);
+
+	for_each_possible_cpu(cpu)
+		dev_pm_opp_clear_config(opp_tokens[cpu]);
+
+	kfree(opp_tokens);
+
+	return 0;
+}
+
+static const struct cpufreq_dt_platform_data rk3399_pdata = {
+	.have_governor_per_policy = true,
+};
+
+static const struct of_device_id rockchip_cpufreq_match_list[] = {
+	{ .compatible = "rockchip,rk3399", .data = &rk3399_pdata },
+	{}
+};
+MODULE_DEVICE_TABLE(of, rockchip_cpufreq_match_list);
+
+static struct platform_driver rockchip_cpufreq_driver = {
+	.probe = rockchip_cpufreq_nvmem_probe,
+	.remove = rockchip_cpufreq_nvmem_remove,
+	.driver = {
+		.name = "rockchip-cpufreq-nvmem",
+	},
+};
+
+static const struct of_device_id *rockchip_cpufreq_match_node(void)
+{
+	const struct of_device_id *match;
+	struct device_node *np;
+
+	np = of_find_node_by_path("/");
+	match = of_match_node(rockchip_cpufreq_match_list, np);
+	of_node_put(np);
+
+	return match;
+}
+
+/*
+ * The efuse may not be probed yet, so all the real work is done in the
+ * probe, which can be deferred. The init here only registers the driver
+ * and the platform device, the latter with the SoC match as platform data.
+ */
+static int __init rockchip_cpufreq_init(void)
+{
+	const struct of_device_id *match;
+	int ret;
+
+	match = rockchip_cpufreq_match_node();
+	if (!match)
+		return -ENODEV;
+
+	ret = platform_driver_register(&rockchip_cpufreq_driver);
+	if (unlikely(ret < 0))
+		return ret;
+
+	rockchip_cpufreq_pdev =
+		platform_device_register_data(NULL, "rockchip-cpufreq-nvmem",
+					      -1, match, sizeof(*match));
+	ret = PTR_ERR_OR_ZERO(rockchip_cpufreq_pdev);
+	if (ret == 0)
+		return 0;
+
+	platform_driver_unregister(&rockchip_cpufreq_driver);
+	return ret;
+}
+module_init(rockchip_cpufreq_init);
+
+static void __exit rockchip_cpufreq_exit(void)
+{
+	platform_device_unregister(rockchip_cpufreq_pdev);
+	platform_driver_unregister(&rockchip_cpufreq_driver);
+}
+module_exit(rockchip_cpufreq_exit);
+
+MODULE_DESCRIPTION("Rockchip nvmem based cpufreq driver");
+MODULE_LICENSE("GPL");
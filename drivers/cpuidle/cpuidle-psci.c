@@ -206,6 +206,12 @@ static const struct of_device_id psci_idle_state_match[] = {
 	{ },
 };
 
+static const struct of_device_id psci_cluster_state_match[] = {
+	{ .compatible = "domain-idle-state",
+	  .data = psci_enter_idle_state },
+	{ },
+};
+
 int psci_dt_parse_state_node(struct device_node *np, u32 *state)
 {
 	int err = of_property_read_u32(np, "arm,psci-suspend-param", state);
@@ -249,7 +255,8 @@ static int psci_dt_cpu_init_topology(struct cpuidle_driver *drv,
 
 static int psci_dt_cpu_init_idle(struct device *dev, struct cpuidle_driver *drv,
 				 struct device_node *cpu_node,
-				 unsigned int state_count, int cpu)
+				 unsigned int state_count,
+				 unsigned int cluster_count, int cpu)
 {
 	int i, ret = 0;
 	u32 *psci_states;
@@ -257,13 +264,17 @@ static int psci_dt_cpu_init_idle(struct device *dev, struct cpuidle_driver *drv,
 	struct psci_cpuidle_data *data = per_cpu_ptr(&psci_cpuidle_data, cpu);
 
 	state_count++; /* Add WFI state too */
-	psci_states = devm_kcalloc(dev, state_count, sizeof(*psci_states),
-				   GFP_KERNEL);
+	psci_states = devm_kcalloc(dev, state_count + cluster_count,
+				   sizeof(*psci_states), GFP_KERNEL);
 	if (!psci_states)
 		return -ENOMEM;
 
-	for (i = 1; i < state_count; i++) {
-		state_node = of_get_cpu_state_node(cpu_node, i - 1);
+	for (i = 1; i < state_count + cluster_count; i++) {
+		if (i < state_count)
+			state_node = of_get_cpu_state_node(cpu_node, i - 1);
+		else
+			state_node = dt_get_cluster_state_node(cpu_node,
+							i - state_count);
 		if (!state_node)
 			break;
 
@@ -273,10 +284,18 @@ static int psci_dt_cpu_init_idle(struct device *dev, struct cpuidle_driver *drv,
 		if (ret)
 			return ret;
 
+		/*
+		 * Cluster states are entered with their parameter as is. In
+		 * PC mode that has to be the composite state the CPU votes
+		 * for, its own level included, as for cluster states listed
+		 * in "cpu-idle-states". How the levels of an OSI style,
+		 * cluster only, parameter combine with a CPU state is up to
+		 * the firmware's StateID encoding, so it isn't guessed here.
+		 */
 		pr_debug("psci-power-state %#x index %d\n", psci_states[i], i);
 	}
 
-	if (i != state_count)
+	if (i != state_count + cluster_count)
 		return -ENODEV;
 
 	/* Initialize optional data, used for the hierarchical topology. */
@@ -290,7 +309,8 @@ static int psci_dt_cpu_init_idle(struct device *dev, struct cpuidle_driver *drv,
 }
 
 static int psci_cpu_init_idle(struct device *dev, struct cpuidle_driver *drv,
-			      unsigned int cpu, unsigned int state_count)
+			      unsigned int cpu, unsigned int state_count,
+			      unsigned int cluster_count)
 {
 	struct device_node *cpu_node;
 	int ret;
@@ -306,7 +326,8 @@ static int psci_cpu_init_idle(struct device *dev, struct cpuidle_driver *drv,
 	if (!cpu_node)
 		return -ENODEV;
 
-	ret = psci_dt_cpu_init_idle(dev, drv, cpu_node, state_count, cpu);
+	ret = psci_dt_cpu_init_idle(dev, drv, cpu_node, state_count,
+				    cluster_count, cpu);
 
 	of_node_put(cpu_node);
 
@@ -326,6 +347,7 @@ static int psci_idle_init_cpu(struct device *dev, int cpu)
 	struct cpuidle_driver *drv;
 	struct device_node *cpu_node;
 	const char *enable_method;
+	int cluster_count = 0;
 	int ret = 0;
 
 	cpu_node = of_cpu_device_node_get(cpu);
@@ -374,10 +396,31 @@ static int psci_idle_init_cpu(struct device *dev, int cpu)
 	if (ret <= 0)
 		return ret ? : -ENODEV;
 
+	/*
+	 * Without OSI the hierarchical topology isn't used and the cluster
+	 * power domain states would never be requested. In platform
+	 * coordinated mode, PSCI has the firmware enter the shallowest of
+	 * the states the CPUs of a cluster voted for, so a cluster state is
+	 * only entered once all of them ask for it. Expose those states
+	 * as regular, deeper, per-CPU states. Each CPU's governor then votes
+	 * based on its own next event, which is what the prediction of the
+	 * cluster wide idle period boils down to in this mode.
+	 */
+	if (!psci_has_osi_support()) {
+		cluster_count = dt_init_cluster_idle_driver(drv,
+						psci_cluster_state_match,
+						ret + 1);
+		if (cluster_count < 0) {
+			pr_warn("CPU %d failed to parse cluster idle states\n",
+				cpu);
+			cluster_count = 0;
+		}
+	}
+
 	/*
 	 * Initialize PSCI idle states.
 	 */
-	ret = psci_cpu_init_idle(dev, drv, cpu, ret);
+	ret = psci_cpu_init_idle(dev, drv, cpu, ret, cluster_count);
 	if (ret) {
 		pr_err("CPU %d failed to PSCI idle\n", cpu);
 		return ret;
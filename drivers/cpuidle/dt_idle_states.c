@@ -95,7 +95,9 @@ static int init_state_node(struct cpuidle_state *idle_state,
  * cpumask
  */
 static bool idle_state_valid(struct device_node *state_node, unsigned int idx,
-			     const cpumask_t *cpumask)
+			     const cpumask_t *cpumask,
+			     struct device_node *(*get_state_node)(
+					struct device_node *, int))
 {
 	int cpu;
 	struct device_node *cpu_node, *curr_state_node;
@@ -111,7 +113,7 @@ static bool idle_state_valid(struct device_node *state_node, unsigned int idx,
 	for (cpu = cpumask_next(cpumask_first(cpumask), cpumask);
 	     cpu < nr_cpu_ids; cpu = cpumask_next(cpu, cpumask)) {
 		cpu_node = of_cpu_device_node_get(cpu);
-		curr_state_node = of_get_cpu_state_node(cpu_node, idx);
+		curr_state_node = get_state_node(cpu_node, idx);
 		if (state_node != curr_state_node)
 			valid = false;
 
@@ -124,31 +126,11 @@ static bool idle_state_valid(struct device_node *state_node, unsigned int idx,
 	return valid;
 }
 
-/**
- * dt_init_idle_driver() - Parse the DT idle states and initialize the
- *			   idle driver states array
- * @drv:	  Pointer to CPU idle driver to be initialized
- * @matches:	  Array of of_device_id match structures to search in for
- *		  compatible idle state nodes. The data pointer for each valid
- *		  struct of_device_id entry in the matches array must point to
- *		  a function with the following signature, that corresponds to
- *		  the CPUidle state enter function signature:
- *
- *		  int (*)(struct cpuidle_device *dev,
- *			  struct cpuidle_driver *drv,
- *			  int index);
- *
- * @start_idx:    First idle state index to be initialized
- *
- * If DT idle states are detected and are valid the state count and states
- * array entries in the cpuidle driver are initialized accordingly starting
- * from index start_idx.
- *
- * Return: number of valid DT idle states parsed, <0 on failure
- */
-int dt_init_idle_driver(struct cpuidle_driver *drv,
-			const struct of_device_id *matches,
-			unsigned int start_idx)
+static int __dt_init_idle_driver(struct cpuidle_driver *drv,
+				 const struct of_device_id *matches,
+				 unsigned int start_idx,
+				 struct device_node *(*get_state_node)(
+					struct device_node *, int))
 {
 	struct cpuidle_state *idle_state;
 	struct device_node *state_node, *cpu_node;
@@ -169,7 +151,7 @@ int dt_init_idle_driver(struct cpuidle_driver *drv,
 	cpu_node = of_cpu_device_node_get(cpumask_first(cpumask));
 
 	for (i = 0; ; i++) {
-		state_node = of_get_cpu_state_node(cpu_node, i);
+		state_node = get_state_node(cpu_node, i);
 		if (!state_node)
 			break;
 
@@ -184,7 +166,7 @@ int dt_init_idle_driver(struct cpuidle_driver *drv,
 			continue;
 		}
 
-		if (!idle_state_valid(state_node, i, cpumask)) {
+		if (!idle_state_valid(state_node, i, cpumask, get_state_node)) {
 			pr_warn("%pOF idle state not valid, bailing out\n",
 				state_node);
 			err = -EINVAL;
@@ -225,4 +207,92 @@ int dt_init_idle_driver(struct cpuidle_driver *drv,
 	 */
 	return state_idx - start_idx;
 }
+
+/**
+ * dt_init_idle_driver() - Parse the DT idle states and initialize the
+ *			   idle driver states array
+ * @drv:	  Pointer to CPU idle driver to be initialized
+ * @matches:	  Array of of_device_id match structures to search in for
+ *		  compatible idle state nodes. The data pointer for each valid
+ *		  struct of_device_id entry in the matches array must point to
+ *		  a function with the following signature, that corresponds to
+ *		  the CPUidle state enter function signature:
+ *
+ *		  int (*)(struct cpuidle_device *dev,
+ *			  struct cpuidle_driver *drv,
+ *			  int index);
+ *
+ * @start_idx:    First idle state index to be initialized
+ *
+ * If DT idle states are detected and are valid the state count and states
+ * array entries in the cpuidle driver are initialized accordingly starting
+ * from index start_idx.
+ *
+ * Return: number of valid DT idle states parsed, <0 on failure
+ */
+int dt_init_idle_driver(struct cpuidle_driver *drv,
+			const struct of_device_id *matches,
+			unsigned int start_idx)
+{
+	return __dt_init_idle_driver(drv, matches, start_idx,
+				     of_get_cpu_state_node);
+}
 EXPORT_SYMBOL_GPL(dt_init_idle_driver);
+
+/**
+ * dt_get_cluster_state_node() - Get an idle state node of a CPU's cluster
+ * @cpu_node:	The device node for the CPU
+ * @index:	The index in the list of the idle states
+ *
+ * In the hierarchical layout the CPU's own power domain may be a subdomain
+ * of a cluster power domain, whose "domain-idle-states" describe the states
+ * shared by all CPUs in the cluster.
+ *
+ * Return: An idle state node of the cluster power domain if found at
+ * @index, with its refcount incremented. NULL otherwise.
+ */
+struct device_node *dt_get_cluster_state_node(struct device_node *cpu_node,
+					      int index)
+{
+	struct of_phandle_args cpu_pd, cluster_pd;
+	struct device_node *state_node = NULL;
+
+	if (of_parse_phandle_with_args(cpu_node, "power-domains",
+				       "#power-domain-cells", 0, &cpu_pd))
+		return NULL;
+
+	if (!of_parse_phandle_with_args(cpu_pd.np, "power-domains",
+					"#power-domain-cells", 0,
+					&cluster_pd)) {
+		state_node = of_parse_phandle(cluster_pd.np,
+					      "domain-idle-states", index);
+		of_node_put(cluster_pd.np);
+	}
+	of_node_put(cpu_pd.np);
+
+	return state_node;
+}
+EXPORT_SYMBOL_GPL(dt_get_cluster_state_node);
+
+/**
+ * dt_init_cluster_idle_driver() - Append the DT cluster idle states to the
+ *				   idle driver states array
+ * @drv:	  Pointer to CPU idle driver to be initialized
+ * @matches:	  Array of of_device_id match structures, as for
+ *		  dt_init_idle_driver()
+ * @start_idx:    First idle state index to be initialized
+ *
+ * For platform coordinated firmware, where each CPU votes for the deepest
+ * state it can tolerate and the firmware picks the shallowest common one,
+ * the states of the cluster power domain are plain per-CPU states.
+ *
+ * Return: number of valid DT cluster idle states parsed, <0 on failure
+ */
+int dt_init_cluster_idle_driver(struct cpuidle_driver *drv,
+				const struct of_device_id *matches,
+				unsigned int start_idx)
+{
+	return __dt_init_idle_driver(drv, matches, start_idx,
+				     dt_get_cluster_state_node);
+}
+EXPORT_SYMBOL_GPL(dt_init_cluster_idle_driver);
@@ -5,4 +5,9 @@
 int dt_init_idle_driver(struct cpuidle_driver *drv,
 			const struct of_device_id *matches,
 			unsigned int start_idx);
+int dt_init_cluster_idle_driver(struct cpuidle_driver *drv,
+				const struct of_device_id *matches,
+				unsigned int start_idx);
+struct device_node *dt_get_cluster_state_node(struct device_node *cpu_node,
+					      int index);
 #endif
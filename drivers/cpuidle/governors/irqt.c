@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * IRQ timings based CPU idle governor.
+ *
+ * The menu and teo governors both start from the next timer event and
+ * correct it with the history of recent idle durations. On systems where
+ * wakeups are dominated by periodic device interrupts (network rings,
+ * display vblank, audio DMA periods) neither of them knows when the next
+ * interrupt is due, so they either pick a state that is too deep and add
+ * exit latency to every period, or stay shallow and waste energy.
+ *
+ * The irq timings framework records the arrival times of the interrupts
+ * handled on each CPU and predicts the next one from the repeating
+ * patterns it finds. This governor uses the earliest of that prediction
+ * and the next timer event as the expected idle duration and picks the
+ * deepest state that fits it and the current latency constraint.
+ *
+ * A prediction that keeps turning out to be wrong, i.e. the CPU stays idle
+ * well past the predicted interrupt, is ignored until the pattern settles
+ * again, so the governor degrades to plain timer based selection.
+ */
+
+#include <linux/cpuidle.h>
+#include <linux/interrupt.h>
+#include <linux/kernel.h>
+#include <linux/percpu.h>
+#include <linux/sched/clock.h>
+#include <linux/string.h>
+#include <linux/tick.h>
+
+#include "../cpuidle.h"
+
+/*
+ * Number of consecutive mispredictions after which the IRQ prediction is
+ * not trusted anymore.
+ */
+#define IRQT_MISS_THRESHOLD	4
+#define IRQT_MISS_MAX		(2 * IRQT_MISS_THRESHOLD)
+
+/**
+ * struct irqt_cpu - CPU data used by the IRQ timings governor.
+ * @irq_ns: Time to the predicted interrupt when the last state was selected,
+ *	    0 if there was no prediction.
+ * @misses: Recent mispredictions count.
+ */
+struct irqt_cpu {
+	u64 irq_ns;
+	unsigned int misses;
+};
+
+static DEFINE_PER_CPU(struct irqt_cpu, irqt_cpus);
+
+/**
+ * irqt_update - Check the last interrupt prediction against reality.
+ * @dev: Target CPU.
+ */
+static void irqt_update(struct cpuidle_device *dev)
+{
+	struct irqt_cpu *cpu_data = per_cpu_ptr(&irqt_cpus, dev->cpu);
+
+	if (!cpu_data->irq_ns)
+		return;
+
+	/*
+	 * Waking up well after the predicted interrupt means it didn't come.
+	 * Waking up earlier is fine, something else woke the CPU up.
+	 */
+	if (dev->last_residency_ns > 2 * cpu_data->irq_ns) {
+		if (cpu_data->misses < IRQT_MISS_MAX)
+			cpu_data->misses++;
+	} else if (cpu_data->misses) {
+		cpu_data->misses--;
+	}
+}
+
+/**
+ * irqt_select - Select an idle state to enter.
+ * @drv: cpuidle driver containing state data.
+ * @dev: Target CPU.
+ * @stop_tick: Indication on whether or not to stop the scheduler tick.
+ */
+static int irqt_select(struct cpuidle_driver *drv, struct cpuidle_device *dev,
+		       bool *stop_tick)
+{
+	struct irqt_cpu *cpu_data = per_cpu_ptr(&irqt_cpus, dev->cpu);
+	s64 latency_req = cpuidle_governor_latency_req(dev->cpu);
+	u64 predicted_ns, next_irq, now;
+	ktime_t delta_tick;
+	int i, idx = 0;
+
+	if (dev->last_state_idx >= 0) {
+		irqt_update(dev);
+		dev->last_state_idx = -1;
+	}
+
+	predicted_ns = tick_nohz_get_sleep_length(&delta_tick);
+
+	now = local_clock();
+	next_irq = irq_timings_next_event(now);
+	if (next_irq != U64_MAX && next_irq > now) {
+		cpu_data->irq_ns = next_irq - now;
+		if (cpu_data->misses < IRQT_MISS_THRESHOLD)
+			predicted_ns = min(predicted_ns, cpu_data->irq_ns);
+	} else {
+		cpu_data->irq_ns = 0;
+	}
+
+	for (i = 0; i < drv->state_count; i++) {
+		struct cpuidle_state *s = &drv->states[i];
+
+		if (dev->states_usage[i].disable)
+			continue;
+
+		if (s->target_residency_ns > predicted_ns ||
+		    s->exit_latency_ns > latency_req)
+			break;
+
+		idx = i;
+	}
+
+	/*
+	 * Don't stop the tick if the CPU is expected to wake up before it
+	 * anyway, unless it has been stopped already. Polling doesn't need
+	 * the tick to be stopped either.
+	 */
+	if ((drv->states[idx].flags & CPUIDLE_FLAG_POLLING) ||
+	    (predicted_ns < TICK_NSEC && !tick_nohz_tick_stopped()))
+		*stop_tick = false;
+
+	return idx;
+}
+
+/**
+ * irqt_reflect - Note that governor data for the CPU need to be updated.
+ * @dev: Target CPU.
+ * @state: Entered state.
+ */
+static void irqt_reflect(struct cpuidle_device *dev, int state)
+{
+	dev->last_state_idx = state;
+}
+
+/**
+ * irqt_enable_device - Initialize the governor's data for the target CPU.
+ * @drv: cpuidle driver (not used).
+ * @dev: Target CPU.
+ */
+static int irqt_enable_device(struct cpuidle_driver *drv,
+			      struct cpuidle_device *dev)
+{
+	struct irqt_cpu *cpu_data = per_cpu_ptr(&irqt_cpus, dev->cpu);
+
+	memset(cpu_data, 0, sizeof(*cpu_data));
+
+	return 0;
+}
+
+static struct cpuidle_governor irqt_governor = {
+	.name =		"irqt",
+	.rating =	18,
+	.enable =	irqt_enable_device,
+	.select =	irqt_select,
+	.reflect =	irqt_reflect,
+};
+
+static int __init irqt_governor_init(void)
+{
+	/*
+	 * Recording the irq timings costs every interrupt, so only do it
+	 * when this governor is asked for with cpuidle.governor=irqt. It
+	 * can't follow sysfs switches either: ->enable() may run from CPU
+	 * hotplug callbacks where flipping the static key isn't allowed.
+	 * Without the recording there are no predictions, and the governor
+	 * just goes by the next timer event.
+	 */
+	if (!strncasecmp(param_governor, irqt_governor.name, CPUIDLE_NAME_LEN))
+		irq_timings_enable();
+
+	return cpuidle_register_governor(&irqt_governor);
+}
+
+postcore_initcall(irqt_governor_init);
@@ -17,6 +17,10 @@
 #include <linux/slab.h>
 #include <linux/list.h>
 #include <linux/of.h>
+#include <linux/cpuhotplug.h>
+#include <linux/hrtimer.h>
+#include <linux/mutex.h>
+#include <linux/perf_event.h>
 
 #define PX30_PMUGRF_OS_REG2		0x208
 
@@ -50,6 +54,8 @@
 #define MAX_DMC_NUM_CH			2
 #define READ_DRAMTYPE_INFO(n)		(((n) >> 13) & 0x7)
 #define READ_CH_INFO(n)			(((n) >> 28) & 0x3)
+/* log2 of the bus width in bytes of channel ch */
+#define READ_BW_INFO(n, ch)		(2 >> (((n) >> (2 + 16 * (ch))) & 0x3))
 /* DDRMON_CTRL */
 #define DDRMON_CTRL			0x04
 #define CLR_DDRMON_CTRL			(0x3f0000 << 0)
@@ -61,6 +67,8 @@
 #define SOFTWARE_DIS			(0x10000 << 1)
 #define TIME_CNT_EN			(0x10001 << 0)
 
+#define DDRMON_CH0_WR_NUM		0x20
+#define DDRMON_CH0_RD_NUM		0x24
 #define DDRMON_CH0_COUNT_NUM		0x28
 #define DDRMON_CH0_DFI_ACCESS_NUM	0x2c
 #define DDRMON_CH1_COUNT_NUM		0x3c
@@ -83,6 +91,25 @@ struct dmc_usage {
 	u32 total;
 };
 
+/* Free running DDRMON counters of one channel */
+struct dmc_count_channel {
+	u32 access;
+	u32 clock_cycles;
+	u32 read_access;
+	u32 write_access;
+};
+
+struct dmc_count {
+	struct dmc_count_channel c[MAX_DMC_NUM_CH];
+};
+
+/* 64 bit totals accumulated from the DDRMON counters for perf */
+struct dmc_perf_total {
+	u64 cycles;
+	u64 read_bytes[MAX_DMC_NUM_CH];
+	u64 write_bytes[MAX_DMC_NUM_CH];
+};
+
 /*
  * The dfi controller can monitor DDR load. It has an upper and lower threshold
  * for the operating points. Whenever the usage leaves these bounds an event is
@@ -104,6 +131,29 @@ struct rockchip_dfi {
 	 * each bit represent a channel
 	 */
 	u32 ch_msk;
+
+	/*
+	 * The DDRMON counters are shared by devfreq and perf, they run while
+	 * either has them enabled and each user keeps its own reference
+	 * values.
+	 */
+	struct mutex mutex;
+	unsigned int usecount;
+	struct dmc_count last_event_count;
+	unsigned int burst_len;
+	unsigned int buswidth[MAX_DMC_NUM_CH];
+
+#ifdef CONFIG_PERF_EVENTS
+	struct pmu pmu;
+	unsigned int cpu;
+	int cpuhp_state;
+	struct hlist_node node;
+	struct hrtimer timer;
+	unsigned int perf_events;
+	spinlock_t count_lock;	/* protects last_perf_count and total */
+	struct dmc_count last_perf_count;
+	struct dmc_perf_total total;
+#endif
 };
 
 static void rk3128_dfi_start_hardware_counter(struct devfreq_event_dev *edev)
@@ -331,9 +381,8 @@ static const struct devfreq_event_ops rk3368_dfi_ops = {
 	.set_event = rk3368_dfi_set_event,
 };
 
-static void rockchip_dfi_start_hardware_counter(struct devfreq_event_dev *edev)
+static void rockchip_dfi_start_hardware_counter(struct rockchip_dfi *info)
 {
-	struct rockchip_dfi *info = devfreq_event_get_drvdata(edev);
 	void __iomem *dfi_regs = info->regs;
 
 	/* clear DDRMON_CTRL setting */
@@ -351,34 +400,93 @@ static void rockchip_dfi_start_hardware_counter(struct devfreq_event_dev *edev)
 	writel_relaxed(SOFTWARE_EN, dfi_regs + DDRMON_CTRL);
 }
 
-static void rockchip_dfi_stop_hardware_counter(struct devfreq_event_dev *edev)
+static void rockchip_dfi_stop_hardware_counter(struct rockchip_dfi *info)
 {
-	struct rockchip_dfi *info = devfreq_event_get_drvdata(edev);
 	void __iomem *dfi_regs = info->regs;
 
 	writel_relaxed(SOFTWARE_DIS, dfi_regs + DDRMON_CTRL);
 }
 
+static int rockchip_dfi_hw_enable(struct rockchip_dfi *info)
+{
+	int ret = 0;
+
+	mutex_lock(&info->mutex);
+
+	if (info->usecount++)
+		goto out;
+
+	if (info->clk) {
+		ret = clk_prepare_enable(info->clk);
+		if (ret) {
+			dev_err(info->dev, "failed to enable dfi clk: %d\n",
+				ret);
+			info->usecount--;
+			goto out;
+		}
+	}
+
+	rockchip_dfi_start_hardware_counter(info);
+out:
+	mutex_unlock(&info->mutex);
+
+	return ret;
+}
+
+static void rockchip_dfi_hw_disable(struct rockchip_dfi *info)
+{
+	mutex_lock(&info->mutex);
+
+	if (!WARN_ON(!info->usecount) && !--info->usecount) {
+		rockchip_dfi_stop_hardware_counter(info);
+		if (info->clk)
+			clk_disable_unprepare(info->clk);
+	}
+
+	mutex_unlock(&info->mutex);
+}
+
+static void rockchip_dfi_read_counters(struct rockchip_dfi *info,
+				       struct dmc_count *count)
+{
+	void __iomem *dfi_regs = info->regs;
+	u32 i;
+
+	for (i = 0; i < MAX_DMC_NUM_CH; i++) {
+		if (!(info->ch_msk & BIT(i)))
+			continue;
+
+		count->c[i].read_access = readl_relaxed(dfi_regs +
+				DDRMON_CH0_RD_NUM + i * 20);
+		count->c[i].write_access = readl_relaxed(dfi_regs +
+				DDRMON_CH0_WR_NUM + i * 20);
+		count->c[i].access = readl_relaxed(dfi_regs +
+				DDRMON_CH0_DFI_ACCESS_NUM + i * 20);
+		count->c[i].clock_cycles = readl_relaxed(dfi_regs +
+				DDRMON_CH0_COUNT_NUM + i * 20);
+	}
+}
+
 static int rockchip_dfi_get_busier_ch(struct devfreq_event_dev *edev)
 {
 	struct rockchip_dfi *info = devfreq_event_get_drvdata(edev);
+	struct dmc_count count;
 	u32 tmp, max = 0;
 	u32 i, busier_ch = 0;
-	void __iomem *dfi_regs = info->regs;
 
-	rockchip_dfi_stop_hardware_counter(edev);
+	rockchip_dfi_read_counters(info, &count);
 
 	/* Find out which channel is busier */
 	for (i = 0; i < MAX_DMC_NUM_CH; i++) {
 		if (!(info->ch_msk & BIT(i)))
 			continue;
 
-		info->ch_usage[i].total = readl_relaxed(dfi_regs +
-				DDRMON_CH0_COUNT_NUM + i * 20);
+		/* the counters are free running, wrap around is fine here */
+		info->ch_usage[i].total = count.c[i].clock_cycles -
+					  info->last_event_count.c[i].clock_cycles;
 
 		/* LPDDR4 BL = 16,other DDR type BL = 8 */
-		tmp = readl_relaxed(dfi_regs +
-				DDRMON_CH0_DFI_ACCESS_NUM + i * 20);
+		tmp = count.c[i].access - info->last_event_count.c[i].access;
 		if (info->dram_type == LPDDR4)
 			tmp *= 8;
 		else
@@ -390,7 +498,7 @@ static int rockchip_dfi_get_busier_ch(struct devfreq_event_dev *edev)
 			max = tmp;
 		}
 	}
-	rockchip_dfi_start_hardware_counter(edev);
+	info->last_event_count = count;
 
 	return busier_ch;
 }
@@ -399,9 +507,7 @@ static int rockchip_dfi_disable(struct devfreq_event_dev *edev)
 {
 	struct rockchip_dfi *info = devfreq_event_get_drvdata(edev);
 
-	rockchip_dfi_stop_hardware_counter(edev);
-	if (info->clk)
-		clk_disable_unprepare(info->clk);
+	rockchip_dfi_hw_disable(info);
 
 	return 0;
 }
@@ -411,16 +517,12 @@ static int rockchip_dfi_enable(struct devfreq_event_dev *edev)
 	struct rockchip_dfi *info = devfreq_event_get_drvdata(edev);
 	int ret;
 
-	if (info->clk) {
-		ret = clk_prepare_enable(info->clk);
-		if (ret) {
-			dev_err(&edev->dev, "failed to enable dfi clk: %d\n",
-				ret);
-			return ret;
-		}
-	}
+	ret = rockchip_dfi_hw_enable(info);
+	if (ret)
+		return ret;
+
+	rockchip_dfi_read_counters(info, &info->last_event_count);
 
-	rockchip_dfi_start_hardware_counter(edev);
 	return 0;
 }
 
@@ -434,11 +536,8 @@ static int rockchip_dfi_get_event(struct devfreq_event_dev *edev,
 {
 	struct rockchip_dfi *info = devfreq_event_get_drvdata(edev);
 	int busier_ch;
-	unsigned long flags;
 
-	local_irq_save(flags);
 	busier_ch = rockchip_dfi_get_busier_ch(edev);
-	local_irq_restore(flags);
 
 	edata->load_count = info->ch_usage[busier_ch].access;
 	edata->total_count = info->ch_usage[busier_ch].total;
@@ -453,6 +552,403 @@ static const struct devfreq_event_ops rockchip_dfi_ops = {
 	.set_event = rockchip_dfi_set_event,
 };
 
+#ifdef CONFIG_PERF_EVENTS
+
+enum {
+	PERF_EVENT_CYCLES,
+	PERF_EVENT_READ_BYTES,
+	PERF_EVENT_WRITE_BYTES,
+	PERF_EVENT_READ_BYTES0,
+	PERF_EVENT_WRITE_BYTES0,
+	PERF_EVENT_READ_BYTES1,
+	PERF_EVENT_WRITE_BYTES1,
+	PERF_EVENT_BYTES,
+	PERF_EVENT_MAX,
+};
+
+/*
+ * The 32 bit clock cycle counter wraps within a few seconds at the higher
+ * DDR rates, fold the counters into the 64 bit totals well before that.
+ */
+#define DFI_PERF_POLL_NS	NSEC_PER_SEC
+
+static void rockchip_ddr_perf_update_total(struct rockchip_dfi *dfi)
+{
+	struct dmc_count *last = &dfi->last_perf_count;
+	struct dmc_perf_total *total = &dfi->total;
+	struct dmc_count now;
+	bool cycles_done = false;
+	u32 i;
+
+	lockdep_assert_held(&dfi->count_lock);
+
+	rockchip_dfi_read_counters(dfi, &now);
+
+	for (i = 0; i < MAX_DMC_NUM_CH; i++) {
+		unsigned int burst_bytes = dfi->burst_len * dfi->buswidth[i];
+
+		if (!(dfi->ch_msk & BIT(i)))
+			continue;
+
+		if (!cycles_done) {
+			total->cycles += (u32)(now.c[i].clock_cycles -
+					       last->c[i].clock_cycles);
+			cycles_done = true;
+		}
+
+		total->read_bytes[i] += (u64)(u32)(now.c[i].read_access -
+						   last->c[i].read_access) *
+					burst_bytes;
+		total->write_bytes[i] += (u64)(u32)(now.c[i].write_access -
+						    last->c[i].write_access) *
+					 burst_bytes;
+	}
+
+	*last = now;
+}
+
+static u64 rockchip_ddr_perf_event_get_count(struct perf_event *event)
+{
+	struct rockchip_dfi *dfi = container_of(event->pmu, struct rockchip_dfi, pmu);
+	struct dmc_perf_total *total = &dfi->total;
+	unsigned long flags;
+	u64 count = 0;
+	u32 i;
+
+	spin_lock_irqsave(&dfi->count_lock, flags);
+
+	rockchip_ddr_perf_update_total(dfi);
+
+	switch (event->attr.config) {
+	case PERF_EVENT_CYCLES:
+		count = total->cycles;
+		break;
+	case PERF_EVENT_READ_BYTES:
+		for (i = 0; i < MAX_DMC_NUM_CH; i++)
+			count += total->read_bytes[i];
+		break;
+	case PERF_EVENT_WRITE_BYTES:
+		for (i = 0; i < MAX_DMC_NUM_CH; i++)
+			count += total->write_bytes[i];
+		break;
+	case PERF_EVENT_READ_BYTES0:
+		count = total->read_bytes[0];
+		break;
+	case PERF_EVENT_WRITE_BYTES0:
+		count = total->write_bytes[0];
+		break;
+	case PERF_EVENT_READ_BYTES1:
+		count = total->read_bytes[1];
+		break;
+	case PERF_EVENT_WRITE_BYTES1:
+		count = total->write_bytes[1];
+		break;
+	case PERF_EVENT_BYTES:
+		for (i = 0; i < MAX_DMC_NUM_CH; i++)
+			count += total->read_bytes[i] + total->write_bytes[i];
+		break;
+	}
+
+	spin_unlock_irqrestore(&dfi->count_lock, flags);
+
+	return count;
+}
+
+static enum hrtimer_restart rockchip_ddr_perf_timer(struct hrtimer *timer)
+{
+	struct rockchip_dfi *dfi = container_of(timer, struct rockchip_dfi, timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&dfi->count_lock, flags);
+	rockchip_ddr_perf_update_total(dfi);
+	spin_unlock_irqrestore(&dfi->count_lock, flags);
+
+	hrtimer_forward_now(timer, ns_to_ktime(DFI_PERF_POLL_NS));
+
+	return HRTIMER_RESTART;
+}
+
+static void rockchip_ddr_perf_event_destroy(struct perf_event *event)
+{
+	struct rockchip_dfi *dfi = container_of(event->pmu, struct rockchip_dfi, pmu);
+
+	mutex_lock(&dfi->mutex);
+	if (!--dfi->perf_events)
+		hrtimer_cancel(&dfi->timer);
+	mutex_unlock(&dfi->mutex);
+
+	rockchip_dfi_hw_disable(dfi);
+}
+
+static int rockchip_ddr_perf_event_init(struct perf_event *event)
+{
+	struct rockchip_dfi *dfi = container_of(event->pmu, struct rockchip_dfi, pmu);
+	unsigned long flags;
+	int ret;
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/* the DDR counters are system wide, there is nothing per task */
+	if (event->attach_state & PERF_ATTACH_TASK)
+		return -EINVAL;
+
+	if (event->cpu < 0)
+		return -EINVAL;
+
+	if (event->attr.config >= PERF_EVENT_MAX)
+		return -EINVAL;
+
+	if ((event->attr.config == PERF_EVENT_READ_BYTES1 ||
+	     event->attr.config == PERF_EVENT_WRITE_BYTES1) &&
+	    !(dfi->ch_msk & BIT(1)))
+		return -ENODEV;
+
+	event->cpu = dfi->cpu;
+
+	ret = rockchip_dfi_hw_enable(dfi);
+	if (ret)
+		return ret;
+
+	mutex_lock(&dfi->mutex);
+	if (!dfi->perf_events++) {
+		spin_lock_irqsave(&dfi->count_lock, flags);
+		rockchip_dfi_read_counters(dfi, &dfi->last_perf_count);
+		spin_unlock_irqrestore(&dfi->count_lock, flags);
+
+		hrtimer_start(&dfi->timer, ns_to_ktime(DFI_PERF_POLL_NS),
+			      HRTIMER_MODE_REL);
+	}
+	mutex_unlock(&dfi->mutex);
+
+	event->destroy = rockchip_ddr_perf_event_destroy;
+
+	return 0;
+}
+
+static void rockchip_ddr_perf_event_update(struct perf_event *event)
+{
+	u64 now, prev;
+
+	now = rockchip_ddr_perf_event_get_count(event);
+	prev = local64_xchg(&event->hw.prev_count, now);
+	local64_add(now - prev, &event->count);
+}
+
+static void rockchip_ddr_perf_event_start(struct perf_event *event, int flags)
+{
+	local64_set(&event->hw.prev_count,
+		    rockchip_ddr_perf_event_get_count(event));
+}
+
+static void rockchip_ddr_perf_event_stop(struct perf_event *event, int flags)
+{
+	rockchip_ddr_perf_event_update(event);
+}
+
+static int rockchip_ddr_perf_event_add(struct perf_event *event, int flags)
+{
+	if (flags & PERF_EF_START)
+		rockchip_ddr_perf_event_start(event, flags);
+
+	return 0;
+}
+
+static void rockchip_ddr_perf_event_del(struct perf_event *event, int flags)
+{
+	rockchip_ddr_perf_event_stop(event, PERF_EF_UPDATE);
+}
+
+static ssize_t ddr_perf_cpumask_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct pmu *pmu = dev_get_drvdata(dev);
+	struct rockchip_dfi *dfi = container_of(pmu, struct rockchip_dfi, pmu);
+
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(dfi->cpu));
+}
+
+static struct device_attribute ddr_perf_cpumask_attr =
+	__ATTR(cpumask, 0444, ddr_perf_cpumask_show, NULL);
+
+static struct attribute *ddr_perf_cpumask_attrs[] = {
+	&ddr_perf_cpumask_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group ddr_perf_cpumask_attr_group = {
+	.attrs = ddr_perf_cpumask_attrs,
+};
+
+PMU_EVENT_ATTR_STRING(cycles, ddr_pmu_cycles, "event=0x00");
+PMU_EVENT_ATTR_STRING(read-bytes, ddr_pmu_read_bytes, "event=0x01");
+PMU_EVENT_ATTR_STRING(read-bytes.unit, ddr_pmu_read_bytes_unit, "B");
+PMU_EVENT_ATTR_STRING(write-bytes, ddr_pmu_write_bytes, "event=0x02");
+PMU_EVENT_ATTR_STRING(write-bytes.unit, ddr_pmu_write_bytes_unit, "B");
+PMU_EVENT_ATTR_STRING(read-bytes0, ddr_pmu_read_bytes0, "event=0x03");
+PMU_EVENT_ATTR_STRING(read-bytes0.unit, ddr_pmu_read_bytes0_unit, "B");
+PMU_EVENT_ATTR_STRING(write-bytes0, ddr_pmu_write_bytes0, "event=0x04");
+PMU_EVENT_ATTR_STRING(write-bytes0.unit, ddr_pmu_write_bytes0_unit, "B");
+PMU_EVENT_ATTR_STRING(read-bytes1, ddr_pmu_read_bytes1, "event=0x05");
+PMU_EVENT_ATTR_STRING(read-bytes1.unit, ddr_pmu_read_bytes1_unit, "B");
+PMU_EVENT_ATTR_STRING(write-bytes1, ddr_pmu_write_bytes1, "event=0x06");
+PMU_EVENT_ATTR_STRING(write-bytes1.unit, ddr_pmu_write_bytes1_unit, "B");
+PMU_EVENT_ATTR_STRING(bytes, ddr_pmu_bytes, "event=0x07");
+PMU_EVENT_ATTR_STRING(bytes.unit, ddr_pmu_bytes_unit, "B");
+
+static struct attribute *ddr_perf_events_attrs[] = {
+	&ddr_pmu_cycles.attr.attr,
+	&ddr_pmu_read_bytes.attr.attr,
+	&ddr_pmu_read_bytes_unit.attr.attr,
+	&ddr_pmu_write_bytes.attr.attr,
+	&ddr_pmu_write_bytes_unit.attr.attr,
+	&ddr_pmu_read_bytes0.attr.attr,
+	&ddr_pmu_read_bytes0_unit.attr.attr,
+	&ddr_pmu_write_bytes0.attr.attr,
+	&ddr_pmu_write_bytes0_unit.attr.attr,
+	&ddr_pmu_read_bytes1.attr.attr,
+	&ddr_pmu_read_bytes1_unit.attr.attr,
+	&ddr_pmu_write_bytes1.attr.attr,
+	&ddr_pmu_write_bytes1_unit.attr.attr,
+	&ddr_pmu_bytes.attr.attr,
+	&ddr_pmu_bytes_unit.attr.attr,
+	NULL,
+};
+
+static const struct attribute_group ddr_perf_events_attr_group = {
+	.name = "events",
+	.attrs = ddr_perf_events_attrs,
+};
+
+PMU_FORMAT_ATTR(event, "config:0-7");
+
+static struct attribute *ddr_perf_format_attrs[] = {
+	&format_attr_event.attr,
+	NULL,
+};
+
+static const struct attribute_group ddr_perf_format_attr_group = {
+	.name = "format",
+	.attrs = ddr_perf_format_attrs,
+};
+
+static const struct attribute_group *attr_groups[] = {
+	&ddr_perf_events_attr_group,
+	&ddr_perf_cpumask_attr_group,
+	&ddr_perf_format_attr_group,
+	NULL,
+};
+
+static int ddr_perf_offline_cpu(unsigned int cpu, struct hlist_node *node)
+{
+	struct rockchip_dfi *dfi = hlist_entry_safe(node, struct rockchip_dfi, node);
+	unsigned int target;
+
+	if (cpu != dfi->cpu)
+		return 0;
+
+	target = cpumask_any_but(cpu_online_mask, cpu);
+	if (target >= nr_cpu_ids)
+		return 0;
+
+	perf_pmu_migrate_context(&dfi->pmu, cpu, target);
+	dfi->cpu = target;
+
+	return 0;
+}
+
+static void rockchip_ddr_cpuhp_remove_state(void *data)
+{
+	struct rockchip_dfi *dfi = data;
+
+	cpuhp_remove_multi_state(dfi->cpuhp_state);
+}
+
+static void rockchip_ddr_cpuhp_remove_instance(void *data)
+{
+	struct rockchip_dfi *dfi = data;
+
+	cpuhp_state_remove_instance_nocalls(dfi->cpuhp_state, &dfi->node);
+}
+
+static void rockchip_ddr_perf_remove(void *data)
+{
+	struct rockchip_dfi *dfi = data;
+
+	perf_pmu_unregister(&dfi->pmu);
+}
+
+static int rockchip_ddr_perf_init(struct rockchip_dfi *dfi)
+{
+	struct pmu *pmu = &dfi->pmu;
+	int ret;
+
+	spin_lock_init(&dfi->count_lock);
+	hrtimer_init(&dfi->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	dfi->timer.function = rockchip_ddr_perf_timer;
+
+	pmu->module = THIS_MODULE;
+	pmu->capabilities = PERF_PMU_CAP_NO_EXCLUDE;
+	pmu->task_ctx_nr = perf_invalid_context;
+	pmu->attr_groups = attr_groups;
+	pmu->event_init = rockchip_ddr_perf_event_init;
+	pmu->add = rockchip_ddr_perf_event_add;
+	pmu->del = rockchip_ddr_perf_event_del;
+	pmu->start = rockchip_ddr_perf_event_start;
+	pmu->stop = rockchip_ddr_perf_event_stop;
+	pmu->read = rockchip_ddr_perf_event_update;
+
+	dfi->cpu = raw_smp_processor_id();
+
+	ret = cpuhp_setup_state_multi(CPUHP_AP_ONLINE_DYN,
+				      "rockchip_ddr_perf_pmu",
+				      NULL,
+				      ddr_perf_offline_cpu);
+	if (ret < 0) {
+		dev_err(dfi->dev, "cpuhp_setup_state_multi failed: %d\n", ret);
+		return ret;
+	}
+
+	dfi->cpuhp_state = ret;
+
+	ret = devm_add_action_or_reset(dfi->dev, rockchip_ddr_cpuhp_remove_state, dfi);
+	if (ret)
+		return ret;
+
+	ret = cpuhp_state_add_instance_nocalls(dfi->cpuhp_state, &dfi->node);
+	if (ret) {
+		dev_err(dfi->dev, "Error %d registering hotplug\n", ret);
+		return ret;
+	}
+
+	ret = devm_add_action_or_reset(dfi->dev, rockchip_ddr_cpuhp_remove_instance, dfi);
+	if (ret)
+		return ret;
+
+	ret = perf_pmu_register(pmu, "rockchip_ddr", -1);
+	if (ret)
+		return ret;
+
+	return devm_add_action_or_reset(dfi->dev, rockchip_ddr_perf_remove, dfi);
+}
+#else
+static int rockchip_ddr_perf_init(struct rockchip_dfi *dfi)
+{
+	return 0;
+}
+#endif
+
+static void rockchip_dfi_init_ddr_info(struct rockchip_dfi *data, u32 val)
+{
+	u32 i;
+
+	data->dram_type = READ_DRAMTYPE_INFO(val);
+	data->burst_len = data->dram_type == LPDDR4 ? 16 : 8;
+
+	for (i = 0; i < MAX_DMC_NUM_CH; i++)
+		data->buswidth[i] = 1 << READ_BW_INFO(val, i);
+}
+
 static __init int px30_dfi_init(struct platform_device *pdev,
 				  struct rockchip_dfi *data,
 				  struct devfreq_event_desc *desc)
@@ -473,7 +969,7 @@ static __init int px30_dfi_init(struct platform_device *pdev,
 	}
 
 	regmap_read(data->regmap_pmugrf, PX30_PMUGRF_OS_REG2, &val);
-	data->dram_type = READ_DRAMTYPE_INFO(val);
+	rockchip_dfi_init_ddr_info(data, val);
 	data->ch_msk = 1;
 	data->clk = NULL;
 
@@ -560,7 +1056,7 @@ static __init int rk3328_dfi_init(struct platform_device *pdev,
 	}
 
 	regmap_read(data->regmap_grf, RK3328_GRF_OS_REG2, &val);
-	data->dram_type = READ_DRAMTYPE_INFO(val);
+	rockchip_dfi_init_ddr_info(data, val);
 	data->ch_msk = 1;
 	data->clk = NULL;
 
@@ -614,7 +1110,7 @@ static __init int rockchip_dfi_init(struct platform_device *pdev,
 		return PTR_ERR(data->regmap_pmu);
 
 	regmap_read(data->regmap_pmu, PMUGRF_OS_REG2, &val);
-	data->dram_type = READ_DRAMTYPE_INFO(val);
+	rockchip_dfi_init_ddr_info(data, val);
 	data->ch_msk = READ_CH_INFO(val);
 
 	desc->ops = &rockchip_dfi_ops;
@@ -643,11 +1139,14 @@ static int rockchip_dfi_probe(struct platform_device *pdev)
 	const struct of_device_id *match;
 	int (*init)(struct platform_device *pdev, struct rockchip_dfi *data,
 		    struct devfreq_event_desc *desc);
+	int ret;
 
 	data = devm_kzalloc(dev, sizeof(struct rockchip_dfi), GFP_KERNEL);
 	if (!data)
 		return -ENOMEM;
 
+	mutex_init(&data->mutex);
+
 	desc = devm_kzalloc(dev, sizeof(*desc), GFP_KERNEL);
 	if (!desc)
 		return -ENOMEM;
@@ -676,6 +1175,13 @@ static int rockchip_dfi_probe(struct platform_device *pdev)
 		return PTR_ERR(data->edev);
 	}
 
+	/* only the DDRMON block has separate read and write counters */
+	if (desc->ops == &rockchip_dfi_ops) {
+		ret = rockchip_ddr_perf_init(data);
+		if (ret)
+			return ret;
+	}
+
 	platform_set_drvdata(pdev, data);
 
 	return 0;
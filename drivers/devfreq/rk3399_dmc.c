@@ -6,25 +6,34 @@
 
 #include <linux/arm-smccc.h>
 #include <linux/bitfield.h>
+#include <linux/bitops.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
 #include <linux/devfreq.h>
 #include <linux/devfreq-event.h>
+#include <linux/interconnect-provider.h>
 #include <linux/interrupt.h>
+#include <linux/ktime.h>
 #include <linux/mfd/syscon.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/pm_opp.h>
+#include <linux/pm_qos.h>
 #include <linux/regmap.h>
 #include <linux/regulator/consumer.h>
 #include <linux/rwsem.h>
 #include <linux/suspend.h>
 
+#include <dt-bindings/interconnect/rockchip,rk3399-dmc.h>
+
 #include <soc/rockchip/pm_domains.h>
 #include <soc/rockchip/rk3399_grf.h>
 #include <soc/rockchip/rockchip_sip.h>
 
+#define CREATE_TRACE_POINTS
+#include "rk3399_dmc_trace.h"
+
 #define NS_TO_CYCLE(NS, MHz)				(((NS) * (MHz)) / NSEC_PER_USEC)
 
 #define RK3399_SET_ODT_PD_0_SR_IDLE			GENMASK(7, 0)
@@ -36,6 +45,28 @@
 
 #define RK3399_SET_ODT_PD_2_ODT_ENABLE			BIT(0)
 
+#define RK3399_PMUGRF_OS_REG2_CH_MASK			GENMASK(29, 28)
+
+/* Each 32-bit channel moves 8 bytes per DDR clock */
+#define RK3399_DMC_BYTES_PER_CYCLE_PER_CH		8
+
+/*
+ * Share of the theoretical DRAM bandwidth which the bandwidth floors voted
+ * through the interconnect framework may use, leaving headroom for refresh,
+ * page misses and unvoted masters.
+ */
+#define RK3399_DMC_ICC_EFFICIENCY			50
+
+/*
+ * Per-OPP settings, computed once at probe so that a transition only has to
+ * look them up.
+ */
+struct rk3399_dmcfreq_opp {
+	unsigned long rate;
+	u32 odt_pd_arg[3];
+	unsigned int min_residency_us;
+};
+
 struct rk3399_dmcfreq {
 	struct device *dev;
 	struct devfreq *devfreq;
@@ -64,46 +95,29 @@ struct rk3399_dmcfreq {
 	unsigned int sr_mc_gate_idle_dis_freq;
 	unsigned int srpd_lite_idle_dis_freq;
 	unsigned int standby_idle_dis_freq;
+
+	struct rk3399_dmcfreq_opp *opps;
+	unsigned int num_opps;
+	/* ODT/PD arguments last handed to TF-A, protected by lock */
+	u32 odt_pd_cur[3];
+	bool odt_pd_valid;
+	ktime_t last_switch;
+
+	/* Bandwidth floors voted by DMA masters through the interconnect */
+	struct icc_provider icc_provider;
+	struct icc_node *icc_nodes[2];
+	struct dev_pm_qos_request icc_qos_req;
+	unsigned int bytes_per_cycle;
 };
 
-static int rk3399_dmcfreq_target(struct device *dev, unsigned long *freq,
-				 u32 flags)
+static void rk3399_dmcfreq_odt_pd_args(struct rk3399_dmcfreq *dmcfreq,
+				      unsigned long rate, u32 *odt_pd_arg)
 {
-	struct rk3399_dmcfreq *dmcfreq = dev_get_drvdata(dev);
-	struct dev_pm_opp *opp;
-	unsigned long old_clk_rate = dmcfreq->rate;
-	unsigned long target_volt, target_rate;
 	unsigned int ddrcon_mhz;
-	struct arm_smccc_res res;
-	int err;
-
 	u32 odt_pd_arg0 = 0;
 	u32 odt_pd_arg1 = 0;
 	u32 odt_pd_arg2 = 0;
 
-	opp = devfreq_recommended_opp(dev, freq, flags);
-	if (IS_ERR(opp))
-		return PTR_ERR(opp);
-
-	target_rate = dev_pm_opp_get_freq(opp);
-	target_volt = dev_pm_opp_get_voltage(opp);
-	dev_pm_opp_put(opp);
-
-	if (dmcfreq->rate == target_rate)
-		return 0;
-
-	mutex_lock(&dmcfreq->lock);
-
-	/*
-	 * Ensure power-domain transitions don't interfere with ARM Trusted
-	 * Firmware power-domain idling.
-	 */
-	err = rockchip_pmu_block();
-	if (err) {
-		dev_err(dev, "Failed to block PMU: %d\n", err);
-		goto out_unlock;
-	}
-
 	/*
 	 * Some idle parameters may be based on the DDR controller clock, which
 	 * is half of the DDR frequency.
@@ -111,7 +125,7 @@ static int rk3399_dmcfreq_target(struct device *dev, unsigned long *freq,
 	 * sr_idle_cycle, sr_mc_gate_idle_cycle, and srpd_lite_idle_cycle
 	 * are based on the 1024 controller clock cycle
 	 */
-	ddrcon_mhz = target_rate / USEC_PER_SEC / 2;
+	ddrcon_mhz = rate / USEC_PER_SEC / 2;
 
 	u32p_replace_bits(&odt_pd_arg1,
 			  NS_TO_CYCLE(dmcfreq->pd_idle_ns, ddrcon_mhz),
@@ -132,33 +146,120 @@ static int rk3399_dmcfreq_target(struct device *dev, unsigned long *freq,
 						   ddrcon_mhz), 1024),
 			  RK3399_SET_ODT_PD_1_SRPD_LITE_IDLE);
 
-	if (dmcfreq->regmap_pmu) {
-		if (target_rate >= dmcfreq->sr_idle_dis_freq)
-			odt_pd_arg0 &= ~RK3399_SET_ODT_PD_0_SR_IDLE;
+	if (rate >= dmcfreq->sr_idle_dis_freq)
+		odt_pd_arg0 &= ~RK3399_SET_ODT_PD_0_SR_IDLE;
+
+	if (rate >= dmcfreq->sr_mc_gate_idle_dis_freq)
+		odt_pd_arg0 &= ~RK3399_SET_ODT_PD_0_SR_MC_GATE_IDLE;
 
-		if (target_rate >= dmcfreq->sr_mc_gate_idle_dis_freq)
-			odt_pd_arg0 &= ~RK3399_SET_ODT_PD_0_SR_MC_GATE_IDLE;
+	if (rate >= dmcfreq->standby_idle_dis_freq)
+		odt_pd_arg0 &= ~RK3399_SET_ODT_PD_0_STANDBY_IDLE;
 
-		if (target_rate >= dmcfreq->standby_idle_dis_freq)
-			odt_pd_arg0 &= ~RK3399_SET_ODT_PD_0_STANDBY_IDLE;
+	if (rate >= dmcfreq->pd_idle_dis_freq)
+		odt_pd_arg1 &= ~RK3399_SET_ODT_PD_1_PD_IDLE;
 
-		if (target_rate >= dmcfreq->pd_idle_dis_freq)
-			odt_pd_arg1 &= ~RK3399_SET_ODT_PD_1_PD_IDLE;
+	if (rate >= dmcfreq->srpd_lite_idle_dis_freq)
+		odt_pd_arg1 &= ~RK3399_SET_ODT_PD_1_SRPD_LITE_IDLE;
+
+	if (rate >= dmcfreq->odt_dis_freq)
+		odt_pd_arg2 |= RK3399_SET_ODT_PD_2_ODT_ENABLE;
+
+	odt_pd_arg[0] = odt_pd_arg0;
+	odt_pd_arg[1] = odt_pd_arg1;
+	odt_pd_arg[2] = odt_pd_arg2;
+}
+
+static const struct rk3399_dmcfreq_opp *
+rk3399_dmcfreq_find_opp(struct rk3399_dmcfreq *dmcfreq, unsigned long rate)
+{
+	unsigned int i;
+
+	for (i = 0; i < dmcfreq->num_opps; i++)
+		if (dmcfreq->opps[i].rate == rate)
+			return &dmcfreq->opps[i];
+
+	return NULL;
+}
+
+static int rk3399_dmcfreq_target(struct device *dev, unsigned long *freq,
+				 u32 flags)
+{
+	struct rk3399_dmcfreq *dmcfreq = dev_get_drvdata(dev);
+	const struct rk3399_dmcfreq_opp *cur_opp, *target_opp;
+	struct dev_pm_opp *opp;
+	unsigned long old_clk_rate = dmcfreq->rate;
+	unsigned long target_volt, target_rate;
+	struct arm_smccc_res res;
+	bool odt_pd_updated = false;
+	u32 odt_pd_arg[3];
+	ktime_t start;
+	int err;
 
-		if (target_rate >= dmcfreq->srpd_lite_idle_dis_freq)
-			odt_pd_arg1 &= ~RK3399_SET_ODT_PD_1_SRPD_LITE_IDLE;
+	opp = devfreq_recommended_opp(dev, freq, flags);
+	if (IS_ERR(opp))
+		return PTR_ERR(opp);
+
+	target_rate = dev_pm_opp_get_freq(opp);
+	target_volt = dev_pm_opp_get_voltage(opp);
+	dev_pm_opp_put(opp);
+
+	if (dmcfreq->rate == target_rate)
+		return 0;
+
+	mutex_lock(&dmcfreq->lock);
+
+	/*
+	 * Don't leave an OPP for a lower one before it has been resident for
+	 * its minimum time: every switch holds off the display and the other
+	 * DRAM masters, so bouncing between OPPs costs more than it saves.
+	 */
+	cur_opp = rk3399_dmcfreq_find_opp(dmcfreq, dmcfreq->rate);
+	if (target_rate < dmcfreq->rate && cur_opp &&
+	    ktime_us_delta(ktime_get(), dmcfreq->last_switch) <
+	    cur_opp->min_residency_us) {
+		*freq = dmcfreq->rate;
+		err = 0;
+		goto out_unlock;
+	}
+
+	start = ktime_get();
+
+	/*
+	 * Ensure power-domain transitions don't interfere with ARM Trusted
+	 * Firmware power-domain idling.
+	 */
+	err = rockchip_pmu_block();
+	if (err) {
+		dev_err(dev, "Failed to block PMU: %d\n", err);
+		goto out_unlock;
+	}
 
-		if (target_rate >= dmcfreq->odt_dis_freq)
-			odt_pd_arg2 |= RK3399_SET_ODT_PD_2_ODT_ENABLE;
+	target_opp = rk3399_dmcfreq_find_opp(dmcfreq, target_rate);
+	if (target_opp)
+		memcpy(odt_pd_arg, target_opp->odt_pd_arg, sizeof(odt_pd_arg));
+	else
+		rk3399_dmcfreq_odt_pd_args(dmcfreq, target_rate, odt_pd_arg);
 
+	/*
+	 * TF-A keeps the ODT/PD settings until they are changed, so only
+	 * make the call when the target OPP needs different ones.
+	 */
+	if (dmcfreq->regmap_pmu &&
+	    (!dmcfreq->odt_pd_valid ||
+	     memcmp(odt_pd_arg, dmcfreq->odt_pd_cur, sizeof(odt_pd_arg)))) {
 		/*
 		 * This makes a SMC call to the TF-A to set the DDR PD
 		 * (power-down) timings and to enable or disable the
 		 * ODT (on-die termination) resistors.
 		 */
-		arm_smccc_smc(ROCKCHIP_SIP_DRAM_FREQ, odt_pd_arg0, odt_pd_arg1,
-			      ROCKCHIP_SIP_CONFIG_DRAM_SET_ODT_PD, odt_pd_arg2,
-			      0, 0, 0, &res);
+		arm_smccc_smc(ROCKCHIP_SIP_DRAM_FREQ, odt_pd_arg[0],
+			      odt_pd_arg[1],
+			      ROCKCHIP_SIP_CONFIG_DRAM_SET_ODT_PD,
+			      odt_pd_arg[2], 0, 0, 0, &res);
+
+		memcpy(dmcfreq->odt_pd_cur, odt_pd_arg, sizeof(odt_pd_arg));
+		dmcfreq->odt_pd_valid = true;
+		odt_pd_updated = true;
 	}
 
 	/*
@@ -207,6 +308,10 @@ static int rk3399_dmcfreq_target(struct device *dev, unsigned long *freq,
 
 	dmcfreq->rate = target_rate;
 	dmcfreq->volt = target_volt;
+	dmcfreq->last_switch = ktime_get();
+
+	trace_rk3399_dmcfreq_switch(old_clk_rate, target_rate, odt_pd_updated,
+				    ktime_us_delta(dmcfreq->last_switch, start));
 
 out:
 	rockchip_pmu_unblock();
@@ -215,6 +320,61 @@ static int rk3399_dmcfreq_target(struct device *dev, unsigned long *freq,
 	return err;
 }
 
+/*
+ * Stage the settings of every OPP. The optional
+ * "rockchip,min-residency-us" property holds either one value used for all
+ * OPPs, or one value per OPP in ascending frequency order.
+ */
+static int rk3399_dmcfreq_stage_opps(struct rk3399_dmcfreq *dmcfreq,
+				     struct device *dev)
+{
+	struct device_node *np = dev->of_node;
+	struct dev_pm_opp *opp;
+	unsigned long rate = 0;
+	int count, num_residency, i;
+	u32 residency = 0;
+
+	count = dev_pm_opp_get_opp_count(dev);
+	if (count <= 0)
+		return count ?: -ENODEV;
+
+	dmcfreq->opps = devm_kcalloc(dev, count, sizeof(*dmcfreq->opps),
+				     GFP_KERNEL);
+	if (!dmcfreq->opps)
+		return -ENOMEM;
+
+	num_residency = of_property_count_u32_elems(np,
+						    "rockchip,min-residency-us");
+	if (num_residency == 1)
+		of_property_read_u32(np, "rockchip,min-residency-us",
+				     &residency);
+	else if (num_residency > 0 && num_residency != count)
+		dev_warn(dev, "ignoring rockchip,min-residency-us: %d entries for %d OPPs\n",
+			 num_residency, count);
+
+	for (i = 0; i < count; i++, rate++) {
+		struct rk3399_dmcfreq_opp *dmc_opp = &dmcfreq->opps[i];
+
+		opp = dev_pm_opp_find_freq_ceil(dev, &rate);
+		if (IS_ERR(opp))
+			return PTR_ERR(opp);
+		dev_pm_opp_put(opp);
+
+		dmc_opp->rate = rate;
+		rk3399_dmcfreq_odt_pd_args(dmcfreq, rate, dmc_opp->odt_pd_arg);
+
+		dmc_opp->min_residency_us = residency;
+		if (num_residency == count)
+			of_property_read_u32_index(np,
+						   "rockchip,min-residency-us",
+						   i, &dmc_opp->min_residency_us);
+	}
+
+	dmcfreq->num_opps = count;
+
+	return 0;
+}
+
 static int rk3399_dmcfreq_get_dev_status(struct device *dev,
 					 struct devfreq_dev_status *stat)
 {
@@ -242,6 +402,125 @@ static int rk3399_dmcfreq_get_cur_freq(struct device *dev, unsigned long *freq)
 	return 0;
 }
 
+static int rk3399_dmcfreq_icc_set(struct icc_node *src, struct icc_node *dst)
+{
+	struct rk3399_dmcfreq *dmcfreq = dst->data;
+	struct icc_node *dram = dmcfreq->icc_nodes[RK3399_DMC_DRAM];
+	u64 bw = max(dram->avg_bw, dram->peak_bw);
+	u64 freq_khz;
+	int ret;
+
+	/* kB/s over bytes per DDR clock is the DDR clock in kHz */
+	freq_khz = div_u64(bw * 100, dmcfreq->bytes_per_cycle *
+			   RK3399_DMC_ICC_EFFICIENCY);
+
+	ret = dev_pm_qos_update_request(&dmcfreq->icc_qos_req,
+					min_t(u64, freq_khz, S32_MAX));
+	if (ret < 0) {
+		dev_err(dmcfreq->dev, "failed to update bandwidth floor: %d\n",
+			ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+static int rk3399_dmcfreq_icc_get_bw(struct icc_node *node, u32 *avg,
+				     u32 *peak)
+{
+	/* Nothing is voted until the first consumer asks for bandwidth */
+	*avg = 0;
+	*peak = 0;
+
+	return 0;
+}
+
+static struct icc_node *rk3399_dmcfreq_icc_xlate(struct of_phandle_args *spec,
+						 void *data)
+{
+	struct rk3399_dmcfreq *dmcfreq = data;
+	unsigned int idx = spec->args[0];
+
+	if (spec->args_count != 1 || idx >= ARRAY_SIZE(dmcfreq->icc_nodes))
+		return ERR_PTR(-EINVAL);
+
+	return dmcfreq->icc_nodes[idx];
+}
+
+/*
+ * Masters with hard bandwidth requirements (VOP scanout, ISP capture) vote
+ * for it on the RK3399_DMC_MASTER -> RK3399_DMC_DRAM path, which is turned
+ * into a minimum frequency request on the devfreq device. The DMC is then
+ * raised as soon as the vote changes, rather than one ondemand polling
+ * period after the underflow has started.
+ */
+static int rk3399_dmcfreq_icc_init(struct rk3399_dmcfreq *dmcfreq)
+{
+	static const char * const names[] = {
+		[RK3399_DMC_MASTER] = "dmc-master",
+		[RK3399_DMC_DRAM] = "dmc-dram",
+	};
+	struct icc_provider *provider = &dmcfreq->icc_provider;
+	struct device *dev = dmcfreq->dev;
+	int ret, i;
+
+	if (!of_find_property(dev->of_node, "#interconnect-cells", NULL))
+		return 0;
+
+	ret = dev_pm_qos_add_request(dev, &dmcfreq->icc_qos_req,
+				     DEV_PM_QOS_MIN_FREQUENCY, 0);
+	if (ret < 0)
+		return ret;
+
+	provider->set = rk3399_dmcfreq_icc_set;
+	provider->aggregate = icc_std_aggregate;
+	provider->get_bw = rk3399_dmcfreq_icc_get_bw;
+	provider->xlate = rk3399_dmcfreq_icc_xlate;
+	provider->dev = dev;
+	provider->data = dmcfreq;
+	icc_provider_init(provider);
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		struct icc_node *node = icc_node_create(i);
+
+		if (IS_ERR(node)) {
+			ret = PTR_ERR(node);
+			goto err_nodes;
+		}
+
+		node->name = names[i];
+		node->data = dmcfreq;
+		icc_node_add(node, provider);
+		dmcfreq->icc_nodes[i] = node;
+	}
+
+	ret = icc_link_create(dmcfreq->icc_nodes[RK3399_DMC_MASTER],
+			      RK3399_DMC_DRAM);
+	if (ret)
+		goto err_nodes;
+
+	ret = icc_provider_register(provider);
+	if (ret)
+		goto err_nodes;
+
+	return 0;
+
+err_nodes:
+	icc_nodes_remove(provider);
+	dev_pm_qos_remove_request(&dmcfreq->icc_qos_req);
+	return ret;
+}
+
+static void rk3399_dmcfreq_icc_exit(struct rk3399_dmcfreq *dmcfreq)
+{
+	if (!dev_pm_qos_request_active(&dmcfreq->icc_qos_req))
+		return;
+
+	icc_provider_deregister(&dmcfreq->icc_provider);
+	icc_nodes_remove(&dmcfreq->icc_provider);
+	dev_pm_qos_remove_request(&dmcfreq->icc_qos_req);
+}
+
 static __maybe_unused int rk3399_dmcfreq_suspend(struct device *dev)
 {
 	struct rk3399_dmcfreq *dmcfreq = dev_get_drvdata(dev);
@@ -273,6 +552,11 @@ static __maybe_unused int rk3399_dmcfreq_resume(struct device *dev)
 		return ret;
 	}
 
+	/* TF-A may not have kept the ODT/PD settings across system sleep */
+	mutex_lock(&dmcfreq->lock);
+	dmcfreq->odt_pd_valid = false;
+	mutex_unlock(&dmcfreq->lock);
+
 	ret = devfreq_resume_device(dmcfreq->devfreq);
 	if (ret < 0) {
 		dev_err(dev, "failed to resume the devfreq devices\n");
@@ -340,6 +624,7 @@ static int rk3399_dmcfreq_probe(struct platform_device *pdev)
 	struct dev_pm_opp *opp;
 	u32 ddr_type;
 	u32 val;
+	u32 channels = 2;
 
 	data = devm_kzalloc(dev, sizeof(struct rk3399_dmcfreq), GFP_KERNEL);
 	if (!data)
@@ -383,6 +668,7 @@ static int rk3399_dmcfreq_probe(struct platform_device *pdev)
 	regmap_read(data->regmap_pmu, RK3399_PMUGRF_OS_REG2, &val);
 	ddr_type = (val >> RK3399_PMUGRF_DDRTYPE_SHIFT) &
 		    RK3399_PMUGRF_DDRTYPE_MASK;
+	channels = hweight32(FIELD_GET(RK3399_PMUGRF_OS_REG2_CH_MASK, val)) ?: 1;
 
 	switch (ddr_type) {
 	case RK3399_PMUGRF_DDRTYPE_DDR3:
@@ -414,6 +700,12 @@ static int rk3399_dmcfreq_probe(struct platform_device *pdev)
 		goto err_edev;
 	}
 
+	ret = rk3399_dmcfreq_stage_opps(data, dev);
+	if (ret) {
+		dev_err(dev, "Failed to stage OPP settings: %d\n", ret);
+		goto err_edev;
+	}
+
 	data->ondemand_data.upthreshold = 25;
 	data->ondemand_data.downdifferential = 15;
 
@@ -428,6 +720,7 @@ static int rk3399_dmcfreq_probe(struct platform_device *pdev)
 	data->rate = dev_pm_opp_get_freq(opp);
 	data->volt = dev_pm_opp_get_voltage(opp);
 	dev_pm_opp_put(opp);
+	data->last_switch = ktime_get();
 
 	data->profile = (struct devfreq_dev_profile) {
 		.polling_ms	= 200,
@@ -449,6 +742,15 @@ static int rk3399_dmcfreq_probe(struct platform_device *pdev)
 	devm_devfreq_register_opp_notifier(dev, data->devfreq);
 
 	data->dev = dev;
+	data->bytes_per_cycle = channels * RK3399_DMC_BYTES_PER_CYCLE_PER_CH;
+
+	ret = rk3399_dmcfreq_icc_init(data);
+	if (ret) {
+		dev_err(dev, "failed to register interconnect provider: %d\n",
+			ret);
+		goto err_edev;
+	}
+
 	platform_set_drvdata(pdev, data);
 
 	return 0;
@@ -463,6 +765,7 @@ static int rk3399_dmcfreq_remove(struct platform_device *pdev)
 {
 	struct rk3399_dmcfreq *dmcfreq = dev_get_drvdata(&pdev->dev);
 
+	rk3399_dmcfreq_icc_exit(dmcfreq);
 	devfreq_event_disable_edev(dmcfreq->edev);
 
 	return 0;
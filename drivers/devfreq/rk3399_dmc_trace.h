@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM rk3399_dmc
+
+#if !defined(_RK3399_DMC_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _RK3399_DMC_TRACE_H
+
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(rk3399_dmcfreq_switch,
+	TP_PROTO(unsigned long old_rate, unsigned long new_rate,
+		 bool odt_pd_updated, s64 latency_us),
+
+	TP_ARGS(old_rate, new_rate, odt_pd_updated, latency_us),
+
+	TP_STRUCT__entry(
+		__field(unsigned long, old_rate)
+		__field(unsigned long, new_rate)
+		__field(bool, odt_pd_updated)
+		__field(s64, latency_us)
+	),
+
+	TP_fast_assign(
+		__entry->old_rate = old_rate;
+		__entry->new_rate = new_rate;
+		__entry->odt_pd_updated = odt_pd_updated;
+		__entry->latency_us = latency_us;
+	),
+
+	TP_printk("old_rate=%lu new_rate=%lu odt_pd_updated=%d latency_us=%lld",
+		  __entry->old_rate, __entry->new_rate,
+		  __entry->odt_pd_updated, __entry->latency_us)
+);
+
+#endif /* _RK3399_DMC_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE rk3399_dmc_trace
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -437,11 +437,35 @@ static long dma_buf_import_sync_file(struct dma_buf *dmabuf,
 }
 #endif
 
+static int dma_buf_sync_direction(u64 flags,
+				  enum dma_data_direction *direction)
+{
+	if (flags & ~DMA_BUF_SYNC_VALID_FLAGS_MASK)
+		return -EINVAL;
+
+	switch (flags & DMA_BUF_SYNC_RW) {
+	case DMA_BUF_SYNC_READ:
+		*direction = DMA_FROM_DEVICE;
+		break;
+	case DMA_BUF_SYNC_WRITE:
+		*direction = DMA_TO_DEVICE;
+		break;
+	case DMA_BUF_SYNC_RW:
+		*direction = DMA_BIDIRECTIONAL;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static long dma_buf_ioctl(struct file *file,
 			  unsigned int cmd, unsigned long arg)
 {
 	struct dma_buf *dmabuf;
 	struct dma_buf_sync sync;
+	struct dma_buf_sync_partial sync_p;
 	enum dma_data_direction direction;
 	int ret;
 
@@ -452,22 +476,9 @@ static long dma_buf_ioctl(struct file *file,
 		if (copy_from_user(&sync, (void __user *) arg, sizeof(sync)))
 			return -EFAULT;
 
-		if (sync.flags & ~DMA_BUF_SYNC_VALID_FLAGS_MASK)
-			return -EINVAL;
-
-		switch (sync.flags & DMA_BUF_SYNC_RW) {
-		case DMA_BUF_SYNC_READ:
-			direction = DMA_FROM_DEVICE;
-			break;
-		case DMA_BUF_SYNC_WRITE:
-			direction = DMA_TO_DEVICE;
-			break;
-		case DMA_BUF_SYNC_RW:
-			direction = DMA_BIDIRECTIONAL;
-			break;
-		default:
-			return -EINVAL;
-		}
+		ret = dma_buf_sync_direction(sync.flags, &direction);
+		if (ret)
+			return ret;
 
 		if (sync.flags & DMA_BUF_SYNC_END)
 			ret = dma_buf_end_cpu_access(dmabuf, direction);
@@ -476,6 +487,30 @@ static long dma_buf_ioctl(struct file *file,
 
 		return ret;
 
+	case DMA_BUF_IOCTL_SYNC_PARTIAL:
+		if (copy_from_user(&sync_p, (void __user *) arg, sizeof(sync_p)))
+			return -EFAULT;
+
+		ret = dma_buf_sync_direction(sync_p.flags, &direction);
+		if (ret)
+			return ret;
+
+		if (!sync_p.len || sync_p.offset >= dmabuf->size ||
+		    sync_p.len > dmabuf->size - sync_p.offset ||
+		    sync_p.offset + sync_p.len > UINT_MAX)
+			return -EINVAL;
+
+		if (sync_p.flags & DMA_BUF_SYNC_END)
+			ret = dma_buf_end_cpu_access_partial(dmabuf, direction,
+							     sync_p.offset,
+							     sync_p.len);
+		else
+			ret = dma_buf_begin_cpu_access_partial(dmabuf, direction,
+							       sync_p.offset,
+							       sync_p.len);
+
+		return ret;
+
 	case DMA_BUF_SET_NAME_A:
 	case DMA_BUF_SET_NAME_B:
 		return dma_buf_set_name(dmabuf, (const char __user *)arg);
@@ -1387,6 +1422,72 @@ int dma_buf_end_cpu_access(struct dma_buf *dmabuf,
 }
 EXPORT_SYMBOL_NS_GPL(dma_buf_end_cpu_access, DMA_BUF);
 
+/**
+ * dma_buf_begin_cpu_access_partial - Must be called before accessing part of
+ * a dma_buf from the cpu in the kernel context.
+ * @dmabuf:	[in]	buffer to prepare cpu access for.
+ * @direction:	[in]	direction of cpu access.
+ * @offset:	[in]	offset of the range for cpu access, in bytes.
+ * @len:	[in]	length of the range for cpu access, in bytes.
+ *
+ * Like dma_buf_begin_cpu_access(), but coherency is only guaranteed for the
+ * given range. Exporters that can't sync a range get the whole buffer synced.
+ * The access must be completed with dma_buf_end_cpu_access_partial() for the
+ * same range.
+ *
+ * Can return negative error values, returns 0 on success.
+ */
+int dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
+				     enum dma_data_direction direction,
+				     unsigned int offset, unsigned int len)
+{
+	int ret;
+
+	if (WARN_ON(!dmabuf))
+		return -EINVAL;
+
+	if (!dmabuf->ops->begin_cpu_access_partial)
+		return dma_buf_begin_cpu_access(dmabuf, direction);
+
+	might_lock(&dmabuf->resv->lock.base);
+
+	ret = dmabuf->ops->begin_cpu_access_partial(dmabuf, direction,
+						    offset, len);
+	if (ret == 0)
+		ret = __dma_buf_begin_cpu_access(dmabuf, direction);
+
+	return ret;
+}
+EXPORT_SYMBOL_NS_GPL(dma_buf_begin_cpu_access_partial, DMA_BUF);
+
+/**
+ * dma_buf_end_cpu_access_partial - Must be called after accessing part of a
+ * dma_buf from the cpu in the kernel context.
+ * @dmabuf:	[in]	buffer to complete cpu access for.
+ * @direction:	[in]	direction of cpu access.
+ * @offset:	[in]	offset of the range for cpu access, in bytes.
+ * @len:	[in]	length of the range for cpu access, in bytes.
+ *
+ * This terminates CPU access started with dma_buf_begin_cpu_access_partial().
+ *
+ * Can return negative error values, returns 0 on success.
+ */
+int dma_buf_end_cpu_access_partial(struct dma_buf *dmabuf,
+				   enum dma_data_direction direction,
+				   unsigned int offset, unsigned int len)
+{
+	WARN_ON(!dmabuf);
+
+	if (!dmabuf->ops->end_cpu_access_partial)
+		return dma_buf_end_cpu_access(dmabuf, direction);
+
+	might_lock(&dmabuf->resv->lock.base);
+
+	return dmabuf->ops->end_cpu_access_partial(dmabuf, direction,
+						   offset, len);
+}
+EXPORT_SYMBOL_NS_GPL(dma_buf_end_cpu_access_partial, DMA_BUF);
+
 
 /**
  * dma_buf_mmap - Setup up a userspace mmap with the given vma
@@ -126,9 +126,20 @@ static void dma_fence_chain_irq_work(struct irq_work *work)
 	chain = container_of(work, typeof(*chain), work);
 
 	/* Try to rearm the callback */
-	if (!dma_fence_chain_enable_signaling(&chain->base))
+	if (!dma_fence_chain_enable_signaling(&chain->base)) {
+		struct dma_fence *prev;
+
 		/* Ok, we are done. No more unsignaled fences left */
 		dma_fence_signal(&chain->base);
+
+		/*
+		 * Everything before this node is signaled as well, so drop it
+		 * right away instead of leaving it to the next walk. Long
+		 * timelines then never keep more than their unsignaled tail.
+		 */
+		prev = unrcu_pointer(xchg(&chain->prev, NULL));
+		dma_fence_put(prev);
+	}
 	dma_fence_put(&chain->base);
 }
 
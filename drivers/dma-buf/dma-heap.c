@@ -29,6 +29,7 @@
  * @name:		used for debugging/device-node name
  * @ops:		ops struct for this heap
  * @heap_devt		heap device node
+ * @heap_dev		heap device
  * @list		list head connecting to list of heaps
  * @heap_cdev		heap char device
  *
@@ -39,6 +40,7 @@ struct dma_heap {
 	const struct dma_heap_ops *ops;
 	void *priv;
 	dev_t heap_devt;
+	struct device *heap_dev;
 	struct list_head list;
 	struct cdev heap_cdev;
 };
@@ -216,6 +218,18 @@ const char *dma_heap_get_name(struct dma_heap *heap)
 	return heap->name;
 }
 
+/**
+ * dma_heap_get_dev() - get device struct for the heap
+ * @heap: DMA-Heap to retrieve device struct from
+ *
+ * Returns:
+ * The device struct for the heap.
+ */
+struct device *dma_heap_get_dev(struct dma_heap *heap)
+{
+	return heap->heap_dev;
+}
+
 struct dma_heap *dma_heap_add(const struct dma_heap_export_info *exp_info)
 {
 	struct dma_heap *heap, *h, *err_ret;
@@ -271,6 +285,7 @@ struct dma_heap *dma_heap_add(const struct dma_heap_export_info *exp_info)
 		err_ret = ERR_CAST(dev_ret);
 		goto err2;
 	}
+	heap->heap_dev = dev_ret;
 
 	mutex_lock(&heap_list_lock);
 	/* check the name is unique */
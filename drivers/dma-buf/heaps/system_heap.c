@@ -0,0 +1,831 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DMABUF System heap exporter
+ *
+ * Copyright (C) 2011 Google, Inc.
+ * Copyright (C) 2019, 2020 Linaro Ltd.
+ *
+ * Portions based off of Andrew Davis' SRAM heap:
+ * Copyright (C) 2019 Texas Instruments Incorporated - http://www.ti.com/
+ *	Andrew F. Davis <afd@ti.com>
+ *
+ * With CONFIG_DMABUF_HEAPS_SYSTEM_POOL, freed pages are kept in per-order
+ * pools instead of going back to the page allocator. They are zeroed (and
+ * for the uncached heap cleaned from the CPU caches) by a background work
+ * item, so that an allocation served from the pools needs neither clearing
+ * nor cache maintenance, which matters for camera and video decoder buffers
+ * allocated in bursts at stream start. A "system-uncached" heap, mapped
+ * write-combined by the CPU and never synced, is exported as well.
+ */
+
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
+#include <linux/dma-mapping.h>
+#include <linux/err.h>
+#include <linux/highmem.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/scatterlist.h>
+#include <linux/shrinker.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+
+#ifdef CONFIG_DMABUF_HEAPS_SYSTEM_POOL
+static unsigned int system_heap_max_pool_pages = SZ_64M >> PAGE_SHIFT;
+module_param_named(max_pool_pages, system_heap_max_pool_pages, uint, 0644);
+MODULE_PARM_DESC(max_pool_pages,
+		 "Maximum number of pages kept in the pools of each heap");
+#else
+#define system_heap_max_pool_pages	0U
+#endif
+
+#define LOW_ORDER_GFP (GFP_HIGHUSER | __GFP_ZERO | __GFP_COMP)
+#define MID_ORDER_GFP (LOW_ORDER_GFP | __GFP_NOWARN)
+#define HIGH_ORDER_GFP  (((GFP_HIGHUSER | __GFP_ZERO | __GFP_NOWARN \
+				| __GFP_NORETRY) & ~__GFP_RECLAIM) \
+				| __GFP_COMP)
+static gfp_t order_flags[] = {HIGH_ORDER_GFP, MID_ORDER_GFP, LOW_ORDER_GFP};
+/*
+ * The selection of the orders used for allocation (1MB, 64K, 4K) is designed
+ * to match with the sizes often found in IOMMUs. Using order 4 pages instead
+ * of order 0 pages can significantly improve the performance of many IOMMUs
+ * by reducing TLB pressure and time spent updating page tables.
+ */
+static const unsigned int orders[] = {8, 4, 0};
+#define NUM_ORDERS ARRAY_SIZE(orders)
+
+/**
+ * struct system_heap_pool - pages of one order kept for reuse
+ * @lock:	protects the lists and counters
+ * @clean:	zeroed pages, ready to be handed out
+ * @dirty:	returned pages waiting to be zeroed
+ * @nr_clean:	number of pages on @clean
+ * @nr_dirty:	number of pages on @dirty
+ * @order:	order of the pages in this pool
+ */
+struct system_heap_pool {
+	spinlock_t lock;
+	struct list_head clean;
+	struct list_head dirty;
+	unsigned int nr_clean;
+	unsigned int nr_dirty;
+	unsigned int order;
+};
+
+/**
+ * struct system_heap - one exported heap, "system" or "system-uncached"
+ * @heap:	the dma-heap
+ * @uncached:	buffers are mapped write-combined and never synced
+ * @pools:	one pool per allocation order
+ * @nr_pages:	pages held by all pools, in PAGE_SIZE units
+ * @zero_work:	zeroes the pages returned to the pools
+ */
+struct system_heap {
+	struct dma_heap *heap;
+	bool uncached;
+	struct system_heap_pool pools[NUM_ORDERS];
+	atomic_long_t nr_pages;
+	struct work_struct zero_work;
+};
+
+static struct system_heap sys_heaps[2];
+
+struct system_heap_buffer {
+	struct system_heap *sheap;
+	struct list_head attachments;
+	struct mutex lock;
+	unsigned long len;
+	struct sg_table sg_table;
+	int vmap_cnt;
+	void *vaddr;
+};
+
+struct dma_heap_attachment {
+	struct device *dev;
+	struct sg_table *table;
+	struct list_head list;
+	bool mapped;
+};
+
+/*
+ * Write the zeroes back so that the CPU cannot evict dirty lines over data
+ * written through a write-combined mapping or by a device.
+ */
+static void system_heap_flush_page(struct system_heap *sheap, struct page *page)
+{
+	struct device *dev = dma_heap_get_dev(sheap->heap);
+	dma_addr_t addr;
+
+	if (!sheap->uncached)
+		return;
+
+	addr = dma_map_page(dev, page, 0, page_size(page), DMA_BIDIRECTIONAL);
+	if (!dma_mapping_error(dev, addr))
+		dma_unmap_page_attrs(dev, addr, page_size(page),
+				     DMA_BIDIRECTIONAL, DMA_ATTR_SKIP_CPU_SYNC);
+}
+
+static struct page *system_heap_pool_get(struct system_heap *sheap,
+					 struct system_heap_pool *pool)
+{
+	struct page *page;
+
+	if (!IS_ENABLED(CONFIG_DMABUF_HEAPS_SYSTEM_POOL))
+		return NULL;
+
+	spin_lock(&pool->lock);
+	page = list_first_entry_or_null(&pool->clean, struct page, lru);
+	if (page) {
+		list_del(&page->lru);
+		pool->nr_clean--;
+	}
+	spin_unlock(&pool->lock);
+
+	if (page)
+		atomic_long_sub(1 << pool->order, &sheap->nr_pages);
+
+	return page;
+}
+
+static void system_heap_pool_put(struct system_heap *sheap, struct page *page)
+{
+	unsigned int order = compound_order(page);
+	struct system_heap_pool *pool = NULL;
+	int i;
+
+	for (i = 0; i < NUM_ORDERS; i++) {
+		if (sheap->pools[i].order == order) {
+			pool = &sheap->pools[i];
+			break;
+		}
+	}
+
+	if (!pool || atomic_long_read(&sheap->nr_pages) + (1 << order) >
+	    system_heap_max_pool_pages) {
+		__free_pages(page, order);
+		return;
+	}
+
+	atomic_long_add(1 << order, &sheap->nr_pages);
+
+	spin_lock(&pool->lock);
+	list_add_tail(&page->lru, &pool->dirty);
+	pool->nr_dirty++;
+	spin_unlock(&pool->lock);
+}
+
+static void system_heap_zero_workfn(struct work_struct *work)
+{
+	struct system_heap *sheap = container_of(work, struct system_heap,
+						 zero_work);
+	int i;
+
+	for (i = 0; i < NUM_ORDERS; i++) {
+		struct system_heap_pool *pool = &sheap->pools[i];
+		struct page *page;
+		unsigned int j;
+
+		for (;;) {
+			spin_lock(&pool->lock);
+			page = list_first_entry_or_null(&pool->dirty,
+							struct page, lru);
+			if (page) {
+				list_del(&page->lru);
+				pool->nr_dirty--;
+			}
+			spin_unlock(&pool->lock);
+
+			if (!page)
+				break;
+
+			for (j = 0; j < (1 << pool->order); j++) {
+				clear_highpage(page + j);
+				cond_resched();
+			}
+			system_heap_flush_page(sheap, page);
+
+			spin_lock(&pool->lock);
+			list_add(&page->lru, &pool->clean);
+			pool->nr_clean++;
+			spin_unlock(&pool->lock);
+		}
+	}
+}
+
+static struct sg_table *dup_sg_table(struct sg_table *table)
+{
+	struct sg_table *new_table;
+	int ret, i;
+	struct scatterlist *sg, *new_sg;
+
+	new_table = kzalloc(sizeof(*new_table), GFP_KERNEL);
+	if (!new_table)
+		return ERR_PTR(-ENOMEM);
+
+	ret = sg_alloc_table(new_table, table->orig_nents, GFP_KERNEL);
+	if (ret) {
+		kfree(new_table);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	new_sg = new_table->sgl;
+	for_each_sgtable_sg(table, sg, i) {
+		sg_set_page(new_sg, sg_page(sg), sg->length, sg->offset);
+		new_sg = sg_next(new_sg);
+	}
+
+	return new_table;
+}
+
+static int system_heap_attach(struct dma_buf *dmabuf,
+			      struct dma_buf_attachment *attachment)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+	struct sg_table *table;
+
+	a = kzalloc(sizeof(*a), GFP_KERNEL);
+	if (!a)
+		return -ENOMEM;
+
+	table = dup_sg_table(&buffer->sg_table);
+	if (IS_ERR(table)) {
+		kfree(a);
+		return -ENOMEM;
+	}
+
+	a->table = table;
+	a->dev = attachment->dev;
+	INIT_LIST_HEAD(&a->list);
+	a->mapped = false;
+
+	attachment->priv = a;
+
+	mutex_lock(&buffer->lock);
+	list_add(&a->list, &buffer->attachments);
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+static void system_heap_detach(struct dma_buf *dmabuf,
+			       struct dma_buf_attachment *attachment)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a = attachment->priv;
+
+	mutex_lock(&buffer->lock);
+	list_del(&a->list);
+	mutex_unlock(&buffer->lock);
+
+	sg_free_table(a->table);
+	kfree(a->table);
+	kfree(a);
+}
+
+static struct sg_table *system_heap_map_dma_buf(struct dma_buf_attachment *attachment,
+						enum dma_data_direction direction)
+{
+	struct system_heap_buffer *buffer = attachment->dmabuf->priv;
+	struct dma_heap_attachment *a = attachment->priv;
+	struct sg_table *table = a->table;
+	unsigned long attrs = 0;
+	int ret;
+
+	if (buffer->sheap->uncached)
+		attrs = DMA_ATTR_SKIP_CPU_SYNC;
+
+	ret = dma_map_sgtable(attachment->dev, table, direction, attrs);
+	if (ret)
+		return ERR_PTR(ret);
+
+	a->mapped = true;
+	return table;
+}
+
+static void system_heap_unmap_dma_buf(struct dma_buf_attachment *attachment,
+				      struct sg_table *table,
+				      enum dma_data_direction direction)
+{
+	struct system_heap_buffer *buffer = attachment->dmabuf->priv;
+	struct dma_heap_attachment *a = attachment->priv;
+	unsigned long attrs = 0;
+
+	if (buffer->sheap->uncached)
+		attrs = DMA_ATTR_SKIP_CPU_SYNC;
+
+	a->mapped = false;
+	dma_unmap_sgtable(attachment->dev, table, direction, attrs);
+}
+
+static int system_heap_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
+						enum dma_data_direction direction)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+
+	if (buffer->sheap->uncached)
+		return 0;
+
+	mutex_lock(&buffer->lock);
+
+	if (buffer->vmap_cnt)
+		invalidate_kernel_vmap_range(buffer->vaddr, buffer->len);
+
+	list_for_each_entry(a, &buffer->attachments, list) {
+		if (!a->mapped)
+			continue;
+		dma_sync_sgtable_for_cpu(a->dev, a->table, direction);
+	}
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+static int system_heap_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
+					      enum dma_data_direction direction)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+
+	if (buffer->sheap->uncached)
+		return 0;
+
+	mutex_lock(&buffer->lock);
+
+	if (buffer->vmap_cnt)
+		flush_kernel_vmap_range(buffer->vaddr, buffer->len);
+
+	list_for_each_entry(a, &buffer->attachments, list) {
+		if (!a->mapped)
+			continue;
+		dma_sync_sgtable_for_device(a->dev, a->table, direction);
+	}
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+/*
+ * The DMA segments of a mapped table may be merged by an IOMMU and need not
+ * line up with buffer offsets, so find the range in the CPU entries instead
+ * and sync each entry it touches as a whole.
+ */
+static void system_heap_sync_range(struct device *dev, struct sg_table *table,
+				   unsigned int offset, unsigned int len,
+				   enum dma_data_direction direction, bool for_cpu)
+{
+	struct scatterlist *sg;
+	int i;
+
+	for_each_sgtable_sg(table, sg, i) {
+		unsigned int size;
+
+		if (offset >= sg->length) {
+			offset -= sg->length;
+			continue;
+		}
+
+		if (for_cpu)
+			dma_sync_sg_for_cpu(dev, sg, 1, direction);
+		else
+			dma_sync_sg_for_device(dev, sg, 1, direction);
+
+		size = min(len, sg->length - offset);
+		len -= size;
+		if (!len)
+			break;
+		offset = 0;
+	}
+}
+
+static int
+system_heap_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
+					     enum dma_data_direction direction,
+					     unsigned int offset,
+					     unsigned int len)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+
+	if (buffer->sheap->uncached)
+		return 0;
+
+	mutex_lock(&buffer->lock);
+
+	if (buffer->vmap_cnt)
+		invalidate_kernel_vmap_range(buffer->vaddr + offset, len);
+
+	list_for_each_entry(a, &buffer->attachments, list) {
+		if (!a->mapped)
+			continue;
+		system_heap_sync_range(a->dev, a->table, offset, len, direction,
+				       true);
+	}
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+static int
+system_heap_dma_buf_end_cpu_access_partial(struct dma_buf *dmabuf,
+					   enum dma_data_direction direction,
+					   unsigned int offset,
+					   unsigned int len)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+
+	if (buffer->sheap->uncached)
+		return 0;
+
+	mutex_lock(&buffer->lock);
+
+	if (buffer->vmap_cnt)
+		flush_kernel_vmap_range(buffer->vaddr + offset, len);
+
+	list_for_each_entry(a, &buffer->attachments, list) {
+		if (!a->mapped)
+			continue;
+		system_heap_sync_range(a->dev, a->table, offset, len, direction,
+				       false);
+	}
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+static int system_heap_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct sg_table *table = &buffer->sg_table;
+	unsigned long addr = vma->vm_start;
+	struct sg_page_iter piter;
+	int ret;
+
+	if (buffer->sheap->uncached)
+		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+
+	for_each_sgtable_page(table, &piter, vma->vm_pgoff) {
+		struct page *page = sg_page_iter_page(&piter);
+
+		ret = remap_pfn_range(vma, addr, page_to_pfn(page), PAGE_SIZE,
+				      vma->vm_page_prot);
+		if (ret)
+			return ret;
+		addr += PAGE_SIZE;
+		if (addr >= vma->vm_end)
+			return 0;
+	}
+	return 0;
+}
+
+static void *system_heap_do_vmap(struct system_heap_buffer *buffer)
+{
+	struct sg_table *table = &buffer->sg_table;
+	int npages = PAGE_ALIGN(buffer->len) / PAGE_SIZE;
+	struct page **pages = vmalloc(sizeof(struct page *) * npages);
+	struct page **tmp = pages;
+	struct sg_page_iter piter;
+	pgprot_t pgprot = PAGE_KERNEL;
+	void *vaddr;
+
+	if (!pages)
+		return ERR_PTR(-ENOMEM);
+
+	if (buffer->sheap->uncached)
+		pgprot = pgprot_writecombine(PAGE_KERNEL);
+
+	for_each_sgtable_page(table, &piter, 0) {
+		WARN_ON(tmp - pages >= npages);
+		*tmp++ = sg_page_iter_page(&piter);
+	}
+
+	vaddr = vmap(pages, npages, VM_MAP, pgprot);
+	vfree(pages);
+
+	if (!vaddr)
+		return ERR_PTR(-ENOMEM);
+
+	return vaddr;
+}
+
+static int system_heap_vmap(struct dma_buf *dmabuf, struct iosys_map *map)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	void *vaddr;
+	int ret = 0;
+
+	mutex_lock(&buffer->lock);
+	if (buffer->vmap_cnt) {
+		buffer->vmap_cnt++;
+		iosys_map_set_vaddr(map, buffer->vaddr);
+		goto out;
+	}
+
+	vaddr = system_heap_do_vmap(buffer);
+	if (IS_ERR(vaddr)) {
+		ret = PTR_ERR(vaddr);
+		goto out;
+	}
+
+	buffer->vaddr = vaddr;
+	buffer->vmap_cnt++;
+	iosys_map_set_vaddr(map, buffer->vaddr);
+out:
+	mutex_unlock(&buffer->lock);
+
+	return ret;
+}
+
+static void system_heap_vunmap(struct dma_buf *dmabuf, struct iosys_map *map)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+
+	mutex_lock(&buffer->lock);
+	if (!--buffer->vmap_cnt) {
+		vunmap(buffer->vaddr);
+		buffer->vaddr = NULL;
+	}
+	mutex_unlock(&buffer->lock);
+	iosys_map_clear(map);
+}
+
+static void system_heap_dma_buf_release(struct dma_buf *dmabuf)
+{
+	struct system_heap_buffer *buffer = dmabuf->priv;
+	struct system_heap *sheap = buffer->sheap;
+	struct sg_table *table;
+	struct scatterlist *sg;
+	int i;
+
+	table = &buffer->sg_table;
+	for_each_sgtable_sg(table, sg, i)
+		system_heap_pool_put(sheap, sg_page(sg));
+	sg_free_table(table);
+	kfree(buffer);
+
+	if (IS_ENABLED(CONFIG_DMABUF_HEAPS_SYSTEM_POOL))
+		queue_work(system_unbound_wq, &sheap->zero_work);
+}
+
+static const struct dma_buf_ops system_heap_buf_ops = {
+	.attach = system_heap_attach,
+	.detach = system_heap_detach,
+	.map_dma_buf = system_heap_map_dma_buf,
+	.unmap_dma_buf = system_heap_unmap_dma_buf,
+	.begin_cpu_access = system_heap_dma_buf_begin_cpu_access,
+	.end_cpu_access = system_heap_dma_buf_end_cpu_access,
+	.begin_cpu_access_partial = system_heap_dma_buf_begin_cpu_access_partial,
+	.end_cpu_access_partial = system_heap_dma_buf_end_cpu_access_partial,
+	.mmap = system_heap_mmap,
+	.vmap = system_heap_vmap,
+	.vunmap = system_heap_vunmap,
+	.release = system_heap_dma_buf_release,
+};
+
+static struct page *alloc_largest_available(struct system_heap *sheap,
+					    unsigned long size,
+					    unsigned int max_order)
+{
+	struct page *page;
+	int i;
+
+	for (i = 0; i < NUM_ORDERS; i++) {
+		if (size <  (PAGE_SIZE << orders[i]))
+			continue;
+		if (max_order < orders[i])
+			continue;
+
+		page = system_heap_pool_get(sheap, &sheap->pools[i]);
+		if (page)
+			return page;
+
+		page = alloc_pages(order_flags[i], orders[i]);
+		if (!page)
+			continue;
+
+		system_heap_flush_page(sheap, page);
+		return page;
+	}
+	return NULL;
+}
+
+static struct dma_buf *system_heap_allocate(struct dma_heap *heap,
+					    unsigned long len,
+					    unsigned long fd_flags,
+					    unsigned long heap_flags)
+{
+	struct system_heap *sheap = dma_heap_get_drvdata(heap);
+	struct system_heap_buffer *buffer;
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	unsigned long size_remaining = len;
+	unsigned int max_order = orders[0];
+	struct dma_buf *dmabuf;
+	struct sg_table *table;
+	struct scatterlist *sg;
+	struct list_head pages;
+	struct page *page, *tmp_page;
+	int i, ret = -ENOMEM;
+
+	buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
+	if (!buffer)
+		return ERR_PTR(-ENOMEM);
+
+	INIT_LIST_HEAD(&buffer->attachments);
+	mutex_init(&buffer->lock);
+	buffer->sheap = sheap;
+	buffer->len = len;
+
+	INIT_LIST_HEAD(&pages);
+	i = 0;
+	while (size_remaining > 0) {
+		/*
+		 * Avoid trying to allocate memory if the process
+		 * has been killed by SIGKILL
+		 */
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			goto free_buffer;
+		}
+
+		page = alloc_largest_available(sheap, size_remaining,
+					       max_order);
+		if (!page)
+			goto free_buffer;
+
+		list_add_tail(&page->lru, &pages);
+		size_remaining -= page_size(page);
+		max_order = compound_order(page);
+		i++;
+	}
+
+	table = &buffer->sg_table;
+	if (sg_alloc_table(table, i, GFP_KERNEL))
+		goto free_buffer;
+
+	sg = table->sgl;
+	list_for_each_entry_safe(page, tmp_page, &pages, lru) {
+		sg_set_page(sg, page, page_size(page), 0);
+		sg = sg_next(sg);
+		list_del(&page->lru);
+	}
+
+	/* create the dmabuf */
+	exp_info.exp_name = dma_heap_get_name(heap);
+	exp_info.ops = &system_heap_buf_ops;
+	exp_info.size = buffer->len;
+	exp_info.flags = fd_flags;
+	exp_info.priv = buffer;
+	dmabuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dmabuf)) {
+		ret = PTR_ERR(dmabuf);
+		goto free_pages;
+	}
+	return dmabuf;
+
+free_pages:
+	for_each_sgtable_sg(table, sg, i)
+		system_heap_pool_put(sheap, sg_page(sg));
+	sg_free_table(table);
+	if (IS_ENABLED(CONFIG_DMABUF_HEAPS_SYSTEM_POOL))
+		queue_work(system_unbound_wq, &sheap->zero_work);
+free_buffer:
+	list_for_each_entry_safe(page, tmp_page, &pages, lru)
+		__free_pages(page, compound_order(page));
+	kfree(buffer);
+
+	return ERR_PTR(ret);
+}
+
+static const struct dma_heap_ops system_heap_ops = {
+	.allocate = system_heap_allocate,
+};
+
+static unsigned long system_heap_shrink_count(struct shrinker *shrinker,
+					      struct shrink_control *sc)
+{
+	unsigned long count = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sys_heaps); i++)
+		count += atomic_long_read(&sys_heaps[i].nr_pages);
+
+	return count ? count : SHRINK_EMPTY;
+}
+
+static unsigned long system_heap_pool_shrink(struct system_heap *sheap,
+					     struct system_heap_pool *pool,
+					     unsigned long nr_to_scan)
+{
+	unsigned long freed = 0;
+	struct page *page;
+
+	while (freed < nr_to_scan) {
+		spin_lock(&pool->lock);
+		page = list_first_entry_or_null(&pool->dirty, struct page, lru);
+		if (page) {
+			pool->nr_dirty--;
+		} else {
+			page = list_first_entry_or_null(&pool->clean,
+							struct page, lru);
+			if (page)
+				pool->nr_clean--;
+		}
+		if (page)
+			list_del(&page->lru);
+		spin_unlock(&pool->lock);
+
+		if (!page)
+			break;
+
+		atomic_long_sub(1 << pool->order, &sheap->nr_pages);
+		__free_pages(page, pool->order);
+		freed += 1 << pool->order;
+	}
+
+	return freed;
+}
+
+static unsigned long system_heap_shrink_scan(struct shrinker *shrinker,
+					     struct shrink_control *sc)
+{
+	unsigned long freed = 0;
+	int i, j;
+
+	/* Give back the small pages first, they're the cheapest to refill */
+	for (j = NUM_ORDERS - 1; j >= 0; j--) {
+		for (i = 0; i < ARRAY_SIZE(sys_heaps); i++) {
+			if (freed >= sc->nr_to_scan)
+				goto out;
+
+			freed += system_heap_pool_shrink(&sys_heaps[i],
+							 &sys_heaps[i].pools[j],
+							 sc->nr_to_scan - freed);
+		}
+	}
+out:
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker system_heap_shrinker = {
+	.count_objects = system_heap_shrink_count,
+	.scan_objects = system_heap_shrink_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+static int system_heap_add(struct system_heap *sheap, const char *name,
+			   bool uncached)
+{
+	struct dma_heap_export_info exp_info;
+	int i;
+
+	sheap->uncached = uncached;
+	atomic_long_set(&sheap->nr_pages, 0);
+	INIT_WORK(&sheap->zero_work, system_heap_zero_workfn);
+	for (i = 0; i < NUM_ORDERS; i++) {
+		struct system_heap_pool *pool = &sheap->pools[i];
+
+		spin_lock_init(&pool->lock);
+		INIT_LIST_HEAD(&pool->clean);
+		INIT_LIST_HEAD(&pool->dirty);
+		pool->order = orders[i];
+	}
+
+	exp_info.name = name;
+	exp_info.ops = &system_heap_ops;
+	exp_info.priv = sheap;
+
+	sheap->heap = dma_heap_add(&exp_info);
+	if (IS_ERR(sheap->heap))
+		return PTR_ERR(sheap->heap);
+
+	/* The heap device is only used for cache maintenance */
+	if (uncached)
+		dma_coerce_mask_and_coherent(dma_heap_get_dev(sheap->heap),
+					     DMA_BIT_MASK(64));
+
+	return 0;
+}
+
+static int system_heap_create(void)
+{
+	int ret;
+
+	ret = system_heap_add(&sys_heaps[0], "system", false);
+	if (ret)
+		return ret;
+
+	if (!IS_ENABLED(CONFIG_DMABUF_HEAPS_SYSTEM_POOL))
+		return 0;
+
+	ret = system_heap_add(&sys_heaps[1], "system-uncached", true);
+	if (ret)
+		return ret;
+
+	return register_shrinker(&system_heap_shrinker, "dmabuf-system-heap");
+}
+module_init(system_heap_create);
+MODULE_LICENSE("GPL");
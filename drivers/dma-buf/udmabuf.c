@@ -67,6 +67,11 @@ static struct sg_table *get_sg_table(struct device *dev, struct dma_buf *buf,
 	sg = kzalloc(sizeof(*sg), GFP_KERNEL);
 	if (!sg)
 		return ERR_PTR(-ENOMEM);
+	/*
+	 * Physically contiguous runs of pages, like the subpages of a hugetlb
+	 * page, are merged into a single entry here, so a hugetlb backed
+	 * buffer needs one entry per huge page at most.
+	 */
 	ret = sg_alloc_table_from_pages(sg, ubuf->pages, ubuf->pagecount,
 					0, ubuf->pagecount << PAGE_SHIFT,
 					GFP_KERNEL);
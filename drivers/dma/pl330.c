@@ -19,6 +19,7 @@
 #include <linux/dma-mapping.h>
 #include <linux/dmaengine.h>
 #include <linux/amba/bus.h>
+#include <linux/amba/pl330.h>
 #include <linux/scatterlist.h>
 #include <linux/of.h>
 #include <linux/of_dma.h>
@@ -248,6 +249,13 @@ enum pl330_byteswap {
  */
 #define MCODE_BUFF_PER_REQ	256
 
+/*
+ * Max number of back-to-back memcpy descs that are programmed into a
+ * single req, so that they run without a round trip through the irq
+ * and tasklet in between.
+ */
+#define PL330_MAX_BATCH		8
+
 /* Use this _only_ to wait on transient states */
 #define UNTIL(t, s)	while (!(_state(t) & (s))) cpu_relax();
 
@@ -457,6 +465,8 @@ struct dma_pl330_chan {
 
 	/* for cyclic capability */
 	bool cyclic;
+	/* complete cyclic periods from the irq handler */
+	bool cyclic_irq;
 
 	/* for runtime pm tracking */
 	bool active;
@@ -545,6 +555,11 @@ struct dma_pl330_desc {
 	unsigned peri:5;
 	/* Hook to attach to DMAC's list of reqs with due callback */
 	struct list_head rqd;
+
+	/* First desc of the batch this desc is programmed in, if any */
+	struct dma_pl330_desc *batch_head;
+	/* Next desc programmed in the same req */
+	struct dma_pl330_desc *batch_next;
 };
 
 struct _xfer_spec {
@@ -555,6 +570,7 @@ struct _xfer_spec {
 static int pl330_config_write(struct dma_chan *chan,
 			struct dma_slave_config *slave_config,
 			enum dma_transfer_direction direction);
+static inline void fill_queue(struct dma_pl330_chan *pch);
 
 static inline bool _queue_full(struct pl330_thread *thrd)
 {
@@ -1413,18 +1429,22 @@ static inline int _setup_xfer(struct pl330_dmac *pl330,
  */
 static int _setup_req(struct pl330_dmac *pl330, unsigned dry_run,
 		      struct pl330_thread *thrd, unsigned index,
-		      struct _xfer_spec *pxs)
+		      struct _xfer_spec *pxs, unsigned int nr_xfers)
 {
 	struct _pl330_req *req = &thrd->req[index];
 	u8 *buf = req->mc_cpu;
+	unsigned int i;
 	int off = 0;
 
 	PL330_DBGMC_START(req->mc_bus);
 
-	/* DMAMOV CCR, ccr */
-	off += _emit_MOV(dry_run, &buf[off], CCR, pxs->ccr);
+	for (i = 0; i < nr_xfers; i++) {
+		/* DMAMOV CCR, ccr */
+		if (!i || pxs[i].ccr != pxs[i - 1].ccr)
+			off += _emit_MOV(dry_run, &buf[off], CCR, pxs[i].ccr);
 
-	off += _setup_xfer(pl330, dry_run, &buf[off], pxs);
+		off += _setup_xfer(pl330, dry_run, &buf[off], &pxs[i]);
+	}
 
 	/* DMASEV peripheral/event */
 	off += _emit_SEV(dry_run, &buf[off], thrd->ev);
@@ -1466,6 +1486,19 @@ static inline u32 _prepare_ccr(const struct pl330_reqcfg *rqc)
 	return ccr;
 }
 
+/* Detach desc and the ones after it from the batch they are in */
+static void pl330_unbatch(struct dma_pl330_desc *desc)
+{
+	struct dma_pl330_desc *next;
+
+	while (desc) {
+		next = desc->batch_next;
+		desc->batch_head = NULL;
+		desc->batch_next = NULL;
+		desc = next;
+	}
+}
+
 /*
  * Submit a list of xfers after which the client wants notification.
  * Client is not notified after each xfer unit, just once after all
@@ -1475,10 +1508,10 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	struct dma_pl330_desc *desc)
 {
 	struct pl330_dmac *pl330 = thrd->dmac;
-	struct _xfer_spec xs;
+	struct _xfer_spec xs[PL330_MAX_BATCH];
+	struct dma_pl330_desc *d;
 	unsigned long flags;
-	unsigned idx;
-	u32 ccr;
+	unsigned idx, nr;
 	int ret = 0;
 
 	switch (desc->rqtype) {
@@ -1518,21 +1551,27 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 		goto xfer_exit;
 	}
 
-	/* Prefer Secure Channel */
-	if (!_manager_ns(thrd))
-		desc->rqcfg.nonsecure = 0;
-	else
-		desc->rqcfg.nonsecure = 1;
+	nr = 0;
+	for (d = desc; d && nr < PL330_MAX_BATCH; d = d->batch_next) {
+		/* Prefer Secure Channel */
+		if (!_manager_ns(thrd))
+			d->rqcfg.nonsecure = 0;
+		else
+			d->rqcfg.nonsecure = 1;
 
-	ccr = _prepare_ccr(&desc->rqcfg);
+		xs[nr].ccr = _prepare_ccr(&d->rqcfg);
+		xs[nr].desc = d;
+		nr++;
+	}
 
 	idx = thrd->req[0].desc == NULL ? 0 : 1;
 
-	xs.ccr = ccr;
-	xs.desc = desc;
-
 	/* First dry run to check if req is acceptable */
-	ret = _setup_req(pl330, 1, thrd, idx, &xs);
+	ret = _setup_req(pl330, 1, thrd, idx, xs, nr);
+
+	/* Leave the tail of a batch that doesn't fit for the next req */
+	while (ret > pl330->mcbufsz / 2 && nr > 1)
+		ret = _setup_req(pl330, 1, thrd, idx, xs, --nr);
 
 	if (ret > pl330->mcbufsz / 2) {
 		dev_info(pl330->ddma.dev, "%s:%d Try increasing mcbufsz (%i/%i)\n",
@@ -1541,10 +1580,17 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 		goto xfer_exit;
 	}
 
+	if (xs[nr - 1].desc->batch_next) {
+		pl330_unbatch(xs[nr - 1].desc->batch_next);
+		xs[nr - 1].desc->batch_next = NULL;
+		if (nr == 1)
+			desc->batch_head = NULL;
+	}
+
 	/* Hook the request */
 	thrd->lstenq = idx;
 	thrd->req[idx].desc = desc;
-	_setup_req(pl330, 0, thrd, idx, &xs);
+	_setup_req(pl330, 0, thrd, idx, xs, nr);
 
 	ret = 0;
 
@@ -1554,6 +1600,35 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	return ret;
 }
 
+/*
+ * Requeue a completed period of a cyclic xfer and give the client its
+ * callback right away, instead of leaving both to the tasklet. Keeps the
+ * period latency down to that of the irq for clients with small periods.
+ */
+static void pl330_cyclic_irq_done(struct dma_pl330_chan *pch,
+				  struct dma_pl330_desc *desc)
+{
+	struct dmaengine_desc_callback cb;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pch->lock, flags);
+
+	desc->status = PREP;
+	list_move_tail(&desc->node, &pch->work_list);
+
+	fill_queue(pch);
+
+	spin_lock(&pch->thread->dmac->lock);
+	pl330_start_thread(pch->thread);
+	spin_unlock(&pch->thread->dmac->lock);
+
+	dmaengine_desc_get_callback(&desc->txd, &cb);
+
+	spin_unlock_irqrestore(&pch->lock, flags);
+
+	dmaengine_desc_callback_invoke(&cb, NULL);
+}
+
 static void dma_pl330_rqcb(struct dma_pl330_desc *desc, enum pl330_op_err err)
 {
 	struct dma_pl330_chan *pch;
@@ -1568,9 +1643,18 @@ static void dma_pl330_rqcb(struct dma_pl330_desc *desc, enum pl330_op_err err)
 	if (!pch)
 		return;
 
+	if (pch->cyclic && pch->cyclic_irq && err == PL330_ERR_NONE) {
+		pl330_cyclic_irq_done(pch, desc);
+		return;
+	}
+
 	spin_lock_irqsave(&pch->lock, flags);
 
-	desc->status = DONE;
+	/* All descs of a batch complete with the req they are in */
+	do {
+		desc->status = DONE;
+		desc = desc->batch_next;
+	} while (desc);
 
 	spin_unlock_irqrestore(&pch->lock, flags);
 
@@ -2039,9 +2123,37 @@ to_desc(struct dma_async_tx_descriptor *tx)
 	return container_of(tx, struct dma_pl330_desc, txd);
 }
 
+/*
+ * Link the memcpy descs queued right after first, so that they are
+ * programmed into the same req and run back to back on the thread.
+ */
+static void pl330_batch_memcpy(struct dma_pl330_chan *pch,
+			       struct dma_pl330_desc *first)
+{
+	struct dma_pl330_desc *desc = first, *prev = first;
+	unsigned int nr = 1;
+
+	if (first->rqtype != DMA_MEM_TO_MEM)
+		return;
+
+	list_for_each_entry_continue(desc, &pch->work_list, node) {
+		if (nr == PL330_MAX_BATCH || desc->status != PREP ||
+		    desc->rqtype != DMA_MEM_TO_MEM)
+			break;
+
+		desc->batch_head = first;
+		prev->batch_next = desc;
+		prev = desc;
+		nr++;
+	}
+
+	if (nr > 1)
+		first->batch_head = first;
+}
+
 static inline void fill_queue(struct dma_pl330_chan *pch)
 {
-	struct dma_pl330_desc *desc;
+	struct dma_pl330_desc *desc, *d;
 	int ret;
 
 	list_for_each_entry(desc, &pch->work_list, node) {
@@ -2050,14 +2162,19 @@ static inline void fill_queue(struct dma_pl330_chan *pch)
 		if (desc->status == BUSY || desc->status == PAUSED)
 			continue;
 
+		pl330_batch_memcpy(pch, desc);
+
 		ret = pl330_submit_req(pch->thread, desc);
 		if (!ret) {
-			desc->status = BUSY;
+			for (d = desc; d; d = d->batch_next)
+				d->status = BUSY;
 		} else if (ret == -EAGAIN) {
 			/* QFull or DMAC Dying */
+			pl330_unbatch(desc);
 			break;
 		} else {
 			/* Unacceptable request */
+			pl330_unbatch(desc);
 			desc->status = DONE;
 			dev_err(pch->dmac->ddma.dev, "%s:%d Bad Desc(%d)\n",
 					__func__, __LINE__, desc->txd.cookie);
@@ -2271,9 +2388,15 @@ static int pl330_config(struct dma_chan *chan,
 			struct dma_slave_config *slave_config)
 {
 	struct dma_pl330_chan *pch = to_pchan(chan);
+	const struct pl330_slave_config *cfg = slave_config->peripheral_config;
 
 	memcpy(&pch->slave_config, slave_config, sizeof(*slave_config));
 
+	if (cfg && slave_config->peripheral_size == sizeof(*cfg))
+		pch->cyclic_irq = cfg->cyclic_irq;
+	else
+		pch->cyclic_irq = false;
+
 	return 0;
 }
 
@@ -2433,6 +2556,13 @@ pl330_tx_status(struct dma_chan *chan, dma_cookie_t cookie,
 	list_for_each_entry(desc, &pch->work_list, node) {
 		if (desc->status == DONE)
 			transferred = desc->bytes_requested;
+		else if (running && desc->batch_head == running)
+			/*
+			 * SAR can't tell which desc of a batch the thread is
+			 * at, so none of them count as done before the whole
+			 * batch has retired.
+			 */
+			transferred = 0;
 		else if (running && desc == running)
 			transferred =
 				pl330_get_current_xferred_count(pch, desc);
@@ -2441,7 +2571,8 @@ pl330_tx_status(struct dma_chan *chan, dma_cookie_t cookie,
 			 * Busy but not running means either just enqueued,
 			 * or finished and not yet marked done
 			 */
-			if (desc == last_enq)
+			if (desc == last_enq ||
+			    (desc->batch_head && desc->batch_head == last_enq))
 				transferred = 0;
 			else
 				transferred = desc->bytes_requested;
@@ -2615,6 +2746,8 @@ static struct dma_pl330_desc *pl330_get_desc(struct dma_pl330_chan *pch)
 
 	/* Initialize the descriptor */
 	desc->pchan = pch;
+	desc->batch_head = NULL;
+	desc->batch_next = NULL;
 	desc->txd.cookie = 0;
 	async_tx_ack(&desc->txd);
 
@@ -30,6 +30,9 @@
 #define GPIO_TYPE_V2		(0x01000C2B)  /* GPIO Version ID 0x01000C2B */
 #define GPIO_TYPE_V2_1		(0x0101157C)  /* GPIO Version ID 0x0101157C */
 
+/* Status register re-reads per parent interrupt, see rockchip_irq_demux() */
+#define RK_IRQ_DEMUX_ROUNDS	4
+
 static const struct rockchip_gpio_regs gpio_regs_v1 = {
 	.port_dr = 0x00,
 	.port_ddr = 0x04,
@@ -193,6 +196,49 @@ static int rockchip_gpio_get(struct gpio_chip *gc, unsigned int offset)
 	return data;
 }
 
+static int rockchip_gpio_get_multiple(struct gpio_chip *gc,
+				      unsigned long *mask, unsigned long *bits)
+{
+	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
+	u32 data;
+
+	data = readl(bank->reg_base + bank->gpio_regs->ext_port);
+	*bits = (*bits & ~*mask) | (data & *mask);
+
+	return 0;
+}
+
+static void rockchip_gpio_set_multiple(struct gpio_chip *gc,
+				       unsigned long *mask, unsigned long *bits)
+{
+	struct rockchip_pin_bank *bank = gpiochip_get_data(gc);
+	void __iomem *reg = bank->reg_base + bank->gpio_regs->port_dr;
+	u32 set_mask = *mask, set_bits = *bits & *mask;
+	unsigned long flags;
+	u32 data;
+
+	/*
+	 * The v2 data register takes a write enable mask in the upper half
+	 * of each 16 bit word, so all lines of a half change with a single
+	 * write and nothing needs to be read back.
+	 */
+	if (bank->gpio_type == GPIO_TYPE_V2) {
+		if (set_mask & 0xffff)
+			writel((set_mask & 0xffff) << 16 | (set_bits & 0xffff),
+			       reg);
+		if (set_mask >> 16)
+			writel((set_mask & 0xffff0000) | set_bits >> 16,
+			       reg + 0x4);
+		return;
+	}
+
+	raw_spin_lock_irqsave(&bank->slock, flags);
+	data = readl(reg);
+	data = (data & ~set_mask) | set_bits;
+	writel(data, reg);
+	raw_spin_unlock_irqrestore(&bank->slock, flags);
+}
+
 static int rockchip_gpio_set_debounce(struct gpio_chip *gc,
 				      unsigned int offset,
 				      unsigned int debounce)
@@ -320,6 +366,8 @@ static const struct gpio_chip rockchip_gpiolib_chip = {
 	.free = gpiochip_generic_free,
 	.set = rockchip_gpio_set,
 	.get = rockchip_gpio_get,
+	.set_multiple = rockchip_gpio_set_multiple,
+	.get_multiple = rockchip_gpio_get_multiple,
 	.get_direction	= rockchip_gpio_get_direction,
 	.direction_input = rockchip_gpio_direction_input,
 	.direction_output = rockchip_gpio_direction_output,
@@ -328,53 +376,80 @@ static const struct gpio_chip rockchip_gpiolib_chip = {
 	.owner = THIS_MODULE,
 };
 
+/*
+ * Triggering IRQ on both rising and falling edge needs manual intervention.
+ */
+static void rockchip_irq_toggle_edge(struct rockchip_pin_bank *bank,
+				     unsigned int irq)
+{
+	u32 data, data_old, polarity;
+	unsigned long flags;
+
+	data = readl_relaxed(bank->reg_base + bank->gpio_regs->ext_port);
+	do {
+		raw_spin_lock_irqsave(&bank->slock, flags);
+
+		polarity = readl_relaxed(bank->reg_base +
+					 bank->gpio_regs->int_polarity);
+		if (data & BIT(irq))
+			polarity &= ~BIT(irq);
+		else
+			polarity |= BIT(irq);
+		writel(polarity,
+		       bank->reg_base + bank->gpio_regs->int_polarity);
+
+		raw_spin_unlock_irqrestore(&bank->slock, flags);
+
+		data_old = data;
+		data = readl_relaxed(bank->reg_base +
+				     bank->gpio_regs->ext_port);
+	} while ((data & BIT(irq)) != (data_old & BIT(irq)));
+}
+
 static void rockchip_irq_demux(struct irq_desc *desc)
 {
 	struct irq_chip *chip = irq_desc_get_chip(desc);
 	struct rockchip_pin_bank *bank = irq_desc_get_handler_data(desc);
-	unsigned long pending;
-	unsigned int irq;
+	void __iomem *status = bank->reg_base + bank->gpio_regs->int_status;
+	unsigned int irq, round;
+	u32 pending;
 
 	dev_dbg(bank->dev, "got irq for bank %s\n", bank->name);
 
 	chained_irq_enter(chip, desc);
 
-	pending = readl_relaxed(bank->reg_base + bank->gpio_regs->int_status);
-	for_each_set_bit(irq, &pending, 32) {
-		dev_dbg(bank->dev, "handling irq %d\n", irq);
+	/*
+	 * Keep going while the status register is set, so lines that fire
+	 * while others are handled don't need another trip through the
+	 * parent interrupt controller. Bound it so a line that keeps firing
+	 * can't hold this CPU: whatever is left raises the parent again.
+	 */
+	for (round = 0; round < RK_IRQ_DEMUX_ROUNDS; round++) {
+		pending = readl_relaxed(status);
+		if (!pending)
+			break;
 
-		/*
-		 * Triggering IRQ on both rising and falling edge
-		 * needs manual intervention.
-		 */
-		if (bank->toggle_edge_mode & BIT(irq)) {
-			u32 data, data_old, polarity;
-			unsigned long flags;
-
-			data = readl_relaxed(bank->reg_base +
-					     bank->gpio_regs->ext_port);
-			do {
-				raw_spin_lock_irqsave(&bank->slock, flags);
-
-				polarity = readl_relaxed(bank->reg_base +
-							 bank->gpio_regs->int_polarity);
-				if (data & BIT(irq))
-					polarity &= ~BIT(irq);
-				else
-					polarity |= BIT(irq);
-				writel(polarity,
-				       bank->reg_base +
-				       bank->gpio_regs->int_polarity);
-
-				raw_spin_unlock_irqrestore(&bank->slock, flags);
-
-				data_old = data;
-				data = readl_relaxed(bank->reg_base +
-						     bank->gpio_regs->ext_port);
-			} while ((data & BIT(irq)) != (data_old & BIT(irq)));
+		for (; pending; pending &= pending - 1) {
+			irq = __ffs(pending);
+			dev_dbg(bank->dev, "handling irq %d\n", irq);
+
+			if (bank->toggle_edge_mode & BIT(irq))
+				rockchip_irq_toggle_edge(bank, irq);
+
+			if (!generic_handle_domain_irq(bank->domain, irq))
+				continue;
+
+			/* Nobody handles it: mask and ack it, so it goes away */
+			dev_err_ratelimited(bank->dev,
+					    "unhandled irq %d on bank %s\n",
+					    irq, bank->name);
+			raw_spin_lock(&bank->slock);
+			rockchip_gpio_writel_bit(bank, irq, 1,
+						 bank->gpio_regs->int_mask);
+			rockchip_gpio_writel_bit(bank, irq, 1,
+						 bank->gpio_regs->port_eoi);
+			raw_spin_unlock(&bank->slock);
 		}
-
-		generic_handle_domain_irq(bank->domain, irq);
 	}
 
 	chained_irq_exit(chip, desc);
@@ -32,6 +32,7 @@
 #include <linux/console.h>
 #include <linux/dma-buf.h>
 #include <linux/kernel.h>
+#include <linux/list_sort.h>
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/sysrq.h>
@@ -737,6 +738,86 @@ static void drm_fb_helper_memory_range_to_clip(struct fb_info *info, off_t off,
 	drm_rect_init(clip, x1, y1, x2 - x1, y2 - y1);
 }
 
+/*
+ * Bounds of the deferred I/O delay of the generic fbdev emulation. It starts
+ * at the minimum and grows while the client keeps writing.
+ */
+#define DRM_FB_HELPER_DEFIO_MIN_DELAY	(HZ / 20)
+#define DRM_FB_HELPER_DEFIO_MAX_DELAY	(HZ / 5)
+
+static void drm_fb_helper_deferred_io_adapt(struct fb_info *info)
+{
+	struct drm_fb_helper *helper = info->par;
+	struct fb_deferred_io *fbdefio = info->fbdefio;
+	unsigned long delay = fbdefio->delay;
+	unsigned long now = jiffies;
+
+	/* Drivers with their own deferred I/O setup keep their delay. */
+	if (fbdefio != &helper->fbdefio)
+		return;
+
+	/*
+	 * The deferred I/O runs a delay after the first write following a
+	 * flush. Running again shortly after the previous flush means that the
+	 * client redraws constantly, so wait longer and flush several redraws
+	 * at once. After a pause go back to the shortest delay.
+	 */
+	if (time_before(now, helper->defio_flush + 2 * delay))
+		delay = min_t(unsigned long, 2 * delay, DRM_FB_HELPER_DEFIO_MAX_DELAY);
+	else
+		delay = DRM_FB_HELPER_DEFIO_MIN_DELAY;
+
+	helper->defio_flush = now;
+	WRITE_ONCE(fbdefio->delay, delay);
+}
+
+static int drm_fb_helper_pageref_cmp(void *priv, const struct list_head *a,
+				     const struct list_head *b)
+{
+	const struct fb_deferred_io_pageref *pa =
+		list_entry(a, struct fb_deferred_io_pageref, list);
+	const struct fb_deferred_io_pageref *pb =
+		list_entry(b, struct fb_deferred_io_pageref, list);
+
+	return pa->offset < pb->offset ? -1 : 1;
+}
+
+/*
+ * Add the scanlines covered by [off, end) to the damage band in @band. If they
+ * don't touch the band, flush the band first, so that unrelated areas of the
+ * screen are not copied as one large rectangle.
+ */
+static void drm_fb_helper_deferred_io_range(struct fb_info *info, unsigned long off,
+					    unsigned long end, struct drm_rect *band)
+{
+	struct drm_fb_helper *helper = info->par;
+	struct drm_rect clip;
+
+	/*
+	 * As we can only track pages, we might reach beyond the end
+	 * of the screen and account for non-existing scanlines. Hence,
+	 * keep the covered memory area within the screen buffer.
+	 */
+	end = min(end, info->screen_size);
+	if (off >= end)
+		return;
+
+	drm_fb_helper_memory_range_to_clip(info, off, end - off, &clip);
+
+	if (!drm_rect_visible(band)) {
+		*band = clip;
+	} else if (clip.y1 > band->y2) {
+		drm_fb_helper_damage(info, band->x1, band->y1,
+				     drm_rect_width(band), drm_rect_height(band));
+		flush_work(&helper->damage_work);
+		*band = clip;
+	} else {
+		band->x1 = min(band->x1, clip.x1);
+		band->x2 = max(band->x2, clip.x2);
+		band->y2 = max(band->y2, clip.y2);
+	}
+}
+
 /**
  * drm_fb_helper_deferred_io() - fbdev deferred_io callback function
  * @info: fb_info struct pointer
@@ -744,35 +825,35 @@ static void drm_fb_helper_memory_range_to_clip(struct fb_info *info, off_t off,
  *
  * This function is used as the &fb_deferred_io.deferred_io
  * callback function for flushing the fbdev mmap writes.
+ *
+ * Runs of written pages that are separated by untouched scanlines are
+ * flushed one after the other instead of as a single damage rectangle. With
+ * the generic fbdev emulation, the deferred I/O delay also grows while the
+ * client writes continuously.
  */
 void drm_fb_helper_deferred_io(struct fb_info *info, struct list_head *pagereflist)
 {
-	unsigned long start, end, min_off, max_off;
+	unsigned long start = 0, end = 0;
 	struct fb_deferred_io_pageref *pageref;
-	struct drm_rect damage_area;
+	struct drm_rect band;
 
-	min_off = ULONG_MAX;
-	max_off = 0;
+	drm_fb_helper_deferred_io_adapt(info);
+
+	drm_rect_init(&band, 0, 0, 0, 0);
+
+	list_sort(NULL, pagereflist, drm_fb_helper_pageref_cmp);
 	list_for_each_entry(pageref, pagereflist, list) {
-		start = pageref->offset;
-		end = start + PAGE_SIZE;
-		min_off = min(min_off, start);
-		max_off = max(max_off, end);
+		if (pageref->offset != end) {
+			drm_fb_helper_deferred_io_range(info, start, end, &band);
+			start = pageref->offset;
+		}
+		end = pageref->offset + PAGE_SIZE;
 	}
-	if (min_off >= max_off)
-		return;
-
-	/*
-	 * As we can only track pages, we might reach beyond the end
-	 * of the screen and account for non-existing scanlines. Hence,
-	 * keep the covered memory area within the screen buffer.
-	 */
-	max_off = min(max_off, info->screen_size);
+	drm_fb_helper_deferred_io_range(info, start, end, &band);
 
-	drm_fb_helper_memory_range_to_clip(info, min_off, max_off - min_off, &damage_area);
-	drm_fb_helper_damage(info, damage_area.x1, damage_area.y1,
-			     drm_rect_width(&damage_area),
-			     drm_rect_height(&damage_area));
+	if (drm_rect_visible(&band))
+		drm_fb_helper_damage(info, band.x1, band.y1,
+				     drm_rect_width(&band), drm_rect_height(&band));
 }
 EXPORT_SYMBOL(drm_fb_helper_deferred_io);
 
@@ -2414,11 +2495,6 @@ static const struct fb_ops drm_fbdev_fb_ops = {
 	.fb_imageblit	= drm_fbdev_fb_imageblit,
 };
 
-static struct fb_deferred_io drm_fbdev_defio = {
-	.delay		= HZ / 20,
-	.deferred_io	= drm_fb_helper_deferred_io,
-};
-
 /*
  * This function uses the client API to create a framebuffer backed by a dumb buffer.
  *
@@ -2468,7 +2544,12 @@ static int drm_fb_helper_generic_probe(struct drm_fb_helper *fb_helper,
 			return -ENOMEM;
 		fbi->flags |= FBINFO_VIRTFB | FBINFO_READS_FAST;
 
-		fbi->fbdefio = &drm_fbdev_defio;
+		/* Set a default deferred I/O handler */
+		fb_helper->fbdefio.delay = DRM_FB_HELPER_DEFIO_MIN_DELAY;
+		fb_helper->fbdefio.deferred_io = drm_fb_helper_deferred_io;
+		fb_helper->defio_flush = jiffies;
+
+		fbi->fbdefio = &fb_helper->fbdefio;
 		fb_deferred_io_init(fbi);
 	} else {
 		/* buffer is mapped for HW framebuffer */
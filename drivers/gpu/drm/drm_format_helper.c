@@ -20,6 +20,33 @@
 #include <drm/drm_print.h>
 #include <drm/drm_rect.h>
 
+#if defined(CONFIG_ARM64) && defined(CONFIG_KERNEL_MODE_NEON) && \
+	!defined(CONFIG_CPU_BIG_ENDIAN)
+#include <asm/neon.h>
+#include <asm/simd.h>
+
+#include "drm_format_helper_neon.h"
+
+/*
+ * Convert the leading pixels of a line with its NEON version, if the FPSIMD
+ * unit is usable here. Evaluates to the number of pixels converted. Short
+ * lines are left to the scalar code, they aren't worth the state switch.
+ */
+#define drm_fb_xfrm_line_neon(neon_line, dbuf, sbuf, pixels)	\
+	({							\
+		unsigned int __x = 0;				\
+								\
+		if ((pixels) >= 16 && may_use_simd()) {		\
+			kernel_neon_begin();			\
+			__x = neon_line(dbuf, sbuf, pixels);	\
+			kernel_neon_end();			\
+		}						\
+		__x;						\
+	})
+#else
+#define drm_fb_xfrm_line_neon(neon_line, dbuf, sbuf, pixels)	0
+#endif
+
 static unsigned int clip_offset(const struct drm_rect *clip, unsigned int pitch, unsigned int cpp)
 {
 	return clip->y1 * pitch + clip->x1 * cpp;
@@ -211,6 +238,11 @@ static void drm_fb_swab16_line(void *dbuf, const void *sbuf, unsigned int pixels
 	u16 *dbuf16 = dbuf;
 	const u16 *sbuf16 = sbuf;
 	const u16 *send16 = sbuf16 + pixels;
+	unsigned int x;
+
+	x = drm_fb_xfrm_line_neon(drm_fb_swab16_line_neon, dbuf, sbuf, pixels);
+	dbuf16 += x;
+	sbuf16 += x;
 
 	while (sbuf16 < send16)
 		*dbuf16++ = swab16(*sbuf16++);
@@ -221,6 +253,11 @@ static void drm_fb_swab32_line(void *dbuf, const void *sbuf, unsigned int pixels
 	u32 *dbuf32 = dbuf;
 	const u32 *sbuf32 = sbuf;
 	const u32 *send32 = sbuf32 + pixels;
+	unsigned int x;
+
+	x = drm_fb_xfrm_line_neon(drm_fb_swab32_line_neon, dbuf, sbuf, pixels);
+	dbuf32 += x;
+	sbuf32 += x;
 
 	while (sbuf32 < send32)
 		*dbuf32++ = swab32(*sbuf32++);
@@ -328,7 +365,9 @@ static void drm_fb_xrgb8888_to_rgb565_line(void *dbuf, const void *sbuf, unsigne
 	u16 val16;
 	u32 pix;
 
-	for (x = 0; x < pixels; x++) {
+	x = drm_fb_xfrm_line_neon(drm_fb_xrgb8888_to_rgb565_line_neon,
+				  dbuf, sbuf, pixels);
+	for (; x < pixels; x++) {
 		pix = le32_to_cpu(sbuf32[x]);
 		val16 = ((pix & 0x00F80000) >> 8) |
 			((pix & 0x0000FC00) >> 5) |
@@ -346,7 +385,9 @@ static void drm_fb_xrgb8888_to_rgb565_swab_line(void *dbuf, const void *sbuf,
 	u16 val16;
 	u32 pix;
 
-	for (x = 0; x < pixels; x++) {
+	x = drm_fb_xfrm_line_neon(drm_fb_xrgb8888_to_rgb565_swab_line_neon,
+				  dbuf, sbuf, pixels);
+	for (; x < pixels; x++) {
 		pix = le32_to_cpu(sbuf32[x]);
 		val16 = ((pix & 0x00F80000) >> 8) |
 			((pix & 0x0000FC00) >> 5) |
@@ -402,7 +443,11 @@ static void drm_fb_xrgb8888_to_rgb888_line(void *dbuf, const void *sbuf, unsigne
 	unsigned int x;
 	u32 pix;
 
-	for (x = 0; x < pixels; x++) {
+	x = drm_fb_xfrm_line_neon(drm_fb_xrgb8888_to_rgb888_line_neon,
+				  dbuf, sbuf, pixels);
+	dbuf8 += x * 3;
+
+	for (; x < pixels; x++) {
 		pix = le32_to_cpu(sbuf32[x]);
 		*dbuf8++ = (pix & 0x000000FF) >>  0;
 		*dbuf8++ = (pix & 0x0000FF00) >>  8;
@@ -561,7 +606,11 @@ static void drm_fb_xrgb8888_to_gray8_line(void *dbuf, const void *sbuf, unsigned
 	const __le32 *sbuf32 = sbuf;
 	unsigned int x;
 
-	for (x = 0; x < pixels; x++) {
+	x = drm_fb_xfrm_line_neon(drm_fb_xrgb8888_to_gray8_line_neon,
+				  dbuf, sbuf, pixels);
+	dbuf8 += x;
+
+	for (; x < pixels; x++) {
 		u32 pix = le32_to_cpu(sbuf32[x]);
 		u8 r = (pix & 0x00ff0000) >> 16;
 		u8 g = (pix & 0x0000ff00) >> 8;
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-2.0 or MIT
+/*
+ * NEON versions of the drm_format_helper line conversions
+ *
+ * Each function converts the largest multiple of 8 pixels that fits in
+ * @pixels and returns the number of pixels it converted, the caller does
+ * the rest with the scalar code. Callers must hold kernel_neon_begin().
+ */
+
+#include <asm/neon-intrinsics.h>
+
+#include "drm_format_helper_neon.h"
+
+unsigned int drm_fb_swab16_line_neon(void *dbuf, const void *sbuf,
+				     unsigned int pixels)
+{
+	const u8 *s = sbuf;
+	u8 *d = dbuf;
+	unsigned int x;
+
+	for (x = 0; x + 8 <= pixels; x += 8, s += 16, d += 16)
+		vst1q_u8(d, vrev16q_u8(vld1q_u8(s)));
+
+	return x;
+}
+
+unsigned int drm_fb_swab32_line_neon(void *dbuf, const void *sbuf,
+				     unsigned int pixels)
+{
+	const u8 *s = sbuf;
+	u8 *d = dbuf;
+	unsigned int x;
+
+	for (x = 0; x + 8 <= pixels; x += 8, s += 32, d += 32) {
+		vst1q_u8(d, vrev32q_u8(vld1q_u8(s)));
+		vst1q_u8(d + 16, vrev32q_u8(vld1q_u8(s + 16)));
+	}
+
+	return x;
+}
+
+/* The pixels are little endian, so the channels load as B, G, R, X */
+static inline uint16x8_t xrgb8888_to_rgb565(const u8 *s)
+{
+	uint8x8x4_t px = vld4_u8(s);
+	uint16x8_t val;
+
+	val = vshll_n_u8(px.val[2], 8);
+	val = vsriq_n_u16(val, vshll_n_u8(px.val[1], 8), 5);
+	val = vsriq_n_u16(val, vshll_n_u8(px.val[0], 8), 11);
+
+	return val;
+}
+
+unsigned int drm_fb_xrgb8888_to_rgb565_line_neon(void *dbuf, const void *sbuf,
+						 unsigned int pixels)
+{
+	const u8 *s = sbuf;
+	u16 *d = dbuf;
+	unsigned int x;
+
+	for (x = 0; x + 8 <= pixels; x += 8, s += 32, d += 8)
+		vst1q_u16(d, xrgb8888_to_rgb565(s));
+
+	return x;
+}
+
+unsigned int drm_fb_xrgb8888_to_rgb565_swab_line_neon(void *dbuf,
+						      const void *sbuf,
+						      unsigned int pixels)
+{
+	const u8 *s = sbuf;
+	u8 *d = dbuf;
+	unsigned int x;
+
+	for (x = 0; x + 8 <= pixels; x += 8, s += 32, d += 16) {
+		uint16x8_t val = xrgb8888_to_rgb565(s);
+
+		vst1q_u8(d, vrev16q_u8(vreinterpretq_u8_u16(val)));
+	}
+
+	return x;
+}
+
+unsigned int drm_fb_xrgb8888_to_rgb888_line_neon(void *dbuf, const void *sbuf,
+						 unsigned int pixels)
+{
+	const u8 *s = sbuf;
+	u8 *d = dbuf;
+	unsigned int x;
+
+	for (x = 0; x + 8 <= pixels; x += 8, s += 32, d += 24) {
+		uint8x8x4_t px = vld4_u8(s);
+		uint8x8x3_t out = { { px.val[0], px.val[1], px.val[2] } };
+
+		vst3_u8(d, out);
+	}
+
+	return x;
+}
+
+unsigned int drm_fb_xrgb8888_to_gray8_line_neon(void *dbuf, const void *sbuf,
+						unsigned int pixels)
+{
+	const u8 *s = sbuf;
+	u8 *d = dbuf;
+	unsigned int x;
+
+	for (x = 0; x + 8 <= pixels; x += 8, s += 32, d += 8) {
+		uint8x8x4_t px = vld4_u8(s);
+		uint16x8_t sum;
+		uint16x4_t lo, hi;
+
+		/* Same as the scalar (3 * r + 6 * g + b) / 10 */
+		sum = vmull_u8(px.val[2], vdup_n_u8(3));
+		sum = vmlal_u8(sum, px.val[1], vdup_n_u8(6));
+		sum = vaddw_u8(sum, px.val[0]);
+
+		/*
+		 * x * 6554 >> 16 equals x / 10 for all sums up to
+		 * 10 * 255, which is as large as they get.
+		 */
+		lo = vshrn_n_u32(vmull_n_u16(vget_low_u16(sum), 6554), 16);
+		hi = vshrn_n_u32(vmull_n_u16(vget_high_u16(sum), 6554), 16);
+
+		vst1_u8(d, vmovn_u16(vcombine_u16(lo, hi)));
+	}
+
+	return x;
+}
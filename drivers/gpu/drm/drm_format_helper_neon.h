@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: GPL-2.0 or MIT */
+
+#ifndef __DRM_FORMAT_HELPER_NEON_H__
+#define __DRM_FORMAT_HELPER_NEON_H__
+
+#include <linux/types.h>
+
+unsigned int drm_fb_swab16_line_neon(void *dbuf, const void *sbuf,
+				     unsigned int pixels);
+unsigned int drm_fb_swab32_line_neon(void *dbuf, const void *sbuf,
+				     unsigned int pixels);
+unsigned int drm_fb_xrgb8888_to_rgb565_line_neon(void *dbuf, const void *sbuf,
+						 unsigned int pixels);
+unsigned int drm_fb_xrgb8888_to_rgb565_swab_line_neon(void *dbuf,
+						      const void *sbuf,
+						      unsigned int pixels);
+unsigned int drm_fb_xrgb8888_to_rgb888_line_neon(void *dbuf, const void *sbuf,
+						 unsigned int pixels);
+unsigned int drm_fb_xrgb8888_to_gray8_line_neon(void *dbuf, const void *sbuf,
+						unsigned int pixels);
+
+#endif
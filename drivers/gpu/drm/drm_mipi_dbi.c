@@ -327,6 +327,47 @@ enum drm_mode_status mipi_dbi_pipe_mode_valid(struct drm_simple_display_pipe *pi
 }
 EXPORT_SYMBOL(mipi_dbi_pipe_mode_valid);
 
+/*
+ * Fixed cost of a flush in pixels: setting the window address and starting
+ * the memory write takes three commands, each one a separate SPI message
+ * with the D/C line toggled, which costs about as much bus time as sending
+ * this many pixels on a typical panel.
+ */
+#define MIPI_DBI_FLUSH_OVERHEAD	256
+
+static void mipi_dbi_flush_damage(struct drm_plane_state *old_state,
+				  struct drm_plane_state *state)
+{
+	struct drm_atomic_helper_damage_iter iter;
+	unsigned long area = 0, clips = 0;
+	struct drm_rect merged, clip;
+
+	if (!drm_atomic_helper_damage_merged(old_state, state, &merged))
+		return;
+
+	/*
+	 * Only send the clips one by one if that moves fewer pixels than the
+	 * bounding rectangle, all fixed costs included. Overlapping clips are
+	 * counted twice, which errs on the side of merging.
+	 */
+	drm_atomic_helper_damage_iter_init(&iter, old_state, state);
+	drm_atomic_for_each_plane_damage(&iter, &clip) {
+		area += drm_rect_width(&clip) * drm_rect_height(&clip) +
+			MIPI_DBI_FLUSH_OVERHEAD;
+		clips++;
+	}
+
+	if (clips < 2 || area >= drm_rect_width(&merged) * drm_rect_height(&merged) +
+			       MIPI_DBI_FLUSH_OVERHEAD) {
+		mipi_dbi_fb_dirty(state->fb, &merged);
+		return;
+	}
+
+	drm_atomic_helper_damage_iter_init(&iter, old_state, state);
+	drm_atomic_for_each_plane_damage(&iter, &clip)
+		mipi_dbi_fb_dirty(state->fb, &clip);
+}
+
 /**
  * mipi_dbi_pipe_update - Display pipe update helper
  * @pipe: Simple display pipe
@@ -339,13 +380,11 @@ void mipi_dbi_pipe_update(struct drm_simple_display_pipe *pipe,
 			  struct drm_plane_state *old_state)
 {
 	struct drm_plane_state *state = pipe->plane.state;
-	struct drm_rect rect;
 
 	if (!pipe->crtc.state->active)
 		return;
 
-	if (drm_atomic_helper_damage_merged(old_state, state, &rect))
-		mipi_dbi_fb_dirty(state->fb, &rect);
+	mipi_dbi_flush_damage(old_state, state);
 }
 EXPORT_SYMBOL(mipi_dbi_pipe_update);
 
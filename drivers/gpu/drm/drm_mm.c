@@ -1039,3 +1039,43 @@ void drm_mm_print(const struct drm_mm *mm, struct drm_printer *p)
 		   total_used, total_free);
 }
 EXPORT_SYMBOL(drm_mm_print);
+
+/**
+ * drm_mm_print_stats - print allocator fragmentation summary
+ * @mm: drm_mm allocator to print
+ * @p: DRM printer to use
+ *
+ * Unlike drm_mm_print() this doesn't dump every node, only the number of
+ * nodes and holes, the free space and the largest hole. The fragmentation
+ * figure is the share of the free space that lies outside the largest hole,
+ * i.e. that cannot be used by the largest possible allocation.
+ */
+void drm_mm_print_stats(const struct drm_mm *mm, struct drm_printer *p)
+{
+	const struct drm_mm_node *entry;
+	struct rb_node *rb;
+	u64 total_used = 0, total_free = 0, largest = 0, hole_start, hole_end;
+	unsigned long nodes = 0, holes = 0;
+
+	drm_mm_for_each_node(entry, mm) {
+		total_used += entry->size;
+		nodes++;
+	}
+
+	drm_mm_for_each_hole(entry, mm, hole_start, hole_end) {
+		total_free += hole_end - hole_start;
+		holes++;
+	}
+
+	/* holes_size is sorted by decreasing size */
+	rb = rb_first_cached(&mm->holes_size);
+	if (rb)
+		largest = rb_to_hole_size(rb);
+
+	drm_printf(p, "nodes: %lu, used %llu\n", nodes, total_used);
+	drm_printf(p, "holes: %lu, free %llu, largest %llu\n",
+		   holes, total_free, largest);
+	drm_printf(p, "fragmentation: %llu%%\n", total_free ?
+		   div64_u64((total_free - largest) * 100, total_free) : 0);
+}
+EXPORT_SYMBOL(drm_mm_print_stats);
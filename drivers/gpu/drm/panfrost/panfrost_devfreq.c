@@ -6,10 +6,18 @@
 #include <linux/devfreq_cooling.h>
 #include <linux/platform_device.h>
 #include <linux/pm_opp.h>
+#include <linux/units.h>
+#include <soc/rockchip/rockchip_opp.h>
 
 #include "panfrost_device.h"
 #include "panfrost_devfreq.h"
 
+/* Number of queued jobs from which the GPU is boosted to its highest OPP */
+#define BOOST_QUEUE_DEPTH	3
+
+/* How long the boost outlives the last job run with a deep queue */
+#define BOOST_HOLD_MS		100
+
 static void panfrost_devfreq_update_utilization(struct panfrost_devfreq *pfdevfreq)
 {
 	ktime_t now, last;
@@ -28,14 +36,20 @@ static void panfrost_devfreq_update_utilization(struct panfrost_devfreq *pfdevfr
 static int panfrost_devfreq_target(struct device *dev, unsigned long *freq,
 				   u32 flags)
 {
+	struct panfrost_device *pfdev = dev_get_drvdata(dev);
 	struct dev_pm_opp *opp;
+	int ret;
 
 	opp = devfreq_recommended_opp(dev, freq, flags);
 	if (IS_ERR(opp))
 		return PTR_ERR(opp);
 	dev_pm_opp_put(opp);
 
-	return dev_pm_opp_set_rate(dev, *freq);
+	ret = dev_pm_opp_set_rate(dev, *freq);
+	if (!ret)
+		WRITE_ONCE(pfdev->pfdevfreq.current_frequency, *freq);
+
+	return ret;
 }
 
 static void panfrost_devfreq_reset(struct panfrost_devfreq *pfdevfreq)
@@ -75,6 +89,65 @@ static int panfrost_devfreq_get_dev_status(struct device *dev,
 	return 0;
 }
 
+static void panfrost_devfreq_boost_work(struct work_struct *work)
+{
+	struct panfrost_devfreq *pfdevfreq =
+		container_of(work, struct panfrost_devfreq, boost_work);
+
+	/*
+	 * Both boosting and unboosting go through this work so that the last
+	 * state wins.
+	 */
+	dev_pm_qos_update_request(&pfdevfreq->boost_req,
+				  atomic_read(&pfdevfreq->boosted) ?
+				  pfdevfreq->boost_freq_khz :
+				  PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE);
+}
+
+static void panfrost_devfreq_unboost_work(struct work_struct *work)
+{
+	struct panfrost_devfreq *pfdevfreq =
+		container_of(to_delayed_work(work), struct panfrost_devfreq,
+			     unboost_work);
+
+	/* From here on simple_ondemand brings the frequency back down. */
+	atomic_set(&pfdevfreq->boosted, 0);
+	queue_work(system_highpri_wq, &pfdevfreq->boost_work);
+}
+
+/*
+ * Use the OPP voltages of the chip's leakage bin where the SoC describes
+ * them, see drivers/soc/rockchip/opp.c.
+ */
+static int panfrost_devfreq_set_leakage_bin(struct device *dev)
+{
+	struct dev_pm_opp_config config = {};
+	unsigned int supported_hw;
+	char name[4];
+	int bin, ret;
+
+	bin = rockchip_opp_get_leakage_bin(dev);
+	if (bin == -ENOENT)
+		return 0;
+	if (bin < 0)
+		return bin;
+
+	snprintf(name, sizeof(name), "L%d", bin);
+	supported_hw = BIT(bin);
+
+	config.prop_name = name;
+	config.supported_hw = &supported_hw;
+	config.supported_hw_count = 1;
+
+	ret = devm_pm_opp_set_config(dev, &config);
+	if (ret)
+		return ret;
+
+	DRM_DEV_INFO(dev, "using leakage bin %d\n", bin);
+
+	return 0;
+}
+
 static struct devfreq_dev_profile panfrost_devfreq_profile = {
 	.timer = DEVFREQ_TIMER_DELAYED,
 	.polling_ms = 50, /* ~3 frames */
@@ -111,6 +184,15 @@ int panfrost_devfreq_init(struct panfrost_device *pfdev)
 		}
 	}
 
+	if (pfdev->comp->leakage_opp) {
+		ret = panfrost_devfreq_set_leakage_bin(dev);
+		if (ret) {
+			if (ret != -EPROBE_DEFER)
+				DRM_DEV_ERROR(dev, "Couldn't set OPP leakage bin\n");
+			return ret;
+		}
+	}
+
 	ret = devm_pm_opp_of_add_table(dev);
 	if (ret) {
 		/* Optional, continue without devfreq */
@@ -121,6 +203,9 @@ int panfrost_devfreq_init(struct panfrost_device *pfdev)
 	pfdevfreq->opp_of_table_added = true;
 
 	spin_lock_init(&pfdevfreq->lock);
+	INIT_WORK(&pfdevfreq->boost_work, panfrost_devfreq_boost_work);
+	INIT_DELAYED_WORK(&pfdevfreq->unboost_work,
+			  panfrost_devfreq_unboost_work);
 
 	panfrost_devfreq_reset(pfdevfreq);
 
@@ -131,6 +216,7 @@ int panfrost_devfreq_init(struct panfrost_device *pfdev)
 		return PTR_ERR(opp);
 
 	panfrost_devfreq_profile.initial_freq = cur_freq;
+	pfdevfreq->current_frequency = cur_freq;
 
 	/*
 	 * Set the recommend OPP this will enable and configure the regulator
@@ -158,6 +244,20 @@ int panfrost_devfreq_init(struct panfrost_device *pfdev)
 		DRM_DEV_ERROR(dev, "Couldn't initialize GPU devfreq\n");
 		return PTR_ERR(devfreq);
 	}
+
+	/* Boost to the highest OPP, thermal limits still apply on top. */
+	cur_freq = ULONG_MAX;
+	opp = dev_pm_opp_find_freq_floor(dev, &cur_freq);
+	if (!IS_ERR(opp)) {
+		dev_pm_opp_put(opp);
+		pfdevfreq->boost_freq_khz = cur_freq / HZ_PER_KHZ;
+		ret = dev_pm_qos_add_request(dev, &pfdevfreq->boost_req,
+					     DEV_PM_QOS_MIN_FREQUENCY,
+					     PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE);
+		if (ret < 0)
+			DRM_DEV_INFO(dev, "Couldn't add boost request\n");
+	}
+
 	pfdevfreq->devfreq = devfreq;
 
 	cooling = devfreq_cooling_em_register(devfreq, NULL);
@@ -173,6 +273,12 @@ void panfrost_devfreq_fini(struct panfrost_device *pfdev)
 {
 	struct panfrost_devfreq *pfdevfreq = &pfdev->pfdevfreq;
 
+	if (dev_pm_qos_request_active(&pfdevfreq->boost_req)) {
+		cancel_delayed_work_sync(&pfdevfreq->unboost_work);
+		cancel_work_sync(&pfdevfreq->boost_work);
+		dev_pm_qos_remove_request(&pfdevfreq->boost_req);
+	}
+
 	if (pfdevfreq->cooling) {
 		devfreq_cooling_unregister(pfdevfreq->cooling);
 		pfdevfreq->cooling = NULL;
@@ -232,3 +338,32 @@ void panfrost_devfreq_record_idle(struct panfrost_devfreq *pfdevfreq)
 
 	spin_unlock_irqrestore(&pfdevfreq->lock, irqflags);
 }
+
+void panfrost_devfreq_record_queued(struct panfrost_devfreq *pfdevfreq)
+{
+	atomic_inc(&pfdevfreq->queued);
+}
+
+void panfrost_devfreq_record_dequeued(struct panfrost_devfreq *pfdevfreq)
+{
+	atomic_dec(&pfdevfreq->queued);
+}
+
+/*
+ * simple_ondemand only reacts to busy time once a polling period is over, so
+ * a burst of jobs arriving after an idle period starts at the lowest OPP. Go
+ * straight to the highest one when the queue gets deep instead, and hold it
+ * while the queue stays deep.
+ */
+void panfrost_devfreq_boost_check(struct panfrost_devfreq *pfdevfreq)
+{
+	if (!dev_pm_qos_request_active(&pfdevfreq->boost_req) ||
+	    atomic_read(&pfdevfreq->queued) < BOOST_QUEUE_DEPTH)
+		return;
+
+	mod_delayed_work(system_wq, &pfdevfreq->unboost_work,
+			 msecs_to_jiffies(BOOST_HOLD_MS));
+
+	if (!atomic_xchg(&pfdevfreq->boosted, 1))
+		queue_work(system_highpri_wq, &pfdevfreq->boost_work);
+}
@@ -5,8 +5,10 @@
 #define __PANFROST_DEVFREQ_H__
 
 #include <linux/devfreq.h>
+#include <linux/pm_qos.h>
 #include <linux/spinlock.h>
 #include <linux/ktime.h>
+#include <linux/workqueue.h>
 
 struct devfreq;
 struct thermal_cooling_device;
@@ -23,6 +25,20 @@ struct panfrost_devfreq {
 	ktime_t idle_time;
 	ktime_t time_last_update;
 	int busy_count;
+	/* OPP rate last set, used to estimate GPU cycles from busy time */
+	unsigned long current_frequency;
+
+	/*
+	 * Jobs pushed to the scheduler and not freed yet. When enough of them
+	 * pile up, the minimum frequency is raised to the highest OPP until
+	 * the queue has stayed short for a while.
+	 */
+	atomic_t queued;
+	atomic_t boosted;
+	u32 boost_freq_khz;
+	struct dev_pm_qos_request boost_req;
+	struct work_struct boost_work;
+	struct delayed_work unboost_work;
 	/*
 	 * Protect busy_time, idle_time, time_last_update and busy_count
 	 * because these can be updated concurrently between multiple jobs.
@@ -39,4 +55,8 @@ void panfrost_devfreq_suspend(struct panfrost_device *pfdev);
 void panfrost_devfreq_record_busy(struct panfrost_devfreq *devfreq);
 void panfrost_devfreq_record_idle(struct panfrost_devfreq *devfreq);
 
+void panfrost_devfreq_record_queued(struct panfrost_devfreq *devfreq);
+void panfrost_devfreq_record_dequeued(struct panfrost_devfreq *devfreq);
+void panfrost_devfreq_boost_check(struct panfrost_devfreq *devfreq);
+
 #endif /* __PANFROST_DEVFREQ_H__ */
@@ -74,6 +74,9 @@ struct panfrost_compatible {
 
 	/* Vendor implementation quirks callback */
 	void (*vendor_quirk)(struct panfrost_device *pfdev);
+
+	/* OPP voltages depend on the leakage bin read from the efuse */
+	bool leakage_opp;
 };
 
 struct panfrost_device {
@@ -118,6 +121,13 @@ struct panfrost_device {
 	struct mutex shrinker_lock;
 	struct list_head shrinker_list;
 	struct shrinker shrinker;
+	/* Reclaim statistics, protected by the shrinker_lock */
+	struct {
+		u64 scans;
+		u64 purged_objects;
+		u64 purged_pages;
+		u64 busy;
+	} shrinker_stats;
 
 	struct panfrost_devfreq pfdevfreq;
 };
@@ -134,12 +144,23 @@ struct panfrost_mmu {
 	struct list_head list;
 };
 
+struct panfrost_engine_usage {
+	unsigned long long elapsed_ns[NUM_JOB_SLOTS];
+	unsigned long long cycles[NUM_JOB_SLOTS];
+};
+
 struct panfrost_file_priv {
 	struct panfrost_device *pfdev;
 
 	struct drm_sched_entity sched_entity[NUM_JOB_SLOTS];
 
 	struct panfrost_mmu *mmu;
+
+	/* Unique id reported in fdinfo */
+	u64 client_id;
+
+	/* GPU time used by this file's jobs, protected by the job_lock */
+	struct panfrost_engine_usage engine_usage;
 };
 
 static inline struct panfrost_device *to_panfrost_device(struct drm_device *ddev)
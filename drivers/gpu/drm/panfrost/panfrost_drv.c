@@ -10,6 +10,7 @@
 #include <drm/panfrost_drm.h>
 #include <drm/drm_drv.h>
 #include <drm/drm_ioctl.h>
+#include <drm/drm_print.h>
 #include <drm/drm_syncobj.h>
 #include <drm/drm_utils.h>
 
@@ -23,6 +24,8 @@
 static bool unstable_ioctls;
 module_param_unsafe(unstable_ioctls, bool, 0600);
 
+static atomic64_t client_ids = ATOMIC64_INIT(0);
+
 static int panfrost_ioctl_get_param(struct drm_device *ddev, void *data, struct drm_file *file)
 {
 	struct drm_panfrost_get_param *param = data;
@@ -85,7 +88,8 @@ static int panfrost_ioctl_create_bo(struct drm_device *dev, void *data,
 	int ret;
 
 	if (!args->size || args->pad ||
-	    (args->flags & ~(PANFROST_BO_NOEXEC | PANFROST_BO_HEAP)))
+	    (args->flags & ~(PANFROST_BO_NOEXEC | PANFROST_BO_HEAP |
+			     PANFROST_BO_HEAP_PREFAULT)))
 		return -EINVAL;
 
 	/* Heaps should never be executable */
@@ -93,6 +97,10 @@ static int panfrost_ioctl_create_bo(struct drm_device *dev, void *data,
 	    !(args->flags & PANFROST_BO_NOEXEC))
 		return -EINVAL;
 
+	if ((args->flags & PANFROST_BO_HEAP_PREFAULT) &&
+	    !(args->flags & PANFROST_BO_HEAP))
+		return -EINVAL;
+
 	bo = panfrost_gem_create(dev, args->size, args->flags);
 	if (IS_ERR(bo))
 		return PTR_ERR(bo);
@@ -118,12 +126,16 @@ static int panfrost_ioctl_create_bo(struct drm_device *dev, void *data,
 	return ret;
 }
 
+#define PANFROST_JD_REQ_MASK (PANFROST_JD_REQ_FS | \
+			      PANFROST_JD_REQ_NO_IMPLICIT_SYNC)
+
 /**
  * panfrost_lookup_bos() - Sets up job->bo[] with the GEM objects
  * referenced by the job.
  * @dev: DRM device
  * @file_priv: DRM file for this fd
- * @args: IOCTL args
+ * @bo_handles: user pointer to the BO handles
+ * @bo_handle_count: number of BO handles
  * @job: job being set up
  *
  * Resolve handles from userspace to BOs and attach them to job.
@@ -134,7 +146,7 @@ static int panfrost_ioctl_create_bo(struct drm_device *dev, void *data,
 static int
 panfrost_lookup_bos(struct drm_device *dev,
 		  struct drm_file *file_priv,
-		  struct drm_panfrost_submit *args,
+		  u64 bo_handles, u32 bo_handle_count,
 		  struct panfrost_job *job)
 {
 	struct panfrost_file_priv *priv = file_priv->driver_priv;
@@ -142,13 +154,13 @@ panfrost_lookup_bos(struct drm_device *dev,
 	unsigned int i;
 	int ret;
 
-	job->bo_count = args->bo_handle_count;
+	job->bo_count = bo_handle_count;
 
 	if (!job->bo_count)
 		return 0;
 
 	ret = drm_gem_objects_lookup(file_priv,
-				     (void __user *)(uintptr_t)args->bo_handles,
+				     (void __user *)(uintptr_t)bo_handles,
 				     job->bo_count, &job->bos);
 	if (ret)
 		return ret;
@@ -171,11 +183,106 @@ panfrost_lookup_bos(struct drm_device *dev,
 
 		atomic_inc(&bo->gpu_usecount);
 		job->mappings[i] = mapping;
+
+		if (bo->heap_prefault)
+			panfrost_mmu_prefault_heap(mapping);
 	}
 
 	return ret;
 }
 
+/**
+ * panfrost_share_bos() - Sets up job->bo[] with the GEM objects of
+ * another job.
+ * @job: job being set up
+ * @from: job whose BOs were resolved by panfrost_lookup_bos()
+ *
+ * Used by batched submissions, where all the jobs reference the same BOs,
+ * to avoid resolving the handles again for every job.
+ */
+static int
+panfrost_share_bos(struct panfrost_job *job, struct panfrost_job *from)
+{
+	struct panfrost_gem_mapping **mappings;
+	struct drm_gem_object **bos;
+	unsigned int i;
+
+	if (!from->bo_count)
+		return 0;
+
+	bos = kvmalloc_array(from->bo_count, sizeof(*bos), GFP_KERNEL);
+	if (!bos)
+		return -ENOMEM;
+
+	mappings = kvmalloc_array(from->bo_count, sizeof(*mappings),
+				  GFP_KERNEL);
+	if (!mappings) {
+		kvfree(bos);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < from->bo_count; i++) {
+		bos[i] = from->bos[i];
+		drm_gem_object_get(bos[i]);
+
+		mappings[i] = from->mappings[i];
+		kref_get(&mappings[i]->refcount);
+		atomic_inc(&mappings[i]->obj->gpu_usecount);
+	}
+
+	job->bos = bos;
+	job->mappings = mappings;
+	job->bo_count = from->bo_count;
+
+	return 0;
+}
+
+static u32 *panfrost_copy_in_sync_handles(u64 in_syncs, u32 in_sync_count)
+{
+	u32 *handles;
+
+	if (!in_sync_count)
+		return NULL;
+
+	handles = kvmalloc_array(in_sync_count, sizeof(u32), GFP_KERNEL);
+	if (!handles) {
+		DRM_DEBUG("Failed to allocate incoming syncobj handles\n");
+		return ERR_PTR(-ENOMEM);
+	}
+
+	if (copy_from_user(handles, (void __user *)(uintptr_t)in_syncs,
+			   in_sync_count * sizeof(u32))) {
+		DRM_DEBUG("Failed to copy in syncobj handles\n");
+		kvfree(handles);
+		return ERR_PTR(-EFAULT);
+	}
+
+	return handles;
+}
+
+static int panfrost_add_in_syncs(struct drm_file *file_priv,
+				 const u32 *handles, u32 in_sync_count,
+				 struct panfrost_job *job)
+{
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < in_sync_count; i++) {
+		struct dma_fence *fence;
+
+		ret = drm_syncobj_find_fence(file_priv, handles[i], 0, 0,
+					     &fence);
+		if (ret)
+			return ret;
+
+		ret = drm_sched_job_add_dependency(&job->base, fence);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 /**
  * panfrost_copy_in_sync() - Sets up job->deps with the sync objects
  * referenced by the job.
@@ -196,62 +303,67 @@ panfrost_copy_in_sync(struct drm_device *dev,
 		  struct panfrost_job *job)
 {
 	u32 *handles;
-	int ret = 0;
-	int i, in_fence_count;
+	int ret;
 
-	in_fence_count = args->in_sync_count;
+	handles = panfrost_copy_in_sync_handles(args->in_syncs,
+						args->in_sync_count);
+	if (IS_ERR_OR_NULL(handles))
+		return PTR_ERR_OR_ZERO(handles);
 
-	if (!in_fence_count)
-		return 0;
+	ret = panfrost_add_in_syncs(file_priv, handles, args->in_sync_count,
+				    job);
 
-	handles = kvmalloc_array(in_fence_count, sizeof(u32), GFP_KERNEL);
-	if (!handles) {
-		ret = -ENOMEM;
-		DRM_DEBUG("Failed to allocate incoming syncobj handles\n");
-		goto fail;
-	}
+	kvfree(handles);
+	return ret;
+}
 
-	if (copy_from_user(handles,
-			   (void __user *)(uintptr_t)args->in_syncs,
-			   in_fence_count * sizeof(u32))) {
-		ret = -EFAULT;
-		DRM_DEBUG("Failed to copy in syncobj handles\n");
-		goto fail;
-	}
+static struct panfrost_job *
+panfrost_job_create(struct drm_device *dev, struct drm_file *file,
+		    u64 jc, u32 requirements)
+{
+	struct panfrost_device *pfdev = dev->dev_private;
+	struct panfrost_file_priv *file_priv = file->driver_priv;
+	struct panfrost_job *job;
+	int ret, slot;
 
-	for (i = 0; i < in_fence_count; i++) {
-		struct dma_fence *fence;
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		return ERR_PTR(-ENOMEM);
 
-		ret = drm_syncobj_find_fence(file_priv, handles[i], 0, 0,
-					     &fence);
-		if (ret)
-			goto fail;
+	kref_init(&job->refcount);
 
-		ret = drm_sched_job_add_dependency(&job->base, fence);
+	job->pfdev = pfdev;
+	job->jc = jc;
+	job->requirements = requirements;
+	job->flush_id = panfrost_gpu_get_latest_flush_id(pfdev);
+	job->mmu = file_priv->mmu;
+	job->engine_usage = &file_priv->engine_usage;
 
-		if (ret)
-			goto fail;
+	slot = panfrost_job_get_slot(job);
+
+	ret = drm_sched_job_init(&job->base,
+				 &file_priv->sched_entity[slot],
+				 NULL);
+	if (ret) {
+		panfrost_job_put(job);
+		return ERR_PTR(ret);
 	}
 
-fail:
-	kvfree(handles);
-	return ret;
+	return job;
 }
 
 static int panfrost_ioctl_submit(struct drm_device *dev, void *data,
 		struct drm_file *file)
 {
-	struct panfrost_device *pfdev = dev->dev_private;
-	struct panfrost_file_priv *file_priv = file->driver_priv;
 	struct drm_panfrost_submit *args = data;
 	struct drm_syncobj *sync_out = NULL;
 	struct panfrost_job *job;
-	int ret = 0, slot;
+	int ret = 0;
 
 	if (!args->jc)
 		return -EINVAL;
 
-	if (args->requirements && args->requirements != PANFROST_JD_REQ_FS)
+	if (args->requirements & ~PANFROST_JD_REQ_MASK)
 		return -EINVAL;
 
 	if (args->out_sync > 0) {
@@ -260,33 +372,18 @@ static int panfrost_ioctl_submit(struct drm_device *dev, void *data,
 			return -ENODEV;
 	}
 
-	job = kzalloc(sizeof(*job), GFP_KERNEL);
-	if (!job) {
-		ret = -ENOMEM;
+	job = panfrost_job_create(dev, file, args->jc, args->requirements);
+	if (IS_ERR(job)) {
+		ret = PTR_ERR(job);
 		goto out_put_syncout;
 	}
 
-	kref_init(&job->refcount);
-
-	job->pfdev = pfdev;
-	job->jc = args->jc;
-	job->requirements = args->requirements;
-	job->flush_id = panfrost_gpu_get_latest_flush_id(pfdev);
-	job->mmu = file_priv->mmu;
-
-	slot = panfrost_job_get_slot(job);
-
-	ret = drm_sched_job_init(&job->base,
-				 &file_priv->sched_entity[slot],
-				 NULL);
-	if (ret)
-		goto out_put_job;
-
 	ret = panfrost_copy_in_sync(dev, file, args, job);
 	if (ret)
 		goto out_cleanup_job;
 
-	ret = panfrost_lookup_bos(dev, file, args, job);
+	ret = panfrost_lookup_bos(dev, file, args->bo_handles,
+				  args->bo_handle_count, job);
 	if (ret)
 		goto out_cleanup_job;
 
@@ -301,7 +398,6 @@ static int panfrost_ioctl_submit(struct drm_device *dev, void *data,
 out_cleanup_job:
 	if (ret)
 		drm_sched_job_cleanup(&job->base);
-out_put_job:
 	panfrost_job_put(job);
 out_put_syncout:
 	if (sync_out)
@@ -310,6 +406,135 @@ static int panfrost_ioctl_submit(struct drm_device *dev, void *data,
 	return ret;
 }
 
+struct panfrost_batch_entry {
+	struct drm_panfrost_batch_job args;
+	struct panfrost_job *job;
+	struct drm_syncobj *sync_out;
+	u32 *in_syncs;
+};
+
+static int panfrost_ioctl_batch_submit(struct drm_device *dev, void *data,
+				       struct drm_file *file)
+{
+	struct drm_panfrost_batch_submit *args = data;
+	struct drm_panfrost_batch_job __user *user_jobs;
+	struct panfrost_batch_entry *entries;
+	struct ww_acquire_ctx acquire_ctx;
+	struct panfrost_job *first;
+	unsigned int i, queued = 0;
+	int ret = 0;
+
+	if (!args->job_count ||
+	    args->job_count > PANFROST_BATCH_SUBMIT_MAX_JOBS)
+		return -EINVAL;
+
+	entries = kcalloc(args->job_count, sizeof(*entries), GFP_KERNEL);
+	if (!entries)
+		return -ENOMEM;
+
+	user_jobs = (void __user *)(uintptr_t)args->jobs;
+
+	/*
+	 * Everything touching user memory is done before the reservations
+	 * are taken: a page fault on a BO mapping would need them too.
+	 */
+	for (i = 0; i < args->job_count; i++) {
+		struct panfrost_batch_entry *e = &entries[i];
+		u32 *handles;
+
+		if (copy_from_user(&e->args, &user_jobs[i], sizeof(e->args))) {
+			ret = -EFAULT;
+			goto out_put;
+		}
+
+		if (!e->args.jc || e->args.pad ||
+		    (e->args.requirements & ~PANFROST_JD_REQ_MASK)) {
+			ret = -EINVAL;
+			goto out_put;
+		}
+
+		if (e->args.out_sync > 0) {
+			e->sync_out = drm_syncobj_find(file, e->args.out_sync);
+			if (!e->sync_out) {
+				ret = -ENODEV;
+				goto out_put;
+			}
+		}
+
+		handles = panfrost_copy_in_sync_handles(e->args.in_syncs,
+							e->args.in_sync_count);
+		if (IS_ERR(handles)) {
+			ret = PTR_ERR(handles);
+			goto out_put;
+		}
+		e->in_syncs = handles;
+
+		e->job = panfrost_job_create(dev, file, e->args.jc,
+					     e->args.requirements);
+		if (IS_ERR(e->job)) {
+			ret = PTR_ERR(e->job);
+			e->job = NULL;
+			goto out_put;
+		}
+
+		if (!i)
+			ret = panfrost_lookup_bos(dev, file, args->bo_handles,
+						  args->bo_handle_count,
+						  e->job);
+		else
+			ret = panfrost_share_bos(e->job, entries[0].job);
+		if (ret)
+			goto out_put;
+	}
+
+	first = entries[0].job;
+	ret = drm_gem_lock_reservations(first->bos, first->bo_count,
+					&acquire_ctx);
+	if (ret)
+		goto out_put;
+
+	/*
+	 * The in_syncs are resolved right before each job is queued, so they
+	 * can name the out_sync of an earlier job of the batch.
+	 */
+	for (; queued < args->job_count; queued++) {
+		struct panfrost_batch_entry *e = &entries[queued];
+
+		ret = panfrost_add_in_syncs(file, e->in_syncs,
+					    e->args.in_sync_count, e->job);
+		if (ret)
+			break;
+
+		ret = panfrost_job_push_locked(e->job);
+		if (ret)
+			break;
+
+		if (e->sync_out)
+			drm_syncobj_replace_fence(e->sync_out,
+						  e->job->render_done_fence);
+	}
+
+	drm_gem_unlock_reservations(first->bos, first->bo_count,
+				    &acquire_ctx);
+
+out_put:
+	for (i = 0; i < args->job_count; i++) {
+		struct panfrost_batch_entry *e = &entries[i];
+
+		if (e->job) {
+			if (i >= queued)
+				drm_sched_job_cleanup(&e->job->base);
+			panfrost_job_put(e->job);
+		}
+		if (e->sync_out)
+			drm_syncobj_put(e->sync_out);
+		kvfree(e->in_syncs);
+	}
+	kfree(entries);
+
+	return ret;
+}
+
 static int
 panfrost_ioctl_wait_bo(struct drm_device *dev, void *data,
 		       struct drm_file *file_priv)
@@ -476,6 +701,7 @@ panfrost_open(struct drm_device *dev, struct drm_file *file)
 		return -ENOMEM;
 
 	panfrost_priv->pfdev = pfdev;
+	panfrost_priv->client_id = atomic64_inc_return(&client_ids);
 	file->driver_priv = panfrost_priv;
 
 	panfrost_priv->mmu = panfrost_mmu_ctx_create(pfdev);
@@ -522,15 +748,70 @@ static const struct drm_ioctl_desc panfrost_drm_driver_ioctls[] = {
 	PANFROST_IOCTL(PERFCNT_ENABLE,	perfcnt_enable,	DRM_RENDER_ALLOW),
 	PANFROST_IOCTL(PERFCNT_DUMP,	perfcnt_dump,	DRM_RENDER_ALLOW),
 	PANFROST_IOCTL(MADVISE,		madvise,	DRM_RENDER_ALLOW),
+	PANFROST_IOCTL(BATCH_SUBMIT,	batch_submit,	DRM_RENDER_ALLOW),
+	PANFROST_IOCTL(PERFCNT_RING,	perfcnt_ring,	DRM_RENDER_ALLOW),
 };
 
-DEFINE_DRM_GEM_FOPS(panfrost_drm_driver_fops);
+static const char * const panfrost_engine_names[NUM_JOB_SLOTS] = {
+	"fragment", "vertex-tiler", "compute",
+};
+
+static void panfrost_show_fdinfo(struct seq_file *m, struct file *f)
+{
+	struct drm_file *file = f->private_data;
+	struct panfrost_file_priv *panfrost_priv = file->driver_priv;
+	struct panfrost_device *pfdev = panfrost_priv->pfdev;
+	unsigned long freq = READ_ONCE(pfdev->pfdevfreq.current_frequency);
+	struct drm_printer p = drm_seq_file_printer(m);
+	struct panfrost_engine_usage usage;
+	struct drm_gem_object *obj;
+	size_t resident = 0;
+	unsigned int i;
+	int id;
+
+	panfrost_job_get_engine_usage(panfrost_priv, &usage);
+
+	drm_printf(&p, "drm-driver:\t%s\n", file->minor->dev->driver->name);
+	drm_printf(&p, "drm-client-id:\t%llu\n", panfrost_priv->client_id);
+
+	/* Compute jobs are never put on JS2 for now, so don't report it */
+	for (i = 0; i < NUM_JOB_SLOTS - 1; i++) {
+		drm_printf(&p, "drm-engine-%s:\t%llu ns\n",
+			   panfrost_engine_names[i], usage.elapsed_ns[i]);
+		drm_printf(&p, "drm-cycles-%s:\t%llu\n",
+			   panfrost_engine_names[i], usage.cycles[i]);
+		drm_printf(&p, "drm-curfreq-%s:\t%lu Hz\n",
+			   panfrost_engine_names[i], freq);
+	}
+
+	spin_lock(&file->table_lock);
+	idr_for_each_entry(&file->object_idr, obj, id)
+		resident += panfrost_gem_rss(obj);
+	spin_unlock(&file->table_lock);
+
+	drm_printf(&p, "drm-memory-resident:\t%zu KiB\n", resident / SZ_1K);
+}
+
+static const struct file_operations panfrost_drm_driver_fops = {
+	.owner = THIS_MODULE,
+	DRM_GEM_FOPS,
+	.show_fdinfo = panfrost_show_fdinfo,
+};
+
+static void panfrost_debugfs_init(struct drm_minor *minor)
+{
+	panfrost_gem_shrinker_debugfs_init(minor);
+	panfrost_mmu_debugfs_init(minor);
+}
 
 /*
  * Panfrost driver version:
  * - 1.0 - initial interface
  * - 1.1 - adds HEAP and NOEXEC flags for CREATE_BO
  * - 1.2 - adds AFBC_FEATURES query
+ * - 1.3 - adds BATCH_SUBMIT and the NO_IMPLICIT_SYNC job requirement
+ * - 1.4 - adds HEAP_PREFAULT flag for CREATE_BO
+ * - 1.5 - adds the unstable PERFCNT_RING ioctl
  */
 static const struct drm_driver panfrost_drm_driver = {
 	.driver_features	= DRIVER_RENDER | DRIVER_GEM | DRIVER_SYNCOBJ,
@@ -539,11 +820,12 @@ static const struct drm_driver panfrost_drm_driver = {
 	.ioctls			= panfrost_drm_driver_ioctls,
 	.num_ioctls		= ARRAY_SIZE(panfrost_drm_driver_ioctls),
 	.fops			= &panfrost_drm_driver_fops,
+	.debugfs_init		= panfrost_debugfs_init,
 	.name			= "panfrost",
 	.desc			= "panfrost DRM",
 	.date			= "20180908",
 	.major			= 1,
-	.minor			= 2,
+	.minor			= 5,
 
 	.gem_create_object	= panfrost_gem_create_object,
 	.prime_handle_to_fd	= drm_gem_prime_handle_to_fd,
@@ -663,6 +945,13 @@ static const struct panfrost_compatible mediatek_mt8183_data = {
 	.pm_domain_names = mediatek_mt8183_pm_domains,
 };
 
+static const struct panfrost_compatible rockchip_rk3399_data = {
+	.num_supplies = ARRAY_SIZE(default_supplies) - 1,
+	.supply_names = default_supplies,
+	.num_pm_domains = 1, /* optional */
+	.leakage_opp = true,
+};
+
 static const struct of_device_id dt_match[] = {
 	/* Set first to probe before the generic compatibles */
 	{ .compatible = "amlogic,meson-gxm-mali",
@@ -681,6 +970,7 @@ static const struct of_device_id dt_match[] = {
 	{ .compatible = "arm,mali-bifrost", .data = &default_data, },
 	{ .compatible = "arm,mali-valhall-jm", .data = &default_data, },
 	{ .compatible = "mediatek,mt8183-mali", .data = &mediatek_mt8183_data },
+	{ .compatible = "rockchip,rk3399-mali", .data = &rockchip_rk3399_data },
 	{}
 };
 MODULE_DEVICE_TABLE(of, dt_match);
@@ -695,6 +985,7 @@ static struct platform_driver panfrost_driver = {
 	.remove		= panfrost_remove,
 	.driver		= {
 		.name	= "panfrost",
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.pm	= &panfrost_pm_ops,
 		.of_match_table = dt_match,
 	},
@@ -251,10 +251,26 @@ panfrost_gem_create(struct drm_device *dev, size_t size, u32 flags)
 	bo = to_panfrost_bo(&shmem->base);
 	bo->noexec = !!(flags & PANFROST_BO_NOEXEC);
 	bo->is_heap = !!(flags & PANFROST_BO_HEAP);
+	bo->heap_prefault = !!(flags & PANFROST_BO_HEAP_PREFAULT);
+	bo->heap_fault_blocks = 1;
 
 	return bo;
 }
 
+/*
+ * Memory backing the BO right now: heap BOs are populated on fault, others
+ * have all their pages once they've been pinned.
+ */
+size_t panfrost_gem_rss(struct drm_gem_object *obj)
+{
+	struct panfrost_gem_object *bo = to_panfrost_bo(obj);
+
+	if (bo->is_heap)
+		return READ_ONCE(bo->heap_rss_size);
+
+	return READ_ONCE(bo->base.pages) ? obj->size : 0;
+}
+
 struct drm_gem_object *
 panfrost_gem_prime_import_sg_table(struct drm_device *dev,
 				   struct dma_buf_attachment *attach,
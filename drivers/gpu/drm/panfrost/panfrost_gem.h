@@ -7,6 +7,7 @@
 #include <drm/drm_gem_shmem_helper.h>
 #include <drm/drm_mm.h>
 
+struct drm_minor;
 struct panfrost_mmu;
 
 struct panfrost_gem_object {
@@ -36,8 +37,15 @@ struct panfrost_gem_object {
 	 */
 	atomic_t gpu_usecount;
 
+	/* 2MB blocks the next heap fault maps, protected by the mappings lock */
+	unsigned int heap_fault_blocks;
+
+	/* Populated size of a heap BO, protected by the pages_lock */
+	size_t heap_rss_size;
+
 	bool noexec		:1;
 	bool is_heap		:1;
+	bool heap_prefault	:1;
 };
 
 struct panfrost_gem_mapping {
@@ -71,6 +79,8 @@ panfrost_gem_prime_import_sg_table(struct drm_device *dev,
 struct panfrost_gem_object *
 panfrost_gem_create(struct drm_device *dev, size_t size, u32 flags);
 
+size_t panfrost_gem_rss(struct drm_gem_object *obj);
+
 int panfrost_gem_open(struct drm_gem_object *obj, struct drm_file *file_priv);
 void panfrost_gem_close(struct drm_gem_object *obj,
 			struct drm_file *file_priv);
@@ -83,5 +93,6 @@ void panfrost_gem_teardown_mappings_locked(struct panfrost_gem_object *bo);
 
 void panfrost_gem_shrinker_init(struct drm_device *dev);
 void panfrost_gem_shrinker_cleanup(struct drm_device *dev);
+void panfrost_gem_shrinker_debugfs_init(struct drm_minor *minor);
 
 #endif /* __PANFROST_GEM_H__ */
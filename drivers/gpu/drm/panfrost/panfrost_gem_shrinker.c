@@ -7,8 +7,11 @@
  */
 
 #include <linux/list.h>
+#include <linux/seq_file.h>
 
+#include <drm/drm_debugfs.h>
 #include <drm/drm_device.h>
+#include <drm/drm_file.h>
 #include <drm/drm_gem_shmem_helper.h>
 
 #include "panfrost_device.h"
@@ -53,6 +56,7 @@ static bool panfrost_gem_purge(struct drm_gem_object *obj)
 
 	panfrost_gem_teardown_mappings_locked(bo);
 	drm_gem_shmem_purge_locked(&bo->base);
+	bo->heap_rss_size = 0;
 	ret = true;
 
 	mutex_unlock(&shmem->pages_lock);
@@ -62,27 +66,88 @@ static bool panfrost_gem_purge(struct drm_gem_object *obj)
 	return ret;
 }
 
+static unsigned long
+panfrost_gem_shrinker_purge_one(struct panfrost_device *pfdev,
+				struct drm_gem_shmem_object *shmem)
+{
+	unsigned long npages = shmem->base.size >> PAGE_SHIFT;
+
+	if (!panfrost_gem_purge(&shmem->base)) {
+		/* Busy or contended, retry it after the others. */
+		list_move_tail(&shmem->madv_list, &pfdev->shrinker_list);
+		pfdev->shrinker_stats.busy++;
+		return 0;
+	}
+
+	list_del_init(&shmem->madv_list);
+	pfdev->shrinker_stats.purged_objects++;
+	pfdev->shrinker_stats.purged_pages += npages;
+
+	return npages;
+}
+
 static unsigned long
 panfrost_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 {
 	struct panfrost_device *pfdev =
 		container_of(shrinker, struct panfrost_device, shrinker);
-	struct drm_gem_shmem_object *shmem, *tmp;
+	struct drm_gem_shmem_object *shmem, *tmp, *last;
 	unsigned long freed = 0;
 
 	if (!mutex_trylock(&pfdev->shrinker_lock))
 		return SHRINK_STOP;
 
+	pfdev->shrinker_stats.scans++;
+
+	if (list_empty(&pfdev->shrinker_list))
+		goto out;
+
+	/*
+	 * The list is kept in madvise order, least recently marked first.
+	 * BOs can only be purged whole, so only take the ones that fit in
+	 * what's left of the request. Busy BOs get moved to the tail, stop
+	 * when reaching the ones moved by this scan.
+	 */
+	last = list_last_entry(&pfdev->shrinker_list,
+			       struct drm_gem_shmem_object, madv_list);
 	list_for_each_entry_safe(shmem, tmp, &pfdev->shrinker_list, madv_list) {
+		bool is_last = shmem == last;
+
 		if (freed >= sc->nr_to_scan)
 			break;
+
 		if (drm_gem_shmem_is_purgeable(shmem) &&
-		    panfrost_gem_purge(&shmem->base)) {
-			freed += shmem->base.size >> PAGE_SHIFT;
-			list_del_init(&shmem->madv_list);
+		    (shmem->base.size >> PAGE_SHIFT) <= sc->nr_to_scan - freed)
+			freed += panfrost_gem_shrinker_purge_one(pfdev, shmem);
+
+		if (is_last)
+			break;
+	}
+
+	/* Nothing small enough, fall back to the oldest BO we can purge. */
+	if (!freed) {
+		last = list_last_entry(&pfdev->shrinker_list,
+				       struct drm_gem_shmem_object, madv_list);
+		list_for_each_entry_safe(shmem, tmp, &pfdev->shrinker_list,
+					 madv_list) {
+			bool is_last = shmem == last;
+
+			if (drm_gem_shmem_is_purgeable(shmem))
+				freed = panfrost_gem_shrinker_purge_one(pfdev,
+									shmem);
+			if (freed || is_last)
+				break;
 		}
 	}
 
+	/*
+	 * Tell the core how much we actually freed when a single BO went
+	 * past the request, so that it doesn't keep asking for more.
+	 */
+	if (freed > sc->nr_to_scan)
+		sc->nr_scanned = freed;
+
+out:
 	mutex_unlock(&pfdev->shrinker_lock);
 
 	if (freed > 0)
@@ -91,6 +156,47 @@ panfrost_gem_shrinker_scan(struct shrinker *shrinker, struct shrink_control *sc)
 	return freed;
 }
 
+static int panfrost_gem_shrinker_debugfs_show(struct seq_file *m, void *data)
+{
+	struct drm_info_node *node = m->private;
+	struct panfrost_device *pfdev = node->minor->dev->dev_private;
+	struct drm_gem_shmem_object *shmem;
+	unsigned long count = 0, pages = 0;
+
+	mutex_lock(&pfdev->shrinker_lock);
+
+	list_for_each_entry(shmem, &pfdev->shrinker_list, madv_list) {
+		if (drm_gem_shmem_is_purgeable(shmem)) {
+			count++;
+			pages += shmem->base.size >> PAGE_SHIFT;
+		}
+	}
+
+	seq_printf(m, "purgeable objects: %lu\n", count);
+	seq_printf(m, "purgeable pages: %lu\n", pages);
+	seq_printf(m, "scans: %llu\n", pfdev->shrinker_stats.scans);
+	seq_printf(m, "purged objects: %llu\n",
+		   pfdev->shrinker_stats.purged_objects);
+	seq_printf(m, "purged pages: %llu\n",
+		   pfdev->shrinker_stats.purged_pages);
+	seq_printf(m, "busy: %llu\n", pfdev->shrinker_stats.busy);
+
+	mutex_unlock(&pfdev->shrinker_lock);
+
+	return 0;
+}
+
+static const struct drm_info_list panfrost_gem_shrinker_debugfs_list[] = {
+	{"gem_shrinker", panfrost_gem_shrinker_debugfs_show, 0},
+};
+
+void panfrost_gem_shrinker_debugfs_init(struct drm_minor *minor)
+{
+	drm_debugfs_create_files(panfrost_gem_shrinker_debugfs_list,
+				 ARRAY_SIZE(panfrost_gem_shrinker_debugfs_list),
+				 minor->debugfs_root, minor);
+}
+
 /**
  * panfrost_gem_shrinker_init - Initialize panfrost shrinker
  * @dev: DRM device
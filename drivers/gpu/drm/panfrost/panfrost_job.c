@@ -5,6 +5,7 @@
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/iopoll.h>
+#include <linux/math64.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
 #include <linux/dma-resv.h>
@@ -21,6 +22,7 @@
 #include "panfrost_gpu.h"
 #include "panfrost_mmu.h"
 #include "panfrost_dump.h"
+#include "panfrost_perfcnt.h"
 
 #define JOB_TIMEOUT_MS 500
 
@@ -31,6 +33,8 @@ struct panfrost_queue_state {
 	struct drm_gpu_scheduler sched;
 	u64 fence_context;
 	u64 emit_seqno;
+	/* Completion time of the last job, protected by the job_lock */
+	ktime_t last_done;
 };
 
 struct panfrost_job_slot {
@@ -231,6 +235,7 @@ static void panfrost_job_hw_submit(struct panfrost_job *job, int js)
 
 	spin_lock(&pfdev->js->job_lock);
 	subslot = panfrost_enqueue_job(pfdev, js, job);
+	job->start_time = ktime_get();
 	/* Don't queue the job if a reset is in progress */
 	if (!atomic_read(&pfdev->reset.pending)) {
 		job_write(pfdev, JS_COMMAND_NEXT(js), JS_COMMAND_START);
@@ -243,7 +248,8 @@ static void panfrost_job_hw_submit(struct panfrost_job *job, int js)
 
 static int panfrost_acquire_object_fences(struct drm_gem_object **bos,
 					  int bo_count,
-					  struct drm_sched_job *job)
+					  struct drm_sched_job *job,
+					  bool implicit_sync)
 {
 	int i, ret;
 
@@ -252,6 +258,9 @@ static int panfrost_acquire_object_fences(struct drm_gem_object **bos,
 		if (ret)
 			return ret;
 
+		if (!implicit_sync)
+			continue;
+
 		/* panfrost always uses write mode in its current uapi */
 		ret = drm_sched_job_add_implicit_dependencies(job, bos[i],
 							      true);
@@ -272,16 +281,19 @@ static void panfrost_attach_object_fences(struct drm_gem_object **bos,
 		dma_resv_add_fence(bos[i]->resv, fence, DMA_RESV_USAGE_WRITE);
 }
 
-int panfrost_job_push(struct panfrost_job *job)
+/**
+ * panfrost_job_push_locked() - Queue a job to the scheduler
+ * @job: job to queue
+ *
+ * The caller holds the reservations of job->bos, which lets a batch of jobs
+ * sharing the same BOs take them only once.
+ */
+int panfrost_job_push_locked(struct panfrost_job *job)
 {
 	struct panfrost_device *pfdev = job->pfdev;
-	struct ww_acquire_ctx acquire_ctx;
-	int ret = 0;
-
-	ret = drm_gem_lock_reservations(job->bos, job->bo_count,
-					    &acquire_ctx);
-	if (ret)
-		return ret;
+	bool implicit_sync = !(job->requirements &
+			       PANFROST_JD_REQ_NO_IMPLICIT_SYNC);
+	int ret;
 
 	mutex_lock(&pfdev->sched_lock);
 	drm_sched_job_arm(&job->base);
@@ -289,14 +301,15 @@ int panfrost_job_push(struct panfrost_job *job)
 	job->render_done_fence = dma_fence_get(&job->base.s_fence->finished);
 
 	ret = panfrost_acquire_object_fences(job->bos, job->bo_count,
-					     &job->base);
+					     &job->base, implicit_sync);
 	if (ret) {
 		mutex_unlock(&pfdev->sched_lock);
-		goto unlock;
+		return ret;
 	}
 
 	kref_get(&job->refcount); /* put by scheduler job completion */
 
+	panfrost_devfreq_record_queued(&pfdev->pfdevfreq);
 	drm_sched_entity_push_job(&job->base);
 
 	mutex_unlock(&pfdev->sched_lock);
@@ -304,7 +317,21 @@ int panfrost_job_push(struct panfrost_job *job)
 	panfrost_attach_object_fences(job->bos, job->bo_count,
 				      job->render_done_fence);
 
-unlock:
+	return 0;
+}
+
+int panfrost_job_push(struct panfrost_job *job)
+{
+	struct ww_acquire_ctx acquire_ctx;
+	int ret = 0;
+
+	ret = drm_gem_lock_reservations(job->bos, job->bo_count,
+					    &acquire_ctx);
+	if (ret)
+		return ret;
+
+	ret = panfrost_job_push_locked(job);
+
 	drm_gem_unlock_reservations(job->bos, job->bo_count, &acquire_ctx);
 
 	return ret;
@@ -349,6 +376,7 @@ static void panfrost_job_free(struct drm_sched_job *sched_job)
 {
 	struct panfrost_job *job = to_panfrost_job(sched_job);
 
+	panfrost_devfreq_record_dequeued(&job->pfdev->pfdevfreq);
 	drm_sched_job_cleanup(sched_job);
 
 	panfrost_job_put(job);
@@ -378,6 +406,7 @@ static struct dma_fence *panfrost_job_run(struct drm_sched_job *sched_job)
 		dma_fence_put(job->done_fence);
 	job->done_fence = dma_fence_get(fence);
 
+	panfrost_devfreq_boost_check(&pfdev->pfdevfreq);
 	panfrost_job_hw_submit(job, slot);
 
 	return fence;
@@ -396,6 +425,31 @@ void panfrost_job_enable_interrupts(struct panfrost_device *pfdev)
 	job_write(pfdev, JOB_INT_MASK, irq_mask);
 }
 
+/*
+ * Charge the time a job spent on the GPU to its file. A job queued in the
+ * second subslot only starts once the one before it is done, hence the
+ * last_done clamp.
+ */
+static void panfrost_job_account(struct panfrost_device *pfdev,
+				 struct panfrost_job *job, unsigned int js)
+{
+	struct panfrost_queue_state *queue = &pfdev->js->queue[js];
+	ktime_t now = ktime_get();
+	ktime_t start = max(job->start_time, queue->last_done);
+	u64 elapsed = ktime_to_ns(ktime_sub(now, start));
+
+	queue->last_done = now;
+
+	if (!job->engine_usage)
+		return;
+
+	job->engine_usage->elapsed_ns[js] += elapsed;
+	job->engine_usage->cycles[js] +=
+		mul_u64_u64_div_u64(elapsed,
+				    READ_ONCE(pfdev->pfdevfreq.current_frequency),
+				    NSEC_PER_SEC);
+}
+
 static void panfrost_job_handle_err(struct panfrost_device *pfdev,
 				    struct panfrost_job *job,
 				    unsigned int js)
@@ -436,6 +490,7 @@ static void panfrost_job_handle_err(struct panfrost_device *pfdev,
 		job->jc = 0;
 	}
 
+	panfrost_job_account(pfdev, job, js);
 	panfrost_mmu_as_put(pfdev, job->mmu);
 	panfrost_devfreq_record_idle(&pfdev->pfdevfreq);
 
@@ -457,11 +512,14 @@ static void panfrost_job_handle_done(struct panfrost_device *pfdev,
 	 * happen when we receive the DONE interrupt while doing a GPU reset).
 	 */
 	job->jc = 0;
+	panfrost_job_account(pfdev, job, panfrost_job_get_slot(job));
 	panfrost_mmu_as_put(pfdev, job->mmu);
 	panfrost_devfreq_record_idle(&pfdev->pfdevfreq);
 
 	dma_fence_signal_locked(job->done_fence);
 	pm_runtime_put_autosuspend(pfdev->dev);
+
+	panfrost_perfcnt_job_done(pfdev);
 }
 
 static void panfrost_job_handle_irq(struct panfrost_device *pfdev, u32 status)
@@ -910,11 +968,24 @@ void panfrost_job_close(struct panfrost_file_priv *panfrost_priv)
 			}
 
 			job_write(pfdev, JS_COMMAND(i), cmd);
+
+			/* The job may complete after the file is gone */
+			job->engine_usage = NULL;
 		}
 	}
 	spin_unlock(&pfdev->js->job_lock);
 }
 
+void panfrost_job_get_engine_usage(struct panfrost_file_priv *panfrost_priv,
+				   struct panfrost_engine_usage *usage)
+{
+	struct panfrost_device *pfdev = panfrost_priv->pfdev;
+
+	spin_lock(&pfdev->js->job_lock);
+	*usage = panfrost_priv->engine_usage;
+	spin_unlock(&pfdev->js->job_lock);
+}
+
 int panfrost_job_is_idle(struct panfrost_device *pfdev)
 {
 	struct panfrost_job_slot *js = pfdev->js;
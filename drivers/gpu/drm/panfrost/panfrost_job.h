@@ -32,6 +32,10 @@ struct panfrost_job {
 
 	/* Fence to be signaled by drm-sched once its done with the job */
 	struct dma_fence *render_done_fence;
+
+	/* Where the GPU time is accounted, NULL once the file is closed */
+	struct panfrost_engine_usage *engine_usage;
+	ktime_t start_time;
 };
 
 int panfrost_job_init(struct panfrost_device *pfdev);
@@ -40,8 +44,11 @@ int panfrost_job_open(struct panfrost_file_priv *panfrost_priv);
 void panfrost_job_close(struct panfrost_file_priv *panfrost_priv);
 int panfrost_job_get_slot(struct panfrost_job *job);
 int panfrost_job_push(struct panfrost_job *job);
+int panfrost_job_push_locked(struct panfrost_job *job);
 void panfrost_job_put(struct panfrost_job *job);
 void panfrost_job_enable_interrupts(struct panfrost_device *pfdev);
 int panfrost_job_is_idle(struct panfrost_device *pfdev);
+void panfrost_job_get_engine_usage(struct panfrost_file_priv *panfrost_priv,
+				   struct panfrost_engine_usage *usage);
 
 #endif
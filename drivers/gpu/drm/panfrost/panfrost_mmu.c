@@ -1,6 +1,9 @@
 // SPDX-License-Identifier: GPL-2.0
 /* Copyright 2019 Linaro, Ltd, Rob Herring <robh@kernel.org> */
 
+#include <drm/drm_debugfs.h>
+#include <drm/drm_file.h>
+#include <drm/drm_print.h>
 #include <drm/panfrost_drm.h>
 
 #include <linux/atomic.h>
@@ -436,34 +439,30 @@ addr_to_mapping(struct panfrost_device *pfdev, int as, u64 addr)
 
 #define NUM_FAULT_PAGES (SZ_2M / PAGE_SIZE)
 
-static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
-				       u64 addr)
+/* Upper bound on how much of a heap BO a single fault maps */
+#define MAX_FAULT_BLOCKS (SZ_16M / SZ_2M)
+
+/*
+ * Map the 2MB block of a heap BO starting at page_offset. Nothing is done if
+ * the block is already mapped; on failure the block is left unpopulated so
+ * that a later fault can retry it.
+ *
+ * Must be called with the BO's mappings lock held, so that the prefault done
+ * at submit time and the fault handler don't populate the same block, or
+ * unwind it, under each other.
+ */
+static int panfrost_mmu_map_heap_block(struct panfrost_device *pfdev,
+				       struct panfrost_gem_mapping *bomapping,
+				       pgoff_t page_offset)
 {
-	int ret, i;
-	struct panfrost_gem_mapping *bomapping;
-	struct panfrost_gem_object *bo;
+	struct panfrost_gem_object *bo = bomapping->obj;
 	struct address_space *mapping;
-	pgoff_t page_offset;
 	struct sg_table *sgt;
 	struct page **pages;
+	u64 addr;
+	int ret, i;
 
-	bomapping = addr_to_mapping(pfdev, as, addr);
-	if (!bomapping)
-		return -ENOENT;
-
-	bo = bomapping->obj;
-	if (!bo->is_heap) {
-		dev_WARN(pfdev->dev, "matching BO is not heap type (GPU VA = %llx)",
-			 bomapping->mmnode.start << PAGE_SHIFT);
-		ret = -EINVAL;
-		goto err_bo;
-	}
-	WARN_ON(bomapping->mmu->as != as);
-
-	/* Assume 2MB alignment and size multiple */
-	addr &= ~((u64)SZ_2M - 1);
-	page_offset = addr >> PAGE_SHIFT;
-	page_offset -= bomapping->mmnode.start;
+	lockdep_assert_held(&bo->mappings.lock);
 
 	mutex_lock(&bo->base.pages_lock);
 
@@ -472,8 +471,7 @@ static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
 				     sizeof(struct sg_table), GFP_KERNEL | __GFP_ZERO);
 		if (!bo->sgts) {
 			mutex_unlock(&bo->base.pages_lock);
-			ret = -ENOMEM;
-			goto err_bo;
+			return -ENOMEM;
 		}
 
 		pages = kvmalloc_array(bo->base.base.size >> PAGE_SHIFT,
@@ -482,8 +480,7 @@ static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
 			kvfree(bo->sgts);
 			bo->sgts = NULL;
 			mutex_unlock(&bo->base.pages_lock);
-			ret = -ENOMEM;
-			goto err_bo;
+			return -ENOMEM;
 		}
 		bo->base.pages = pages;
 		bo->base.pages_use_count = 1;
@@ -492,7 +489,7 @@ static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
 		if (pages[page_offset]) {
 			/* Pages are already mapped, bail out. */
 			mutex_unlock(&bo->base.pages_lock);
-			goto out;
+			return 0;
 		}
 	}
 
@@ -509,9 +506,10 @@ static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
 		}
 	}
 
+	bo->heap_rss_size += SZ_2M;
 	mutex_unlock(&bo->base.pages_lock);
 
-	sgt = &bo->sgts[page_offset / (SZ_2M / PAGE_SIZE)];
+	sgt = &bo->sgts[page_offset / NUM_FAULT_PAGES];
 	ret = sg_alloc_table_from_pages(sgt, pages + page_offset,
 					NUM_FAULT_PAGES, 0, SZ_2M, GFP_KERNEL);
 	if (ret)
@@ -521,27 +519,115 @@ static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
 	if (ret)
 		goto err_map;
 
+	addr = (u64)(bomapping->mmnode.start + page_offset) << PAGE_SHIFT;
 	mmu_map_sg(pfdev, bomapping->mmu, addr,
 		   IOMMU_WRITE | IOMMU_READ | IOMMU_NOEXEC, sgt);
 
 	bomapping->active = true;
 
-	dev_dbg(pfdev->dev, "mapped page fault @ AS%d %llx", as, addr);
-
-out:
-	panfrost_gem_mapping_put(bomapping);
-
 	return 0;
 
 err_map:
 	sg_free_table(sgt);
 err_pages:
-	drm_gem_shmem_put_pages(&bo->base);
-err_bo:
+	mutex_lock(&bo->base.pages_lock);
+	for (i = page_offset; i < page_offset + NUM_FAULT_PAGES && pages[i]; i++) {
+		put_page(pages[i]);
+		pages[i] = NULL;
+	}
+	/* The whole block had been read in and accounted */
+	if (i == page_offset + NUM_FAULT_PAGES)
+		bo->heap_rss_size -= SZ_2M;
+	mutex_unlock(&bo->base.pages_lock);
+	return ret;
+}
+
+static int panfrost_mmu_map_fault_addr(struct panfrost_device *pfdev, int as,
+				       u64 addr)
+{
+	struct panfrost_gem_mapping *bomapping;
+	struct panfrost_gem_object *bo;
+	unsigned int blocks, i;
+	pgoff_t page_offset, nr_pages;
+	int ret;
+
+	bomapping = addr_to_mapping(pfdev, as, addr);
+	if (!bomapping)
+		return -ENOENT;
+
+	bo = bomapping->obj;
+	if (!bo->is_heap) {
+		dev_WARN(pfdev->dev, "matching BO is not heap type (GPU VA = %llx)",
+			 bomapping->mmnode.start << PAGE_SHIFT);
+		ret = -EINVAL;
+		goto out;
+	}
+	WARN_ON(bomapping->mmu->as != as);
+
+	/* Assume 2MB alignment and size multiple */
+	addr &= ~((u64)SZ_2M - 1);
+	page_offset = addr >> PAGE_SHIFT;
+	page_offset -= bomapping->mmnode.start;
+
+	mutex_lock(&bo->mappings.lock);
+
+	ret = panfrost_mmu_map_heap_block(pfdev, bomapping, page_offset);
+	if (ret)
+		goto out_unlock;
+
+	/*
+	 * The tiler fills its heap linearly, so a fault is almost always
+	 * followed by one on the next block. Map ahead of the faulting block,
+	 * twice as far after each fault on the same BO, to cut the number of
+	 * fault round trips. Failing to map ahead isn't fatal, the GPU will
+	 * just fault again.
+	 */
+	blocks = bo->heap_fault_blocks;
+	nr_pages = bo->base.base.size >> PAGE_SHIFT;
+	for (i = 1; i < blocks; i++) {
+		pgoff_t offset = page_offset + i * NUM_FAULT_PAGES;
+
+		if (offset >= nr_pages ||
+		    panfrost_mmu_map_heap_block(pfdev, bomapping, offset))
+			break;
+	}
+	bo->heap_fault_blocks = min_t(unsigned int, blocks * 2,
+				      MAX_FAULT_BLOCKS);
+
+	dev_dbg(pfdev->dev, "mapped page fault @ AS%d %llx (%u blocks)",
+		as, addr, i);
+
+out_unlock:
+	mutex_unlock(&bo->mappings.lock);
+out:
 	panfrost_gem_mapping_put(bomapping);
 	return ret;
 }
 
+/**
+ * panfrost_mmu_prefault_heap() - Map the start of a heap BO ahead of use
+ * @mapping: heap BO mapping about to be used by a job
+ *
+ * Maps as much of the heap as the next fault on it would, so that a job
+ * doesn't have to take a fault before the tiler gets going.
+ */
+void panfrost_mmu_prefault_heap(struct panfrost_gem_mapping *mapping)
+{
+	struct panfrost_gem_object *bo = mapping->obj;
+	struct panfrost_device *pfdev = to_panfrost_device(bo->base.base.dev);
+	unsigned int blocks, i;
+
+	mutex_lock(&bo->mappings.lock);
+	blocks = min_t(unsigned int, bo->heap_fault_blocks,
+		       bo->base.base.size / SZ_2M);
+	for (i = 0; i < blocks; i++) {
+		if (panfrost_mmu_map_heap_block(pfdev, mapping,
+						i * NUM_FAULT_PAGES))
+			break;
+	}
+	mutex_unlock(&bo->mappings.lock);
+}
+
 static void panfrost_mmu_release_ctx(struct kref *kref)
 {
 	struct panfrost_mmu *mmu = container_of(kref, struct panfrost_mmu,
@@ -643,6 +729,42 @@ struct panfrost_mmu *panfrost_mmu_ctx_create(struct panfrost_device *pfdev)
 	return mmu;
 }
 
+static int panfrost_mmu_va_debugfs_show(struct seq_file *m, void *data)
+{
+	struct drm_info_node *node = m->private;
+	struct drm_device *ddev = node->minor->dev;
+	struct drm_printer p = drm_seq_file_printer(m);
+	struct drm_file *file;
+
+	mutex_lock(&ddev->filelist_mutex);
+
+	list_for_each_entry_reverse(file, &ddev->filelist, lhead) {
+		struct panfrost_file_priv *priv = file->driver_priv;
+		struct panfrost_mmu *mmu = priv->mmu;
+
+		drm_printf(&p, "client %llu:\n", priv->client_id);
+
+		spin_lock(&mmu->mm_lock);
+		drm_mm_print_stats(&mmu->mm, &p);
+		spin_unlock(&mmu->mm_lock);
+	}
+
+	mutex_unlock(&ddev->filelist_mutex);
+
+	return 0;
+}
+
+static const struct drm_info_list panfrost_mmu_debugfs_list[] = {
+	{"gpu_va", panfrost_mmu_va_debugfs_show, 0},
+};
+
+void panfrost_mmu_debugfs_init(struct drm_minor *minor)
+{
+	drm_debugfs_create_files(panfrost_mmu_debugfs_list,
+				 ARRAY_SIZE(panfrost_mmu_debugfs_list),
+				 minor->debugfs_root, minor);
+}
+
 static const char *access_type_name(struct panfrost_device *pfdev,
 		u32 fault_status)
 {
@@ -7,6 +7,7 @@
 #include <linux/pm_runtime.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/workqueue.h>
 
 #include <drm/drm_file.h>
 #include <drm/drm_gem_shmem_helper.h>
@@ -26,13 +27,32 @@
 #define BLOCKS_PER_COREGROUP		8
 #define V4_SHADERS_PER_COREGROUP	4
 
+/* GPU_PERFCNT_BASE must be 2KB aligned */
+#define RING_SAMPLE_ALIGN		SZ_2K
+
 struct panfrost_perfcnt {
+	struct panfrost_device *pfdev;
 	struct panfrost_gem_mapping *mapping;
 	size_t bosize;
 	void *buf;
 	struct panfrost_file_priv *user;
+	unsigned int counterset;
 	struct mutex lock;
 	struct completion dump_comp;
+
+	/* Continuous sampling, the ring is active when ring.mapping is set */
+	struct {
+		struct panfrost_gem_mapping *mapping;
+		void *buf;
+		u32 nr_samples;
+		u32 stride;
+		u32 slot;
+		u64 head;
+		unsigned long period;
+		bool sample_jobs;
+		struct delayed_work timer_work;
+		struct work_struct job_work;
+	} ring;
 };
 
 void panfrost_perfcnt_clean_cache_done(struct panfrost_device *pfdev)
@@ -45,13 +65,12 @@ void panfrost_perfcnt_sample_done(struct panfrost_device *pfdev)
 	gpu_write(pfdev, GPU_CMD, GPU_CMD_CLEAN_CACHES);
 }
 
-static int panfrost_perfcnt_dump_locked(struct panfrost_device *pfdev)
+static int panfrost_perfcnt_dump_locked(struct panfrost_device *pfdev,
+					u64 gpuva)
 {
-	u64 gpuva;
 	int ret;
 
 	reinit_completion(&pfdev->perfcnt->dump_comp);
-	gpuva = pfdev->perfcnt->mapping->mmnode.start << PAGE_SHIFT;
 	gpu_write(pfdev, GPU_PERFCNT_BASE_LO, lower_32_bits(gpuva));
 	gpu_write(pfdev, GPU_PERFCNT_BASE_HI, upper_32_bits(gpuva));
 	gpu_write(pfdev, GPU_INT_CLEAR,
@@ -79,8 +98,9 @@ static int panfrost_perfcnt_enable_locked(struct panfrost_device *pfdev,
 	u32 cfg, as;
 	int ret;
 
+	/* Already enabled, possibly through the other ioctl */
 	if (user == perfcnt->user)
-		return 0;
+		return counterset == perfcnt->counterset ? 0 : -EINVAL;
 	else if (perfcnt->user)
 		return -EBUSY;
 
@@ -129,6 +149,7 @@ static int panfrost_perfcnt_enable_locked(struct panfrost_device *pfdev,
 	}
 
 	perfcnt->user = user;
+	perfcnt->counterset = counterset;
 
 	as = panfrost_mmu_as_get(pfdev, perfcnt->mapping->mmu);
 	cfg = GPU_PERFCNT_CFG_AS(as) |
@@ -177,6 +198,171 @@ static int panfrost_perfcnt_enable_locked(struct panfrost_device *pfdev,
 	return ret;
 }
 
+static void panfrost_perfcnt_ring_sample_locked(struct panfrost_perfcnt *perfcnt,
+						u32 reason)
+{
+	struct drm_panfrost_perfcnt_ring_header *header = perfcnt->ring.buf;
+	struct drm_panfrost_perfcnt_sample_info *info;
+	u32 offset;
+	u64 gpuva;
+
+	offset = RING_SAMPLE_ALIGN + perfcnt->ring.slot * perfcnt->ring.stride;
+	gpuva = (perfcnt->ring.mapping->mmnode.start << PAGE_SHIFT) + offset;
+
+	if (panfrost_perfcnt_dump_locked(perfcnt->pfdev, gpuva))
+		return;
+
+	info = perfcnt->ring.buf + offset + perfcnt->bosize;
+	info->timestamp_ns = ktime_get_ns();
+	info->seqno = perfcnt->ring.head;
+	info->reason = reason;
+
+	/* Only publish the sample once it's been fully written. */
+	smp_wmb();
+	WRITE_ONCE(header->head, ++perfcnt->ring.head);
+
+	if (++perfcnt->ring.slot == perfcnt->ring.nr_samples)
+		perfcnt->ring.slot = 0;
+}
+
+static void panfrost_perfcnt_ring_timer_work(struct work_struct *work)
+{
+	struct panfrost_perfcnt *perfcnt =
+		container_of(to_delayed_work(work), struct panfrost_perfcnt,
+			     ring.timer_work);
+
+	mutex_lock(&perfcnt->lock);
+	if (perfcnt->ring.mapping && perfcnt->ring.period) {
+		panfrost_perfcnt_ring_sample_locked(perfcnt,
+						    PANFROST_PERFCNT_SAMPLE_TIMER);
+		schedule_delayed_work(&perfcnt->ring.timer_work,
+				      perfcnt->ring.period);
+	}
+	mutex_unlock(&perfcnt->lock);
+}
+
+static void panfrost_perfcnt_ring_job_work(struct work_struct *work)
+{
+	struct panfrost_perfcnt *perfcnt =
+		container_of(work, struct panfrost_perfcnt, ring.job_work);
+
+	mutex_lock(&perfcnt->lock);
+	if (perfcnt->ring.mapping && perfcnt->ring.sample_jobs)
+		panfrost_perfcnt_ring_sample_locked(perfcnt,
+						    PANFROST_PERFCNT_SAMPLE_JOB);
+	mutex_unlock(&perfcnt->lock);
+}
+
+/*
+ * Called from the job IRQ handler. Completions that happen while a sample
+ * is pending are folded into it, so sampling never holds back the jobs.
+ */
+void panfrost_perfcnt_job_done(struct panfrost_device *pfdev)
+{
+	struct panfrost_perfcnt *perfcnt = pfdev->perfcnt;
+
+	if (READ_ONCE(perfcnt->ring.sample_jobs))
+		schedule_work(&perfcnt->ring.job_work);
+}
+
+static int panfrost_perfcnt_ring_start_locked(struct panfrost_device *pfdev,
+					      struct drm_file *file_priv,
+					      struct drm_panfrost_perfcnt_ring *req)
+{
+	struct panfrost_file_priv *user = file_priv->driver_priv;
+	struct panfrost_perfcnt *perfcnt = pfdev->perfcnt;
+	struct drm_panfrost_perfcnt_ring_header *header;
+	struct drm_gem_shmem_object *bo;
+	struct iosys_map map;
+	u32 stride;
+	int ret;
+
+	if (perfcnt->ring.mapping)
+		return -EBUSY;
+
+	stride = ALIGN(perfcnt->bosize +
+		       sizeof(struct drm_panfrost_perfcnt_sample_info),
+		       RING_SAMPLE_ALIGN);
+
+	bo = drm_gem_shmem_create(pfdev->ddev, RING_SAMPLE_ALIGN +
+				  (size_t)req->nr_samples * stride);
+	if (IS_ERR(bo))
+		return PTR_ERR(bo);
+
+	/* The handle maps the ring in the address space of file_priv. */
+	ret = drm_gem_handle_create(file_priv, &bo->base, &req->handle);
+	if (ret)
+		goto out_put_bo;
+
+	perfcnt->ring.mapping =
+		panfrost_gem_mapping_get(to_panfrost_bo(&bo->base), user);
+	if (!perfcnt->ring.mapping) {
+		ret = -EINVAL;
+		goto out_delete_handle;
+	}
+
+	ret = drm_gem_shmem_vmap(bo, &map);
+	if (ret) {
+		panfrost_gem_mapping_put(perfcnt->ring.mapping);
+		perfcnt->ring.mapping = NULL;
+		goto out_delete_handle;
+	}
+
+	header = map.vaddr;
+	header->head = 0;
+	header->nr_samples = req->nr_samples;
+	header->sample_offset = RING_SAMPLE_ALIGN;
+	header->sample_stride = stride;
+	header->counters_size = perfcnt->bosize;
+
+	perfcnt->ring.buf = map.vaddr;
+	perfcnt->ring.nr_samples = req->nr_samples;
+	perfcnt->ring.stride = stride;
+	perfcnt->ring.slot = 0;
+	perfcnt->ring.head = 0;
+	perfcnt->ring.period = usecs_to_jiffies(req->period_us);
+	WRITE_ONCE(perfcnt->ring.sample_jobs,
+		   !!(req->flags & PANFROST_PERFCNT_RING_SAMPLE_JOBS));
+
+	if (perfcnt->ring.period)
+		schedule_delayed_work(&perfcnt->ring.timer_work,
+				      perfcnt->ring.period);
+
+	/* The BO ref is retained by the handle and the mapping. */
+	drm_gem_object_put(&bo->base);
+
+	return 0;
+
+out_delete_handle:
+	drm_gem_handle_delete(file_priv, req->handle);
+out_put_bo:
+	drm_gem_object_put(&bo->base);
+	return ret;
+}
+
+/*
+ * The sampling works can't be waited for here since they take the perfcnt
+ * lock, but they do nothing once the ring is gone.
+ */
+static void panfrost_perfcnt_ring_stop_locked(struct panfrost_device *pfdev)
+{
+	struct panfrost_perfcnt *perfcnt = pfdev->perfcnt;
+	struct iosys_map map = IOSYS_MAP_INIT_VADDR(perfcnt->ring.buf);
+
+	if (!perfcnt->ring.mapping)
+		return;
+
+	WRITE_ONCE(perfcnt->ring.sample_jobs, false);
+	perfcnt->ring.period = 0;
+	cancel_delayed_work(&perfcnt->ring.timer_work);
+	cancel_work(&perfcnt->ring.job_work);
+
+	drm_gem_shmem_vunmap(&perfcnt->ring.mapping->obj->base, &map);
+	perfcnt->ring.buf = NULL;
+	panfrost_gem_mapping_put(perfcnt->ring.mapping);
+	perfcnt->ring.mapping = NULL;
+}
+
 static int panfrost_perfcnt_disable_locked(struct panfrost_device *pfdev,
 					   struct drm_file *file_priv)
 {
@@ -187,6 +373,8 @@ static int panfrost_perfcnt_disable_locked(struct panfrost_device *pfdev,
 	if (user != perfcnt->user)
 		return -EINVAL;
 
+	panfrost_perfcnt_ring_stop_locked(pfdev);
+
 	gpu_write(pfdev, GPU_PRFCNT_JM_EN, 0x0);
 	gpu_write(pfdev, GPU_PRFCNT_SHADER_EN, 0x0);
 	gpu_write(pfdev, GPU_PRFCNT_MMU_L2_EN, 0x0);
@@ -253,7 +441,8 @@ int panfrost_ioctl_perfcnt_dump(struct drm_device *dev, void *data,
 		goto out;
 	}
 
-	ret = panfrost_perfcnt_dump_locked(pfdev);
+	ret = panfrost_perfcnt_dump_locked(pfdev, perfcnt->mapping->mmnode.start <<
+						  PAGE_SHIFT);
 	if (ret)
 		goto out;
 
@@ -266,6 +455,56 @@ int panfrost_ioctl_perfcnt_dump(struct drm_device *dev, void *data,
 	return ret;
 }
 
+int panfrost_ioctl_perfcnt_ring(struct drm_device *dev, void *data,
+				struct drm_file *file_priv)
+{
+	struct panfrost_device *pfdev = dev->dev_private;
+	struct panfrost_perfcnt *perfcnt = pfdev->perfcnt;
+	struct drm_panfrost_perfcnt_ring *req = data;
+	bool enabled;
+	int ret;
+
+	ret = panfrost_unstable_ioctl_check();
+	if (ret)
+		return ret;
+
+	if (req->enable > 1)
+		return -EINVAL;
+
+	if (!req->enable) {
+		mutex_lock(&perfcnt->lock);
+		if (perfcnt->user == file_priv->driver_priv)
+			panfrost_perfcnt_ring_stop_locked(pfdev);
+		else
+			ret = -EINVAL;
+		mutex_unlock(&perfcnt->lock);
+		return ret;
+	}
+
+	if (req->counterset > (panfrost_model_is_bifrost(pfdev) ? 1 : 0))
+		return -EINVAL;
+
+	if (!req->nr_samples ||
+	    req->nr_samples > PANFROST_PERFCNT_RING_MAX_SAMPLES ||
+	    (req->flags & ~PANFROST_PERFCNT_RING_SAMPLE_JOBS) ||
+	    (req->period_us && req->period_us < USEC_PER_MSEC) ||
+	    (!req->period_us && !req->flags))
+		return -EINVAL;
+
+	mutex_lock(&perfcnt->lock);
+	enabled = perfcnt->user == file_priv->driver_priv;
+	ret = panfrost_perfcnt_enable_locked(pfdev, file_priv,
+					     req->counterset);
+	if (!ret) {
+		ret = panfrost_perfcnt_ring_start_locked(pfdev, file_priv, req);
+		if (ret && !enabled)
+			panfrost_perfcnt_disable_locked(pfdev, file_priv);
+	}
+	mutex_unlock(&perfcnt->lock);
+
+	return ret;
+}
+
 void panfrost_perfcnt_close(struct drm_file *file_priv)
 {
 	struct panfrost_file_priv *pfile = file_priv->driver_priv;
@@ -320,7 +559,11 @@ int panfrost_perfcnt_init(struct panfrost_device *pfdev)
 	if (!perfcnt)
 		return -ENOMEM;
 
+	perfcnt->pfdev = pfdev;
 	perfcnt->bosize = size;
+	INIT_DELAYED_WORK(&perfcnt->ring.timer_work,
+			  panfrost_perfcnt_ring_timer_work);
+	INIT_WORK(&perfcnt->ring.job_work, panfrost_perfcnt_ring_job_work);
 
 	/* Start with everything disabled. */
 	gpu_write(pfdev, GPU_PERFCNT_CFG,
@@ -339,6 +582,9 @@ int panfrost_perfcnt_init(struct panfrost_device *pfdev)
 
 void panfrost_perfcnt_fini(struct panfrost_device *pfdev)
 {
+	cancel_delayed_work_sync(&pfdev->perfcnt->ring.timer_work);
+	cancel_work_sync(&pfdev->perfcnt->ring.job_work);
+
 	/* Disable everything before leaving. */
 	gpu_write(pfdev, GPU_PERFCNT_CFG,
 		  GPU_PERFCNT_CFG_MODE(GPU_PERFCNT_CFG_MODE_OFF));
@@ -7,6 +7,7 @@
 
 void panfrost_perfcnt_sample_done(struct panfrost_device *pfdev);
 void panfrost_perfcnt_clean_cache_done(struct panfrost_device *pfdev);
+void panfrost_perfcnt_job_done(struct panfrost_device *pfdev);
 int panfrost_perfcnt_init(struct panfrost_device *pfdev);
 void panfrost_perfcnt_fini(struct panfrost_device *pfdev);
 void panfrost_perfcnt_close(struct drm_file *file_priv);
@@ -14,5 +15,7 @@ int panfrost_ioctl_perfcnt_enable(struct drm_device *dev, void *data,
 				  struct drm_file *file_priv);
 int panfrost_ioctl_perfcnt_dump(struct drm_device *dev, void *data,
 				struct drm_file *file_priv);
+int panfrost_ioctl_perfcnt_ring(struct drm_device *dev, void *data,
+				struct drm_file *file_priv);
 
 #endif
@@ -6,6 +6,7 @@
 
 #include <linux/clk.h>
 #include <linux/component.h>
+#include <linux/crc32.h>
 #include <linux/extcon.h>
 #include <linux/firmware.h>
 #include <linux/mfd/syscon.h>
@@ -425,7 +426,9 @@ static int cdn_dp_enable_phy(struct cdn_dp_device *dp, struct cdn_dp_port *port)
 	}
 
 	port->lanes = cdn_dp_get_port_lanes(port);
-	ret = cdn_dp_set_host_cap(dp, port->lanes, property.intval);
+	port->flip = property.intval;
+	ret = cdn_dp_set_host_cap(dp, CDN_DP_MAX_LINK_RATE, port->lanes,
+				  port->flip, false);
 	if (ret) {
 		DRM_DEV_ERROR(dp->dev, "set host capabilities failed: %d\n",
 			      ret);
@@ -574,6 +577,130 @@ static void cdn_dp_encoder_mode_set(struct drm_encoder *encoder,
 	drm_mode_copy(&dp->mode, adjusted);
 }
 
+static u32 cdn_dp_edid_crc(struct cdn_dp_device *dp)
+{
+	if (!dp->edid)
+		return 0;
+
+	return crc32_le(~0, (const u8 *)dp->edid,
+			EDID_LENGTH * (dp->edid->extensions + 1));
+}
+
+static struct cdn_dp_link_cache *
+cdn_dp_link_cache_find(struct cdn_dp_device *dp, u32 crc)
+{
+	int i;
+
+	for (i = 0; i < CDN_DP_LINK_CACHE_SIZE; i++) {
+		struct cdn_dp_link_cache *entry = &dp->link_cache[i];
+
+		if (entry->edid_crc != crc)
+			continue;
+
+		if (time_after(jiffies, entry->expires)) {
+			entry->edid_crc = 0;
+			return NULL;
+		}
+
+		return entry;
+	}
+
+	return NULL;
+}
+
+/* Forget the link training result of the current sink */
+static void cdn_dp_link_cache_drop(struct cdn_dp_device *dp)
+{
+	struct cdn_dp_link_cache *entry;
+	u32 crc = cdn_dp_edid_crc(dp);
+
+	if (!crc)
+		return;
+
+	entry = cdn_dp_link_cache_find(dp, crc);
+	if (entry)
+		entry->edid_crc = 0;
+}
+
+/*
+ * Full link training tries every rate and lane count down from the maximum
+ * and takes a good part of a second with some sinks, most of it spent on
+ * the way down when the cable or dock can't do the highest rate. For a
+ * sink we trained before, identified by its EDID, first ask the firmware
+ * for the rate and lane count that worked last time, with fast link
+ * training if the sink supports it. Only if that fails do the full
+ * training.
+ *
+ * The result is kept across unplugs, since re-plugging the same dock is
+ * the case this is for. A result that had to fall back may be down to a
+ * transient error though, so it expires after CDN_DP_LINK_CACHE_EXPIRY
+ * and the next hot-plug or re-train checks again whether the link can do
+ * better. Using a cached result doesn't extend its lifetime.
+ */
+static int cdn_dp_train_link_cached(struct cdn_dp_device *dp)
+{
+	struct cdn_dp_port *port = dp->port[dp->active_port];
+	struct cdn_dp_link_cache *entry = NULL;
+	u32 crc = cdn_dp_edid_crc(dp);
+	unsigned int max_rate, max_lanes;
+	bool fast_lt;
+	int ret;
+
+	max_rate = min(drm_dp_max_link_rate(dp->dpcd),
+		       drm_dp_bw_code_to_link_rate(CDN_DP_MAX_LINK_RATE));
+	max_lanes = min_t(unsigned int, drm_dp_max_lane_count(dp->dpcd),
+			  port->lanes);
+
+	if (crc)
+		entry = cdn_dp_link_cache_find(dp, crc);
+
+	/* The sink or the port may not do as much anymore */
+	if (entry && (drm_dp_bw_code_to_link_rate(entry->rate) > max_rate ||
+		      entry->lanes > max_lanes)) {
+		entry->edid_crc = 0;
+		entry = NULL;
+	}
+
+	if (entry) {
+		fast_lt = dp->dpcd[DP_MAX_DOWNSPREAD] &
+			  DP_NO_AUX_HANDSHAKE_LINK_TRAINING;
+
+		ret = cdn_dp_set_host_cap(dp, entry->rate, entry->lanes,
+					  port->flip, fast_lt);
+		if (!ret)
+			ret = cdn_dp_train_link(dp);
+		if (!ret)
+			return 0;
+
+		DRM_DEV_DEBUG_KMS(dp->dev,
+				  "cached link config failed, full training\n");
+		entry->edid_crc = 0;
+	}
+
+	/* A cached result used earlier may have lowered the host caps */
+	ret = cdn_dp_set_host_cap(dp, CDN_DP_MAX_LINK_RATE, port->lanes,
+				  port->flip, false);
+	if (ret)
+		return ret;
+
+	ret = cdn_dp_train_link(dp);
+	if (ret || !crc)
+		return ret;
+
+	if (!entry) {
+		entry = &dp->link_cache[dp->link_cache_next];
+		dp->link_cache_next = (dp->link_cache_next + 1) %
+				      CDN_DP_LINK_CACHE_SIZE;
+	}
+
+	entry->edid_crc = crc;
+	entry->rate = drm_dp_link_rate_to_bw_code(dp->max_rate);
+	entry->lanes = dp->max_lanes;
+	entry->expires = jiffies + CDN_DP_LINK_CACHE_EXPIRY;
+
+	return 0;
+}
+
 static bool cdn_dp_check_link_status(struct cdn_dp_device *dp)
 {
 	u8 link_status[DP_LINK_STATUS_SIZE];
@@ -631,7 +758,7 @@ static void cdn_dp_encoder_enable(struct drm_encoder *encoder)
 		goto out;
 	}
 	if (!cdn_dp_check_link_status(dp)) {
-		ret = cdn_dp_train_link(dp);
+		ret = cdn_dp_train_link_cached(dp);
 		if (ret) {
 			DRM_DEV_ERROR(dp->dev, "Failed link train %d\n", ret);
 			goto out;
@@ -647,6 +774,7 @@ static void cdn_dp_encoder_enable(struct drm_encoder *encoder)
 	ret = cdn_dp_config_video(dp);
 	if (ret) {
 		DRM_DEV_ERROR(dp->dev, "Failed to config video %d\n", ret);
+		cdn_dp_link_cache_drop(dp);
 		goto out;
 	}
 
@@ -990,7 +1118,7 @@ static void cdn_dp_pd_event_work(struct work_struct *work)
 		struct drm_display_mode *mode = &dp->mode;
 
 		DRM_DEV_INFO(dp->dev, "Connected with sink. Re-train link\n");
-		ret = cdn_dp_train_link(dp);
+		ret = cdn_dp_train_link_cached(dp);
 		if (ret) {
 			dp->connected = false;
 			DRM_DEV_ERROR(dp->dev, "Train link failed %d\n", ret);
@@ -1002,6 +1130,7 @@ static void cdn_dp_pd_event_work(struct work_struct *work)
 		    (rate != dp->max_rate || lanes != dp->max_lanes)) {
 			ret = cdn_dp_config_video(dp);
 			if (ret) {
+				cdn_dp_link_cache_drop(dp);
 				dp->connected = false;
 				DRM_DEV_ERROR(dp->dev,
 					      "Failed to config video %d\n",
@@ -58,10 +58,23 @@ struct cdn_dp_port {
 	struct extcon_dev *extcon;
 	struct phy *phy;
 	u8 lanes;
+	bool flip;
 	bool phy_enabled;
 	u8 id;
 };
 
+/* Number of sinks whose link training result is remembered */
+#define CDN_DP_LINK_CACHE_SIZE	4
+/* After this long a sink is fully trained again, in case it can do better */
+#define CDN_DP_LINK_CACHE_EXPIRY	(10 * 60 * HZ)
+
+struct cdn_dp_link_cache {
+	u32 edid_crc;	/* 0 if the entry is unused */
+	u8 rate;	/* link bw code */
+	u8 lanes;
+	unsigned long expires;	/* jiffies */
+};
+
 struct cdn_dp_device {
 	struct device *dev;
 	struct drm_device *drm_dev;
@@ -103,6 +116,9 @@ struct cdn_dp_device {
 	u8 dpcd[DP_RECEIVER_CAP_SIZE];
 	bool sink_has_audio;
 
+	struct cdn_dp_link_cache link_cache[CDN_DP_LINK_CACHE_SIZE];
+	unsigned int link_cache_next;
+
 	hdmi_codec_plugged_cb plugged_cb;
 	struct device *codec_dev;
 };
@@ -354,17 +354,18 @@ int cdn_dp_set_firmware_active(struct cdn_dp_device *dp, bool enable)
 	return ret;
 }
 
-int cdn_dp_set_host_cap(struct cdn_dp_device *dp, u8 lanes, bool flip)
+int cdn_dp_set_host_cap(struct cdn_dp_device *dp, u8 rate, u8 lanes,
+			bool flip, bool fast_lt)
 {
 	u8 msg[8];
 	int ret;
 
-	msg[0] = CDN_DP_MAX_LINK_RATE;
+	msg[0] = rate;
 	msg[1] = lanes | SCRAMBLER_EN;
 	msg[2] = VOLTAGE_LEVEL_2;
 	msg[3] = PRE_EMPHASIS_LEVEL_3;
 	msg[4] = PTS1 | PTS2 | PTS3 | PTS4;
-	msg[5] = FAST_LT_NOT_SUPPORT;
+	msg[5] = fast_lt ? FAST_LT_SUPPORT : FAST_LT_NOT_SUPPORT;
 	msg[6] = flip ? LANE_MAPPING_FLIPPED : LANE_MAPPING_NORMAL;
 	msg[7] = ENHANCED;
 
@@ -75,6 +75,7 @@ struct rockchip_hdmi {
 	struct rockchip_encoder encoder;
 	const struct rockchip_hdmi_chip_data *chip_data;
 	struct clk *ref_clk;
+	bool ref_clk_enabled;
 	struct clk *grf_clk;
 	struct dw_hdmi *hdmi;
 	struct regulator *avdd_0v9;
@@ -262,6 +263,18 @@ dw_hdmi_rockchip_mode_valid(struct dw_hdmi *hdmi, void *data,
 
 static void dw_hdmi_rockchip_encoder_disable(struct drm_encoder *encoder)
 {
+	struct rockchip_hdmi *hdmi = to_rockchip_hdmi(encoder);
+
+	/*
+	 * The bridge has powered the PHY down at this point. Only the
+	 * controller registers and the CEC engine are still in use, and they
+	 * don't run from the reference clock, so drop it while the display is
+	 * off.
+	 */
+	if (hdmi->ref_clk_enabled) {
+		clk_disable_unprepare(hdmi->ref_clk);
+		hdmi->ref_clk_enabled = false;
+	}
 }
 
 static bool
@@ -287,6 +300,15 @@ static void dw_hdmi_rockchip_encoder_enable(struct drm_encoder *encoder)
 	u32 val;
 	int ret;
 
+	if (!hdmi->ref_clk_enabled) {
+		ret = clk_prepare_enable(hdmi->ref_clk);
+		if (ret)
+			DRM_DEV_ERROR(hdmi->dev,
+				      "Failed to enable HDMI reference clock: %d\n", ret);
+		else
+			hdmi->ref_clk_enabled = true;
+	}
+
 	if (hdmi->chip_data->lcdsel_grf_reg < 0)
 		return;
 
@@ -596,6 +618,7 @@ static int dw_hdmi_rockchip_bind(struct device *dev, struct device *master,
 			      ret);
 		goto err_clk;
 	}
+	hdmi->ref_clk_enabled = true;
 
 	if (hdmi->chip_data == &rk3568_chip_data) {
 		regmap_write(hdmi->regmap, RK3568_GRF_VO_CON1,
@@ -641,7 +664,8 @@ static void dw_hdmi_rockchip_unbind(struct device *dev, struct device *master,
 
 	dw_hdmi_unbind(hdmi->hdmi);
 	drm_encoder_cleanup(&hdmi->encoder.encoder);
-	clk_disable_unprepare(hdmi->ref_clk);
+	if (hdmi->ref_clk_enabled)
+		clk_disable_unprepare(hdmi->ref_clk);
 
 	regulator_disable(hdmi->avdd_1v8);
 	regulator_disable(hdmi->avdd_0v9);
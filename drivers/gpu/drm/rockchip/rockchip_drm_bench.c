@@ -0,0 +1,353 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Microbenchmarks for the buffer paths used by the Rockchip DRM driver
+ *
+ * Reading one of the bench_* debugfs files of the DRM minor runs the
+ * benchmark over a sweep of buffer sizes and prints the percentiles
+ * of the time one operation takes:
+ *
+ *  - bench_iommu: iommu_map_sgtable() and iommu_unmap() in the DRM domain
+ *  - bench_gem: rockchip_gem_create_object() and freeing the object
+ *  - bench_dma: a memcpy on any DMA_MEMCPY capable dmaengine channel
+ *    (the PL330 on RK3399), waited for by polling
+ *
+ * The number of runs per size is set with the iterations module
+ * parameter.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/iommu.h>
+#include <linux/module.h>
+#include <linux/scatterlist.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/timekeeping.h>
+
+#include <drm/drm_debugfs.h>
+#include <drm/drm_device.h>
+#include <drm/drm_file.h>
+#include <drm/drm_gem.h>
+
+#include "rockchip_drm_drv.h"
+#include "rockchip_drm_gem.h"
+
+#define BENCH_MAX_ITERATIONS	10000U
+#define BENCH_MAX_SIZE		SZ_4M
+
+static unsigned int iterations = 100;
+module_param(iterations, uint, 0644);
+MODULE_PARM_DESC(iterations, "Runs per buffer size of the debugfs benchmarks");
+
+static const size_t bench_sizes[] = {
+	SZ_4K, SZ_16K, SZ_64K, SZ_256K, SZ_1M, SZ_4M,
+};
+
+struct bench_samples {
+	unsigned int count;
+	u64 *ns;
+};
+
+static int bench_samples_init(struct bench_samples *s, unsigned int count)
+{
+	s->count = 0;
+	s->ns = kvmalloc_array(count, sizeof(*s->ns), GFP_KERNEL);
+
+	return s->ns ? 0 : -ENOMEM;
+}
+
+static void bench_samples_fini(struct bench_samples *s)
+{
+	kvfree(s->ns);
+}
+
+static int bench_cmp_u64(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void bench_print_header(struct seq_file *m)
+{
+	seq_printf(m, "%-8s %-8s %10s %10s %10s %10s %10s\n", "op", "size",
+		   "min ns", "p50 ns", "p90 ns", "p99 ns", "max ns");
+}
+
+static void bench_print(struct seq_file *m, const char *op, size_t size,
+			struct bench_samples *s)
+{
+	u64 *ns = s->ns;
+	unsigned int n = s->count;
+
+	if (!n) {
+		seq_printf(m, "%-8s %-8zu failed\n", op, size);
+		return;
+	}
+
+	sort(ns, n, sizeof(*ns), bench_cmp_u64, NULL);
+
+	seq_printf(m, "%-8s %-8zu %10llu %10llu %10llu %10llu %10llu\n",
+		   op, size, ns[0], ns[n * 50 / 100], ns[n * 90 / 100],
+		   ns[n * 99 / 100], ns[n - 1]);
+}
+
+static unsigned int bench_iterations(void)
+{
+	return clamp(READ_ONCE(iterations), 1U, BENCH_MAX_ITERATIONS);
+}
+
+static int bench_iommu_show(struct seq_file *m, void *unused)
+{
+	struct drm_info_node *node = m->private;
+	struct rockchip_drm_private *private = node->minor->dev->dev_private;
+	unsigned int n = bench_iterations();
+	struct bench_samples map, unmap;
+	struct drm_mm_node mm = {};
+	struct sg_table sgt;
+	struct page **pages;
+	unsigned int npages = BENCH_MAX_SIZE >> PAGE_SHIFT;
+	int prot = IOMMU_READ | IOMMU_WRITE;
+	unsigned int i, j;
+	int ret;
+
+	if (!private->domain) {
+		seq_puts(m, "no IOMMU domain\n");
+		return 0;
+	}
+
+	pages = kvcalloc(npages, sizeof(*pages), GFP_KERNEL);
+	if (!pages)
+		return -ENOMEM;
+
+	for (i = 0; i < npages; i++) {
+		pages[i] = alloc_page(GFP_KERNEL);
+		if (!pages[i]) {
+			ret = -ENOMEM;
+			goto out_free_pages;
+		}
+	}
+
+	ret = bench_samples_init(&map, n);
+	if (ret)
+		goto out_free_pages;
+
+	ret = bench_samples_init(&unmap, n);
+	if (ret)
+		goto out_fini_map;
+
+	mutex_lock(&private->mm_lock);
+	ret = drm_mm_insert_node_generic(&private->mm, &mm, BENCH_MAX_SIZE,
+					 PAGE_SIZE, 0, 0);
+	mutex_unlock(&private->mm_lock);
+	if (ret)
+		goto out_fini_unmap;
+
+	bench_print_header(m);
+
+	for (i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+		size_t size = bench_sizes[i];
+
+		ret = sg_alloc_table_from_pages(&sgt, pages, size >> PAGE_SHIFT,
+						0, size, GFP_KERNEL);
+		if (ret)
+			break;
+
+		map.count = 0;
+		unmap.count = 0;
+
+		for (j = 0; j < n; j++) {
+			u64 t0, t1, t2;
+			ssize_t mapped;
+
+			t0 = ktime_get_ns();
+			mapped = iommu_map_sgtable(private->domain, mm.start,
+						   &sgt, prot);
+			t1 = ktime_get_ns();
+			if (mapped < (ssize_t)size) {
+				if (mapped > 0)
+					iommu_unmap(private->domain, mm.start,
+						    mapped);
+				break;
+			}
+			iommu_unmap(private->domain, mm.start, size);
+			t2 = ktime_get_ns();
+
+			map.ns[map.count++] = t1 - t0;
+			unmap.ns[unmap.count++] = t2 - t1;
+
+			cond_resched();
+		}
+
+		sg_free_table(&sgt);
+
+		bench_print(m, "map", size, &map);
+		bench_print(m, "unmap", size, &unmap);
+	}
+
+	mutex_lock(&private->mm_lock);
+	drm_mm_remove_node(&mm);
+	mutex_unlock(&private->mm_lock);
+
+out_fini_unmap:
+	bench_samples_fini(&unmap);
+out_fini_map:
+	bench_samples_fini(&map);
+out_free_pages:
+	for (i = 0; i < npages && pages[i]; i++)
+		__free_page(pages[i]);
+	kvfree(pages);
+
+	return ret;
+}
+
+static int bench_gem_show(struct seq_file *m, void *unused)
+{
+	struct drm_info_node *node = m->private;
+	struct drm_device *drm = node->minor->dev;
+	unsigned int n = bench_iterations();
+	struct bench_samples create, destroy;
+	unsigned int i, j;
+	int ret;
+
+	ret = bench_samples_init(&create, n);
+	if (ret)
+		return ret;
+
+	ret = bench_samples_init(&destroy, n);
+	if (ret)
+		goto out_fini_create;
+
+	bench_print_header(m);
+
+	for (i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+		size_t size = bench_sizes[i];
+
+		create.count = 0;
+		destroy.count = 0;
+
+		for (j = 0; j < n; j++) {
+			struct rockchip_gem_object *rk_obj;
+			u64 t0, t1, t2;
+
+			t0 = ktime_get_ns();
+			rk_obj = rockchip_gem_create_object(drm, size, false);
+			t1 = ktime_get_ns();
+			if (IS_ERR(rk_obj))
+				break;
+			drm_gem_object_put(&rk_obj->base);
+			t2 = ktime_get_ns();
+
+			create.ns[create.count++] = t1 - t0;
+			destroy.ns[destroy.count++] = t2 - t1;
+
+			cond_resched();
+		}
+
+		bench_print(m, "create", size, &create);
+		bench_print(m, "free", size, &destroy);
+	}
+
+	bench_samples_fini(&destroy);
+out_fini_create:
+	bench_samples_fini(&create);
+
+	return ret;
+}
+
+static int bench_dma_show(struct seq_file *m, void *unused)
+{
+	unsigned int n = bench_iterations();
+	struct bench_samples copy;
+	dma_addr_t src_dma, dst_dma;
+	struct dma_chan *chan;
+	struct device *dev;
+	void *src, *dst;
+	dma_cap_mask_t mask;
+	unsigned int i, j;
+	int ret;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_MEMCPY, mask);
+	chan = dma_request_chan_by_mask(&mask);
+	if (IS_ERR(chan)) {
+		seq_puts(m, "no memcpy channel\n");
+		return 0;
+	}
+
+	dev = chan->device->dev;
+
+	ret = -ENOMEM;
+	src = dma_alloc_coherent(dev, BENCH_MAX_SIZE, &src_dma, GFP_KERNEL);
+	if (!src)
+		goto out_release;
+
+	dst = dma_alloc_coherent(dev, BENCH_MAX_SIZE, &dst_dma, GFP_KERNEL);
+	if (!dst)
+		goto out_free_src;
+
+	ret = bench_samples_init(&copy, n);
+	if (ret)
+		goto out_free_dst;
+
+	seq_printf(m, "channel %s\n", dma_chan_name(chan));
+	bench_print_header(m);
+
+	for (i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+		size_t size = bench_sizes[i];
+
+		copy.count = 0;
+
+		for (j = 0; j < n; j++) {
+			struct dma_async_tx_descriptor *tx;
+			dma_cookie_t cookie;
+			u64 t0, t1;
+
+			t0 = ktime_get_ns();
+			tx = dmaengine_prep_dma_memcpy(chan, dst_dma, src_dma,
+						       size, DMA_CTRL_ACK);
+			if (!tx)
+				break;
+
+			cookie = dmaengine_submit(tx);
+			dma_async_issue_pending(chan);
+			if (dma_sync_wait(chan, cookie) != DMA_COMPLETE) {
+				dmaengine_terminate_sync(chan);
+				break;
+			}
+			t1 = ktime_get_ns();
+
+			copy.ns[copy.count++] = t1 - t0;
+
+			cond_resched();
+		}
+
+		bench_print(m, "memcpy", size, &copy);
+	}
+
+	bench_samples_fini(&copy);
+out_free_dst:
+	dma_free_coherent(dev, BENCH_MAX_SIZE, dst, dst_dma);
+out_free_src:
+	dma_free_coherent(dev, BENCH_MAX_SIZE, src, src_dma);
+out_release:
+	dma_release_channel(chan);
+
+	return ret;
+}
+
+static const struct drm_info_list rockchip_drm_bench_list[] = {
+	{ "bench_iommu", bench_iommu_show, 0 },
+	{ "bench_gem", bench_gem_show, 0 },
+	{ "bench_dma", bench_dma_show, 0 },
+};
+
+void rockchip_drm_bench_debugfs_init(struct drm_minor *minor)
+{
+	drm_debugfs_create_files(rockchip_drm_bench_list,
+				 ARRAY_SIZE(rockchip_drm_bench_list),
+				 minor->debugfs_root, minor);
+}
@@ -102,6 +102,7 @@ static int rockchip_drm_init_iommu(struct drm_device *drm_dev)
 	struct rockchip_drm_private *private = drm_dev->dev_private;
 	struct iommu_domain_geometry *geometry;
 	u64 start, end;
+	int ret;
 
 	if (IS_ERR_OR_NULL(private->iommu_dev))
 		return 0;
@@ -119,7 +120,14 @@ static int rockchip_drm_init_iommu(struct drm_device *drm_dev)
 	drm_mm_init(&private->mm, start, end - start + 1);
 	mutex_init(&private->mm_lock);
 
-	return 0;
+	ret = rockchip_gem_import_cache_init(drm_dev);
+	if (ret) {
+		drm_mm_takedown(&private->mm);
+		iommu_domain_free(private->domain);
+		private->domain = NULL;
+	}
+
+	return ret;
 }
 
 static void rockchip_iommu_cleanup(struct drm_device *drm_dev)
@@ -129,6 +137,7 @@ static void rockchip_iommu_cleanup(struct drm_device *drm_dev)
 	if (!private->domain)
 		return;
 
+	rockchip_gem_import_cache_fini(drm_dev);
 	drm_mm_takedown(&private->mm);
 	iommu_domain_free(private->domain);
 }
@@ -226,8 +235,12 @@ static const struct drm_driver rockchip_drm_driver = {
 	.dumb_create		= rockchip_gem_dumb_create,
 	.prime_handle_to_fd	= drm_gem_prime_handle_to_fd,
 	.prime_fd_to_handle	= drm_gem_prime_fd_to_handle,
+	.gem_prime_import	= rockchip_gem_prime_import,
 	.gem_prime_import_sg_table	= rockchip_gem_prime_import_sg_table,
 	.gem_prime_mmap		= drm_gem_prime_mmap,
+#if IS_ENABLED(CONFIG_ROCKCHIP_DRM_BENCH)
+	.debugfs_init		= rockchip_drm_bench_debugfs_init,
+#endif
 	.fops			= &rockchip_drm_driver_fops,
 	.name	= DRIVER_NAME,
 	.desc	= DRIVER_DESC,
@@ -15,6 +15,7 @@
 
 #include <linux/module.h>
 #include <linux/component.h>
+#include <linux/shrinker.h>
 
 #define ROCKCHIP_MAX_FB_BUFFER	3
 #define ROCKCHIP_MAX_CONNECTOR	2
@@ -22,6 +23,7 @@
 
 struct drm_device;
 struct drm_connector;
+struct drm_minor;
 struct iommu_domain;
 
 struct rockchip_crtc_state {
@@ -43,13 +45,19 @@ struct rockchip_crtc_state {
  *
  * @crtc: array of enabled CRTCs, used to map from "pipe" to drm_crtc.
  * @num_pipe: number of pipes for this device.
- * @mm_lock: protect drm_mm on multi-threads.
+ * @mm_lock: protect drm_mm and the import cache on multi-threads.
+ * @import_cache: IOMMU mappings of released imports, most recent first.
+ * @import_cache_count: number of entries in @import_cache.
+ * @import_shrinker: releases @import_cache entries under memory pressure.
  */
 struct rockchip_drm_private {
 	struct iommu_domain *domain;
 	struct device *iommu_dev;
 	struct mutex mm_lock;
 	struct drm_mm mm;
+	struct list_head import_cache;
+	unsigned int import_cache_count;
+	struct shrinker import_shrinker;
 };
 
 struct rockchip_encoder {
@@ -67,6 +75,7 @@ int rockchip_drm_wait_vact_end(struct drm_crtc *crtc, unsigned int mstimeout);
 int rockchip_drm_encoder_set_crtc_endpoint_id(struct rockchip_encoder *rencoder,
 					      struct device_node *np, int port, int reg);
 int rockchip_drm_endpoint_is_subdriver(struct device_node *ep);
+void rockchip_drm_bench_debugfs_init(struct drm_minor *minor);
 extern struct platform_driver cdn_dp_driver;
 extern struct platform_driver dw_hdmi_rockchip_pltfm_driver;
 extern struct platform_driver dw_mipi_dsi_rockchip_driver;
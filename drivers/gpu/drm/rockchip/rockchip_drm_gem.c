@@ -6,6 +6,7 @@
 
 #include <linux/dma-buf.h>
 #include <linux/iommu.h>
+#include <linux/shrinker.h>
 #include <linux/vmalloc.h>
 
 #include <drm/drm.h>
@@ -74,6 +75,201 @@ static int rockchip_gem_iommu_unmap(struct rockchip_gem_object *rk_obj)
 	return 0;
 }
 
+/*
+ * Imported buffers are typically recycled from a small pool (decoder
+ * output, GPU swapchain), and userspace tends to import them again for
+ * every frame. Instead of tearing down the attachment and IOMMU mapping
+ * when the GEM object goes away, park them here so that the next import
+ * of the same dma-buf only needs a new GEM object.
+ *
+ * A parked entry keeps its dma-buf, and so the exporter's memory, alive.
+ * Entries are dropped once nobody else holds the dma-buf at the next
+ * release, and a shrinker gives them all back under memory pressure,
+ * oldest first, in case no release comes along.
+ */
+#define ROCKCHIP_GEM_IMPORT_CACHE_MAX	16
+
+struct rockchip_gem_import {
+	struct list_head node;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	struct drm_mm_node mm;
+	size_t size;
+};
+
+static void rockchip_gem_import_free(struct rockchip_gem_import *import)
+{
+	struct dma_buf *dma_buf = import->attach->dmabuf;
+
+	dma_buf_unmap_attachment(import->attach, import->sgt,
+				 DMA_BIDIRECTIONAL);
+	dma_buf_detach(dma_buf, import->attach);
+	dma_buf_put(dma_buf);
+	kfree(import);
+}
+
+static void rockchip_gem_import_release(struct rockchip_drm_private *private,
+					struct rockchip_gem_import *import)
+{
+	iommu_unmap(private->domain, import->mm.start, import->size);
+
+	mutex_lock(&private->mm_lock);
+	drm_mm_remove_node(&import->mm);
+	mutex_unlock(&private->mm_lock);
+
+	rockchip_gem_import_free(import);
+}
+
+/*
+ * Move out entries whose dma-buf is only kept alive by the cache, as
+ * nobody can import those again, and the oldest ones above the limit.
+ */
+static void
+rockchip_gem_import_cache_trim_locked(struct rockchip_drm_private *private,
+				      struct list_head *evict)
+{
+	struct rockchip_gem_import *import, *tmp;
+
+	list_for_each_entry_safe_reverse(import, tmp, &private->import_cache,
+					 node) {
+		if (file_count(import->attach->dmabuf->file) > 1 &&
+		    private->import_cache_count <= ROCKCHIP_GEM_IMPORT_CACHE_MAX)
+			continue;
+
+		list_move(&import->node, evict);
+		private->import_cache_count--;
+	}
+}
+
+static bool rockchip_gem_import_cache_put(struct rockchip_gem_object *rk_obj)
+{
+	struct drm_gem_object *obj = &rk_obj->base;
+	struct rockchip_drm_private *private = obj->dev->dev_private;
+	struct rockchip_gem_import *import, *tmp;
+	LIST_HEAD(evict);
+
+	import = kzalloc(sizeof(*import), GFP_KERNEL);
+	if (!import)
+		return false;
+
+	import->attach = obj->import_attach;
+	import->sgt = rk_obj->sgt;
+	import->size = rk_obj->size;
+
+	mutex_lock(&private->mm_lock);
+	drm_mm_replace_node(&rk_obj->mm, &import->mm);
+	list_add(&import->node, &private->import_cache);
+	private->import_cache_count++;
+	rockchip_gem_import_cache_trim_locked(private, &evict);
+	mutex_unlock(&private->mm_lock);
+
+	list_for_each_entry_safe(import, tmp, &evict, node)
+		rockchip_gem_import_release(private, import);
+
+	return true;
+}
+
+static struct rockchip_gem_import *
+rockchip_gem_import_cache_get(struct rockchip_drm_private *private,
+			      struct dma_buf *dma_buf)
+{
+	struct rockchip_gem_import *import;
+
+	mutex_lock(&private->mm_lock);
+	list_for_each_entry(import, &private->import_cache, node) {
+		if (import->attach->dmabuf == dma_buf) {
+			list_del(&import->node);
+			private->import_cache_count--;
+			mutex_unlock(&private->mm_lock);
+			return import;
+		}
+	}
+	mutex_unlock(&private->mm_lock);
+
+	return NULL;
+}
+
+static unsigned long
+rockchip_gem_import_cache_count(struct shrinker *shrinker,
+				struct shrink_control *sc)
+{
+	struct rockchip_drm_private *private =
+		container_of(shrinker, struct rockchip_drm_private,
+			     import_shrinker);
+
+	return READ_ONCE(private->import_cache_count) ?: SHRINK_EMPTY;
+}
+
+static unsigned long
+rockchip_gem_import_cache_scan(struct shrinker *shrinker,
+			       struct shrink_control *sc)
+{
+	struct rockchip_drm_private *private =
+		container_of(shrinker, struct rockchip_drm_private,
+			     import_shrinker);
+	struct rockchip_gem_import *import, *tmp;
+	unsigned long freed = 0;
+	LIST_HEAD(evict);
+
+	/*
+	 * mm_lock holders may be allocating memory themselves, so only take
+	 * it when uncontended, and only once: the IOVAs are given back while
+	 * holding it rather than through rockchip_gem_import_release().
+	 */
+	if (!mutex_trylock(&private->mm_lock))
+		return SHRINK_STOP;
+
+	list_for_each_entry_safe_reverse(import, tmp, &private->import_cache,
+					 node) {
+		if (freed >= sc->nr_to_scan)
+			break;
+
+		list_move(&import->node, &evict);
+		private->import_cache_count--;
+		iommu_unmap(private->domain, import->mm.start, import->size);
+		drm_mm_remove_node(&import->mm);
+		freed++;
+	}
+	mutex_unlock(&private->mm_lock);
+
+	list_for_each_entry_safe(import, tmp, &evict, node)
+		rockchip_gem_import_free(import);
+
+	return freed;
+}
+
+int rockchip_gem_import_cache_init(struct drm_device *drm)
+{
+	struct rockchip_drm_private *private = drm->dev_private;
+
+	INIT_LIST_HEAD(&private->import_cache);
+
+	private->import_shrinker.count_objects =
+		rockchip_gem_import_cache_count;
+	private->import_shrinker.scan_objects = rockchip_gem_import_cache_scan;
+	private->import_shrinker.seeks = DEFAULT_SEEKS;
+
+	return register_shrinker(&private->import_shrinker,
+				 "drm-rockchip-import");
+}
+
+void rockchip_gem_import_cache_fini(struct drm_device *drm)
+{
+	struct rockchip_drm_private *private = drm->dev_private;
+	struct rockchip_gem_import *import, *tmp;
+
+	if (!private->domain)
+		return;
+
+	unregister_shrinker(&private->import_shrinker);
+
+	list_for_each_entry_safe(import, tmp, &private->import_cache, node) {
+		list_del(&import->node);
+		rockchip_gem_import_release(private, import);
+	}
+	private->import_cache_count = 0;
+}
+
 static int rockchip_gem_get_pages(struct rockchip_gem_object *rk_obj)
 {
 	struct drm_device *drm = rk_obj->base.dev;
@@ -334,12 +530,15 @@ void rockchip_gem_free_object(struct drm_gem_object *obj)
 
 	if (obj->import_attach) {
 		if (private->domain) {
-			rockchip_gem_iommu_unmap(rk_obj);
+			if (!rockchip_gem_import_cache_put(rk_obj)) {
+				rockchip_gem_iommu_unmap(rk_obj);
+				drm_prime_gem_destroy(obj, rk_obj->sgt);
+			}
 		} else {
 			dma_unmap_sgtable(drm->dev, rk_obj->sgt,
 					  DMA_BIDIRECTIONAL, 0);
+			drm_prime_gem_destroy(obj, rk_obj->sgt);
 		}
-		drm_prime_gem_destroy(obj, rk_obj->sgt);
 	} else {
 		rockchip_gem_free_buf(rk_obj);
 	}
@@ -510,6 +709,53 @@ rockchip_gem_prime_import_sg_table(struct drm_device *drm,
 	return ERR_PTR(ret);
 }
 
+/*
+ * rockchip_gem_prime_import - (struct drm_driver)->gem_prime_import
+ * callback function
+ *
+ * Reuses the attachment and IOMMU mapping of a previous import of the
+ * same dma-buf when one is still cached, and falls back to the generic
+ * PRIME import otherwise.
+ */
+struct drm_gem_object *rockchip_gem_prime_import(struct drm_device *drm,
+						 struct dma_buf *dma_buf)
+{
+	struct rockchip_drm_private *private = drm->dev_private;
+	struct rockchip_gem_import *import;
+	struct rockchip_gem_object *rk_obj;
+	struct drm_gem_object *obj;
+
+	if (!private->domain)
+		return drm_gem_prime_import(drm, dma_buf);
+
+	import = rockchip_gem_import_cache_get(private, dma_buf);
+	if (!import)
+		return drm_gem_prime_import(drm, dma_buf);
+
+	rk_obj = rockchip_gem_alloc_object(drm, dma_buf->size);
+	if (IS_ERR(rk_obj)) {
+		rockchip_gem_import_release(private, import);
+		return ERR_CAST(rk_obj);
+	}
+
+	mutex_lock(&private->mm_lock);
+	drm_mm_replace_node(&import->mm, &rk_obj->mm);
+	mutex_unlock(&private->mm_lock);
+
+	rk_obj->dma_addr = rk_obj->mm.start;
+	rk_obj->sgt = import->sgt;
+	rk_obj->size = import->size;
+
+	/* The cached entry's dma-buf reference now belongs to the object. */
+	obj = &rk_obj->base;
+	obj->import_attach = import->attach;
+	obj->resv = dma_buf->resv;
+
+	kfree(import);
+
+	return obj;
+}
+
 int rockchip_gem_prime_vmap(struct drm_gem_object *obj, struct iosys_map *map)
 {
 	struct rockchip_gem_object *rk_obj = to_rockchip_obj(obj);
@@ -31,6 +31,10 @@ struct drm_gem_object *
 rockchip_gem_prime_import_sg_table(struct drm_device *dev,
 				   struct dma_buf_attachment *attach,
 				   struct sg_table *sg);
+struct drm_gem_object *rockchip_gem_prime_import(struct drm_device *drm,
+						 struct dma_buf *dma_buf);
+int rockchip_gem_import_cache_init(struct drm_device *drm);
+void rockchip_gem_import_cache_fini(struct drm_device *drm);
 int rockchip_gem_prime_vmap(struct drm_gem_object *obj, struct iosys_map *map);
 void rockchip_gem_prime_vunmap(struct drm_gem_object *obj,
 			       struct iosys_map *map);
@@ -7,6 +7,7 @@
 #include <linux/clk.h>
 #include <linux/component.h>
 #include <linux/delay.h>
+#include <linux/interconnect.h>
 #include <linux/iopoll.h>
 #include <linux/kernel.h>
 #include <linux/log2.h>
@@ -113,6 +114,17 @@
 
 #define AFBC_TILE_16x16		BIT(4)
 
+/*
+ * Framebuffers an async update may displace on a window before the next
+ * vblank releases them. Past that, updates go through a regular commit.
+ */
+#define VOP_MAX_PENDING_FLIPS	2
+
+static unsigned int late_latch_lines;
+module_param(late_latch_lines, uint, 0644);
+MODULE_PARM_DESC(late_latch_lines,
+		 "Hold commits until this many lines before the end of the active area (0 = disabled)");
+
 /*
  * The coefficients of the following matrix are all fixed points.
  * The format is S2.10 for the 3x3 part of the matrix, and S9.12 for the offsets.
@@ -134,6 +146,9 @@ struct vop_win {
 	const struct vop_win_data *data;
 	const struct vop_win_yuv2yuv_data *yuv2yuv_data;
 	struct vop *vop;
+
+	/* framebuffers displaced by async updates since the last vblank */
+	atomic_t pending_flips;
 };
 
 struct rockchip_rgb;
@@ -182,6 +197,9 @@ struct vop {
 	/* vop dclk reset */
 	struct reset_control *dclk_rst;
 
+	/* optional DRAM bandwidth vote for scanout */
+	struct icc_path *icc_path;
+
 	/* optional internal rgb encoder */
 	struct rockchip_rgb *rgb;
 
@@ -753,6 +771,8 @@ static void vop_crtc_atomic_disable(struct drm_crtc *crtc,
 	 */
 	rockchip_drm_dma_detach_device(vop->drm_dev, vop->dev);
 
+	icc_set_bw(vop->icc_path, 0, 0);
+
 	clk_disable(vop->dclk);
 	vop_core_clks_disable(vop);
 	pm_runtime_put(vop->dev);
@@ -782,6 +802,9 @@ static inline bool rockchip_afbc(u64 modifier)
 static bool rockchip_mod_supported(struct drm_plane *plane,
 				   u32 format, u64 modifier)
 {
+	struct vop_win *vop_win = to_vop_win(plane);
+	const u64 *modifiers = vop_win->data->phy->format_modifiers;
+
 	if (modifier == DRM_FORMAT_MOD_LINEAR)
 		return true;
 
@@ -791,6 +814,20 @@ static bool rockchip_mod_supported(struct drm_plane *plane,
 		return false;
 	}
 
+	/* Only the windows the AFBC decoder can be routed to advertise it. */
+	for (; *modifiers != DRM_FORMAT_MOD_INVALID; modifiers++)
+		if (*modifiers == modifier)
+			break;
+	if (*modifiers == DRM_FORMAT_MOD_INVALID)
+		return false;
+
+	/*
+	 * The decoder only handles packed RGB, filter out the YUV formats
+	 * here rather than letting vop_convert_afbc_format() warn about them.
+	 */
+	if (drm_format_info(format)->is_yuv)
+		return false;
+
 	return vop_convert_afbc_format(format) >= 0;
 }
 
@@ -1063,7 +1100,8 @@ static int vop_plane_atomic_async_check(struct drm_plane *plane,
 					DRM_PLANE_NO_SCALING;
 	struct drm_crtc_state *crtc_state;
 
-	if (plane != new_plane_state->crtc->cursor)
+	if (plane != new_plane_state->crtc->cursor &&
+	    plane->type != DRM_PLANE_TYPE_OVERLAY)
 		return -EINVAL;
 
 	if (!plane->state)
@@ -1072,6 +1110,15 @@ static int vop_plane_atomic_async_check(struct drm_plane *plane,
 	if (!plane->state->fb)
 		return -EINVAL;
 
+	/* The AFBC decoder is shared between the windows. */
+	if (rockchip_afbc(plane->state->fb->modifier) ||
+	    (new_plane_state->fb && rockchip_afbc(new_plane_state->fb->modifier)))
+		return -EINVAL;
+
+	if (new_plane_state->fb != plane->state->fb &&
+	    atomic_read(&vop_win->pending_flips) >= VOP_MAX_PENDING_FLIPS)
+		return -EBUSY;
+
 	if (state)
 		crtc_state = drm_atomic_get_existing_crtc_state(state,
 								new_plane_state->crtc);
@@ -1099,29 +1146,94 @@ static void vop_plane_atomic_async_update(struct drm_plane *plane,
 	plane->state->src_y = new_state->src_y;
 	plane->state->src_h = new_state->src_h;
 	plane->state->src_w = new_state->src_w;
-	swap(plane->state->fb, new_state->fb);
 
+	/* Program the new state while it still holds the new framebuffer. */
 	if (vop->is_enabled) {
 		vop_plane_atomic_update(plane, state);
 		spin_lock(&vop->reg_lock);
 		vop_cfg_done(vop);
 		spin_unlock(&vop->reg_lock);
+	}
 
-		/*
-		 * A scanout can still be occurring, so we can't drop the
-		 * reference to the old framebuffer. To solve this we get a
-		 * reference to old_fb and set a worker to release it later.
-		 * FIXME: if we perform 500 async_update calls before the
-		 * vblank, then we can have 500 different framebuffers waiting
-		 * to be released.
-		 */
-		if (old_fb && plane->state->fb != old_fb) {
-			drm_framebuffer_get(old_fb);
-			WARN_ON(drm_crtc_vblank_get(plane->state->crtc) != 0);
-			drm_flip_work_queue(&vop->fb_unref_work, old_fb);
-			set_bit(VOP_PENDING_FB_UNREF, &vop->pending);
-		}
+	swap(plane->state->fb, new_state->fb);
+
+	/*
+	 * A scanout can still be occurring, so we can't drop the reference to
+	 * the old framebuffer. To solve this we get a reference to old_fb and
+	 * set a worker to release it after the next vblank. The async check
+	 * bounds how many of them can pile up per window.
+	 */
+	if (vop->is_enabled && old_fb && plane->state->fb != old_fb) {
+		drm_framebuffer_get(old_fb);
+		WARN_ON(drm_crtc_vblank_get(plane->state->crtc) != 0);
+		drm_flip_work_queue(&vop->fb_unref_work, old_fb);
+		atomic_inc(&to_vop_win(plane)->pending_flips);
+		set_bit(VOP_PENDING_FB_UNREF, &vop->pending);
+	}
+}
+
+/*
+ * The atomic helpers only try the async path for legacy cursor updates.
+ * Flag framebuffer swaps on overlay windows the same way, so that a video
+ * player flipping through SetPlane doesn't wait for a vblank on each frame.
+ * Anything else takes the regular path.
+ */
+static int vop_plane_update_plane(struct drm_plane *plane,
+				  struct drm_crtc *crtc,
+				  struct drm_framebuffer *fb,
+				  int crtc_x, int crtc_y,
+				  unsigned int crtc_w, unsigned int crtc_h,
+				  uint32_t src_x, uint32_t src_y,
+				  uint32_t src_w, uint32_t src_h,
+				  struct drm_modeset_acquire_ctx *ctx)
+{
+	struct drm_plane_state *old_state = plane->state;
+	struct drm_plane_state *plane_state;
+	struct drm_atomic_state *state;
+	int ret;
+
+	if (plane->type != DRM_PLANE_TYPE_OVERLAY || !fb || !old_state->fb ||
+	    old_state->crtc != crtc ||
+	    old_state->crtc_x != crtc_x || old_state->crtc_y != crtc_y ||
+	    old_state->crtc_w != crtc_w || old_state->crtc_h != crtc_h ||
+	    old_state->src_x != src_x || old_state->src_y != src_y ||
+	    old_state->src_w != src_w || old_state->src_h != src_h)
+		return drm_atomic_helper_update_plane(plane, crtc, fb,
+						      crtc_x, crtc_y,
+						      crtc_w, crtc_h,
+						      src_x, src_y,
+						      src_w, src_h, ctx);
+
+	state = drm_atomic_state_alloc(plane->dev);
+	if (!state)
+		return -ENOMEM;
+
+	state->acquire_ctx = ctx;
+	plane_state = drm_atomic_get_plane_state(state, plane);
+	if (IS_ERR(plane_state)) {
+		ret = PTR_ERR(plane_state);
+		goto out;
 	}
+
+	drm_atomic_set_fb_for_plane(plane_state, fb);
+	state->legacy_cursor_update = true;
+
+	/*
+	 * A regular commit flagged as a legacy cursor update doesn't wait for
+	 * the vblank, so the old framebuffer would be released while it is
+	 * still scanned out. Keep the flag only if the async path is taken.
+	 */
+	ret = drm_atomic_check_only(state);
+	if (ret)
+		goto out;
+
+	if (!state->async_update)
+		state->legacy_cursor_update = false;
+
+	ret = drm_atomic_commit(state);
+out:
+	drm_atomic_state_put(state);
+	return ret;
 }
 
 static const struct drm_plane_helper_funcs plane_helper_funcs = {
@@ -1133,7 +1245,7 @@ static const struct drm_plane_helper_funcs plane_helper_funcs = {
 };
 
 static const struct drm_plane_funcs vop_plane_funcs = {
-	.update_plane	= drm_atomic_helper_update_plane,
+	.update_plane	= vop_plane_update_plane,
 	.disable_plane	= drm_atomic_helper_disable_plane,
 	.destroy = vop_plane_destroy,
 	.reset = drm_atomic_helper_plane_reset,
@@ -1360,6 +1472,16 @@ static void vop_crtc_atomic_enable(struct drm_crtc *crtc,
 
 	WARN_ON(vop->event);
 
+	/*
+	 * Vote for the bandwidth of a full screen 32bpp scanout before the
+	 * first fetch, so that the DMC is not still running at the rate
+	 * picked for an idle system when the line buffers start draining.
+	 */
+	ret = icc_set_bw(vop->icc_path, 0,
+			 kBps_to_icc(adjusted_mode->crtc_clock * 4));
+	if (ret)
+		DRM_DEV_ERROR(vop->dev, "Failed to vote bandwidth (%d)\n", ret);
+
 	ret = vop_enable(crtc, old_state);
 	if (ret) {
 		mutex_unlock(&vop->vop_lock);
@@ -1529,6 +1651,73 @@ static int vop_crtc_atomic_check(struct drm_crtc *crtc,
 	return 0;
 }
 
+/*
+ * With late latching, cfg_done for a commit that comes in early in the
+ * frame isn't written right away but at the line flag interrupt
+ * late_latch_lines before the end of the active area. There is no scanline
+ * counter, so the current line is estimated from the last vblank
+ * timestamp. When that is stale, or the latch line has passed already, the
+ * commit is armed right away as without late latching.
+ */
+static void vop_crtc_wait_latch_line(struct vop *vop)
+{
+	struct drm_crtc *crtc = &vop->crtc;
+	const struct drm_display_mode *mode = &crtc->state->adjusted_mode;
+	u16 vact_end = mode->vtotal - mode->vsync_start + mode->vdisplay;
+	u64 line_ns, frame_ns, elapsed_ns;
+	unsigned int latch_line;
+	unsigned long timeout;
+	ktime_t vblank_time;
+
+	if (!late_latch_lines || late_latch_lines >= vact_end ||
+	    !mode->clock || !mode->htotal)
+		return;
+
+	if (drm_crtc_vblank_get(crtc))
+		return;
+
+	line_ns = div_u64((u64)mode->htotal * NSEC_PER_MSEC, mode->clock);
+	frame_ns = line_ns * mode->vtotal;
+	latch_line = vact_end - late_latch_lines;
+
+	drm_crtc_vblank_count_and_time(crtc, &vblank_time);
+	elapsed_ns = ktime_to_ns(ktime_sub(ktime_get(), vblank_time));
+
+	/* Leave a line of margin to arm the interrupt */
+	if (elapsed_ns >= frame_ns ||
+	    div64_u64(elapsed_ns, line_ns) + 1 >= latch_line)
+		goto out_put;
+
+	mutex_lock(&vop->vop_lock);
+
+	/* rockchip_drm_wait_vact_end() uses the line flag, don't hold then */
+	if (vop_line_flag_irq_is_enabled(vop))
+		goto out_unlock;
+
+	spin_lock(&vop->reg_lock);
+	VOP_REG_SET(vop, intr, line_flag_num[0], latch_line);
+	spin_unlock(&vop->reg_lock);
+
+	reinit_completion(&vop->line_flag_completion);
+	vop_line_flag_irq_enable(vop);
+
+	timeout = nsecs_to_jiffies(frame_ns) + 1;
+	if (!wait_for_completion_timeout(&vop->line_flag_completion, timeout))
+		DRM_DEV_DEBUG_KMS(vop->dev, "late latch line %u missed\n",
+				  latch_line);
+
+	vop_line_flag_irq_disable(vop);
+
+	spin_lock(&vop->reg_lock);
+	VOP_REG_SET(vop, intr, line_flag_num[0], vact_end);
+	spin_unlock(&vop->reg_lock);
+
+out_unlock:
+	mutex_unlock(&vop->vop_lock);
+out_put:
+	drm_crtc_vblank_put(crtc);
+}
+
 static void vop_crtc_atomic_flush(struct drm_crtc *crtc,
 				  struct drm_atomic_state *state)
 {
@@ -1544,6 +1733,8 @@ static void vop_crtc_atomic_flush(struct drm_crtc *crtc,
 	if (WARN_ON(!vop->is_enabled))
 		return;
 
+	vop_crtc_wait_latch_line(vop);
+
 	spin_lock(&vop->reg_lock);
 
 	/* Enable AFBC if there is some AFBC window, disable otherwise. */
@@ -1738,8 +1929,14 @@ static void vop_handle_vblank(struct vop *vop)
 	}
 	spin_unlock(&drm->event_lock);
 
-	if (test_and_clear_bit(VOP_PENDING_FB_UNREF, &vop->pending))
+	if (test_and_clear_bit(VOP_PENDING_FB_UNREF, &vop->pending)) {
+		int i;
+
+		for (i = 0; i < vop->data->win_size; i++)
+			atomic_set(&vop->win[i].pending_flips, 0);
+
 		drm_flip_work_commit(&vop->fb_unref_work, system_unbound_wq);
+	}
 }
 
 static irqreturn_t vop_isr(int irq, void *data)
@@ -1972,6 +2169,12 @@ static int vop_initial(struct vop *vop)
 	struct reset_control *ahb_rst;
 	int i, ret;
 
+	vop->icc_path = devm_of_icc_get(vop->dev, "dram");
+	if (IS_ERR(vop->icc_path)) {
+		DRM_DEV_ERROR(vop->dev, "failed to get dram interconnect path\n");
+		return PTR_ERR(vop->icc_path);
+	}
+
 	vop->hclk = devm_clk_get(vop->dev, "hclk_vop");
 	if (IS_ERR(vop->hclk)) {
 		DRM_DEV_ERROR(vop->dev, "failed to get hclk source\n");
@@ -948,12 +948,13 @@ static const struct vop_win_phy rk3399_win01_data = {
 /*
  * rk3399 vop big windows register layout is same as rk3288, but we
  * have a separate rk3399 win data array here so that we can advertise
- * AFBC on the primary plane.
+ * AFBC on the full windows. The single AFBC decoder can be routed to
+ * either win0 or win1, the multi-area win2/win3 cannot use it.
  */
 static const struct vop_win_data rk3399_vop_win_data[] = {
 	{ .base = 0x00, .phy = &rk3399_win01_data,
 	  .type = DRM_PLANE_TYPE_PRIMARY },
-	{ .base = 0x40, .phy = &rk3368_win01_data,
+	{ .base = 0x40, .phy = &rk3399_win01_data,
 	  .type = DRM_PLANE_TYPE_OVERLAY },
 	{ .base = 0x00, .phy = &rk3368_win23_data,
 	  .type = DRM_PLANE_TYPE_OVERLAY },
@@ -119,6 +119,28 @@ void drm_sched_rq_remove_entity(struct drm_sched_rq *rq,
 	spin_unlock(&rq->lock);
 }
 
+/**
+ * drm_sched_can_queue - Can we queue the next job of an entity
+ *
+ * @sched: scheduler instance
+ * @entity: the entity to check
+ *
+ * Return true if the hardware queue has enough credits left for the job at
+ * the head of @entity's queue.
+ */
+static bool drm_sched_can_queue(struct drm_gpu_scheduler *sched,
+				struct drm_sched_entity *entity)
+{
+	struct drm_sched_job *s_job;
+
+	s_job = to_drm_sched_job(spsc_queue_peek(&entity->job_queue));
+	if (!s_job)
+		return false;
+
+	return atomic_read(&sched->credit_count) + s_job->credits <=
+		sched->hw_submission_limit;
+}
+
 /**
  * drm_sched_rq_select_entity - Select an entity which could provide a job to run
  *
@@ -136,7 +158,8 @@ drm_sched_rq_select_entity(struct drm_sched_rq *rq)
 	entity = rq->current_entity;
 	if (entity) {
 		list_for_each_entry_continue(entity, &rq->entities, list) {
-			if (drm_sched_entity_is_ready(entity)) {
+			if (drm_sched_entity_is_ready(entity) &&
+			    drm_sched_can_queue(rq->sched, entity)) {
 				rq->current_entity = entity;
 				reinit_completion(&entity->entity_idle);
 				spin_unlock(&rq->lock);
@@ -147,7 +170,8 @@ drm_sched_rq_select_entity(struct drm_sched_rq *rq)
 
 	list_for_each_entry(entity, &rq->entities, list) {
 
-		if (drm_sched_entity_is_ready(entity)) {
+		if (drm_sched_entity_is_ready(entity) &&
+		    drm_sched_can_queue(rq->sched, entity)) {
 			rq->current_entity = entity;
 			reinit_completion(&entity->entity_idle);
 			spin_unlock(&rq->lock);
@@ -175,6 +199,7 @@ static void drm_sched_job_done(struct drm_sched_job *s_job)
 	struct drm_gpu_scheduler *sched = s_fence->sched;
 
 	atomic_dec(&sched->hw_rq_count);
+	atomic_sub(s_job->credits, &sched->credit_count);
 	atomic_dec(sched->score);
 
 	trace_drm_sched_process_job(s_fence);
@@ -422,6 +447,7 @@ void drm_sched_stop(struct drm_gpu_scheduler *sched, struct drm_sched_job *bad)
 			dma_fence_put(s_job->s_fence->parent);
 			s_job->s_fence->parent = NULL;
 			atomic_dec(&sched->hw_rq_count);
+			atomic_sub(s_job->credits, &sched->credit_count);
 		} else {
 			/*
 			 * remove job from pending_list.
@@ -483,6 +509,7 @@ void drm_sched_start(struct drm_gpu_scheduler *sched, bool full_recovery)
 		struct dma_fence *fence = s_job->s_fence->parent;
 
 		atomic_inc(&sched->hw_rq_count);
+		atomic_add(s_job->credits, &sched->credit_count);
 
 		if (!full_recovery)
 			continue;
@@ -596,6 +623,7 @@ int drm_sched_job_init(struct drm_sched_job *job,
 		return -ENOENT;
 
 	job->entity = entity;
+	job->credits = 1;
 	job->s_fence = drm_sched_fence_alloc(entity, owner);
 	if (!job->s_fence)
 		return -ENOMEM;
@@ -630,6 +658,12 @@ void drm_sched_job_arm(struct drm_sched_job *job)
 	drm_sched_entity_select_rq(entity);
 	sched = entity->rq->sched;
 
+	/* A job that can never fit would stall its entity forever */
+	if (WARN_ON(!job->credits ||
+		    job->credits > sched->hw_submission_limit))
+		job->credits = clamp_t(u32, job->credits, 1,
+				       sched->hw_submission_limit);
+
 	job->sched = sched;
 	job->s_priority = entity->rq - sched->sched_rq;
 	job->id = atomic64_inc_return(&sched->job_id_count);
@@ -769,7 +803,7 @@ EXPORT_SYMBOL(drm_sched_job_cleanup);
  */
 static bool drm_sched_ready(struct drm_gpu_scheduler *sched)
 {
-	return atomic_read(&sched->hw_rq_count) <
+	return atomic_read(&sched->credit_count) <
 		sched->hw_submission_limit;
 }
 
@@ -950,6 +984,7 @@ static int drm_sched_main(void *param)
 		s_fence = sched_job->s_fence;
 
 		atomic_inc(&sched->hw_rq_count);
+		atomic_add(sched_job->credits, &sched->credit_count);
 		drm_sched_job_begin(sched_job);
 
 		trace_drm_run_job(sched_job, entity);
@@ -986,7 +1021,8 @@ static int drm_sched_main(void *param)
  *
  * @sched: scheduler instance
  * @ops: backend operations for this scheduler
- * @hw_submission: number of hw submissions that can be in flight
+ * @hw_submission: number of job credits that can be in flight, i.e. the
+ *		   number of jobs if all of them take the default single credit
  * @hang_limit: number of times to allow a job to hang before dropping it
  * @timeout: timeout value in jiffies for the scheduler
  * @timeout_wq: workqueue to use for timeout work. If NULL, the system_wq is
@@ -1020,6 +1056,7 @@ int drm_sched_init(struct drm_gpu_scheduler *sched,
 	INIT_LIST_HEAD(&sched->pending_list);
 	spin_lock_init(&sched->job_list_lock);
 	atomic_set(&sched->hw_rq_count, 0);
+	atomic_set(&sched->credit_count, 0);
 	INIT_DELAYED_WORK(&sched->work_tdr, drm_sched_job_timedout);
 	atomic_set(&sched->_score, 0);
 	atomic64_set(&sched->job_id_count, 0);
@@ -12,6 +12,10 @@
 #include <drm/drm_print.h>
 #include <drm/drm_rect.h>
 
+#include <linux/ktime.h>
+#include <linux/random.h>
+#include <linux/vmalloc.h>
+
 #include "../drm_crtc_internal.h"
 
 #define TEST_BUF_SIZE 50
@@ -442,12 +446,195 @@ static void drm_test_fb_xrgb8888_to_xrgb2101010(struct kunit *test)
 	KUNIT_EXPECT_EQ(test, memcmp(buf, result->expected, dst_size), 0);
 }
 
+/*
+ * The line conversions may have arch specific versions that handle a
+ * multiple of pixels at a time and leave the rest to the generic code.
+ * Check them against a plain reference on random data of odd sizes, so
+ * that both the vector and the tail paths are covered.
+ */
+#define RANDOM_WIDTH	397
+#define RANDOM_HEIGHT	3
+
+static void ref_xrgb8888_to_rgb565(u16 *dst, const u32 *src, size_t pixels, bool swab)
+{
+	size_t i;
+
+	for (i = 0; i < pixels; i++) {
+		u32 pix = le32_to_cpu((__force __le32)src[i]);
+		u16 val16 = ((pix & 0x00F80000) >> 8) |
+			    ((pix & 0x0000FC00) >> 5) |
+			    ((pix & 0x000000F8) >> 3);
+
+		dst[i] = swab ? swab16(val16) : val16;
+	}
+}
+
+static void ref_xrgb8888_to_rgb888(u8 *dst, const u32 *src, size_t pixels)
+{
+	size_t i;
+
+	for (i = 0; i < pixels; i++) {
+		u32 pix = le32_to_cpu((__force __le32)src[i]);
+
+		*dst++ = pix;
+		*dst++ = pix >> 8;
+		*dst++ = pix >> 16;
+	}
+}
+
+static void ref_xrgb8888_to_gray8(u8 *dst, const u32 *src, size_t pixels)
+{
+	size_t i;
+
+	for (i = 0; i < pixels; i++) {
+		u32 pix = le32_to_cpu((__force __le32)src[i]);
+		u8 r = pix >> 16, g = pix >> 8, b = pix;
+
+		dst[i] = (3 * r + 6 * g + b) / 10;
+	}
+}
+
+static void ref_swab32(u32 *dst, const u32 *src, size_t pixels)
+{
+	size_t i;
+
+	for (i = 0; i < pixels; i++)
+		dst[i] = swab32(src[i]);
+}
+
+static void drm_test_fb_xrgb8888_random(struct kunit *test)
+{
+	const struct drm_rect clip = DRM_RECT_INIT(0, 0, RANDOM_WIDTH, RANDOM_HEIGHT);
+	const size_t pixels = RANDOM_WIDTH * RANDOM_HEIGHT;
+	struct drm_framebuffer fb = {
+		.format = drm_format_info(DRM_FORMAT_XRGB8888),
+		.pitches = { RANDOM_WIDTH * sizeof(u32), 0, 0 },
+	};
+	struct iosys_map dst, src;
+	u32 *xrgb8888;
+	void *buf, *ref;
+
+	xrgb8888 = kunit_kmalloc_array(test, pixels, sizeof(u32), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, xrgb8888);
+	get_random_bytes(xrgb8888, pixels * sizeof(u32));
+	iosys_map_set_vaddr(&src, xrgb8888);
+
+	buf = kunit_kzalloc(test, pixels * sizeof(u32), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, buf);
+	ref = kunit_kzalloc(test, pixels * sizeof(u32), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ref);
+	iosys_map_set_vaddr(&dst, buf);
+
+	drm_fb_xrgb8888_to_rgb565(&dst, NULL, &src, &fb, &clip, false);
+	ref_xrgb8888_to_rgb565(ref, xrgb8888, pixels, false);
+	KUNIT_EXPECT_EQ(test, memcmp(buf, ref, pixels * sizeof(u16)), 0);
+
+	drm_fb_xrgb8888_to_rgb565(&dst, NULL, &src, &fb, &clip, true);
+	ref_xrgb8888_to_rgb565(ref, xrgb8888, pixels, true);
+	KUNIT_EXPECT_EQ(test, memcmp(buf, ref, pixels * sizeof(u16)), 0);
+
+	drm_fb_xrgb8888_to_rgb888(&dst, NULL, &src, &fb, &clip);
+	ref_xrgb8888_to_rgb888(ref, xrgb8888, pixels);
+	KUNIT_EXPECT_EQ(test, memcmp(buf, ref, pixels * 3), 0);
+
+	drm_fb_xrgb8888_to_gray8(&dst, NULL, &src, &fb, &clip);
+	ref_xrgb8888_to_gray8(ref, xrgb8888, pixels);
+	KUNIT_EXPECT_EQ(test, memcmp(buf, ref, pixels), 0);
+
+	drm_fb_swab(&dst, NULL, &src, &fb, &clip, true);
+	ref_swab32(ref, xrgb8888, pixels);
+	KUNIT_EXPECT_EQ(test, memcmp(buf, ref, pixels * sizeof(u32)), 0);
+}
+
+#define BENCH_WIDTH	1920
+#define BENCH_HEIGHT	1080
+
+static int bench_vzalloc_init(struct kunit_resource *res, void *context)
+{
+	res->data = vzalloc(*(size_t *)context);
+
+	return res->data ? 0 : -ENOMEM;
+}
+
+static void bench_vfree(struct kunit_resource *res)
+{
+	vfree(res->data);
+}
+
+/* A full HD XRGB8888 frame is too large for kmalloc() on many configs */
+static void *bench_vzalloc(struct kunit *test, size_t size)
+{
+	return kunit_alloc_resource(test, bench_vzalloc_init, bench_vfree,
+				    GFP_KERNEL, &size);
+}
+
+/*
+ * Not a correctness test, prints how long a full HD frame conversion takes
+ * with the helpers and with the plain reference loops.
+ */
+static void drm_test_fb_xrgb8888_benchmark(struct kunit *test)
+{
+	const struct drm_rect clip = DRM_RECT_INIT(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+	const size_t pixels = BENCH_WIDTH * BENCH_HEIGHT;
+	struct drm_framebuffer fb = {
+		.format = drm_format_info(DRM_FORMAT_XRGB8888),
+		.pitches = { BENCH_WIDTH * sizeof(u32), 0, 0 },
+	};
+	struct iosys_map dst, src;
+	u32 *xrgb8888;
+	void *buf;
+	ktime_t t0, t1, t2;
+
+	xrgb8888 = bench_vzalloc(test, pixels * sizeof(u32));
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, xrgb8888);
+	get_random_bytes(xrgb8888, pixels * sizeof(u32));
+	iosys_map_set_vaddr(&src, xrgb8888);
+
+	buf = bench_vzalloc(test, pixels * sizeof(u32));
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, buf);
+	iosys_map_set_vaddr(&dst, buf);
+
+	t0 = ktime_get();
+	drm_fb_xrgb8888_to_rgb565(&dst, NULL, &src, &fb, &clip, false);
+	t1 = ktime_get();
+	ref_xrgb8888_to_rgb565(buf, xrgb8888, pixels, false);
+	t2 = ktime_get();
+	kunit_info(test, "rgb565: %lld us, reference %lld us\n",
+		   ktime_us_delta(t1, t0), ktime_us_delta(t2, t1));
+
+	t0 = ktime_get();
+	drm_fb_xrgb8888_to_rgb888(&dst, NULL, &src, &fb, &clip);
+	t1 = ktime_get();
+	ref_xrgb8888_to_rgb888(buf, xrgb8888, pixels);
+	t2 = ktime_get();
+	kunit_info(test, "rgb888: %lld us, reference %lld us\n",
+		   ktime_us_delta(t1, t0), ktime_us_delta(t2, t1));
+
+	t0 = ktime_get();
+	drm_fb_xrgb8888_to_gray8(&dst, NULL, &src, &fb, &clip);
+	t1 = ktime_get();
+	ref_xrgb8888_to_gray8(buf, xrgb8888, pixels);
+	t2 = ktime_get();
+	kunit_info(test, "gray8: %lld us, reference %lld us\n",
+		   ktime_us_delta(t1, t0), ktime_us_delta(t2, t1));
+
+	t0 = ktime_get();
+	drm_fb_swab(&dst, NULL, &src, &fb, &clip, true);
+	t1 = ktime_get();
+	ref_swab32(buf, xrgb8888, pixels);
+	t2 = ktime_get();
+	kunit_info(test, "swab32: %lld us, reference %lld us\n",
+		   ktime_us_delta(t1, t0), ktime_us_delta(t2, t1));
+}
+
 static struct kunit_case drm_format_helper_test_cases[] = {
 	KUNIT_CASE_PARAM(drm_test_fb_xrgb8888_to_gray8, convert_xrgb8888_gen_params),
 	KUNIT_CASE_PARAM(drm_test_fb_xrgb8888_to_rgb332, convert_xrgb8888_gen_params),
 	KUNIT_CASE_PARAM(drm_test_fb_xrgb8888_to_rgb565, convert_xrgb8888_gen_params),
 	KUNIT_CASE_PARAM(drm_test_fb_xrgb8888_to_rgb888, convert_xrgb8888_gen_params),
 	KUNIT_CASE_PARAM(drm_test_fb_xrgb8888_to_xrgb2101010, convert_xrgb8888_gen_params),
+	KUNIT_CASE(drm_test_fb_xrgb8888_random),
+	KUNIT_CASE(drm_test_fb_xrgb8888_benchmark),
 	{}
 };
 
@@ -18,9 +18,22 @@
 #include <linux/sysfs.h>
 #include <linux/thermal.h>
 #include <linux/timer.h>
+#include <linux/workqueue.h>
 
 #define MAX_PWM 255
 
+/*
+ * Gains of the RPM controller, in 1/1024 PWM steps per permille of RPM
+ * error. The error is relative to the target so the same gains work for
+ * fans of different speeds.
+ */
+#define PWM_FAN_PID_SHIFT	10
+#define PWM_FAN_PID_KP		64
+#define PWM_FAN_PID_KI		32
+#define PWM_FAN_PID_KD		16
+/* The tach is sampled more often while the RPM is being regulated */
+#define PWM_FAN_PID_PERIOD	(HZ / 4)
+
 struct pwm_fan_tach {
 	int irq;
 	atomic_t pulses;
@@ -51,10 +64,17 @@ struct pwm_fan_ctx {
 	ktime_t sample_start;
 	struct timer_list rpm_timer;
 
+	/* closed loop control of the first fan, disabled if rpm_target is 0 */
+	unsigned int rpm_target;
+	unsigned int pid_out;
+	int pid_err[2];
+	struct work_struct pid_work;
+
 	unsigned int pwm_value;
 	unsigned int pwm_fan_state;
 	unsigned int pwm_fan_max_state;
 	unsigned int *pwm_fan_cooling_levels;
+	unsigned int *pwm_fan_cooling_rpms;
 	struct thermal_cooling_device *cdev;
 
 	struct hwmon_chip_info info;
@@ -91,7 +111,12 @@ static void sample_timer(struct timer_list *t)
 		ctx->sample_start = ktime_get();
 	}
 
-	mod_timer(&ctx->rpm_timer, jiffies + HZ);
+	if (READ_ONCE(ctx->rpm_target)) {
+		schedule_work(&ctx->pid_work);
+		mod_timer(&ctx->rpm_timer, jiffies + PWM_FAN_PID_PERIOD);
+	} else {
+		mod_timer(&ctx->rpm_timer, jiffies + HZ);
+	}
 }
 
 static void pwm_fan_enable_mode_2_state(int enable_mode,
@@ -231,6 +256,75 @@ static int set_pwm(struct pwm_fan_ctx *ctx, unsigned long pwm)
 	return ret;
 }
 
+static void pwm_fan_pid_work(struct work_struct *work)
+{
+	struct pwm_fan_ctx *ctx = container_of(work, struct pwm_fan_ctx,
+					       pid_work);
+	int err, out;
+
+	mutex_lock(&ctx->lock);
+
+	if (!ctx->rpm_target)
+		goto out;
+
+	/* permille of the target, positive when the fan is too slow */
+	err = ((int)ctx->rpm_target - (int)ctx->tachs[0].rpm) * 1000 /
+	      (int)ctx->rpm_target;
+	err = clamp(err, -1000, 1000);
+
+	/* velocity form, the integral term lives in pid_out */
+	out = ctx->pid_out;
+	out += PWM_FAN_PID_KP * (err - ctx->pid_err[0]);
+	out += PWM_FAN_PID_KI * err;
+	out += PWM_FAN_PID_KD * (err - 2 * ctx->pid_err[0] + ctx->pid_err[1]);
+
+	/* pwm 0 would power the fan off and lose the tach */
+	ctx->pid_out = clamp(out, 1 << PWM_FAN_PID_SHIFT,
+			     MAX_PWM << PWM_FAN_PID_SHIFT);
+	ctx->pid_err[1] = ctx->pid_err[0];
+	ctx->pid_err[0] = err;
+
+	out = ctx->pid_out >> PWM_FAN_PID_SHIFT;
+	if (out != ctx->pwm_value)
+		__set_pwm(ctx, out);
+out:
+	mutex_unlock(&ctx->lock);
+}
+
+/*
+ * Regulate the first fan to @rpm, starting from duty cycle @pwm. 0 switches
+ * back to open loop control at @pwm.
+ */
+static int pwm_fan_set_target(struct pwm_fan_ctx *ctx, unsigned int rpm,
+			      unsigned long pwm)
+{
+	bool start;
+	int ret;
+
+	mutex_lock(&ctx->lock);
+
+	start = rpm && !ctx->rpm_target;
+
+	/* start from the open loop duty cycle so the fan spins up right away */
+	if (rpm && !pwm)
+		pwm = ctx->pwm_value ? : MAX_PWM;
+
+	ret = __set_pwm(ctx, pwm);
+	if (!ret) {
+		WRITE_ONCE(ctx->rpm_target, rpm);
+		ctx->pid_out = pwm << PWM_FAN_PID_SHIFT;
+		ctx->pid_err[0] = 0;
+		ctx->pid_err[1] = 0;
+	}
+
+	mutex_unlock(&ctx->lock);
+
+	if (start)
+		mod_timer(&ctx->rpm_timer, jiffies + PWM_FAN_PID_PERIOD);
+
+	return ret;
+}
+
 static void pwm_fan_update_state(struct pwm_fan_ctx *ctx, unsigned long pwm)
 {
 	int i;
@@ -295,11 +389,20 @@ static int pwm_fan_write(struct device *dev, enum hwmon_sensor_types type,
 	struct pwm_fan_ctx *ctx = dev_get_drvdata(dev);
 	int ret;
 
+	if (type == hwmon_fan) {
+		if (attr != hwmon_fan_target)
+			return -EOPNOTSUPP;
+		if (val < 0 || val > INT_MAX / 1000)
+			return -EINVAL;
+		return pwm_fan_set_target(ctx, val, val ? 0 : ctx->pwm_value);
+	}
+
 	switch (attr) {
 	case hwmon_pwm_input:
 		if (val < 0 || val > MAX_PWM)
 			return -EINVAL;
-		ret = set_pwm(ctx, val);
+		/* writing the duty cycle directly switches to open loop */
+		ret = pwm_fan_set_target(ctx, 0, val);
 		if (ret)
 			return ret;
 		pwm_fan_update_state(ctx, val);
@@ -335,7 +438,10 @@ static int pwm_fan_read(struct device *dev, enum hwmon_sensor_types type,
 		}
 		return -EOPNOTSUPP;
 	case hwmon_fan:
-		*val = ctx->tachs[channel].rpm;
+		if (attr == hwmon_fan_target)
+			*val = ctx->rpm_target;
+		else
+			*val = ctx->tachs[channel].rpm;
 		return 0;
 
 	default:
@@ -352,6 +458,8 @@ static umode_t pwm_fan_is_visible(const void *data,
 		return 0644;
 
 	case hwmon_fan:
+		if (attr == hwmon_fan_target)
+			return 0644;
 		return 0444;
 
 	default:
@@ -404,7 +512,11 @@ pwm_fan_set_cur_state(struct thermal_cooling_device *cdev, unsigned long state)
 	if (state == ctx->pwm_fan_state)
 		return 0;
 
-	ret = set_pwm(ctx, ctx->pwm_fan_cooling_levels[state]);
+	if (ctx->pwm_fan_cooling_rpms)
+		ret = pwm_fan_set_target(ctx, ctx->pwm_fan_cooling_rpms[state],
+					 ctx->pwm_fan_cooling_levels[state]);
+	else
+		ret = set_pwm(ctx, ctx->pwm_fan_cooling_levels[state]);
 	if (ret) {
 		dev_err(&cdev->device, "Cannot set pwm!\n");
 		return ret;
@@ -459,6 +571,41 @@ static int pwm_fan_of_get_cooling_data(struct device *dev,
 
 	ctx->pwm_fan_max_state = num - 1;
 
+	/*
+	 * With a tachometer the cooling levels can be RPM targets instead, the
+	 * PWM levels are then only used as the starting point of the control
+	 * loop. "cooling-rpm-levels" needs one entry per "cooling-levels"
+	 * entry; a 0 entry runs that state open loop at its PWM level.
+	 */
+	if (!ctx->tach_count || ctx->tachs[0].irq <= 0 ||
+	    !of_find_property(np, "cooling-rpm-levels", NULL))
+		return 0;
+
+	if (of_property_count_u32_elems(np, "cooling-rpm-levels") != num) {
+		dev_err(dev, "cooling-rpm-levels must match cooling-levels\n");
+		return -EINVAL;
+	}
+
+	ctx->pwm_fan_cooling_rpms = devm_kcalloc(dev, num, sizeof(u32),
+						 GFP_KERNEL);
+	if (!ctx->pwm_fan_cooling_rpms)
+		return -ENOMEM;
+
+	ret = of_property_read_u32_array(np, "cooling-rpm-levels",
+					 ctx->pwm_fan_cooling_rpms, num);
+	if (ret) {
+		dev_err(dev, "Property 'cooling-rpm-levels' cannot be read!\n");
+		return ret;
+	}
+
+	for (i = 0; i < num; i++) {
+		if (ctx->pwm_fan_cooling_rpms[i] > INT_MAX / 1000) {
+			dev_err(dev, "PWM fan rpm[%d]:%u too big\n", i,
+				ctx->pwm_fan_cooling_rpms[i]);
+			return -EINVAL;
+		}
+	}
+
 	return 0;
 }
 
@@ -466,7 +613,9 @@ static void pwm_fan_cleanup(void *__ctx)
 {
 	struct pwm_fan_ctx *ctx = __ctx;
 
+	WRITE_ONCE(ctx->rpm_target, 0);
 	del_timer_sync(&ctx->rpm_timer);
+	cancel_work_sync(&ctx->pid_work);
 	/* Switch off everything */
 	ctx->enable_mode = pwm_disable_reg_disable;
 	pwm_fan_power_off(ctx);
@@ -529,6 +678,7 @@ static int pwm_fan_probe(struct platform_device *pdev)
 		return ret;
 	}
 	timer_setup(&ctx->rpm_timer, sample_timer, 0);
+	INIT_WORK(&ctx->pid_work, pwm_fan_pid_work);
 	ret = devm_add_action_or_reset(dev, pwm_fan_cleanup, ctx);
 	if (ret)
 		return ret;
@@ -592,6 +742,9 @@ static int pwm_fan_probe(struct platform_device *pdev)
 		}
 
 		fan_channel_config[i] = HWMON_F_INPUT;
+		/* the first fan can be regulated to a target speed */
+		if (!i && tach->irq > 0)
+			fan_channel_config[i] |= HWMON_F_TARGET;
 
 		dev_dbg(dev, "tach%d: irq=%d, pulses_per_revolution=%d\n",
 			i, tach->irq, tach->pulses_per_revolution);
@@ -645,15 +798,32 @@ static void pwm_fan_shutdown(struct platform_device *pdev)
 static int pwm_fan_suspend(struct device *dev)
 {
 	struct pwm_fan_ctx *ctx = dev_get_drvdata(dev);
+	int ret;
+
+	/* keep the control loop from powering the fan back on */
+	del_timer_sync(&ctx->rpm_timer);
+	cancel_work_sync(&ctx->pid_work);
+
+	mutex_lock(&ctx->lock);
+	ret = pwm_fan_power_off(ctx);
+	mutex_unlock(&ctx->lock);
 
-	return pwm_fan_power_off(ctx);
+	return ret;
 }
 
 static int pwm_fan_resume(struct device *dev)
 {
 	struct pwm_fan_ctx *ctx = dev_get_drvdata(dev);
+	int ret;
+
+	ret = set_pwm(ctx, ctx->pwm_value);
 
-	return set_pwm(ctx, ctx->pwm_value);
+	if (ctx->tach_count) {
+		ctx->sample_start = ktime_get();
+		mod_timer(&ctx->rpm_timer, jiffies + HZ);
+	}
+
+	return ret;
 }
 
 static DEFINE_SIMPLE_DEV_PM_OPS(pwm_fan_pm, pwm_fan_suspend, pwm_fan_resume);
@@ -77,6 +77,7 @@ enum {
 
 /* Constants */
 #define WAIT_TIMEOUT      1000 /* ms */
+#define SPIN_TIMEOUT      200 /* us */
 #define DEFAULT_SCL_RATE  (100 * 1000) /* Hz */
 
 /**
@@ -183,6 +184,8 @@ struct rk3x_i2c_soc_data {
  * @wait: the waitqueue to wait for i2c transfer
  * @busy: the condition for the event to wait for
  * @msg: current i2c message
+ * @msg_last: last message sent along with @msg, using I2C_M_NOSTART
+ * @addr_sent: the slave address of this transfer has been written out
  * @addr: addr of i2c slave device
  * @mode: mode of i2c transfer
  * @is_last_msg: flag determines whether it is the last msg in this transfer
@@ -211,6 +214,8 @@ struct rk3x_i2c {
 
 	/* Current message */
 	struct i2c_msg *msg;
+	struct i2c_msg *msg_last;
+	bool addr_sent;
 	u8 addr;
 	unsigned int mode;
 	bool is_last_msg;
@@ -330,9 +335,32 @@ static void rk3x_i2c_prepare_read(struct rk3x_i2c *i2c)
 	i2c_writel(i2c, len, REG_MRXCNT);
 }
 
+/**
+ * rk3x_i2c_tx_pending - Check for data left to transmit
+ * @i2c: target controller data
+ *
+ * Moves on to the next message once i2c->msg is sent, as long as it is
+ * part of the same transfer.
+ *
+ * Return: true if there is data left to transmit.
+ */
+static bool rk3x_i2c_tx_pending(struct rk3x_i2c *i2c)
+{
+	while (i2c->processed == i2c->msg->len && i2c->msg != i2c->msg_last) {
+		i2c->msg++;
+		i2c->processed = 0;
+	}
+
+	return i2c->processed != i2c->msg->len;
+}
+
 /**
  * rk3x_i2c_fill_transmit_buf - Fill the transmit buffer with data from i2c->msg
  * @i2c: target controller data
+ *
+ * The buffer is filled across message boundaries up to i2c->msg_last, so
+ * that a write split into I2C_M_NOSTART segments still moves 32 bytes per
+ * interrupt.
  */
 static void rk3x_i2c_fill_transmit_buf(struct rk3x_i2c *i2c)
 {
@@ -344,13 +372,15 @@ static void rk3x_i2c_fill_transmit_buf(struct rk3x_i2c *i2c)
 	for (i = 0; i < 8; ++i) {
 		val = 0;
 		for (j = 0; j < 4; ++j) {
-			if ((i2c->processed == i2c->msg->len) && (cnt != 0))
+			if (!rk3x_i2c_tx_pending(i2c) && (cnt != 0))
 				break;
 
-			if (i2c->processed == 0 && cnt == 0)
+			if (!i2c->addr_sent) {
 				byte = (i2c->addr & 0x7f) << 1;
-			else
+				i2c->addr_sent = true;
+			} else {
 				byte = i2c->msg->buf[i2c->processed++];
+			}
 
 			val |= byte << (j * 8);
 			cnt++;
@@ -358,7 +388,7 @@ static void rk3x_i2c_fill_transmit_buf(struct rk3x_i2c *i2c)
 
 		i2c_writel(i2c, val, TXBUFFER_BASE + 4 * i);
 
-		if (i2c->processed == i2c->msg->len)
+		if (!rk3x_i2c_tx_pending(i2c))
 			break;
 	}
 
@@ -409,7 +439,7 @@ static void rk3x_i2c_handle_write(struct rk3x_i2c *i2c, unsigned int ipd)
 	i2c_writel(i2c, REG_INT_MBTF, REG_IPD);
 
 	/* are we finished? */
-	if (i2c->processed == i2c->msg->len)
+	if (!rk3x_i2c_tx_pending(i2c))
 		rk3x_i2c_stop(i2c, i2c->error);
 	else
 		rk3x_i2c_fill_transmit_buf(i2c);
@@ -997,6 +1027,7 @@ static int rk3x_i2c_setup(struct rk3x_i2c *i2c, struct i2c_msg *msgs, int num)
 
 		/* msgs[0] is handled by hw. */
 		i2c->msg = &msgs[1];
+		i2c->msg_last = &msgs[1];
 
 		i2c->mode = REG_CON_MOD_REGISTER_TX;
 
@@ -1021,15 +1052,26 @@ static int rk3x_i2c_setup(struct rk3x_i2c *i2c, struct i2c_msg *msgs, int num)
 			i2c_writel(i2c, addr | REG_MRXADDR_VALID(0),
 				   REG_MRXADDR);
 			i2c_writel(i2c, 0, REG_MRXRADDR);
+			ret = 1;
 		} else {
 			i2c->mode = REG_CON_MOD_TX;
+
+			/*
+			 * Writes that go on without a START are sent in the
+			 * same transfer, e.g. an SMBus block write put
+			 * together from a header and a payload.
+			 */
+			for (ret = 1; ret < num; ret++)
+				if ((msgs[ret].flags & I2C_M_RD) ||
+				    !(msgs[ret].flags & I2C_M_NOSTART))
+					break;
 		}
 
 		i2c->msg = &msgs[0];
-
-		ret = 1;
+		i2c->msg_last = &msgs[ret - 1];
 	}
 
+	i2c->addr_sent = false;
 	i2c->addr = msgs[0].addr;
 	i2c->busy = true;
 	i2c->state = STATE_START;
@@ -1054,6 +1096,61 @@ static int rk3x_i2c_wait_xfer_poll(struct rk3x_i2c *i2c)
 	return !i2c->busy;
 }
 
+/*
+ * Short transfers, like the register reads PMICs get all the time, are
+ * over in about the time it takes to go to sleep and be woken up again.
+ * Spin for those, and only sleep if they take longer than they should.
+ */
+static bool rk3x_i2c_wait_xfer_spin(struct rk3x_i2c *i2c,
+				    struct i2c_msg *msgs, int num)
+{
+	unsigned int bytes = 0;
+	ktime_t timeout;
+	u64 us;
+	int i;
+
+	/* data plus one slave address per message, 9 clocks each */
+	for (i = 0; i < num; i++)
+		bytes += msgs[i].len + 1;
+
+	us = DIV_ROUND_UP_ULL((u64)bytes * 9 * USEC_PER_SEC,
+			      i2c->t.bus_freq_hz);
+	if (us > SPIN_TIMEOUT / 2)
+		return false;
+
+	timeout = ktime_add_us(ktime_get(), 2 * us);
+
+	while (READ_ONCE(i2c->busy)) {
+		if (ktime_after(ktime_get(), timeout))
+			return false;
+		cpu_relax();
+	}
+
+	return true;
+}
+
+/*
+ * The controller can only continue a write without a START, by chaining
+ * it into the transfer of the write before it (see rk3x_i2c_setup()).
+ * A read, or anything following a read, always starts afresh; that also
+ * covers the end of a register mode transfer, which is a read.
+ */
+static int rk3x_i2c_check_nostart(struct i2c_msg *msgs, int num)
+{
+	int i;
+
+	for (i = 0; i < num; i++) {
+		if (!(msgs[i].flags & I2C_M_NOSTART))
+			continue;
+
+		if (!i || (msgs[i].flags & I2C_M_RD) ||
+		    (msgs[i - 1].flags & I2C_M_RD))
+			return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
 static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 				struct i2c_msg *msgs, int num, bool polling)
 {
@@ -1063,6 +1160,10 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 	int ret = 0;
 	int i;
 
+	ret = rk3x_i2c_check_nostart(msgs, num);
+	if (ret)
+		return ret;
+
 	spin_lock_irqsave(&i2c->lock, flags);
 
 	clk_enable(i2c->clk);
@@ -1090,8 +1191,11 @@ static int rk3x_i2c_xfer_common(struct i2c_adapter *adap,
 		rk3x_i2c_start(i2c);
 
 		if (!polling) {
-			timeout = wait_event_timeout(i2c->wait, !i2c->busy,
-						     msecs_to_jiffies(WAIT_TIMEOUT));
+			if (rk3x_i2c_wait_xfer_spin(i2c, msgs + i, ret))
+				timeout = 1;
+			else
+				timeout = wait_event_timeout(i2c->wait, !i2c->busy,
+							     msecs_to_jiffies(WAIT_TIMEOUT));
 		} else {
 			timeout = rk3x_i2c_wait_xfer_poll(i2c);
 		}
@@ -1151,7 +1255,9 @@ static __maybe_unused int rk3x_i2c_resume(struct device *dev)
 
 static u32 rk3x_i2c_func(struct i2c_adapter *adap)
 {
-	return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL | I2C_FUNC_PROTOCOL_MANGLING;
+	/* I2C_M_NOSTART is only supported on writes following a write */
+	return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL | I2C_FUNC_PROTOCOL_MANGLING |
+	       I2C_FUNC_NOSTART;
 }
 
 static const struct i2c_algorithm rk3x_i2c_algorithm = {
@@ -8,6 +8,7 @@
 #include <linux/platform_device.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/clk.h>
@@ -35,6 +36,7 @@
 #define SARADC_DLY_PU_SOC_MASK		0x3f
 
 #define SARADC_TIMEOUT			msecs_to_jiffies(100)
+#define SARADC_POLL_TIMEOUT_US		10000
 #define SARADC_MAX_CHANNELS		8
 
 struct rockchip_saradc_data {
@@ -85,6 +87,37 @@ static int rockchip_saradc_conversion(struct rockchip_saradc *info,
 	return 0;
 }
 
+/*
+ * Buffered scans run back to back from the trigger handler, so wait for
+ * the end of conversion by polling the status bit rather than taking an
+ * interrupt and a wakeup for every channel of every scan.
+ */
+static int rockchip_saradc_conversion_polled(struct rockchip_saradc *info,
+					     struct iio_chan_spec const *chan,
+					     u16 *val)
+{
+	u32 ctrl;
+	int ret;
+
+	/* 8 clock periods as delay between power up and start cmd */
+	writel_relaxed(8, info->regs + SARADC_DLY_PU_SOC);
+
+	writel(SARADC_CTRL_POWER_CTRL | (chan->channel & SARADC_CTRL_CHN_MASK),
+	       info->regs + SARADC_CTRL);
+
+	ret = readl_poll_timeout(info->regs + SARADC_CTRL, ctrl,
+				 ctrl & SARADC_CTRL_IRQ_STATUS, 1,
+				 SARADC_POLL_TIMEOUT_US);
+	if (!ret) {
+		*val = readl_relaxed(info->regs + SARADC_DATA);
+		*val &= GENMASK(chan->scan_type.realbits - 1, 0);
+	}
+
+	rockchip_saradc_power_down(info);
+
+	return ret;
+}
+
 static int rockchip_saradc_read_raw(struct iio_dev *indio_dev,
 				    struct iio_chan_spec const *chan,
 				    int *val, int *val2, long mask)
@@ -275,13 +308,11 @@ static irqreturn_t rockchip_saradc_trigger_handler(int irq, void *p)
 	for_each_set_bit(i, i_dev->active_scan_mask, i_dev->masklength) {
 		const struct iio_chan_spec *chan = &i_dev->channels[i];
 
-		ret = rockchip_saradc_conversion(info, chan);
-		if (ret) {
-			rockchip_saradc_power_down(info);
+		ret = rockchip_saradc_conversion_polled(info, chan,
+							&data.values[j]);
+		if (ret)
 			goto out;
-		}
 
-		data.values[j] = info->last_val;
 		j++;
 	}
 
@@ -6,8 +6,10 @@
  *			Daniel Kurtz <djkurtz@chromium.org>
  */
 
+#include <linux/atomic.h>
 #include <linux/clk.h>
 #include <linux/compiler.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/dma-mapping.h>
@@ -23,6 +25,9 @@
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/seq_file.h>
+#include <linux/shrinker.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 
@@ -79,6 +84,23 @@
   */
 #define RK_IOMMU_PGSIZE_BITMAP 0x007ff000
 
+/* IOVA span covered by a single page table */
+#define RK_IOMMU_PT_SPAN (NUM_PT_ENTRIES * SPAGE_SIZE)
+
+/*
+ * Invalidating more than this many bytes one IOTLB line at a time costs
+ * more MMIO writes than refilling the IOTLB after a single ZAP_CACHE.
+ */
+#define RK_IOMMU_ZAP_ALL_THRESHOLD SZ_1M
+
+/* IOTLB invalidation counters, exported through debugfs */
+struct rk_iommu_zap_stats {
+	atomic64_t unmaps;	/* unmap calls gathered for a deferred sync */
+	atomic64_t syncs;	/* iotlb_sync calls flushing a gathered range */
+	atomic64_t zap_lines;	/* ZAP_ONE_LINE writes, per MMU */
+	atomic64_t zap_all;	/* ZAP_CACHE commands, per MMU */
+};
+
 struct rk_iommu_domain {
 	struct list_head iommus;
 	u32 *dt; /* page directory table */
@@ -86,6 +108,9 @@ struct rk_iommu_domain {
 	spinlock_t iommus_lock; /* lock for iommus list */
 	spinlock_t dt_lock; /* lock for modifying page directory table */
 
+	struct rk_iommu_zap_stats stats;
+	struct dentry *debugfs;
+
 	struct iommu_domain domain;
 };
 
@@ -122,6 +147,28 @@ struct rk_iommudata {
 
 static struct device *dma_dev;
 static const struct rk_iommu_ops *rk_ops;
+static struct dentry *rk_iommu_debugfs_dir;
+
+/*
+ * All page tables are mapped for dma_dev, so a page table released by one
+ * domain can be handed as is to the next one, already zeroed and cleaned
+ * to memory. Keep a small pool of them, so that recycling domains avoids
+ * both the page allocator and dma_map_single(). The pool is refilled to
+ * RK_PT_POOL_LOW pages when a domain is allocated and trimmed by a
+ * shrinker under memory pressure.
+ */
+#define RK_PT_POOL_LOW	8
+#define RK_PT_POOL_MAX	64
+
+static struct rk_pt_pool {
+	spinlock_t lock; /* protects pages and count */
+	struct list_head pages; /* linked through page->lru */
+	unsigned int count;
+	struct shrinker shrinker;
+} rk_pt_pool = {
+	.lock = __SPIN_LOCK_UNLOCKED(rk_pt_pool.lock),
+	.pages = LIST_HEAD_INIT(rk_pt_pool.pages),
+};
 
 static inline void rk_table_flush(struct rk_iommu_domain *dom, dma_addr_t dma,
 				  unsigned int count)
@@ -136,6 +183,100 @@ static struct rk_iommu_domain *to_rk_domain(struct iommu_domain *dom)
 	return container_of(dom, struct rk_iommu_domain, domain);
 }
 
+static u32 *rk_pt_pool_get(dma_addr_t *pt_dma)
+{
+	struct page *page;
+	unsigned long flags;
+
+	spin_lock_irqsave(&rk_pt_pool.lock, flags);
+	page = list_first_entry_or_null(&rk_pt_pool.pages, struct page, lru);
+	if (page) {
+		list_del(&page->lru);
+		rk_pt_pool.count--;
+	}
+	spin_unlock_irqrestore(&rk_pt_pool.lock, flags);
+
+	if (!page)
+		return NULL;
+
+	*pt_dma = page_private(page);
+	return page_address(page);
+}
+
+static void rk_pt_free(u32 *page_table, dma_addr_t pt_dma)
+{
+	dma_unmap_single(dma_dev, pt_dma, SPAGE_SIZE, DMA_TO_DEVICE);
+	free_page((unsigned long)page_table);
+}
+
+/* Called in sleepable context, the page is cleared and cleaned here */
+static void rk_pt_pool_put(u32 *page_table, dma_addr_t pt_dma)
+{
+	struct page *page = virt_to_page(page_table);
+	unsigned long flags;
+
+	if (READ_ONCE(rk_pt_pool.count) >= RK_PT_POOL_MAX) {
+		rk_pt_free(page_table, pt_dma);
+		return;
+	}
+
+	clear_page(page_table);
+	dma_sync_single_for_device(dma_dev, pt_dma, SPAGE_SIZE, DMA_TO_DEVICE);
+	set_page_private(page, pt_dma);
+
+	spin_lock_irqsave(&rk_pt_pool.lock, flags);
+	list_add(&page->lru, &rk_pt_pool.pages);
+	rk_pt_pool.count++;
+	spin_unlock_irqrestore(&rk_pt_pool.lock, flags);
+}
+
+static void rk_pt_pool_refill(void)
+{
+	while (READ_ONCE(rk_pt_pool.count) < RK_PT_POOL_LOW) {
+		u32 *page_table;
+		dma_addr_t pt_dma;
+
+		page_table = (u32 *)get_zeroed_page(GFP_KERNEL | GFP_DMA32);
+		if (!page_table)
+			return;
+
+		pt_dma = dma_map_single(dma_dev, page_table, SPAGE_SIZE,
+					DMA_TO_DEVICE);
+		if (dma_mapping_error(dma_dev, pt_dma)) {
+			free_page((unsigned long)page_table);
+			return;
+		}
+
+		rk_pt_pool_put(page_table, pt_dma);
+	}
+}
+
+static unsigned long rk_pt_pool_count(struct shrinker *shrinker,
+				      struct shrink_control *sc)
+{
+	return READ_ONCE(rk_pt_pool.count) ?: SHRINK_EMPTY;
+}
+
+static unsigned long rk_pt_pool_scan(struct shrinker *shrinker,
+				     struct shrink_control *sc)
+{
+	unsigned long freed = 0;
+
+	while (freed < sc->nr_to_scan) {
+		dma_addr_t pt_dma;
+		u32 *page_table;
+
+		page_table = rk_pt_pool_get(&pt_dma);
+		if (!page_table)
+			break;
+
+		rk_pt_free(page_table, pt_dma);
+		freed++;
+	}
+
+	return freed ?: SHRINK_STOP;
+}
+
 /*
  * The Rockchip rk3288 iommu uses a 2-level page table.
  * The first level is the "Directory Table" (DT).
@@ -357,10 +498,12 @@ static void rk_iommu_zap_lines(struct rk_iommu *iommu, dma_addr_t iova_start,
 {
 	int i;
 	dma_addr_t iova_end = iova_start + size;
-	/*
-	 * TODO(djkurtz): Figure out when it is more efficient to shootdown the
-	 * entire iotlb rather than iterate over individual iovas.
-	 */
+
+	if (size > RK_IOMMU_ZAP_ALL_THRESHOLD) {
+		rk_iommu_command(iommu, RK_MMU_CMD_ZAP_CACHE);
+		return;
+	}
+
 	for (i = 0; i < iommu->num_mmu; i++) {
 		dma_addr_t iova;
 
@@ -696,6 +839,14 @@ static void rk_iommu_zap_iova(struct rk_iommu_domain *rk_domain,
 			rk_iommu_zap_lines(iommu, iova, size);
 			clk_bulk_disable(iommu->num_clocks, iommu->clocks);
 			pm_runtime_put(iommu->dev);
+
+			if (size > RK_IOMMU_ZAP_ALL_THRESHOLD)
+				atomic64_add(iommu->num_mmu,
+					     &rk_domain->stats.zap_all);
+			else
+				atomic64_add(iommu->num_mmu *
+					     DIV_ROUND_UP(size, SPAGE_SIZE),
+					     &rk_domain->stats.zap_lines);
 		}
 	}
 	spin_unlock_irqrestore(&rk_domain->iommus_lock, flags);
@@ -726,6 +877,10 @@ static u32 *rk_dte_get_page_table(struct rk_iommu_domain *rk_domain,
 	if (rk_dte_is_pt_valid(dte))
 		goto done;
 
+	page_table = rk_pt_pool_get(&pt_dma);
+	if (page_table)
+		goto install;
+
 	page_table = (u32 *)get_zeroed_page(GFP_ATOMIC | GFP_DMA32);
 	if (!page_table)
 		return ERR_PTR(-ENOMEM);
@@ -737,11 +892,10 @@ static u32 *rk_dte_get_page_table(struct rk_iommu_domain *rk_domain,
 		return ERR_PTR(-ENOMEM);
 	}
 
+install:
+	/* The new DTE is flushed to memory by rk_iommu_iotlb_sync_map() */
 	dte = rk_ops->mk_dtentries(pt_dma);
 	*dte_addr = dte;
-
-	rk_table_flush(rk_domain,
-		       rk_domain->dt_dma + dte_index * sizeof(u32), 1);
 done:
 	pt_phys = rk_ops->pt_address(dte);
 	return (u32 *)phys_to_virt(pt_phys);
@@ -790,16 +944,10 @@ static int rk_iommu_map_iova(struct rk_iommu_domain *rk_domain, u32 *pte_addr,
 		paddr += SPAGE_SIZE;
 	}
 
-	rk_table_flush(rk_domain, pte_dma, pte_total);
-
 	/*
-	 * Zap the first and last iova to evict from iotlb any previously
-	 * mapped cachelines holding stale values for its dte and pte.
-	 * We only zap the first and last iova, since only they could have
-	 * dte or pte shared with an existing mapping.
+	 * The new PTEs are flushed to memory, and the iotlb is zapped, once
+	 * for the whole mapping by rk_iommu_iotlb_sync_map().
 	 */
-	rk_iommu_zap_iova_first_last(rk_domain, iova, size);
-
 	return 0;
 unwind:
 	/* Unmap the range of iovas that we just mapped */
@@ -814,44 +962,104 @@ static int rk_iommu_map_iova(struct rk_iommu_domain *rk_domain, u32 *pte_addr,
 	return -EADDRINUSE;
 }
 
-static int rk_iommu_map(struct iommu_domain *domain, unsigned long _iova,
-			phys_addr_t paddr, size_t size, int prot, gfp_t gfp)
+static int rk_iommu_map_pages(struct iommu_domain *domain, unsigned long _iova,
+			      phys_addr_t paddr, size_t pgsize, size_t pgcount,
+			      int prot, gfp_t gfp, size_t *mapped)
 {
 	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
 	unsigned long flags;
 	dma_addr_t pte_dma, iova = (dma_addr_t)_iova;
+	size_t size = pgsize * pgcount;
 	u32 *page_table, *pte_addr;
-	u32 dte_index, pte_index;
-	int ret;
+	u32 dte, pte_index;
+	int ret = 0;
 
 	spin_lock_irqsave(&rk_domain->dt_lock, flags);
 
 	/*
 	 * pgsize_bitmap specifies iova sizes that fit in one page table
-	 * (1024 4-KiB pages = 4 MiB).
-	 * So, size will always be 4096 <= size <= 4194304.
-	 * Since iommu_map() guarantees that both iova and size will be
-	 * aligned, we will always only be mapping from a single dte here.
+	 * (1024 4-KiB pages = 4 MiB), but a run of 4 MiB pages spans several
+	 * dtes. Fill them one page table at a time.
 	 */
-	page_table = rk_dte_get_page_table(rk_domain, iova);
-	if (IS_ERR(page_table)) {
-		spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
-		return PTR_ERR(page_table);
-	}
+	while (size) {
+		size_t chunk = min_t(size_t, size, RK_IOMMU_PT_SPAN -
+				     (iova & (RK_IOMMU_PT_SPAN - 1)));
 
-	dte_index = rk_domain->dt[rk_iova_dte_index(iova)];
-	pte_index = rk_iova_pte_index(iova);
-	pte_addr = &page_table[pte_index];
+		page_table = rk_dte_get_page_table(rk_domain, iova);
+		if (IS_ERR(page_table)) {
+			ret = PTR_ERR(page_table);
+			break;
+		}
+
+		dte = rk_domain->dt[rk_iova_dte_index(iova)];
+		pte_index = rk_iova_pte_index(iova);
+		pte_addr = &page_table[pte_index];
 
-	pte_dma = rk_ops->pt_address(dte_index) + pte_index * sizeof(u32);
-	ret = rk_iommu_map_iova(rk_domain, pte_addr, pte_dma, iova,
-				paddr, size, prot);
+		pte_dma = rk_ops->pt_address(dte) + pte_index * sizeof(u32);
+		ret = rk_iommu_map_iova(rk_domain, pte_addr, pte_dma, iova,
+					paddr, chunk, prot);
+		if (ret)
+			break;
+
+		iova += chunk;
+		paddr += chunk;
+		size -= chunk;
+		*mapped += chunk;
+	}
 
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
 
 	return ret;
 }
 
+static void rk_iommu_iotlb_sync_map(struct iommu_domain *domain,
+				    unsigned long _iova, size_t size)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+	dma_addr_t iova = (dma_addr_t)_iova;
+	dma_addr_t iova_last = iova + size - 1;
+	u32 dte_first, dte_last, i;
+	unsigned long flags;
+
+	if (!size)
+		return;
+
+	dte_first = rk_iova_dte_index(iova);
+	dte_last = rk_iova_dte_index(iova_last);
+
+	spin_lock_irqsave(&rk_domain->dt_lock, flags);
+
+	/* Clean each dte and page table touched by the mapping exactly once */
+	rk_table_flush(rk_domain, rk_domain->dt_dma + dte_first * sizeof(u32),
+		       dte_last - dte_first + 1);
+
+	for (i = dte_first; i <= dte_last; i++) {
+		u32 dte = rk_domain->dt[i];
+		u32 pte_first, pte_last;
+
+		if (!rk_dte_is_pt_valid(dte))
+			continue;
+
+		pte_first = i == dte_first ? rk_iova_pte_index(iova) : 0;
+		pte_last = i == dte_last ? rk_iova_pte_index(iova_last) :
+					   NUM_PT_ENTRIES - 1;
+
+		rk_table_flush(rk_domain, rk_ops->pt_address(dte) +
+				       pte_first * sizeof(u32),
+			       pte_last - pte_first + 1);
+	}
+
+	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
+
+	/*
+	 * Zap the first and last iova to evict from iotlb any previously
+	 * mapped cachelines holding stale values for its dte and pte.
+	 * We only zap the first and last iova, since only they could have
+	 * dte or pte shared with an existing mapping.
+	 */
+	rk_iommu_zap_iova_first_last(rk_domain, iova, size);
+}
+
 static size_t rk_iommu_unmap(struct iommu_domain *domain, unsigned long _iova,
 			     size_t size, struct iommu_iotlb_gather *gather)
 {
@@ -886,12 +1094,50 @@ static size_t rk_iommu_unmap(struct iommu_domain *domain, unsigned long _iova,
 
 	spin_unlock_irqrestore(&rk_domain->dt_lock, flags);
 
-	/* Shootdown iotlb entries for iova range that was just unmapped */
-	rk_iommu_zap_iova(rk_domain, iova, unmap_size);
+	if (!unmap_size)
+		return 0;
+
+	/*
+	 * Defer the shootdown of the iotlb entries for the iova range that
+	 * was just unmapped to rk_iommu_iotlb_sync(), so that unmapping a
+	 * large buffer one page table at a time costs a single invalidation.
+	 * Page tables are never freed on unmap, so no walk can see stale
+	 * table memory in the meantime. A queued gather is flushed later
+	 * with rk_iommu_flush_iotlb_all() instead.
+	 */
+	atomic64_inc(&rk_domain->stats.unmaps);
+	if (iommu_iotlb_gather_queued(gather))
+		return unmap_size;
+
+	if (iommu_iotlb_gather_is_disjoint(gather, iova, unmap_size))
+		iommu_iotlb_sync(domain, gather);
+	iommu_iotlb_gather_add_range(gather, iova, unmap_size);
 
 	return unmap_size;
 }
 
+static void rk_iommu_iotlb_sync(struct iommu_domain *domain,
+				struct iommu_iotlb_gather *gather)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+
+	/* Nothing was gathered */
+	if (!gather->end)
+		return;
+
+	atomic64_inc(&rk_domain->stats.syncs);
+	rk_iommu_zap_iova(rk_domain, gather->start,
+			  gather->end - gather->start + 1);
+}
+
+static void rk_iommu_flush_iotlb_all(struct iommu_domain *domain)
+{
+	struct rk_iommu_domain *rk_domain = to_rk_domain(domain);
+
+	/* Any size above RK_IOMMU_ZAP_ALL_THRESHOLD zaps the whole cache */
+	rk_iommu_zap_iova(rk_domain, 0, SIZE_MAX);
+}
+
 static struct rk_iommu *rk_iommu_from_dev(struct device *dev)
 {
 	struct rk_iommudata *data = dev_iommu_priv_get(dev);
@@ -1028,6 +1274,36 @@ static int rk_iommu_attach_device(struct iommu_domain *domain,
 	return ret;
 }
 
+static int rk_iommu_zap_stats_show(struct seq_file *s, void *unused)
+{
+	struct rk_iommu_domain *rk_domain = s->private;
+	struct rk_iommu_zap_stats *stats = &rk_domain->stats;
+
+	seq_printf(s, "unmaps:    %lld\n", atomic64_read(&stats->unmaps));
+	seq_printf(s, "syncs:     %lld\n", atomic64_read(&stats->syncs));
+	seq_printf(s, "zap_lines: %lld\n", atomic64_read(&stats->zap_lines));
+	seq_printf(s, "zap_all:   %lld\n", atomic64_read(&stats->zap_all));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rk_iommu_zap_stats);
+
+static void rk_iommu_domain_debugfs_init(struct rk_iommu_domain *rk_domain)
+{
+	static atomic_t domain_id = ATOMIC_INIT(0);
+	char name[16];
+
+	if (!rk_iommu_debugfs_dir)
+		return;
+
+	snprintf(name, sizeof(name), "domain%d",
+		 atomic_inc_return(&domain_id));
+	rk_domain->debugfs = debugfs_create_file(name, 0444,
+						 rk_iommu_debugfs_dir,
+						 rk_domain,
+						 &rk_iommu_zap_stats_fops);
+}
+
 static struct iommu_domain *rk_iommu_domain_alloc(unsigned type)
 {
 	struct rk_iommu_domain *rk_domain;
@@ -1066,6 +1342,9 @@ static struct iommu_domain *rk_iommu_domain_alloc(unsigned type)
 	rk_domain->domain.geometry.aperture_end   = DMA_BIT_MASK(32);
 	rk_domain->domain.geometry.force_aperture = true;
 
+	rk_iommu_domain_debugfs_init(rk_domain);
+	rk_pt_pool_refill();
+
 	return &rk_domain->domain;
 
 err_free_dt:
@@ -1083,14 +1362,15 @@ static void rk_iommu_domain_free(struct iommu_domain *domain)
 
 	WARN_ON(!list_empty(&rk_domain->iommus));
 
+	debugfs_remove(rk_domain->debugfs);
+
 	for (i = 0; i < NUM_DT_ENTRIES; i++) {
 		u32 dte = rk_domain->dt[i];
 		if (rk_dte_is_pt_valid(dte)) {
 			phys_addr_t pt_phys = rk_ops->pt_address(dte);
 			u32 *page_table = phys_to_virt(pt_phys);
-			dma_unmap_single(dma_dev, pt_phys,
-					 SPAGE_SIZE, DMA_TO_DEVICE);
-			free_page((unsigned long)page_table);
+
+			rk_pt_pool_put(page_table, pt_phys);
 		}
 	}
 
@@ -1164,8 +1444,11 @@ static const struct iommu_ops rk_iommu_ops = {
 	.default_domain_ops = &(const struct iommu_domain_ops) {
 		.attach_dev	= rk_iommu_attach_device,
 		.detach_dev	= rk_iommu_detach_device,
-		.map		= rk_iommu_map,
+		.map_pages	= rk_iommu_map_pages,
 		.unmap		= rk_iommu_unmap,
+		.flush_iotlb_all = rk_iommu_flush_iotlb_all,
+		.iotlb_sync_map	= rk_iommu_iotlb_sync_map,
+		.iotlb_sync	= rk_iommu_iotlb_sync,
 		.iova_to_phys	= rk_iommu_iova_to_phys,
 		.free		= rk_iommu_domain_free,
 	}
@@ -1266,9 +1549,22 @@ static int rk_iommu_probe(struct platform_device *pdev)
 	 * API, since a domain might not physically correspond to a single
 	 * IOMMU device..
 	 */
-	if (!dma_dev)
+	if (!dma_dev) {
 		dma_dev = &pdev->dev;
 
+		rk_pt_pool.shrinker.count_objects = rk_pt_pool_count;
+		rk_pt_pool.shrinker.scan_objects = rk_pt_pool_scan;
+		rk_pt_pool.shrinker.seeks = DEFAULT_SEEKS;
+		if (register_shrinker(&rk_pt_pool.shrinker, "rk-iommu-pt"))
+			dev_warn(dev, "failed to register page table pool shrinker\n");
+	}
+
+#ifdef CONFIG_IOMMU_DEBUGFS
+	if (!rk_iommu_debugfs_dir)
+		rk_iommu_debugfs_dir = debugfs_create_dir("rockchip",
+							  iommu_debugfs_dir);
+#endif
+
 	pm_runtime_enable(dev);
 
 	for (i = 0; i < iommu->num_irq; i++) {
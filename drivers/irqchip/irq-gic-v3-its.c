@@ -10,6 +10,7 @@
 #include <linux/bitmap.h>
 #include <linux/cpu.h>
 #include <linux/crash_dump.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/efi.h>
 #include <linux/interrupt.h>
@@ -27,6 +28,8 @@
 #include <linux/of_pci.h>
 #include <linux/of_platform.h>
 #include <linux/percpu.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/syscore_ops.h>
 
@@ -86,6 +89,15 @@ struct its_baser {
 
 struct its_device;
 
+/* Command queue statistics, exported through debugfs */
+struct its_cmdq_stats {
+	atomic64_t		waits;		/* completions waited for */
+	atomic64_t		posted;		/* commands not waited for */
+	atomic64_t		wait_ns;	/* total time spent waiting */
+	atomic64_t		max_wait_ns;
+	atomic64_t		timeouts;
+};
+
 /*
  * The ITS structure - contains most of the infrastructure, with the
  * top-level MSI domain, the command queue, the collections, and the
@@ -119,6 +131,7 @@ struct its_node {
 	unsigned int		msi_domain_flags;
 	u32			pre_its_base; /* for Socionext Synquacer */
 	int			vlpi_redist_offset;
+	struct its_cmdq_stats	cmdq_stats;
 };
 
 #define is_v4(its)		(!!((its)->typer & GITS_TYPER_VLPIS))
@@ -1062,12 +1075,28 @@ static void its_flush_cmd(struct its_node *its, struct its_cmd_block *cmd)
 		dsb(ishst);
 }
 
+static void its_cmdq_account(struct its_node *its, u64 start, bool timeout)
+{
+	struct its_cmdq_stats *stats = &its->cmdq_stats;
+	s64 delta = local_clock() - start;
+	s64 max = atomic64_read(&stats->max_wait_ns);
+
+	atomic64_inc(&stats->waits);
+	atomic64_add(delta, &stats->wait_ns);
+	while (delta > max &&
+	       !atomic64_try_cmpxchg(&stats->max_wait_ns, &max, delta))
+		;
+	if (timeout)
+		atomic64_inc(&stats->timeouts);
+}
+
 static int its_wait_for_range_completion(struct its_node *its,
 					 u64	prev_idx,
 					 struct its_cmd_block *to)
 {
 	u64 rd_idx, to_idx, linear_idx;
 	u32 count = 1000000;	/* 1s! */
+	u64 start = local_clock();
 
 	/* Linearize to_idx if the command set has wrapped around */
 	to_idx = its_cmd_ptr_to_offset(its, to);
@@ -1097,6 +1126,7 @@ static int its_wait_for_range_completion(struct its_node *its,
 		if (!count) {
 			pr_err_ratelimited("ITS queue timeout (%llu %llu)\n",
 					   to_idx, linear_idx);
+			its_cmdq_account(its, start, true);
 			return -1;
 		}
 		prev_idx = rd_idx;
@@ -1104,14 +1134,23 @@ static int its_wait_for_range_completion(struct its_node *its,
 		udelay(1);
 	}
 
+	its_cmdq_account(its, start, false);
 	return 0;
 }
 
-/* Warning, macro hell follows */
+/*
+ * Warning, macro hell follows
+ *
+ * Commands are executed in order, so when @wait is false the completion
+ * is implied by the next command that is waited for. The helper sync
+ * command is still queued, so that the effects of the command are
+ * visible to the redistributors without that wait.
+ */
 #define BUILD_SINGLE_CMD_FUNC(name, buildtype, synctype, buildfn)	\
 void name(struct its_node *its,						\
 	  buildtype builder,						\
-	  struct its_cmd_desc *desc)					\
+	  struct its_cmd_desc *desc,					\
+	  bool wait)							\
 {									\
 	struct its_cmd_block *cmd, *sync_cmd, *next_cmd;		\
 	synctype *sync_obj;						\
@@ -1142,6 +1181,11 @@ post:									\
 	next_cmd = its_post_commands(its);				\
 	raw_spin_unlock_irqrestore(&its->lock, flags);			\
 									\
+	if (!wait) {							\
+		atomic64_inc(&its->cmdq_stats.posted);			\
+		return;							\
+	}								\
+									\
 	if (its_wait_for_range_completion(its, rd_idx, next_cmd))	\
 		pr_err_ratelimited("ITS cmd %ps failed\n", builder);	\
 }
@@ -1156,9 +1200,16 @@ static void its_build_sync_cmd(struct its_node *its,
 	its_fixup_cmd(sync_cmd);
 }
 
-static BUILD_SINGLE_CMD_FUNC(its_send_single_command, its_cmd_builder_t,
+static BUILD_SINGLE_CMD_FUNC(__its_send_single_command, its_cmd_builder_t,
 			     struct its_collection, its_build_sync_cmd)
 
+static void its_send_single_command(struct its_node *its,
+				    its_cmd_builder_t builder,
+				    struct its_cmd_desc *desc)
+{
+	__its_send_single_command(its, builder, desc, true);
+}
+
 static void its_build_vsync_cmd(struct its_node *its,
 				struct its_cmd_block *sync_cmd,
 				struct its_vpe *sync_vpe)
@@ -1169,9 +1220,16 @@ static void its_build_vsync_cmd(struct its_node *its,
 	its_fixup_cmd(sync_cmd);
 }
 
-static BUILD_SINGLE_CMD_FUNC(its_send_single_vcommand, its_cmd_vbuilder_t,
+static BUILD_SINGLE_CMD_FUNC(__its_send_single_vcommand, its_cmd_vbuilder_t,
 			     struct its_vpe, its_build_vsync_cmd)
 
+static void its_send_single_vcommand(struct its_node *its,
+				     its_cmd_vbuilder_t builder,
+				     struct its_cmd_desc *desc)
+{
+	__its_send_single_vcommand(its, builder, desc, true);
+}
+
 static void its_send_int(struct its_device *dev, u32 event_id)
 {
 	struct its_cmd_desc desc;
@@ -1243,7 +1301,14 @@ static void its_send_movi(struct its_device *dev,
 	desc.its_movi_cmd.col = col;
 	desc.its_movi_cmd.event_id = id;
 
-	its_send_single_command(dev->its, its_build_movi_cmd, &desc);
+	/*
+	 * Waiting for each MOVI makes rebalancing many LPIs stall on the
+	 * command queue once per interrupt. An LPI still delivered to the
+	 * old CPU in the meantime is handled there just fine, so only wait
+	 * when that CPU is going away.
+	 */
+	__its_send_single_command(dev->its, its_build_movi_cmd, &desc,
+				  !cpu_online(dev->event_map.col_map[id]));
 }
 
 static void its_send_discard(struct its_device *dev, u32 id)
@@ -5562,6 +5627,45 @@ int __init its_lpi_memreserve_init(void)
 	return 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int its_cmdq_stats_show(struct seq_file *m, void *v)
+{
+	struct its_node *its = m->private;
+	struct its_cmdq_stats *stats = &its->cmdq_stats;
+
+	seq_printf(m, "waits: %lld\n", atomic64_read(&stats->waits));
+	seq_printf(m, "posted: %lld\n", atomic64_read(&stats->posted));
+	seq_printf(m, "wait_ns: %lld\n", atomic64_read(&stats->wait_ns));
+	seq_printf(m, "max_wait_ns: %lld\n", atomic64_read(&stats->max_wait_ns));
+	seq_printf(m, "timeouts: %lld\n", atomic64_read(&stats->timeouts));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(its_cmdq_stats);
+
+static int __init its_debugfs_init(void)
+{
+	struct its_node *its;
+	struct dentry *dir;
+	char name[32];
+
+	if (list_empty(&its_nodes))
+		return 0;
+
+	dir = debugfs_create_dir("gic-its", NULL);
+
+	/* ITSs are never removed once probed */
+	list_for_each_entry(its, &its_nodes, entry) {
+		snprintf(name, sizeof(name), "its@%llx_cmdq",
+			 (unsigned long long)its->phys_base);
+		debugfs_create_file(name, 0444, dir, its, &its_cmdq_stats_fops);
+	}
+
+	return 0;
+}
+late_initcall(its_debugfs_init);
+#endif
+
 int __init its_init(struct fwnode_handle *handle, struct rdists *rdists,
 		    struct irq_domain *parent_domain)
 {
@@ -552,10 +552,15 @@ static int gic_irq_nmi_setup(struct irq_data *d)
 	if (gic_irq_in_rdist(d)) {
 		u32 idx = gic_get_ppi_index(d);
 
-		/* Setting up PPI as NMI, only switch handler for first NMI */
+		/*
+		 * Setting up PPI as NMI, only switch handler for first NMI.
+		 * A partitioned PPI keeps its chained handler, which deals
+		 * with NMIs itself.
+		 */
 		if (!refcount_inc_not_zero(&ppi_nmi_refs[idx])) {
 			refcount_set(&ppi_nmi_refs[idx], 1);
-			desc->handle_irq = handle_percpu_devid_fasteoi_nmi;
+			if (desc->handle_irq == handle_percpu_devid_irq)
+				desc->handle_irq = handle_percpu_devid_fasteoi_nmi;
 		}
 	} else {
 		desc->handle_irq = handle_fasteoi_nmi;
@@ -590,7 +595,8 @@ static void gic_irq_nmi_teardown(struct irq_data *d)
 		u32 idx = gic_get_ppi_index(d);
 
 		/* Tearing down NMI, only switch handler for last NMI */
-		if (refcount_dec_and_test(&ppi_nmi_refs[idx]))
+		if (refcount_dec_and_test(&ppi_nmi_refs[idx]) &&
+		    desc->handle_irq == handle_percpu_devid_fasteoi_nmi)
 			desc->handle_irq = handle_percpu_devid_irq;
 	} else {
 		desc->handle_irq = handle_fasteoi_irq;
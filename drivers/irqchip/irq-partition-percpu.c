@@ -19,6 +19,7 @@ struct partition_desc {
 	struct irq_domain		*domain;
 	struct irq_desc			*chained_desc;
 	unsigned long			*bitmap;
+	unsigned int			*nmi_refs;
 	struct irq_domain_ops		ops;
 };
 
@@ -92,6 +93,51 @@ static int partition_irq_set_type(struct irq_data *d, unsigned int type)
 	return -EINVAL;
 }
 
+/*
+ * The partitions share the parent PPI, so the NMI priority is set up on
+ * the parent for the CPUs of the partition only. The parent keeps the
+ * chained handler, which forwards NMIs to the partition flow handler.
+ */
+static int partition_irq_nmi_setup(struct irq_data *d)
+{
+	struct partition_desc *part = irq_data_get_irq_chip_data(d);
+	struct irq_chip *chip = irq_desc_get_chip(part->chained_desc);
+	struct irq_data *data = irq_desc_get_irq_data(part->chained_desc);
+	int ret;
+
+	if (!partition_check_cpu(part, smp_processor_id(), d->hwirq))
+		return 0;
+
+	if (!chip->irq_nmi_setup)
+		return -EINVAL;
+
+	ret = chip->irq_nmi_setup(data);
+	if (ret)
+		return ret;
+
+	/* desc lock should already be held */
+	if (!part->nmi_refs[d->hwirq]++)
+		irq_to_desc(d->irq)->handle_irq = handle_percpu_devid_fasteoi_nmi;
+
+	return 0;
+}
+
+static void partition_irq_nmi_teardown(struct irq_data *d)
+{
+	struct partition_desc *part = irq_data_get_irq_chip_data(d);
+	struct irq_chip *chip = irq_desc_get_chip(part->chained_desc);
+	struct irq_data *data = irq_desc_get_irq_data(part->chained_desc);
+
+	if (!partition_check_cpu(part, smp_processor_id(), d->hwirq) ||
+	    !chip->irq_nmi_teardown || WARN_ON(!part->nmi_refs[d->hwirq]))
+		return;
+
+	chip->irq_nmi_teardown(data);
+
+	if (!--part->nmi_refs[d->hwirq])
+		irq_to_desc(d->irq)->handle_irq = handle_percpu_devid_irq;
+}
+
 static void partition_irq_print_chip(struct irq_data *d, struct seq_file *p)
 {
 	struct partition_desc *part = irq_data_get_irq_chip_data(d);
@@ -107,7 +153,10 @@ static struct irq_chip partition_irq_chip = {
 	.irq_set_type		= partition_irq_set_type,
 	.irq_get_irqchip_state	= partition_irq_get_irqchip_state,
 	.irq_set_irqchip_state	= partition_irq_set_irqchip_state,
+	.irq_nmi_setup		= partition_irq_nmi_setup,
+	.irq_nmi_teardown	= partition_irq_nmi_teardown,
 	.irq_print_chip		= partition_irq_print_chip,
+	.flags			= IRQCHIP_SUPPORTS_NMI,
 };
 
 static void partition_handle_irq(struct irq_desc *desc)
@@ -126,6 +175,8 @@ static void partition_handle_irq(struct irq_desc *desc)
 
 	if (unlikely(hwirq == part->nr_parts))
 		handle_bad_irq(desc);
+	else if (in_nmi())
+		generic_handle_domain_nmi(part->domain, hwirq);
 	else
 		generic_handle_domain_irq(part->domain, hwirq);
 
@@ -219,6 +270,10 @@ struct partition_desc *partition_create_desc(struct fwnode_handle *fwnode,
 	if (WARN_ON(!desc->bitmap))
 		goto out;
 
+	desc->nmi_refs = kcalloc(nr_parts, sizeof(*desc->nmi_refs), GFP_KERNEL);
+	if (WARN_ON(!desc->nmi_refs))
+		goto out;
+
 	desc->chained_desc = irq_to_desc(chained_irq);
 	desc->nr_parts = nr_parts;
 	desc->parts = parts;
@@ -227,6 +282,7 @@ struct partition_desc *partition_create_desc(struct fwnode_handle *fwnode,
 out:
 	if (d)
 		irq_domain_remove(d);
+	bitmap_free(desc->bitmap);
 	kfree(desc);
 
 	return NULL;
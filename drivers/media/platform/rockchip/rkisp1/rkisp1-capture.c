@@ -399,6 +399,43 @@ static u32 rkisp1_pixfmt_comp_size(const struct v4l2_pix_format_mplane *pixm,
 	return pixm->plane_fmt[component].sizeimage;
 }
 
+/*
+ * In embedded mode the selfpath frame is appended to the last plane of each
+ * mainpath buffer, see V4L2_CID_RKISP1_EMBED_SELFPATH.
+ */
+static bool rkisp1_capture_embeds_sp(const struct rkisp1_capture *cap)
+{
+	return cap->embed_sp && cap->embed_sp->val;
+}
+
+static u32 rkisp1_capture_embed_size(struct rkisp1_capture *cap)
+{
+	const struct v4l2_pix_format_mplane *pixm =
+		&cap->rkisp1->capture_devs[RKISP1_SELFPATH].pix.fmt;
+	unsigned int i;
+	u32 size = 0;
+
+	if (!rkisp1_capture_embeds_sp(cap))
+		return 0;
+
+	for (i = 0; i < pixm->num_planes; i++)
+		size += pixm->plane_fmt[i].sizeimage;
+
+	return size;
+}
+
+static u32 rkisp1_capture_plane_size(struct rkisp1_capture *cap,
+				     unsigned int plane)
+{
+	const struct v4l2_pix_format_mplane *pixm = &cap->pix.fmt;
+	u32 size = pixm->plane_fmt[plane].sizeimage;
+
+	if (plane == pixm->num_planes - 1)
+		size += rkisp1_capture_embed_size(cap);
+
+	return size;
+}
+
 static void rkisp1_irq_frame_end_enable(struct rkisp1_capture *cap)
 {
 	u32 mi_imsc = rkisp1_read(cap->rkisp1, RKISP1_CIF_MI_IMSC);
@@ -614,19 +651,10 @@ static void rkisp1_dummy_buf_destroy(struct rkisp1_capture *cap)
 		       cap->buf.dummy.dma_addr, DMA_ATTR_NO_KERNEL_MAPPING);
 }
 
-static void rkisp1_set_next_buf(struct rkisp1_capture *cap)
+static void rkisp1_set_buf_addr(struct rkisp1_capture *cap,
+				const u32 *buff_addr)
 {
-	cap->buf.curr = cap->buf.next;
-	cap->buf.next = NULL;
-
-	if (!list_empty(&cap->buf.queue)) {
-		u32 *buff_addr;
-
-		cap->buf.next = list_first_entry(&cap->buf.queue, struct rkisp1_buffer, queue);
-		list_del(&cap->buf.next->queue);
-
-		buff_addr = cap->buf.next->buff_addr;
-
+	if (buff_addr) {
 		rkisp1_write(cap->rkisp1, cap->config->mi.y_base_ad_init,
 			     buff_addr[RKISP1_PLANE_Y]);
 		/*
@@ -668,6 +696,27 @@ static void rkisp1_set_next_buf(struct rkisp1_capture *cap)
 	rkisp1_write(cap->rkisp1, cap->config->mi.cr_offs_cnt_init, 0);
 }
 
+static void rkisp1_set_next_buf(struct rkisp1_capture *cap)
+{
+	struct rkisp1_buffer *next;
+
+	cap->buf.curr = cap->buf.next;
+	cap->buf.next = NULL;
+
+	if (!list_empty(&cap->buf.queue)) {
+		cap->buf.next = list_first_entry(&cap->buf.queue, struct rkisp1_buffer, queue);
+		list_del(&cap->buf.next->queue);
+	}
+
+	next = cap->buf.next;
+	rkisp1_set_buf_addr(cap, next ? next->buff_addr : NULL);
+
+	/* The selfpath follows the mainpath buffers when embedded */
+	if (cap->sp_embedded)
+		rkisp1_set_buf_addr(&cap->rkisp1->capture_devs[RKISP1_SELFPATH],
+				    next ? next->sp_buff_addr : NULL);
+}
+
 /*
  * This function is called when a frame end comes. The next frame
  * is processing and we should set up buffer for next-next frame,
@@ -694,10 +743,43 @@ static void rkisp1_handle_buffer(struct rkisp1_capture *cap)
 	spin_unlock(&cap->buf.lock);
 }
 
+/*
+ * In embedded mode a mainpath buffer can only be completed, and the next one
+ * programmed to both paths, once both paths are done with the current frame.
+ * Filter out the selfpath frame end and hold the mainpath one back until
+ * both have been seen.
+ */
+static u32 rkisp1_capture_embed_frame_end(struct rkisp1_capture *mp,
+					  u32 status)
+{
+	struct rkisp1_capture *sp = &mp->rkisp1->capture_devs[RKISP1_SELFPATH];
+	u32 frame_end = RKISP1_CIF_MI_FRAME(mp) | RKISP1_CIF_MI_FRAME(sp);
+
+	mp->embed_fe |= status & frame_end;
+	status &= ~RKISP1_CIF_MI_FRAME(sp);
+
+	if (mp->is_stopping || mp->embed_fe == frame_end)
+		mp->embed_fe = 0;
+	else
+		status &= ~RKISP1_CIF_MI_FRAME(mp);
+
+	return status;
+}
+
+static void rkisp1_capture_embed_stop(struct rkisp1_capture *mp)
+{
+	struct rkisp1_capture *sp = &mp->rkisp1->capture_devs[RKISP1_SELFPATH];
+
+	rkisp1_write(mp->rkisp1, RKISP1_CIF_MI_ICR, RKISP1_CIF_MI_FRAME(sp));
+	sp->ops->disable(sp);
+}
+
 irqreturn_t rkisp1_capture_isr(int irq, void *ctx)
 {
 	struct device *dev = ctx;
 	struct rkisp1_device *rkisp1 = dev_get_drvdata(dev);
+	struct rkisp1_capture *mp = &rkisp1->capture_devs[RKISP1_MAINPATH];
+	struct rkisp1_capture *sp = &rkisp1->capture_devs[RKISP1_SELFPATH];
 	unsigned int i;
 	u32 status;
 
@@ -707,6 +789,9 @@ irqreturn_t rkisp1_capture_isr(int irq, void *ctx)
 
 	rkisp1_write(rkisp1, RKISP1_CIF_MI_ICR, status);
 
+	if (mp->sp_embedded)
+		status = rkisp1_capture_embed_frame_end(mp, status);
+
 	for (i = 0; i < ARRAY_SIZE(rkisp1->capture_devs); ++i) {
 		struct rkisp1_capture *cap = &rkisp1->capture_devs[i];
 
@@ -724,8 +809,11 @@ irqreturn_t rkisp1_capture_isr(int irq, void *ctx)
 		 * frame end that sync the configurations to shadow
 		 * regs.
 		 */
-		if (!cap->ops->is_stopped(cap)) {
+		if (!cap->ops->is_stopped(cap) ||
+		    (cap->sp_embedded && !sp->ops->is_stopped(sp))) {
 			cap->ops->stop(cap);
+			if (cap->sp_embedded)
+				rkisp1_capture_embed_stop(cap);
 			continue;
 		}
 		cap->is_stopping = false;
@@ -755,17 +843,40 @@ static int rkisp1_vb2_queue_setup(struct vb2_queue *queue,
 			return -EINVAL;
 
 		for (i = 0; i < pixm->num_planes; i++)
-			if (sizes[i] < pixm->plane_fmt[i].sizeimage)
+			if (sizes[i] < rkisp1_capture_plane_size(cap, i))
 				return -EINVAL;
 	} else {
 		*num_planes = pixm->num_planes;
 		for (i = 0; i < pixm->num_planes; i++)
-			sizes[i] = pixm->plane_fmt[i].sizeimage;
+			sizes[i] = rkisp1_capture_plane_size(cap, i);
 	}
 
 	return 0;
 }
 
+static void rkisp1_embed_buf_init(struct rkisp1_capture *cap,
+				  struct rkisp1_buffer *ispbuf)
+{
+	struct rkisp1_capture *sp = &cap->rkisp1->capture_devs[RKISP1_SELFPATH];
+	const struct v4l2_pix_format_mplane *pixm = &sp->pix.fmt;
+	unsigned int last = cap->pix.fmt.num_planes - 1;
+	u32 *buff_addr = ispbuf->sp_buff_addr;
+
+	memset(ispbuf->sp_buff_addr, 0, sizeof(ispbuf->sp_buff_addr));
+
+	/* The selfpath planes follow the mainpath image in its last plane */
+	buff_addr[RKISP1_PLANE_Y] =
+		vb2_dma_contig_plane_dma_addr(&ispbuf->vb.vb2_buf, last) +
+		cap->pix.fmt.plane_fmt[last].sizeimage;
+	buff_addr[RKISP1_PLANE_CB] = buff_addr[RKISP1_PLANE_Y] +
+		rkisp1_pixfmt_comp_size(pixm, RKISP1_PLANE_Y);
+	buff_addr[RKISP1_PLANE_CR] = buff_addr[RKISP1_PLANE_CB] +
+		rkisp1_pixfmt_comp_size(pixm, RKISP1_PLANE_CB);
+
+	if (sp->pix.info->comp_planes == 3 && sp->pix.cfg->uv_swap)
+		swap(buff_addr[RKISP1_PLANE_CR], buff_addr[RKISP1_PLANE_CB]);
+}
+
 static int rkisp1_vb2_buf_init(struct vb2_buffer *vb)
 {
 	struct vb2_v4l2_buffer *vbuf = to_vb2_v4l2_buffer(vb);
@@ -796,6 +907,10 @@ static int rkisp1_vb2_buf_init(struct vb2_buffer *vb)
 	if (cap->pix.info->comp_planes == 3 && cap->pix.cfg->uv_swap)
 		swap(ispbuf->buff_addr[RKISP1_PLANE_CR],
 		     ispbuf->buff_addr[RKISP1_PLANE_CB]);
+
+	if (rkisp1_capture_embeds_sp(cap))
+		rkisp1_embed_buf_init(cap, ispbuf);
+
 	return 0;
 }
 
@@ -817,7 +932,7 @@ static int rkisp1_vb2_buf_prepare(struct vb2_buffer *vb)
 	unsigned int i;
 
 	for (i = 0; i < cap->pix.fmt.num_planes; i++) {
-		unsigned long size = cap->pix.fmt.plane_fmt[i].sizeimage;
+		unsigned long size = rkisp1_capture_plane_size(cap, i);
 
 		if (vb2_plane_size(vb, i) < size) {
 			dev_err(cap->rkisp1->dev,
@@ -864,14 +979,24 @@ static void rkisp1_cap_stream_enable(struct rkisp1_capture *cap)
 {
 	struct rkisp1_device *rkisp1 = cap->rkisp1;
 	struct rkisp1_capture *other = &rkisp1->capture_devs[cap->id ^ 1];
+	struct rkisp1_capture *sp = &rkisp1->capture_devs[RKISP1_SELFPATH];
+
+	cap->sp_embedded = rkisp1_capture_embeds_sp(cap);
+	cap->embed_fe = 0;
 
 	cap->ops->set_data_path(cap);
 	cap->ops->config(cap);
+	if (cap->sp_embedded) {
+		sp->ops->set_data_path(sp);
+		sp->ops->config(sp);
+	}
 
 	/* Setup a buffer for the next frame */
 	spin_lock_irq(&cap->buf.lock);
 	rkisp1_set_next_buf(cap);
 	cap->ops->enable(cap);
+	if (cap->sp_embedded)
+		sp->ops->enable(sp);
 	/* It's safe to configure ACTIVE and SHADOW registers for the
 	 * first stream. While when the second is starting, do NOT
 	 * force update because it also updates the first one.
@@ -903,9 +1028,13 @@ static void rkisp1_cap_stream_disable(struct rkisp1_capture *cap)
 	if (!ret) {
 		cap->rkisp1->debug.stop_timeout[cap->id]++;
 		cap->ops->stop(cap);
+		if (cap->sp_embedded)
+			rkisp1_capture_embed_stop(cap);
 		cap->is_stopping = false;
 		cap->is_streaming = false;
 	}
+
+	cap->sp_embedded = false;
 }
 
 /*
@@ -931,6 +1060,10 @@ static void rkisp1_pipeline_stream_disable(struct rkisp1_capture *cap)
 
 	v4l2_subdev_call(&rkisp1->resizer_devs[cap->id].sd, video, s_stream,
 			 false);
+
+	if (rkisp1_capture_embeds_sp(cap))
+		v4l2_subdev_call(&rkisp1->resizer_devs[RKISP1_SELFPATH].sd,
+				 video, s_stream, false);
 }
 
 /*
@@ -945,6 +1078,17 @@ static int rkisp1_pipeline_stream_enable(struct rkisp1_capture *cap)
 	struct rkisp1_device *rkisp1 = cap->rkisp1;
 	int ret;
 
+	/*
+	 * Configure the selfpath resizer first, while the mainpath isn't
+	 * streaming yet, so that its shadow registers are updated right away.
+	 */
+	if (rkisp1_capture_embeds_sp(cap)) {
+		ret = v4l2_subdev_call(&rkisp1->resizer_devs[RKISP1_SELFPATH].sd,
+				       video, s_stream, true);
+		if (ret)
+			return ret;
+	}
+
 	rkisp1_cap_stream_enable(cap);
 
 	ret = v4l2_subdev_call(&rkisp1->resizer_devs[cap->id].sd, video,
@@ -970,6 +1114,9 @@ static int rkisp1_pipeline_stream_enable(struct rkisp1_capture *cap)
 			 false);
 err_disable_cap:
 	rkisp1_cap_stream_disable(cap);
+	if (rkisp1_capture_embeds_sp(cap))
+		v4l2_subdev_call(&rkisp1->resizer_devs[RKISP1_SELFPATH].sd,
+				 video, s_stream, false);
 
 	return ret;
 }
@@ -993,21 +1140,49 @@ static void rkisp1_vb2_stop_streaming(struct vb2_queue *queue)
 		dev_err(rkisp1->dev, "power down failed error:%d\n", ret);
 
 	rkisp1_dummy_buf_destroy(cap);
+	if (rkisp1_capture_embeds_sp(cap))
+		rkisp1_dummy_buf_destroy(&rkisp1->capture_devs[RKISP1_SELFPATH]);
 
 	video_device_pipeline_stop(&node->vdev);
 
 	mutex_unlock(&cap->rkisp1->stream_lock);
 }
 
+static int rkisp1_capture_embed_validate(struct rkisp1_capture *cap)
+{
+	struct rkisp1_capture *mp = &cap->rkisp1->capture_devs[RKISP1_MAINPATH];
+	struct rkisp1_capture *sp = &cap->rkisp1->capture_devs[RKISP1_SELFPATH];
+
+	if (!rkisp1_capture_embeds_sp(mp))
+		return 0;
+
+	/* The selfpath is driven by the mainpath when embedded */
+	if (cap == sp)
+		return -EBUSY;
+
+	if (!media_pad_remote_pad_first(&sp->vnode.pad))
+		return -EPIPE;
+
+	return 0;
+}
+
 static int
 rkisp1_vb2_start_streaming(struct vb2_queue *queue, unsigned int count)
 {
 	struct rkisp1_capture *cap = queue->drv_priv;
+	struct rkisp1_capture *sp = &cap->rkisp1->capture_devs[RKISP1_SELFPATH];
 	struct media_entity *entity = &cap->vnode.vdev.entity;
 	int ret;
 
 	mutex_lock(&cap->rkisp1->stream_lock);
 
+	ret = rkisp1_capture_embed_validate(cap);
+	if (ret) {
+		dev_err(cap->rkisp1->dev, "invalid selfpath embedding %d\n",
+			ret);
+		goto err_ret_buffers;
+	}
+
 	ret = video_device_pipeline_start(&cap->vnode.vdev, &cap->rkisp1->pipe);
 	if (ret) {
 		dev_err(cap->rkisp1->dev, "start pipeline failed %d\n", ret);
@@ -1018,10 +1193,16 @@ rkisp1_vb2_start_streaming(struct vb2_queue *queue, unsigned int count)
 	if (ret)
 		goto err_pipeline_stop;
 
+	if (rkisp1_capture_embeds_sp(cap)) {
+		ret = rkisp1_dummy_buf_create(sp);
+		if (ret)
+			goto err_destroy_dummy;
+	}
+
 	ret = pm_runtime_resume_and_get(cap->rkisp1->dev);
 	if (ret < 0) {
 		dev_err(cap->rkisp1->dev, "power up failed %d\n", ret);
-		goto err_destroy_dummy;
+		goto err_destroy_sp_dummy;
 	}
 	ret = v4l2_pipeline_pm_get(entity);
 	if (ret) {
@@ -1041,6 +1222,9 @@ rkisp1_vb2_start_streaming(struct vb2_queue *queue, unsigned int count)
 	v4l2_pipeline_pm_put(entity);
 err_pipe_pm_put:
 	pm_runtime_put(cap->rkisp1->dev);
+err_destroy_sp_dummy:
+	if (rkisp1_capture_embeds_sp(cap))
+		rkisp1_dummy_buf_destroy(sp);
 err_destroy_dummy:
 	rkisp1_dummy_buf_destroy(cap);
 err_pipeline_stop:
@@ -1216,10 +1400,16 @@ static int rkisp1_s_fmt_vid_cap_mplane(struct file *file,
 	struct rkisp1_capture *cap = video_drvdata(file);
 	struct rkisp1_vdev_node *node =
 				rkisp1_vdev_to_node(&cap->vnode.vdev);
+	struct rkisp1_capture *mp = &cap->rkisp1->capture_devs[RKISP1_MAINPATH];
 
 	if (vb2_is_busy(&node->buf_queue))
 		return -EBUSY;
 
+	/* The mainpath buffers are sized for the embedded selfpath frame */
+	if (cap->id == RKISP1_SELFPATH && rkisp1_capture_embeds_sp(mp) &&
+	    vb2_is_busy(&mp->vnode.buf_queue))
+		return -EBUSY;
+
 	rkisp1_set_fmt(cap, &f->fmt.pix_mp);
 
 	return 0;
@@ -1264,6 +1454,38 @@ static const struct v4l2_ioctl_ops rkisp1_v4l2_ioctl_ops = {
 	.vidioc_unsubscribe_event = v4l2_event_unsubscribe,
 };
 
+static int rkisp1_capture_s_ctrl(struct v4l2_ctrl *ctrl)
+{
+	struct rkisp1_capture *cap =
+		container_of(ctrl->handler, struct rkisp1_capture, ctrl_handler);
+	struct rkisp1_capture *sp = &cap->rkisp1->capture_devs[RKISP1_SELFPATH];
+
+	switch (ctrl->id) {
+	case V4L2_CID_RKISP1_EMBED_SELFPATH:
+		if (vb2_is_busy(&cap->vnode.buf_queue) ||
+		    vb2_is_busy(&sp->vnode.buf_queue))
+			return -EBUSY;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+static const struct v4l2_ctrl_ops rkisp1_capture_ctrl_ops = {
+	.s_ctrl = rkisp1_capture_s_ctrl,
+};
+
+static const struct v4l2_ctrl_config rkisp1_capture_embed_sp_ctrl = {
+	.ops = &rkisp1_capture_ctrl_ops,
+	.id = V4L2_CID_RKISP1_EMBED_SELFPATH,
+	.name = "Embed Self Path",
+	.type = V4L2_CTRL_TYPE_BOOLEAN,
+	.min = 0,
+	.max = 1,
+	.step = 1,
+	.def = 0,
+};
+
 static int rkisp1_capture_link_validate(struct media_link *link)
 {
 	struct video_device *vdev =
@@ -1322,6 +1544,7 @@ static void rkisp1_unregister_capture(struct rkisp1_capture *cap)
 
 	media_entity_cleanup(&cap->vnode.vdev.entity);
 	vb2_video_unregister_device(&cap->vnode.vdev);
+	v4l2_ctrl_handler_free(&cap->ctrl_handler);
 	mutex_destroy(&cap->vnode.vlock);
 }
 
@@ -1361,6 +1584,19 @@ static int rkisp1_register_capture(struct rkisp1_capture *cap)
 	vdev->vfl_dir = VFL_DIR_RX;
 	node->pad.flags = MEDIA_PAD_FL_SINK;
 
+	if (cap->id == RKISP1_MAINPATH) {
+		v4l2_ctrl_handler_init(&cap->ctrl_handler, 1);
+		cap->ctrl_handler.lock = &node->vlock;
+		cap->embed_sp = v4l2_ctrl_new_custom(&cap->ctrl_handler,
+						     &rkisp1_capture_embed_sp_ctrl,
+						     NULL);
+		if (cap->ctrl_handler.error) {
+			ret = cap->ctrl_handler.error;
+			goto error;
+		}
+		vdev->ctrl_handler = &cap->ctrl_handler;
+	}
+
 	q = &node->buf_queue;
 	q->type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
 	q->io_modes = VB2_MMAP | VB2_DMABUF;
@@ -1399,6 +1635,7 @@ static int rkisp1_register_capture(struct rkisp1_capture *cap)
 
 error:
 	media_entity_cleanup(&vdev->entity);
+	v4l2_ctrl_handler_free(&cap->ctrl_handler);
 	mutex_destroy(&node->vlock);
 	return ret;
 }
@@ -12,6 +12,7 @@
 #define _RKISP1_COMMON_H
 
 #include <linux/clk.h>
+#include <linux/interconnect.h>
 #include <linux/interrupt.h>
 #include <linux/mutex.h>
 #include <linux/rkisp1-config.h>
@@ -229,11 +230,13 @@ struct rkisp1_vdev_node {
  * @vb:		vb2 buffer
  * @queue:	entry of the buffer in the queue
  * @buff_addr:	dma addresses of each plane, used only by the capture devices: selfpath, mainpath
+ * @sp_buff_addr: dma addresses of the selfpath planes embedded in a mainpath buffer
  */
 struct rkisp1_buffer {
 	struct vb2_v4l2_buffer vb;
 	struct list_head queue;
 	u32 buff_addr[VIDEO_MAX_PLANES];
+	u32 sp_buff_addr[VIDEO_MAX_PLANES];
 };
 
 /*
@@ -278,6 +281,10 @@ struct rkisp1_device;
  * @pix.cfg:	  pixel configuration
  * @pix.info:	  a pointer to the v4l2_format_info of the pixel format
  * @pix.fmt:	  buffer format
+ * @ctrl_handler: control handler, mainpath only
+ * @embed_sp:	  V4L2_CID_RKISP1_EMBED_SELFPATH control, mainpath only
+ * @sp_embedded:  the selfpath is written to the mainpath buffers while streaming
+ * @embed_fe:	  frame end interrupts seen for the current frame in embedded mode
  */
 struct rkisp1_capture {
 	struct rkisp1_vdev_node vnode;
@@ -302,6 +309,10 @@ struct rkisp1_capture {
 		const struct v4l2_format_info *info;
 		struct v4l2_pix_format_mplane fmt;
 	} pix;
+	struct v4l2_ctrl_handler ctrl_handler;
+	struct v4l2_ctrl *embed_sp;
+	bool sp_embedded;
+	u32 embed_fe;
 };
 
 struct rkisp1_stats;
@@ -331,6 +342,9 @@ struct rkisp1_stats {
 	spinlock_t lock; /* locks the buffers list 'stats' */
 	struct list_head stat;
 	struct v4l2_format vdev_fmt;
+
+	/* measurements for the 3A event when no buffer is queued */
+	struct rkisp1_stat_buffer scratch;
 };
 
 struct rkisp1_params;
@@ -367,6 +381,8 @@ struct rkisp1_params_ops {
  * @vdev_fmt:		v4l2_format of the metadata format
  * @quantization:	the quantization configured on the isp's src pad
  * @raw_type:		the bayer pattern on the isp video sink pad
+ * @cur_cfg:		module configs last written to the hardware
+ * @cur_cfg_valid:	RKISP1_CIF_ISP_MODULE_* mask of valid @cur_cfg blocks
  */
 struct rkisp1_params {
 	struct rkisp1_vdev_node vnode;
@@ -380,6 +396,9 @@ struct rkisp1_params {
 	enum v4l2_quantization quantization;
 	enum v4l2_ycbcr_encoding ycbcr_encoding;
 	enum rkisp1_fmt_raw_pat_type raw_type;
+
+	struct rkisp1_params_cfg cur_cfg;
+	u32 cur_cfg_valid;
 };
 
 /*
@@ -417,12 +436,21 @@ struct rkisp1_resizer {
  * @img_stabilization_size_error: size error is generated in image stabilization submodule
  * @inform_size_err:		  size error is generated in inform submodule
  * @mipi_error:			  mipi error occurred
+ * @mipi_sync_fifo_overflow:	  the mipi receiver could not hand the data over to the isp
+ *				  in time, the first sign of the isp or memory falling behind
+ * @mipi_dphy_error:		  sot, sync or control error reported by the dphy
+ * @mipi_csi_error:		  ecc, checksum or protocol error in a csi-2 packet
  * @stats_error:		  writing to the 'Interrupt clear register' did not clear
  *				  it in the register 'Masked interrupt status'
  * @stop_timeout:		  upon stream stop, the capture waits 1 second for the isr to stop
  *				  the stream. This param is incremented in case of timeout.
  * @frame_drop:			  a frame was ready but the buffer queue was empty so the frame
  *				  was not sent to userspace
+ * @frame_start_ns:		  time of the last frame start, 0 before the first one
+ * @frame_interval_ns:		  time between the last two frame starts
+ * @frame_interval_min_ns:	  shortest frame interval seen in the current stream
+ * @frame_interval_max_ns:	  longest frame interval seen in the current stream
+ * @frame_active_ns:		  time from frame start to frame end of the last frame
  */
 struct rkisp1_debug {
 	struct dentry *debugfs_dir;
@@ -432,9 +460,18 @@ struct rkisp1_debug {
 	unsigned long inform_size_error;
 	unsigned long irq_delay;
 	unsigned long mipi_error;
+	unsigned long mipi_sync_fifo_overflow;
+	unsigned long mipi_dphy_error;
+	unsigned long mipi_csi_error;
 	unsigned long stats_error;
+	unsigned long stats_dropped;
 	unsigned long stop_timeout[2];
 	unsigned long frame_drop[2];
+	u64 frame_start_ns;
+	u64 frame_interval_ns;
+	u64 frame_interval_min_ns;
+	u64 frame_interval_max_ns;
+	u64 frame_active_ns;
 };
 
 /*
@@ -445,6 +482,7 @@ struct rkisp1_debug {
  * @dev:	   a pointer to the struct device
  * @clk_size:	   number of clocks
  * @clks:	   array of clocks
+ * @icc_path:	   optional DRAM bandwidth vote for the capture paths
  * @v4l2_dev:	   v4l2_device variable
  * @media_dev:	   media_device variable
  * @notifier:	   a notifier to register on the v4l2-async API to be notified on the sensor
@@ -465,6 +503,7 @@ struct rkisp1_device {
 	struct device *dev;
 	unsigned int clk_size;
 	struct clk_bulk_data clks[RKISP1_MAX_BUS_CLK];
+	struct icc_path *icc_path;
 	struct v4l2_device v4l2_dev;
 	struct media_device media_dev;
 	struct v4l2_async_notifier notifier;
@@ -237,6 +237,13 @@ irqreturn_t rkisp1_csi_isr(int irq, void *ctx)
 		rkisp1->debug.mipi_error++;
 	}
 
+	if (status & RKISP1_CIF_MIPI_SYNC_FIFO_OVFLW(0x0f))
+		rkisp1->debug.mipi_sync_fifo_overflow++;
+	if (status & RKISP1_CIF_MIPI_ERR_DPHY)
+		rkisp1->debug.mipi_dphy_error++;
+	if (status & RKISP1_CIF_MIPI_ERR_CSI)
+		rkisp1->debug.mipi_csi_error++;
+
 	return IRQ_HANDLED;
 }
 
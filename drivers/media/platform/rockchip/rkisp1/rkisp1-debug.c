@@ -11,6 +11,7 @@
 #include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/device.h>
+#include <linux/math64.h>
 #include <linux/minmax.h>
 #include <linux/pm_runtime.h>
 #include <linux/seq_file.h>
@@ -187,6 +188,36 @@ static int rkisp1_debug_input_status_show(struct seq_file *m, void *p)
 }
 DEFINE_SHOW_ATTRIBUTE(rkisp1_debug_input_status);
 
+/*
+ * The line time is the frame active time over the number of acquired lines.
+ * Comparing it, and the frame interval spread, with what the sensor is
+ * configured for shows how much slack the pipeline has left before the mipi
+ * fifo overflows and frames get dropped.
+ */
+static int rkisp1_debug_frame_timing_show(struct seq_file *m, void *p)
+{
+	struct rkisp1_device *rkisp1 = m->private;
+	struct rkisp1_debug *debug = &rkisp1->debug;
+	u64 active_ns = READ_ONCE(debug->frame_active_ns);
+	u32 lines = 0;
+
+	if (pm_runtime_get_if_in_use(rkisp1->dev) > 0) {
+		lines = rkisp1_read(rkisp1, RKISP1_CIF_ISP_ACQ_V_SIZE);
+		pm_runtime_put(rkisp1->dev);
+	}
+
+	seq_printf(m, "frame_interval_ns: %llu (min %llu, max %llu)\n",
+		   READ_ONCE(debug->frame_interval_ns),
+		   READ_ONCE(debug->frame_interval_min_ns),
+		   READ_ONCE(debug->frame_interval_max_ns));
+	seq_printf(m, "frame_active_ns: %llu\n", active_ns);
+	seq_printf(m, "line_time_ns: %llu\n",
+		   lines ? div_u64(active_ns, lines) : 0);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rkisp1_debug_frame_timing);
+
 void rkisp1_debug_init(struct rkisp1_device *rkisp1)
 {
 	struct rkisp1_debug *debug = &rkisp1->debug;
@@ -207,8 +238,17 @@ void rkisp1_debug_init(struct rkisp1_device *rkisp1)
 			     &debug->irq_delay);
 	debugfs_create_ulong("mipi_error", 0444, debug->debugfs_dir,
 			     &debug->mipi_error);
+	debugfs_create_ulong("mipi_sync_fifo_overflow", 0444,
+			     debug->debugfs_dir,
+			     &debug->mipi_sync_fifo_overflow);
+	debugfs_create_ulong("mipi_dphy_error", 0444, debug->debugfs_dir,
+			     &debug->mipi_dphy_error);
+	debugfs_create_ulong("mipi_csi_error", 0444, debug->debugfs_dir,
+			     &debug->mipi_csi_error);
 	debugfs_create_ulong("stats_error", 0444, debug->debugfs_dir,
 			     &debug->stats_error);
+	debugfs_create_ulong("stats_dropped", 0444, debug->debugfs_dir,
+			     &debug->stats_dropped);
 	debugfs_create_ulong("mp_stop_timeout", 0444, debug->debugfs_dir,
 			     &debug->stop_timeout[RKISP1_MAINPATH]);
 	debugfs_create_ulong("sp_stop_timeout", 0444, debug->debugfs_dir,
@@ -219,6 +259,8 @@ void rkisp1_debug_init(struct rkisp1_device *rkisp1)
 			     &debug->frame_drop[RKISP1_SELFPATH]);
 	debugfs_create_file("input_status", 0444, debug->debugfs_dir, rkisp1,
 			    &rkisp1_debug_input_status_fops);
+	debugfs_create_file("frame_timing", 0444, debug->debugfs_dir, rkisp1,
+			    &rkisp1_debug_frame_timing_fops);
 
 	regs_dir = debugfs_create_dir("regs", debug->debugfs_dir);
 
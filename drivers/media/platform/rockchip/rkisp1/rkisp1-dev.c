@@ -557,6 +557,11 @@ static int rkisp1_probe(struct platform_device *pdev)
 		return ret;
 	rkisp1->clk_size = info->clk_size;
 
+	rkisp1->icc_path = devm_of_icc_get(dev, "dram");
+	if (IS_ERR(rkisp1->icc_path))
+		return dev_err_probe(dev, PTR_ERR(rkisp1->icc_path),
+				     "failed to get dram interconnect path\n");
+
 	pm_runtime_enable(&pdev->dev);
 
 	ret = pm_runtime_resume_and_get(&pdev->dev);
@@ -9,6 +9,7 @@
  */
 
 #include <linux/iopoll.h>
+#include <linux/ktime.h>
 #include <linux/pm_runtime.h>
 #include <linux/videodev2.h>
 #include <linux/vmalloc.h>
@@ -833,6 +834,47 @@ static const struct v4l2_subdev_pad_ops rkisp1_isp_pad_ops = {
  * Stream operations
  */
 
+/*
+ * Vote for the DRAM bandwidth of the capture before the sensor starts, so
+ * that the memory controller is not still clocked for an idle system when
+ * the first frame arrives. Each capture path writes at most two bytes per
+ * input pixel (YUV 4:2:2).
+ */
+static void rkisp1_isp_vote_bandwidth(struct rkisp1_device *rkisp1)
+{
+	struct v4l2_subdev *sensor = rkisp1->source;
+	struct v4l2_ctrl *pixel_rate = NULL;
+	u64 bw;
+	int ret;
+
+	if (!rkisp1->icc_path)
+		return;
+
+	if (sensor == &rkisp1->csi.sd) {
+		struct media_pad *pad;
+
+		pad = media_pad_remote_pad_unique(&rkisp1->csi.pads[RKISP1_CSI_PAD_SINK]);
+		sensor = IS_ERR(pad) ? NULL
+				     : media_entity_to_v4l2_subdev(pad->entity);
+	}
+
+	if (sensor)
+		pixel_rate = v4l2_ctrl_find(sensor->ctrl_handler,
+					    V4L2_CID_PIXEL_RATE);
+	if (!pixel_rate) {
+		dev_dbg(rkisp1->dev, "no pixel rate, not voting bandwidth\n");
+		return;
+	}
+
+	bw = div_u64(v4l2_ctrl_g_ctrl_int64(pixel_rate) * 2 *
+		     ARRAY_SIZE(rkisp1->capture_devs), 1000);
+	bw = min_t(u64, bw, U32_MAX);
+
+	ret = icc_set_bw(rkisp1->icc_path, kBps_to_icc(bw), kBps_to_icc(bw));
+	if (ret)
+		dev_warn(rkisp1->dev, "failed to vote bandwidth: %d\n", ret);
+}
+
 static int rkisp1_isp_s_stream(struct v4l2_subdev *sd, int enable)
 {
 	struct rkisp1_isp *isp = to_rkisp1_isp(sd);
@@ -846,6 +888,7 @@ static int rkisp1_isp_s_stream(struct v4l2_subdev *sd, int enable)
 	if (!enable) {
 		v4l2_subdev_call(rkisp1->source, video, s_stream, false);
 		rkisp1_isp_stop(isp);
+		icc_set_bw(rkisp1->icc_path, 0, 0);
 		return 0;
 	}
 
@@ -877,16 +920,23 @@ static int rkisp1_isp_s_stream(struct v4l2_subdev *sd, int enable)
 	}
 
 	isp->frame_sequence = -1;
+	rkisp1->debug.frame_start_ns = 0;
+	rkisp1->debug.frame_interval_ns = 0;
+	rkisp1->debug.frame_interval_min_ns = 0;
+	rkisp1->debug.frame_interval_max_ns = 0;
+	rkisp1->debug.frame_active_ns = 0;
 	mutex_lock(&isp->ops_lock);
 	ret = rkisp1_config_cif(isp, mbus_type, mbus_flags);
 	if (ret)
 		goto mutex_unlock;
 
+	rkisp1_isp_vote_bandwidth(rkisp1);
 	rkisp1_isp_start(isp);
 
 	ret = v4l2_subdev_call(rkisp1->source, video, s_stream, true);
 	if (ret) {
 		rkisp1_isp_stop(isp);
+		icc_set_bw(rkisp1->icc_path, 0, 0);
 		goto mutex_unlock;
 	}
 
@@ -993,6 +1043,24 @@ void rkisp1_isp_unregister(struct rkisp1_device *rkisp1)
  * Interrupt handlers
  */
 
+static void rkisp1_isp_frame_start_timing(struct rkisp1_debug *debug)
+{
+	u64 now = ktime_get_ns();
+
+	if (debug->frame_start_ns) {
+		u64 interval = now - debug->frame_start_ns;
+
+		debug->frame_interval_ns = interval;
+		if (!debug->frame_interval_min_ns ||
+		    interval < debug->frame_interval_min_ns)
+			debug->frame_interval_min_ns = interval;
+		if (interval > debug->frame_interval_max_ns)
+			debug->frame_interval_max_ns = interval;
+	}
+
+	debug->frame_start_ns = now;
+}
+
 static void rkisp1_isp_queue_event_sof(struct rkisp1_isp *isp)
 {
 	struct v4l2_event event = {
@@ -1018,6 +1086,7 @@ irqreturn_t rkisp1_isp_isr(int irq, void *ctx)
 	/* Vertical sync signal, starting generating new frame */
 	if (status & RKISP1_CIF_ISP_V_START) {
 		rkisp1->isp.frame_sequence++;
+		rkisp1_isp_frame_start_timing(&rkisp1->debug);
 		rkisp1_isp_queue_event_sof(&rkisp1->isp);
 		if (status & RKISP1_CIF_ISP_FRAME) {
 			WARN_ONCE(1, "irq delay is too long, buffers might not be in sync\n");
@@ -1042,6 +1111,10 @@ irqreturn_t rkisp1_isp_isr(int irq, void *ctx)
 	if (status & RKISP1_CIF_ISP_FRAME) {
 		u32 isp_ris;
 
+		if (rkisp1->debug.frame_start_ns)
+			rkisp1->debug.frame_active_ns = ktime_get_ns() -
+				rkisp1->debug.frame_start_ns;
+
 		/* New frame from the sensor received */
 		isp_ris = rkisp1_read(rkisp1, RKISP1_CIF_ISP_RIS);
 		if (isp_ris & RKISP1_STATS_MEAS_MASK)
@@ -18,6 +18,11 @@
 #define RKISP1_ISP_PARAMS_REQ_BUFS_MIN	2
 #define RKISP1_ISP_PARAMS_REQ_BUFS_MAX	8
 
+#define RKISP1_PARAMS_MEAS_MODULES	(RKISP1_CIF_ISP_MODULE_AWB | \
+					 RKISP1_CIF_ISP_MODULE_AFC | \
+					 RKISP1_CIF_ISP_MODULE_HST | \
+					 RKISP1_CIF_ISP_MODULE_AEC)
+
 #define RKISP1_ISP_DPCC_METHODS_SET(n) \
 			(RKISP1_CIF_ISP_DPCC_METHODS_SET_1 + 0x4 * (n))
 #define RKISP1_ISP_DPCC_LINE_THRESH(n) \
@@ -33,6 +38,37 @@
 #define RKISP1_ISP_CC_COEFF(n) \
 			(RKISP1_CIF_ISP_CC_COEFF_0 + (n) * 4)
 
+#define RKISP1_PARAMS_BLOCK(_module, _member)				\
+	{								\
+		.module = RKISP1_CIF_ISP_MODULE_##_module,		\
+		.offset = offsetof(struct rkisp1_params_cfg, _member),	\
+		.size = sizeof_field(struct rkisp1_params_cfg, _member),\
+	}
+
+static const struct rkisp1_params_block {
+	u32 module;
+	unsigned int offset;
+	unsigned int size;
+} rkisp1_params_blocks[] = {
+	RKISP1_PARAMS_BLOCK(DPCC, others.dpcc_config),
+	RKISP1_PARAMS_BLOCK(BLS, others.bls_config),
+	RKISP1_PARAMS_BLOCK(SDG, others.sdg_config),
+	RKISP1_PARAMS_BLOCK(HST, meas.hst_config),
+	RKISP1_PARAMS_BLOCK(LSC, others.lsc_config),
+	RKISP1_PARAMS_BLOCK(AWB_GAIN, others.awb_gain_config),
+	RKISP1_PARAMS_BLOCK(FLT, others.flt_config),
+	RKISP1_PARAMS_BLOCK(BDM, others.bdm_config),
+	RKISP1_PARAMS_BLOCK(CTK, others.ctk_config),
+	RKISP1_PARAMS_BLOCK(GOC, others.goc_config),
+	RKISP1_PARAMS_BLOCK(CPROC, others.cproc_config),
+	RKISP1_PARAMS_BLOCK(AFC, meas.afc_config),
+	RKISP1_PARAMS_BLOCK(AWB, meas.awb_meas_config),
+	RKISP1_PARAMS_BLOCK(IE, others.ie_config),
+	RKISP1_PARAMS_BLOCK(AEC, meas.aec_config),
+	RKISP1_PARAMS_BLOCK(DPF, others.dpf_config),
+	RKISP1_PARAMS_BLOCK(DPF_STRENGTH, others.dpf_strength_config),
+};
+
 static inline void
 rkisp1_param_set_bits(struct rkisp1_params *params, u32 reg, u32 bit_mask)
 {
@@ -1239,6 +1275,41 @@ rkisp1_dpf_strength_config(struct rkisp1_params *params,
 	rkisp1_write(params->rkisp1, RKISP1_CIF_ISP_DPF_STRENGTH_R, arg->r);
 }
 
+/*
+ * Userspace commonly flags every module for a config update in every buffer,
+ * while only a few of them (AWB gains, say) actually change from frame to
+ * frame. Drop the modules whose config matches what was written last from
+ * the update mask, the registers already hold it, and remember the new
+ * configs of the others.
+ */
+static u32 rkisp1_params_cfg_update(struct rkisp1_params *params,
+				    const struct rkisp1_params_cfg *new_params,
+				    u32 modules)
+{
+	u32 update = new_params->module_cfg_update & modules;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(rkisp1_params_blocks); i++) {
+		const struct rkisp1_params_block *block = &rkisp1_params_blocks[i];
+		const void *new_cfg = (const void *)new_params + block->offset;
+		void *cur_cfg = (void *)&params->cur_cfg + block->offset;
+
+		if (!(update & block->module))
+			continue;
+
+		if ((params->cur_cfg_valid & block->module) &&
+		    !memcmp(cur_cfg, new_cfg, block->size)) {
+			update &= ~block->module;
+			continue;
+		}
+
+		memcpy(cur_cfg, new_cfg, block->size);
+		params->cur_cfg_valid |= block->module;
+	}
+
+	return update;
+}
+
 static void
 rkisp1_isp_isr_other_config(struct rkisp1_params *params,
 			    const struct rkisp1_params_cfg *new_params)
@@ -1246,7 +1317,9 @@ rkisp1_isp_isr_other_config(struct rkisp1_params *params,
 	unsigned int module_en_update, module_cfg_update, module_ens;
 
 	module_en_update = new_params->module_en_update;
-	module_cfg_update = new_params->module_cfg_update;
+	module_cfg_update = rkisp1_params_cfg_update(params, new_params,
+						     ~(RKISP1_CIF_ISP_MODULE_LSC |
+						       RKISP1_PARAMS_MEAS_MODULES));
 	module_ens = new_params->module_ens;
 
 	/* update dpc config */
@@ -1420,7 +1493,8 @@ rkisp1_isp_isr_lsc_config(struct rkisp1_params *params,
 	unsigned int module_en_update, module_cfg_update, module_ens;
 
 	module_en_update = new_params->module_en_update;
-	module_cfg_update = new_params->module_cfg_update;
+	module_cfg_update = rkisp1_params_cfg_update(params, new_params,
+						     RKISP1_CIF_ISP_MODULE_LSC);
 	module_ens = new_params->module_ens;
 
 	/* update lsc config */
@@ -1446,7 +1520,8 @@ static void rkisp1_isp_isr_meas_config(struct rkisp1_params *params,
 	unsigned int module_en_update, module_cfg_update, module_ens;
 
 	module_en_update = new_params->module_en_update;
-	module_cfg_update = new_params->module_cfg_update;
+	module_cfg_update = rkisp1_params_cfg_update(params, new_params,
+						     RKISP1_PARAMS_MEAS_MODULES);
 	module_ens = new_params->module_ens;
 
 	/* update awb config */
@@ -1610,6 +1685,13 @@ void rkisp1_params_pre_configure(struct rkisp1_params *params,
 	params->ycbcr_encoding = ycbcr_encoding;
 	params->raw_type = bayer_pat;
 
+	/*
+	 * The measurement defaults below overwrite whatever was configured,
+	 * and the ISP may have been reset since the last stream, so nothing
+	 * written before can be assumed anymore.
+	 */
+	params->cur_cfg_valid = 0;
+
 	params->ops->awb_meas_config(params, &rkisp1_awb_params_default_config);
 	params->ops->awb_meas_enable(params, &rkisp1_awb_params_default_config,
 				     true);
@@ -16,7 +16,7 @@
 #define RKISP1_STATS_DEV_NAME	RKISP1_DRIVER_NAME "_stats"
 
 #define RKISP1_ISP_STATS_REQ_BUFS_MIN 2
-#define RKISP1_ISP_STATS_REQ_BUFS_MAX 8
+#define RKISP1_ISP_STATS_REQ_BUFS_MAX 16
 
 static int rkisp1_stats_enum_fmt_meta_cap(struct file *file, void *priv,
 					  struct v4l2_fmtdesc *f)
@@ -60,6 +60,16 @@ static int rkisp1_stats_querycap(struct file *file,
 	return 0;
 }
 
+static int rkisp1_stats_subscribe_event(struct v4l2_fh *fh,
+					const struct v4l2_event_subscription *sub)
+{
+	if (sub->type == V4L2_EVENT_RKISP1_STATS_3A)
+		return v4l2_event_subscribe(fh, sub, RKISP1_ISP_STATS_REQ_BUFS_MIN,
+					    NULL);
+
+	return v4l2_ctrl_subscribe_event(fh, sub);
+}
+
 /* ISP video device IOCTLs */
 static const struct v4l2_ioctl_ops rkisp1_stats_ioctl = {
 	.vidioc_reqbufs = vb2_ioctl_reqbufs,
@@ -76,7 +86,7 @@ static const struct v4l2_ioctl_ops rkisp1_stats_ioctl = {
 	.vidioc_s_fmt_meta_cap = rkisp1_stats_g_fmt_meta_cap,
 	.vidioc_try_fmt_meta_cap = rkisp1_stats_g_fmt_meta_cap,
 	.vidioc_querycap = rkisp1_stats_querycap,
-	.vidioc_subscribe_event = v4l2_ctrl_subscribe_event,
+	.vidioc_subscribe_event = rkisp1_stats_subscribe_event,
 	.vidioc_unsubscribe_event = v4l2_event_unsubscribe,
 };
 
@@ -360,6 +370,47 @@ static struct rkisp1_stats_ops rkisp1_v12_stats_ops = {
 	.get_hst_meas = rkisp1_stats_get_hst_meas_v12,
 };
 
+static void rkisp1_stats_send_event(struct rkisp1_stats *stats,
+				    const struct rkisp1_stat_buffer *pbuf,
+				    bool dropped)
+{
+	struct rkisp1_stat_event *payload;
+	struct v4l2_event ev = {
+		.type = V4L2_EVENT_RKISP1_STATS_3A,
+	};
+	unsigned int i, n, sum = 0;
+
+	BUILD_BUG_ON(sizeof(*payload) > sizeof(ev.u.data));
+
+	payload = (struct rkisp1_stat_event *)ev.u.data;
+	payload->meas_type = pbuf->meas_type;
+	payload->frame_id = pbuf->frame_id;
+
+	if (pbuf->meas_type & RKISP1_CIF_ISP_STAT_AWB) {
+		const struct rkisp1_cif_isp_awb_meas *awb =
+			&pbuf->params.awb.awb_mean[0];
+
+		payload->awb_cnt = awb->cnt;
+		payload->awb_mean_y_or_g = awb->mean_y_or_g;
+		payload->awb_mean_cb_or_b = awb->mean_cb_or_b;
+		payload->awb_mean_cr_or_r = awb->mean_cr_or_r;
+	}
+
+	if (pbuf->meas_type & RKISP1_CIF_ISP_STAT_AUTOEXP) {
+		n = stats->rkisp1->info->isp_ver == RKISP1_V12 ?
+		    RKISP1_CIF_ISP_AE_MEAN_MAX_V12 :
+		    RKISP1_CIF_ISP_AE_MEAN_MAX_V10;
+		for (i = 0; i < n; i++)
+			sum += pbuf->params.ae.exp_mean[i];
+		payload->ae_mean = DIV_ROUND_CLOSEST(sum, n);
+	}
+
+	if (dropped)
+		payload->flags |= RKISP1_STAT_EVENT_FL_DROPPED;
+
+	v4l2_event_queue(&stats->vnode.vdev, &ev);
+}
+
 static void
 rkisp1_stats_send_measurement(struct rkisp1_stats *stats, u32 isp_ris)
 {
@@ -375,22 +426,38 @@ rkisp1_stats_send_measurement(struct rkisp1_stats *stats, u32 isp_ris)
 		list_del(&cur_buf->queue);
 	}
 
-	if (!cur_buf)
-		return;
+	/*
+	 * Without a buffer the full statistics are lost, but AE and AWB are
+	 * still read so that the 3A event can be delivered.
+	 */
+	if (cur_buf) {
+		cur_stat_buf = (struct rkisp1_stat_buffer *)
+				vb2_plane_vaddr(&cur_buf->vb.vb2_buf, 0);
+	} else {
+		stats->rkisp1->debug.stats_dropped++;
+		cur_stat_buf = &stats->scratch;
+	}
+
+	cur_stat_buf->meas_type = 0;
+	cur_stat_buf->frame_id = frame_sequence;
 
-	cur_stat_buf = (struct rkisp1_stat_buffer *)
-			vb2_plane_vaddr(&cur_buf->vb.vb2_buf, 0);
 	if (isp_ris & RKISP1_CIF_ISP_AWB_DONE)
 		stats->ops->get_awb_meas(stats, cur_stat_buf);
 
-	if (isp_ris & RKISP1_CIF_ISP_AFM_FIN)
-		rkisp1_stats_get_afc_meas(stats, cur_stat_buf);
-
 	if (isp_ris & RKISP1_CIF_ISP_EXP_END) {
 		stats->ops->get_aec_meas(stats, cur_stat_buf);
 		rkisp1_stats_get_bls_meas(stats, cur_stat_buf);
 	}
 
+	if (isp_ris & (RKISP1_CIF_ISP_AWB_DONE | RKISP1_CIF_ISP_EXP_END))
+		rkisp1_stats_send_event(stats, cur_stat_buf, !cur_buf);
+
+	if (!cur_buf)
+		return;
+
+	if (isp_ris & RKISP1_CIF_ISP_AFM_FIN)
+		rkisp1_stats_get_afc_meas(stats, cur_stat_buf);
+
 	if (isp_ris & RKISP1_CIF_ISP_HIST_MEASURE_RDY)
 		stats->ops->get_hst_meas(stats, cur_stat_buf);
 
@@ -208,6 +208,38 @@ struct hantro_dev {
 	spinlock_t irqlock;
 	const struct hantro_variant *variant;
 	struct delayed_work watchdog_work;
+
+	struct list_head ctx_list;
+	struct mutex sched_mutex;	/* ctx_list additions and removals */
+	spinlock_t sched_lock;		/* ctx_list and hantro_ctx_sched */
+	struct work_struct sched_work;
+	u32 next_ctx_id;
+	struct dentry *debugfs;
+};
+
+/**
+ * struct hantro_ctx_sched - Per-context fair-scheduling state.
+ *
+ * @node:	Entry in the device's context list.
+ * @id:		Context number, as shown in debugfs.
+ * @vruntime:	Hardware time used, scaled by the context weight, in ns.
+ * @busy_ns:	Total hardware time used by the context.
+ * @max_ns:	Longest single job of the context.
+ * @jobs:	Number of jobs run by the context.
+ * @start:	Start time of the currently running job.
+ * @queued:	The context is on the mem2mem job queue or running.
+ * @deferred:	The context was held back to let others catch up.
+ */
+struct hantro_ctx_sched {
+	struct list_head node;
+	u32 id;
+	u64 vruntime;
+	u64 busy_ns;
+	u64 max_ns;
+	u64 jobs;
+	ktime_t start;
+	bool queued;
+	bool deferred;
 };
 
 /**
@@ -229,6 +261,8 @@ struct hantro_dev {
  * @jpeg_quality:	User-specified JPEG compression quality.
  * @bit_depth:		Bit depth of current frame
  *
+ * @sched:		Fair-scheduling state and decode time statistics.
+ *
  * @codec_ops:		Set of operations related to codec mode.
  * @postproc:		Post-processing context.
  * @h264_dec:		H.264-decoding context.
@@ -255,11 +289,14 @@ struct hantro_ctx {
 	int jpeg_quality;
 	int bit_depth;
 
+	struct hantro_ctx_sched sched;
+
 	const struct hantro_codec_ops *codec_ops;
 	struct hantro_postproc_ctx postproc;
 
 	/* Specific for particular codec modes. */
 	union {
+		struct hantro_jpeg_enc_hw_ctx jpeg_enc;
 		struct hantro_h264_dec_hw_ctx h264_dec;
 		struct hantro_mpeg2_dec_hw_ctx mpeg2_dec;
 		struct hantro_vp8_dec_hw_ctx vp8_dec;
@@ -314,6 +351,10 @@ struct hantro_postproc_regs {
 	struct hantro_reg output_fmt;
 	struct hantro_reg orig_width;
 	struct hantro_reg display_width;
+	struct hantro_reg hor_scale_mode;
+	struct hantro_reg ver_scale_mode;
+	struct hantro_reg wscale_invra;
+	struct hantro_reg hscale_invra;
 };
 
 struct hantro_vp9_decoded_buffer_info {
@@ -481,5 +522,7 @@ void hantro_postproc_free(struct hantro_ctx *ctx);
 int hantro_postproc_alloc(struct hantro_ctx *ctx);
 int hanto_postproc_enum_framesizes(struct hantro_ctx *ctx,
 				   struct v4l2_frmsizeenum *fsize);
+bool hantro_postproc_try_size(const struct hantro_ctx *ctx,
+			      u32 *width, u32 *height);
 
 #endif /* HANTRO_H_ */
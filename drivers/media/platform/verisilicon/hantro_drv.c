@@ -11,11 +11,13 @@
  */
 
 #include <linux/clk.h>
+#include <linux/debugfs.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/pm.h>
 #include <linux/pm_runtime.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/videodev2.h>
 #include <linux/workqueue.h>
@@ -30,6 +32,13 @@
 
 #define DRIVER_NAME "hantro-vpu"
 
+/*
+ * How far, in weighted hardware time, a context may run ahead of the
+ * least served context waiting for the hardware before it is held back.
+ */
+#define HANTRO_SCHED_SLICE_NS		(10 * NSEC_PER_MSEC)
+#define HANTRO_SCHED_WEIGHT_DEFAULT	2
+
 int hantro_debug;
 module_param_named(debug, hantro_debug, int, 0644);
 MODULE_PARM_DESC(debug,
@@ -58,6 +67,138 @@ static const struct v4l2_event hantro_eos_event = {
 	.type = V4L2_EVENT_EOS
 };
 
+/*
+ * The V4L2 access priority of the context's file handle doubles as its
+ * scheduling weight: recording streams get twice the hardware time of
+ * interactive ones, background ones half of it.
+ */
+static unsigned int hantro_ctx_weight(struct hantro_ctx *ctx)
+{
+	switch (ctx->fh.prio) {
+	case V4L2_PRIORITY_BACKGROUND:
+		return 1;
+	case V4L2_PRIORITY_RECORD:
+		return 4;
+	default:
+		return HANTRO_SCHED_WEIGHT_DEFAULT;
+	}
+}
+
+static bool hantro_sched_has_deferred(struct hantro_dev *vpu)
+{
+	struct hantro_ctx *ctx;
+
+	lockdep_assert_held(&vpu->sched_lock);
+
+	list_for_each_entry(ctx, &vpu->ctx_list, sched.node)
+		if (ctx->sched.deferred)
+			return true;
+
+	return false;
+}
+
+static void hantro_sched_account(struct hantro_dev *vpu,
+				 struct hantro_ctx *ctx)
+{
+	unsigned long flags;
+	u64 elapsed;
+
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), ctx->sched.start));
+
+	spin_lock_irqsave(&vpu->sched_lock, flags);
+	ctx->sched.busy_ns += elapsed;
+	ctx->sched.max_ns = max(ctx->sched.max_ns, elapsed);
+	ctx->sched.jobs++;
+	ctx->sched.vruntime += div_u64(elapsed * HANTRO_SCHED_WEIGHT_DEFAULT,
+				       hantro_ctx_weight(ctx));
+	ctx->sched.queued = false;
+	if (hantro_sched_has_deferred(vpu))
+		schedule_work(&vpu->sched_work);
+	spin_unlock_irqrestore(&vpu->sched_lock, flags);
+}
+
+/*
+ * Called by mem2mem with its job lock held, right before queueing the
+ * context. Hold back contexts that are more than a slice ahead of the
+ * least served context already waiting, they get another chance each
+ * time a job completes.
+ */
+static int hantro_job_ready(void *priv)
+{
+	struct hantro_ctx *ctx = priv;
+	struct hantro_dev *vpu = ctx->dev;
+	struct hantro_ctx *other;
+	u64 min_vruntime = U64_MAX;
+	unsigned long flags;
+	bool ready;
+
+	spin_lock_irqsave(&vpu->sched_lock, flags);
+	list_for_each_entry(other, &vpu->ctx_list, sched.node) {
+		if (other != ctx && other->sched.queued)
+			min_vruntime = min(min_vruntime,
+					   other->sched.vruntime);
+	}
+
+	if (min_vruntime == U64_MAX) {
+		ready = true;
+	} else {
+		/*
+		 * Don't let a context that was idle, or just opened, use
+		 * its low vruntime to monopolize the hardware.
+		 */
+		if (min_vruntime > HANTRO_SCHED_SLICE_NS &&
+		    ctx->sched.vruntime < min_vruntime - HANTRO_SCHED_SLICE_NS)
+			ctx->sched.vruntime = min_vruntime -
+					      HANTRO_SCHED_SLICE_NS;
+
+		ready = ctx->sched.vruntime <=
+			min_vruntime + HANTRO_SCHED_SLICE_NS;
+	}
+
+	ctx->sched.queued = ready;
+	ctx->sched.deferred = !ready;
+	spin_unlock_irqrestore(&vpu->sched_lock, flags);
+
+	return ready;
+}
+
+static void hantro_sched_work(struct work_struct *work)
+{
+	struct hantro_dev *vpu = container_of(work, struct hantro_dev,
+					      sched_work);
+	struct hantro_ctx *ctx;
+	bool deferred;
+
+	mutex_lock(&vpu->sched_mutex);
+	list_for_each_entry(ctx, &vpu->ctx_list, sched.node) {
+		spin_lock_irq(&vpu->sched_lock);
+		deferred = ctx->sched.deferred;
+		ctx->sched.deferred = false;
+		spin_unlock_irq(&vpu->sched_lock);
+
+		if (deferred)
+			v4l2_m2m_try_schedule(ctx->fh.m2m_ctx);
+	}
+	mutex_unlock(&vpu->sched_mutex);
+}
+
+/*
+ * mem2mem drops queued jobs on STREAMOFF without finishing them, so the
+ * context must stop counting as waiting for the hardware.
+ */
+void hantro_sched_stop(struct hantro_ctx *ctx)
+{
+	struct hantro_dev *vpu = ctx->dev;
+	unsigned long flags;
+
+	spin_lock_irqsave(&vpu->sched_lock, flags);
+	ctx->sched.queued = false;
+	ctx->sched.deferred = false;
+	if (hantro_sched_has_deferred(vpu))
+		schedule_work(&vpu->sched_work);
+	spin_unlock_irqrestore(&vpu->sched_lock, flags);
+}
+
 static void hantro_job_finish_no_pm(struct hantro_dev *vpu,
 				    struct hantro_ctx *ctx,
 				    enum vb2_buffer_state result)
@@ -81,6 +222,9 @@ static void hantro_job_finish_no_pm(struct hantro_dev *vpu,
 		v4l2_m2m_mark_stopped(ctx->fh.m2m_ctx);
 	}
 
+	/* Must be done before mem2mem gets a chance to requeue the context. */
+	hantro_sched_account(vpu, ctx);
+
 	v4l2_m2m_buf_done_and_job_finish(ctx->dev->m2m_dev, ctx->fh.m2m_ctx,
 					 result);
 }
@@ -176,6 +320,8 @@ static void device_run(void *priv)
 	src = hantro_get_src_buf(ctx);
 	dst = hantro_get_dst_buf(ctx);
 
+	ctx->sched.start = ktime_get();
+
 	ret = pm_runtime_resume_and_get(ctx->dev->dev);
 	if (ret < 0)
 		goto err_cancel_job;
@@ -197,6 +343,7 @@ static void device_run(void *priv)
 
 static const struct v4l2_m2m_ops vpu_m2m_ops = {
 	.device_run = device_run,
+	.job_ready = hantro_job_ready,
 };
 
 static int
@@ -583,6 +730,13 @@ static int hantro_open(struct file *filp)
 	}
 	ctx->fh.ctrl_handler = &ctx->ctrl_handler;
 
+	mutex_lock(&vpu->sched_mutex);
+	spin_lock_irq(&vpu->sched_lock);
+	ctx->sched.id = vpu->next_ctx_id++;
+	list_add_tail(&ctx->sched.node, &vpu->ctx_list);
+	spin_unlock_irq(&vpu->sched_lock);
+	mutex_unlock(&vpu->sched_mutex);
+
 	return 0;
 
 err_fh_free:
@@ -597,6 +751,17 @@ static int hantro_release(struct file *filp)
 {
 	struct hantro_ctx *ctx =
 		container_of(filp->private_data, struct hantro_ctx, fh);
+	struct hantro_dev *vpu = ctx->dev;
+
+	/*
+	 * The scheduler work may still try to queue the context, take it
+	 * off the list before its mem2mem context goes away.
+	 */
+	mutex_lock(&vpu->sched_mutex);
+	spin_lock_irq(&vpu->sched_lock);
+	list_del(&ctx->sched.node);
+	spin_unlock_irq(&vpu->sched_lock);
+	mutex_unlock(&vpu->sched_mutex);
 
 	/*
 	 * No need for extra locking because this was the last reference
@@ -611,6 +776,37 @@ static int hantro_release(struct file *filp)
 	return 0;
 }
 
+static int hantro_sched_show(struct seq_file *m, void *data)
+{
+	struct hantro_dev *vpu = m->private;
+	struct hantro_ctx_sched sched;
+	struct hantro_ctx *ctx;
+
+	seq_printf(m, "%-5s %-4s %-6s %10s %14s %10s %10s %14s\n",
+		   "ctx", "type", "weight", "jobs", "busy_us", "avg_us",
+		   "max_us", "vruntime_us");
+
+	mutex_lock(&vpu->sched_mutex);
+	list_for_each_entry(ctx, &vpu->ctx_list, sched.node) {
+		spin_lock_irq(&vpu->sched_lock);
+		sched = ctx->sched;
+		spin_unlock_irq(&vpu->sched_lock);
+
+		seq_printf(m, "%-5u %-4s %-6u %10llu %14llu %10llu %10llu %14llu\n",
+			   sched.id, ctx->is_encoder ? "enc" : "dec",
+			   hantro_ctx_weight(ctx),
+			   sched.jobs, div_u64(sched.busy_ns, NSEC_PER_USEC),
+			   sched.jobs ? div64_u64(sched.busy_ns, sched.jobs *
+						  NSEC_PER_USEC) : 0,
+			   div_u64(sched.max_ns, NSEC_PER_USEC),
+			   div_u64(sched.vruntime, NSEC_PER_USEC));
+	}
+	mutex_unlock(&vpu->sched_mutex);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(hantro_sched);
+
 static const struct v4l2_file_operations hantro_fops = {
 	.owner = THIS_MODULE,
 	.open = hantro_open,
@@ -923,6 +1119,11 @@ static int hantro_probe(struct platform_device *pdev)
 
 	INIT_DELAYED_WORK(&vpu->watchdog_work, hantro_watchdog);
 
+	INIT_LIST_HEAD(&vpu->ctx_list);
+	mutex_init(&vpu->sched_mutex);
+	spin_lock_init(&vpu->sched_lock);
+	INIT_WORK(&vpu->sched_work, hantro_sched_work);
+
 	vpu->clocks = devm_kcalloc(&pdev->dev, vpu->variant->num_clocks,
 				   sizeof(*vpu->clocks), GFP_KERNEL);
 	if (!vpu->clocks)
@@ -1075,6 +1276,10 @@ static int hantro_probe(struct platform_device *pdev)
 		goto err_rm_dec_func;
 	}
 
+	vpu->debugfs = debugfs_create_dir(dev_name(vpu->dev), NULL);
+	debugfs_create_file("sched", 0444, vpu->debugfs, vpu,
+			    &hantro_sched_fops);
+
 	return 0;
 
 err_rm_dec_func:
@@ -1102,11 +1307,13 @@ static int hantro_remove(struct platform_device *pdev)
 
 	v4l2_info(&vpu->v4l2_dev, "Removing %s\n", pdev->name);
 
+	debugfs_remove_recursive(vpu->debugfs);
 	media_device_unregister(&vpu->mdev);
 	hantro_remove_dec_func(vpu);
 	hantro_remove_enc_func(vpu);
 	media_device_cleanup(&vpu->mdev);
 	v4l2_m2m_release(vpu->m2m_dev);
+	cancel_work_sync(&vpu->sched_work);
 	v4l2_device_unregister(&vpu->v4l2_dev);
 	clk_bulk_unprepare(vpu->variant->num_clocks, vpu->clocks);
 	reset_control_assert(vpu->resets);
@@ -1138,6 +1345,7 @@ static struct platform_driver hantro_driver = {
 	.remove = hantro_remove,
 	.driver = {
 		   .name = DRIVER_NAME,
+		   .probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		   .of_match_table = of_match_ptr(of_hantro_match),
 		   .pm = &hantro_pm_ops,
 	},
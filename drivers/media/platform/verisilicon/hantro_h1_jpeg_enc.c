@@ -78,15 +78,15 @@ static void hantro_h1_jpeg_enc_set_buffers(struct hantro_dev *vpu,
 
 static void
 hantro_h1_jpeg_enc_set_qtable(struct hantro_dev *vpu,
-			      unsigned char *luma_qtable,
-			      unsigned char *chroma_qtable)
+			      const unsigned char *luma_qtable,
+			      const unsigned char *chroma_qtable)
 {
 	u32 reg, i;
-	__be32 *luma_qtable_p;
-	__be32 *chroma_qtable_p;
+	const __be32 *luma_qtable_p;
+	const __be32 *chroma_qtable_p;
 
-	luma_qtable_p = (__be32 *)luma_qtable;
-	chroma_qtable_p = (__be32 *)chroma_qtable;
+	luma_qtable_p = (const __be32 *)luma_qtable;
+	chroma_qtable_p = (const __be32 *)chroma_qtable;
 
 	/*
 	 * Quantization table registers must be written in contiguous blocks.
@@ -107,7 +107,8 @@ int hantro_h1_jpeg_enc_run(struct hantro_ctx *ctx)
 {
 	struct hantro_dev *vpu = ctx->dev;
 	struct vb2_v4l2_buffer *src_buf, *dst_buf;
-	struct hantro_jpeg_ctx jpeg_ctx;
+	const struct hantro_jpeg_ctx *jpeg_ctx;
+	void *header;
 	u32 reg;
 
 	src_buf = hantro_get_src_buf(ctx);
@@ -115,12 +116,8 @@ int hantro_h1_jpeg_enc_run(struct hantro_ctx *ctx)
 
 	hantro_start_prepare_run(ctx);
 
-	memset(&jpeg_ctx, 0, sizeof(jpeg_ctx));
-	jpeg_ctx.buffer = vb2_plane_vaddr(&dst_buf->vb2_buf, 0);
-	jpeg_ctx.width = ctx->dst_fmt.width;
-	jpeg_ctx.height = ctx->dst_fmt.height;
-	jpeg_ctx.quality = ctx->jpeg_quality;
-	hantro_jpeg_header_assemble(&jpeg_ctx);
+	header = vb2_plane_vaddr(&dst_buf->vb2_buf, 0);
+	jpeg_ctx = hantro_jpeg_enc_prepare_header(ctx, header);
 
 	/* Switch to JPEG encoder mode before writing registers */
 	vepu_write_relaxed(vpu, H1_REG_ENC_CTRL_ENC_MODE_JPEG,
@@ -129,8 +126,8 @@ int hantro_h1_jpeg_enc_run(struct hantro_ctx *ctx)
 	hantro_h1_set_src_img_ctrl(vpu, ctx);
 	hantro_h1_jpeg_enc_set_buffers(vpu, ctx, &src_buf->vb2_buf,
 				       &dst_buf->vb2_buf);
-	hantro_h1_jpeg_enc_set_qtable(vpu, jpeg_ctx.hw_luma_qtable,
-				      jpeg_ctx.hw_chroma_qtable);
+	hantro_h1_jpeg_enc_set_qtable(vpu, jpeg_ctx->hw_luma_qtable,
+				      jpeg_ctx->hw_chroma_qtable);
 
 	reg = H1_REG_AXI_CTRL_OUTPUT_SWAP16
 		| H1_REG_AXI_CTRL_INPUT_SWAP16
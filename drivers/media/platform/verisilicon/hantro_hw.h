@@ -15,6 +15,8 @@
 #include <media/v4l2-vp9.h>
 #include <media/videobuf2-core.h>
 
+#include "hantro_jpeg.h"
+
 #define DEC_8190_ALIGN_MASK	0x07U
 
 #define MB_DIM			16
@@ -195,6 +197,18 @@ struct hantro_vp9_frame_info {
 #define MAX_SB_COLS	64
 #define MAX_SB_ROWS	34
 
+/**
+ * struct hantro_jpeg_enc_hw_ctx
+ *
+ * @jpeg:	Size, quality and hardware quantization tables @header
+ *		was assembled for. Zero size until the first frame.
+ * @header:	JPEG header copied at the start of every output buffer.
+ */
+struct hantro_jpeg_enc_hw_ctx {
+	struct hantro_jpeg_ctx jpeg;
+	unsigned char header[JPEG_HEADER_SIZE];
+};
+
 /**
  * struct hantro_vp9_dec_hw_ctx
  *
@@ -264,11 +278,16 @@ struct hantro_postproc_ctx {
  * @enum_framesizes:	Enumerate possible scaled output formats.
  *			Returns zero if OK, a negative value in error cases.
  *			Optional.
+ * @try_size:		Check whether the decoded frame can be scaled to the
+ *			given output size, possibly adjusting it to one the
+ *			post-processor can produce. Optional, no scaling if
+ *			missing.
  */
 struct hantro_postproc_ops {
 	void (*enable)(struct hantro_ctx *ctx);
 	void (*disable)(struct hantro_ctx *ctx);
 	int (*enum_framesizes)(struct hantro_ctx *ctx, struct v4l2_frmsizeenum *fsize);
+	bool (*try_size)(const struct hantro_ctx *ctx, u32 *width, u32 *height);
 };
 
 /**
@@ -334,6 +353,7 @@ void hantro_irq_done(struct hantro_dev *vpu,
 		     enum vb2_buffer_state result);
 void hantro_start_prepare_run(struct hantro_ctx *ctx);
 void hantro_end_prepare_run(struct hantro_ctx *ctx);
+void hantro_sched_stop(struct hantro_ctx *ctx);
 
 irqreturn_t hantro_g1_irq(int irq, void *dev_id);
 void hantro_g1_reset(struct hantro_ctx *ctx);
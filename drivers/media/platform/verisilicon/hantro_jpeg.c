@@ -346,3 +346,29 @@ void hantro_jpeg_header_assemble(struct hantro_jpeg_ctx *ctx)
 
 	jpeg_set_quality(ctx);
 }
+
+/*
+ * Copy the JPEG header into the output buffer at @dst. The header and
+ * the hardware quantization tables only depend on the frame size and
+ * quality, so they are assembled once and reused until either changes.
+ */
+const struct hantro_jpeg_ctx *
+hantro_jpeg_enc_prepare_header(struct hantro_ctx *ctx, void *dst)
+{
+	struct hantro_jpeg_enc_hw_ctx *jpeg_enc = &ctx->jpeg_enc;
+	struct hantro_jpeg_ctx *jpeg = &jpeg_enc->jpeg;
+
+	if (jpeg->width != ctx->dst_fmt.width ||
+	    jpeg->height != ctx->dst_fmt.height ||
+	    jpeg->quality != ctx->jpeg_quality) {
+		jpeg->buffer = jpeg_enc->header;
+		jpeg->width = ctx->dst_fmt.width;
+		jpeg->height = ctx->dst_fmt.height;
+		jpeg->quality = ctx->jpeg_quality;
+		hantro_jpeg_header_assemble(jpeg);
+	}
+
+	memcpy(dst, jpeg_enc->header, JPEG_HEADER_SIZE);
+
+	return jpeg;
+}
@@ -1,8 +1,13 @@
 /* SPDX-License-Identifier: GPL-2.0+ */
 
+#ifndef HANTRO_JPEG_H_
+#define HANTRO_JPEG_H_
+
 #define JPEG_HEADER_SIZE	624
 #define JPEG_QUANT_SIZE		64
 
+struct hantro_ctx;
+
 struct hantro_jpeg_ctx {
 	int width;
 	int height;
@@ -13,3 +18,7 @@ struct hantro_jpeg_ctx {
 };
 
 void hantro_jpeg_header_assemble(struct hantro_jpeg_ctx *ctx);
+const struct hantro_jpeg_ctx *
+hantro_jpeg_enc_prepare_header(struct hantro_ctx *ctx, void *dst);
+
+#endif /* HANTRO_JPEG_H_ */
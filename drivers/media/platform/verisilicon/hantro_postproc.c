@@ -34,6 +34,8 @@
 #define VPU_PP_IN_YUV240_TILED		0x5
 #define VPU_PP_OUT_RGB			0x0
 #define VPU_PP_OUT_YUYV			0x3
+#define VPU_PP_SCALE_NONE		0x0
+#define VPU_PP_SCALE_DOWN		0x2
 
 static const struct hantro_postproc_regs hantro_g1_postproc_regs = {
 	.pipeline_en = {G1_REG_PP_INTERRUPT, 1, 0x1},
@@ -50,6 +52,10 @@ static const struct hantro_postproc_regs hantro_g1_postproc_regs = {
 	.output_fmt = {G1_REG_PP_CONTROL, 26, 0x7},
 	.orig_width = {G1_REG_PP_MASK1_ORIG_WIDTH, 23, 0x1ff},
 	.display_width = {G1_REG_PP_DISPLAY_WIDTH, 0, 0xfff},
+	.hor_scale_mode = {G1_REG_PP_CONTROL, 2, 0x3},
+	.ver_scale_mode = {G1_REG_PP_CONTROL, 0, 0x3},
+	.wscale_invra = {G1_REG_PP_SCALING2, 16, 0xffff},
+	.hscale_invra = {G1_REG_PP_SCALING2, 0, 0xffff},
 };
 
 bool hantro_needs_postproc(const struct hantro_ctx *ctx,
@@ -91,14 +97,77 @@ static void hantro_postproc_g1_enable(struct hantro_ctx *ctx)
 	HANTRO_PP_REG_WRITE(vpu, out_swap32, 0x1);
 	HANTRO_PP_REG_WRITE(vpu, max_burst, 16);
 	HANTRO_PP_REG_WRITE(vpu, out_luma_base, dst_dma);
-	HANTRO_PP_REG_WRITE(vpu, input_width, MB_WIDTH(ctx->dst_fmt.width));
-	HANTRO_PP_REG_WRITE(vpu, input_height, MB_HEIGHT(ctx->dst_fmt.height));
+	HANTRO_PP_REG_WRITE(vpu, input_width, MB_WIDTH(ctx->src_fmt.width));
+	HANTRO_PP_REG_WRITE(vpu, input_height, MB_HEIGHT(ctx->src_fmt.height));
 	HANTRO_PP_REG_WRITE(vpu, input_fmt, src_pp_fmt);
 	HANTRO_PP_REG_WRITE(vpu, output_fmt, dst_pp_fmt);
 	HANTRO_PP_REG_WRITE(vpu, output_width, ctx->dst_fmt.width);
 	HANTRO_PP_REG_WRITE(vpu, output_height, ctx->dst_fmt.height);
-	HANTRO_PP_REG_WRITE(vpu, orig_width, MB_WIDTH(ctx->dst_fmt.width));
+	HANTRO_PP_REG_WRITE(vpu, orig_width, MB_WIDTH(ctx->src_fmt.width));
 	HANTRO_PP_REG_WRITE(vpu, display_width, ctx->dst_fmt.width);
+
+	/*
+	 * In downscaling mode the inverse ratios are the output size over
+	 * the input size, as 0.16 fixed point.
+	 */
+	if (ctx->dst_fmt.width < ctx->src_fmt.width) {
+		HANTRO_PP_REG_WRITE(vpu, hor_scale_mode, VPU_PP_SCALE_DOWN);
+		HANTRO_PP_REG_WRITE(vpu, wscale_invra,
+				    (ctx->dst_fmt.width << 16) /
+				    ctx->src_fmt.width);
+	} else {
+		HANTRO_PP_REG_WRITE(vpu, hor_scale_mode, VPU_PP_SCALE_NONE);
+	}
+
+	if (ctx->dst_fmt.height < ctx->src_fmt.height) {
+		HANTRO_PP_REG_WRITE(vpu, ver_scale_mode, VPU_PP_SCALE_DOWN);
+		HANTRO_PP_REG_WRITE(vpu, hscale_invra,
+				    (ctx->dst_fmt.height << 16) /
+				    ctx->src_fmt.height);
+	} else {
+		HANTRO_PP_REG_WRITE(vpu, ver_scale_mode, VPU_PP_SCALE_NONE);
+	}
+}
+
+static int hantro_postproc_g1_enum_framesizes(struct hantro_ctx *ctx,
+					      struct v4l2_frmsizeenum *fsize)
+{
+	if (fsize->index != 0)
+		return -EINVAL;
+
+	if (!ctx->src_fmt.width || !ctx->src_fmt.height)
+		return -EINVAL;
+
+	/* G1 scaler can scale down by any ratio, but not up */
+	fsize->type = V4L2_FRMSIZE_TYPE_STEPWISE;
+	fsize->stepwise.min_width = FMT_MIN_WIDTH;
+	fsize->stepwise.max_width = ctx->src_fmt.width;
+	fsize->stepwise.step_width = MB_DIM;
+	fsize->stepwise.min_height = FMT_MIN_HEIGHT;
+	fsize->stepwise.max_height = ctx->src_fmt.height;
+	fsize->stepwise.step_height = MB_DIM;
+
+	return 0;
+}
+
+static bool hantro_postproc_g1_try_size(const struct hantro_ctx *ctx,
+					u32 *width, u32 *height)
+{
+	if (*width < FMT_MIN_WIDTH || *width > ctx->src_fmt.width ||
+	    *height < FMT_MIN_HEIGHT || *height > ctx->src_fmt.height)
+		return false;
+
+	/*
+	 * Scaled sizes are whole macroblocks, as enumerated. Round down, as
+	 * the frmsize constraints would otherwise round up past the coded
+	 * size, which the scaler can't reach.
+	 */
+	if (*width < ctx->src_fmt.width)
+		*width = round_down(*width, MB_DIM);
+	if (*height < ctx->src_fmt.height)
+		*height = round_down(*height, MB_DIM);
+
+	return true;
 }
 
 static int down_scale_factor(struct hantro_ctx *ctx)
@@ -170,6 +239,20 @@ static int hantro_postproc_g2_enum_framesizes(struct hantro_ctx *ctx,
 	return 0;
 }
 
+static bool hantro_postproc_g2_try_size(const struct hantro_ctx *ctx,
+					u32 *width, u32 *height)
+{
+	unsigned int i;
+
+	for (i = 0; i <= 3; i++) {
+		if (*width == ctx->src_fmt.width >> i &&
+		    *height == ctx->src_fmt.height >> i)
+			return true;
+	}
+
+	return false;
+}
+
 void hantro_postproc_free(struct hantro_ctx *ctx)
 {
 	struct hantro_dev *vpu = ctx->dev;
@@ -272,13 +355,27 @@ int hanto_postproc_enum_framesizes(struct hantro_ctx *ctx,
 	return -EINVAL;
 }
 
+bool hantro_postproc_try_size(const struct hantro_ctx *ctx,
+			      u32 *width, u32 *height)
+{
+	struct hantro_dev *vpu = ctx->dev;
+
+	if (vpu->variant->postproc_ops && vpu->variant->postproc_ops->try_size)
+		return vpu->variant->postproc_ops->try_size(ctx, width, height);
+
+	return false;
+}
+
 const struct hantro_postproc_ops hantro_g1_postproc_ops = {
 	.enable = hantro_postproc_g1_enable,
 	.disable = hantro_postproc_g1_disable,
+	.enum_framesizes = hantro_postproc_g1_enum_framesizes,
+	.try_size = hantro_postproc_g1_try_size,
 };
 
 const struct hantro_postproc_ops hantro_g2_postproc_ops = {
 	.enable = hantro_postproc_g2_enable,
 	.disable = hantro_postproc_g2_disable,
 	.enum_framesizes = hantro_postproc_g2_enum_framesizes,
+	.try_size = hantro_postproc_g2_try_size,
 };
@@ -307,10 +307,15 @@ static int hantro_try_fmt(const struct hantro_ctx *ctx,
 		vpu_fmt = fmt;
 		/*
 		 * Width/height on the CAPTURE end of a decoder are ignored and
-		 * replaced by the OUTPUT ones.
+		 * replaced by the OUTPUT ones, unless the post-processor can
+		 * scale the decoded frame to the requested size.
 		 */
-		pix_mp->width = ctx->src_fmt.width;
-		pix_mp->height = ctx->src_fmt.height;
+		if (!hantro_needs_postproc(ctx, fmt) ||
+		    !hantro_postproc_try_size(ctx, &pix_mp->width,
+					      &pix_mp->height)) {
+			pix_mp->width = ctx->src_fmt.width;
+			pix_mp->height = ctx->src_fmt.height;
+		}
 	}
 
 	pix_mp->field = V4L2_FIELD_NONE;
@@ -959,6 +964,7 @@ static void hantro_stop_streaming(struct vb2_queue *q)
 		hantro_return_bufs(q, v4l2_m2m_dst_buf_remove);
 
 	v4l2_m2m_update_stop_streaming_state(ctx->fh.m2m_ctx, q);
+	hantro_sched_stop(ctx);
 
 	if (V4L2_TYPE_IS_OUTPUT(q->type) &&
 	    v4l2_m2m_has_stopped(ctx->fh.m2m_ctx))
@@ -104,15 +104,15 @@ static void rockchip_vpu2_jpeg_enc_set_buffers(struct hantro_dev *vpu,
 
 static void
 rockchip_vpu2_jpeg_enc_set_qtable(struct hantro_dev *vpu,
-				  unsigned char *luma_qtable,
-				  unsigned char *chroma_qtable)
+				  const unsigned char *luma_qtable,
+				  const unsigned char *chroma_qtable)
 {
 	u32 reg, i;
-	__be32 *luma_qtable_p;
-	__be32 *chroma_qtable_p;
+	const __be32 *luma_qtable_p;
+	const __be32 *chroma_qtable_p;
 
-	luma_qtable_p = (__be32 *)luma_qtable;
-	chroma_qtable_p = (__be32 *)chroma_qtable;
+	luma_qtable_p = (const __be32 *)luma_qtable;
+	chroma_qtable_p = (const __be32 *)chroma_qtable;
 
 	/*
 	 * Quantization table registers must be written in contiguous blocks.
@@ -133,7 +133,8 @@ int rockchip_vpu2_jpeg_enc_run(struct hantro_ctx *ctx)
 {
 	struct hantro_dev *vpu = ctx->dev;
 	struct vb2_v4l2_buffer *src_buf, *dst_buf;
-	struct hantro_jpeg_ctx jpeg_ctx;
+	const struct hantro_jpeg_ctx *jpeg_ctx;
+	void *header;
 	u32 reg;
 
 	src_buf = hantro_get_src_buf(ctx);
@@ -141,15 +142,11 @@ int rockchip_vpu2_jpeg_enc_run(struct hantro_ctx *ctx)
 
 	hantro_start_prepare_run(ctx);
 
-	memset(&jpeg_ctx, 0, sizeof(jpeg_ctx));
-	jpeg_ctx.buffer = vb2_plane_vaddr(&dst_buf->vb2_buf, 0);
-	if (!jpeg_ctx.buffer)
+	header = vb2_plane_vaddr(&dst_buf->vb2_buf, 0);
+	if (!header)
 		return -ENOMEM;
 
-	jpeg_ctx.width = ctx->dst_fmt.width;
-	jpeg_ctx.height = ctx->dst_fmt.height;
-	jpeg_ctx.quality = ctx->jpeg_quality;
-	hantro_jpeg_header_assemble(&jpeg_ctx);
+	jpeg_ctx = hantro_jpeg_enc_prepare_header(ctx, header);
 
 	/* Switch to JPEG encoder mode before writing registers */
 	vepu_write_relaxed(vpu, VEPU_REG_ENCODE_FORMAT_JPEG,
@@ -158,8 +155,8 @@ int rockchip_vpu2_jpeg_enc_run(struct hantro_ctx *ctx)
 	rockchip_vpu2_set_src_img_ctrl(vpu, ctx);
 	rockchip_vpu2_jpeg_enc_set_buffers(vpu, ctx, &src_buf->vb2_buf,
 					   &dst_buf->vb2_buf);
-	rockchip_vpu2_jpeg_enc_set_qtable(vpu, jpeg_ctx.hw_luma_qtable,
-					  jpeg_ctx.hw_chroma_qtable);
+	rockchip_vpu2_jpeg_enc_set_qtable(vpu, jpeg_ctx->hw_luma_qtable,
+					  jpeg_ctx->hw_chroma_qtable);
 
 	reg = VEPU_REG_OUTPUT_SWAP32
 		| VEPU_REG_OUTPUT_SWAP16
@@ -511,8 +511,8 @@ int rockchip_vpu2_vp8_dec_run(struct hantro_ctx *ctx)
 	const struct v4l2_ctrl_vp8_frame *hdr;
 	struct hantro_dev *vpu = ctx->dev;
 	struct vb2_v4l2_buffer *vb2_dst;
-	size_t height = ctx->dst_fmt.height;
-	size_t width = ctx->dst_fmt.width;
+	size_t height = ctx->src_fmt.height;
+	size_t width = ctx->src_fmt.width;
 	u32 mb_width, mb_height;
 	u32 reg;
 
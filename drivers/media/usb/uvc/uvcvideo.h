@@ -49,8 +49,11 @@
 
 /* Number of isochronous URBs. */
 #define UVC_URBS		5
-/* Maximum number of packets per URB. */
-#define UVC_MAX_PACKETS		32
+/*
+ * Maximum number of packets per URB. At high speed with one high bandwidth
+ * packet per microframe this is 8ms per URB, 40ms queued in total.
+ */
+#define UVC_MAX_PACKETS		64
 /* Maximum status buffer size in bytes of interrupt URB. */
 #define UVC_MAX_STATUS_SIZE	16
 
@@ -392,6 +392,25 @@ void v4l2_ctrl_request_complete(struct media_request *req,
 }
 EXPORT_SYMBOL(v4l2_ctrl_request_complete);
 
+/*
+ * Stateless codec userspace tends to resend the same SPS, PPS and scaling
+ * matrices with every request. A request value that matches the current one
+ * has already been through try_ctrl when it was set and cannot change
+ * anything, so there is no need to copy it into p_new and compare it again.
+ */
+static bool req_matches_cur(struct v4l2_ctrl_ref *ref)
+{
+	struct v4l2_ctrl *ctrl = ref->ctrl;
+
+	if (ctrl->flags & (V4L2_CTRL_FLAG_EXECUTE_ON_WRITE |
+			   V4L2_CTRL_FLAG_VOLATILE))
+		return false;
+	if (ref->p_req_elems != ctrl->elems)
+		return false;
+
+	return ctrl->type_ops->equal(ctrl, ref->p_req, ctrl->p_cur);
+}
+
 int v4l2_ctrl_request_setup(struct media_request *req,
 			    struct v4l2_ctrl_handler *main_hdl)
 {
@@ -442,7 +461,8 @@ int v4l2_ctrl_request_setup(struct media_request *req,
 				struct v4l2_ctrl_ref *r =
 					find_ref(hdl, master->cluster[i]->id);
 
-				if (r->p_req_valid) {
+				if (r->p_req_valid &&
+				    (master->is_auto || !req_matches_cur(r))) {
 					have_new_data = true;
 					break;
 				}
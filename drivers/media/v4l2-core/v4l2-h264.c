@@ -8,7 +8,6 @@
  */
 
 #include <linux/module.h>
-#include <linux/sort.h>
 
 #include <media/v4l2-h264.h>
 
@@ -250,6 +249,27 @@ static int v4l2_h264_b1_ref_list_cmp(const void *ptra, const void *ptrb,
 	return poca < pocb ? -1 : 1;
 }
 
+/*
+ * The lists hold at most 32 two byte entries and the DPB order is often close
+ * to the final one, so a plain insertion sort beats sort_r() and its generic
+ * swap callbacks here.
+ */
+static void
+v4l2_h264_sort_reflist(const struct v4l2_h264_reflist_builder *builder,
+		       struct v4l2_h264_reference *reflist,
+		       int (*cmp)(const void *, const void *, const void *))
+{
+	struct v4l2_h264_reference tmp;
+	int i, j;
+
+	for (i = 1; i < builder->num_valid; i++) {
+		tmp = reflist[i];
+		for (j = i; j > 0 && cmp(&reflist[j - 1], &tmp, builder) > 0; j--)
+			reflist[j] = reflist[j - 1];
+		reflist[j] = tmp;
+	}
+}
+
 /*
  * The references need to be reordered so that references are alternating
  * between top and bottom field references starting with the current picture
@@ -395,8 +415,7 @@ v4l2_h264_build_p_ref_list(const struct v4l2_h264_reflist_builder *builder,
 {
 	memcpy(reflist, builder->unordered_reflist,
 	       sizeof(builder->unordered_reflist[0]) * builder->num_valid);
-	sort_r(reflist, builder->num_valid, sizeof(*reflist),
-	       v4l2_h264_p_ref_list_cmp, NULL, builder);
+	v4l2_h264_sort_reflist(builder, reflist, v4l2_h264_p_ref_list_cmp);
 
 	if (builder->cur_pic_fields != V4L2_H264_FRAME_REF)
 		reorder_field_reflist(builder, reflist);
@@ -426,13 +445,11 @@ v4l2_h264_build_b_ref_lists(const struct v4l2_h264_reflist_builder *builder,
 {
 	memcpy(b0_reflist, builder->unordered_reflist,
 	       sizeof(builder->unordered_reflist[0]) * builder->num_valid);
-	sort_r(b0_reflist, builder->num_valid, sizeof(*b0_reflist),
-	       v4l2_h264_b0_ref_list_cmp, NULL, builder);
+	v4l2_h264_sort_reflist(builder, b0_reflist, v4l2_h264_b0_ref_list_cmp);
 
 	memcpy(b1_reflist, builder->unordered_reflist,
 	       sizeof(builder->unordered_reflist[0]) * builder->num_valid);
-	sort_r(b1_reflist, builder->num_valid, sizeof(*b1_reflist),
-	       v4l2_h264_b1_ref_list_cmp, NULL, builder);
+	v4l2_h264_sort_reflist(builder, b1_reflist, v4l2_h264_b1_ref_list_cmp);
 
 	if (builder->cur_pic_fields != V4L2_H264_FRAME_REF) {
 		reorder_field_reflist(builder, b0_reflist);
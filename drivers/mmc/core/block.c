@@ -137,6 +137,12 @@ struct mmc_blk_data {
 #define MMC_BLK_PART_INVALID	UINT_MAX	/* Unknown partition active */
 	int	area_type;
 
+	/*
+	 * Only used in main mmc_blk_data, set when a write may have left
+	 * data in the card's cache since the last successful cache flush.
+	 */
+	bool	cache_dirty;
+
 	/* debugfs files (only in main mmc_blk_data) */
 	struct dentry *status_dentry;
 	struct dentry *ext_csd_dentry;
@@ -1256,9 +1262,24 @@ static void mmc_blk_issue_flush(struct mmc_queue *mq, struct request *req)
 {
 	struct mmc_blk_data *md = mq->blkdata;
 	struct mmc_card *card = md->queue.card;
+	struct mmc_blk_data *main_md = dev_get_drvdata(&card->dev);
 	int ret = 0;
 
+	/*
+	 * We get here only once everything issued before has completed, so
+	 * if nothing was written since the last flush there is nothing left
+	 * in the cache to flush. This lets concurrent fsyncs queued behind
+	 * one flush complete without sending one each.
+	 */
+	if (!main_md->cache_dirty) {
+		blk_mq_end_request(req, BLK_STS_OK);
+		return;
+	}
+
+	main_md->cache_dirty = false;
 	ret = mmc_flush_cache(card->host);
+	if (ret)
+		main_md->cache_dirty = true;
 	blk_mq_end_request(req, ret ? BLK_STS_IOERR : BLK_STS_OK);
 }
 
@@ -2367,6 +2388,12 @@ enum mmc_issued mmc_blk_mq_issue_rq(struct mmc_queue *mq, struct request *req)
 	if (ret)
 		return MMC_REQ_FAILED_TO_START;
 
+	if (op_is_write(req_op(req))) {
+		struct mmc_blk_data *main_md = dev_get_drvdata(&card->dev);
+
+		main_md->cache_dirty = true;
+	}
+
 	switch (mmc_issue_type(mq, req)) {
 	case MMC_ISSUE_SYNC:
 		ret = mmc_blk_wait_for_idle(mq, host);
@@ -2467,6 +2494,7 @@ static struct mmc_blk_data *mmc_blk_alloc_req(struct mmc_card *card,
 	}
 
 	md->area_type = area_type;
+	md->cache_dirty = true;
 
 	/*
 	 * Set the read-only status based on the supported commands
@@ -298,6 +298,48 @@ static const struct file_operations mmc_err_stats_fops = {
 	.release = single_release,
 };
 
+static int mmc_qdepth_stats_show(struct seq_file *file, void *data)
+{
+	struct mmc_host *host = (struct mmc_host *)file->private;
+	const char *desc[MMC_QDEPTH_BUCKETS] = {
+		"1", "2", "3-4", "5-8", "9-16", "17+",
+	};
+	int i;
+
+	seq_printf(file, "# CQE:\t %s\n", host->cqe_on ? "on" : "off");
+	seq_printf(file, "# Max depth:\t %u\n", host->qdepth_max);
+	for (i = 0; i < MMC_QDEPTH_BUCKETS; i++)
+		seq_printf(file, "# Depth %s:\t %u\n",
+			   desc[i], host->qdepth_stats[i]);
+
+	return 0;
+}
+
+static int mmc_qdepth_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mmc_qdepth_stats_show, inode->i_private);
+}
+
+static ssize_t mmc_qdepth_stats_write(struct file *filp,
+				      const char __user *ubuf,
+				      size_t cnt, loff_t *ppos)
+{
+	struct mmc_host *host = filp->f_mapping->host->i_private;
+
+	pr_debug("%s: Resetting MMC queue depth statistics\n", __func__);
+	memset(host->qdepth_stats, 0, sizeof(host->qdepth_stats));
+	host->qdepth_max = 0;
+
+	return cnt;
+}
+
+static const struct file_operations mmc_qdepth_stats_fops = {
+	.open	= mmc_qdepth_stats_open,
+	.read	= seq_read,
+	.write	= mmc_qdepth_stats_write,
+	.release = single_release,
+};
+
 void mmc_add_host_debugfs(struct mmc_host *host)
 {
 	struct dentry *root;
@@ -315,6 +357,8 @@ void mmc_add_host_debugfs(struct mmc_host *host)
 			    &mmc_err_state);
 	debugfs_create_file("err_stats", 0600, root, host,
 			    &mmc_err_stats_fops);
+	debugfs_create_file("qdepth_stats", 0600, root, host,
+			    &mmc_qdepth_stats_fops);
 
 #ifdef CONFIG_FAIL_MMC_REQUEST
 	if (fail_request)
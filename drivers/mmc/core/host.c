@@ -276,7 +276,7 @@ EXPORT_SYMBOL(mmc_of_parse_clk_phase);
 int mmc_of_parse(struct mmc_host *host)
 {
 	struct device *dev = host->parent;
-	u32 bus_width, drv_type, cd_debounce_delay_ms;
+	u32 bus_width, drv_type, cd_debounce_delay_ms, cpu;
 	int ret;
 
 	if (!dev || !dev_fwnode(dev))
@@ -431,6 +431,16 @@ int mmc_of_parse(struct mmc_host *host)
 	device_property_read_u32(dev, "post-power-on-delay-ms",
 				 &host->ios.power_delay_ms);
 
+	/*
+	 * Neither is set by default: SDIO IRQ work stays unbound and every
+	 * card interrupt is followed by unmasking it again.
+	 */
+	if (!device_property_read_u32(dev, "sdio-irq-cpu", &cpu) &&
+	    cpu < nr_cpu_ids && cpu_possible(cpu))
+		host->sdio_irq_cpu = cpu;
+	device_property_read_u32(dev, "sdio-irq-poll-us",
+				 &host->sdio_irq_poll_us);
+
 	return mmc_pwrseq_alloc(host);
 }
 
@@ -566,6 +576,7 @@ struct mmc_host *mmc_alloc_host(int extra, struct device *dev)
 	init_waitqueue_head(&host->wq);
 	INIT_DELAYED_WORK(&host->detect, mmc_rescan);
 	INIT_WORK(&host->sdio_irq_work, sdio_irq_work);
+	host->sdio_irq_cpu = WORK_CPU_UNBOUND;
 	timer_setup(&host->retune_timer, mmc_retune_timer, 0);
 
 	/*
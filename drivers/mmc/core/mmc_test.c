@@ -8,6 +8,7 @@
 #include <linux/mmc/host.h>
 #include <linux/mmc/mmc.h>
 #include <linux/slab.h>
+#include <linux/sort.h>
 
 #include <linux/scatterlist.h>
 #include <linux/list.h>
@@ -39,6 +40,18 @@
  */
 #define TEST_AREA_MAX_SIZE (128 * 1024 * 1024)
 
+/*
+ * Latency tests use 4KiB random transfers and keep the latency of at most
+ * MMC_TEST_LAT_MAX of them per measurement.
+ */
+#define MMC_TEST_LAT_SZ		4096
+#define MMC_TEST_LAT_MAX	65536
+#define MMC_TEST_LAT_PCTS	5
+#define MMC_TEST_LAT_SECS	10
+
+/* Duration of the sustained write test, measured in 1 second windows */
+#define MMC_TEST_SUSTAINED_SECS	60
+
 /**
  * struct mmc_test_pages - pages allocated by 'alloc_pages()'.
  * @page: first page in the allocation
@@ -93,6 +106,8 @@ struct mmc_test_area {
  * @ts: time values of transfer
  * @rate: calculated transfer rate
  * @iops: I/O operations per second (times 100)
+ * @qd: queue depth, 0 if the test doesn't measure latency
+ * @lat: latency percentiles in microseconds, see mmc_test_lat_pct[]
  */
 struct mmc_test_transfer_result {
 	struct list_head link;
@@ -101,6 +116,8 @@ struct mmc_test_transfer_result {
 	struct timespec64 ts;
 	unsigned int rate;
 	unsigned int iops;
+	unsigned int qd;
+	unsigned int lat[MMC_TEST_LAT_PCTS];
 };
 
 /**
@@ -530,18 +547,19 @@ static unsigned int mmc_test_rate(uint64_t bytes, struct timespec64 *ts)
 /*
  * Save transfer results for future usage
  */
-static void mmc_test_save_transfer_result(struct mmc_test_card *test,
+static struct mmc_test_transfer_result *
+mmc_test_save_transfer_result(struct mmc_test_card *test,
 	unsigned int count, unsigned int sectors, struct timespec64 ts,
 	unsigned int rate, unsigned int iops)
 {
 	struct mmc_test_transfer_result *tr;
 
 	if (!test->gr)
-		return;
+		return NULL;
 
-	tr = kmalloc(sizeof(*tr), GFP_KERNEL);
+	tr = kzalloc(sizeof(*tr), GFP_KERNEL);
 	if (!tr)
-		return;
+		return NULL;
 
 	tr->count = count;
 	tr->sectors = sectors;
@@ -550,6 +568,8 @@ static void mmc_test_save_transfer_result(struct mmc_test_card *test,
 	tr->iops = iops;
 
 	list_add_tail(&tr->link, &test->gr->tr_lst);
+
+	return tr;
 }
 
 /*
@@ -579,9 +599,10 @@ static void mmc_test_print_rate(struct mmc_test_card *test, uint64_t bytes,
 /*
  * Print the average transfer rate.
  */
-static void mmc_test_print_avg_rate(struct mmc_test_card *test, uint64_t bytes,
-				    unsigned int count, struct timespec64 *ts1,
-				    struct timespec64 *ts2)
+static struct mmc_test_transfer_result *
+mmc_test_print_avg_rate(struct mmc_test_card *test, uint64_t bytes,
+			unsigned int count, struct timespec64 *ts1,
+			struct timespec64 *ts2)
 {
 	unsigned int rate, iops, sectors = bytes >> 9;
 	uint64_t tot = bytes * count;
@@ -601,7 +622,8 @@ static void mmc_test_print_avg_rate(struct mmc_test_card *test, uint64_t bytes,
 			 rate / 1000, rate / 1024, iops / 100, iops % 100,
 			 test->area.sg_len);
 
-	mmc_test_save_transfer_result(test, count, sectors, ts, rate, iops);
+	return mmc_test_save_transfer_result(test, count, sectors, ts, rate,
+					     iops);
 }
 
 /*
@@ -1908,32 +1930,42 @@ static unsigned int mmc_test_rnd_num(unsigned int rnd_cnt)
 	return (r * rnd_cnt) >> 15;
 }
 
-static int mmc_test_rnd_perf(struct mmc_test_card *test, int write, int print,
-			     unsigned long sz)
+/*
+ * Pick a random address for a transfer of @ssz sectors in the second quarter
+ * of the card, never in the same erase unit as the previous one.
+ */
+static unsigned int mmc_test_rnd_addr(struct mmc_test_card *test,
+				      unsigned int ssz, unsigned int *last_ea)
 {
-	unsigned int dev_addr, cnt, rnd_addr, range1, range2, last_ea = 0, ea;
-	unsigned int ssz;
-	struct timespec64 ts1, ts2, ts;
-	int ret;
-
-	ssz = sz >> 9;
+	unsigned int rnd_addr, range1, range2, ea;
 
 	rnd_addr = mmc_test_capacity(test->card) / 4;
 	range1 = rnd_addr / test->card->pref_erase;
 	range2 = range1 / ssz;
 
+	ea = mmc_test_rnd_num(range1);
+	if (ea == *last_ea)
+		ea -= 1;
+	*last_ea = ea;
+
+	return rnd_addr + test->card->pref_erase * ea +
+	       ssz * mmc_test_rnd_num(range2);
+}
+
+static int mmc_test_rnd_perf(struct mmc_test_card *test, int write, int print,
+			     unsigned long sz)
+{
+	unsigned int dev_addr, cnt, last_ea = 0;
+	struct timespec64 ts1, ts2, ts;
+	int ret;
+
 	ktime_get_ts64(&ts1);
 	for (cnt = 0; cnt < UINT_MAX; cnt++) {
 		ktime_get_ts64(&ts2);
 		ts = timespec64_sub(ts2, ts1);
 		if (ts.tv_sec >= 10)
 			break;
-		ea = mmc_test_rnd_num(range1);
-		if (ea == last_ea)
-			ea -= 1;
-		last_ea = ea;
-		dev_addr = rnd_addr + test->card->pref_erase * ea +
-			   ssz * mmc_test_rnd_num(range2);
+		dev_addr = mmc_test_rnd_addr(test, sz >> 9, &last_ea);
 		ret = mmc_test_area_io(test, sz, dev_addr, write, 0, 0);
 		if (ret)
 			return ret;
@@ -1994,6 +2026,220 @@ static int mmc_test_random_write_perf(struct mmc_test_card *test)
 	return mmc_test_random_perf(test, 1);
 }
 
+/* Reported latency percentiles, in tenths of a percent */
+static const unsigned int mmc_test_lat_pct[MMC_TEST_LAT_PCTS] = {
+	500, 900, 990, 999, 1000,
+};
+
+static int mmc_test_lat_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void mmc_test_lat_pcts(u32 *lat, unsigned int cnt, unsigned int *pcts)
+{
+	unsigned int i, idx;
+
+	if (!cnt) {
+		memset(pcts, 0, MMC_TEST_LAT_PCTS * sizeof(*pcts));
+		return;
+	}
+
+	sort(lat, cnt, sizeof(*lat), mmc_test_lat_cmp, NULL);
+
+	for (i = 0; i < MMC_TEST_LAT_PCTS; i++) {
+		idx = cnt * mmc_test_lat_pct[i] / 1000;
+		pcts[i] = lat[min(idx, cnt - 1)];
+	}
+}
+
+/*
+ * Do random transfers of the size mapped by mmc_test_area_map() one at a time
+ * for @secs seconds, recording the latency of each.
+ */
+static int mmc_test_lat_blocking(struct mmc_test_card *test, int write,
+				 unsigned int secs, u32 *lat,
+				 unsigned int *cnt)
+{
+	struct mmc_test_area *t = &test->area;
+	unsigned int dev_addr, last_ea = 0;
+	ktime_t start, t0;
+	int ret;
+
+	start = ktime_get();
+	while (*cnt < MMC_TEST_LAT_MAX) {
+		t0 = ktime_get();
+		if (ktime_ms_delta(t0, start) >= secs * MSEC_PER_SEC)
+			break;
+		dev_addr = mmc_test_rnd_addr(test, t->blocks, &last_ea);
+		ret = mmc_test_area_transfer(test, dev_addr, write);
+		if (ret)
+			return ret;
+		lat[(*cnt)++] = ktime_us_delta(ktime_get(), t0);
+	}
+
+	return 0;
+}
+
+/*
+ * Same as mmc_test_lat_blocking() but keep a second request prepared while
+ * the first one is in flight, i.e. a queue depth of 2. The latency of a
+ * request runs from its preparation to the completion of its transfer.
+ */
+static int mmc_test_lat_nonblock(struct mmc_test_card *test, int write,
+				 unsigned int secs, u32 *lat,
+				 unsigned int *cnt)
+{
+	struct mmc_test_area *t = &test->area;
+	struct scatterlist *sg = t->sg;
+	struct scatterlist *sg_areq = t->sg_areq;
+	struct mmc_request *mrq, *prev_mrq;
+	unsigned int dev_addr, last_ea = 0;
+	ktime_t start, t_mrq, t_prev = 0;
+	struct mmc_test_req *rq1, *rq2;
+	int ret = RESULT_OK;
+
+	rq1 = mmc_test_req_alloc();
+	rq2 = mmc_test_req_alloc();
+	if (!rq1 || !rq2) {
+		ret = RESULT_FAIL;
+		goto err;
+	}
+
+	mrq = &rq1->mrq;
+	prev_mrq = NULL;
+
+	start = ktime_get();
+	while (*cnt < MMC_TEST_LAT_MAX - 1) {
+		t_mrq = ktime_get();
+		if (ktime_ms_delta(t_mrq, start) >= secs * MSEC_PER_SEC)
+			break;
+		dev_addr = mmc_test_rnd_addr(test, t->blocks, &last_ea);
+		mmc_test_req_reset(container_of(mrq, struct mmc_test_req, mrq));
+		mmc_test_prepare_mrq(test, mrq, sg, t->sg_len, dev_addr,
+				     t->blocks, 512, write);
+		ret = mmc_test_start_areq(test, mrq, prev_mrq);
+		if (ret)
+			goto err;
+
+		if (prev_mrq)
+			lat[(*cnt)++] = ktime_us_delta(ktime_get(), t_prev);
+		else
+			prev_mrq = &rq2->mrq;
+
+		swap(mrq, prev_mrq);
+		swap(sg, sg_areq);
+		t_prev = t_mrq;
+	}
+
+	ret = mmc_test_start_areq(test, NULL, prev_mrq);
+	if (!ret && prev_mrq)
+		lat[(*cnt)++] = ktime_us_delta(ktime_get(), t_prev);
+err:
+	kfree(rq1);
+	kfree(rq2);
+	return ret;
+}
+
+/*
+ * Random 4KiB transfers at queue depth @qd for @secs seconds, reporting IOPS
+ * and latency percentiles.
+ */
+static int mmc_test_rnd_lat(struct mmc_test_card *test, int write,
+			    unsigned int qd, unsigned int secs)
+{
+	unsigned int pcts[MMC_TEST_LAT_PCTS];
+	struct mmc_test_transfer_result *tr;
+	struct timespec64 ts1, ts2;
+	unsigned int cnt = 0;
+	u32 *lat;
+	int ret;
+
+	lat = kvmalloc_array(MMC_TEST_LAT_MAX, sizeof(*lat), GFP_KERNEL);
+	if (!lat)
+		return -ENOMEM;
+
+	ret = mmc_test_area_map(test, MMC_TEST_LAT_SZ, 0, 0, qd > 1);
+	if (ret)
+		goto out;
+
+	ktime_get_ts64(&ts1);
+	if (qd > 1)
+		ret = mmc_test_lat_nonblock(test, write, secs, lat, &cnt);
+	else
+		ret = mmc_test_lat_blocking(test, write, secs, lat, &cnt);
+	ktime_get_ts64(&ts2);
+	if (ret)
+		goto out;
+
+	mmc_test_lat_pcts(lat, cnt, pcts);
+
+	pr_info("%s: Queue depth %u latency: p50 %u us, p90 %u us, p99 %u us, p99.9 %u us, max %u us\n",
+		mmc_hostname(test->card->host), qd,
+		pcts[0], pcts[1], pcts[2], pcts[3], pcts[4]);
+
+	tr = mmc_test_print_avg_rate(test, MMC_TEST_LAT_SZ, cnt, &ts1, &ts2);
+	if (tr) {
+		tr->qd = qd;
+		memcpy(tr->lat, pcts, sizeof(pcts));
+	}
+out:
+	kvfree(lat);
+	return ret;
+}
+
+/*
+ * Random 4KiB read IOPS and latency at queue depth 1.
+ */
+static int mmc_test_rnd_lat_read_qd1(struct mmc_test_card *test)
+{
+	return mmc_test_rnd_lat(test, 0, 1, MMC_TEST_LAT_SECS);
+}
+
+/*
+ * Random 4KiB read IOPS and latency at queue depth 2.
+ */
+static int mmc_test_rnd_lat_read_qd2(struct mmc_test_card *test)
+{
+	return mmc_test_rnd_lat(test, 0, 2, MMC_TEST_LAT_SECS);
+}
+
+/*
+ * Random 4KiB write IOPS and latency at queue depth 1.
+ */
+static int mmc_test_rnd_lat_write_qd1(struct mmc_test_card *test)
+{
+	return mmc_test_rnd_lat(test, 1, 1, MMC_TEST_LAT_SECS);
+}
+
+/*
+ * Random 4KiB write IOPS and latency at queue depth 2.
+ */
+static int mmc_test_rnd_lat_write_qd2(struct mmc_test_card *test)
+{
+	return mmc_test_rnd_lat(test, 1, 2, MMC_TEST_LAT_SECS);
+}
+
+/*
+ * Sustained random 4KiB writes, reported per second so that the slowdown
+ * once the card starts garbage collecting shows up in the results.
+ */
+static int mmc_test_rnd_lat_sustained_write(struct mmc_test_card *test)
+{
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < MMC_TEST_SUSTAINED_SECS; i++) {
+		ret = mmc_test_rnd_lat(test, 1, 1, 1);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 static int mmc_test_seq_perf(struct mmc_test_card *test, int write,
 			     unsigned int tot_sz, int max_scatter)
 {
@@ -2926,6 +3172,41 @@ static const struct mmc_test_case mmc_test_cases[] = {
 		.run = mmc_test_cmds_during_write_cmd23_nonblock,
 		.cleanup = mmc_test_area_cleanup,
 	},
+
+	{
+		.name = "Random 4KiB read IOPS and latency, queue depth 1",
+		.prepare = mmc_test_area_prepare,
+		.run = mmc_test_rnd_lat_read_qd1,
+		.cleanup = mmc_test_area_cleanup,
+	},
+
+	{
+		.name = "Random 4KiB read IOPS and latency, queue depth 2",
+		.prepare = mmc_test_area_prepare,
+		.run = mmc_test_rnd_lat_read_qd2,
+		.cleanup = mmc_test_area_cleanup,
+	},
+
+	{
+		.name = "Random 4KiB write IOPS and latency, queue depth 1",
+		.prepare = mmc_test_area_prepare,
+		.run = mmc_test_rnd_lat_write_qd1,
+		.cleanup = mmc_test_area_cleanup,
+	},
+
+	{
+		.name = "Random 4KiB write IOPS and latency, queue depth 2",
+		.prepare = mmc_test_area_prepare,
+		.run = mmc_test_rnd_lat_write_qd2,
+		.cleanup = mmc_test_area_cleanup,
+	},
+
+	{
+		.name = "Sustained random 4KiB write performance",
+		.prepare = mmc_test_area_prepare,
+		.run = mmc_test_rnd_lat_sustained_write,
+		.cleanup = mmc_test_area_cleanup,
+	},
 };
 
 static DEFINE_MUTEX(mmc_test_lock);
@@ -3138,6 +3419,47 @@ static const struct file_operations mmc_test_fops_test = {
 	.release	= single_release,
 };
 
+/*
+ * Same results as the "test" file, one "key=value" record per line so that
+ * they can be collected by scripts.
+ */
+static int mtf_results_show(struct seq_file *sf, void *data)
+{
+	struct mmc_card *card = (struct mmc_card *)sf->private;
+	struct mmc_test_general_result *gr;
+
+	mutex_lock(&mmc_test_lock);
+
+	list_for_each_entry(gr, &mmc_test_result, link) {
+		struct mmc_test_transfer_result *tr;
+
+		if (gr->card != card)
+			continue;
+
+		if (list_empty(&gr->tr_lst))
+			seq_printf(sf, "test=%d result=%d\n", gr->testcase + 1,
+				   gr->result);
+
+		list_for_each_entry(tr, &gr->tr_lst, link) {
+			seq_printf(sf, "test=%d result=%d count=%u sectors=%u time_ns=%lld rate=%u iops=%u.%02u",
+				   gr->testcase + 1, gr->result, tr->count,
+				   tr->sectors, timespec64_to_ns(&tr->ts),
+				   tr->rate, tr->iops / 100, tr->iops % 100);
+			if (tr->qd)
+				seq_printf(sf, " qd=%u lat_p50_us=%u lat_p90_us=%u lat_p99_us=%u lat_p999_us=%u lat_max_us=%u",
+					   tr->qd, tr->lat[0], tr->lat[1],
+					   tr->lat[2], tr->lat[3], tr->lat[4]);
+			seq_putc(sf, '\n');
+		}
+	}
+
+	mutex_unlock(&mmc_test_lock);
+
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(mtf_results);
+
 static int mtf_testlist_show(struct seq_file *sf, void *data)
 {
 	int i;
@@ -3211,6 +3533,11 @@ static int mmc_test_register_dbgfs_file(struct mmc_card *card)
 	if (ret)
 		goto err;
 
+	ret = __mmc_test_register_dbgfs_file(card, "results", S_IRUGO,
+		&mtf_results_fops);
+	if (ret)
+		goto err;
+
 err:
 	mutex_unlock(&mmc_test_lock);
 
@@ -1113,7 +1113,7 @@ static int mmc_sdio_resume(struct mmc_host *host)
 		if (!(host->caps2 & MMC_CAP2_SDIO_IRQ_NOTHREAD))
 			wake_up_process(host->sdio_irq_thread);
 		else if (host->caps & MMC_CAP_SDIO_IRQ)
-			schedule_work(&host->sdio_irq_work);
+			sdio_queue_irq_work(host);
 	}
 
 out:
@@ -110,11 +110,35 @@ static int process_sdio_pending_irqs(struct mmc_host *host)
 	return ret;
 }
 
+/*
+ * Under load a card interrupt tends to be followed closely by the next
+ * one. With sdio_irq_poll_us set, keep reading CCCR_INTx while that
+ * finds work, for at most that long, before going back to waiting for
+ * the interrupt. That saves a wakeup per interrupt while busy.
+ */
+static int sdio_poll_pending_irqs(struct mmc_host *host, int ret)
+{
+	ktime_t timeout;
+
+	if (!host->sdio_irq_poll_us || ret <= 0)
+		return ret;
+
+	timeout = ktime_add_us(ktime_get(), host->sdio_irq_poll_us);
+	do {
+		ret = process_sdio_pending_irqs(host);
+	} while (ret > 0 && ktime_before(ktime_get(), timeout));
+
+	return ret;
+}
+
 static void sdio_run_irqs(struct mmc_host *host)
 {
+	int ret;
+
 	mmc_claim_host(host);
 	if (host->sdio_irqs) {
-		process_sdio_pending_irqs(host);
+		ret = process_sdio_pending_irqs(host);
+		sdio_poll_pending_irqs(host, ret);
 		if (!host->sdio_irq_pending)
 			host->ops->ack_sdio_irq(host);
 	}
@@ -129,10 +153,16 @@ void sdio_irq_work(struct work_struct *work)
 	sdio_run_irqs(host);
 }
 
+void sdio_queue_irq_work(struct mmc_host *host)
+{
+	queue_work_on(host->sdio_irq_cpu, system_highpri_wq,
+		      &host->sdio_irq_work);
+}
+
 void sdio_signal_irq(struct mmc_host *host)
 {
 	host->sdio_irq_pending = true;
-	schedule_work(&host->sdio_irq_work);
+	sdio_queue_irq_work(host);
 }
 EXPORT_SYMBOL_GPL(sdio_signal_irq);
 
@@ -176,6 +206,8 @@ static int sdio_irq_thread(void *_host)
 		if (ret)
 			break;
 		ret = process_sdio_pending_irqs(host);
+		if (host->caps & MMC_CAP_SDIO_IRQ)
+			ret = sdio_poll_pending_irqs(host, ret);
 		mmc_release_host(host);
 
 		/*
@@ -238,6 +270,9 @@ static int sdio_card_irq_get(struct mmc_card *card)
 				host->sdio_irqs--;
 				return err;
 			}
+			if (host->sdio_irq_cpu != WORK_CPU_UNBOUND)
+				set_cpus_allowed_ptr(host->sdio_irq_thread,
+						cpumask_of(host->sdio_irq_cpu));
 		} else if (host->caps & MMC_CAP_SDIO_IRQ) {
 			host->ops->enable_sdio_irq(host, 1);
 		}
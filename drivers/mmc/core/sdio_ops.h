@@ -22,6 +22,7 @@ int mmc_io_rw_extended(struct mmc_card *card, int write, unsigned fn,
 	unsigned addr, int incr_addr, u8 *buf, unsigned blocks, unsigned blksz);
 int sdio_reset(struct mmc_host *host);
 void sdio_irq_work(struct work_struct *work);
+void sdio_queue_irq_work(struct mmc_host *host);
 
 static inline bool sdio_is_io_busy(u32 opcode, u32 arg)
 {
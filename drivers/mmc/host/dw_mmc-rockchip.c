@@ -3,9 +3,11 @@
  * Copyright (c) 2014, Fuzhou Rockchip Electronics Co., Ltd
  */
 
+#include <linux/bitmap.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/clk.h>
+#include <linux/mmc/card.h>
 #include <linux/mmc/host.h>
 #include <linux/of_address.h>
 #include <linux/mmc/slot-gpio.h>
@@ -26,6 +28,12 @@ struct dw_mci_rockchip_priv_data {
 	int			default_sample_phase;
 	int			num_phases;
 	int			vqmmc_off_uV;
+	/* Last tuning result, reused while card, timing and clock match */
+	int			tuned_phase;
+	unsigned int		tuned_clock;
+	unsigned char		tuned_timing;
+	bool			tuned_cid_valid;
+	u32			tuned_cid[4];
 };
 
 static void dw_mci_rk3288_set_ios(struct dw_mci *host, struct mmc_ios *ios)
@@ -145,129 +153,193 @@ static void dw_mci_rk3288_set_ios(struct dw_mci *host, struct mmc_ios *ios)
 #define TUNING_ITERATION_TO_PHASE(i, num_phases) \
 		(DIV_ROUND_UP((i) * 360, num_phases))
 
+/* Sample one tuning block at iteration @i, wrapping around the circle */
+static bool dw_mci_rk3288_try_phase(struct dw_mci_rockchip_priv_data *priv,
+				    struct mmc_host *mmc, u32 opcode, int i)
+{
+	clk_set_phase(priv->sample_clk,
+		      TUNING_ITERATION_TO_PHASE(i % priv->num_phases,
+						priv->num_phases));
+
+	return !mmc_send_tuning(mmc, opcode, NULL);
+}
+
+/*
+ * If the card, timing and clock are the ones we tuned for last time, a
+ * single tuning block at the cached phase is enough to tell whether it
+ * still works.  This makes re-tuning after (runtime) resume cheap.
+ */
+static bool dw_mci_rk3288_tuning_cached(struct dw_mci *host,
+					struct mmc_host *mmc, u32 opcode)
+{
+	struct dw_mci_rockchip_priv_data *priv = host->priv;
+	struct mmc_card *card = mmc->card;
+
+	if (priv->tuned_phase < 0 || !card)
+		return false;
+
+	if (mmc->ios.timing != priv->tuned_timing ||
+	    mmc->ios.clock != priv->tuned_clock)
+		return false;
+
+	if (priv->tuned_cid_valid &&
+	    memcmp(priv->tuned_cid, card->raw_cid, sizeof(priv->tuned_cid)))
+		return false;
+
+	clk_set_phase(priv->sample_clk, priv->tuned_phase);
+	if (mmc_send_tuning(mmc, opcode, NULL))
+		return false;
+
+	/*
+	 * The first tuning happens while the card is being enumerated and
+	 * mmc->card is not set yet, remember its CID once we know it.
+	 */
+	memcpy(priv->tuned_cid, card->raw_cid, sizeof(priv->tuned_cid));
+	priv->tuned_cid_valid = true;
+
+	dev_dbg(host->dev, "Reusing tuned phase %d\n", priv->tuned_phase);
+
+	return true;
+}
+
+static void dw_mci_rk3288_tuning_save(struct dw_mci_rockchip_priv_data *priv,
+				      struct mmc_host *mmc, int phase)
+{
+	priv->tuned_phase = phase;
+	priv->tuned_timing = mmc->ios.timing;
+	priv->tuned_clock = mmc->ios.clock;
+	priv->tuned_cid_valid = !!mmc->card;
+	if (mmc->card)
+		memcpy(priv->tuned_cid, mmc->card->raw_cid,
+		       sizeof(priv->tuned_cid));
+}
+
 static int dw_mci_rk3288_execute_tuning(struct dw_mci_slot *slot, u32 opcode)
 {
 	struct dw_mci *host = slot->host;
 	struct dw_mci_rockchip_priv_data *priv = host->priv;
 	struct mmc_host *mmc = slot->mmc;
-	int ret = 0;
-	int i;
-	bool v, prev_v = 0, first_v;
-	struct range_t {
-		int start;
-		int end; /* inclusive */
-	};
-	struct range_t *ranges;
-	unsigned int range_count = 0;
-	int longest_range_len = -1;
-	int longest_range = -1;
+	int num_phases = priv->num_phases;
+	int step, num_coarse, good_count = 0;
+	int run_start = 0, run_len = 0, best_start = 0, best_len = 0;
+	int first_bad, lo, hi, mid, span, start, end, len;
 	int middle_phase;
+	unsigned long *good;
+	int ret = 0;
+	int i, k;
 
 	if (IS_ERR(priv->sample_clk)) {
 		dev_err(host->dev, "Tuning clock (sample_clk) not defined.\n");
 		return -EIO;
 	}
 
-	ranges = kmalloc_array(priv->num_phases / 2 + 1,
-			       sizeof(*ranges), GFP_KERNEL);
-	if (!ranges)
-		return -ENOMEM;
-
-	/* Try each phase and extract good ranges */
-	for (i = 0; i < priv->num_phases; ) {
-		clk_set_phase(priv->sample_clk,
-			      TUNING_ITERATION_TO_PHASE(i, priv->num_phases));
+	if (dw_mci_rk3288_tuning_cached(host, mmc, opcode))
+		return 0;
 
-		v = !mmc_send_tuning(mmc, opcode, NULL);
+	priv->tuned_phase = -1;
 
-		if (i == 0)
-			first_v = v;
+	/*
+	 * Coarse pass: one tuning block every 20 degrees, which is still
+	 * narrower than any usable window.
+	 */
+	step = DIV_ROUND_UP(20 * num_phases, 360);
+	num_coarse = DIV_ROUND_UP(num_phases, step);
 
-		if ((!prev_v) && v) {
-			range_count++;
-			ranges[range_count-1].start = i;
-		}
-		if (v) {
-			ranges[range_count-1].end = i;
-			i++;
-		} else if (i == priv->num_phases - 1) {
-			/* No extra skipping rules if we're at the end */
-			i++;
-		} else {
-			/*
-			 * No need to check too close to an invalid
-			 * one since testing bad phases is slow.  Skip
-			 * 20 degrees.
-			 */
-			i += DIV_ROUND_UP(20 * priv->num_phases, 360);
+	good = bitmap_zalloc(num_coarse, GFP_KERNEL);
+	if (!good)
+		return -ENOMEM;
 
-			/* Always test the last one */
-			if (i >= priv->num_phases)
-				i = priv->num_phases - 1;
+	for (k = 0; k < num_coarse; k++) {
+		if (dw_mci_rk3288_try_phase(priv, mmc, opcode, k * step)) {
+			__set_bit(k, good);
+			good_count++;
 		}
-
-		prev_v = v;
 	}
 
-	if (range_count == 0) {
+	if (good_count == 0) {
 		dev_warn(host->dev, "All phases bad!");
 		ret = -EIO;
 		goto free;
 	}
 
-	/* wrap around case, merge the end points */
-	if ((range_count > 1) && first_v && v) {
-		ranges[0].start = ranges[range_count-1].start;
-		range_count--;
-	}
-
-	if (ranges[0].start == 0 && ranges[0].end == priv->num_phases - 1) {
+	if (good_count == num_coarse) {
 		clk_set_phase(priv->sample_clk, priv->default_sample_phase);
 		dev_info(host->dev, "All phases work, using default phase %d.",
 			 priv->default_sample_phase);
+		dw_mci_rk3288_tuning_save(priv, mmc,
+					  priv->default_sample_phase);
 		goto free;
 	}
 
-	/* Find the longest range */
-	for (i = 0; i < range_count; i++) {
-		int len = (ranges[i].end - ranges[i].start + 1);
+	/*
+	 * Find the longest run of good coarse points.  Starting right after
+	 * a bad one takes care of a run wrapping around 360 degrees.
+	 */
+	first_bad = find_first_zero_bit(good, num_coarse);
+	for (i = 1; i <= num_coarse; i++) {
+		k = (first_bad + i) % num_coarse;
 
-		if (len < 0)
-			len += priv->num_phases;
+		if (!test_bit(k, good)) {
+			run_len = 0;
+			continue;
+		}
 
-		if (longest_range_len < len) {
-			longest_range_len = len;
-			longest_range = i;
+		if (!run_len)
+			run_start = k;
+		if (++run_len > best_len) {
+			best_len = run_len;
+			best_start = run_start;
 		}
+	}
 
-		dev_dbg(host->dev, "Good phase range %d-%d (%d len)\n",
-			TUNING_ITERATION_TO_PHASE(ranges[i].start,
-						  priv->num_phases),
-			TUNING_ITERATION_TO_PHASE(ranges[i].end,
-						  priv->num_phases),
-			len
-		);
+	/*
+	 * Fine pass: bisect the edges of that run between its outermost
+	 * good coarse points and the bad ones next to them.  The last gap
+	 * before wrapping around may be shorter than a full step.
+	 */
+	k = (best_start + num_coarse - 1) % num_coarse;
+	span = min(step, num_phases - k * step);
+	lo = 0;
+	hi = span;
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (dw_mci_rk3288_try_phase(priv, mmc, opcode, k * step + mid))
+			hi = mid;
+		else
+			lo = mid;
+	}
+	start = (k * step + hi) % num_phases;
+
+	k = (best_start + best_len - 1) % num_coarse;
+	span = min(step, num_phases - k * step);
+	lo = 0;
+	hi = span;
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (dw_mci_rk3288_try_phase(priv, mmc, opcode, k * step + mid))
+			lo = mid;
+		else
+			hi = mid;
 	}
+	end = (k * step + lo) % num_phases;
+
+	len = (end - start + num_phases) % num_phases + 1;
 
 	dev_dbg(host->dev, "Best phase range %d-%d (%d len)\n",
-		TUNING_ITERATION_TO_PHASE(ranges[longest_range].start,
-					  priv->num_phases),
-		TUNING_ITERATION_TO_PHASE(ranges[longest_range].end,
-					  priv->num_phases),
-		longest_range_len
+		TUNING_ITERATION_TO_PHASE(start, num_phases),
+		TUNING_ITERATION_TO_PHASE(end, num_phases),
+		len
 	);
 
-	middle_phase = ranges[longest_range].start + longest_range_len / 2;
-	middle_phase %= priv->num_phases;
-	dev_info(host->dev, "Successfully tuned phase to %d\n",
-		 TUNING_ITERATION_TO_PHASE(middle_phase, priv->num_phases));
+	middle_phase = (start + len / 2) % num_phases;
+	middle_phase = TUNING_ITERATION_TO_PHASE(middle_phase, num_phases);
+	dev_info(host->dev, "Successfully tuned phase to %d\n", middle_phase);
 
-	clk_set_phase(priv->sample_clk,
-		      TUNING_ITERATION_TO_PHASE(middle_phase,
-						priv->num_phases));
+	clk_set_phase(priv->sample_clk, middle_phase);
+	dw_mci_rk3288_tuning_save(priv, mmc, middle_phase);
 
 free:
-	kfree(ranges);
+	bitmap_free(good);
 	return ret;
 }
 
@@ -288,6 +360,8 @@ static int dw_mci_rk3288_parse_dt(struct dw_mci *host)
 					&priv->default_sample_phase))
 		priv->default_sample_phase = 0;
 
+	priv->tuned_phase = -1;
+
 	priv->drv_clk = devm_clk_get(host->dev, "ciu-drive");
 	if (IS_ERR(priv->drv_clk))
 		dev_dbg(host->dev, "ciu-drive not available\n");
@@ -61,6 +61,11 @@
 				 SDMMC_IDMAC_INT_TI)
 
 #define DESC_RING_BUF_SZ	PAGE_SIZE
+/*
+ * One descriptor ring per desc_data slot: while the IDMAC walks one of
+ * them, pre_req builds the chain of the next request in the other.
+ */
+#define DESC_RING_NR_BUFS(host)	ARRAY_SIZE((host)->desc_data)
 
 struct idmac_desc_64addr {
 	u32		des0;	/* Control Descriptor */
@@ -499,8 +504,19 @@ static void dw_mci_dmac_complete_dma(void *arg)
 	}
 }
 
-static int dw_mci_idmac_init(struct dw_mci *host)
+static void *dw_mci_idmac_ring(struct dw_mci *host, unsigned int ring)
+{
+	return host->sg_cpu + ring * DESC_RING_BUF_SZ;
+}
+
+static dma_addr_t dw_mci_idmac_ring_dma(struct dw_mci *host, unsigned int ring)
+{
+	return host->sg_dma + ring * DESC_RING_BUF_SZ;
+}
+
+static void dw_mci_idmac_init_ring(struct dw_mci *host, unsigned int ring)
 {
+	dma_addr_t ring_dma = dw_mci_idmac_ring_dma(host, ring);
 	int i;
 
 	if (host->dma_64bit_address == 1) {
@@ -510,13 +526,13 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 			DESC_RING_BUF_SZ / sizeof(struct idmac_desc_64addr);
 
 		/* Forward link the descriptor list */
-		for (i = 0, p = host->sg_cpu; i < host->ring_size - 1;
-								i++, p++) {
-			p->des6 = (host->sg_dma +
+		for (i = 0, p = dw_mci_idmac_ring(host, ring);
+		     i < host->ring_size - 1; i++, p++) {
+			p->des6 = (ring_dma +
 					(sizeof(struct idmac_desc_64addr) *
 							(i + 1))) & 0xffffffff;
 
-			p->des7 = (u64)(host->sg_dma +
+			p->des7 = (u64)(ring_dma +
 					(sizeof(struct idmac_desc_64addr) *
 							(i + 1))) >> 32;
 			/* Initialize reserved and buffer size fields to "0" */
@@ -527,8 +543,8 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 		}
 
 		/* Set the last descriptor as the end-of-ring descriptor */
-		p->des6 = host->sg_dma & 0xffffffff;
-		p->des7 = (u64)host->sg_dma >> 32;
+		p->des6 = ring_dma & 0xffffffff;
+		p->des7 = (u64)ring_dma >> 32;
 		p->des0 = IDMAC_DES0_ER;
 
 	} else {
@@ -538,20 +554,45 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 			DESC_RING_BUF_SZ / sizeof(struct idmac_desc);
 
 		/* Forward link the descriptor list */
-		for (i = 0, p = host->sg_cpu;
+		for (i = 0, p = dw_mci_idmac_ring(host, ring);
 		     i < host->ring_size - 1;
 		     i++, p++) {
-			p->des3 = cpu_to_le32(host->sg_dma +
+			p->des3 = cpu_to_le32(ring_dma +
 					(sizeof(struct idmac_desc) * (i + 1)));
 			p->des0 = 0;
 			p->des1 = 0;
 		}
 
 		/* Set the last descriptor as the end-of-ring descriptor */
-		p->des3 = cpu_to_le32(host->sg_dma);
+		p->des3 = cpu_to_le32(ring_dma);
 		p->des0 = cpu_to_le32(IDMAC_DES0_ER);
 	}
 
+	host->desc_data[ring] = NULL;
+}
+
+static void dw_mci_idmac_set_ring(struct dw_mci *host, unsigned int ring)
+{
+	dma_addr_t ring_dma = dw_mci_idmac_ring_dma(host, ring);
+
+	/* Set the descriptor base address */
+	if (host->dma_64bit_address == 1) {
+		mci_writel(host, DBADDRL, ring_dma & 0xffffffff);
+		mci_writel(host, DBADDRU, (u64)ring_dma >> 32);
+	} else {
+		mci_writel(host, DBADDR, ring_dma);
+	}
+
+	host->desc_ring = ring;
+}
+
+static int dw_mci_idmac_init(struct dw_mci *host)
+{
+	unsigned int ring;
+
+	for (ring = 0; ring < DESC_RING_NR_BUFS(host); ring++)
+		dw_mci_idmac_init_ring(host, ring);
+
 	dw_mci_idmac_reset(host);
 
 	if (host->dma_64bit_address == 1) {
@@ -559,34 +600,29 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 		mci_writel(host, IDSTS64, IDMAC_INT_CLR);
 		mci_writel(host, IDINTEN64, SDMMC_IDMAC_INT_NI |
 				SDMMC_IDMAC_INT_RI | SDMMC_IDMAC_INT_TI);
-
-		/* Set the descriptor base address */
-		mci_writel(host, DBADDRL, host->sg_dma & 0xffffffff);
-		mci_writel(host, DBADDRU, (u64)host->sg_dma >> 32);
-
 	} else {
 		/* Mask out interrupts - get Tx & Rx complete only */
 		mci_writel(host, IDSTS, IDMAC_INT_CLR);
 		mci_writel(host, IDINTEN, SDMMC_IDMAC_INT_NI |
 				SDMMC_IDMAC_INT_RI | SDMMC_IDMAC_INT_TI);
-
-		/* Set the descriptor base address */
-		mci_writel(host, DBADDR, host->sg_dma);
 	}
 
+	dw_mci_idmac_set_ring(host, 0);
+
 	return 0;
 }
 
 static inline int dw_mci_prepare_desc64(struct dw_mci *host,
 					 struct mmc_data *data,
-					 unsigned int sg_len)
+					 unsigned int sg_len,
+					 unsigned int ring, bool wait)
 {
 	unsigned int desc_len;
 	struct idmac_desc_64addr *desc_first, *desc_last, *desc;
 	u32 val;
 	int i;
 
-	desc_first = desc_last = desc = host->sg_cpu;
+	desc_first = desc_last = desc = dw_mci_idmac_ring(host, ring);
 
 	for (i = 0; i < sg_len; i++) {
 		unsigned int length = sg_dma_len(&data->sg[i]);
@@ -605,10 +641,14 @@ static inline int dw_mci_prepare_desc64(struct dw_mci *host,
 			 * isn't still owned by IDMAC as IDMAC's write
 			 * ops and CPU's read ops are asynchronous.
 			 */
-			if (readl_poll_timeout_atomic(&desc->des0, val,
+			if (!wait) {
+				if (readl(&desc->des0) & IDMAC_DES0_OWN)
+					goto err_own_bit;
+			} else if (readl_poll_timeout_atomic(&desc->des0, val,
 						!(val & IDMAC_DES0_OWN),
-						10, 100 * USEC_PER_MSEC))
+						10, 100 * USEC_PER_MSEC)) {
 				goto err_own_bit;
+			}
 
 			/*
 			 * Set the OWN bit and disable interrupts
@@ -643,22 +683,23 @@ static inline int dw_mci_prepare_desc64(struct dw_mci *host,
 err_own_bit:
 	/* restore the descriptor chain as it's polluted */
 	dev_dbg(host->dev, "descriptor is still owned by IDMAC.\n");
-	memset(host->sg_cpu, 0, DESC_RING_BUF_SZ);
-	dw_mci_idmac_init(host);
+	memset(dw_mci_idmac_ring(host, ring), 0, DESC_RING_BUF_SZ);
+	dw_mci_idmac_init_ring(host, ring);
 	return -EINVAL;
 }
 
 
 static inline int dw_mci_prepare_desc32(struct dw_mci *host,
 					 struct mmc_data *data,
-					 unsigned int sg_len)
+					 unsigned int sg_len,
+					 unsigned int ring, bool wait)
 {
 	unsigned int desc_len;
 	struct idmac_desc *desc_first, *desc_last, *desc;
 	u32 val;
 	int i;
 
-	desc_first = desc_last = desc = host->sg_cpu;
+	desc_first = desc_last = desc = dw_mci_idmac_ring(host, ring);
 
 	for (i = 0; i < sg_len; i++) {
 		unsigned int length = sg_dma_len(&data->sg[i]);
@@ -677,11 +718,15 @@ static inline int dw_mci_prepare_desc32(struct dw_mci *host,
 			 * isn't still owned by IDMAC as IDMAC's write
 			 * ops and CPU's read ops are asynchronous.
 			 */
-			if (readl_poll_timeout_atomic(&desc->des0, val,
+			if (!wait) {
+				if (!IDMAC_OWN_CLR64(readl(&desc->des0)))
+					goto err_own_bit;
+			} else if (readl_poll_timeout_atomic(&desc->des0, val,
 						      IDMAC_OWN_CLR64(val),
 						      10,
-						      100 * USEC_PER_MSEC))
+						      100 * USEC_PER_MSEC)) {
 				goto err_own_bit;
+			}
 
 			/*
 			 * Set the OWN bit and disable interrupts
@@ -717,23 +762,60 @@ static inline int dw_mci_prepare_desc32(struct dw_mci *host,
 err_own_bit:
 	/* restore the descriptor chain as it's polluted */
 	dev_dbg(host->dev, "descriptor is still owned by IDMAC.\n");
-	memset(host->sg_cpu, 0, DESC_RING_BUF_SZ);
-	dw_mci_idmac_init(host);
+	memset(dw_mci_idmac_ring(host, ring), 0, DESC_RING_BUF_SZ);
+	dw_mci_idmac_init_ring(host, ring);
 	return -EINVAL;
 }
 
-static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
+/*
+ * Only wait for the IDMAC to release the descriptors when @wait is set:
+ * pre_req runs under the host lock just to get ahead of the next start,
+ * so it gives up instead and leaves the chain to be built at start.
+ */
+static int dw_mci_idmac_prepare_ring(struct dw_mci *host,
+				     struct mmc_data *data,
+				     unsigned int sg_len, unsigned int ring,
+				     bool wait)
 {
-	u32 temp;
 	int ret;
 
+	/* Drop a chain pre-built for a request that never got started */
+	if (host->desc_data[ring])
+		dw_mci_idmac_init_ring(host, ring);
+
 	if (host->dma_64bit_address == 1)
-		ret = dw_mci_prepare_desc64(host, host->data, sg_len);
+		ret = dw_mci_prepare_desc64(host, data, sg_len, ring, wait);
 	else
-		ret = dw_mci_prepare_desc32(host, host->data, sg_len);
+		ret = dw_mci_prepare_desc32(host, data, sg_len, ring, wait);
 
-	if (ret)
-		goto out;
+	if (!ret)
+		host->desc_data[ring] = data;
+
+	return ret;
+}
+
+static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
+{
+	struct mmc_data *data = host->data;
+	unsigned int ring;
+	u32 temp;
+	int ret = 0;
+
+	/* Use the chain pre_req built for this request, if any */
+	for (ring = 0; ring < DESC_RING_NR_BUFS(host); ring++)
+		if (host->desc_data[ring] == data)
+			break;
+
+	if (ring == DESC_RING_NR_BUFS(host)) {
+		ring = (host->desc_ring + 1) % DESC_RING_NR_BUFS(host);
+		ret = dw_mci_idmac_prepare_ring(host, data, sg_len, ring,
+						true);
+		if (ret)
+			goto out;
+	}
+
+	/* The IDMAC owns this ring now, it's no longer a pre-built one */
+	host->desc_data[ring] = NULL;
 
 	/* drain writebuffer */
 	wmb();
@@ -741,6 +823,7 @@ static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
 	/* Make sure to reset DMA in case we did PIO before this */
 	dw_mci_ctrl_reset(host, SDMMC_CTRL_DMA_RESET);
 	dw_mci_idmac_reset(host);
+	dw_mci_idmac_set_ring(host, ring);
 
 	/* Select IDMAC interface */
 	temp = mci_readl(host, CTRL);
@@ -916,17 +999,34 @@ static void dw_mci_pre_req(struct mmc_host *mmc,
 			   struct mmc_request *mrq)
 {
 	struct dw_mci_slot *slot = mmc_priv(mmc);
+	struct dw_mci *host = slot->host;
 	struct mmc_data *data = mrq->data;
+	unsigned int ring;
+	int sg_len;
 
-	if (!slot->host->use_dma || !data)
+	if (!host->use_dma || !data)
 		return;
 
 	/* This data might be unmapped at this time */
 	data->host_cookie = COOKIE_UNMAPPED;
 
-	if (dw_mci_pre_dma_transfer(slot->host, mrq->data,
-				COOKIE_PRE_MAPPED) < 0)
+	sg_len = dw_mci_pre_dma_transfer(host, mrq->data, COOKIE_PRE_MAPPED);
+	if (sg_len < 0) {
 		data->host_cookie = COOKIE_UNMAPPED;
+		return;
+	}
+
+	if (host->use_dma != TRANS_MODE_IDMAC)
+		return;
+
+	/*
+	 * Build the descriptor chain in the ring the IDMAC is not walking,
+	 * so starting this request only takes the doorbell write.
+	 */
+	spin_lock_bh(&host->lock);
+	ring = (host->desc_ring + 1) % DESC_RING_NR_BUFS(host);
+	dw_mci_idmac_prepare_ring(host, data, sg_len, ring, false);
+	spin_unlock_bh(&host->lock);
 }
 
 static void dw_mci_post_req(struct mmc_host *mmc,
@@ -945,6 +1045,17 @@ static void dw_mci_post_req(struct mmc_host *mmc,
 			     data->sg_len,
 			     mmc_get_dma_dir(data));
 	data->host_cookie = COOKIE_UNMAPPED;
+
+	if (slot->host->use_dma == TRANS_MODE_IDMAC) {
+		unsigned int ring;
+
+		/* Don't match a later request allocated at the same address */
+		spin_lock_bh(&slot->host->lock);
+		for (ring = 0; ring < DESC_RING_NR_BUFS(slot->host); ring++)
+			if (slot->host->desc_data[ring] == data)
+				dw_mci_idmac_init_ring(slot->host, ring);
+		spin_unlock_bh(&slot->host->lock);
+	}
 }
 
 static int dw_mci_get_cd(struct mmc_host *mmc)
@@ -3049,7 +3160,8 @@ static void dw_mci_init_dma(struct dw_mci *host)
 
 		/* Alloc memory for sg translation */
 		host->sg_cpu = dmam_alloc_coherent(host->dev,
-						   DESC_RING_BUF_SZ,
+						   DESC_RING_BUF_SZ *
+						   DESC_RING_NR_BUFS(host),
 						   &host->sg_dma, GFP_KERNEL);
 		if (!host->sg_cpu) {
 			dev_err(host->dev,
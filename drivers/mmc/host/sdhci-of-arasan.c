@@ -166,6 +166,11 @@ struct sdhci_arasan_data {
  * 19MHz instead
  */
 #define SDHCI_ARASAN_QUIRK_CLOCK_25_BROKEN BIT(2)
+/*
+ * The PHY DLL has to be locked before the command queue engine takes over,
+ * which the PHY doesn't guarantee when it was powered with the clock off.
+ */
+#define SDHCI_ARASAN_QUIRK_CQE_DLL_LOCK	BIT(3)
 };
 
 struct sdhci_arasan_of_data {
@@ -440,7 +445,20 @@ static void sdhci_arasan_cqe_enable(struct mmc_host *mmc)
 	sdhci_cqe_enable(mmc);
 }
 
+static void sdhci_arasan_cqe_pre_enable(struct mmc_host *mmc)
+{
+	struct sdhci_host *host = mmc_priv(mmc);
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_arasan_data *sdhci_arasan = sdhci_pltfm_priv(pltfm_host);
+
+	if ((sdhci_arasan->quirks & SDHCI_ARASAN_QUIRK_CQE_DLL_LOCK) &&
+	    sdhci_arasan->is_phy_on && phy_calibrate(sdhci_arasan->phy))
+		pr_warn("%s: PHY DLL not locked, CQE transfers may fail\n",
+			mmc_hostname(mmc));
+}
+
 static const struct cqhci_host_ops sdhci_arasan_cqhci_ops = {
+	.pre_enable     = sdhci_arasan_cqe_pre_enable,
 	.enable         = sdhci_arasan_cqe_enable,
 	.disable        = sdhci_cqe_disable,
 	.dumpregs       = sdhci_arasan_dumpregs,
@@ -1651,8 +1669,10 @@ static int sdhci_arasan_probe(struct platform_device *pdev)
 
 	pltfm_host->clk = clk_xin;
 
-	if (of_device_is_compatible(np, "rockchip,rk3399-sdhci-5.1"))
+	if (of_device_is_compatible(np, "rockchip,rk3399-sdhci-5.1")) {
 		sdhci_arasan_update_clockmultiplier(host, 0x0);
+		sdhci_arasan->quirks |= SDHCI_ARASAN_QUIRK_CQE_DLL_LOCK;
+	}
 
 	if (of_device_is_compatible(np, "intel,keembay-sdhci-5.1-emmc") ||
 	    of_device_is_compatible(np, "intel,keembay-sdhci-5.1-sd") ||
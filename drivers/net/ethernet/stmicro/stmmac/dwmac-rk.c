@@ -18,6 +18,8 @@
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
 #include <linux/regulator/consumer.h>
+#include <linux/interrupt.h>
+#include <linux/sched/topology.h>
 #include <linux/delay.h>
 #include <linux/mfd/syscon.h>
 #include <linux/regmap.h>
@@ -35,6 +37,7 @@ struct rk_gmac_ops {
 	void (*set_clock_selection)(struct rk_priv_data *bsp_priv, bool input,
 				    bool enable);
 	void (*integrated_phy_powerup)(struct rk_priv_data *bsp_priv);
+	bool tso;
 	bool regs_valid;
 	u32 regs[];
 };
@@ -81,6 +84,9 @@ struct rk_priv_data {
 
 	struct regmap *grf;
 	struct regmap *php_grf;
+
+	int irq;
+	struct cpumask irq_affinity;
 };
 
 #define HIWORD_UPDATE(val, mask, shift) \
@@ -1110,6 +1116,7 @@ static const struct rk_gmac_ops rk3568_ops = {
 	.set_to_rmii = rk3568_set_to_rmii,
 	.set_rgmii_speed = rk3568_set_gmac_speed,
 	.set_rmii_speed = rk3568_set_gmac_speed,
+	.tso = true,
 	.regs_valid = true,
 	.regs = {
 		0xfe2a0000, /* gmac0 */
@@ -1257,6 +1264,7 @@ static const struct rk_gmac_ops rk3588_ops = {
 	.set_rgmii_speed = rk3588_set_gmac_speed,
 	.set_rmii_speed = rk3588_set_gmac_speed,
 	.set_clock_selection = rk3588_set_clock_selection,
+	.tso = true,
 	.regs_valid = true,
 	.regs = {
 		0xfe1b0000, /* gmac0 */
@@ -1441,6 +1449,7 @@ static const struct rk_gmac_ops rv1126_ops = {
 	.set_to_rmii = rv1126_set_to_rmii,
 	.set_rgmii_speed = rv1126_set_rgmii_speed,
 	.set_rmii_speed = rv1126_set_rmii_speed,
+	.tso = true,
 };
 
 #define RK_GRF_MACPHY_CON0		0xb00
@@ -1803,6 +1812,67 @@ static void rk_fix_speed(void *priv, unsigned int speed)
 	}
 }
 
+/*
+ * All DMA channels of the Rockchip GMACs share the "macirq" line, so RX
+ * processing runs wherever that interrupt lands. Unless the DT already
+ * pins it with handle_cpu_id, hint it towards the CPUs with the highest
+ * capacity (the Cortex-A72 cluster on RK3399), since a single NAPI
+ * context saturates a little core at gigabit rates.
+ */
+static void rk_gmac_set_irq_affinity(struct rk_priv_data *bsp_priv, int irq)
+{
+	struct device *dev = &bsp_priv->pdev->dev;
+	unsigned long cap, max_cap = 0;
+	int cpu;
+
+	if (of_find_property(dev->of_node, "handle_cpu_id", NULL))
+		return;
+
+	for_each_online_cpu(cpu) {
+		cap = arch_scale_cpu_capacity(cpu);
+		if (cap > max_cap) {
+			max_cap = cap;
+			cpumask_clear(&bsp_priv->irq_affinity);
+		}
+		if (cap == max_cap)
+			cpumask_set_cpu(cpu, &bsp_priv->irq_affinity);
+	}
+
+	/* Nothing to prefer on symmetric systems */
+	if (cpumask_weight(&bsp_priv->irq_affinity) == num_online_cpus())
+		return;
+
+	if (irq_set_affinity_and_hint(irq, &bsp_priv->irq_affinity))
+		return;
+
+	bsp_priv->irq = irq;
+	dev_dbg(dev, "steering irq %d to cpus %*pbl\n", irq,
+		cpumask_pr_args(&bsp_priv->irq_affinity));
+}
+
+/*
+ * The Rockchip GMACs sit on a 64-bit AXI port, so one RX burst of the DMA
+ * moves (rx)pbl (x8) beats of 8 bytes worth of descriptors. Refill the RX
+ * ring, and in particular the AF_XDP zero-copy ring, a whole burst at a
+ * time so the DMA never fetches a burst it can only partially own.
+ */
+#define RK_GMAC_AXI_BEAT_BYTES		8
+#define RK_GMAC_RX_FILL_BATCH_MIN	16
+#define RK_GMAC_RX_FILL_BATCH_MAX	64
+
+static unsigned int rk_gmac_rx_fill_batch(struct stmmac_dma_cfg *dma_cfg)
+{
+	unsigned int beats;
+
+	beats = dma_cfg->rxpbl ?: dma_cfg->pbl;
+	if (dma_cfg->pblx8)
+		beats *= 8;
+
+	return clamp_t(unsigned int,
+		       beats * RK_GMAC_AXI_BEAT_BYTES / sizeof(struct dma_desc),
+		       RK_GMAC_RX_FILL_BATCH_MIN, RK_GMAC_RX_FILL_BATCH_MAX);
+}
+
 static int rk_gmac_probe(struct platform_device *pdev)
 {
 	struct plat_stmmacenet_data *plat_dat;
@@ -1831,6 +1901,35 @@ static int rk_gmac_probe(struct platform_device *pdev)
 		plat_dat->has_gmac = true;
 	plat_dat->fix_mac_speed = rk_fix_speed;
 
+	/*
+	 * The GMAC4 based cores all come with the TSO engine, there is no
+	 * need to repeat that in every board DT. A 64K send is split over
+	 * up to a few dozen descriptors, so give them the largest TX ring
+	 * unless a smaller one was asked for.
+	 */
+	if (data->tso) {
+		plat_dat->tso_en = true;
+		if (!plat_dat->dma_tx_size)
+			plat_dat->dma_tx_size = DMA_MAX_TX_SIZE;
+	}
+
+	/*
+	 * The GMAC4-based controllers can spread RX over the MTL queues the
+	 * DT configures (snps,mtl-rx-config). Let the MAC hash flows over
+	 * them when the core has RSS. Cores without RSS, and the single
+	 * channel GMAC of RK3399, ignore the flag.
+	 */
+	if (plat_dat->has_gmac4 && plat_dat->rx_queues_to_use > 1)
+		plat_dat->rss_en = 1;
+
+	plat_dat->rx_fill_batch = rk_gmac_rx_fill_batch(plat_dat->dma_cfg);
+
+	/*
+	 * A fixed RX watchdog is either too slow for small RPC traffic or too
+	 * eager for bulk transfers on the little cores, let net_dim pick it.
+	 */
+	plat_dat->rx_dim_en = true;
+
 	plat_dat->bsp_priv = rk_gmac_setup(pdev, plat_dat, data);
 	if (IS_ERR(plat_dat->bsp_priv)) {
 		ret = PTR_ERR(plat_dat->bsp_priv);
@@ -1849,6 +1948,8 @@ static int rk_gmac_probe(struct platform_device *pdev)
 	if (ret)
 		goto err_gmac_powerdown;
 
+	rk_gmac_set_irq_affinity(plat_dat->bsp_priv, stmmac_res.irq);
+
 	return 0;
 
 err_gmac_powerdown:
@@ -1862,7 +1963,12 @@ static int rk_gmac_probe(struct platform_device *pdev)
 static int rk_gmac_remove(struct platform_device *pdev)
 {
 	struct rk_priv_data *bsp_priv = get_stmmac_bsp_priv(&pdev->dev);
-	int ret = stmmac_dvr_remove(&pdev->dev);
+	int ret;
+
+	if (bsp_priv->irq)
+		irq_update_affinity_hint(bsp_priv->irq, NULL);
+
+	ret = stmmac_dvr_remove(&pdev->dev);
 
 	if (!pm_runtime_status_suspended(&pdev->dev))
 		rk_gmac_powerdown(bsp_priv);
@@ -1941,6 +2047,7 @@ static struct platform_driver rk_gmac_dwmac_driver = {
 	.remove = rk_gmac_remove,
 	.driver = {
 		.name           = "rk_gmac-dwmac",
+		.probe_type	= PROBE_PREFER_ASYNCHRONOUS,
 		.pm		= &rk_gmac_pm_ops,
 		.of_match_table = rk_gmac_dwmac_match,
 	},
@@ -296,6 +296,41 @@ static int dwmac4_wrback_get_rx_timestamp_status(void *desc, void *next_desc,
 	return 0;
 }
 
+static int dwmac4_get_rx_hwtstamp(void *desc, void *next_desc, u32 ats,
+				  u64 *ts)
+{
+	struct dma_desc *p = (struct dma_desc *)desc;
+	struct dma_desc *ctx = (struct dma_desc *)next_desc;
+	unsigned int rdes0, rdes1, rdes3;
+	int i;
+
+	rdes3 = le32_to_cpu(p->des3);
+	if (!(rdes3 & RDES3_RDES1_VALID) ||
+	    !(le32_to_cpu(p->des1) & RDES1_TIMESTAMP_AVAILABLE))
+		return -ENODATA;
+
+	/* The context descriptor may be written back a bit later */
+	for (i = 0; i < 10; i++) {
+		rdes3 = le32_to_cpu(READ_ONCE(ctx->des3));
+		if (!(rdes3 & RDES3_OWN) && (rdes3 & RDES3_CONTEXT_DESCRIPTOR))
+			break;
+	}
+	if (i == 10)
+		return -EBUSY;
+
+	dma_rmb();
+
+	rdes0 = le32_to_cpu(ctx->des0);
+	rdes1 = le32_to_cpu(ctx->des1);
+	if (rdes0 == 0xffffffff && rdes1 == 0xffffffff)
+		/* Corrupted value */
+		return -EINVAL;
+
+	*ts = rdes0 + rdes1 * 1000000000ULL;
+
+	return 0;
+}
+
 static void dwmac4_rd_init_rx_desc(struct dma_desc *p, int disable_rx_ic,
 				   int mode, int end, int bfsize)
 {
@@ -562,6 +597,7 @@ const struct stmmac_desc_ops dwmac4_desc_ops = {
 	.get_tx_timestamp_status = dwmac4_wrback_get_tx_timestamp_status,
 	.get_rx_timestamp_status = dwmac4_wrback_get_rx_timestamp_status,
 	.get_timestamp = dwmac4_get_timestamp,
+	.get_rx_hwtstamp = dwmac4_get_rx_hwtstamp,
 	.set_tx_ic = dwmac4_rd_set_tx_ic,
 	.prepare_tx_desc = dwmac4_rd_prepare_tx_desc,
 	.prepare_tso_tx_desc = dwmac4_rd_prepare_tso_tx_desc,
@@ -126,6 +126,34 @@ static int dwxgmac2_get_rx_timestamp_status(void *desc, void *next_desc,
 	return !ret;
 }
 
+static int dwxgmac2_get_rx_hwtstamp(void *desc, void *next_desc, u32 ats,
+				    u64 *ts)
+{
+	struct dma_desc *p = (struct dma_desc *)desc;
+	struct dma_desc *ctx = (struct dma_desc *)next_desc;
+	unsigned int rdes0, rdes1, rdes3;
+
+	if (!(le32_to_cpu(p->des3) & XGMAC_RDES3_CDA))
+		return -ENODATA;
+
+	rdes3 = le32_to_cpu(ctx->des3);
+
+	dma_rmb();
+
+	if ((rdes3 & XGMAC_RDES3_OWN) || !(rdes3 & XGMAC_RDES3_CTXT) ||
+	    (rdes3 & XGMAC_RDES3_TSD) || !(rdes3 & XGMAC_RDES3_TSA))
+		return -EINVAL;
+
+	rdes0 = le32_to_cpu(ctx->des0);
+	rdes1 = le32_to_cpu(ctx->des1);
+	if (rdes0 == 0xffffffff && rdes1 == 0xffffffff)
+		return -EINVAL;
+
+	*ts = rdes0 + rdes1 * 1000000000ULL;
+
+	return 0;
+}
+
 static void dwxgmac2_init_rx_desc(struct dma_desc *p, int disable_rx_ic,
 				  int mode, int end, int bfsize)
 {
@@ -354,6 +382,7 @@ const struct stmmac_desc_ops dwxgmac210_desc_ops = {
 	.get_tx_timestamp_status = dwxgmac2_get_tx_timestamp_status,
 	.get_rx_timestamp_status = dwxgmac2_get_rx_timestamp_status,
 	.get_timestamp = dwxgmac2_get_timestamp,
+	.get_rx_hwtstamp = dwxgmac2_get_rx_hwtstamp,
 	.set_tx_ic = dwxgmac2_set_tx_ic,
 	.prepare_tx_desc = dwxgmac2_prepare_tx_desc,
 	.prepare_tso_tx_desc = dwxgmac2_prepare_tso_tx_desc,
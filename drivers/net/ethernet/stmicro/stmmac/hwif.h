@@ -77,6 +77,8 @@ struct stmmac_desc_ops {
 	void (*get_timestamp)(void *desc, u32 ats, u64 *ts);
 	/* get rx timestamp status */
 	int (*get_rx_timestamp_status)(void *desc, void *next_desc, u32 ats);
+	/* get rx timestamp status and value in one go, 0 if valid */
+	int (*get_rx_hwtstamp)(void *desc, void *next_desc, u32 ats, u64 *ts);
 	/* Display ring */
 	void (*display_ring)(void *head, unsigned int size, bool rx,
 			     dma_addr_t dma_rx_phy, unsigned int desc_size);
@@ -136,6 +138,8 @@ struct stmmac_desc_ops {
 	stmmac_do_void_callback(__priv, desc, get_timestamp, __args)
 #define stmmac_get_rx_timestamp_status(__priv, __args...) \
 	stmmac_do_callback(__priv, desc, get_rx_timestamp_status, __args)
+#define stmmac_get_rx_hwtstamp_desc(__priv, __args...) \
+	stmmac_do_callback(__priv, desc, get_rx_hwtstamp, __args)
 #define stmmac_display_ring(__priv, __args...) \
 	stmmac_do_void_callback(__priv, desc, display_ring, __args)
 #define stmmac_set_mss(__priv, __args...) \
@@ -12,6 +12,7 @@
 #define STMMAC_RESOURCE_NAME   "stmmaceth"
 
 #include <linux/clk.h>
+#include <linux/dim.h>
 #include <linux/hrtimer.h>
 #include <linux/if_vlan.h>
 #include <linux/stmmac.h>
@@ -123,6 +124,11 @@ struct stmmac_channel {
 	struct stmmac_priv *priv_data;
 	spinlock_t lock;
 	u32 index;
+	/* RX interrupt moderation (DIM), sampled at NAPI completion */
+	struct dim rx_dim;
+	u16 rx_dim_events;
+	u64 rx_dim_packets;
+	u64 rx_dim_bytes;
 };
 
 struct stmmac_tc_entry {
@@ -267,6 +273,7 @@ struct stmmac_priv {
 	u32 systime_flags;
 	u32 adv_ts;
 	int use_riwt;
+	int use_rx_dim;
 	int irq_wake;
 	rwlock_t ptp_lock;
 	/* Protects auxiliary snapshot registers from concurrent access. */
@@ -337,6 +344,8 @@ int stmmac_mdio_register(struct net_device *ndev);
 int stmmac_mdio_reset(struct mii_bus *mii);
 int stmmac_xpcs_setup(struct mii_bus *mii);
 void stmmac_set_ethtool_ops(struct net_device *netdev);
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv);
+void stmmac_rx_dim_enable(struct stmmac_priv *priv, bool enable);
 
 int stmmac_init_tstamp_counter(struct stmmac_priv *priv, u32 systime_flags);
 void stmmac_ptp_register(struct stmmac_priv *priv);
@@ -565,6 +565,24 @@ static void stmmac_get_per_qstats(struct stmmac_priv *priv, u64 *data)
 	}
 }
 
+static void stmmac_get_page_pool_stats(struct stmmac_priv *priv, u64 *data)
+{
+	u32 rx_cnt = priv->plat->rx_queues_to_use;
+	struct page_pool_stats stats = {};
+	u32 q;
+
+	/* The page pools only exist while the interface is up */
+	if (netif_running(priv->dev)) {
+		for (q = 0; q < rx_cnt; q++) {
+			struct stmmac_rx_queue *rx_q = &priv->dma_conf.rx_queue[q];
+
+			if (rx_q->page_pool)
+				page_pool_get_stats(rx_q->page_pool, &stats);
+		}
+	}
+	page_pool_ethtool_stats_get(data, &stats);
+}
+
 static void stmmac_get_ethtool_stats(struct net_device *dev,
 				 struct ethtool_stats *dummy, u64 *data)
 {
@@ -616,6 +634,9 @@ static void stmmac_get_ethtool_stats(struct net_device *dev,
 			     sizeof(u64)) ? (*(u64 *)p) : (*(u32 *)p);
 	}
 	stmmac_get_per_qstats(priv, &data[j]);
+	j += STMMAC_TXQ_STATS * tx_queues_count +
+	     STMMAC_RXQ_STATS * rx_queues_count;
+	stmmac_get_page_pool_stats(priv, &data[j]);
 }
 
 static int stmmac_get_sset_count(struct net_device *netdev, int sset)
@@ -629,7 +650,8 @@ static int stmmac_get_sset_count(struct net_device *netdev, int sset)
 	case ETH_SS_STATS:
 		len = STMMAC_STATS_LEN +
 		      STMMAC_TXQ_STATS * tx_cnt +
-		      STMMAC_RXQ_STATS * rx_cnt;
+		      STMMAC_RXQ_STATS * rx_cnt +
+		      page_pool_ethtool_stats_get_count();
 
 		if (priv->dma_cap.rmon)
 			len += STMMAC_MMC_STATS_LEN;
@@ -705,6 +727,10 @@ static void stmmac_get_strings(struct net_device *dev, u32 stringset, u8 *data)
 			p += ETH_GSTRING_LEN;
 		}
 		stmmac_get_qstats_string(priv, p);
+		p += ETH_GSTRING_LEN *
+		     (STMMAC_TXQ_STATS * priv->plat->tx_queues_to_use +
+		      STMMAC_RXQ_STATS * priv->plat->rx_queues_to_use);
+		page_pool_ethtool_stats_get_strings(p);
 		break;
 	case ETH_SS_TEST:
 		stmmac_selftest_get_strings(priv, p);
@@ -819,7 +845,7 @@ static int stmmac_ethtool_op_set_eee(struct net_device *dev,
 	return 0;
 }
 
-static u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv)
+u32 stmmac_usec2riwt(u32 usec, struct stmmac_priv *priv)
 {
 	unsigned long clk = clk_get_rate(priv->plat->stmmac_clk);
 
@@ -880,6 +906,8 @@ static int __stmmac_get_coalesce(struct net_device *dev,
 		ec->rx_coalesce_usecs = 0;
 	}
 
+	ec->use_adaptive_rx_coalesce = priv->use_rx_dim;
+
 	return 0;
 }
 
@@ -917,6 +945,16 @@ static int __stmmac_set_coalesce(struct net_device *dev,
 	else if (queue >= max_cnt)
 		return -EINVAL;
 
+	/* Adaptive moderation drives the RX watchdog, so it needs one */
+	if (ec->use_adaptive_rx_coalesce && !priv->use_riwt)
+		return -EOPNOTSUPP;
+
+	/* It is on or off for the whole device, not per queue */
+	if (!all_queues && ec->use_adaptive_rx_coalesce != !!priv->use_rx_dim)
+		return -EOPNOTSUPP;
+
+	stmmac_rx_dim_enable(priv, ec->use_adaptive_rx_coalesce);
+
 	if (priv->use_riwt && (ec->rx_coalesce_usecs > 0)) {
 		rx_riwt = stmmac_usec2riwt(ec->rx_coalesce_usecs, priv);
 
@@ -1151,7 +1189,8 @@ static int stmmac_set_tunable(struct net_device *dev,
 
 static const struct ethtool_ops stmmac_ethtool_ops = {
 	.supported_coalesce_params = ETHTOOL_COALESCE_USECS |
-				     ETHTOOL_COALESCE_MAX_FRAMES,
+				     ETHTOOL_COALESCE_MAX_FRAMES |
+				     ETHTOOL_COALESCE_USE_ADAPTIVE_RX,
 	.begin = stmmac_check_if_running,
 	.get_drvinfo = stmmac_ethtool_getdrvinfo,
 	.get_msglevel = stmmac_ethtool_getmsglevel,
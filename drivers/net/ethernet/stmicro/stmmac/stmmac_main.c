@@ -212,11 +212,14 @@ static void __stmmac_disable_all_queues(struct stmmac_priv *priv)
 		if (stmmac_xdp_is_enabled(priv) &&
 		    test_bit(queue, priv->af_xdp_zc_qps)) {
 			napi_disable(&ch->rxtx_napi);
+			cancel_work_sync(&ch->rx_dim.work);
 			continue;
 		}
 
-		if (queue < rx_queues_cnt)
+		if (queue < rx_queues_cnt) {
 			napi_disable(&ch->rx_napi);
+			cancel_work_sync(&ch->rx_dim.work);
+		}
 		if (queue < tx_queues_cnt)
 			napi_disable(&ch->tx_napi);
 	}
@@ -389,6 +392,17 @@ static inline u32 stmmac_rx_dirty(struct stmmac_priv *priv, u32 queue)
 	return dirty;
 }
 
+/**
+ * stmmac_rx_fill_batch - Get the number of RX descriptors refilled at once
+ * @priv: driver private structure
+ * Description: glue layers can match the refill batch to the burst the DMA
+ * fetches descriptors with, so that it never runs into half refilled bursts.
+ */
+static inline u32 stmmac_rx_fill_batch(struct stmmac_priv *priv)
+{
+	return priv->plat->rx_fill_batch ?: STMMAC_RX_FILL_BATCH;
+}
+
 static void stmmac_lpi_entry_timer_config(struct stmmac_priv *priv, bool en)
 {
 	int tx_lpi_timer;
@@ -581,17 +595,29 @@ static void stmmac_get_rx_hwtstamp(struct stmmac_priv *priv, struct dma_desc *p,
 	struct skb_shared_hwtstamps *shhwtstamp = NULL;
 	struct dma_desc *desc = p;
 	u64 ns = 0;
+	int ret;
 
 	if (!priv->hwts_rx_en)
 		return;
-	/* For GMAC4, the valid timestamp is from CTX next desc. */
-	if (priv->plat->has_gmac4 || priv->plat->has_xgmac)
-		desc = np;
 
-	/* Check if timestamp is available */
-	if (stmmac_get_rx_timestamp_status(priv, p, np, priv->adv_ts)) {
-		stmmac_get_timestamp(priv, desc, priv->adv_ts, &ns);
+	if (priv->hw->desc->get_rx_hwtstamp) {
+		/* Status and value from a single pass over the descriptors */
+		ret = stmmac_get_rx_hwtstamp_desc(priv, p, np, priv->adv_ts,
+						  &ns);
+	} else {
+		/* For GMAC4, the valid timestamp is from CTX next desc. */
+		if (priv->plat->has_gmac4 || priv->plat->has_xgmac)
+			desc = np;
+
+		/* Check if timestamp is available */
+		ret = -ENODATA;
+		if (stmmac_get_rx_timestamp_status(priv, p, np, priv->adv_ts)) {
+			stmmac_get_timestamp(priv, desc, priv->adv_ts, &ns);
+			ret = 0;
+		}
+	}
 
+	if (!ret) {
 		ns -= priv->plat->cdc_error_adj;
 
 		netdev_dbg(priv->dev, "get valid RX hw timestamp %llu\n", ns);
@@ -2013,7 +2039,10 @@ static int __alloc_dma_rx_desc_resources(struct stmmac_priv *priv,
 	rx_q->priv_data = priv;
 
 	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
-	pp_params.pool_size = dma_conf->dma_rx_size;
+	/* Leave room for a whole refill batch being recycled while the
+	 * ring itself is fully populated.
+	 */
+	pp_params.pool_size = dma_conf->dma_rx_size + stmmac_rx_fill_batch(priv);
 	num_pages = DIV_ROUND_UP(dma_conf->dma_buf_sz, PAGE_SIZE);
 	pp_params.order = ilog2(num_pages);
 	pp_params.nid = dev_to_node(priv->device);
@@ -4938,6 +4967,8 @@ static void stmmac_dispatch_skb_zc(struct stmmac_priv *priv, u32 queue,
 
 	priv->dev->stats.rx_packets++;
 	priv->dev->stats.rx_bytes += len;
+	ch->rx_dim_packets++;
+	ch->rx_dim_bytes += len;
 }
 
 static bool stmmac_rx_refill_zc(struct stmmac_priv *priv, u32 queue, u32 budget)
@@ -5049,7 +5080,7 @@ static int stmmac_rx_zc(struct stmmac_priv *priv, int limit, u32 queue)
 		entry = next_entry;
 		buf = &rx_q->buf_pool[entry];
 
-		if (dirty >= STMMAC_RX_FILL_BATCH) {
+		if (dirty >= stmmac_rx_fill_batch(priv)) {
 			failure = failure ||
 				  !stmmac_rx_refill_zc(priv, queue, dirty);
 			dirty = 0;
@@ -5425,6 +5456,8 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 
 		priv->dev->stats.rx_packets++;
 		priv->dev->stats.rx_bytes += len;
+		ch->rx_dim_packets++;
+		ch->rx_dim_bytes += len;
 		count++;
 	}
 
@@ -5445,6 +5478,70 @@ static int stmmac_rx(struct stmmac_priv *priv, int limit, u32 queue)
 	return count;
 }
 
+static void stmmac_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_channel *ch =
+		container_of(dim, struct stmmac_channel, rx_dim);
+	struct stmmac_priv *priv = ch->priv_data;
+	struct dim_cq_moder moder;
+	u32 riwt;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+
+	/* Only the watchdog is tuned, rx_coal_frames stays as configured */
+	riwt = stmmac_usec2riwt(moder.usec, priv);
+	riwt = clamp_t(u32, riwt, MIN_DMA_RIWT, MAX_DMA_RIWT);
+	stmmac_rx_watchdog(priv, priv->ioaddr, riwt, ch->index);
+
+	dim->state = DIM_START_MEASURE;
+}
+
+static void stmmac_rx_dim_update(struct stmmac_priv *priv,
+				 struct stmmac_channel *ch)
+{
+	struct dim_sample sample = {};
+
+	if (!priv->use_rx_dim)
+		return;
+
+	ch->rx_dim_events++;
+	dim_update_sample(ch->rx_dim_events, ch->rx_dim_packets,
+			  ch->rx_dim_bytes, &sample);
+	net_dim(&ch->rx_dim, sample);
+}
+
+/**
+ * stmmac_rx_dim_enable - Turn dynamic RX interrupt moderation on or off
+ * @priv: driver private structure
+ * @enable: new state
+ * Description: when turned off, the RX watchdog of every queue goes back
+ * to the value configured through ethtool.
+ */
+void stmmac_rx_dim_enable(struct stmmac_priv *priv, bool enable)
+{
+	u32 queue;
+
+	if (priv->use_rx_dim == enable)
+		return;
+
+	priv->use_rx_dim = enable;
+	if (enable)
+		return;
+
+	for (queue = 0; queue < priv->plat->rx_queues_to_use; queue++) {
+		struct stmmac_channel *ch = &priv->channel[queue];
+
+		cancel_work_sync(&ch->rx_dim.work);
+		ch->rx_dim.state = DIM_START_MEASURE;
+		ch->rx_dim.profile_ix = 0;
+
+		if (netif_running(priv->dev))
+			stmmac_rx_watchdog(priv, priv->ioaddr,
+					   priv->rx_riwt[queue], queue);
+	}
+}
+
 static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 {
 	struct stmmac_channel *ch =
@@ -5459,6 +5556,8 @@ static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		stmmac_rx_dim_update(priv, ch);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
 		spin_unlock_irqrestore(&ch->lock, flags);
@@ -5518,6 +5617,8 @@ static int stmmac_napi_poll_rxtx(struct napi_struct *napi, int budget)
 	if (napi_complete_done(napi, rxtx_done)) {
 		unsigned long flags;
 
+		stmmac_rx_dim_update(priv, ch);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		/* Both RX and TX work done are compelte,
 		 * so enable both RX & TX IRQs.
@@ -6908,6 +7009,9 @@ static int stmmac_hw_init(struct stmmac_priv *priv)
 		priv->use_riwt = 1;
 		dev_info(priv->device,
 			 "Enable RX Mitigation via HW Watchdog Timer\n");
+
+		/* Let net_dim tune the watchdog if the platform asks for it */
+		priv->use_rx_dim = priv->plat->rx_dim_en;
 	}
 
 	return 0;
@@ -6929,6 +7033,8 @@ static void stmmac_napi_add(struct net_device *dev)
 
 		if (queue < priv->plat->rx_queues_to_use) {
 			netif_napi_add(dev, &ch->rx_napi, stmmac_napi_poll_rx);
+			INIT_WORK(&ch->rx_dim.work, stmmac_rx_dim_work);
+			ch->rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
 		}
 		if (queue < priv->plat->tx_queues_to_use) {
 			netif_napi_add_tx(dev, &ch->tx_napi,
@@ -7105,6 +7211,7 @@ int stmmac_dvr_probe(struct device *device,
 	priv->ioaddr = res->addr;
 	priv->dev->base_addr = (unsigned long)res->addr;
 	priv->plat->dma_cfg->multi_msi_en = priv->plat->multi_msi_en;
+	priv->dma_conf.dma_tx_size = priv->plat->dma_tx_size;
 
 	if (!of_property_read_u32(device->of_node, "handle_cpu_id", &cpu_id)) {
 		cpumask_clear(&cpumask);
@@ -18,6 +18,7 @@
 #include <net/tcp.h>
 #include <net/udp.h>
 #include <net/tc_act/tc_gact.h>
+#include <net/xdp_sock_drv.h>
 #include "stmmac.h"
 
 struct stmmachdr {
@@ -1815,6 +1816,38 @@ static int stmmac_test_tbs(struct stmmac_priv *priv)
 	return ret;
 }
 
+static int stmmac_test_xsk_zc(struct stmmac_priv *priv)
+{
+	int i, zc = 0;
+
+	if (!stmmac_xdp_is_enabled(priv))
+		return -EOPNOTSUPP;
+
+	for (i = 0; i < priv->plat->rx_queues_to_use; i++) {
+		struct stmmac_rx_queue *rx_q = &priv->dma_conf.rx_queue[i];
+		struct stmmac_tx_queue *tx_q = &priv->dma_conf.tx_queue[i];
+		struct xsk_buff_pool *pool;
+
+		if (!test_bit(i, priv->af_xdp_zc_qps))
+			continue;
+
+		/* A bound XSK pool only means zero-copy if the rings run
+		 * straight out of it, otherwise frames are being copied.
+		 */
+		pool = xsk_get_pool_from_qid(priv->dev, i);
+		if (!pool || rx_q->xsk_pool != pool || tx_q->xsk_pool != pool)
+			return -EINVAL;
+		if (rx_q->xdp_rxq.mem.type != MEM_TYPE_XSK_BUFF_POOL)
+			return -EINVAL;
+		if (!rx_q->buf_alloc_num)
+			return -ENOBUFS;
+
+		zc++;
+	}
+
+	return zc ? 0 : -EOPNOTSUPP;
+}
+
 #define STMMAC_LOOPBACK_NONE	0
 #define STMMAC_LOOPBACK_MAC	1
 #define STMMAC_LOOPBACK_PHY	2
@@ -1952,6 +1985,10 @@ static const struct stmmac_test {
 		.name = "TBS (ETF Scheduler)        ",
 		.lb = STMMAC_LOOPBACK_PHY,
 		.fn = stmmac_test_tbs,
+	}, {
+		.name = "XDP Zero-Copy              ",
+		.lb = STMMAC_LOOPBACK_NONE,
+		.fn = stmmac_test_xsk_zc,
 	},
 };
 
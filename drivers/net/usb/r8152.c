@@ -750,6 +750,7 @@ enum rtl_register_content {
 
 #define RTL8152_MAX_TX		4
 #define RTL8152_MAX_RX		10
+#define RTL8152_MAX_RX_2500	20
 #define INTBUFSIZE		2
 #define TX_ALIGN		4
 #define RX_ALIGN		8
@@ -943,6 +944,7 @@ struct r8152 {
 	u32 rx_buf_sz;
 	u32 rx_copybreak;
 	u32 rx_pending;
+	u32 rx_urbs;
 	u32 fc_pause_on, fc_pause_off;
 
 	unsigned int pipe_in, pipe_out, pipe_intr, pipe_ctrl_in, pipe_ctrl_out;
@@ -2036,7 +2038,7 @@ static int alloc_all_mem(struct r8152 *tp)
 	skb_queue_head_init(&tp->rx_queue);
 	atomic_set(&tp->rx_count, 0);
 
-	for (i = 0; i < RTL8152_MAX_RX; i++) {
+	for (i = 0; i < tp->rx_urbs; i++) {
 		if (!alloc_rx_agg(tp, GFP_KERNEL))
 			goto err1;
 	}
@@ -2388,7 +2390,7 @@ static u8 r8152_rx_csum(struct r8152 *tp, struct rx_desc *rx_desc)
 
 static inline bool rx_count_exceed(struct r8152 *tp)
 {
-	return atomic_read(&tp->rx_count) > RTL8152_MAX_RX;
+	return atomic_read(&tp->rx_count) > tp->rx_urbs;
 }
 
 static inline int agg_offset(struct rx_agg *agg, void *addr)
@@ -2938,8 +2940,8 @@ static int rtl_start_rx(struct r8152 *tp)
 	list_for_each_entry_safe(agg, agg_next, &tmp_list, info_list) {
 		INIT_LIST_HEAD(&agg->list);
 
-		/* Only RTL8152_MAX_RX rx_agg need to be submitted. */
-		if (++i > RTL8152_MAX_RX) {
+		/* Only rx_urbs rx_agg need to be submitted. */
+		if (++i > tp->rx_urbs) {
 			spin_lock_irqsave(&tp->rx_lock, flags);
 			list_add_tail(&agg->list, &tp->rx_used);
 			spin_unlock_irqrestore(&tp->rx_lock, flags);
@@ -2979,7 +2981,7 @@ static int rtl_stop_rx(struct r8152 *tp)
 	spin_unlock_irqrestore(&tp->rx_lock, flags);
 
 	list_for_each_entry_safe(agg, agg_next, &tmp_list, info_list) {
-		/* At least RTL8152_MAX_RX rx_agg have the page_count being
+		/* At least rx_urbs rx_agg have the page_count being
 		 * equal to 1, so the other ones could be freed safely.
 		 */
 		if (page_count(agg->page) > 1)
@@ -9130,7 +9132,7 @@ static int rtl8152_set_ringparam(struct net_device *netdev,
 {
 	struct r8152 *tp = netdev_priv(netdev);
 
-	if (ring->rx_pending < (RTL8152_MAX_RX * 2))
+	if (ring->rx_pending < (tp->rx_urbs * 2))
 		return -EINVAL;
 
 	if (tp->rx_pending != ring->rx_pending) {
@@ -9827,8 +9829,14 @@ static int rtl8152_probe(struct usb_interface *intf,
 	}
 	tp->duplex = DUPLEX_FULL;
 
+	/* A 2.5G link drains the rx URBs twice as fast; keep more in flight */
+	if (tp->speed == SPEED_2500)
+		tp->rx_urbs = RTL8152_MAX_RX_2500;
+	else
+		tp->rx_urbs = RTL8152_MAX_RX;
+
 	tp->rx_copybreak = RTL8152_RXFG_HEADSZ;
-	tp->rx_pending = 10 * RTL8152_MAX_RX;
+	tp->rx_pending = 10 * tp->rx_urbs;
 
 	intf->needs_remote_wakeup = 1;
 
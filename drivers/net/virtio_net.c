@@ -1455,6 +1455,7 @@ static bool try_fill_recv(struct virtnet_info *vi, struct receive_queue *rq,
 	int err;
 	bool oom;
 
+	virtqueue_add_batch_start(rq->vq);
 	do {
 		if (vi->mergeable_rx_bufs)
 			err = add_recvbuf_mergeable(vi, rq, gfp);
@@ -1467,6 +1468,8 @@ static bool try_fill_recv(struct virtnet_info *vi, struct receive_queue *rq,
 		if (err)
 			break;
 	} while (rq->vq->num_free);
+	virtqueue_add_batch_end(rq->vq);
+
 	if (virtqueue_kick_prepare(rq->vq) && virtqueue_notify(rq->vq)) {
 		unsigned long flags;
 
@@ -1592,14 +1595,28 @@ static int virtnet_receive(struct receive_queue *rq, int budget,
 	return stats.packets;
 }
 
+/* Completed TX buffers reaped from the ring at once */
+#define VIRTNET_XMIT_REAP_BATCH	16
+
 static void free_old_xmit_skbs(struct send_queue *sq, bool in_napi)
 {
-	unsigned int len;
+	unsigned int lens[VIRTNET_XMIT_REAP_BATCH];
+	void *bufs[VIRTNET_XMIT_REAP_BATCH];
 	unsigned int packets = 0;
 	unsigned int bytes = 0;
+	unsigned int i = 0, n = 0;
 	void *ptr;
 
-	while ((ptr = virtqueue_get_buf(sq->vq, &len)) != NULL) {
+	for (;;) {
+		if (i == n) {
+			n = virtqueue_get_bufs(sq->vq, bufs, lens,
+					       VIRTNET_XMIT_REAP_BATCH);
+			if (!n)
+				break;
+			i = 0;
+		}
+		ptr = bufs[i++];
+
 		if (likely(!is_xdp_frame(ptr))) {
 			struct sk_buff *skb = ptr;
 
@@ -23,6 +23,7 @@ struct wg_device;
 struct multicore_worker {
 	void *ptr;
 	struct work_struct work;
+	unsigned int credit;
 };
 
 struct crypt_queue {
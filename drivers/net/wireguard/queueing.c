@@ -5,6 +5,25 @@
 
 #include "queueing.h"
 #include <linux/skb_array.h>
+#include <linux/moduleparam.h>
+
+static char *crypt_cpus;
+module_param(crypt_cpus, charp, 0444);
+MODULE_PARM_DESC(crypt_cpus, "List of CPUs to run encryption and decryption workers on (default: all)");
+
+struct cpumask wg_crypt_cpumask;
+
+void __init wg_crypt_cpumask_init(void)
+{
+	cpumask_setall(&wg_crypt_cpumask);
+	if (!crypt_cpus)
+		return;
+	if (cpulist_parse(crypt_cpus, &wg_crypt_cpumask) < 0 ||
+	    cpumask_empty(&wg_crypt_cpumask)) {
+		pr_warn("Invalid crypt_cpus \"%s\", using all CPUs\n", crypt_cpus);
+		cpumask_setall(&wg_crypt_cpumask);
+	}
+}
 
 struct multicore_worker __percpu *
 wg_packet_percpu_multicore_worker_alloc(work_func_t function, void *ptr)
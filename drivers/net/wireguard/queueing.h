@@ -11,6 +11,7 @@
 #include <linux/skbuff.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
+#include <linux/sched/topology.h>
 #include <net/ip_tunnels.h>
 
 struct wg_device;
@@ -21,6 +22,8 @@ struct prev_queue;
 struct sk_buff;
 
 /* queueing.c APIs: */
+extern struct cpumask wg_crypt_cpumask;
+void wg_crypt_cpumask_init(void);
 int wg_packet_queue_init(struct crypt_queue *queue, work_func_t function,
 			 unsigned int len);
 void wg_packet_queue_free(struct crypt_queue *queue, bool purge);
@@ -117,16 +120,47 @@ static inline int wg_cpumask_choose_online(int *stored_cpu, unsigned int id)
 	return cpu;
 }
 
-/* This function is racy, in the sense that it's called while last_cpu is
- * unlocked, so it could return the same CPU twice. Adding locking or using
- * atomic sequence numbers is slower though, and the consequences of racing are
- * harmless, so live with it.
+/* Round robin over the online crypt CPUs, weighted by CPU capacity: each visit
+ * credits a CPU with its capacity, and it is only picked once it has earned
+ * SCHED_CAPACITY_SCALE, so that slower cores of an asymmetric system get
+ * proportionally fewer packets and don't hold up the in-order peer queues.
+ * When all CPUs have full capacity, every visit picks the CPU.
+ *
+ * This function is racy, in the sense that it's called while last_cpu and the
+ * credits are unlocked, so it could return the same CPU twice. Adding locking
+ * or using atomic sequence numbers is slower though, and the consequences of
+ * racing are harmless, so live with it.
  */
-static inline int wg_cpumask_next_online(int *last_cpu)
+static inline int wg_cpumask_next_online(struct multicore_worker __percpu *worker,
+					 int *last_cpu)
 {
-	int cpu = cpumask_next(*last_cpu, cpu_online_mask);
-	if (cpu >= nr_cpu_ids)
-		cpu = cpumask_first(cpu_online_mask);
+	const struct cpumask *mask = &wg_crypt_cpumask;
+	struct multicore_worker *w;
+	unsigned long capacity;
+	unsigned int credit;
+	int cpu = *last_cpu;
+
+	if (unlikely(!cpumask_intersects(mask, cpu_online_mask)))
+		mask = cpu_online_mask;
+	for (;;) {
+		cpu = cpumask_next_and(cpu, mask, cpu_online_mask);
+		if (cpu >= nr_cpu_ids)
+			cpu = cpumask_first_and(mask, cpu_online_mask);
+		if (unlikely(cpu >= nr_cpu_ids)) {
+			cpu = cpumask_first(cpu_online_mask);
+			break;
+		}
+		capacity = arch_scale_cpu_capacity(cpu);
+		if (capacity >= SCHED_CAPACITY_SCALE || !capacity)
+			break;
+		w = per_cpu_ptr(worker, cpu);
+		credit = READ_ONCE(w->credit) + capacity;
+		if (credit >= SCHED_CAPACITY_SCALE) {
+			WRITE_ONCE(w->credit, credit - SCHED_CAPACITY_SCALE);
+			break;
+		}
+		WRITE_ONCE(w->credit, credit);
+	}
 	*last_cpu = cpu;
 	return cpu;
 }
@@ -170,7 +204,7 @@ static inline int wg_queue_enqueue_per_device_and_peer(
 	/* Then we queue it up in the device queue, which consumes the
 	 * packet as soon as it can.
 	 */
-	cpu = wg_cpumask_next_online(&device_queue->last_cpu);
+	cpu = wg_cpumask_next_online(device_queue->worker, &device_queue->last_cpu);
 	if (unlikely(ptr_ring_produce_bh(&device_queue->ring, skb)))
 		return -EPIPE;
 	queue_work_on(cpu, wq, &per_cpu_ptr(device_queue->worker, cpu)->work);
@@ -128,6 +128,8 @@ struct rte_console {
 
 #define BRCMF_TXMINMAX	1	/* Max tx frames if rx still pending */
 
+#define BRCMF_TXGLOM_GROW	64	/* Good tx chains before regrowing */
+
 #define MEMBLOCK	2048	/* Block size used for downloading
 				 of dongle image */
 #define MAX_DATA_BUF	(32 * 1024)	/* Must be large enough to hold
@@ -524,6 +526,8 @@ struct brcmf_sdio {
 
 	u8 tx_hdrlen;		/* sdio bus header length for tx packet */
 	bool txglom;		/* host tx glomming enable flag */
+	uint txglom_sz;		/* current tx chain limit, <= txglomsz */
+	uint txglom_good;	/* chains sent since last txglom_sz change */
 	u16 head_align;		/* buffer pointer alignment */
 	u16 sgentry_align;	/* scatter-gather buffer alignment */
 };
@@ -2331,6 +2335,27 @@ static int brcmf_sdio_txpkt(struct brcmf_sdio *bus, struct sk_buff_head *pktq,
 	return ret;
 }
 
+/* Shrink the tx chain limit when a chain fails, so a marginal SDIO link
+ * loses and retries less data per CMD53, and grow it back to txglomsz
+ * once chains go through again.
+ */
+static void brcmf_sdio_txglom_adapt(struct brcmf_sdio *bus, int ret)
+{
+	if (ret) {
+		bus->txglom_sz = max_t(uint, bus->txglom_sz / 2, 1);
+		bus->txglom_good = 0;
+		return;
+	}
+
+	if (bus->txglom_sz >= bus->sdiodev->txglomsz ||
+	    ++bus->txglom_good < BRCMF_TXGLOM_GROW)
+		return;
+
+	bus->txglom_sz = min_t(uint, bus->txglom_sz * 2,
+			       bus->sdiodev->txglomsz);
+	bus->txglom_good = 0;
+}
+
 static uint brcmf_sdio_sendfromq(struct brcmf_sdio *bus, uint maxframes)
 {
 	struct sk_buff *pkt;
@@ -2350,7 +2375,7 @@ static uint brcmf_sdio_sendfromq(struct brcmf_sdio *bus, uint maxframes)
 		pkt_num = 1;
 		if (bus->txglom)
 			pkt_num = min_t(u8, bus->tx_max - bus->tx_seq,
-					bus->sdiodev->txglomsz);
+					bus->txglom_sz);
 		pkt_num = min_t(u32, pkt_num,
 				brcmu_pktq_mlen(&bus->txq, ~bus->flowcontrol));
 		__skb_queue_head_init(&pktq);
@@ -2367,6 +2392,8 @@ static uint brcmf_sdio_sendfromq(struct brcmf_sdio *bus, uint maxframes)
 			break;
 
 		ret = brcmf_sdio_txpkt(bus, &pktq, SDPCM_DATA_CHANNEL);
+		if (bus->txglom)
+			brcmf_sdio_txglom_adapt(bus, ret);
 
 		cnt += i;
 
@@ -3583,6 +3610,10 @@ static int brcmf_sdio_bus_preinit(struct device *dev)
 		} else {
 			bus->txglom = true;
 			bus->tx_hdrlen += SDPCM_HWEXT_LEN;
+			bus->txglom_sz = sdiodev->txglomsz;
+			/* let one scheduling round carry a full chain */
+			bus->txbound = max_t(uint, bus->txbound,
+					     sdiodev->txglomsz);
 		}
 	}
 	brcmf_bus_add_txhdrlen(bus->sdiodev->dev, bus->tx_hdrlen);
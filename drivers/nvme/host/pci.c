@@ -44,6 +44,13 @@
 #define NVME_MAX_KB_SZ	4096
 #define NVME_MAX_SEGS	127
 
+/*
+ * Don't let the HMB take more than this fraction of system memory. Large
+ * HMB chunks come out of CMA on systems without an IOMMU, and on small
+ * boards the default limit would eat most of it.
+ */
+#define NVME_HMB_MAX_RAM_SHIFT	6
+
 static int use_threaded_interrupts;
 module_param(use_threaded_interrupts, int, 0444);
 
@@ -96,7 +103,7 @@ MODULE_PARM_DESC(write_queues,
 	"Number of queues to use for writes. If not set, reads and writes "
 	"will share a queue set.");
 
-static unsigned int poll_queues;
+static unsigned int poll_queues = CONFIG_NVME_POLL_QUEUES;
 module_param_cb(poll_queues, &io_queue_count_ops, &poll_queues, 0644);
 MODULE_PARM_DESC(poll_queues, "Number of queues to use for polled IO.");
 
@@ -2106,11 +2113,14 @@ static int nvme_setup_host_mem(struct nvme_dev *dev)
 	u32 enable_bits = NVME_HOST_MEM_ENABLE;
 	int ret;
 
+	max = min_t(u64, max,
+		    ((u64)totalram_pages() << PAGE_SHIFT) >> NVME_HMB_MAX_RAM_SHIFT);
+
 	preferred = min(preferred, max);
 	if (min > max) {
 		dev_warn(dev->ctrl.device,
-			"min host memory (%lld MiB) above limit (%d MiB).\n",
-			min >> ilog2(SZ_1M), max_host_mem_size_mb);
+			"min host memory (%lld MiB) above limit (%lld MiB).\n",
+			min >> ilog2(SZ_1M), max >> ilog2(SZ_1M));
 		nvme_free_host_mem(dev);
 		return 0;
 	}
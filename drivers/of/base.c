@@ -135,7 +135,7 @@ int __weak of_node_to_nid(struct device_node *np)
 }
 #endif
 
-#define OF_PHANDLE_CACHE_BITS	7
+#define OF_PHANDLE_CACHE_BITS	CONFIG_OF_PHANDLE_CACHE_BITS
 #define OF_PHANDLE_CACHE_SZ	BIT(OF_PHANDLE_CACHE_BITS)
 
 static struct device_node *phandle_cache[OF_PHANDLE_CACHE_SZ];
@@ -346,6 +346,54 @@ static int unflatten_dt_nodes(const void *blob,
 	return mem - base;
 }
 
+/**
+ * unflatten_dt_size - Upper bound of the memory needed to unflatten a blob
+ * @blob: The device tree blob
+ *
+ * Walks the structure block once, without looking up property names or
+ * node status, and accounts for every node, every property and a fixed up
+ * "name" property per node. Every allocation is rounded up to the largest
+ * alignment used, so that the result is never less than what
+ * unflatten_dt_nodes() consumes, whatever the order of the allocations.
+ *
+ * Return: The size in bytes or an error code.
+ */
+static int unflatten_dt_size(const void *blob)
+{
+	const unsigned long align = max(__alignof__(struct device_node),
+					__alignof__(struct property));
+	int offset = 0, nextoffset, len;
+	unsigned long size = 0;
+	uint32_t tag;
+
+	do {
+		tag = fdt_next_tag(blob, offset, &nextoffset);
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			if (!fdt_get_name(blob, offset, &len))
+				return len;
+			size += ALIGN(sizeof(struct device_node) + len + 1,
+				      align);
+			size += ALIGN(sizeof(struct property) + len + 1,
+				      align);
+			break;
+		case FDT_PROP:
+			size += ALIGN(sizeof(struct property), align);
+			break;
+		}
+		offset = nextoffset;
+	} while (tag != FDT_END && size <= INT_MAX);
+
+	if (offset < 0 && offset != -FDT_ERR_NOTFOUND) {
+		pr_err("Error %d processing FDT\n", offset);
+		return -EINVAL;
+	}
+	if (size > INT_MAX)
+		return -E2BIG;
+
+	return size;
+}
+
 /**
  * __unflatten_device_tree - create tree of device_nodes from flat blob
  * @blob: The blob to expand
@@ -393,7 +441,7 @@ void *__unflatten_device_tree(const void *blob,
 	}
 
 	/* First pass, scan for size */
-	size = unflatten_dt_nodes(blob, NULL, dad, NULL);
+	size = unflatten_dt_size(blob);
 	if (size <= 0)
 		return NULL;
 
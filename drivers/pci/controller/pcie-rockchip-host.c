@@ -57,6 +57,18 @@ static void rockchip_pcie_clr_bw_int(struct rockchip_pcie *rockchip)
 	rockchip_pcie_write(rockchip, status, PCIE_RC_CONFIG_LCS);
 }
 
+static void rockchip_pcie_show_link(struct rockchip_pcie *rockchip)
+{
+	u32 status;
+
+	/* Negotiated speed and lane counter from MGMT */
+	status = rockchip_pcie_read(rockchip, PCIE_CORE_CTRL);
+	dev_info_ratelimited(rockchip->dev, "link up at %s GT/s x%d\n",
+			     PCIE_LINK_IS_GEN2(status) ? "5.0" : "2.5",
+			     0x1 << ((status & PCIE_CORE_PL_CONF_LANE_MASK) >>
+				     PCIE_CORE_PL_CONF_LANE_SHIFT));
+}
+
 static void rockchip_pcie_update_txcredit_mui(struct rockchip_pcie *rockchip)
 {
 	u32 val;
@@ -352,14 +364,20 @@ static int rockchip_pcie_host_init_port(struct rockchip_pcie *rockchip)
 					 status, PCIE_LINK_IS_GEN2(status), 20,
 					 500 * USEC_PER_MSEC);
 		if (err)
-			dev_dbg(dev, "PCIe link training gen2 timeout, fall back to gen1!\n");
+			dev_info(dev, "PCIe link training gen2 timeout, fall back to gen1!\n");
+
+		/* Retraining can't fail the port, it stays up at gen1 */
+		err = readl_poll_timeout(rockchip->apb_base +
+					 PCIE_CLIENT_BASIC_STATUS1,
+					 status, PCIE_LINK_UP(status), 20,
+					 500 * USEC_PER_MSEC);
+		if (err) {
+			dev_err(dev, "PCIe link lost after gen2 retrain!\n");
+			goto err_power_off_phy;
+		}
 	}
 
-	/* Check the final link width from negotiated lane counter from MGMT */
-	status = rockchip_pcie_read(rockchip, PCIE_CORE_CTRL);
-	status = 0x1 << ((status & PCIE_CORE_PL_CONF_LANE_MASK) >>
-			  PCIE_CORE_PL_CONF_LANE_SHIFT);
-	dev_dbg(dev, "current link width is x%d\n", status);
+	rockchip_pcie_show_link(rockchip);
 
 	/* Power off unused lane(s) */
 	rockchip->lanes_map = rockchip_pcie_lane_map(rockchip);
@@ -376,10 +394,17 @@ static int rockchip_pcie_host_init_port(struct rockchip_pcie *rockchip)
 			    PCI_CLASS_BRIDGE_PCI_NORMAL << 8,
 			    PCIE_RC_CONFIG_RID_CCR);
 
-	/* Clear THP cap's next cap pointer to remove L1 substate cap */
-	status = rockchip_pcie_read(rockchip, PCIE_RC_CONFIG_THP_CAP);
-	status &= ~PCIE_RC_CONFIG_THP_CAP_NEXT_MASK;
-	rockchip_pcie_write(rockchip, status, PCIE_RC_CONFIG_THP_CAP);
+	/*
+	 * L1 substates need CLKREQ#, so unless the board has it wired up,
+	 * clear THP cap's next cap pointer to remove L1 substate cap.
+	 * Otherwise the ASPM policy (pcie_aspm.policy, settable at runtime)
+	 * chooses between performance and the L1 substates.
+	 */
+	if (!of_property_read_bool(dev->of_node, "supports-clkreq")) {
+		status = rockchip_pcie_read(rockchip, PCIE_RC_CONFIG_THP_CAP);
+		status &= ~PCIE_RC_CONFIG_THP_CAP_NEXT_MASK;
+		rockchip_pcie_write(rockchip, status, PCIE_RC_CONFIG_THP_CAP);
+	}
 
 	/* Clear L0s from RC's link cap */
 	if (of_property_read_bool(dev->of_node, "aspm-no-l0s")) {
@@ -458,9 +483,15 @@ static irqreturn_t rockchip_pcie_subsys_irq_handler(int irq, void *arg)
 
 		rockchip_pcie_write(rockchip, sub_reg, PCIE_CORE_INT_STATUS);
 	} else if (reg & PCIE_CLIENT_INT_PHY) {
-		dev_dbg(dev, "phy link changes\n");
+		sub_reg = rockchip_pcie_read(rockchip, PCIE_RC_CONFIG_LCS);
+		dev_dbg(dev, "phy link changes%s%s\n",
+			sub_reg & (PCI_EXP_LNKSTA_LBMS << 16) ?
+			", bandwidth management" : "",
+			sub_reg & (PCI_EXP_LNKSTA_LABS << 16) ?
+			", autonomous bandwidth change" : "");
 		rockchip_pcie_update_txcredit_mui(rockchip);
 		rockchip_pcie_clr_bw_int(rockchip);
+		rockchip_pcie_show_link(rockchip);
 	}
 
 	rockchip_pcie_write(rockchip, reg & PCIE_CLIENT_INT_LOCAL,
@@ -613,6 +644,16 @@ static int rockchip_pcie_parse_host_dt(struct rockchip_pcie *rockchip)
 	if (IS_ERR(rockchip->vpcie0v9))
 		return PTR_ERR(rockchip->vpcie0v9);
 
+	/*
+	 * The RC has no MSI controller of its own, MSIs are only delivered
+	 * when msi-map routes them to the GIC ITS. Without it, endpoints
+	 * fall back to INTx, which all end up on the chained "legacy" irq
+	 * and can't be spread over the CPUs.
+	 */
+	if (!of_find_property(dev->of_node, "msi-map", NULL) &&
+	    !of_find_property(dev->of_node, "msi-parent", NULL))
+		dev_info(dev, "no msi-map, endpoints are limited to INTx\n");
+
 	return 0;
 }
 
@@ -777,6 +818,30 @@ static int rockchip_pcie_prog_ib_atu(struct rockchip_pcie *rockchip,
 	return 0;
 }
 
+/*
+ * The RC passes inbound addresses through as they are, so one window only
+ * needs enough address bits to reach the end of the DMA ranges. Without
+ * dma-ranges, keep the 4GB window the RC always had.
+ */
+static u8 rockchip_pcie_ib_pass_bits(struct rockchip_pcie *rockchip)
+{
+	struct pci_host_bridge *bridge = pci_host_bridge_from_priv(rockchip);
+	struct resource_entry *entry;
+	u64 end = 0;
+
+	resource_list_for_each_entry(entry, &bridge->dma_ranges) {
+		if (entry->offset) {
+			dev_warn(rockchip->dev,
+				 "ignoring translated dma-range %pR\n",
+				 entry->res);
+			continue;
+		}
+		end = max_t(u64, end, entry->res->end);
+	}
+
+	return clamp(fls64(end), 32, 64);
+}
+
 static int rockchip_pcie_cfg_atu(struct rockchip_pcie *rockchip)
 {
 	struct device *dev = rockchip->dev;
@@ -809,7 +874,9 @@ static int rockchip_pcie_cfg_atu(struct rockchip_pcie *rockchip)
 		}
 	}
 
-	err = rockchip_pcie_prog_ib_atu(rockchip, 2, 32 - 1, 0x0, 0);
+	err = rockchip_pcie_prog_ib_atu(rockchip, 2,
+					rockchip_pcie_ib_pass_bits(rockchip) - 1,
+					0x0, 0);
 	if (err) {
 		dev_err(dev, "program RC mem inbound ATU failed\n");
 		return err;
@@ -984,6 +1051,8 @@ static int rockchip_pcie_probe(struct platform_device *pdev)
 
 	bridge->sysdata = rockchip;
 	bridge->ops = &rockchip_pcie_ops;
+	/* Don't let endpoints try MSI if nothing handles it */
+	bridge->msi_domain = true;
 
 	err = rockchip_pcie_setup_irq(rockchip);
 	if (err)
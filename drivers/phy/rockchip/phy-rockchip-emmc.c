@@ -316,11 +316,38 @@ static int rockchip_emmc_phy_power_on(struct phy *phy)
 	return rockchip_emmc_phy_power(phy, PHYCTRL_PDB_PWR_ON);
 }
 
+/*
+ * Power on does not wait for the DLL when the card clock was still off at
+ * that point.  Let the host confirm the lock before it relies on it, e.g.
+ * before the command queue engine starts issuing transfers on its own.
+ */
+static int rockchip_emmc_phy_calibrate(struct phy *phy)
+{
+	struct rockchip_emmc_phy *rk_phy = phy_get_drvdata(phy);
+	unsigned int con6, dllrdy;
+	int ret;
+
+	regmap_read(rk_phy->reg_base, rk_phy->reg_offset + GRF_EMMCPHY_CON6,
+		    &con6);
+	if (!((con6 >> PHYCTRL_ENDLL_SHIFT) & PHYCTRL_ENDLL_MASK))
+		return 0;
+
+	ret = regmap_read_poll_timeout(rk_phy->reg_base,
+				       rk_phy->reg_offset + GRF_EMMCPHY_STATUS,
+				       dllrdy, PHYCTRL_IS_DLLRDY(dllrdy),
+				       0, 50 * USEC_PER_MSEC);
+	if (ret)
+		pr_err("%s: dllrdy failed. ret=%d\n", __func__, ret);
+
+	return ret;
+}
+
 static const struct phy_ops ops = {
 	.init		= rockchip_emmc_phy_init,
 	.exit		= rockchip_emmc_phy_exit,
 	.power_on	= rockchip_emmc_phy_power_on,
 	.power_off	= rockchip_emmc_phy_power_off,
+	.calibrate	= rockchip_emmc_phy_calibrate,
 	.owner		= THIS_MODULE,
 };
 
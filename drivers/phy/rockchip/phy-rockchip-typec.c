@@ -862,6 +862,29 @@ static int tcphy_cfg_usb3_to_usb2_only(struct rockchip_typec_phy *tcphy,
 	return 0;
 }
 
+/*
+ * Hand the two USB3 lanes over to DP without resetting the PHY. In USB3
+ * mode both PLLs were configured by tcphy_phy_init(), so the DP PLL is
+ * already locked and only the lanes and the lane mux need to change. The
+ * USB3 controller is moved to USB2 first, as it is in DP only mode.
+ */
+static void tcphy_switch_to_dp_only(struct rockchip_typec_phy *tcphy)
+{
+	tcphy_cfg_usb3_to_usb2_only(tcphy, true);
+
+	writel(DP_MODE_ENTER_A2, tcphy->base + DP_MODE_CTL);
+
+	if (tcphy->flip) {
+		tcphy_dp_cfg_lane(tcphy, 3);
+		tcphy_dp_cfg_lane(tcphy, 2);
+	} else {
+		tcphy_dp_cfg_lane(tcphy, 0);
+		tcphy_dp_cfg_lane(tcphy, 1);
+	}
+
+	writel(PIN_ASSIGN_C_E, tcphy->base + PMA_LANE_CFG);
+}
+
 static int rockchip_usb3_phy_power_on(struct phy *phy)
 {
 	struct rockchip_typec_phy *tcphy = phy_get_drvdata(phy);
@@ -946,10 +969,12 @@ static int rockchip_dp_phy_power_on(struct phy *phy)
 	struct rockchip_typec_phy *tcphy = phy_get_drvdata(phy);
 	const struct rockchip_usb3phy_port_cfg *cfg = tcphy->port_cfgs;
 	int new_mode, ret = 0;
+	bool flip;
 	u32 val;
 
 	mutex_lock(&tcphy->lock);
 
+	flip = tcphy->flip;
 	new_mode = tcphy_get_mode(tcphy);
 	if (new_mode < 0) {
 		ret = new_mode;
@@ -966,9 +991,13 @@ static int rockchip_dp_phy_power_on(struct phy *phy)
 
 	/*
 	 * If the PHY has been power on, but the mode is not DP only mode,
-	 * re-init the PHY for setting all of 4 lanes to DP.
+	 * set all of 4 lanes to DP. With an unchanged orientation the lanes
+	 * can be switched in place, otherwise the PHY has to be re-inited.
 	 */
-	if (new_mode == MODE_DFP_DP && tcphy->mode != MODE_DISCONNECT) {
+	if (new_mode == MODE_DFP_DP && tcphy->mode != MODE_DISCONNECT &&
+	    tcphy->flip == flip) {
+		tcphy_switch_to_dp_only(tcphy);
+	} else if (new_mode == MODE_DFP_DP && tcphy->mode != MODE_DISCONNECT) {
 		tcphy_phy_deinit(tcphy);
 		ret = tcphy_phy_init(tcphy, new_mode);
 	} else if (tcphy->mode == MODE_DISCONNECT) {
@@ -1164,7 +1164,7 @@ static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 	struct regmap *regmap;
 	int reg, ret, mask, mux_type;
 	u8 bit;
-	u32 data, rmask, route_location, route_reg, route_val;
+	u32 data, route_location, route_reg, route_val;
 
 	ret = rockchip_verify_mux(bank, pin, mux);
 	if (ret < 0)
@@ -1173,6 +1173,13 @@ static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 	if (bank->iomux[iomux_num].type & IOMUX_GPIO_ONLY)
 		return 0;
 
+	/*
+	 * Runtime PM state changes and gpio direction changes mostly
+	 * select the mux the pin already has.
+	 */
+	if (READ_ONCE(bank->mux_cache[pin]) == mux)
+		return 0;
+
 	dev_dbg(dev, "setting mux of GPIO%d-%d to %d\n", bank->bank_num, pin, mux);
 
 	if (bank->iomux[iomux_num].type & IOMUX_SOURCE_PMU)
@@ -1209,31 +1216,29 @@ static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 				if (mux < 8) {
 					reg += 0x4000 - 0xC; /* PMU2_IOC_BASE */
 					data = (mask << (bit + 16));
-					rmask = data | (data >> 16);
 					data |= (mux & mask) << bit;
-					ret = regmap_update_bits(regmap, reg, rmask, data);
+					ret = regmap_write(regmap, reg, data);
 				} else {
 					u32 reg0 = 0;
 
 					reg0 = reg + 0x4000 - 0xC; /* PMU2_IOC_BASE */
 					data = (mask << (bit + 16));
-					rmask = data | (data >> 16);
 					data |= 8 << bit;
-					ret = regmap_update_bits(regmap, reg0, rmask, data);
+					ret = regmap_write(regmap, reg0, data);
 
 					reg0 = reg + 0x8000; /* BUS_IOC_BASE */
 					data = (mask << (bit + 16));
-					rmask = data | (data >> 16);
 					data |= mux << bit;
 					regmap = info->regmap_base;
-					ret |= regmap_update_bits(regmap, reg0, rmask, data);
+					ret |= regmap_write(regmap, reg0, data);
 				}
 			} else {
 				data = (mask << (bit + 16));
-				rmask = data | (data >> 16);
 				data |= (mux & mask) << bit;
-				ret = regmap_update_bits(regmap, reg, rmask, data);
+				ret = regmap_write(regmap, reg, data);
 			}
+			if (!ret)
+				WRITE_ONCE(bank->mux_cache[pin], mux);
 			return ret;
 		} else if (bank->bank_num > 0) {
 			reg += 0x8000; /* BUS_IOC_BASE */
@@ -1265,9 +1270,10 @@ static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 	}
 
 	data = (mask << (bit + 16));
-	rmask = data | (data >> 16);
 	data |= (mux & mask) << bit;
-	ret = regmap_update_bits(regmap, reg, rmask, data);
+	ret = regmap_write(regmap, reg, data);
+	if (!ret)
+		WRITE_ONCE(bank->mux_cache[pin], mux);
 
 	return ret;
 }
@@ -2283,7 +2289,7 @@ static int rockchip_set_drive_perpin(struct rockchip_pin_bank *bank,
 	struct device *dev = info->dev;
 	struct regmap *regmap;
 	int reg, ret, i;
-	u32 data, rmask, rmask_bits, temp;
+	u32 data, rmask_bits, temp;
 	u8 bit;
 	int drv_type = bank->drv[pin_num / 8].drv_type;
 
@@ -2342,16 +2348,14 @@ static int rockchip_set_drive_perpin(struct rockchip_pin_bank *bank,
 			data = (ret & 0x1) << 15;
 			temp = (ret >> 0x1) & 0x3;
 
-			rmask = BIT(15) | BIT(31);
 			data |= BIT(31);
-			ret = regmap_update_bits(regmap, reg, rmask, data);
+			ret = regmap_write(regmap, reg, data);
 			if (ret)
 				return ret;
 
-			rmask = 0x3 | (0x3 << 16);
 			temp |= (0x3 << 16);
 			reg += 0x4;
-			ret = regmap_update_bits(regmap, reg, rmask, temp);
+			ret = regmap_write(regmap, reg, temp);
 
 			return ret;
 		case 18 ... 21:
@@ -2378,10 +2382,9 @@ static int rockchip_set_drive_perpin(struct rockchip_pin_bank *bank,
 config:
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << rmask_bits) - 1) << (bit + 16);
-	rmask = data | (data >> 16);
 	data |= (ret << bit);
 
-	ret = regmap_update_bits(regmap, reg, rmask, data);
+	ret = regmap_write(regmap, reg, data);
 
 	return ret;
 }
@@ -2466,7 +2469,7 @@ static int rockchip_set_pull(struct rockchip_pin_bank *bank,
 	struct regmap *regmap;
 	int reg, ret, i, pull_type;
 	u8 bit;
-	u32 data, rmask;
+	u32 data;
 
 	dev_dbg(dev, "setting pull of GPIO%d-%d to %d\n", bank->bank_num, pin_num, pull);
 
@@ -2521,10 +2524,9 @@ static int rockchip_set_pull(struct rockchip_pin_bank *bank,
 
 		/* enable the write to the equivalent lower bits */
 		data = ((1 << RK3188_PULL_BITS_PER_PIN) - 1) << (bit + 16);
-		rmask = data | (data >> 16);
 		data |= (ret << bit);
 
-		ret = regmap_update_bits(regmap, reg, rmask, data);
+		ret = regmap_write(regmap, reg, data);
 		break;
 	default:
 		dev_err(dev, "unsupported pinctrl type\n");
@@ -2622,7 +2624,7 @@ static int rockchip_set_schmitt(struct rockchip_pin_bank *bank,
 	struct regmap *regmap;
 	int reg, ret;
 	u8 bit;
-	u32 data, rmask;
+	u32 data;
 
 	dev_dbg(dev, "setting input schmitt of GPIO%d-%d to %d\n",
 		bank->bank_num, pin_num, enable);
@@ -2635,16 +2637,14 @@ static int rockchip_set_schmitt(struct rockchip_pin_bank *bank,
 	switch (ctrl->type) {
 	case RK3568:
 		data = ((1 << RK3568_SCHMITT_BITS_PER_PIN) - 1) << (bit + 16);
-		rmask = data | (data >> 16);
 		data |= ((enable ? 0x2 : 0x1) << bit);
 		break;
 	default:
 		data = BIT(bit + 16) | (enable << bit);
-		rmask = BIT(bit + 16) | BIT(bit);
 		break;
 	}
 
-	return regmap_update_bits(regmap, reg, rmask, data);
+	return regmap_write(regmap, reg, data);
 }
 
 /*
@@ -3211,6 +3211,7 @@ static struct rockchip_pin_ctrl *rockchip_pinctrl_get_soc_data(
 
 		raw_spin_lock_init(&bank->slock);
 		bank->drvdata = d;
+		memset(bank->mux_cache, RK_MUX_UNKNOWN, sizeof(bank->mux_cache));
 		bank->pin_base = ctrl->nr_pins;
 		ctrl->nr_pins += bank->nr_pins;
 
@@ -3336,7 +3337,12 @@ static int __maybe_unused rockchip_pinctrl_suspend(struct device *dev)
 static int __maybe_unused rockchip_pinctrl_resume(struct device *dev)
 {
 	struct rockchip_pinctrl *info = dev_get_drvdata(dev);
-	int ret;
+	int ret, i;
+
+	/* the firmware may have touched the iomux while we were suspended */
+	for (i = 0; i < info->ctrl->nr_banks; i++)
+		memset(info->ctrl->pin_banks[i].mux_cache, RK_MUX_UNKNOWN,
+		       sizeof(info->ctrl->pin_banks[i].mux_cache));
 
 	if (info->ctrl->type == RK3288) {
 		ret = regmap_write(info->regmap_base, RK3288_GRF_GPIO6C_IOMUX,
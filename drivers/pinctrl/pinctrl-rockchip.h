@@ -310,6 +310,7 @@ struct rockchip_drv {
  * @route_mask: bits describing the routing pins of per bank
  * @deferred_output: gpio output settings to be done after gpio bank probed
  * @deferred_lock: mutex for the deferred_output shared btw gpio and pinctrl
+ * @mux_cache: last mux value written for each pin, RK_MUX_UNKNOWN if unknown
  */
 struct rockchip_pin_bank {
 	struct device			*dev;
@@ -340,8 +341,11 @@ struct rockchip_pin_bank {
 	u32				route_mask;
 	struct list_head		deferred_pins;
 	struct mutex			deferred_lock;
+	u8				mux_cache[32];
 };
 
+#define RK_MUX_UNKNOWN		0xff
+
 /**
  * struct rockchip_mux_recalced_data: represent a pin iomux data.
  * @num: bank number.
@@ -499,9 +499,22 @@ static int fan53555_regulator_register(struct fan53555_device_info *di,
 	return PTR_ERR_OR_ZERO(rdev);
 }
 
+static bool fan53555_volatile_reg(struct device *dev, unsigned int reg)
+{
+	return reg == FAN53555_MONITOR;
+}
+
+/*
+ * Cache the registers so that a DVFS voltage change is a single I2C write
+ * rather than a read-modify-write, and reading the voltage back doesn't
+ * touch the bus at all.
+ */
 static const struct regmap_config fan53555_regmap_config = {
 	.reg_bits = 8,
 	.val_bits = 8,
+	.max_register = TCS4525_COMMAND,
+	.volatile_reg = fan53555_volatile_reg,
+	.cache_type = REGCACHE_RBTREE,
 };
 
 static struct fan53555_platform_data *fan53555_parse_dt(struct device *dev,
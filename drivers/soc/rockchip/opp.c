@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Rockchip OPP table selection by leakage
+ *
+ * The static leakage of the CPU clusters and the GPU is measured at
+ * production time and stored in the efuse. Leaky parts are fast and run
+ * at a given frequency with less voltage, so a single OPP voltage table
+ * has to be made for the slowest, least leaky parts and overvolts the
+ * rest.
+ *
+ * An OPP table can describe the leakage bins with
+ *
+ *	nvmem-cells = <&cpul_leakage>;
+ *	nvmem-cell-names = "leakage";
+ *	rockchip,leakage-voltage-sel = <min max bin>, ...;
+ *
+ * where each triplet maps an inclusive range of efuse values to a bin.
+ * Users select opp-microvolt-L<bin> and opp-supported-hw bit <bin> for
+ * the bin returned here.
+ */
+
+#include <linux/device.h>
+#include <linux/export.h>
+#include <linux/nvmem-consumer.h>
+#include <linux/of.h>
+#include <linux/pm_opp.h>
+#include <linux/slab.h>
+#include <soc/rockchip/rockchip_opp.h>
+
+static int rockchip_opp_read_leakage(struct device_node *np, u32 *leakage)
+{
+	struct nvmem_cell *cell;
+	size_t len, i;
+	u8 *buf;
+
+	cell = of_nvmem_cell_get(np, "leakage");
+	if (IS_ERR(cell))
+		return PTR_ERR(cell);
+
+	buf = nvmem_cell_read(cell, &len);
+	nvmem_cell_put(cell);
+	if (IS_ERR(buf))
+		return PTR_ERR(buf);
+
+	*leakage = 0;
+	for (i = 0; i < min(len, sizeof(*leakage)); i++)
+		*leakage |= buf[i] << (8 * i);
+
+	kfree(buf);
+
+	return 0;
+}
+
+/**
+ * rockchip_opp_get_leakage_bin() - Look up the leakage bin of a device
+ * @dev: device whose operating-points-v2 table has the leakage description
+ *
+ * Must be called before the OPP table of @dev is added.
+ *
+ * Return: the bin, -ENOENT if the OPP table isn't binned or the efuse value
+ * is not in any of the bins, or another negative error code (including
+ * -EPROBE_DEFER) if the efuse couldn't be read.
+ */
+int rockchip_opp_get_leakage_bin(struct device *dev)
+{
+	struct device_node *np;
+	u32 *sel, leakage;
+	int count, i, ret;
+
+	np = dev_pm_opp_of_get_opp_desc_node(dev);
+	if (!np)
+		return -ENOENT;
+
+	count = of_property_count_u32_elems(np, "rockchip,leakage-voltage-sel");
+	if (count <= 0 || count % 3) {
+		ret = -ENOENT;
+		goto out_put;
+	}
+
+	ret = rockchip_opp_read_leakage(np, &leakage);
+	if (ret)
+		goto out_put;
+
+	sel = kcalloc(count, sizeof(*sel), GFP_KERNEL);
+	if (!sel) {
+		ret = -ENOMEM;
+		goto out_put;
+	}
+
+	ret = of_property_read_u32_array(np, "rockchip,leakage-voltage-sel",
+					 sel, count);
+	if (ret)
+		goto out_free;
+
+	ret = -ENOENT;
+	for (i = 0; i < count; i += 3) {
+		if (leakage >= sel[i] && leakage <= sel[i + 1] &&
+		    sel[i + 2] < ROCKCHIP_OPP_MAX_BINS) {
+			ret = sel[i + 2];
+			break;
+		}
+	}
+
+	dev_dbg(dev, "leakage %u, bin %d\n", leakage, ret);
+
+out_free:
+	kfree(sel);
+out_put:
+	of_node_put(np);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(rockchip_opp_get_leakage_bin);
@@ -5,9 +5,11 @@
  * Copyright (c) 2015 ROCKCHIP, Co. Ltd.
  */
 
+#include <linux/debugfs.h>
 #include <linux/io.h>
 #include <linux/iopoll.h>
 #include <linux/err.h>
+#include <linux/ktime.h>
 #include <linux/mutex.h>
 #include <linux/pm_clock.h>
 #include <linux/pm_domain.h>
@@ -16,6 +18,7 @@
 #include <linux/of_platform.h>
 #include <linux/clk.h>
 #include <linux/regmap.h>
+#include <linux/seq_file.h>
 #include <linux/mfd/syscon.h>
 #include <soc/rockchip/pm_domains.h>
 #include <dt-bindings/power/px30-power.h>
@@ -73,6 +76,9 @@ struct rockchip_pmu_info {
 #define QOS_SATURATION		0x14
 #define QOS_EXTCONTROL		0x18
 
+/* Power transition latency histogram, in power of two microseconds */
+#define LATENCY_HIST_BUCKETS	14
+
 struct rockchip_pm_domain {
 	struct generic_pm_domain genpd;
 	const struct rockchip_domain_info *info;
@@ -80,8 +86,12 @@ struct rockchip_pm_domain {
 	int num_qos;
 	struct regmap **qos_regmap;
 	u32 *qos_save_regs[MAX_QOS_REGS_NUM];
+	unsigned long *qos_dirty[MAX_QOS_REGS_NUM];
+	bool keep_qos;
 	int num_clks;
 	struct clk_bulk_data *clks;
+	unsigned long on_latency_hist[LATENCY_HIST_BUCKETS];
+	unsigned long off_latency_hist[LATENCY_HIST_BUCKETS];
 };
 
 struct rockchip_pmu {
@@ -90,9 +100,34 @@ struct rockchip_pmu {
 	const struct rockchip_pmu_info *info;
 	struct mutex mutex; /* mutex lock for pmu */
 	struct genpd_onecell_data genpd_data;
+	struct dentry *debugfs;
+	struct dentry *debugfs_qos;
 	struct generic_pm_domain *domains[];
 };
 
+/* A NoC QoS register of one master of a domain, exposed in debugfs */
+struct rockchip_qos_attr {
+	struct rockchip_pm_domain *pd;
+	int qos;
+	int reg;
+};
+
+static const u32 rockchip_qos_regs[MAX_QOS_REGS_NUM] = {
+	QOS_PRIORITY,
+	QOS_MODE,
+	QOS_BANDWIDTH,
+	QOS_SATURATION,
+	QOS_EXTCONTROL,
+};
+
+static const char * const rockchip_qos_reg_names[MAX_QOS_REGS_NUM] = {
+	"priority",
+	"mode",
+	"bandwidth",
+	"saturation",
+	"extcontrol",
+};
+
 #define to_rockchip_pd(gpd) container_of(gpd, struct rockchip_pm_domain, genpd)
 
 #define DOMAIN(_name, pwr, status, req, idle, ack, wakeup)	\
@@ -340,53 +375,44 @@ static int rockchip_pmu_set_idle_request(struct rockchip_pm_domain *pd,
 
 static int rockchip_pmu_save_qos(struct rockchip_pm_domain *pd)
 {
-	int i;
+	int i, j;
+
+	for (i = 0; i < pd->num_qos; i++)
+		for (j = 0; j < MAX_QOS_REGS_NUM; j++)
+			regmap_read(pd->qos_regmap[i], rockchip_qos_regs[j],
+				    &pd->qos_save_regs[j][i]);
 
-	for (i = 0; i < pd->num_qos; i++) {
-		regmap_read(pd->qos_regmap[i],
-			    QOS_PRIORITY,
-			    &pd->qos_save_regs[0][i]);
-		regmap_read(pd->qos_regmap[i],
-			    QOS_MODE,
-			    &pd->qos_save_regs[1][i]);
-		regmap_read(pd->qos_regmap[i],
-			    QOS_BANDWIDTH,
-			    &pd->qos_save_regs[2][i]);
-		regmap_read(pd->qos_regmap[i],
-			    QOS_SATURATION,
-			    &pd->qos_save_regs[3][i]);
-		regmap_read(pd->qos_regmap[i],
-			    QOS_EXTCONTROL,
-			    &pd->qos_save_regs[4][i]);
-	}
 	return 0;
 }
 
 static int rockchip_pmu_restore_qos(struct rockchip_pm_domain *pd)
 {
-	int i;
+	int i, j;
 
-	for (i = 0; i < pd->num_qos; i++) {
-		regmap_write(pd->qos_regmap[i],
-			     QOS_PRIORITY,
-			     pd->qos_save_regs[0][i]);
-		regmap_write(pd->qos_regmap[i],
-			     QOS_MODE,
-			     pd->qos_save_regs[1][i]);
-		regmap_write(pd->qos_regmap[i],
-			     QOS_BANDWIDTH,
-			     pd->qos_save_regs[2][i]);
-		regmap_write(pd->qos_regmap[i],
-			     QOS_SATURATION,
-			     pd->qos_save_regs[3][i]);
-		regmap_write(pd->qos_regmap[i],
-			     QOS_EXTCONTROL,
-			     pd->qos_save_regs[4][i]);
-	}
+	for (i = 0; i < pd->num_qos; i++)
+		for (j = 0; j < MAX_QOS_REGS_NUM; j++)
+			regmap_write(pd->qos_regmap[i], rockchip_qos_regs[j],
+				     pd->qos_save_regs[j][i]);
 
 	return 0;
 }
 
+/* Write back the QoS registers changed while an idle-only domain was idle */
+static void rockchip_pmu_restore_dirty_qos(struct rockchip_pm_domain *pd)
+{
+	int i, j;
+
+	for (j = 0; j < MAX_QOS_REGS_NUM; j++) {
+		if (!pd->qos_dirty[j])
+			continue;
+
+		for_each_set_bit(i, pd->qos_dirty[j], pd->num_qos)
+			regmap_write(pd->qos_regmap[i], rockchip_qos_regs[j],
+				     pd->qos_save_regs[j][i]);
+		bitmap_zero(pd->qos_dirty[j], pd->num_qos);
+	}
+}
+
 static bool rockchip_pmu_domain_is_on(struct rockchip_pm_domain *pd)
 {
 	struct rockchip_pmu *pmu = pd->pmu;
@@ -437,14 +463,50 @@ static void rockchip_do_pmu_set_power_domain(struct rockchip_pm_domain *pd,
 	}
 }
 
+static void rockchip_pd_account_latency(struct rockchip_pm_domain *pd,
+					bool power_on, ktime_t start)
+{
+	s64 us = ktime_us_delta(ktime_get(), start);
+	unsigned int bucket = min_t(unsigned int, fls64(max_t(s64, us, 0)),
+				    LATENCY_HIST_BUCKETS - 1);
+
+	if (power_on)
+		pd->on_latency_hist[bucket]++;
+	else
+		pd->off_latency_hist[bucket]++;
+}
+
+/*
+ * Whether the NoC QoS registers of a domain can lose their values, because
+ * it or one of the domains it sits in has a power switch. Only idle-only
+ * domains with idle-only parents, all the way up, are never powered off.
+ */
+static bool rockchip_pd_can_lose_qos(struct generic_pm_domain *genpd)
+{
+	struct gpd_link *link;
+
+	if (to_rockchip_pd(genpd)->info->pwr_mask)
+		return true;
+
+	list_for_each_entry(link, &genpd->child_links, child_node)
+		if (rockchip_pd_can_lose_qos(link->parent))
+			return true;
+
+	return false;
+}
+
 static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 {
 	struct rockchip_pmu *pmu = pd->pmu;
+	bool keep_qos = pd->keep_qos;
+	ktime_t start;
 	int ret;
 
 	mutex_lock(&pmu->mutex);
 
 	if (rockchip_pmu_domain_is_on(pd) != power_on) {
+		start = ktime_get();
+
 		ret = clk_bulk_enable(pd->num_clks, pd->clks);
 		if (ret < 0) {
 			dev_err(pmu->dev, "failed to enable clocks\n");
@@ -453,7 +515,8 @@ static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 		}
 
 		if (!power_on) {
-			rockchip_pmu_save_qos(pd);
+			if (!keep_qos)
+				rockchip_pmu_save_qos(pd);
 
 			/* if powering down, idle request to NIU first */
 			rockchip_pmu_set_idle_request(pd, true);
@@ -465,10 +528,15 @@ static int rockchip_pd_power(struct rockchip_pm_domain *pd, bool power_on)
 			/* if powering up, leave idle mode */
 			rockchip_pmu_set_idle_request(pd, false);
 
-			rockchip_pmu_restore_qos(pd);
+			if (!keep_qos)
+				rockchip_pmu_restore_qos(pd);
+			else
+				rockchip_pmu_restore_dirty_qos(pd);
 		}
 
 		clk_bulk_disable(pd->num_clks, pd->clks);
+
+		rockchip_pd_account_latency(pd, power_on, start);
 	}
 
 	mutex_unlock(&pmu->mutex);
@@ -489,6 +557,136 @@ static int rockchip_pd_power_off(struct generic_pm_domain *domain)
 	return rockchip_pd_power(pd, false);
 }
 
+static int rockchip_pd_latency_show(struct seq_file *s, void *data)
+{
+	struct rockchip_pm_domain *pd = s->private;
+	int i;
+
+	seq_printf(s, "%-14s %10s %10s\n", "usecs", "on", "off");
+
+	for (i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+		char range[16];
+
+		if (!i)
+			snprintf(range, sizeof(range), "0");
+		else if (i == LATENCY_HIST_BUCKETS - 1)
+			snprintf(range, sizeof(range), "%lu+", BIT(i - 1));
+		else
+			snprintf(range, sizeof(range), "%lu-%lu",
+				 BIT(i - 1), BIT(i) - 1);
+
+		seq_printf(s, "%-14s %10lu %10lu\n", range,
+			   pd->on_latency_hist[i], pd->off_latency_hist[i]);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(rockchip_pd_latency);
+
+/*
+ * The QoS registers can only be accessed while the domain is powered and
+ * its clocks are running. While it is off, the saved copy is used instead,
+ * and written to the hardware when the domain is powered on again. The
+ * saved copy is kept up to date on every access, as idle-only domains do
+ * not save their registers when they go idle.
+ */
+static int rockchip_qos_get(void *data, u64 *val)
+{
+	struct rockchip_qos_attr *attr = data;
+	struct rockchip_pm_domain *pd = attr->pd;
+	u32 value;
+	int ret;
+
+	mutex_lock(&pd->pmu->mutex);
+
+	value = pd->qos_save_regs[attr->reg][attr->qos];
+
+	if (rockchip_pmu_domain_is_on(pd)) {
+		ret = clk_bulk_enable(pd->num_clks, pd->clks);
+		if (ret < 0)
+			goto out_unlock;
+
+		regmap_read(pd->qos_regmap[attr->qos],
+			    rockchip_qos_regs[attr->reg], &value);
+		pd->qos_save_regs[attr->reg][attr->qos] = value;
+
+		clk_bulk_disable(pd->num_clks, pd->clks);
+	}
+
+	*val = value;
+	ret = 0;
+
+out_unlock:
+	mutex_unlock(&pd->pmu->mutex);
+	return ret;
+}
+
+static int rockchip_qos_set(void *data, u64 val)
+{
+	struct rockchip_qos_attr *attr = data;
+	struct rockchip_pm_domain *pd = attr->pd;
+	int ret = 0;
+
+	if (val > U32_MAX)
+		return -EINVAL;
+
+	mutex_lock(&pd->pmu->mutex);
+
+	pd->qos_save_regs[attr->reg][attr->qos] = val;
+
+	if (rockchip_pmu_domain_is_on(pd)) {
+		ret = clk_bulk_enable(pd->num_clks, pd->clks);
+		if (ret < 0)
+			goto out_unlock;
+
+		regmap_write(pd->qos_regmap[attr->qos],
+			     rockchip_qos_regs[attr->reg], val);
+
+		clk_bulk_disable(pd->num_clks, pd->clks);
+	} else if (pd->keep_qos) {
+		set_bit(attr->qos, pd->qos_dirty[attr->reg]);
+	}
+
+out_unlock:
+	mutex_unlock(&pd->pmu->mutex);
+	return ret;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(rockchip_qos_fops, rockchip_qos_get,
+			 rockchip_qos_set, "0x%08llx\n");
+
+static int rockchip_pd_qos_debugfs_init(struct rockchip_pm_domain *pd,
+					int qos, struct device_node *qos_node)
+{
+	struct rockchip_pmu *pmu = pd->pmu;
+	struct rockchip_qos_attr *attrs;
+	struct dentry *dir;
+	int j;
+
+	attrs = devm_kcalloc(pmu->dev, MAX_QOS_REGS_NUM, sizeof(*attrs),
+			     GFP_KERNEL);
+	if (!attrs)
+		return -ENOMEM;
+
+	dir = debugfs_create_dir(kbasename(qos_node->full_name),
+				 pmu->debugfs_qos);
+
+	for (j = 0; j < MAX_QOS_REGS_NUM; j++) {
+		attrs[j].pd = pd;
+		attrs[j].qos = qos;
+		attrs[j].reg = j;
+		debugfs_create_file_unsafe(rockchip_qos_reg_names[j], 0644,
+					   dir, &attrs[j], &rockchip_qos_fops);
+	}
+
+	return 0;
+}
+
+static void rockchip_pd_free_states(struct genpd_power_state *states,
+				    unsigned int state_count)
+{
+	kfree(states);
+}
+
 static int rockchip_pd_attach_dev(struct generic_pm_domain *genpd,
 				  struct device *dev)
 {
@@ -532,8 +730,9 @@ static int rockchip_pm_add_one_domain(struct rockchip_pmu *pmu,
 {
 	const struct rockchip_domain_info *pd_info;
 	struct rockchip_pm_domain *pd;
+	struct genpd_power_state *states;
 	struct device_node *qos_node;
-	int i, j;
+	int i, j, state_count;
 	u32 id;
 	int error;
 
@@ -616,6 +815,17 @@ static int rockchip_pm_add_one_domain(struct rockchip_pmu *pmu,
 				error = -ENOMEM;
 				goto err_unprepare_clocks;
 			}
+
+			if (pd->info->pwr_mask)
+				continue;
+
+			pd->qos_dirty[j] = devm_bitmap_zalloc(pmu->dev,
+							      pd->num_qos,
+							      GFP_KERNEL);
+			if (!pd->qos_dirty[j]) {
+				error = -ENOMEM;
+				goto err_unprepare_clocks;
+			}
 		}
 
 		for (j = 0; j < pd->num_qos; j++) {
@@ -630,7 +840,10 @@ static int rockchip_pm_add_one_domain(struct rockchip_pmu *pmu,
 				of_node_put(qos_node);
 				goto err_unprepare_clocks;
 			}
+			error = rockchip_pd_qos_debugfs_init(pd, j, qos_node);
 			of_node_put(qos_node);
+			if (error)
+				goto err_unprepare_clocks;
 		}
 	}
 
@@ -645,7 +858,28 @@ static int rockchip_pm_add_one_domain(struct rockchip_pmu *pmu,
 	pd->genpd.flags = GENPD_FLAG_PM_CLK;
 	if (pd_info->active_wakeup)
 		pd->genpd.flags |= GENPD_FLAG_ACTIVE_WAKEUP;
-	pm_genpd_init(&pd->genpd, NULL, !rockchip_pmu_domain_is_on(pd));
+
+	/*
+	 * Domains that describe their power off/on latencies and minimum
+	 * residency in "domain-idle-states" get the QoS governor, so that
+	 * they are only powered off when the device latency constraints and
+	 * the next wakeup allow it.
+	 */
+	error = of_genpd_parse_idle_states(node, &states, &state_count);
+	if (error)
+		goto err_unprepare_clocks;
+
+	if (state_count) {
+		pd->genpd.states = states;
+		pd->genpd.state_count = state_count;
+		pd->genpd.free_states = rockchip_pd_free_states;
+	}
+
+	pm_genpd_init(&pd->genpd, state_count ? &simple_qos_governor : NULL,
+		      !rockchip_pmu_domain_is_on(pd));
+
+	debugfs_create_file(pd->genpd.name, 0444, pmu->debugfs, pd,
+			    &rockchip_pd_latency_fops);
 
 	pmu->genpd_data.domains[id] = &pd->genpd;
 	return 0;
@@ -695,6 +929,8 @@ static void rockchip_pm_domain_cleanup(struct rockchip_pmu *pmu)
 		}
 	}
 
+	debugfs_remove_recursive(pmu->debugfs);
+
 	/* devm will free our memory */
 }
 
@@ -772,7 +1008,7 @@ static int rockchip_pm_domain_probe(struct platform_device *pdev)
 	struct rockchip_pmu *pmu;
 	const struct of_device_id *match;
 	const struct rockchip_pmu_info *pmu_info;
-	int error;
+	int error, i;
 
 	if (!np) {
 		dev_err(dev, "device tree node not found\n");
@@ -824,6 +1060,9 @@ static int rockchip_pm_domain_probe(struct platform_device *pdev)
 		rockchip_configure_pd_cnt(pmu, pmu_info->gpu_pwrcnt_offset,
 					pmu_info->gpu_power_transition_time);
 
+	pmu->debugfs = debugfs_create_dir(dev_name(dev), NULL);
+	pmu->debugfs_qos = debugfs_create_dir("qos", pmu->debugfs);
+
 	error = -ENODEV;
 
 	/*
@@ -855,6 +1094,21 @@ static int rockchip_pm_domain_probe(struct platform_device *pdev)
 		goto err_out;
 	}
 
+	/*
+	 * Domains that are never powered off keep their QoS registers and
+	 * needn't save and restore them, except for debugfs changes made
+	 * while the domain was idle. Only known once all subdomains are in.
+	 */
+	for (i = 0; i < pmu->genpd_data.num_domains; i++) {
+		struct rockchip_pm_domain *pd;
+
+		if (!pmu->genpd_data.domains[i])
+			continue;
+
+		pd = to_rockchip_pd(pmu->genpd_data.domains[i]);
+		pd->keep_qos = !rockchip_pd_can_lose_qos(&pd->genpd);
+	}
+
 	error = of_genpd_add_provider_onecell(np, &pmu->genpd_data);
 	if (error) {
 		dev_err(dev, "failed to add provider: %d\n", error);
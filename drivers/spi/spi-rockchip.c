@@ -4,6 +4,7 @@
  * Author: Addy Ke <addy.ke@rock-chips.com>
  */
 
+#include <linux/average.h>
 #include <linux/clk.h>
 #include <linux/dmaengine.h>
 #include <linux/interrupt.h>
@@ -167,6 +168,17 @@
 
 #define ROCKCHIP_AUTOSUSPEND_TIMEOUT		2000
 
+/*
+ * Initial and max cost of a DMA transfer over the time it spends on the
+ * wire, in ns. Transfers that are over on the wire sooner than that are
+ * cheaper to do in PIO. The actual cost is measured on DMA transfers and
+ * averaged, starting from the initial value.
+ */
+#define ROCKCHIP_SPI_DMA_COST_NS		20000
+#define ROCKCHIP_SPI_DMA_COST_MAX_NS		200000
+
+DECLARE_EWMA(dma_cost, 0, 8)
+
 struct rockchip_spi {
 	struct device *dev;
 
@@ -199,6 +211,18 @@ struct rockchip_spi {
 	bool cs_high_supported; /* native CS supports active-high polarity */
 
 	struct spi_transfer *xfer; /* Store xfer temporarily */
+
+	/* Last slave config set on the DMA channels, 0 if none yet */
+	u32 rx_dma_burst;
+	u8 rx_dma_width;
+	u8 tx_dma_width;
+
+	/* Measured DMA cost, and its value for the current message */
+	struct ewma_dma_cost dma_cost;
+	u32 dma_cost_ns;
+	/* Start and wire time of the running DMA transfer */
+	ktime_t dma_start;
+	u64 dma_wire_ns;
 };
 
 static inline void spi_enable_chip(struct rockchip_spi *rs, bool enable)
@@ -397,6 +421,22 @@ static int rockchip_spi_prepare_irq(struct rockchip_spi *rs,
 	return 1;
 }
 
+static u64 rockchip_spi_wire_ns(struct spi_transfer *xfer,
+				unsigned int bytes_per_word)
+{
+	return div_u64((u64)(xfer->len / bytes_per_word) *
+		       xfer->bits_per_word * NSEC_PER_SEC, xfer->speed_hz);
+}
+
+static void rockchip_spi_dma_account(struct rockchip_spi *rs)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), rs->dma_start));
+
+	ns = ns > rs->dma_wire_ns ? ns - rs->dma_wire_ns : 0;
+	ewma_dma_cost_add(&rs->dma_cost,
+			  min_t(u64, ns, ROCKCHIP_SPI_DMA_COST_MAX_NS));
+}
+
 static void rockchip_spi_dma_rxcb(void *data)
 {
 	struct spi_controller *ctlr = data;
@@ -409,6 +449,9 @@ static void rockchip_spi_dma_rxcb(void *data)
 	if (rs->cs_inactive)
 		writel_relaxed(0, rs->regs + ROCKCHIP_SPI_IMR);
 
+	if (!ctlr->slave && !rs->slave_abort)
+		rockchip_spi_dma_account(rs);
+
 	spi_enable_chip(rs, false);
 	spi_finalize_current_transfer(ctlr);
 }
@@ -425,6 +468,9 @@ static void rockchip_spi_dma_txcb(void *data)
 	/* Wait until the FIFO data completely. */
 	wait_for_tx_idle(rs, ctlr->slave);
 
+	if (!ctlr->slave && !rs->slave_abort)
+		rockchip_spi_dma_account(rs);
+
 	spi_enable_chip(rs, false);
 	spi_finalize_current_transfer(ctlr);
 }
@@ -454,14 +500,21 @@ static int rockchip_spi_prepare_dma(struct rockchip_spi *rs,
 
 	rxdesc = NULL;
 	if (xfer->rx_buf) {
-		struct dma_slave_config rxconf = {
-			.direction = DMA_DEV_TO_MEM,
-			.src_addr = rs->dma_addr_rx,
-			.src_addr_width = rs->n_bytes,
-			.src_maxburst = rockchip_spi_calc_burst_size(xfer->len / rs->n_bytes),
-		};
-
-		dmaengine_slave_config(ctlr->dma_rx, &rxconf);
+		u32 burst = rockchip_spi_calc_burst_size(xfer->len / rs->n_bytes);
+
+		/* the channel keeps its config, only redo it when it changes */
+		if (burst != rs->rx_dma_burst || rs->n_bytes != rs->rx_dma_width) {
+			struct dma_slave_config rxconf = {
+				.direction = DMA_DEV_TO_MEM,
+				.src_addr = rs->dma_addr_rx,
+				.src_addr_width = rs->n_bytes,
+				.src_maxburst = burst,
+			};
+
+			dmaengine_slave_config(ctlr->dma_rx, &rxconf);
+			rs->rx_dma_burst = burst;
+			rs->rx_dma_width = rs->n_bytes;
+		}
 
 		rxdesc = dmaengine_prep_slave_sg(
 				ctlr->dma_rx,
@@ -476,14 +529,17 @@ static int rockchip_spi_prepare_dma(struct rockchip_spi *rs,
 
 	txdesc = NULL;
 	if (xfer->tx_buf) {
-		struct dma_slave_config txconf = {
-			.direction = DMA_MEM_TO_DEV,
-			.dst_addr = rs->dma_addr_tx,
-			.dst_addr_width = rs->n_bytes,
-			.dst_maxburst = rs->fifo_len / 4,
-		};
-
-		dmaengine_slave_config(ctlr->dma_tx, &txconf);
+		if (rs->n_bytes != rs->tx_dma_width) {
+			struct dma_slave_config txconf = {
+				.direction = DMA_MEM_TO_DEV,
+				.dst_addr = rs->dma_addr_tx,
+				.dst_addr_width = rs->n_bytes,
+				.dst_maxburst = rs->fifo_len / 4,
+			};
+
+			dmaengine_slave_config(ctlr->dma_tx, &txconf);
+			rs->tx_dma_width = rs->n_bytes;
+		}
 
 		txdesc = dmaengine_prep_slave_sg(
 				ctlr->dma_tx,
@@ -499,6 +555,9 @@ static int rockchip_spi_prepare_dma(struct rockchip_spi *rs,
 		txdesc->callback_param = ctlr;
 	}
 
+	rs->dma_start = ktime_get();
+	rs->dma_wire_ns = rockchip_spi_wire_ns(xfer, rs->n_bytes);
+
 	/* rx must be started before tx due to spi instinct */
 	if (rxdesc) {
 		atomic_or(RXDMA, &rs->state);
@@ -716,7 +775,29 @@ static bool rockchip_spi_can_dma(struct spi_controller *ctlr,
 	 * length we can just fill the fifo and wait for a single irq,
 	 * so don't bother setting up dma
 	 */
-	return xfer->len / bytes_per_word >= rs->fifo_len;
+	if (xfer->len / bytes_per_word < rs->fifo_len)
+		return false;
+
+	/* in slave mode the wire speed is up to the master */
+	if (ctlr->slave || !xfer->speed_hz)
+		return true;
+
+	/* past that, use dma once pio would keep the cpu busy for longer */
+	return rockchip_spi_wire_ns(xfer, bytes_per_word) >= rs->dma_cost_ns;
+}
+
+static int rockchip_spi_prepare_message(struct spi_controller *ctlr,
+					struct spi_message *msg)
+{
+	struct rockchip_spi *rs = spi_controller_get_devdata(ctlr);
+
+	/*
+	 * The core calls can_dma() again when unmapping the message, so
+	 * the cost it goes by has to stay the same until then.
+	 */
+	rs->dma_cost_ns = ewma_dma_cost_read(&rs->dma_cost);
+
+	return 0;
 }
 
 static int rockchip_spi_setup(struct spi_device *spi)
@@ -905,6 +986,11 @@ static int rockchip_spi_probe(struct platform_device *pdev)
 		rs->dma_addr_tx = mem->start + ROCKCHIP_SPI_TXDR;
 		rs->dma_addr_rx = mem->start + ROCKCHIP_SPI_RXDR;
 		ctlr->can_dma = rockchip_spi_can_dma;
+		ctlr->prepare_message = rockchip_spi_prepare_message;
+
+		ewma_dma_cost_init(&rs->dma_cost);
+		ewma_dma_cost_add(&rs->dma_cost, ROCKCHIP_SPI_DMA_COST_NS);
+		rs->dma_cost_ns = ROCKCHIP_SPI_DMA_COST_NS;
 	}
 
 	switch (readl_relaxed(rs->regs + ROCKCHIP_SPI_VERSION)) {
@@ -88,7 +88,7 @@ struct chip_tsadc_table {
  * @tshut_mode: the hardware-controlled shutdown mode (0:CRU 1:GPIO)
  * @tshut_polarity: the hardware-controlled active polarity (0:LOW 1:HIGH)
  * @initialize: SoC special initialize tsadc controller method
- * @irq_ack: clear the interrupt
+ * @irq_ack: clear the interrupt, returns the pending interrupt status
  * @control: enable/disable method for the tsadc controller
  * @get_temp: get the temperature
  * @set_alarm_temp: set the high temperature interrupt
@@ -109,7 +109,7 @@ struct rockchip_tsadc_chip {
 	/* Chip-wide methods */
 	void (*initialize)(struct regmap *grf,
 			   void __iomem *reg, enum tshut_polarity p);
-	void (*irq_ack)(void __iomem *reg);
+	u32 (*irq_ack)(void __iomem *reg);
 	void (*control)(void __iomem *reg, bool on);
 
 	/* Per-sensor methods */
@@ -793,20 +793,24 @@ static void rk_tsadcv7_initialize(struct regmap *grf, void __iomem *regs,
 	}
 }
 
-static void rk_tsadcv2_irq_ack(void __iomem *regs)
+static u32 rk_tsadcv2_irq_ack(void __iomem *regs)
 {
 	u32 val;
 
 	val = readl_relaxed(regs + TSADCV2_INT_PD);
 	writel_relaxed(val & TSADCV2_INT_PD_CLEAR_MASK, regs + TSADCV2_INT_PD);
+
+	return val;
 }
 
-static void rk_tsadcv3_irq_ack(void __iomem *regs)
+static u32 rk_tsadcv3_irq_ack(void __iomem *regs)
 {
 	u32 val;
 
 	val = readl_relaxed(regs + TSADCV2_INT_PD);
 	writel_relaxed(val & TSADCV3_INT_PD_CLEAR_MASK, regs + TSADCV2_INT_PD);
+
+	return val;
 }
 
 static void rk_tsadcv2_control(void __iomem *regs, bool enable)
@@ -1198,15 +1202,30 @@ rockchip_thermal_toggle_sensor(struct rockchip_thermal_sensor *sensor, bool on)
 static irqreturn_t rockchip_thermal_alarm_irq_thread(int irq, void *dev)
 {
 	struct rockchip_thermal_data *thermal = dev;
+	u32 pending, alarm = 0;
 	int i;
 
-	dev_dbg(&thermal->pdev->dev, "thermal alarm\n");
+	pending = thermal->chip->irq_ack(thermal->regs);
 
-	thermal->chip->irq_ack(thermal->regs);
+	dev_dbg(&thermal->pdev->dev, "thermal alarm 0x%x\n", pending);
 
 	for (i = 0; i < thermal->chip->chn_num; i++)
-		thermal_zone_device_update(thermal->sensors[i].tzd,
+		alarm |= pending & TSADCV2_INT_SRC_EN(thermal->sensors[i].id);
+
+	/*
+	 * Only update the zones whose high temperature alarm fired, so that
+	 * their governors run right away rather than after every other zone
+	 * has been read. Fall back to all zones if no channel is flagged.
+	 */
+	for (i = 0; i < thermal->chip->chn_num; i++) {
+		struct rockchip_thermal_sensor *sensor = &thermal->sensors[i];
+
+		if (alarm && !(alarm & TSADCV2_INT_SRC_EN(sensor->id)))
+			continue;
+
+		thermal_zone_device_update(sensor->tzd,
 					   THERMAL_EVENT_UNSPECIFIED);
+	}
 
 	return IRQ_HANDLED;
 }
@@ -74,6 +74,15 @@ static void dma_rx_complete(void *param)
 	spin_lock_irqsave(&p->port.lock, flags);
 	if (dma->rx_running)
 		__dma_rx_complete(p);
+
+	/*
+	 * The buffer filled up while data is still streaming in. Re-arm now
+	 * instead of waiting for the next Rx interrupt, at high baud rates
+	 * the FIFO would overrun in that window. __dma_rx_complete() clears
+	 * rx_running, so this cannot be folded into the check above.
+	 */
+	if (!dma->rx_running && (serial_lsr_in(p) & UART_LSR_DR))
+		p->dma->rx_dma(p);
 	spin_unlock_irqrestore(&p->port.lock, flags);
 }
 
@@ -1467,6 +1467,7 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 	u8			tx_thr_num_pkt_prd = 0;
 	u8			tx_max_burst_prd = 0;
 	u8			tx_fifo_resize_max_num;
+	u32			imod_interval_ns = 0;
 	const char		*usb_psy_name;
 	int			ret;
 
@@ -1582,6 +1583,9 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 				"snps,xhci-slow-suspend-quirk");
 	dwc->xhci_trb_ent_quirk = device_property_read_bool(dev,
 				"snps,xhci-trb-ent-quirk");
+	/* passed on to the xHCI as "imod-max-interval-ns", 0 disables it */
+	device_property_read_u32(dev, "snps,xhci-imod-max-interval-ns",
+				 &dwc->xhci_imod_max);
 
 	dwc->tx_de_emphasis_quirk = device_property_read_bool(dev,
 				"snps,tx_de_emphasis_quirk");
@@ -1599,6 +1603,9 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 
 	dwc->dis_split_quirk = device_property_read_bool(dev,
 				"snps,dis-split-quirk");
+	/* device mode DEV_IMOD interval, 0 (the default) keeps it off */
+	device_property_read_u32(dev, "snps,imod-interval-ns",
+				 &imod_interval_ns);
 
 	dwc->lpm_nyet_threshold = lpm_nyet_threshold;
 	dwc->tx_de_emphasis = tx_de_emphasis;
@@ -1611,7 +1618,9 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 	dwc->tx_thr_num_pkt_prd = tx_thr_num_pkt_prd;
 	dwc->tx_max_burst_prd = tx_max_burst_prd;
 
-	dwc->imod_interval = 0;
+	/* in 250ns increments */
+	dwc->imod_interval = min_t(u32, DIV_ROUND_UP(imod_interval_ns, 250),
+				   DWC3_DEV_IMOD_INTERVAL_MASK);
 
 	dwc->tx_fifo_resize_max_num = tx_fifo_resize_max_num;
 }
@@ -1105,6 +1105,8 @@ struct dwc3_scratchpad_array {
  * @xhci_trb_ent_quirk: set if need to enable the Evaluate Next TRB(ENT)
  *			flag in the TRB data structure to force xHC to
  *			pre-fetch the next TRB of a TD.
+ * @xhci_imod_max: upper bound in ns up to which the xHC may stretch its
+ *			interrupt moderation under load, or 0 to keep it fixed.
  * @tx_de_emphasis_quirk: set if we enable Tx de-emphasis quirk
  * @tx_de_emphasis: Tx de-emphasis value
  *	0	- -6dB de-emphasis
@@ -1325,6 +1327,7 @@ struct dwc3 {
 	unsigned		gfladj_refclk_lpm_sel:1;
 	unsigned		xhci_slow_suspend_quirk:1;
 	unsigned		xhci_trb_ent_quirk:1;
+	u32			xhci_imod_max;
 
 	unsigned		tx_de_emphasis_quirk:1;
 	unsigned		tx_de_emphasis:2;
@@ -66,7 +66,7 @@ static int dwc3_host_get_irq(struct dwc3 *dwc)
 
 int dwc3_host_init(struct dwc3 *dwc)
 {
-	struct property_entry	props[5];
+	struct property_entry	props[7];
 	struct platform_device	*xhci;
 	int			ret, irq;
 	u32			cpu_id;
@@ -115,6 +115,10 @@ int dwc3_host_init(struct dwc3 *dwc)
 	if (dwc->xhci_trb_ent_quirk)
 		props[prop_idx++] = PROPERTY_ENTRY_BOOL("xhci-trb-ent-quirk");
 
+	if (dwc->xhci_imod_max)
+		props[prop_idx++] = PROPERTY_ENTRY_U32("imod-max-interval-ns",
+						       dwc->xhci_imod_max);
+
 	/**
 	 * WORKAROUND: dwc3 revisions <=3.00a have a limitation
 	 * where Port Disable command doesn't work.
@@ -309,6 +309,13 @@ static int xhci_plat_probe(struct platform_device *pdev)
 
 		device_property_read_u32(tmpdev, "imod-interval-ns",
 					 &xhci->imod_interval);
+
+		/*
+		 * Optional ceiling for adaptive moderation, in ns. 0 (the
+		 * default) keeps imod-interval-ns fixed.
+		 */
+		device_property_read_u32(tmpdev, "imod-max-interval-ns",
+					 &xhci->imod_max);
 	}
 
 	hcd->usb_phy = devm_usb_get_phy_by_phandle(sysdev, "usb-phy", 0);
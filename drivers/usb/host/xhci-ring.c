@@ -3018,6 +3018,38 @@ static void xhci_update_erst_dequeue(struct xhci_hcd *xhci,
 	xhci_write_64(xhci, temp_64, &xhci->ir_set->erst_dequeue);
 }
 
+/*
+ * Adaptive interrupt moderation: when imod_max is set, scale the interval
+ * between imod_interval and imod_max depending on how many events each
+ * interrupt had to service, so bulk streams take fewer interrupts while a
+ * mostly idle bus keeps its latency.
+ */
+#define IMOD_ADAPT_EVENTS_HIGH	32
+#define IMOD_ADAPT_EVENTS_LOW	4
+
+static void xhci_adapt_imod(struct xhci_hcd *xhci, int events)
+{
+	u32 imod = xhci->imod_cur;
+	u32 temp;
+
+	if (!xhci->imod_max || xhci->imod_max <= xhci->imod_interval)
+		return;
+
+	if (events >= IMOD_ADAPT_EVENTS_HIGH)
+		imod = min(max(imod * 2, 250U), xhci->imod_max);
+	else if (events <= IMOD_ADAPT_EVENTS_LOW)
+		imod = max(imod / 2, xhci->imod_interval);
+
+	if (imod == xhci->imod_cur)
+		return;
+
+	xhci->imod_cur = imod;
+	temp = readl(&xhci->ir_set->irq_control);
+	temp &= ~ER_IRQ_INTERVAL_MASK;
+	temp |= (imod / 250) & ER_IRQ_INTERVAL_MASK;
+	writel(temp, &xhci->ir_set->irq_control);
+}
+
 /*
  * xHCI spec says we can get an interrupt, and if the HC has an error condition,
  * we might get bad data out of the event ring.  Section 4.10.2.7 has a list of
@@ -3031,6 +3063,7 @@ irqreturn_t xhci_irq(struct usb_hcd *hcd)
 	u64 temp_64;
 	u32 status;
 	int event_loop = 0;
+	int event_count = 0;
 
 	spin_lock(&xhci->lock);
 	/* Check if the xHC generated the interrupt, or the irq is shared */
@@ -3085,6 +3118,7 @@ irqreturn_t xhci_irq(struct usb_hcd *hcd)
 	 * that clears the EHB.
 	 */
 	while (xhci_handle_event(xhci) > 0) {
+		event_count++;
 		if (event_loop++ < TRBS_PER_SEGMENT / 2)
 			continue;
 		xhci_update_erst_dequeue(xhci, event_ring_deq);
@@ -3098,6 +3132,7 @@ irqreturn_t xhci_irq(struct usb_hcd *hcd)
 	}
 
 	xhci_update_erst_dequeue(xhci, event_ring_deq);
+	xhci_adapt_imod(xhci, event_count);
 	ret = IRQ_HANDLED;
 
 out:
@@ -3320,6 +3355,32 @@ static unsigned int count_sg_trbs_needed(struct urb *urb)
 	return num_trbs;
 }
 
+/*
+ * Merge the run of DMA-contiguous sg entries starting at *sgp into a single
+ * block, so a transfer built from adjacent pages is queued with as few TRBs
+ * as the 64KB boundary rule allows. *sgp is left on the last merged entry.
+ */
+static unsigned int xhci_sg_block_len(struct scatterlist **sgp,
+				      unsigned int *num_sgs)
+{
+	struct scatterlist *sg = *sgp, *next;
+	unsigned int len = sg_dma_len(sg);
+	dma_addr_t end = sg_dma_address(sg) + len;
+
+	while (*num_sgs > 1) {
+		next = sg_next(sg);
+		if (!next || sg_dma_address(next) != end)
+			break;
+		len += sg_dma_len(next);
+		end += sg_dma_len(next);
+		sg = next;
+		--*num_sgs;
+	}
+
+	*sgp = sg;
+	return len;
+}
+
 static unsigned int count_isoc_trbs_needed(struct urb *urb, int i)
 {
 	u64 addr, len;
@@ -3551,7 +3612,7 @@ int xhci_queue_bulk_tx(struct xhci_hcd *xhci, gfp_t mem_flags,
 		num_sgs = urb->num_mapped_sgs;
 		sg = urb->sg;
 		addr = (u64) sg_dma_address(sg);
-		block_len = sg_dma_len(sg);
+		block_len = xhci_sg_block_len(&sg, &num_sgs);
 		num_trbs = count_sg_trbs_needed(urb);
 	} else {
 		num_trbs = count_trbs_needed(urb);
@@ -3673,8 +3734,8 @@ int xhci_queue_bulk_tx(struct xhci_hcd *xhci, gfp_t mem_flags,
 			sent_len -= block_len;
 			sg = sg_next(sg);
 			if (num_sgs != 0 && sg) {
-				block_len = sg_dma_len(sg);
 				addr = (u64) sg_dma_address(sg);
+				block_len = xhci_sg_block_len(&sg, &num_sgs);
 				addr += sent_len;
 			}
 		}
@@ -695,6 +695,7 @@ int xhci_run(struct usb_hcd *hcd)
 	temp &= ~ER_IRQ_INTERVAL_MASK;
 	temp |= (xhci->imod_interval / 250) & ER_IRQ_INTERVAL_MASK;
 	writel(temp, &xhci->ir_set->irq_control);
+	xhci->imod_cur = xhci->imod_interval;
 
 	if (xhci->quirks & XHCI_NEC_HOST) {
 		struct xhci_command *command;
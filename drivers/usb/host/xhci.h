@@ -1783,6 +1783,9 @@ struct xhci_hcd {
 	u8		isoc_threshold;
 	/* imod_interval in ns (I * 250ns) */
 	u32		imod_interval;
+	/* upper bound for adaptive moderation, 0 keeps imod_interval fixed */
+	u32		imod_max;
+	u32		imod_cur;
 	u32		isoc_bei_interval;
 	int		event_ring_max;
 	/* 4KB min, 128MB max */
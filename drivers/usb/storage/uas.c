@@ -9,6 +9,7 @@
  */
 
 #include <linux/blkdev.h>
+#include <linux/dma-mapping.h>
 #include <linux/slab.h>
 #include <linux/types.h>
 #include <linux/module.h>
@@ -835,6 +836,18 @@ static int uas_slave_alloc(struct scsi_device *sdev)
 		blk_queue_max_hw_sectors(sdev->request_queue, 64);
 	else if (devinfo->flags & US_FL_MAX_SECTORS_240)
 		blk_queue_max_hw_sectors(sdev->request_queue, 240);
+	else if (devinfo->udev->speed >= USB_SPEED_SUPER)
+		blk_queue_max_hw_sectors(sdev->request_queue, 2048);
+
+	/*
+	 * USB3 devices get the same 2048 sector limit usb-storage uses, but
+	 * never more than the host controller can map at once, otherwise
+	 * swiotlb setups would fail the mapping.
+	 */
+	blk_queue_max_hw_sectors(sdev->request_queue,
+		min_t(size_t, queue_max_hw_sectors(sdev->request_queue),
+		      dma_max_mapping_size(devinfo->udev->bus->sysdev) >>
+		      SECTOR_SHIFT));
 
 	return 0;
 }
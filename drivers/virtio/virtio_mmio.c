@@ -88,7 +88,7 @@ struct virtio_mmio_device {
 	void __iomem *base;
 	unsigned long version;
 
-	/* a list of queues so we can dispatch IRQs */
+	/* a list of queues with a callback so we can dispatch IRQs */
 	spinlock_t lock;
 	struct list_head virtqueues;
 };
@@ -449,9 +449,18 @@ static struct virtqueue *vm_setup_vq(struct virtio_device *vdev, unsigned int in
 	vq->priv = info;
 	info->vq = vq;
 
-	spin_lock_irqsave(&vm_dev->lock, flags);
-	list_add(&info->node, &vm_dev->virtqueues);
-	spin_unlock_irqrestore(&vm_dev->lock, flags);
+	/*
+	 * Queues without a callback are polled by their driver and run with
+	 * interrupts suppressed, so keep them out of the interrupt handler's
+	 * way. With a single interrupt line shared by all queues this avoids
+	 * checking every polled ring on every completion interrupt.
+	 */
+	INIT_LIST_HEAD(&info->node);
+	if (callback) {
+		spin_lock_irqsave(&vm_dev->lock, flags);
+		list_add(&info->node, &vm_dev->virtqueues);
+		spin_unlock_irqrestore(&vm_dev->lock, flags);
+	}
 
 	return vq;
 
@@ -133,6 +133,14 @@ struct vring_virtqueue_packed {
 	/* Index of the next avail descriptor. */
 	u16 next_avail_idx;
 
+	/*
+	 * Head of the first buffer added in the current batch, which is made
+	 * available when the batch ends.
+	 */
+	bool batch_pending;
+	u16 batch_head;
+	__le16 batch_head_flags;
+
 	/*
 	 * Last written value to driver->flags in
 	 * guest byte order.
@@ -177,6 +185,9 @@ struct vring_virtqueue {
 	/* Number we've added since last sync. */
 	unsigned int num_added;
 
+	/* Between virtqueue_add_batch_start() and virtqueue_add_batch_end(). */
+	bool add_batch;
+
 	/* Last used index  we've seen.
 	 * for split ring, it just contains last used index
 	 * for packed ring:
@@ -514,6 +525,15 @@ static inline unsigned int virtqueue_add_desc_split(struct virtqueue *vq,
 	return next;
 }
 
+static void virtqueue_publish_split(struct vring_virtqueue *vq)
+{
+	/* Descriptors and available array need to be set before we expose the
+	 * new available array entries. */
+	virtio_wmb(vq->weak_barriers);
+	vq->split.vring.avail->idx = cpu_to_virtio16(vq->vq.vdev,
+						vq->split.avail_idx_shadow);
+}
+
 static inline int virtqueue_add_split(struct virtqueue *_vq,
 				      struct scatterlist *sgs[],
 				      unsigned int total_sg,
@@ -654,12 +674,10 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 	avail = vq->split.avail_idx_shadow & (vq->split.vring.num - 1);
 	vq->split.vring.avail->ring[avail] = cpu_to_virtio16(_vq->vdev, head);
 
-	/* Descriptors and available array need to be set before we expose the
-	 * new available array entries. */
-	virtio_wmb(vq->weak_barriers);
+	/* Inside a batch avail->idx is only updated when the batch ends. */
 	vq->split.avail_idx_shadow++;
-	vq->split.vring.avail->idx = cpu_to_virtio16(_vq->vdev,
-						vq->split.avail_idx_shadow);
+	if (!vq->add_batch)
+		virtqueue_publish_split(vq);
 	vq->num_added++;
 
 	pr_debug("Added buffer head %i to %p\n", head, vq);
@@ -667,8 +685,11 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 
 	/* This is very unlikely, but theoretically possible.  Kick
 	 * just in case. */
-	if (unlikely(vq->num_added == (1 << 16) - 1))
+	if (unlikely(vq->num_added == (1 << 16) - 1)) {
+		if (vq->add_batch)
+			virtqueue_publish_split(vq);
 		virtqueue_kick(_vq);
+	}
 
 	return 0;
 
@@ -784,30 +805,14 @@ static inline bool more_used_split(const struct vring_virtqueue *vq)
 			vq->split.vring.used->idx);
 }
 
-static void *virtqueue_get_buf_ctx_split(struct virtqueue *_vq,
-					 unsigned int *len,
-					 void **ctx)
+/* Detach the next used buffer, the caller has checked that there is one. */
+static void *detach_used_split(struct vring_virtqueue *vq, unsigned int *len,
+			       void **ctx)
 {
-	struct vring_virtqueue *vq = to_vvq(_vq);
-	void *ret;
+	struct virtqueue *_vq = &vq->vq;
 	unsigned int i;
 	u16 last_used;
-
-	START_USE(vq);
-
-	if (unlikely(vq->broken)) {
-		END_USE(vq);
-		return NULL;
-	}
-
-	if (!more_used_split(vq)) {
-		pr_debug("No more buffers in queue\n");
-		END_USE(vq);
-		return NULL;
-	}
-
-	/* Only get used array entries after they have been exposed by host. */
-	virtio_rmb(vq->weak_barriers);
+	void *ret;
 
 	last_used = (vq->last_used_idx & (vq->split.vring.num - 1));
 	i = virtio32_to_cpu(_vq->vdev,
@@ -828,13 +833,49 @@ static void *virtqueue_get_buf_ctx_split(struct virtqueue *_vq,
 	ret = vq->split.desc_state[i].data;
 	detach_buf_split(vq, i, ctx);
 	vq->last_used_idx++;
+
+	return ret;
+}
+
+static void update_used_event_split(struct vring_virtqueue *vq)
+{
 	/* If we expect an interrupt for the next entry, tell host
 	 * by writing event index and flush out the write before
 	 * the read in the next get_buf call. */
 	if (!(vq->split.avail_flags_shadow & VRING_AVAIL_F_NO_INTERRUPT))
 		virtio_store_mb(vq->weak_barriers,
 				&vring_used_event(&vq->split.vring),
-				cpu_to_virtio16(_vq->vdev, vq->last_used_idx));
+				cpu_to_virtio16(vq->vq.vdev, vq->last_used_idx));
+}
+
+static void *virtqueue_get_buf_ctx_split(struct virtqueue *_vq,
+					 unsigned int *len,
+					 void **ctx)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+	void *ret;
+
+	START_USE(vq);
+
+	if (unlikely(vq->broken)) {
+		END_USE(vq);
+		return NULL;
+	}
+
+	if (!more_used_split(vq)) {
+		pr_debug("No more buffers in queue\n");
+		END_USE(vq);
+		return NULL;
+	}
+
+	/* Only get used array entries after they have been exposed by host. */
+	virtio_rmb(vq->weak_barriers);
+
+	ret = detach_used_split(vq, len, ctx);
+	if (unlikely(!ret))
+		return NULL;
+
+	update_used_event_split(vq);
 
 	LAST_ADD_TIME_INVALID(vq);
 
@@ -842,6 +883,45 @@ static void *virtqueue_get_buf_ctx_split(struct virtqueue *_vq,
 	return ret;
 }
 
+static unsigned int virtqueue_get_bufs_split(struct virtqueue *_vq,
+					     void **bufs, unsigned int *lens,
+					     unsigned int num)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+	unsigned int n;
+	u16 used;
+
+	START_USE(vq);
+
+	if (unlikely(vq->broken)) {
+		END_USE(vq);
+		return 0;
+	}
+
+	used = virtio16_to_cpu(_vq->vdev, vq->split.vring.used->idx);
+	num = min_t(unsigned int, num, (u16)(used - vq->last_used_idx));
+	if (!num) {
+		END_USE(vq);
+		return 0;
+	}
+
+	/* One barrier covers all the entries exposed by this used->idx. */
+	virtio_rmb(vq->weak_barriers);
+
+	for (n = 0; n < num; n++) {
+		bufs[n] = detach_used_split(vq, &lens[n], NULL);
+		if (unlikely(!bufs[n]))
+			return n;
+	}
+
+	update_used_event_split(vq);
+
+	LAST_ADD_TIME_INVALID(vq);
+
+	END_USE(vq);
+	return n;
+}
+
 static void virtqueue_disable_cb_split(struct virtqueue *_vq)
 {
 	struct vring_virtqueue *vq = to_vvq(_vq);
@@ -1235,6 +1315,35 @@ static struct vring_packed_desc *alloc_indirect_packed(unsigned int total_sg,
 	return desc;
 }
 
+/*
+ * Make the buffer starting at @head available. Within a batch only the head of
+ * the first buffer needs to be ordered after the descriptors: the device walks
+ * the ring in order, so it can't get to the later buffers before that head has
+ * been written by virtqueue_add_batch_end().
+ */
+static void virtqueue_publish_packed(struct vring_virtqueue *vq, u16 head,
+				     __le16 head_flags)
+{
+	if (vq->add_batch) {
+		if (!vq->packed.batch_pending) {
+			vq->packed.batch_pending = true;
+			vq->packed.batch_head = head;
+			vq->packed.batch_head_flags = head_flags;
+		} else {
+			vq->packed.vring.desc[head].flags = head_flags;
+		}
+		return;
+	}
+
+	/*
+	 * A driver MUST NOT make the first descriptor in the list
+	 * available before all subsequent descriptors comprising
+	 * the list are made available.
+	 */
+	virtio_wmb(vq->weak_barriers);
+	vq->packed.vring.desc[head].flags = head_flags;
+}
+
 static int virtqueue_add_indirect_packed(struct vring_virtqueue *vq,
 					 struct scatterlist *sgs[],
 					 unsigned int total_sg,
@@ -1300,14 +1409,9 @@ static int virtqueue_add_indirect_packed(struct vring_virtqueue *vq,
 						  vq->packed.avail_used_flags;
 	}
 
-	/*
-	 * A driver MUST NOT make the first descriptor in the list
-	 * available before all subsequent descriptors comprising
-	 * the list are made available.
-	 */
-	virtio_wmb(vq->weak_barriers);
-	vq->packed.vring.desc[head].flags = cpu_to_le16(VRING_DESC_F_INDIRECT |
-						vq->packed.avail_used_flags);
+	virtqueue_publish_packed(vq, head,
+				 cpu_to_le16(VRING_DESC_F_INDIRECT |
+					     vq->packed.avail_used_flags));
 
 	/* We're using some buffers from the free list. */
 	vq->vq.num_free -= 1;
@@ -1465,13 +1569,7 @@ static inline int virtqueue_add_packed(struct virtqueue *_vq,
 	vq->packed.desc_state[id].indir_desc = ctx;
 	vq->packed.desc_state[id].last = prev;
 
-	/*
-	 * A driver MUST NOT make the first descriptor in the list
-	 * available before all subsequent descriptors comprising
-	 * the list are made available.
-	 */
-	virtio_wmb(vq->weak_barriers);
-	vq->packed.vring.desc[head].flags = head_flags;
+	virtqueue_publish_packed(vq, head, head_flags);
 	vq->num_added += descs_used;
 
 	pr_debug("Added buffer head %i to %p\n", head, vq);
@@ -1620,31 +1718,14 @@ static inline bool more_used_packed(const struct vring_virtqueue *vq)
 	return is_used_desc_packed(vq, last_used, used_wrap_counter);
 }
 
-static void *virtqueue_get_buf_ctx_packed(struct virtqueue *_vq,
-					  unsigned int *len,
-					  void **ctx)
+/* Detach the next used buffer, the caller has checked that there is one. */
+static void *detach_used_packed(struct vring_virtqueue *vq, unsigned int *len,
+				void **ctx)
 {
-	struct vring_virtqueue *vq = to_vvq(_vq);
 	u16 last_used, id, last_used_idx;
 	bool used_wrap_counter;
 	void *ret;
 
-	START_USE(vq);
-
-	if (unlikely(vq->broken)) {
-		END_USE(vq);
-		return NULL;
-	}
-
-	if (!more_used_packed(vq)) {
-		pr_debug("No more buffers in queue\n");
-		END_USE(vq);
-		return NULL;
-	}
-
-	/* Only get used elements after they have been exposed by host. */
-	virtio_rmb(vq->weak_barriers);
-
 	last_used_idx = READ_ONCE(vq->last_used_idx);
 	used_wrap_counter = packed_used_wrap_counter(last_used_idx);
 	last_used = packed_last_used(last_used_idx);
@@ -1673,6 +1754,11 @@ static void *virtqueue_get_buf_ctx_packed(struct virtqueue *_vq,
 	last_used = (last_used | (used_wrap_counter << VRING_PACKED_EVENT_F_WRAP_CTR));
 	WRITE_ONCE(vq->last_used_idx, last_used);
 
+	return ret;
+}
+
+static void update_used_event_packed(struct vring_virtqueue *vq)
+{
 	/*
 	 * If we expect an interrupt for the next entry, tell host
 	 * by writing event index and flush out the write before
@@ -1682,6 +1768,36 @@ static void *virtqueue_get_buf_ctx_packed(struct virtqueue *_vq,
 		virtio_store_mb(vq->weak_barriers,
 				&vq->packed.vring.driver->off_wrap,
 				cpu_to_le16(vq->last_used_idx));
+}
+
+static void *virtqueue_get_buf_ctx_packed(struct virtqueue *_vq,
+					  unsigned int *len,
+					  void **ctx)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+	void *ret;
+
+	START_USE(vq);
+
+	if (unlikely(vq->broken)) {
+		END_USE(vq);
+		return NULL;
+	}
+
+	if (!more_used_packed(vq)) {
+		pr_debug("No more buffers in queue\n");
+		END_USE(vq);
+		return NULL;
+	}
+
+	/* Only get used elements after they have been exposed by host. */
+	virtio_rmb(vq->weak_barriers);
+
+	ret = detach_used_packed(vq, len, ctx);
+	if (unlikely(!ret))
+		return NULL;
+
+	update_used_event_packed(vq);
 
 	LAST_ADD_TIME_INVALID(vq);
 
@@ -1689,6 +1805,42 @@ static void *virtqueue_get_buf_ctx_packed(struct virtqueue *_vq,
 	return ret;
 }
 
+static unsigned int virtqueue_get_bufs_packed(struct virtqueue *_vq,
+					      void **bufs, unsigned int *lens,
+					      unsigned int num)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+	unsigned int n;
+
+	START_USE(vq);
+
+	if (unlikely(vq->broken)) {
+		END_USE(vq);
+		return 0;
+	}
+
+	/*
+	 * Each used descriptor is published by its own flags and the position
+	 * of the next one depends on the id in this one, so every buffer needs
+	 * its read barrier. The event index is only written once though.
+	 */
+	for (n = 0; n < num && more_used_packed(vq); n++) {
+		virtio_rmb(vq->weak_barriers);
+
+		bufs[n] = detach_used_packed(vq, &lens[n], NULL);
+		if (unlikely(!bufs[n]))
+			return n;
+	}
+
+	if (n) {
+		update_used_event_packed(vq);
+		LAST_ADD_TIME_INVALID(vq);
+	}
+
+	END_USE(vq);
+	return n;
+}
+
 static void virtqueue_disable_cb_packed(struct virtqueue *_vq)
 {
 	struct vring_virtqueue *vq = to_vvq(_vq);
@@ -2216,6 +2368,53 @@ int virtqueue_add_inbuf_ctx(struct virtqueue *vq,
 }
 EXPORT_SYMBOL_GPL(virtqueue_add_inbuf_ctx);
 
+/**
+ * virtqueue_add_batch_start - start adding a batch of buffers
+ * @_vq: the struct virtqueue we're talking about.
+ *
+ * Buffers added with virtqueue_add_*() until virtqueue_add_batch_end() are
+ * made available to the device together, with a single write barrier.
+ *
+ * Caller must ensure we don't call this with other virtqueue operations
+ * at the same time (except where noted).
+ */
+void virtqueue_add_batch_start(struct virtqueue *_vq)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+
+	vq->add_batch = true;
+}
+EXPORT_SYMBOL_GPL(virtqueue_add_batch_start);
+
+/**
+ * virtqueue_add_batch_end - make a batch of buffers available
+ * @_vq: the struct virtqueue we're talking about.
+ *
+ * Exposes the buffers added since virtqueue_add_batch_start() to the device.
+ * This must be called before virtqueue_kick_prepare() or virtqueue_kick().
+ *
+ * Caller must ensure we don't call this with other virtqueue operations
+ * at the same time (except where noted).
+ */
+void virtqueue_add_batch_end(struct virtqueue *_vq)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+
+	vq->add_batch = false;
+
+	if (!vq->packed_ring) {
+		virtqueue_publish_split(vq);
+		return;
+	}
+
+	if (vq->packed.batch_pending) {
+		vq->packed.batch_pending = false;
+		virtqueue_publish_packed(vq, vq->packed.batch_head,
+					 vq->packed.batch_head_flags);
+	}
+}
+EXPORT_SYMBOL_GPL(virtqueue_add_batch_end);
+
 /**
  * virtqueue_kick_prepare - first half of split virtqueue_kick call.
  * @_vq: the struct virtqueue
@@ -2312,6 +2511,32 @@ void *virtqueue_get_buf(struct virtqueue *_vq, unsigned int *len)
 	return virtqueue_get_buf_ctx(_vq, len, NULL);
 }
 EXPORT_SYMBOL_GPL(virtqueue_get_buf);
+
+/**
+ * virtqueue_get_bufs - get several used buffers
+ * @_vq: the struct virtqueue we're talking about.
+ * @bufs: array receiving the "data" tokens of the used buffers
+ * @lens: array receiving the lengths written into the buffers
+ * @num: size of @bufs and @lens
+ *
+ * Like calling virtqueue_get_buf() up to @num times, but with one barrier
+ * for all the buffers on split rings and a single event index update.
+ * The token contexts are not returned.
+ *
+ * Caller must ensure we don't call this with other virtqueue
+ * operations at the same time (except where noted).
+ *
+ * Returns the number of buffers returned in @bufs.
+ */
+unsigned int virtqueue_get_bufs(struct virtqueue *_vq, void **bufs,
+				unsigned int *lens, unsigned int num)
+{
+	struct vring_virtqueue *vq = to_vvq(_vq);
+
+	return vq->packed_ring ? virtqueue_get_bufs_packed(_vq, bufs, lens, num) :
+				 virtqueue_get_bufs_split(_vq, bufs, lens, num);
+}
+EXPORT_SYMBOL_GPL(virtqueue_get_bufs);
 /**
  * virtqueue_disable_cb - disable callbacks
  * @_vq: the struct virtqueue we're talking about.
@@ -216,6 +216,106 @@ static int erofs_fscache_read_folios_async(struct fscache_cookie *cookie,
 	return ret;
 }
 
+/*
+ * Make sure the range (@pstart, @len) of the cache file is populated without
+ * reading anything into the page cache. Each hole in the range goes to the
+ * on-demand daemon as a single read request covering all of it.
+ */
+static int erofs_fscache_prefetch_range(struct fscache_cookie *cookie,
+					loff_t pstart, size_t len)
+{
+	struct netfs_io_request rreq = {};
+	struct netfs_io_subrequest subreq = { .rreq = &rreq };
+	struct netfs_cache_resources *cres = &rreq.cache_resources;
+	enum netfs_io_source source;
+	size_t done = 0;
+	int ret;
+
+	ret = fscache_begin_read_operation(cres, cookie);
+	if (ret)
+		return ret;
+
+	while (done < len) {
+		subreq.start = pstart + done;
+		subreq.len = len - done;
+		subreq.flags = 1 << NETFS_SREQ_ONDEMAND;
+
+		source = cres->ops->prepare_read(&subreq, LLONG_MAX);
+		if (source != NETFS_READ_FROM_CACHE || !subreq.len) {
+			ret = -EIO;
+			break;
+		}
+		done += subreq.len;
+	}
+
+	cres->ops->end_operation(cres);
+	return ret;
+}
+
+/*
+ * Fetch the data of the file @nid in (@pos, @len) into the cache, e.g. for
+ * the files an image manifest lists as needed at startup.
+ */
+int erofs_fscache_prefetch(struct super_block *sb, erofs_nid_t nid,
+			   erofs_off_t pos, u64 len)
+{
+	struct inode *inode;
+	erofs_off_t end;
+	int ret = 0;
+
+	inode = erofs_iget(sb, nid);
+	if (IS_ERR(inode))
+		return PTR_ERR(inode);
+
+	if (!S_ISREG(inode->i_mode) ||
+	    erofs_inode_is_data_compressed(EROFS_I(inode)->datalayout)) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	if (check_add_overflow(pos, len, &end))
+		end = U64_MAX;
+	end = min_t(erofs_off_t, end, i_size_read(inode));
+
+	while (pos < end) {
+		struct erofs_map_blocks map = { .m_la = pos };
+		struct erofs_map_dev mdev;
+		u64 count;
+
+		ret = erofs_map_blocks(inode, &map, EROFS_GET_BLOCKS_RAW);
+		if (ret)
+			break;
+
+		if (pos - map.m_la >= map.m_llen) {
+			ret = -EFSCORRUPTED;
+			break;
+		}
+		count = min(map.m_llen - (pos - map.m_la), end - pos);
+
+		/* inline tails are read along with the metadata */
+		if ((map.m_flags & EROFS_MAP_MAPPED) &&
+		    !(map.m_flags & EROFS_MAP_META)) {
+			mdev = (struct erofs_map_dev) {
+				.m_deviceid = map.m_deviceid,
+				.m_pa = map.m_pa,
+			};
+			ret = erofs_map_dev(sb, &mdev);
+			if (ret)
+				break;
+
+			ret = erofs_fscache_prefetch_range(mdev.m_fscache->cookie,
+					mdev.m_pa + (pos - map.m_la), count);
+			if (ret)
+				break;
+		}
+		pos += count;
+		cond_resched();
+	}
+out:
+	iput(inode);
+	return ret;
+}
+
 static int erofs_fscache_meta_read_folio(struct file *data, struct folio *folio)
 {
 	int ret;
@@ -265,7 +365,7 @@ static int erofs_fscache_data_read(struct address_space *mapping,
 	struct erofs_map_blocks map;
 	struct erofs_map_dev mdev;
 	struct iov_iter iter;
-	size_t count;
+	size_t count, ra;
 	int ret;
 
 	*unlock = true;
@@ -318,6 +418,17 @@ static int erofs_fscache_data_read(struct address_space *mapping,
 	if (ret)
 		return ret;
 
+	/*
+	 * Small reads would each become a round trip to the on-demand daemon,
+	 * so ask it for the data up to fscache_ra_kb ahead in one go first.
+	 * Failing that is fine, the read below asks again for what it needs.
+	 */
+	ra = min_t(u64, (u64)EROFS_SB(sb)->opt.fscache_ra_kb << 10,
+		   map.m_llen - (pos - map.m_la));
+	if (ra > count)
+		erofs_fscache_prefetch_range(mdev.m_fscache->cookie,
+				mdev.m_pa + (pos - map.m_la), ra);
+
 	rreq = erofs_fscache_alloc_request(mapping, pos, count);
 	if (IS_ERR(rreq))
 		return PTR_ERR(rreq);
@@ -73,6 +73,16 @@ struct erofs_mount_opts {
 
 	/* threshold for decompression synchronously */
 	unsigned int max_sync_decompress_pages;
+
+	/* spread the pclusters of one read over erofs_unzipd workers */
+	bool parallel_decompress;
+
+	/* upper bound of the managed cache in KiB (0 - unlimited) */
+	unsigned int max_cached_kb;
+#endif
+#ifdef CONFIG_EROFS_FS_ONDEMAND
+	/* on-demand requests of data reads are grown to this size (0 - off) */
+	unsigned int fscache_ra_kb;
 #endif
 	unsigned int mount_opt;
 };
@@ -132,6 +142,10 @@ struct erofs_sb_info {
 
 	struct erofs_sb_lz4_info lz4;
 	struct inode *packed_inode;
+
+	/* pclusters decompressed by the reading context / handed to workers */
+	atomic_t pcl_inline;
+	atomic_t pcl_offloaded;
 #endif	/* CONFIG_EROFS_FS_ZIP */
 	struct erofs_dev_context *devs;
 	struct dax_device *dax_dev;
@@ -166,6 +180,7 @@ struct erofs_sb_info {
 	/* sysfs support */
 	struct kobject s_kobj;		/* /sys/fs/erofs/<devname> */
 	struct completion s_kobj_unregister;
+	struct super_block *sb;
 
 	/* fscache support */
 	struct fscache_volume *volume;
@@ -620,6 +635,8 @@ struct erofs_fscache *erofs_fscache_register_cookie(struct super_block *sb,
 						    char *name,
 						    unsigned int flags);
 void erofs_fscache_unregister_cookie(struct erofs_fscache *fscache);
+int erofs_fscache_prefetch(struct super_block *sb, erofs_nid_t nid,
+			   erofs_off_t pos, u64 len);
 
 extern const struct address_space_operations erofs_fscache_access_aops;
 #else
@@ -640,6 +657,13 @@ struct erofs_fscache *erofs_fscache_register_cookie(struct super_block *sb,
 static inline void erofs_fscache_unregister_cookie(struct erofs_fscache *fscache)
 {
 }
+
+static inline int erofs_fscache_prefetch(struct super_block *sb,
+					 erofs_nid_t nid, erofs_off_t pos,
+					 u64 len)
+{
+	return -EOPNOTSUPP;
+}
 #endif
 
 #define EFSCORRUPTED    EUCLEAN         /* Filesystem is corrupted */
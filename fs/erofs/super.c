@@ -429,6 +429,9 @@ static void erofs_default_options(struct erofs_fs_context *ctx)
 	ctx->opt.max_sync_decompress_pages = 3;
 	ctx->opt.sync_decompress = EROFS_SYNC_DECOMPRESS_AUTO;
 #endif
+#ifdef CONFIG_EROFS_FS_ONDEMAND
+	ctx->opt.fscache_ra_kb = 1024;
+#endif
 #ifdef CONFIG_EROFS_FS_XATTR
 	set_opt(&ctx->opt, XATTR_USER);
 #endif
@@ -716,6 +719,7 @@ static int erofs_fc_fill_super(struct super_block *sb, struct fs_context *fc)
 		return -ENOMEM;
 
 	sb->s_fs_info = sbi;
+	sbi->sb = sb;
 	sbi->opt = ctx->opt;
 	sbi->devs = ctx->devs;
 	ctx->devs = NULL;
@@ -12,6 +12,8 @@ enum {
 	attr_feature,
 	attr_pointer_ui,
 	attr_pointer_bool,
+	attr_pointer_atomic,
+	attr_prefetch,
 };
 
 enum {
@@ -53,15 +55,34 @@ static struct erofs_attr erofs_attr_##_name = {			\
 #define EROFS_ATTR_RW_BOOL(_name, _struct)	\
 	EROFS_ATTR_RW(_name, pointer_bool, _struct)
 
+#define EROFS_ATTR_RO_ATOMIC(_name, _struct)	\
+	EROFS_RO_ATTR(_name, pointer_atomic, _struct)
+
 #define ATTR_LIST(name) (&erofs_attr_##name.attr)
 
 #ifdef CONFIG_EROFS_FS_ZIP
 EROFS_ATTR_RW_UI(sync_decompress, erofs_mount_opts);
+EROFS_ATTR_RW_BOOL(parallel_decompress, erofs_mount_opts);
+EROFS_ATTR_RW_UI(max_cached_kb, erofs_mount_opts);
+EROFS_ATTR_RO_ATOMIC(pcl_inline, erofs_sb_info);
+EROFS_ATTR_RO_ATOMIC(pcl_offloaded, erofs_sb_info);
+#endif
+#ifdef CONFIG_EROFS_FS_ONDEMAND
+EROFS_ATTR_RW_UI(fscache_ra_kb, erofs_mount_opts);
+EROFS_ATTR_FUNC(prefetch, 0200);
 #endif
 
 static struct attribute *erofs_attrs[] = {
 #ifdef CONFIG_EROFS_FS_ZIP
 	ATTR_LIST(sync_decompress),
+	ATTR_LIST(parallel_decompress),
+	ATTR_LIST(max_cached_kb),
+	ATTR_LIST(pcl_inline),
+	ATTR_LIST(pcl_offloaded),
+#endif
+#ifdef CONFIG_EROFS_FS_ONDEMAND
+	ATTR_LIST(fscache_ra_kb),
+	ATTR_LIST(prefetch),
 #endif
 	NULL,
 };
@@ -123,10 +144,40 @@ static ssize_t erofs_attr_show(struct kobject *kobj,
 		if (!ptr)
 			return 0;
 		return sysfs_emit(buf, "%d\n", *(bool *)ptr);
+	case attr_pointer_atomic:
+		if (!ptr)
+			return 0;
+		return sysfs_emit(buf, "%u\n",
+				  (unsigned int)atomic_read((atomic_t *)ptr));
 	}
 	return 0;
 }
 
+/*
+ * Each line written to "prefetch" is "<nid> <offset> <length>" of a range of
+ * a file to fetch into the cache ahead of its first read.
+ */
+static ssize_t erofs_prefetch_store(struct erofs_sb_info *sbi,
+				    const char *buf, size_t len)
+{
+	const char *p = buf;
+	u64 nid, pos, size;
+	int n, ret;
+
+	if (!erofs_is_fscache_mode(sbi->sb))
+		return -EOPNOTSUPP;
+
+	while (*(p = skip_spaces(p))) {
+		if (sscanf(p, "%llu %llu %llu%n", &nid, &pos, &size, &n) != 3)
+			return -EINVAL;
+		ret = erofs_fscache_prefetch(sbi->sb, nid, pos, size);
+		if (ret)
+			return ret;
+		p += n;
+	}
+	return len;
+}
+
 static ssize_t erofs_attr_store(struct kobject *kobj, struct attribute *attr,
 						const char *buf, size_t len)
 {
@@ -163,6 +214,8 @@ static ssize_t erofs_attr_store(struct kobject *kobj, struct attribute *attr,
 			return -EINVAL;
 		*(bool *)ptr = !!t;
 		return len;
+	case attr_prefetch:
+		return erofs_prefetch_store(sbi, buf, len);
 	}
 	return 0;
 }
@@ -353,7 +353,7 @@ static inline int z_erofs_init_workqueue(void)
 	 * scheduling overhead, perhaps per-CPU threads should be better?
 	 */
 	z_erofs_workqueue = alloc_workqueue("erofs_unzipd",
-					    WQ_UNBOUND | WQ_HIGHPRI,
+					    WQ_UNBOUND | WQ_HIGHPRI | WQ_SYSFS,
 					    onlinecpus + onlinecpus / 4);
 	return z_erofs_workqueue ? 0 : -ENOMEM;
 }
@@ -422,11 +422,21 @@ struct z_erofs_decompress_frontend {
 
 static bool z_erofs_should_alloc_cache(struct z_erofs_decompress_frontend *fe)
 {
-	unsigned int cachestrategy = EROFS_I_SB(fe->inode)->opt.cache_strategy;
+	struct erofs_sb_info *const sbi = EROFS_I_SB(fe->inode);
+	unsigned int cachestrategy = sbi->opt.cache_strategy;
+	unsigned int max_cached_kb = READ_ONCE(sbi->opt.max_cached_kb);
 
 	if (cachestrategy <= EROFS_ZIP_CACHE_DISABLED)
 		return false;
 
+	/*
+	 * Once the managed cache is full, use in-place I/O for new pclusters
+	 * and leave the pages already cached to the page LRU.
+	 */
+	if (max_cached_kb && (MNGD_MAPPING(sbi)->nrpages <<
+			      (PAGE_SHIFT - 10)) >= max_cached_kb)
+		return false;
+
 	if (fe->backmost)
 		return true;
 
@@ -464,7 +474,9 @@ static void z_erofs_bind_cache(struct z_erofs_decompress_frontend *fe,
 		if (READ_ONCE(pcl->compressed_bvecs[i].page))
 			continue;
 
-		page = find_get_page(mc, pcl->obj.index + i);
+		/* mark it accessed so that hot pclusters stay cached */
+		page = find_get_page_flags(mc, pcl->obj.index + i,
+					   FGP_ACCESSED);
 
 		if (page) {
 			t = (void *)((unsigned long)page | 1);
@@ -1237,9 +1249,57 @@ static int z_erofs_decompress_pcluster(struct z_erofs_decompress_backend *be,
 	return err;
 }
 
+struct z_erofs_pcluster_work {
+	struct work_struct work;
+	struct super_block *sb;
+	struct z_erofs_pcluster *pcl;
+	bool eio;
+};
+
+static void z_erofs_pcluster_workfn(struct work_struct *work)
+{
+	struct z_erofs_pcluster_work *pw =
+		container_of(work, struct z_erofs_pcluster_work, work);
+	struct page *pagepool = NULL;
+	struct z_erofs_decompress_backend be = {
+		.sb = pw->sb,
+		.pcl = pw->pcl,
+		.pagepool = &pagepool,
+		.decompressed_secondary_bvecs =
+			LIST_HEAD_INIT(be.decompressed_secondary_bvecs),
+	};
+
+	z_erofs_decompress_pcluster(&be, pw->eio ? -EIO : 0);
+	erofs_workgroup_put(&be.pcl->obj);
+	erofs_release_pages(&pagepool);
+	kfree(pw);
+}
+
+/*
+ * Pclusters of one queue are independent of each other, so hand them out to
+ * erofs_unzipd instead of decompressing them one after another here.
+ */
+static bool z_erofs_offload_pcluster(const struct z_erofs_decompressqueue *io,
+				     struct z_erofs_pcluster *pcl)
+{
+	struct z_erofs_pcluster_work *pw;
+
+	pw = kmalloc(sizeof(*pw), GFP_NOIO | __GFP_NOWARN);
+	if (!pw)
+		return false;
+
+	INIT_WORK(&pw->work, z_erofs_pcluster_workfn);
+	pw->sb = io->sb;
+	pw->pcl = pcl;
+	pw->eio = io->eio;
+	queue_work(z_erofs_workqueue, &pw->work);
+	return true;
+}
+
 static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 				     struct page **pagepool)
 {
+	struct erofs_sb_info *const sbi = EROFS_SB(io->sb);
 	struct z_erofs_decompress_backend be = {
 		.sb = io->sb,
 		.pagepool = pagepool,
@@ -1254,6 +1314,15 @@ static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
 		be.pcl = container_of(owned, struct z_erofs_pcluster, next);
 		owned = READ_ONCE(be.pcl->next);
 
+		/* always keep the last pcluster for the current context */
+		if (sbi->opt.parallel_decompress &&
+		    owned != Z_EROFS_PCLUSTER_TAIL &&
+		    z_erofs_offload_pcluster(io, be.pcl)) {
+			atomic_inc(&sbi->pcl_offloaded);
+			continue;
+		}
+		atomic_inc(&sbi->pcl_inline);
+
 		z_erofs_decompress_pcluster(&be, io->eio ? -EIO : 0);
 		erofs_workgroup_put(&be.pcl->obj);
 	}
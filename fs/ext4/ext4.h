@@ -1760,6 +1760,9 @@ struct ext4_sb_info {
 	spinlock_t s_fc_lock;
 	struct buffer_head *s_fc_bh;
 	struct ext4_fc_stats s_fc_stats;
+	unsigned int s_fc_max_batch_time;	/* usecs, 0 disables batching */
+	pid_t s_fc_last_sync_writer;
+	ktime_t s_fc_last_commit_end;
 	tid_t s_fc_ineligible_tid;
 #ifdef CONFIG_EXT4_DEBUG
 	int s_fc_debug_max_replay;
@@ -1902,6 +1905,7 @@ enum {
 	EXT4_STATE_VERITY_IN_PROGRESS,	/* building fs-verity Merkle tree */
 	EXT4_STATE_FC_COMMITTING,	/* Fast commit ongoing */
 	EXT4_STATE_ORPHAN_FILE,		/* Inode orphaned in orphan file */
+	EXT4_STATE_ES_REFERENCED,	/* extent cache hit since last shrink */
 };
 
 #define EXT4_INODE_BIT_FNS(name, field, offset)				\
@@ -961,6 +961,8 @@ int ext4_es_lookup_extent(struct inode *inode, ext4_lblk_t lblk,
 		es->es_pblk = es1->es_pblk;
 		if (!ext4_es_is_referenced(es1))
 			ext4_es_set_referenced(es1);
+		if (!ext4_test_inode_state(inode, EXT4_STATE_ES_REFERENCED))
+			ext4_set_inode_state(inode, EXT4_STATE_ES_REFERENCED);
 		percpu_counter_inc(&stats->es_stats_cache_hits);
 		if (next_lblk) {
 			node = rb_next(&es1->rb_node);
@@ -1490,12 +1492,25 @@ static int __es_shrink(struct ext4_sb_info *sbi, int nr_to_scan,
 		 * Normally we try hard to avoid shrinking precached inodes,
 		 * but we will as a last resort.
 		 */
-		if (!retried && ext4_test_inode_state(&ei->vfs_inode,
+		if (retried < 2 && ext4_test_inode_state(&ei->vfs_inode,
 						EXT4_STATE_EXT_PRECACHED)) {
 			nr_skipped++;
 			continue;
 		}
 
+		/*
+		 * The same second chance the referenced bit gives extents,
+		 * at inode granularity: skip inodes that had cache hits since
+		 * the last scan so that cold inodes are reclaimed first.
+		 */
+		if (!retried && ext4_test_inode_state(&ei->vfs_inode,
+						EXT4_STATE_ES_REFERENCED)) {
+			ext4_clear_inode_state(&ei->vfs_inode,
+					       EXT4_STATE_ES_REFERENCED);
+			nr_skipped++;
+			continue;
+		}
+
 		if (ei == locked_ei || !write_trylock(&ei->i_es_lock)) {
 			nr_skipped++;
 			continue;
@@ -1517,9 +1532,10 @@ static int __es_shrink(struct ext4_sb_info *sbi, int nr_to_scan,
 
 	/*
 	 * If we skipped any inodes, and we weren't able to make any
-	 * forward progress, try again to scan precached inodes.
+	 * forward progress, try again including recently referenced
+	 * inodes, and then precached ones.
 	 */
-	if ((nr_shrunk == 0) && nr_skipped && !retried) {
+	if ((nr_shrunk == 0) && nr_skipped && retried < 2) {
 		retried++;
 		goto retry;
 	}
@@ -1202,6 +1202,37 @@ static void ext4_fc_update_stats(struct super_block *sb, int status,
 	trace_ext4_fc_commit_stop(sb, nblks, status, commit_tid);
 }
 
+/*
+ * Group commit for fast commits, modelled on jbd2_journal_stop(): if the
+ * previous fast commit was for another task and ended less than an average
+ * commit time ago, fsyncs are coming in faster than we can commit them.  Wait
+ * for up to that long (bounded by s_fc_max_batch_time) so that the updates of
+ * the other fsync callers get into the same fast commit, and they can then
+ * skip theirs.
+ */
+static void ext4_fc_batch_wait(struct super_block *sb)
+{
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
+	u64 max_batch = (u64)READ_ONCE(sbi->s_fc_max_batch_time) *
+			NSEC_PER_USEC;
+	u64 commit_time = sbi->s_fc_stats.s_fc_avg_commit_time;
+	pid_t pid = current->pid;
+	ktime_t expires;
+
+	if (!max_batch || READ_ONCE(sbi->s_fc_last_sync_writer) == pid)
+		return;
+	WRITE_ONCE(sbi->s_fc_last_sync_writer, pid);
+
+	if (ktime_to_ns(ktime_sub(ktime_get(),
+			READ_ONCE(sbi->s_fc_last_commit_end))) >= commit_time)
+		return;
+
+	sbi->s_fc_stats.fc_batch_waits++;
+	expires = ktime_add_ns(ktime_get(), min(commit_time, max_batch));
+	set_current_state(TASK_UNINTERRUPTIBLE);
+	schedule_hrtimeout(&expires, HRTIMER_MODE_ABS);
+}
+
 /*
  * The main commit entry point. Performs a fast commit for transaction
  * commit_tid if needed. If it's not possible to perform a fast commit
@@ -1222,6 +1253,7 @@ int ext4_fc_commit(journal_t *journal, tid_t commit_tid)
 
 	trace_ext4_fc_commit_start(sb, commit_tid);
 
+	ext4_fc_batch_wait(sb);
 	start_time = ktime_get();
 
 restart_fc:
@@ -1273,6 +1305,7 @@ int ext4_fc_commit(journal_t *journal, tid_t commit_tid)
 	 */
 	commit_time = ktime_to_ns(ktime_sub(ktime_get(), start_time));
 	ext4_fc_update_stats(sb, status, commit_time, nblks, commit_tid);
+	WRITE_ONCE(sbi->s_fc_last_commit_end, ktime_get());
 	return ret;
 
 fallback:
@@ -2297,10 +2330,11 @@ int ext4_fc_info_show(struct seq_file *seq, void *v)
 		return 0;
 
 	seq_printf(seq,
-		"fc stats:\n%ld commits\n%ld ineligible\n%ld numblks\n%lluus avg_commit_time\n",
+		"fc stats:\n%ld commits\n%ld ineligible\n%ld numblks\n%lluus avg_commit_time\n%ld skipped\n%ld batch_waits\n",
 		   stats->fc_num_commits, stats->fc_ineligible_commits,
 		   stats->fc_numblks,
-		   div_u64(stats->s_fc_avg_commit_time, 1000));
+		   div_u64(stats->s_fc_avg_commit_time, 1000),
+		   stats->fc_skipped_commits, stats->fc_batch_waits);
 	seq_puts(seq, "Ineligible reasons:\n");
 	for (i = 0; i < EXT4_FC_REASON_MAX; i++)
 		seq_printf(seq, "\"%s\":\t%d\n", fc_ineligible_reasons[i],
@@ -122,6 +122,7 @@ struct ext4_fc_stats {
 	unsigned long fc_failed_commits;
 	unsigned long fc_skipped_commits;
 	unsigned long fc_numblks;
+	unsigned long fc_batch_waits;
 	u64 s_fc_avg_commit_time;
 };
 
@@ -126,7 +126,10 @@
  * terms of number of blocks. If we have mounted the file system with -O
  * stripe=<value> option the group prealloc request is normalized to the
  * smallest multiple of the stripe value (sbi->s_stripe) which is
- * greater than the default mb_group_prealloc.
+ * greater than the default mb_group_prealloc.  The same option can be used
+ * to keep small files packed into flash erase blocks: with stripe set to the
+ * erase block size in blocks, group preallocations are found by
+ * ext4_mb_scan_aligned() and so start on an erase block boundary.
  *
  * If "mb_optimize_scan" mount option is set, we maintain in memory group info
  * structures in two data structures:
@@ -3997,17 +4000,25 @@ void ext4_mb_mark_bb(struct super_block *sb, ext4_fsblk_t block,
  * Group request are normalized to s_mb_group_prealloc, which goes to
  * s_strip if we set the same via mount option.
  * s_mb_group_prealloc can be configured via
- * /sys/fs/ext4/<partition>/mb_group_prealloc
+ * /sys/fs/ext4/<partition>/mb_group_prealloc, and is rounded up to a
+ * multiple of s_stripe here so that a value written there keeps group
+ * preallocations stripe (or flash erase block) aligned.
  *
  * XXX: should we try to preallocate more than the group has now?
  */
 static void ext4_mb_normalize_group_request(struct ext4_allocation_context *ac)
 {
 	struct super_block *sb = ac->ac_sb;
+	struct ext4_sb_info *sbi = EXT4_SB(sb);
 	struct ext4_locality_group *lg = ac->ac_lg;
 
 	BUG_ON(lg == NULL);
-	ac->ac_g_ex.fe_len = EXT4_SB(sb)->s_mb_group_prealloc;
+	ac->ac_g_ex.fe_len = sbi->s_mb_group_prealloc;
+	if (sbi->s_stripe > 1)
+		ac->ac_g_ex.fe_len = min_t(ext4_grpblk_t,
+					   roundup(ac->ac_g_ex.fe_len,
+						   sbi->s_stripe),
+					   EXT4_CLUSTERS_PER_GROUP(sb));
 	mb_debug(sb, "goal %u blocks for locality group\n", ac->ac_g_ex.fe_len);
 }
 
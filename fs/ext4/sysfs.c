@@ -184,6 +184,9 @@ static struct ext4_attr ext4_attr_##_name = {			\
 #define EXT4_RW_ATTR_SBI_UL(_name,_elname)	\
 	EXT4_ATTR_OFFSET(_name, 0644, pointer_ul, ext4_sb_info, _elname)
 
+#define EXT4_RO_ATTR_SBI_UL(_name,_elname)	\
+	EXT4_ATTR_OFFSET(_name, 0444, pointer_ul, ext4_sb_info, _elname)
+
 #define EXT4_RO_ATTR_SBI_ATOMIC(_name,_elname)	\
 	EXT4_ATTR_OFFSET(_name, 0444, pointer_atomic, ext4_sb_info, _elname)
 
@@ -246,6 +249,12 @@ EXT4_ATTR(journal_task, 0444, journal_task);
 EXT4_RW_ATTR_SBI_UI(mb_prefetch, s_mb_prefetch);
 EXT4_RW_ATTR_SBI_UI(mb_prefetch_limit, s_mb_prefetch_limit);
 EXT4_RW_ATTR_SBI_UL(last_trim_minblks, s_last_trim_minblks);
+EXT4_RW_ATTR_SBI_UI(fc_max_batch_time, s_fc_max_batch_time);
+EXT4_RO_ATTR_SBI_UL(fc_commits, s_fc_stats.fc_num_commits);
+EXT4_RO_ATTR_SBI_UL(fc_skipped_commits, s_fc_stats.fc_skipped_commits);
+EXT4_RO_ATTR_SBI_UL(fc_batch_waits, s_fc_stats.fc_batch_waits);
+EXT4_ATTR_OFFSET(fc_avg_commit_time_ns, 0444, pointer_u64, ext4_sb_info,
+		 s_fc_stats.s_fc_avg_commit_time);
 
 static unsigned int old_bump_val = 128;
 EXT4_ATTR_PTR(max_writeback_mb_bump, 0444, pointer_ui, &old_bump_val);
@@ -297,6 +306,11 @@ static struct attribute *ext4_attrs[] = {
 	ATTR_LIST(mb_prefetch),
 	ATTR_LIST(mb_prefetch_limit),
 	ATTR_LIST(last_trim_minblks),
+	ATTR_LIST(fc_max_batch_time),
+	ATTR_LIST(fc_commits),
+	ATTR_LIST(fc_skipped_commits),
+	ATTR_LIST(fc_batch_waits),
+	ATTR_LIST(fc_avg_commit_time_ns),
 	NULL,
 };
 ATTRIBUTE_GROUPS(ext4);
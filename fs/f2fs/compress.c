@@ -798,14 +798,28 @@ void f2fs_decompress_cluster(struct decompress_io_ctx *dic, bool in_task)
 	f2fs_decompress_end_io(dic, ret, in_task);
 }
 
+static void f2fs_decompress_work(struct work_struct *work)
+{
+	struct decompress_io_ctx *dic =
+		container_of(work, struct decompress_io_ctx, decompress_work);
+
+	f2fs_decompress_cluster(dic, true);
+}
+
 /*
  * This is called when a page of a compressed cluster has been read from disk
  * (or failed to be read from disk).  It checks whether this page was the last
  * page being waited on in the cluster, and if so, it decompresses the cluster
  * (or in the case of a failure, cleans up without actually decompressing).
+ *
+ * If @deferred is given, the cluster isn't decompressed here but handed back
+ * through it, and the cluster handed back by the previous call is queued to
+ * post_read_wq instead.  This lets the clusters completed by one bio be
+ * decompressed in parallel while the caller decompresses the last of them.
  */
 void f2fs_end_read_compressed_page(struct page *page, bool failed,
-		block_t blkaddr, bool in_task)
+		block_t blkaddr, bool in_task,
+		struct decompress_io_ctx **deferred)
 {
 	struct decompress_io_ctx *dic =
 			(struct decompress_io_ctx *)page_private(page);
@@ -819,8 +833,19 @@ void f2fs_end_read_compressed_page(struct page *page, bool failed,
 		f2fs_cache_compressed_page(sbi, page,
 					dic->inode->i_ino, blkaddr);
 
-	if (atomic_dec_and_test(&dic->remaining_pages))
+	if (!atomic_dec_and_test(&dic->remaining_pages))
+		return;
+
+	if (!deferred) {
 		f2fs_decompress_cluster(dic, in_task);
+		return;
+	}
+
+	if (*deferred) {
+		INIT_WORK(&(*deferred)->decompress_work, f2fs_decompress_work);
+		queue_work(sbi->post_read_wq, &(*deferred)->decompress_work);
+	}
+	*deferred = dic;
 }
 
 static bool is_page_in_cluster(struct compress_ctx *cc, pgoff_t index)
@@ -1435,7 +1460,8 @@ void f2fs_compress_write_end_io(struct bio *bio, struct page *page)
 static int f2fs_write_raw_pages(struct compress_ctx *cc,
 					int *submitted,
 					struct writeback_control *wbc,
-					enum iostat_type io_type)
+					enum iostat_type io_type,
+					bool balance)
 {
 	struct address_space *mapping = cc->inode->i_mapping;
 	int _submitted, compr_blocks, ret, i;
@@ -1502,21 +1528,21 @@ static int f2fs_write_raw_pages(struct compress_ctx *cc,
 		*submitted += _submitted;
 	}
 
-	f2fs_balance_fs(F2FS_M_SB(mapping), true);
+	if (balance)
+		f2fs_balance_fs(F2FS_M_SB(mapping), true);
 
 	return 0;
 }
 
-int f2fs_write_multi_pages(struct compress_ctx *cc,
+static int __f2fs_write_multi_pages(struct compress_ctx *cc,
+					bool compress, int err,
 					int *submitted,
 					struct writeback_control *wbc,
-					enum iostat_type io_type)
+					enum iostat_type io_type,
+					bool balance)
 {
-	int err;
-
 	*submitted = 0;
-	if (cluster_may_compress(cc)) {
-		err = f2fs_compress_pages(cc);
+	if (compress) {
 		if (err == -EAGAIN) {
 			add_compr_block_stat(cc->inode, cc->cluster_size);
 			goto write;
@@ -1534,13 +1560,157 @@ int f2fs_write_multi_pages(struct compress_ctx *cc,
 write:
 	f2fs_bug_on(F2FS_I_SB(cc->inode), *submitted);
 
-	err = f2fs_write_raw_pages(cc, submitted, wbc, io_type);
+	err = f2fs_write_raw_pages(cc, submitted, wbc, io_type, balance);
 	f2fs_put_rpages_wbc(cc, wbc, false, 0);
 destroy_out:
 	f2fs_destroy_compress_ctx(cc, false);
 	return err;
 }
 
+int f2fs_write_multi_pages(struct compress_ctx *cc,
+					int *submitted,
+					struct writeback_control *wbc,
+					enum iostat_type io_type)
+{
+	bool compress = cluster_may_compress(cc);
+	int err = 0;
+
+	if (compress)
+		err = f2fs_compress_pages(cc);
+
+	return __f2fs_write_multi_pages(cc, compress, err, submitted,
+							wbc, io_type, true);
+}
+
+struct compress_wb_work {
+	struct list_head list;
+	struct work_struct work;
+	struct completion done;
+	struct compress_ctx cc;
+	int err;			/* result of f2fs_compress_pages() */
+};
+
+static void f2fs_compress_wb_workfn(struct work_struct *work)
+{
+	struct compress_wb_work *cw =
+			container_of(work, struct compress_wb_work, work);
+
+	cw->err = f2fs_compress_pages(&cw->cc);
+	complete(&cw->done);
+}
+
+void f2fs_init_compress_wb_ctx(struct compress_wb_ctx *cwb,
+						struct inode *inode)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+
+	INIT_LIST_HEAD(&cwb->pending);
+	cwb->inode = inode;
+	cwb->nr_pending = 0;
+	cwb->need_balance = false;
+	cwb->max_pending = sbi->compress_wq ?
+				READ_ONCE(sbi->compress_wb_clusters) : 0;
+}
+
+/* wait for the oldest queued cluster to be compressed and write it out */
+static int f2fs_write_pending_cluster(struct compress_wb_ctx *cwb,
+						int *submitted,
+						struct writeback_control *wbc,
+						enum iostat_type io_type)
+{
+	struct compress_wb_work *cw = list_first_entry(&cwb->pending,
+					struct compress_wb_work, list);
+	int err;
+
+	wait_for_completion(&cw->done);
+	list_del(&cw->list);
+	cwb->nr_pending--;
+
+	/*
+	 * Foreground GC may need to lock the pages of clusters still queued
+	 * behind this one, so only balance once none are left.
+	 */
+	if (cwb->nr_pending)
+		cwb->need_balance = true;
+	err = __f2fs_write_multi_pages(&cw->cc, true, cw->err, submitted,
+					wbc, io_type, !cwb->nr_pending);
+	kfree(cw);
+	return err;
+}
+
+int f2fs_flush_multi_pages(struct compress_wb_ctx *cwb,
+					int *submitted,
+					struct writeback_control *wbc,
+					enum iostat_type io_type)
+{
+	int ret = 0;
+
+	*submitted = 0;
+	while (cwb->nr_pending) {
+		int _submitted, err;
+
+		/* keep going on error, queued clusters hold locked pages */
+		err = f2fs_write_pending_cluster(cwb, &_submitted,
+							wbc, io_type);
+		*submitted += _submitted;
+		if (err && !ret)
+			ret = err;
+	}
+
+	if (cwb->need_balance) {
+		cwb->need_balance = false;
+		f2fs_balance_fs(F2FS_I_SB(cwb->inode), true);
+	}
+	return ret;
+}
+
+/*
+ * Like f2fs_write_multi_pages(), but hand compression of the cluster to
+ * compress_wq and return without waiting, so that writeback can go on
+ * gathering the following clusters while earlier ones are compressed on
+ * other CPUs.  Queued clusters are still written by the caller and in file
+ * order, once more than max_pending are in flight or on
+ * f2fs_flush_multi_pages().  @submitted counts the pages written here.
+ */
+int f2fs_queue_multi_pages(struct compress_ctx *cc,
+					struct compress_wb_ctx *cwb,
+					int *submitted,
+					struct writeback_control *wbc,
+					enum iostat_type io_type)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(cc->inode);
+	struct compress_wb_work *cw = NULL;
+
+	if (cwb->max_pending && cluster_may_compress(cc))
+		cw = kmalloc(sizeof(*cw), GFP_NOFS);
+
+	if (!cw) {
+		int _submitted, err, err2;
+
+		err = f2fs_flush_multi_pages(cwb, submitted, wbc, io_type);
+		err2 = f2fs_write_multi_pages(cc, &_submitted, wbc, io_type);
+		*submitted += _submitted;
+		return err ? err : err2;
+	}
+
+	cw->cc = *cc;
+	init_completion(&cw->done);
+	INIT_WORK(&cw->work, f2fs_compress_wb_workfn);
+	list_add_tail(&cw->list, &cwb->pending);
+	cwb->nr_pending++;
+	queue_work(sbi->compress_wq, &cw->work);
+
+	/* the cluster pages and rpages array now belong to the work */
+	cc->rpages = NULL;
+	cc->nr_rpages = 0;
+	cc->cluster_idx = NULL_CLUSTER;
+
+	*submitted = 0;
+	if (cwb->nr_pending <= cwb->max_pending)
+		return 0;
+	return f2fs_write_pending_cluster(cwb, submitted, wbc, io_type);
+}
+
 static inline bool allow_memalloc_for_decomp(struct f2fs_sb_info *sbi,
 		bool pre_alloc)
 {
@@ -2005,6 +2175,25 @@ void f2fs_destroy_page_array_cache(struct f2fs_sb_info *sbi)
 	kmem_cache_destroy(sbi->page_array_slab);
 }
 
+int f2fs_init_compress_wq(struct f2fs_sb_info *sbi)
+{
+	if (!f2fs_sb_has_compression(sbi))
+		return 0;
+
+	sbi->compress_wq = alloc_workqueue("f2fs_compress_wq",
+					WQ_UNBOUND | WQ_MEM_RECLAIM,
+					num_online_cpus());
+	if (!sbi->compress_wq)
+		return -ENOMEM;
+	return 0;
+}
+
+void f2fs_destroy_compress_wq(struct f2fs_sb_info *sbi)
+{
+	if (sbi->compress_wq)
+		destroy_workqueue(sbi->compress_wq);
+}
+
 static int __init f2fs_init_cic_cache(void)
 {
 	cic_entry_slab = f2fs_kmem_cache_create("f2fs_cic_entry",
@@ -134,7 +134,7 @@ static void f2fs_finish_read_bio(struct bio *bio, bool in_task)
 		if (f2fs_is_compressed_page(page)) {
 			if (bio->bi_status)
 				f2fs_end_read_compressed_page(page, true, 0,
-							in_task);
+							in_task, NULL);
 			f2fs_put_page_dic(page, in_task);
 			continue;
 		}
@@ -223,11 +223,13 @@ static void f2fs_verify_and_finish_bio(struct bio *bio, bool in_task)
  * Note that a bio may span clusters (even a mix of compressed and uncompressed
  * clusters) or be for just part of a cluster.  STEP_DECOMPRESS just indicates
  * that the bio includes at least one compressed page.  The actual decompression
- * is done on a per-cluster basis, not a per-bio basis.
+ * is done on a per-cluster basis, not a per-bio basis, and when the bio
+ * completes several clusters they are decompressed in parallel.
  */
 static void f2fs_handle_step_decompress(struct bio_post_read_ctx *ctx,
 		bool in_task)
 {
+	struct decompress_io_ctx *dic = NULL;
 	struct bio_vec *bv;
 	struct bvec_iter_all iter_all;
 	bool all_compressed = true;
@@ -238,13 +240,17 @@ static void f2fs_handle_step_decompress(struct bio_post_read_ctx *ctx,
 
 		if (f2fs_is_compressed_page(page))
 			f2fs_end_read_compressed_page(page, false, blkaddr,
-						      in_task);
+						      in_task, &dic);
 		else
 			all_compressed = false;
 
 		blkaddr++;
 	}
 
+	/* earlier clusters went to post_read_wq, decompress the last one here */
+	if (dic)
+		f2fs_decompress_cluster(dic, in_task);
+
 	/*
 	 * Optimization: if all the bio's pages are compressed, then scheduling
 	 * the per-bio verity work is unnecessary, as verity will be fully
@@ -2974,6 +2980,7 @@ static int f2fs_write_cache_pages(struct address_space *mapping,
 		.rlen = PAGE_SIZE * F2FS_I(inode)->i_cluster_size,
 		.private = NULL,
 	};
+	struct compress_wb_ctx cwb;
 #endif
 	int nr_folios, p, idx;
 	int nr_pages;
@@ -2994,6 +3001,7 @@ static int f2fs_write_cache_pages(struct address_space *mapping,
 				cc.log_cluster_size, GFP_NOFS | __GFP_NOFAIL);
 		max_pages = 1 << cc.log_cluster_size;
 	}
+	f2fs_init_compress_wb_ctx(&cwb, inode);
 #endif
 
 	folio_batch_init(&fbatch);
@@ -3072,7 +3080,7 @@ static int f2fs_write_cache_pages(struct address_space *mapping,
 
 				if (!f2fs_cluster_can_merge_page(&cc,
 								folio->index)) {
-					ret = f2fs_write_multi_pages(&cc,
+					ret = f2fs_queue_multi_pages(&cc, &cwb,
 						&submitted, wbc, io_type);
 					if (!ret)
 						need_readd = true;
@@ -3199,7 +3207,7 @@ static int f2fs_write_cache_pages(struct address_space *mapping,
 #ifdef CONFIG_F2FS_FS_COMPRESSION
 	/* flush remained pages in compress cluster */
 	if (f2fs_compressed_file(inode) && !f2fs_cluster_is_empty(&cc)) {
-		ret = f2fs_write_multi_pages(&cc, &submitted, wbc, io_type);
+		ret = f2fs_queue_multi_pages(&cc, &cwb, &submitted, wbc, io_type);
 		nwritten += submitted;
 		wbc->nr_to_write -= submitted;
 		if (ret) {
@@ -3207,8 +3215,21 @@ static int f2fs_write_cache_pages(struct address_space *mapping,
 			retry = 0;
 		}
 	}
-	if (f2fs_compressed_file(inode))
+	if (f2fs_compressed_file(inode)) {
+		int ret2;
+
+		/* wait for clusters still being compressed and write them */
+		ret2 = f2fs_flush_multi_pages(&cwb, &submitted, wbc, io_type);
+		nwritten += submitted;
+		wbc->nr_to_write -= submitted;
+		if (ret2) {
+			if (!ret)
+				ret = ret2;
+			done = 1;
+			retry = 0;
+		}
 		f2fs_destroy_compress_ctx(&cc, false);
+	}
 #endif
 	if (retry) {
 		index = 0;
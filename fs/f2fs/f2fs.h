@@ -1488,6 +1488,7 @@ enum compress_flag {
 
 #define	COMPRESS_WATERMARK			20
 #define	COMPRESS_PERCENT			20
+#define	MAX_COMPRESS_WB_CLUSTERS		64
 
 #define COMPRESS_DATA_RESERVED_SIZE		4
 struct compress_data {
@@ -1522,6 +1523,15 @@ struct compress_ctx {
 	void *private2;			/* extra payload buffer */
 };
 
+/* compress context for pipelined writeback, see f2fs_queue_multi_pages() */
+struct compress_wb_ctx {
+	struct inode *inode;		/* inode the context belong to */
+	struct list_head pending;	/* clusters being compressed, in order */
+	unsigned int nr_pending;	/* number of clusters in pending list */
+	unsigned int max_pending;	/* pipeline depth, 0 compresses inline */
+	bool need_balance;		/* f2fs_balance_fs() was deferred */
+};
+
 /* compress context for write IO path */
 struct compress_io_ctx {
 	u32 magic;			/* magic number to indicate page is compressed */
@@ -1579,6 +1589,7 @@ struct decompress_io_ctx {
 	void *private2;			/* extra payload buffer */
 	struct work_struct verity_work;	/* work to verify the decompressed pages */
 	struct work_struct free_work;	/* work for late free this structure itself */
+	struct work_struct decompress_work;	/* work to decompress the cluster */
 };
 
 #define NULL_CLUSTER			((unsigned int)(~0))
@@ -1825,6 +1836,10 @@ struct f2fs_sb_info {
 	unsigned int compress_percent;		/* cache page percentage */
 	unsigned int compress_watermark;	/* cache page watermark */
 	atomic_t compress_page_hit;		/* cache hit count */
+
+	/* For pipelined compression in writeback */
+	struct workqueue_struct *compress_wq;	/* compress workqueue */
+	unsigned int compress_wb_clusters;	/* clusters compressed ahead */
 #endif
 
 #ifdef CONFIG_F2FS_IOSTAT
@@ -1839,6 +1854,10 @@ struct f2fs_sb_info {
 	/* For io latency related statistics info in one iostat period */
 	spinlock_t iostat_lat_lock;
 	struct iostat_lat_info *iostat_io_lat;
+
+	/* cumulative per-cpu io latency histograms and their last trace */
+	struct iostat_lat_hist __percpu *iostat_lat_hist;
+	struct iostat_lat_hist *iostat_lat_hist_prev;
 #endif
 };
 
@@ -4221,7 +4240,8 @@ int f2fs_init_compress_mempool(void);
 void f2fs_destroy_compress_mempool(void);
 void f2fs_decompress_cluster(struct decompress_io_ctx *dic, bool in_task);
 void f2fs_end_read_compressed_page(struct page *page, bool failed,
-				block_t blkaddr, bool in_task);
+				block_t blkaddr, bool in_task,
+				struct decompress_io_ctx **deferred);
 bool f2fs_cluster_is_empty(struct compress_ctx *cc);
 bool f2fs_cluster_can_merge_page(struct compress_ctx *cc, pgoff_t index);
 bool f2fs_all_cluster_page_ready(struct compress_ctx *cc, struct page **pages,
@@ -4232,6 +4252,17 @@ int f2fs_write_multi_pages(struct compress_ctx *cc,
 						int *submitted,
 						struct writeback_control *wbc,
 						enum iostat_type io_type);
+void f2fs_init_compress_wb_ctx(struct compress_wb_ctx *cwb,
+						struct inode *inode);
+int f2fs_queue_multi_pages(struct compress_ctx *cc,
+						struct compress_wb_ctx *cwb,
+						int *submitted,
+						struct writeback_control *wbc,
+						enum iostat_type io_type);
+int f2fs_flush_multi_pages(struct compress_wb_ctx *cwb,
+						int *submitted,
+						struct writeback_control *wbc,
+						enum iostat_type io_type);
 int f2fs_is_compressed_cluster(struct inode *inode, pgoff_t index);
 void f2fs_update_read_extent_tree_range_compressed(struct inode *inode,
 				pgoff_t fofs, block_t blkaddr,
@@ -4251,6 +4282,8 @@ int f2fs_init_compress_inode(struct f2fs_sb_info *sbi);
 void f2fs_destroy_compress_inode(struct f2fs_sb_info *sbi);
 int f2fs_init_page_array_cache(struct f2fs_sb_info *sbi);
 void f2fs_destroy_page_array_cache(struct f2fs_sb_info *sbi);
+int f2fs_init_compress_wq(struct f2fs_sb_info *sbi);
+void f2fs_destroy_compress_wq(struct f2fs_sb_info *sbi);
 int __init f2fs_init_compress_cache(void);
 void f2fs_destroy_compress_cache(void);
 struct address_space *COMPRESS_MAPPING(struct f2fs_sb_info *sbi);
@@ -4291,7 +4324,8 @@ static inline void f2fs_destroy_compress_mempool(void) { }
 static inline void f2fs_decompress_cluster(struct decompress_io_ctx *dic,
 				bool in_task) { }
 static inline void f2fs_end_read_compressed_page(struct page *page,
-				bool failed, block_t blkaddr, bool in_task)
+				bool failed, block_t blkaddr, bool in_task,
+				struct decompress_io_ctx **deferred)
 {
 	WARN_ON_ONCE(1);
 }
@@ -4305,6 +4339,8 @@ static inline int f2fs_init_compress_inode(struct f2fs_sb_info *sbi) { return 0;
 static inline void f2fs_destroy_compress_inode(struct f2fs_sb_info *sbi) { }
 static inline int f2fs_init_page_array_cache(struct f2fs_sb_info *sbi) { return 0; }
 static inline void f2fs_destroy_page_array_cache(struct f2fs_sb_info *sbi) { }
+static inline int f2fs_init_compress_wq(struct f2fs_sb_info *sbi) { return 0; }
+static inline void f2fs_destroy_compress_wq(struct f2fs_sb_info *sbi) { }
 static inline int __init f2fs_init_compress_cache(void) { return 0; }
 static inline void f2fs_destroy_compress_cache(void) { }
 static inline void f2fs_invalidate_compress_page(struct f2fs_sb_info *sbi,
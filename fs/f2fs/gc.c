@@ -15,6 +15,7 @@
 #include <linux/sched/signal.h>
 #include <linux/random.h>
 #include <linux/sched/mm.h>
+#include <linux/blk_types.h>
 
 #include "f2fs.h"
 #include "node.h"
@@ -28,6 +29,39 @@ static struct kmem_cache *victim_entry_slab;
 static unsigned int count_bits(const unsigned long *addr,
 				unsigned int offset, unsigned int len);
 
+/*
+ * f2fs's own inflight counters don't see I/O issued to the device through
+ * other partitions or by other users, so also require the block layer not
+ * to have started or completed any request on the whole device for a
+ * while. The required idle time shrinks with the free sections left, so
+ * that reclaim still gets to run on a busy device close to full.
+ */
+static bool f2fs_bdev_is_idle(struct f2fs_sb_info *sbi)
+{
+	unsigned int idle_ms = sbi->gc_thread->bdev_idle_time;
+	unsigned long idle;
+	int i;
+
+	if (!idle_ms || sbi->gc_mode == GC_URGENT_HIGH ||
+	    sbi->gc_mode == GC_URGENT_LOW || sbi->gc_mode == GC_URGENT_MID)
+		return true;
+
+	idle_ms = div_u64((u64)idle_ms * free_sections(sbi),
+			  max(MAIN_SECS(sbi), 1U));
+	idle = msecs_to_jiffies(idle_ms);
+
+	for (i = 0; i < max(sbi->s_ndevs, 1); i++) {
+		struct block_device *bdev = f2fs_is_multi_device(sbi) ?
+					FDEV(i).bdev : sbi->sb->s_bdev;
+
+		if (time_before(jiffies,
+				READ_ONCE(bdev_whole(bdev)->bd_stamp) + idle))
+			return false;
+	}
+
+	return true;
+}
+
 static int gc_thread_func(void *data)
 {
 	struct f2fs_sb_info *sbi = data;
@@ -111,8 +145,12 @@ static int gc_thread_func(void *data)
 			goto next;
 		}
 
-		if (!is_idle(sbi, GC_TIME)) {
-			increase_sleep_time(gc_th, &wait_ms);
+		if (!is_idle(sbi, GC_TIME) || !f2fs_bdev_is_idle(sbi)) {
+			/* retry soon if space is needed, back off otherwise */
+			if (has_enough_invalid_blocks(sbi))
+				decrease_sleep_time(gc_th, &wait_ms);
+			else
+				increase_sleep_time(gc_th, &wait_ms);
 			f2fs_up_write(&sbi->gc_lock);
 			stat_io_skip_bggc_count(sbi);
 			goto next;
@@ -183,6 +221,7 @@ int f2fs_start_gc_thread(struct f2fs_sb_info *sbi)
 	gc_th->min_sleep_time = DEF_GC_THREAD_MIN_SLEEP_TIME;
 	gc_th->max_sleep_time = DEF_GC_THREAD_MAX_SLEEP_TIME;
 	gc_th->no_gc_sleep_time = DEF_GC_THREAD_NOGC_SLEEP_TIME;
+	gc_th->bdev_idle_time = DEF_GC_THREAD_BDEV_IDLE_TIME;
 
 	gc_th->gc_wake = 0;
 
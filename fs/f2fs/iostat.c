@@ -95,6 +95,86 @@ int __maybe_unused iostat_info_seq_show(struct seq_file *seq, void *offset)
 	return 0;
 }
 
+static void iostat_sum_lat_hist(struct f2fs_sb_info *sbi, int idx, int io,
+				unsigned long *hist)
+{
+	int cpu, i;
+
+	memset(hist, 0, sizeof(*hist) * IOSTAT_LAT_HIST_BUCKETS);
+	for_each_possible_cpu(cpu) {
+		struct iostat_lat_hist *lat_hist =
+				per_cpu_ptr(sbi->iostat_lat_hist, cpu);
+
+		for (i = 0; i < IOSTAT_LAT_HIST_BUCKETS; i++)
+			hist[i] += READ_ONCE(lat_hist->cnt[idx][io][i]);
+	}
+}
+
+int __maybe_unused iostat_lat_hist_seq_show(struct seq_file *seq,
+			void *offset)
+{
+	static const char * const io_name[MAX_IO_TYPE] = {
+		"read", "sync write", "async write",
+	};
+	static const char * const type_name[NR_PAGE_TYPE] = {
+		"data", "node", "meta",
+	};
+	struct super_block *sb = seq->private;
+	struct f2fs_sb_info *sbi = F2FS_SB(sb);
+	unsigned long hist[IOSTAT_LAT_HIST_BUCKETS];
+	int idx, io, i;
+
+	if (!sbi->iostat_enable)
+		return 0;
+
+	seq_printf(seq, "%-24s", "latency(us) <");
+	for (i = 0; i < IOSTAT_LAT_HIST_BUCKETS - 1; i++)
+		seq_printf(seq, " %lu", 1UL << i);
+	seq_puts(seq, " inf\n");
+
+	for (idx = 0; idx < MAX_IO_TYPE; idx++) {
+		for (io = 0; io < NR_PAGE_TYPE; io++) {
+			iostat_sum_lat_hist(sbi, idx, io, hist);
+			seq_printf(seq, "%-11s %-4s:       ",
+					io_name[idx], type_name[io]);
+			for (i = 0; i < IOSTAT_LAT_HIST_BUCKETS; i++)
+				seq_printf(seq, " %lu", hist[i]);
+			seq_putc(seq, '\n');
+		}
+	}
+
+	return 0;
+}
+
+static inline void __record_iostat_lat_hist(struct f2fs_sb_info *sbi)
+{
+	struct iostat_lat_hist *prev = sbi->iostat_lat_hist_prev;
+	unsigned int delta[IOSTAT_LAT_HIST_BUCKETS];
+	unsigned long hist[IOSTAT_LAT_HIST_BUCKETS];
+	unsigned long flags;
+	int idx, io, i;
+	bool empty;
+
+	for (idx = 0; idx < MAX_IO_TYPE; idx++) {
+		for (io = 0; io < NR_PAGE_TYPE; io++) {
+			iostat_sum_lat_hist(sbi, idx, io, hist);
+
+			empty = true;
+			spin_lock_irqsave(&sbi->iostat_lat_lock, flags);
+			for (i = 0; i < IOSTAT_LAT_HIST_BUCKETS; i++) {
+				delta[i] = hist[i] - prev->cnt[idx][io][i];
+				prev->cnt[idx][io][i] = hist[i];
+				if (delta[i])
+					empty = false;
+			}
+			spin_unlock_irqrestore(&sbi->iostat_lat_lock, flags);
+
+			if (!empty)
+				trace_f2fs_iostat_lat_hist(sbi, idx, io, delta);
+		}
+	}
+}
+
 static inline void __record_iostat_latency(struct f2fs_sb_info *sbi)
 {
 	int io, idx = 0;
@@ -120,6 +200,8 @@ static inline void __record_iostat_latency(struct f2fs_sb_info *sbi)
 	spin_unlock_irqrestore(&sbi->iostat_lat_lock, flags);
 
 	trace_f2fs_iostat_latency(sbi, iostat_lat);
+
+	__record_iostat_lat_hist(sbi);
 }
 
 static inline void f2fs_record_iostat(struct f2fs_sb_info *sbi)
@@ -155,7 +237,7 @@ static inline void f2fs_record_iostat(struct f2fs_sb_info *sbi)
 void f2fs_reset_iostat(struct f2fs_sb_info *sbi)
 {
 	struct iostat_lat_info *io_lat = sbi->iostat_io_lat;
-	int i;
+	int cpu, i;
 
 	spin_lock_irq(&sbi->iostat_lock);
 	for (i = 0; i < NR_IO_TYPE; i++) {
@@ -166,6 +248,10 @@ void f2fs_reset_iostat(struct f2fs_sb_info *sbi)
 
 	spin_lock_irq(&sbi->iostat_lat_lock);
 	memset(io_lat, 0, sizeof(struct iostat_lat_info));
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(sbi->iostat_lat_hist, cpu), 0,
+				sizeof(struct iostat_lat_hist));
+	memset(sbi->iostat_lat_hist_prev, 0, sizeof(struct iostat_lat_hist));
 	spin_unlock_irq(&sbi->iostat_lat_lock);
 }
 
@@ -213,6 +299,19 @@ void f2fs_update_iostat(struct f2fs_sb_info *sbi, struct inode *inode,
 	f2fs_record_iostat(sbi);
 }
 
+/*
+ * Called from the bio completion of every bio, so each cpu only bumps its
+ * own counter and the per-period deltas are worked out by the tracer.
+ */
+static inline void __update_iostat_lat_hist(struct f2fs_sb_info *sbi,
+				int idx, unsigned int iotype, u64 lat_ns)
+{
+	unsigned int bucket = fls64(div_u64(lat_ns, NSEC_PER_USEC));
+
+	bucket = min_t(unsigned int, bucket, IOSTAT_LAT_HIST_BUCKETS - 1);
+	this_cpu_inc(sbi->iostat_lat_hist->cnt[idx][iotype][bucket]);
+}
+
 static inline void __update_iostat_latency(struct bio_iostat_ctx *iostat_ctx,
 				int rw, bool is_sync)
 {
@@ -243,6 +342,10 @@ static inline void __update_iostat_latency(struct bio_iostat_ctx *iostat_ctx,
 			idx = WRITE_ASYNC_IO;
 	}
 
+	if (iostat_ctx->submit_ns)
+		__update_iostat_lat_hist(sbi, idx, iotype,
+				ktime_get_ns() - iostat_ctx->submit_ns);
+
 	spin_lock_irqsave(&sbi->iostat_lat_lock, flags);
 	io_lat->sum_lat[idx][iotype] += ts_diff;
 	io_lat->bio_cnt[idx][iotype]++;
@@ -272,6 +375,7 @@ void iostat_alloc_and_bind_ctx(struct f2fs_sb_info *sbi,
 	iostat_ctx = mempool_alloc(bio_iostat_ctx_pool, GFP_NOFS);
 	iostat_ctx->sbi = sbi;
 	iostat_ctx->submit_ts = 0;
+	iostat_ctx->submit_ns = 0;
 	iostat_ctx->type = 0;
 	iostat_ctx->post_read_ctx = ctx;
 	bio->bi_private = iostat_ctx;
@@ -315,10 +419,27 @@ int f2fs_init_iostat(struct f2fs_sb_info *sbi)
 	if (!sbi->iostat_io_lat)
 		return -ENOMEM;
 
+	sbi->iostat_lat_hist = alloc_percpu(struct iostat_lat_hist);
+	if (!sbi->iostat_lat_hist)
+		goto free_io_lat;
+
+	sbi->iostat_lat_hist_prev = f2fs_kzalloc(sbi,
+				sizeof(struct iostat_lat_hist), GFP_KERNEL);
+	if (!sbi->iostat_lat_hist_prev)
+		goto free_lat_hist;
+
 	return 0;
+
+free_lat_hist:
+	free_percpu(sbi->iostat_lat_hist);
+free_io_lat:
+	kfree(sbi->iostat_io_lat);
+	return -ENOMEM;
 }
 
 void f2fs_destroy_iostat(struct f2fs_sb_info *sbi)
 {
+	kfree(sbi->iostat_lat_hist_prev);
+	free_percpu(sbi->iostat_lat_hist);
 	kfree(sbi->iostat_io_lat);
 }
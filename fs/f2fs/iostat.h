@@ -28,8 +28,21 @@ struct iostat_lat_info {
 	unsigned int bio_cnt[MAX_IO_TYPE][NR_PAGE_TYPE];	/* bio count */
 };
 
+/*
+ * Bucket i of the latency histograms counts the bios completed in
+ * [2^(i-1), 2^i) usecs, bucket 0 the ones under 1 usec and the last
+ * bucket everything slower than that, i.e. over ~4 seconds.
+ */
+#define IOSTAT_LAT_HIST_BUCKETS		24
+
+struct iostat_lat_hist {
+	unsigned long cnt[MAX_IO_TYPE][NR_PAGE_TYPE][IOSTAT_LAT_HIST_BUCKETS];
+};
+
 extern int __maybe_unused iostat_info_seq_show(struct seq_file *seq,
 			void *offset);
+extern int __maybe_unused iostat_lat_hist_seq_show(struct seq_file *seq,
+			void *offset);
 extern void f2fs_reset_iostat(struct f2fs_sb_info *sbi);
 extern void f2fs_update_iostat(struct f2fs_sb_info *sbi, struct inode *inode,
 			enum iostat_type type, unsigned long long io_bytes);
@@ -37,6 +50,7 @@ extern void f2fs_update_iostat(struct f2fs_sb_info *sbi, struct inode *inode,
 struct bio_iostat_ctx {
 	struct f2fs_sb_info *sbi;
 	unsigned long submit_ts;
+	u64 submit_ns;			/* 0 if iostat was disabled at submit */
 	enum page_type type;
 	struct bio_post_read_ctx *post_read_ctx;
 };
@@ -47,6 +61,8 @@ static inline void iostat_update_submit_ctx(struct bio *bio,
 	struct bio_iostat_ctx *iostat_ctx = bio->bi_private;
 
 	iostat_ctx->submit_ts = jiffies;
+	iostat_ctx->submit_ns = iostat_ctx->sbi->iostat_enable ?
+						ktime_get_ns() : 0;
 	iostat_ctx->type = type;
 }
 
@@ -51,6 +51,12 @@ MODULE_PARM_DESC(max_user_congthresh,
  "Global limit for the maximum congestion threshold an "
  "unprivileged user can set");
 
+static unsigned int max_pages_limit = FUSE_MAX_MAX_PAGES;
+module_param(max_pages_limit, uint, 0644);
+MODULE_PARM_DESC(max_pages_limit,
+ "Maximum number of pages per request a server can negotiate with "
+ "FUSE_MAX_PAGES (default 256, at most 4096)");
+
 #define FUSE_DEFAULT_BLKSIZE 512
 
 /** Maximum number of outstanding background requests */
@@ -846,7 +852,9 @@ void fuse_conn_init(struct fuse_conn *fc, struct fuse_mount *fm,
 	fc->pid_ns = get_pid_ns(task_active_pid_ns(current));
 	fc->user_ns = get_user_ns(user_ns);
 	fc->max_pages = FUSE_DEFAULT_MAX_PAGES_PER_REQ;
-	fc->max_pages_limit = FUSE_MAX_MAX_PAGES;
+	fc->max_pages_limit = clamp_t(unsigned int, READ_ONCE(max_pages_limit),
+				      FUSE_DEFAULT_MAX_PAGES_PER_REQ,
+				      FUSE_MAX_MAX_PAGES_LIMIT);
 
 	INIT_LIST_HEAD(&fc->mounts);
 	list_add(&fm->fc_entry, &fc->mounts);
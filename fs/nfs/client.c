@@ -967,6 +967,10 @@ struct nfs_server *nfs_alloc_server(void)
 
 	atomic_set(&server->active, 0);
 
+	spin_lock_init(&server->ra_lock);
+	server->ra_window_start = server->ra_rtt_start = jiffies;
+	server->ra_rtt_min_us = U32_MAX;
+
 	server->io_stats = nfs_alloc_iostats();
 	if (!server->io_stats) {
 		kfree(server);
@@ -989,6 +993,7 @@ EXPORT_SYMBOL_GPL(nfs_alloc_server);
  */
 void nfs_free_server(struct nfs_server *server)
 {
+	nfs_sysfs_remove_server(server);
 	nfs_server_remove_lists(server);
 
 	if (server->destroy != NULL)
@@ -689,6 +689,15 @@ void nfs_pgio_header_free(struct nfs_pgio_header *hdr)
 }
 EXPORT_SYMBOL_GPL(nfs_pgio_header_free);
 
+static atomic_t *nfs_pgio_inflight(struct nfs_pgio_header *hdr)
+{
+	struct nfs_server *server = NFS_SERVER(hdr->inode);
+
+	if (hdr->rw_mode == FMODE_READ)
+		return &server->read_inflight;
+	return &server->write_inflight;
+}
+
 /**
  * nfs_pgio_rpcsetup - Set up arguments for a pageio call
  * @hdr: The pageio hdr
@@ -779,6 +788,9 @@ int nfs_initiate_pgio(struct rpc_clnt *clnt, struct nfs_pgio_header *hdr,
 		hdr->args.count,
 		(unsigned long long)hdr->args.offset);
 
+	if (!test_and_set_bit(NFS_IOHDR_INFLIGHT, &hdr->flags))
+		atomic_inc(nfs_pgio_inflight(hdr));
+
 	task = rpc_run_task(&task_setup_data);
 	if (IS_ERR(task))
 		return PTR_ERR(task);
@@ -804,6 +816,9 @@ static void nfs_pgio_error(struct nfs_pgio_header *hdr)
 static void nfs_pgio_release(void *calldata)
 {
 	struct nfs_pgio_header *hdr = calldata;
+
+	if (test_and_clear_bit(NFS_IOHDR_INFLIGHT, &hdr->flags))
+		atomic_dec(nfs_pgio_inflight(hdr));
 	hdr->completion_ops->completion(hdr);
 }
 
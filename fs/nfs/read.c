@@ -36,6 +36,11 @@ static const struct nfs_rw_ops nfs_rw_read_ops;
 
 static struct kmem_cache *nfs_rdata_cachep;
 
+/* Interval over which read throughput is sampled */
+#define NFS_RA_SAMPLE_INTERVAL	(HZ)
+/* How long the minimum read RTT is remembered */
+#define NFS_RA_RTT_INTERVAL	(10 * HZ)
+
 static struct nfs_pgio_header *nfs_readhdr_alloc(void)
 {
 	struct nfs_pgio_header *p = kmem_cache_zalloc(nfs_rdata_cachep, GFP_KERNEL);
@@ -222,6 +227,64 @@ static const struct nfs_pgio_completion_ops nfs_async_read_completion_ops = {
 	.completion = nfs_read_completion,
 };
 
+/*
+ * Size readahead so that a single sequential stream keeps about twice the
+ * bandwidth-delay product of the mount in flight.  The delay is the minimum
+ * read RTT seen recently, so that queueing on a saturated link does not
+ * make the window grow without bound.
+ */
+static void nfs_read_autoscale(struct nfs_server *server)
+{
+	unsigned long max_pages;
+	u64 bdp;
+
+	if (!server->super)
+		return;
+	bdp = div_u64(server->read_bytes_per_sec * server->ra_rtt_min_us,
+		      USEC_PER_SEC);
+	max_pages = max_t(unsigned long, server->rpages * NFS_MAX_READAHEAD,
+			  VM_READAHEAD_PAGES);
+	WRITE_ONCE(server->super->s_bdi->ra_pages,
+		   clamp_t(u64, (2 * bdp) >> PAGE_SHIFT,
+			   VM_READAHEAD_PAGES, max_pages));
+}
+
+static void nfs_read_sample(struct rpc_task *task,
+			    struct nfs_pgio_header *hdr)
+{
+	struct nfs_server *server = NFS_SERVER(hdr->inode);
+	unsigned long now = jiffies;
+	unsigned long elapsed;
+	u32 rtt = 0;
+
+	if (task->tk_rqstp)
+		rtt = ktime_to_us(task->tk_rqstp->rq_rtt);
+
+	spin_lock(&server->ra_lock);
+	if (time_after_eq(now, server->ra_rtt_start + NFS_RA_RTT_INTERVAL)) {
+		server->ra_rtt_start = now;
+		server->ra_rtt_min_us = U32_MAX;
+	}
+	if (rtt && rtt < server->ra_rtt_min_us)
+		server->ra_rtt_min_us = rtt;
+
+	server->ra_window_bytes += hdr->res.count;
+	elapsed = now - server->ra_window_start;
+	if (elapsed >= NFS_RA_SAMPLE_INTERVAL) {
+		/* Don't let an idle period count against the throughput */
+		if (elapsed < 2 * NFS_RA_SAMPLE_INTERVAL) {
+			server->read_bytes_per_sec =
+				div_u64(server->ra_window_bytes * HZ, elapsed);
+			if (server->ra_autoscale &&
+			    server->ra_rtt_min_us != U32_MAX)
+				nfs_read_autoscale(server);
+		}
+		server->ra_window_start = now;
+		server->ra_window_bytes = 0;
+	}
+	spin_unlock(&server->ra_lock);
+}
+
 /*
  * This is the callback from RPC telling us whether a reply was
  * received or some error occurred (timeout or socket shutdown).
@@ -236,6 +299,8 @@ static int nfs_readpage_done(struct rpc_task *task,
 
 	nfs_add_stats(inode, NFSIOS_SERVERREADBYTES, hdr->res.count);
 	trace_nfs_readpage_done(task, hdr);
+	if (task->tk_status >= 0)
+		nfs_read_sample(task, hdr);
 
 	if (task->tk_status == -ESTALE) {
 		nfs_set_inode_stale(inode);
@@ -414,6 +479,15 @@ void nfs_readahead(struct readahead_control *ractl)
 	nfs_inc_stats(inode, NFSIOS_VFSREADPAGES);
 	task_io_account_read(readahead_length(ractl));
 
+	/*
+	 * The readahead window is copied from the bdi at open time, so let
+	 * streams that are already open pick up a rescaled window.  Files
+	 * with readahead disabled (POSIX_FADV_RANDOM) are left alone.
+	 */
+	if (READ_ONCE(NFS_SERVER(inode)->ra_autoscale) && ractl->ra &&
+	    ractl->ra->ra_pages)
+		ractl->ra->ra_pages = READ_ONCE(inode_to_bdi(inode)->ra_pages);
+
 	ret = -ESTALE;
 	if (NFS_STALE(inode))
 		goto out;
@@ -68,6 +68,8 @@
 #include "nfs4session.h"
 #include "pnfs.h"
 #include "nfs.h"
+#include "netns.h"
+#include "sysfs.h"
 
 #define NFSDBG_FACILITY		NFSDBG_VFS
 
@@ -1297,6 +1299,7 @@ int nfs_get_tree_common(struct fs_context *fc)
 			goto error_splat_super;
 		s->s_bdi->io_pages = server->rpages;
 		server->super = s;
+		nfs_sysfs_add_server(server);
 	}
 
 	if (!s->s_root) {
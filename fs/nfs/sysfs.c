@@ -190,3 +190,122 @@ void nfs_netns_sysfs_destroy(struct nfs_net *netns)
 		netns->nfs_client = NULL;
 	}
 }
+
+static void nfs_sysfs_sb_release(struct kobject *kobj)
+{
+	/* the nfs_server is freed by nfs_free_server() */
+}
+
+static ssize_t read_inflight_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct nfs_server *server = container_of(kobj, struct nfs_server, kobj);
+
+	return sysfs_emit(buf, "%d\n", atomic_read(&server->read_inflight));
+}
+
+static ssize_t write_inflight_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct nfs_server *server = container_of(kobj, struct nfs_server, kobj);
+
+	return sysfs_emit(buf, "%d\n", atomic_read(&server->write_inflight));
+}
+
+static ssize_t read_rtt_min_us_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct nfs_server *server = container_of(kobj, struct nfs_server, kobj);
+	u32 rtt = READ_ONCE(server->ra_rtt_min_us);
+
+	return sysfs_emit(buf, "%u\n", rtt == U32_MAX ? 0 : rtt);
+}
+
+static ssize_t read_bytes_per_sec_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct nfs_server *server = container_of(kobj, struct nfs_server, kobj);
+	u64 bps;
+
+	spin_lock(&server->ra_lock);
+	bps = server->read_bytes_per_sec;
+	spin_unlock(&server->ra_lock);
+	return sysfs_emit(buf, "%llu\n", bps);
+}
+
+static ssize_t readahead_autoscale_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct nfs_server *server = container_of(kobj, struct nfs_server, kobj);
+
+	return sysfs_emit(buf, "%d\n", READ_ONCE(server->ra_autoscale));
+}
+
+static ssize_t readahead_autoscale_store(struct kobject *kobj,
+		struct kobj_attribute *attr,
+		const char *buf, size_t count)
+{
+	struct nfs_server *server = container_of(kobj, struct nfs_server, kobj);
+	bool enable;
+	int ret;
+
+	ret = kstrtobool(buf, &enable);
+	if (ret)
+		return ret;
+	WRITE_ONCE(server->ra_autoscale, enable);
+	return count;
+}
+
+static struct kobj_attribute nfs_sysfs_attr_read_inflight =
+		__ATTR_RO(read_inflight);
+static struct kobj_attribute nfs_sysfs_attr_write_inflight =
+		__ATTR_RO(write_inflight);
+static struct kobj_attribute nfs_sysfs_attr_read_rtt_min_us =
+		__ATTR_RO(read_rtt_min_us);
+static struct kobj_attribute nfs_sysfs_attr_read_bytes_per_sec =
+		__ATTR_RO(read_bytes_per_sec);
+static struct kobj_attribute nfs_sysfs_attr_readahead_autoscale =
+		__ATTR_RW(readahead_autoscale);
+
+static struct attribute *nfs_sb_attrs[] = {
+	&nfs_sysfs_attr_read_inflight.attr,
+	&nfs_sysfs_attr_write_inflight.attr,
+	&nfs_sysfs_attr_read_rtt_min_us.attr,
+	&nfs_sysfs_attr_read_bytes_per_sec.attr,
+	&nfs_sysfs_attr_readahead_autoscale.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(nfs_sb);
+
+static struct kobj_type nfs_sb_ktype = {
+	.release = nfs_sysfs_sb_release,
+	.default_groups = nfs_sb_groups,
+	.sysfs_ops = &kobj_sysfs_ops,
+};
+
+void nfs_sysfs_add_server(struct nfs_server *server)
+{
+	int ret;
+
+	ret = kobject_init_and_add(&server->kobj, &nfs_sb_ktype,
+				   &nfs_kset->kobj, "%u:%u",
+				   MAJOR(server->s_dev), MINOR(server->s_dev));
+	if (ret < 0) {
+		pr_warn("NFS: sysfs add server %u:%u failed (%d)\n",
+			MAJOR(server->s_dev), MINOR(server->s_dev), ret);
+		kobject_put(&server->kobj);
+		/* nfs_sysfs_remove_server() must not put it again */
+		memset(&server->kobj, 0, sizeof(server->kobj));
+		return;
+	}
+	kobject_uevent(&server->kobj, KOBJ_ADD);
+}
+
+void nfs_sysfs_remove_server(struct nfs_server *server)
+{
+	if (!server->kobj.state_initialized)
+		return;
+	kobject_uevent(&server->kobj, KOBJ_REMOVE);
+	kobject_del(&server->kobj);
+	kobject_put(&server->kobj);
+}
@@ -22,4 +22,7 @@ extern void nfs_sysfs_exit(void);
 void nfs_netns_sysfs_setup(struct nfs_net *netns, struct net *net);
 void nfs_netns_sysfs_destroy(struct nfs_net *netns);
 
+void nfs_sysfs_add_server(struct nfs_server *server);
+void nfs_sysfs_remove_server(struct nfs_server *server);
+
 #endif
@@ -204,6 +204,7 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	loff_t data_pos = -1;
 	loff_t hole_len;
 	bool skip_hole = false;
+	bool copy_range;
 	int error = 0;
 
 	ovl_path_lowerdata(dentry, &datapath);
@@ -224,6 +225,16 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 	if (old_file->f_mode & FMODE_LSEEK)
 		skip_hole = true;
 
+	/*
+	 * Filesystems with copy offload (e.g. NFS and CIFS server side copy)
+	 * can copy without bouncing the data through the page cache.  Call
+	 * ->copy_file_range() directly instead of vfs_copy_file_range(),
+	 * which would take freeze protection again on top of ovl_want_write().
+	 */
+	copy_range = new_file->f_op->copy_file_range &&
+		     old_file->f_op->copy_file_range ==
+				new_file->f_op->copy_file_range;
+
 	while (len) {
 		size_t this_len = OVL_COPY_UP_CHUNK_SIZE;
 		long bytes;
@@ -266,6 +277,20 @@ static int ovl_copy_up_file(struct ovl_fs *ofs, struct dentry *dentry,
 			}
 		}
 
+		if (copy_range) {
+			bytes = new_file->f_op->copy_file_range(old_file,
+						old_pos, new_file, new_pos,
+						this_len, 0);
+			if (bytes > 0) {
+				old_pos += bytes;
+				new_pos += bytes;
+				len -= bytes;
+				continue;
+			}
+			/* fall back to splice for the rest of the file */
+			copy_range = false;
+		}
+
 		bytes = do_splice_direct(old_file, &old_pos,
 					 new_file, &new_pos,
 					 this_len, SPLICE_F_MOVE);
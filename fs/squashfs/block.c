@@ -76,8 +76,8 @@ static int copy_bio_to_actor(struct bio *bio,
 	return copied_bytes;
 }
 
-static int squashfs_bio_read(struct super_block *sb, u64 index, int length,
-			     struct bio **biop, int *block_offset)
+static int squashfs_bio_alloc(struct super_block *sb, u64 index, int length,
+			      struct bio **biop, int *block_offset)
 {
 	struct squashfs_sb_info *msblk = sb->s_fs_info;
 	const u64 read_start = round_down(index, msblk->devblksize);
@@ -113,10 +113,6 @@ static int squashfs_bio_read(struct super_block *sb, u64 index, int length,
 		total_len -= len;
 	}
 
-	error = submit_bio_wait(bio);
-	if (error)
-		goto out_free_bio;
-
 	*biop = bio;
 	*block_offset = index & ((1 << msblk->devblksize_log2) - 1);
 	return 0;
@@ -128,6 +124,28 @@ static int squashfs_bio_read(struct super_block *sb, u64 index, int length,
 	return error;
 }
 
+static int squashfs_bio_read(struct super_block *sb, u64 index, int length,
+			     struct bio **biop, int *block_offset)
+{
+	struct bio *bio;
+	int error;
+
+	error = squashfs_bio_alloc(sb, index, length, &bio, block_offset);
+	if (error)
+		return error;
+
+	error = submit_bio_wait(bio);
+	if (error) {
+		bio_free_pages(bio);
+		bio_uninit(bio);
+		kfree(bio);
+		return error;
+	}
+
+	*biop = bio;
+	return 0;
+}
+
 /*
  * Read and decompress a metadata block or datablock.  Length is non-zero
  * if a datablock is being read (the size is stored elsewhere in the
@@ -234,3 +252,101 @@ int squashfs_read_data(struct super_block *sb, u64 index, int length,
 
 	return res;
 }
+
+static void squashfs_read_error(struct squashfs_sb_info *msblk, u64 index,
+				int res)
+{
+	ERROR("Failed to read block 0x%llx: %d\n", index, res);
+	if (msblk->panic_on_errors)
+		panic("squashfs read failed");
+}
+
+static void squashfs_bio_end_io(struct bio *bio)
+{
+	struct squashfs_bio_req *req = bio->bi_private;
+
+	complete(&req->done);
+}
+
+/*
+ * Start reading a datablock without waiting for the I/O, so that the caller
+ * can overlap it with decompressing an earlier block.  Every request started
+ * successfully must be finished with squashfs_read_data_end().
+ */
+int squashfs_read_data_start(struct super_block *sb, u64 index, int length,
+			     struct squashfs_bio_req *req)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+	int res;
+
+	req->index = index;
+	req->compressed = SQUASHFS_COMPRESSED_BLOCK(length);
+	req->length = SQUASHFS_COMPRESSED_SIZE_BLOCK(length);
+	TRACE("Block @ 0x%llx, %scompressed size %d (async)\n", index,
+	      req->compressed ? "" : "un", req->length);
+
+	if (req->length < 0 || req->length > msblk->block_size ||
+			(index + req->length) > msblk->bytes_used) {
+		res = -EIO;
+		goto out;
+	}
+
+	res = squashfs_bio_alloc(sb, index, req->length, &req->bio,
+				 &req->offset);
+	if (res)
+		goto out;
+
+	init_completion(&req->done);
+	req->bio->bi_private = req;
+	req->bio->bi_end_io = squashfs_bio_end_io;
+	submit_bio(req->bio);
+	return 0;
+
+out:
+	squashfs_read_error(msblk, index, res);
+	return res;
+}
+
+/*
+ * Wait for a datablock read started by squashfs_read_data_start() and
+ * decompress it into the output actor.  Returns the number of bytes
+ * decompressed or a negative errno, like squashfs_read_data().
+ */
+int squashfs_read_data_end(struct super_block *sb, struct squashfs_bio_req *req,
+			   struct squashfs_page_actor *output)
+{
+	struct squashfs_sb_info *msblk = sb->s_fs_info;
+	struct bio *bio = req->bio;
+	int res;
+
+	wait_for_completion_io(&req->done);
+
+	res = blk_status_to_errno(bio->bi_status);
+	if (res)
+		goto out_free_bio;
+
+	if (req->length > output->length) {
+		res = -EIO;
+		goto out_free_bio;
+	}
+
+	if (req->compressed) {
+		if (!msblk->stream) {
+			res = -EIO;
+			goto out_free_bio;
+		}
+		res = squashfs_decompress(msblk, bio, req->offset, req->length,
+					  output);
+	} else {
+		res = copy_bio_to_actor(bio, output, req->offset, req->length);
+	}
+
+out_free_bio:
+	bio_free_pages(bio);
+	bio_uninit(bio);
+	kfree(bio);
+	if (res < 0)
+		squashfs_read_error(msblk, req->index, res);
+
+	return res;
+}
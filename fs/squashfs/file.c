@@ -533,102 +533,157 @@ static int squashfs_readahead_fragment(struct page **page,
 	return error;
 }
 
-static void squashfs_readahead(struct readahead_control *ractl)
+/* A block of the readahead window, possibly with its read in flight */
+struct squashfs_ra_block {
+	struct page			**pages;
+	unsigned int			nr_pages;
+	unsigned int			expected;
+	pgoff_t				index;
+	struct squashfs_page_actor	*actor;
+	struct squashfs_bio_req		req;
+};
+
+static void squashfs_readahead_release(struct squashfs_ra_block *blk)
+{
+	int i;
+
+	for (i = 0; i < blk->nr_pages; i++) {
+		unlock_page(blk->pages[i]);
+		put_page(blk->pages[i]);
+	}
+}
+
+/*
+ * Grab the pages of the next block in the readahead window and start reading
+ * it from the device.  The tail end fragment is read synchronously through the
+ * fragment cache.  Returns false once there is nothing more to read.
+ */
+static bool squashfs_readahead_start(struct readahead_control *ractl,
+				     struct squashfs_ra_block *blk,
+				     loff_t start)
 {
 	struct inode *inode = ractl->mapping->host;
 	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
-	size_t mask = (1UL << msblk->block_log) - 1;
 	unsigned short shift = msblk->block_log - PAGE_SHIFT;
-	loff_t start = readahead_pos(ractl) & ~mask;
-	size_t len = readahead_length(ractl) + readahead_pos(ractl) - start;
-	struct squashfs_page_actor *actor;
-	unsigned int nr_pages = 0;
-	struct page **pages;
-	int i, file_end = i_size_read(inode) >> msblk->block_log;
-	unsigned int max_pages = 1UL << shift;
-
-	readahead_expand(ractl, start, (len | mask) + 1);
-
-	pages = kmalloc_array(max_pages, sizeof(void *), GFP_KERNEL);
-	if (!pages)
-		return;
+	int file_end = i_size_read(inode) >> msblk->block_log;
+	unsigned int max_pages;
+	u64 block = 0;
+	int bsize;
 
 	for (;;) {
-		pgoff_t index;
-		int res, bsize;
-		u64 block = 0;
-		unsigned int expected;
-		struct page *last_page;
-
-		expected = start >> msblk->block_log == file_end ?
+		blk->expected = start >> msblk->block_log == file_end ?
 			   (i_size_read(inode) & (msblk->block_size - 1)) :
 			    msblk->block_size;
 
-		max_pages = (expected + PAGE_SIZE - 1) >> PAGE_SHIFT;
+		max_pages = (blk->expected + PAGE_SIZE - 1) >> PAGE_SHIFT;
 
-		nr_pages = __readahead_batch(ractl, pages, max_pages);
-		if (!nr_pages)
-			break;
+		blk->nr_pages = __readahead_batch(ractl, blk->pages, max_pages);
+		if (!blk->nr_pages)
+			return false;
 
 		if (readahead_pos(ractl) >= i_size_read(inode))
 			goto skip_pages;
 
-		index = pages[0]->index >> shift;
+		blk->index = blk->pages[0]->index >> shift;
 
-		if ((pages[nr_pages - 1]->index >> shift) != index)
+		if ((blk->pages[blk->nr_pages - 1]->index >> shift) != blk->index)
 			goto skip_pages;
 
-		if (index == file_end && squashfs_i(inode)->fragment_block !=
-						SQUASHFS_INVALID_BLK) {
-			res = squashfs_readahead_fragment(pages, nr_pages,
-							  expected);
-			if (res)
-				goto skip_pages;
-			continue;
-		}
+		if (blk->index != file_end || squashfs_i(inode)->fragment_block ==
+						SQUASHFS_INVALID_BLK)
+			break;
 
-		bsize = read_blocklist(inode, index, &block);
-		if (bsize == 0)
+		if (squashfs_readahead_fragment(blk->pages, blk->nr_pages,
+						blk->expected))
 			goto skip_pages;
+	}
 
-		actor = squashfs_page_actor_init_special(msblk, pages, nr_pages,
-							 expected);
-		if (!actor)
-			goto skip_pages;
+	bsize = read_blocklist(inode, blk->index, &block);
+	if (bsize == 0)
+		goto skip_pages;
 
-		res = squashfs_read_data(inode->i_sb, block, bsize, NULL, actor);
+	blk->actor = squashfs_page_actor_init_special(msblk, blk->pages,
+						      blk->nr_pages,
+						      blk->expected);
+	if (!blk->actor)
+		goto skip_pages;
 
-		last_page = squashfs_page_actor_free(actor);
+	if (squashfs_read_data_start(inode->i_sb, block, bsize, &blk->req)) {
+		squashfs_page_actor_free(blk->actor);
+		goto skip_pages;
+	}
 
-		if (res == expected) {
-			int bytes;
+	return true;
 
-			/* Last page (if present) may have trailing bytes not filled */
-			bytes = res % PAGE_SIZE;
-			if (index == file_end && bytes && last_page)
-				memzero_page(last_page, bytes,
-					     PAGE_SIZE - bytes);
+skip_pages:
+	squashfs_readahead_release(blk);
+	return false;
+}
 
-			for (i = 0; i < nr_pages; i++) {
-				flush_dcache_page(pages[i]);
-				SetPageUptodate(pages[i]);
-			}
-		}
+static void squashfs_readahead_finish(struct inode *inode,
+				      struct squashfs_ra_block *blk)
+{
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	int file_end = i_size_read(inode) >> msblk->block_log;
+	struct page *last_page;
+	int i, res;
+
+	res = squashfs_read_data_end(inode->i_sb, &blk->req, blk->actor);
+
+	last_page = squashfs_page_actor_free(blk->actor);
+
+	if (res == blk->expected) {
+		int bytes;
 
-		for (i = 0; i < nr_pages; i++) {
-			unlock_page(pages[i]);
-			put_page(pages[i]);
+		/* Last page (if present) may have trailing bytes not filled */
+		bytes = res % PAGE_SIZE;
+		if (blk->index == file_end && bytes && last_page)
+			memzero_page(last_page, bytes,
+				     PAGE_SIZE - bytes);
+
+		for (i = 0; i < blk->nr_pages; i++) {
+			flush_dcache_page(blk->pages[i]);
+			SetPageUptodate(blk->pages[i]);
 		}
 	}
 
-	kfree(pages);
-	return;
+	squashfs_readahead_release(blk);
+}
 
-skip_pages:
-	for (i = 0; i < nr_pages; i++) {
-		unlock_page(pages[i]);
-		put_page(pages[i]);
+static void squashfs_readahead(struct readahead_control *ractl)
+{
+	struct inode *inode = ractl->mapping->host;
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	size_t mask = (1UL << msblk->block_log) - 1;
+	unsigned short shift = msblk->block_log - PAGE_SHIFT;
+	loff_t start = readahead_pos(ractl) & ~mask;
+	size_t len = readahead_length(ractl) + readahead_pos(ractl) - start;
+	unsigned int max_pages = 1UL << shift;
+	struct squashfs_ra_block blk[2], *cur = &blk[0], *next = &blk[1];
+	struct page **pages;
+	bool more;
+
+	readahead_expand(ractl, start, (len | mask) + 1);
+
+	pages = kmalloc_array(2 * max_pages, sizeof(void *), GFP_KERNEL);
+	if (!pages)
+		return;
+
+	blk[0].pages = pages;
+	blk[1].pages = pages + max_pages;
+
+	/*
+	 * Keep the device read of the following block in flight while the
+	 * current one is decompressed, so that I/O latency overlaps with the
+	 * decompression instead of being serialised behind it.
+	 */
+	more = squashfs_readahead_start(ractl, cur, start);
+	while (more) {
+		more = squashfs_readahead_start(ractl, next, start);
+		squashfs_readahead_finish(inode, cur);
+		swap(cur, next);
 	}
+
 	kfree(pages);
 }
 
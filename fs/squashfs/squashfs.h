@@ -17,6 +17,11 @@
 /* block.c */
 extern int squashfs_read_data(struct super_block *, u64, int, u64 *,
 				struct squashfs_page_actor *);
+extern int squashfs_read_data_start(struct super_block *, u64, int,
+				struct squashfs_bio_req *);
+extern int squashfs_read_data_end(struct super_block *,
+				struct squashfs_bio_req *,
+				struct squashfs_page_actor *);
 
 /* cache.c */
 extern struct squashfs_cache *squashfs_cache_init(char *, int, int);
@@ -40,6 +40,16 @@ struct squashfs_cache_entry {
 	struct squashfs_page_actor	*actor;
 };
 
+/* An asynchronous datablock read, see squashfs_read_data_start() */
+struct squashfs_bio_req {
+	struct bio				*bio;
+	struct completion			done;
+	u64					index;
+	int					length;
+	int					offset;
+	bool					compressed;
+};
+
 struct squashfs_sb_info {
 	const struct squashfs_decompressor	*decompressor;
 	int					devblksize;
@@ -186,6 +186,25 @@ struct drm_fb_helper {
 	 * See also: @deferred_setup
 	 */
 	int preferred_bpp;
+
+#ifdef CONFIG_FB_DEFERRED_IO
+	/**
+	 * @fbdefio:
+	 *
+	 * Deferred I/O handler used by the generic fbdev emulation when it
+	 * renders into a shadow buffer. Its delay is adjusted to the rate at
+	 * which the client writes.
+	 */
+	struct fb_deferred_io fbdefio;
+
+	/**
+	 * @defio_flush:
+	 *
+	 * Time in jiffies of the last run of drm_fb_helper_deferred_io() on
+	 * @fbdefio.
+	 */
+	unsigned long defio_flush;
+#endif
 };
 
 static inline struct drm_fb_helper *
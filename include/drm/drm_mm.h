@@ -549,5 +549,6 @@ bool drm_mm_scan_remove_block(struct drm_mm_scan *scan,
 struct drm_mm_node *drm_mm_scan_color_evict(struct drm_mm_scan *scan);
 
 void drm_mm_print(const struct drm_mm *mm, struct drm_printer *p);
+void drm_mm_print_stats(const struct drm_mm *mm, struct drm_printer *p);
 
 #endif
@@ -286,6 +286,11 @@ struct drm_sched_fence *to_drm_sched_fence(struct dma_fence *f);
  * @s_priority: the priority of the job.
  * @entity: the entity to which this job belongs.
  * @cb: the callback for the parent fence in s_fence.
+ * @credits: the number of credits this job takes from the scheduler's
+ *           hardware queue, see &drm_gpu_scheduler.hw_submission_limit.
+ *           Set to 1 by drm_sched_job_init(), drivers whose jobs take
+ *           a variable share of the ring may change it before
+ *           drm_sched_job_arm().
  *
  * A job is created by the driver using drm_sched_job_init(), and
  * should call drm_sched_entity_push_job() once it wants the scheduler
@@ -311,6 +316,7 @@ struct drm_sched_job {
 	enum drm_sched_priority		s_priority;
 	struct drm_sched_entity         *entity;
 	struct dma_fence_cb		cb;
+	u32				credits;
 	/**
 	 * @dependencies:
 	 *
@@ -324,6 +330,9 @@ struct drm_sched_job {
 	unsigned long			last_dependency;
 };
 
+#define to_drm_sched_job(sched_job)		\
+		container_of((sched_job), struct drm_sched_job, queue_node)
+
 static inline bool drm_sched_invalidate_job(struct drm_sched_job *s_job,
 					    int threshold)
 {
@@ -420,7 +429,7 @@ struct drm_sched_backend_ops {
  * struct drm_gpu_scheduler - scheduler instance-specific data
  *
  * @ops: backend operations provided by the driver.
- * @hw_submission_limit: the max size of the hardware queue.
+ * @hw_submission_limit: the max size of the hardware queue, in job credits.
  * @timeout: the time after which a job is removed from the scheduler.
  * @name: name of the ring for which this scheduler is being used.
  * @sched_rq: priority wise array of run queues.
@@ -430,6 +439,8 @@ struct drm_sched_backend_ops {
  *                 waits on this wait queue until all the scheduled jobs are
  *                 finished.
  * @hw_rq_count: the number of jobs currently in the hardware queue.
+ * @credit_count: the number of credits taken by the jobs currently in the
+ *                hardware queue.
  * @job_id_count: used to assign unique id to the each job.
  * @timeout_wq: workqueue used to queue @work_tdr
  * @work_tdr: schedules a delayed call to @drm_sched_job_timedout after the
@@ -456,6 +467,7 @@ struct drm_gpu_scheduler {
 	wait_queue_head_t		wake_up_worker;
 	wait_queue_head_t		job_scheduled;
 	atomic_t			hw_rq_count;
+	atomic_t			credit_count;
 	atomic64_t			job_id_count;
 	struct workqueue_struct		*timeout_wq;
 	struct delayed_work		work_tdr;
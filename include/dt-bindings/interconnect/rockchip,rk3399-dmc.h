@@ -0,0 +1,12 @@
+/* SPDX-License-Identifier: (GPL-2.0-only OR BSD-2-Clause) */
+/*
+ * Interconnect node ids of the RK3399 DMC
+ */
+
+#ifndef __DT_BINDINGS_INTERCONNECT_ROCKCHIP_RK3399_DMC_H
+#define __DT_BINDINGS_INTERCONNECT_ROCKCHIP_RK3399_DMC_H
+
+#define RK3399_DMC_MASTER	0
+#define RK3399_DMC_DRAM		1
+
+#endif /* __DT_BINDINGS_INTERCONNECT_ROCKCHIP_RK3399_DMC_H */
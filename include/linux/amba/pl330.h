@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * linux/amba/pl330.h - ARM PrimeCell PL330 DMAC client configuration
+ */
+
+#ifndef AMBA_PL330_H
+#define AMBA_PL330_H
+
+/**
+ * struct pl330_slave_config - pl330 specific part of a slave config
+ * @cyclic_irq: complete cyclic periods straight from the DMAC interrupt
+ *	handler rather than from the channel tasklet. The period callback
+ *	then runs in hard-irq context.
+ *
+ * Passed as &dma_slave_config.peripheral_config.
+ */
+struct pl330_slave_config {
+	bool cyclic_irq;
+};
+
+#endif /* AMBA_PL330_H */
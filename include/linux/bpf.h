@@ -137,6 +137,11 @@ struct bpf_map_ops {
 	/* Misc helpers.*/
 	int (*map_redirect)(struct bpf_map *map, u32 ifindex, u64 flags);
 
+	/* Memory currently used by the map, reported as memlock in fdinfo.
+	 * Maps without it report an estimate based on max_entries.
+	 */
+	u64 (*map_mem_usage)(const struct bpf_map *map);
+
 	/* map_meta_equal must be implemented for maps that can be
 	 * used as an inner map.  It is a runtime check to ensure
 	 * an inner map can be inserted to an outer map.
@@ -1783,6 +1788,7 @@ bpf_map_alloc_percpu(const struct bpf_map *map, size_t size, size_t align,
 #endif
 
 extern int sysctl_unprivileged_bpf_disabled;
+extern unsigned int sysctl_bpf_verifier_max_states;
 
 static inline bool bpf_allow_ptr_leaks(void)
 {
@@ -1865,6 +1871,9 @@ struct bpf_iter_aux_info {
 	struct {
 		enum bpf_iter_task_type	type;
 		u32 pid;
+		u32 flags;
+		/* local_clock() when the last iterator was created */
+		atomic64_t last_iter;
 	} task;
 };
 
@@ -15,6 +15,8 @@ struct bpf_mem_alloc {
 };
 
 int bpf_mem_alloc_init(struct bpf_mem_alloc *ma, int size, bool percpu);
+void bpf_mem_alloc_reserve(struct bpf_mem_alloc *ma, int cnt);
+u64 bpf_mem_alloc_cached_size(struct bpf_mem_alloc *ma);
 void bpf_mem_alloc_destroy(struct bpf_mem_alloc *ma);
 
 /* kmalloc/kfree equivalent: */
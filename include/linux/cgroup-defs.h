@@ -25,6 +25,7 @@
 #ifdef CONFIG_CGROUPS
 
 struct cgroup;
+struct cgroup_psi_action;
 struct cgroup_root;
 struct cgroup_subsys;
 struct cgroup_taskset;
@@ -476,6 +477,8 @@ struct cgroup {
 	/* per-cpu recursive resource statistics */
 	struct cgroup_rstat_cpu __percpu *rstat_cpu;
 	struct list_head rstat_css_list;
+	/* jiffies at the start of the last flush of this subtree */
+	unsigned long rstat_flush_time;
 
 	/* cgroup basic resource statistics */
 	struct cgroup_base_stat last_bstat;
@@ -498,6 +501,9 @@ struct cgroup {
 	/* used to track pressure stalls */
 	struct psi_group *psi;
 
+	/* in-kernel reaction to memory pressure, protected by cgroup_mutex */
+	struct cgroup_psi_action *psi_action;
+
 	/* used to store eBPF programs */
 	struct cgroup_bpf bpf;
 
@@ -112,6 +112,9 @@ enum mmc_err_stat {
 	MMC_ERR_MAX,
 };
 
+/* Requests in flight at issue time: 1, 2, 3-4, 5-8, 9-16, 17+ */
+#define MMC_QDEPTH_BUCKETS	6
+
 struct mmc_host_ops {
 	/*
 	 * It is optional for the host to implement pre_req and post_req in
@@ -479,6 +482,8 @@ struct mmc_host {
 	struct work_struct	sdio_irq_work;
 	bool			sdio_irq_pending;
 	atomic_t		sdio_irq_thread_abort;
+	int			sdio_irq_cpu;	/* CPU for SDIO IRQ processing */
+	unsigned int		sdio_irq_poll_us; /* busy poll window */
 
 	mmc_pm_flag_t		pm_flags;	/* requested pm features */
 
@@ -521,6 +526,8 @@ struct mmc_host {
 	bool			hsq_enabled;
 
 	u32			err_stats[MMC_ERR_MAX];
+	u32			qdepth_stats[MMC_QDEPTH_BUCKETS];
+	u32			qdepth_max;
 	unsigned long		private[] ____cacheline_aligned;
 };
 
@@ -661,6 +668,15 @@ static inline void mmc_debugfs_err_stats_inc(struct mmc_host *host,
 	host->err_stats[stat] += 1;
 }
 
+static inline void mmc_debugfs_qdepth_inc(struct mmc_host *host,
+					  unsigned int depth)
+{
+	host->qdepth_stats[min_t(unsigned int, order_base_2(depth),
+				 MMC_QDEPTH_BUCKETS - 1)] += 1;
+	if (depth > host->qdepth_max)
+		host->qdepth_max = depth;
+}
+
 int mmc_send_tuning(struct mmc_host *host, u32 opcode, int *cmd_error);
 int mmc_send_abort_tuning(struct mmc_host *host, u32 opcode);
 int mmc_get_ext_csd(struct mmc_card *card, u8 **new_ext_csd);
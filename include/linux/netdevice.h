@@ -1985,6 +1985,8 @@ enum netdev_ml_priv_type {
  *	@wol_enabled:	Wake-on-LAN is enabled
  *
  *	@threaded:	napi threaded mode is enabled
+ *	@threaded_cpus:	CPUs the napi threads may run on, all if empty
+ *	@threaded_cpus_gen:	bumped whenever @threaded_cpus changes
  *
  *	@net_notifier_list:	List of per-net netdev notifier block
  *				that follow this device when it is moved
@@ -2343,6 +2345,8 @@ struct net_device {
 	bool			proto_down;
 	unsigned		wol_enabled:1;
 	unsigned		threaded:1;
+	cpumask_var_t		threaded_cpus;
+	unsigned int		threaded_cpus_gen;
 
 	struct list_head	net_notifier_list;
 
@@ -3014,7 +3018,7 @@ u16 dev_pick_tx_cpu_id(struct net_device *dev, struct sk_buff *skb,
 		       struct net_device *sb_dev);
 
 int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev);
-int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id);
+int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id, bool more);
 
 static inline int dev_queue_xmit(struct sk_buff *skb)
 {
@@ -3031,7 +3035,7 @@ static inline int dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
 {
 	int ret;
 
-	ret = __dev_direct_xmit(skb, queue_id);
+	ret = __dev_direct_xmit(skb, queue_id, false);
 	if (!dev_xmit_complete(ret))
 		kfree_skb(skb);
 	return ret;
@@ -3128,6 +3132,10 @@ struct softnet_data {
 	unsigned int		processed;
 	unsigned int		time_squeeze;
 	unsigned int		received_rps;
+	unsigned int		gro_merged;
+	unsigned int		gro_fraglist;
+	unsigned int		skb_data_cache_hit;
+	unsigned int		skb_data_cache_miss;
 #ifdef CONFIG_RPS
 	struct softnet_data	*rps_ipi_list;
 #endif
@@ -5,6 +5,7 @@
 #include <linux/list.h>
 #include <linux/backing-dev.h>
 #include <linux/idr.h>
+#include <linux/kobject.h>
 #include <linux/wait.h>
 #include <linux/nfs_xdr.h>
 #include <linux/sunrpc/xprt.h>
@@ -140,6 +141,8 @@ struct nfs_server {
 	struct nfs_iostats __percpu *io_stats;	/* I/O statistics */
 	atomic_long_t		writeback;	/* number of writeback pages */
 	unsigned int		write_congested;/* flag set when writeback gets too high */
+	atomic_t		read_inflight;	/* read RPCs in flight */
+	atomic_t		write_inflight;	/* write RPCs in flight */
 	unsigned int		flags;		/* various flags */
 
 /* The following are for internal use only. Also see uapi/linux/nfs_mount.h */
@@ -189,6 +192,16 @@ struct nfs_server {
 	unsigned long		mount_time;	/* when this fs was mounted */
 	struct super_block	*super;		/* VFS super block */
 	dev_t			s_dev;		/* superblock dev numbers */
+	struct kobject		kobj;		/* /sys/fs/nfs/<s_dev> */
+
+	/* Read throughput sampling, see nfs_read_sample() */
+	spinlock_t		ra_lock;
+	bool			ra_autoscale;	/* size readahead from samples */
+	unsigned long		ra_window_start;/* jiffies */
+	u64			ra_window_bytes;
+	unsigned long		ra_rtt_start;	/* jiffies */
+	u32			ra_rtt_min_us;	/* min read RTT since ra_rtt_start */
+	u64			read_bytes_per_sec;/* last sampled read throughput */
 	struct nfs_auth_info	auth_info;	/* parsed auth flavors */
 
 #ifdef CONFIG_NFS_FSCACHE
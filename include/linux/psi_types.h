@@ -140,6 +140,9 @@ struct psi_trigger {
 	/* Kernfs file for cgroup triggers */
 	struct kernfs_open_file *of;
 
+	/* In-kernel action queued instead of notifying userspace */
+	struct work_struct *action;
+
 	/* Pending event flag */
 	int event;
 
@@ -387,6 +387,9 @@ struct sched_info {
 	/* When were we last queued to run? */
 	unsigned long long		last_queued;
 
+	/* When did we last get off a CPU? */
+	unsigned long long		last_departure;
+
 #endif /* CONFIG_SCHED_INFO */
 };
 
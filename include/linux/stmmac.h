@@ -218,6 +218,7 @@ struct plat_stmmacenet_data {
 	u32 host_dma_width;
 	u32 rx_queues_to_use;
 	u32 tx_queues_to_use;
+	unsigned int dma_tx_size;
 	u8 rx_sched_algorithm;
 	u8 tx_sched_algorithm;
 	struct stmmac_rxq_cfg rx_queues_cfg[MTL_MAX_RX_QUEUES];
@@ -250,6 +251,8 @@ struct plat_stmmacenet_data {
 	bool has_sun8i;
 	bool tso_en;
 	int rss_en;
+	unsigned int rx_fill_batch;
+	bool rx_dim_en;
 	int mac_port_sel_speed;
 	bool en_tx_lpi_clockgating;
 	bool rx_clk_runs_in_lpi;
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef __SOC_ROCKCHIP_OPP_H__
+#define __SOC_ROCKCHIP_OPP_H__
+
+#include <linux/errno.h>
+
+struct device;
+
+/* Bins are used as opp-supported-hw bits, so there can't be more than 32 */
+#define ROCKCHIP_OPP_MAX_BINS	32
+
+#ifdef CONFIG_ROCKCHIP_OPP
+
+int rockchip_opp_get_leakage_bin(struct device *dev);
+
+#else /* CONFIG_ROCKCHIP_OPP */
+
+static inline int rockchip_opp_get_leakage_bin(struct device *dev)
+{
+	return -ENOENT;
+}
+
+#endif /* CONFIG_ROCKCHIP_OPP */
+
+#endif /* __SOC_ROCKCHIP_OPP_H__ */
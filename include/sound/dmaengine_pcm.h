@@ -109,6 +109,12 @@ int snd_dmaengine_pcm_refine_runtime_hwparams(
  * playback.
  */
 #define SND_DMAENGINE_PCM_FLAG_HALF_DUPLEX BIT(3)
+/*
+ * Let applications disable period wakeups and schedule on their own timers.
+ * Only takes effect if the DMA channels report the residue with burst
+ * granularity or better, the pointer is then exact at any time.
+ */
+#define SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP BIT(4)
 
 /**
  * struct snd_dmaengine_pcm_config - Configuration data for dmaengine based PCM
@@ -2051,6 +2051,36 @@ TRACE_EVENT(f2fs_iostat_latency,
 		__entry->n_wr_as_peak, __entry->n_wr_as_avg, __entry->n_wr_as_cnt,
 		__entry->m_wr_as_peak, __entry->m_wr_as_avg, __entry->m_wr_as_cnt)
 );
+
+TRACE_EVENT(f2fs_iostat_lat_hist,
+
+	TP_PROTO(struct f2fs_sb_info *sbi, int io, int type, unsigned int *hist),
+
+	TP_ARGS(sbi, io, type, hist),
+
+	TP_STRUCT__entry(
+		__field(dev_t,	dev)
+		__field(int,	io)
+		__field(int,	type)
+		__array(unsigned int,	hist, IOSTAT_LAT_HIST_BUCKETS)
+	),
+
+	TP_fast_assign(
+		__entry->dev	= sbi->sb->s_dev;
+		__entry->io	= io;
+		__entry->type	= type;
+		memcpy(__entry->hist, hist, sizeof(__entry->hist));
+	),
+
+	TP_printk("dev = (%d,%d), iotype = %s_%s, "
+		"bios per latency(us) bucket <1,<2,...,<2^22,inf = %s",
+		show_dev(__entry->dev),
+		__print_symbolic(__entry->io,
+			{ 0, "rd" }, { 1, "wr_sync" }, { 2, "wr_async" }),
+		show_block_type(__entry->type),
+		__print_array(__entry->hist, IOSTAT_LAT_HIST_BUCKETS,
+			sizeof(unsigned int)))
+);
 #endif
 
 TRACE_EVENT(f2fs_bmap,
@@ -189,9 +189,10 @@ DEFINE_EVENT(xdp_redirect_template, xdp_redirect_map_err,
 TRACE_EVENT(xdp_cpumap_kthread,
 
 	TP_PROTO(int map_id, unsigned int processed,  unsigned int drops,
-		 int sched, struct xdp_cpumap_stats *xdp_stats),
+		 int sched, struct xdp_cpumap_stats *xdp_stats,
+		 unsigned int gro_merged),
 
-	TP_ARGS(map_id, processed, drops, sched, xdp_stats),
+	TP_ARGS(map_id, processed, drops, sched, xdp_stats, gro_merged),
 
 	TP_STRUCT__entry(
 		__field(int, map_id)
@@ -203,6 +204,7 @@ TRACE_EVENT(xdp_cpumap_kthread,
 		__field(unsigned int, xdp_pass)
 		__field(unsigned int, xdp_drop)
 		__field(unsigned int, xdp_redirect)
+		__field(unsigned int, gro_merged)
 	),
 
 	TP_fast_assign(
@@ -215,18 +217,21 @@ TRACE_EVENT(xdp_cpumap_kthread,
 		__entry->xdp_pass	= xdp_stats->pass;
 		__entry->xdp_drop	= xdp_stats->drop;
 		__entry->xdp_redirect	= xdp_stats->redirect;
+		__entry->gro_merged	= gro_merged;
 	),
 
 	TP_printk("kthread"
 		  " cpu=%d map_id=%d action=%s"
 		  " processed=%u drops=%u"
 		  " sched=%d"
-		  " xdp_pass=%u xdp_drop=%u xdp_redirect=%u",
+		  " xdp_pass=%u xdp_drop=%u xdp_redirect=%u"
+		  " gro_merged=%u",
 		  __entry->cpu, __entry->map_id,
 		  __print_symbolic(__entry->act, __XDP_ACT_SYM_TAB),
 		  __entry->processed, __entry->drops,
 		  __entry->sched,
-		  __entry->xdp_pass, __entry->xdp_drop, __entry->xdp_redirect)
+		  __entry->xdp_pass, __entry->xdp_drop, __entry->xdp_redirect,
+		  __entry->gro_merged)
 );
 
 TRACE_EVENT(xdp_cpumap_enqueue,
@@ -21,6 +21,8 @@ extern "C" {
 #define DRM_PANFROST_PERFCNT_ENABLE		0x06
 #define DRM_PANFROST_PERFCNT_DUMP		0x07
 #define DRM_PANFROST_MADVISE			0x08
+#define DRM_PANFROST_BATCH_SUBMIT		0x09
+#define DRM_PANFROST_PERFCNT_RING		0x0a
 
 #define DRM_IOCTL_PANFROST_SUBMIT		DRM_IOW(DRM_COMMAND_BASE + DRM_PANFROST_SUBMIT, struct drm_panfrost_submit)
 #define DRM_IOCTL_PANFROST_WAIT_BO		DRM_IOW(DRM_COMMAND_BASE + DRM_PANFROST_WAIT_BO, struct drm_panfrost_wait_bo)
@@ -29,6 +31,7 @@ extern "C" {
 #define DRM_IOCTL_PANFROST_GET_PARAM		DRM_IOWR(DRM_COMMAND_BASE + DRM_PANFROST_GET_PARAM, struct drm_panfrost_get_param)
 #define DRM_IOCTL_PANFROST_GET_BO_OFFSET	DRM_IOWR(DRM_COMMAND_BASE + DRM_PANFROST_GET_BO_OFFSET, struct drm_panfrost_get_bo_offset)
 #define DRM_IOCTL_PANFROST_MADVISE		DRM_IOWR(DRM_COMMAND_BASE + DRM_PANFROST_MADVISE, struct drm_panfrost_madvise)
+#define DRM_IOCTL_PANFROST_BATCH_SUBMIT		DRM_IOW(DRM_COMMAND_BASE + DRM_PANFROST_BATCH_SUBMIT, struct drm_panfrost_batch_submit)
 
 /*
  * Unstable ioctl(s): only exposed when the unsafe unstable_ioctls module
@@ -38,8 +41,15 @@ extern "C" {
  */
 #define DRM_IOCTL_PANFROST_PERFCNT_ENABLE	DRM_IOW(DRM_COMMAND_BASE + DRM_PANFROST_PERFCNT_ENABLE, struct drm_panfrost_perfcnt_enable)
 #define DRM_IOCTL_PANFROST_PERFCNT_DUMP		DRM_IOW(DRM_COMMAND_BASE + DRM_PANFROST_PERFCNT_DUMP, struct drm_panfrost_perfcnt_dump)
+#define DRM_IOCTL_PANFROST_PERFCNT_RING		DRM_IOWR(DRM_COMMAND_BASE + DRM_PANFROST_PERFCNT_RING, struct drm_panfrost_perfcnt_ring)
 
 #define PANFROST_JD_REQ_FS (1 << 0)
+/*
+ * Don't wait for the implicit fences of the BOs referenced by the job, only
+ * for the in_syncs. The job's fence is still added to the BOs, so WAIT_BO and
+ * importers of those BOs keep seeing it.
+ */
+#define PANFROST_JD_REQ_NO_IMPLICIT_SYNC (1 << 1)
 /**
  * struct drm_panfrost_submit - ioctl argument for submitting commands to the 3D
  * engine.
@@ -70,6 +80,45 @@ struct drm_panfrost_submit {
 	__u32 requirements;
 };
 
+#define PANFROST_BATCH_SUBMIT_MAX_JOBS 64
+
+/**
+ * struct drm_panfrost_batch_job - one job chain of a DRM_PANFROST_BATCH_SUBMIT
+ *
+ * Same meaning as the corresponding fields of struct drm_panfrost_submit.
+ */
+struct drm_panfrost_batch_job {
+	__u64 jc;
+	__u64 in_syncs;
+	__u32 in_sync_count;
+	__u32 out_sync;
+	__u32 requirements;
+	__u32 pad;
+};
+
+/**
+ * struct drm_panfrost_batch_submit - ioctl argument for submitting several
+ * job chains that reference the same BOs.
+ *
+ * The jobs are queued in array order, as if each had been passed to
+ * DRM_PANFROST_SUBMIT with the shared BO list, so in_syncs may name the
+ * out_sync of an earlier job of the batch. If a job fails to be queued, the
+ * jobs before it have already been queued and their out_syncs updated.
+ */
+struct drm_panfrost_batch_submit {
+	/** Pointer to an array of struct drm_panfrost_batch_job. */
+	__u64 jobs;
+
+	/** Pointer to a u32 array of the BOs referenced by all the jobs. */
+	__u64 bo_handles;
+
+	/** Number of jobs, at most PANFROST_BATCH_SUBMIT_MAX_JOBS. */
+	__u32 job_count;
+
+	/** Number of BO handles passed in (size is that times 4). */
+	__u32 bo_handle_count;
+};
+
 /**
  * struct drm_panfrost_wait_bo - ioctl argument for waiting for
  * completion of the last DRM_PANFROST_SUBMIT on a BO.
@@ -87,6 +136,8 @@ struct drm_panfrost_wait_bo {
 /* Valid flags to pass to drm_panfrost_create_bo */
 #define PANFROST_BO_NOEXEC	1
 #define PANFROST_BO_HEAP	2
+/* Map the start of the heap at submit time instead of on the first fault */
+#define PANFROST_BO_HEAP_PREFAULT	4
 
 /**
  * struct drm_panfrost_create_bo - ioctl argument for creating Panfrost BOs.
@@ -204,6 +255,83 @@ struct drm_panfrost_perfcnt_dump {
 	__u64 buf_ptr;
 };
 
+/* Take a sample each time a job completes */
+#define PANFROST_PERFCNT_RING_SAMPLE_JOBS	(1 << 0)
+
+#define PANFROST_PERFCNT_RING_MAX_SAMPLES	1024
+
+/**
+ * struct drm_panfrost_perfcnt_ring - ioctl argument for sampling the
+ * performance counters into a ring buffer.
+ *
+ * Enabling the ring also enables the counters, as PERFCNT_ENABLE does, and
+ * PERFCNT_DUMP keeps working alongside it. The ring is a BO laid out as a
+ * struct drm_panfrost_perfcnt_ring_header followed by the sample slots, that
+ * user space maps with MMAP_BO and reads without further ioctls. Stopping
+ * the ring leaves the counters enabled until PERFCNT_ENABLE disables them or
+ * the file is closed.
+ */
+struct drm_panfrost_perfcnt_ring {
+	/** Start (1) or stop (0) sampling. */
+	__u32 enable;
+
+	/** Counter set to track, see struct drm_panfrost_perfcnt_enable. */
+	__u32 counterset;
+
+	/**
+	 * Sampling period in microseconds, at least 1000, or 0 for no
+	 * periodic sampling.
+	 */
+	__u32 period_us;
+
+	/** A combination of PANFROST_PERFCNT_RING_* */
+	__u32 flags;
+
+	/** Number of slots in the ring, at most PANFROST_PERFCNT_RING_MAX_SAMPLES. */
+	__u32 nr_samples;
+
+	/** Returned GEM handle of the ring BO. */
+	__u32 handle;
+};
+
+struct drm_panfrost_perfcnt_ring_header {
+	/**
+	 * Number of samples written so far. Sample n lives in slot
+	 * n % nr_samples, and is complete once head is greater than n.
+	 */
+	__u64 head;
+
+	__u32 nr_samples;
+
+	/** Offset of the first slot from the start of the BO. */
+	__u32 sample_offset;
+
+	/** Distance between two slots. */
+	__u32 sample_stride;
+
+	/**
+	 * Size of the counter dump at the start of each slot, as returned by
+	 * PERFCNT_DUMP. A struct drm_panfrost_perfcnt_sample_info follows it.
+	 */
+	__u32 counters_size;
+};
+
+#define PANFROST_PERFCNT_SAMPLE_TIMER	0
+#define PANFROST_PERFCNT_SAMPLE_JOB	1
+
+struct drm_panfrost_perfcnt_sample_info {
+	/** CLOCK_MONOTONIC time the sample was taken at. */
+	__u64 timestamp_ns;
+
+	/** Index of the sample, to spot the slots that were overwritten. */
+	__u64 seqno;
+
+	/** PANFROST_PERFCNT_SAMPLE_TIMER or PANFROST_PERFCNT_SAMPLE_JOB */
+	__u32 reason;
+
+	__u32 pad;
+};
+
 /* madvise provides a way to tell the kernel in case a buffers contents
  * can be discarded under memory pressure, which is useful for userspace
  * bo cache where we want to optimistically hold on to buffer allocate
@@ -115,9 +115,19 @@ union bpf_iter_link_info {
 		__u32	tid;
 		__u32	pid;
 		__u32	pid_fd;
+		__u32	flags;	/* BPF_ITER_TASK_F_* */
 	} task;
 };
 
+/* Flags for task iterators. */
+enum {
+	/* Only visit tasks that have been on a CPU since the previous
+	 * iterator was created from the same link. The first iterator
+	 * visits all tasks. Requires CONFIG_SCHED_INFO.
+	 */
+	BPF_ITER_TASK_F_CHANGED		= (1U << 0),
+};
+
 /* BPF syscall commands, see bpf(2) man-page for more details. */
 /**
  * DOC: eBPF Syscall Preamble
@@ -1255,6 +1265,12 @@ enum {
 	BPF_F_INNER_MAP		= (1U << 12),
 };
 
+/* BPF_MAP_TYPE_BLOOM_FILTER flags in map_extra, above the hash count. */
+enum {
+	/* Set all the bits of a value in one cache line */
+	BPF_BLOOM_F_BLOCKED	= (1U << 4),
+};
+
 /* Flags for BPF_PROG_QUERY. */
 
 /* Query effective (directly attached + inherited from ancestor cgroups)
@@ -1323,7 +1339,24 @@ union bpf_attr {
 		 *
 		 * BPF_MAP_TYPE_BLOOM_FILTER - the lowest 4 bits indicate the
 		 * number of hash functions (if 0, the bloom filter will default
-		 * to using 5 hash functions).
+		 * to using 5 hash functions). With BPF_BLOOM_F_BLOCKED, the
+		 * bits are derived from a single hash and all fall in the same
+		 * cache line, trading a slightly higher false positive rate
+		 * for one memory access per lookup.
+		 *
+		 * BPF_MAP_TYPE_RINGBUF - wakeup watermark in bytes. Without
+		 * BPF_RB_FORCE_WAKEUP, the consumer is only notified once the
+		 * committed data crosses this many bytes past its position (if
+		 * 0, it is notified as soon as a record is available). Must be
+		 * smaller than max_entries.
+		 *
+		 * BPF_MAP_TYPE_{LRU_,}{PERCPU_,}HASH - the lower 32 bits are
+		 * the number of hash buckets, a power of two no larger than
+		 * max_entries rounded up to a power of two (if 0, max_entries
+		 * rounded up is used). With BPF_F_NO_PREALLOC, the upper 32
+		 * bits are the number of free elements each CPU keeps ready
+		 * for updates, at most max_entries divided by the number of
+		 * possible CPUs (if 0, a small default is used).
 		 */
 		__u64	map_extra;
 	};
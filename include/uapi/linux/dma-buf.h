@@ -83,6 +83,23 @@ struct dma_buf_sync {
 #define DMA_BUF_SYNC_VALID_FLAGS_MASK \
 	(DMA_BUF_SYNC_RW | DMA_BUF_SYNC_END)
 
+/**
+ * struct dma_buf_sync_partial - Synchronize part of a buffer with CPU access.
+ *
+ * Like &struct dma_buf_sync, but only the byte range starting at @offset
+ * with @len bytes is made coherent. Exporters without ranged cache
+ * maintenance sync the whole buffer, so this is never less coherent than
+ * DMA_BUF_IOCTL_SYNC for the given range.
+ */
+struct dma_buf_sync_partial {
+	/** @flags: Set of access flags, as for &struct dma_buf_sync */
+	__u64 flags;
+	/** @offset: Start of the range, in bytes */
+	__u64 offset;
+	/** @len: Length of the range, in bytes */
+	__u64 len;
+};
+
 #define DMA_BUF_NAME_LEN	32
 
 /**
@@ -178,5 +195,6 @@ struct dma_buf_import_sync_file {
 #define DMA_BUF_SET_NAME_B	_IOW(DMA_BUF_BASE, 1, __u64)
 #define DMA_BUF_IOCTL_EXPORT_SYNC_FILE	_IOWR(DMA_BUF_BASE, 2, struct dma_buf_export_sync_file)
 #define DMA_BUF_IOCTL_IMPORT_SYNC_FILE	_IOW(DMA_BUF_BASE, 3, struct dma_buf_import_sync_file)
+#define DMA_BUF_IOCTL_SYNC_PARTIAL	_IOW(DMA_BUF_BASE, 4, struct dma_buf_sync_partial)
 
 #endif
@@ -165,6 +165,12 @@ enum {
  */
 #define IORING_SETUP_DEFER_TASKRUN	(1U << 13)
 
+/*
+ * SQPOLL thread spins for a time derived from the recent gaps between
+ * submissions, bounded by sq_thread_idle, instead of always sq_thread_idle.
+ */
+#define IORING_SETUP_SQ_ADAPTIVE	(1U << 24)
+
 enum io_uring_op {
 	IORING_OP_NOP,
 	IORING_OP_READV,
@@ -508,6 +514,12 @@ enum {
 	/* register a range of fixed file slots for automatic slot allocation */
 	IORING_REGISTER_FILE_ALLOC_RANGE	= 25,
 
+	/*
+	 * set/get min number of io-wq workers kept alive (and pre-spawned),
+	 * a count of (__u32)-1 leaves that one unchanged
+	 */
+	IORING_REGISTER_IOWQ_MIN_WORKERS	= 26,
+
 	/* this goes last */
 	IORING_REGISTER_LAST
 };
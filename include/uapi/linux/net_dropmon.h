@@ -94,6 +94,11 @@ enum net_dm_attr {
 	NET_DM_ATTR_HW_DROPS,			/* flag */
 	NET_DM_ATTR_FLOW_ACTION_COOKIE,		/* binary */
 	NET_DM_ATTR_REASON,			/* string */
+	NET_DM_ATTR_SAMPLE_RATE,		/* u32 */
+	NET_DM_ATTR_ALERT_INTERVAL,		/* u32 */
+	NET_DM_ATTR_SW_ENTRIES,			/* nested */
+	NET_DM_ATTR_SW_ENTRY,			/* nested */
+	NET_DM_ATTR_SW_DROP_COUNT,		/* u32 */
 
 	__NET_DM_ATTR_MAX,
 	NET_DM_ATTR_MAX = __NET_DM_ATTR_MAX - 1
@@ -104,10 +109,15 @@ enum net_dm_attr {
  * @NET_DM_ALERT_MODE_SUMMARY: A summary of recent drops is sent to user space.
  * @NET_DM_ALERT_MODE_PACKET: Each dropped packet is sent to user space along
  *                            with metadata.
+ * @NET_DM_ALERT_MODE_AGGREGATE: Drops are counted per location and reason and
+ *                               the counters are sent to user space once per
+ *                               alert interval, along with a sample of the
+ *                               dropped packets.
  */
 enum net_dm_alert_mode {
 	NET_DM_ALERT_MODE_SUMMARY,
 	NET_DM_ALERT_MODE_PACKET,
+	NET_DM_ALERT_MODE_AGGREGATE,
 };
 
 enum {
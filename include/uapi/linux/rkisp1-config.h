@@ -8,6 +8,7 @@
 #define _UAPI_RKISP1_CONFIG_H
 
 #include <linux/types.h>
+#include <linux/videodev2.h>
 
 /* Defect Pixel Cluster Detection */
 #define RKISP1_CIF_ISP_MODULE_DPCC		(1U << 0)
@@ -172,6 +173,27 @@
 #define RKISP1_CIF_ISP_STAT_AFM           (1U << 2)
 #define RKISP1_CIF_ISP_STAT_HIST          (1U << 3)
 
+/*
+ * Events
+ */
+#define V4L2_EVENT_RKISP1_CLASS		(V4L2_EVENT_PRIVATE_START | 0x100)
+#define V4L2_EVENT_RKISP1_STATS_3A	(V4L2_EVENT_RKISP1_CLASS | 0x1)
+
+#define RKISP1_STAT_EVENT_FL_DROPPED	(1U << 0)
+
+/*
+ * Controls
+ */
+
+/*
+ * Main path control: when set, the self path frame is written to the last
+ * plane of each main path buffer, right after the main path image, instead
+ * of being delivered through the self path video node. The self path format
+ * is that of the self path video node, with all its planes laid out
+ * contiguously. The self path video node must not be streaming.
+ */
+#define V4L2_CID_RKISP1_EMBED_SELFPATH	(V4L2_CID_USER_RKISP1_BASE + 0x0)
+
 /**
  * enum rkisp1_cif_isp_version - ISP variants
  *
@@ -992,4 +1014,34 @@ struct rkisp1_stat_buffer {
 	struct rkisp1_cif_isp_stat params;
 };
 
+/**
+ * struct rkisp1_stat_event - Early AE/AWB results
+ *
+ * Payload of the V4L2_EVENT_RKISP1_STATS_3A event, queued on the statistics
+ * video node for every frame as soon as the AE and AWB measurements have
+ * been read, before the rest of the statistics buffer is filled. The event
+ * is queued even when no statistics buffer was available, in which case
+ * RKISP1_STAT_EVENT_FL_DROPPED is set in @flags.
+ *
+ * @meas_type: measurement types (RKISP1_CIF_ISP_STAT_AWB and/or
+ *	       RKISP1_CIF_ISP_STAT_AUTOEXP)
+ * @frame_id: frame sequence number, as in &struct rkisp1_stat_buffer
+ * @awb_cnt: white pixel count, see &struct rkisp1_cif_isp_awb_meas
+ * @awb_mean_y_or_g: mean value of Y, or green if RGB is selected
+ * @awb_mean_cb_or_b: mean value of Cb, or blue if RGB is selected
+ * @awb_mean_cr_or_r: mean value of Cr, or red if RGB is selected
+ * @ae_mean: mean luminance over all AE blocks
+ * @flags: RKISP1_STAT_EVENT_FL_* flags
+ */
+struct rkisp1_stat_event {
+	__u32 meas_type;
+	__u32 frame_id;
+	__u32 awb_cnt;
+	__u8 awb_mean_y_or_g;
+	__u8 awb_mean_cb_or_b;
+	__u8 awb_mean_cr_or_r;
+	__u8 ae_mean;
+	__u32 flags;
+};
+
 #endif /* _UAPI_RKISP1_CONFIG_H */
@@ -8,6 +8,12 @@
 
 /*
  * Admin commands, issued by ublk server, and handled by ublk driver.
+ *
+ * GET_QUEUE_AFFINITY: returns the CPUs whose blk-mq submissions are mapped
+ *      to queue header->data[0]. ublk server is expected to run one thread
+ *      per queue and pin it to this mask, so that request forwarding and
+ *      completion stay on the submitting CPUs and no io command ever has to
+ *      be bounced to a remote daemon.
  */
 #define	UBLK_CMD_GET_QUEUE_AFFINITY	0x01
 #define	UBLK_CMD_GET_DEV_INFO	0x02
@@ -54,6 +60,31 @@
 /* tag bit is 12bit, so at most 4096 IOs for each queue */
 #define UBLK_MAX_QUEUE_DEPTH	4096
 
+/*
+ * With UBLK_F_USER_COPY, the io buffer of request (q_id, tag) is accessed by
+ * pread()/pwrite() on /dev/ublkcN at
+ *
+ *	UBLKSRV_IO_BUF_OFFSET + ublk_pos(q_id, tag, offset)
+ *
+ * single IO buffer max size is 32MB
+ */
+#define UBLK_IO_BUF_OFF		0
+#define UBLK_IO_BUF_BITS	25
+#define UBLK_IO_BUF_BITS_MASK	((1ULL << UBLK_IO_BUF_BITS) - 1)
+
+/* so at most 64K IOs for each queue */
+#define UBLK_TAG_OFF		UBLK_IO_BUF_BITS
+#define UBLK_TAG_BITS		16
+#define UBLK_TAG_BITS_MASK	((1ULL << UBLK_TAG_BITS) - 1)
+
+/* max 4096 queues */
+#define UBLK_QID_OFF		(UBLK_TAG_OFF + UBLK_TAG_BITS)
+#define UBLK_QID_BITS		12
+#define UBLK_QID_BITS_MASK	((1ULL << UBLK_QID_BITS) - 1)
+
+#define UBLKSRV_IO_BUF_TOTAL_BITS	(UBLK_QID_OFF + UBLK_QID_BITS)
+#define UBLKSRV_IO_BUF_TOTAL_SIZE	(1ULL << UBLKSRV_IO_BUF_TOTAL_BITS)
+
 /*
  * zero copy requires 4k block size, and can remap ublk driver's io
  * request into ublksrv's vm space
@@ -79,6 +110,17 @@
 
 #define UBLK_F_USER_RECOVERY_REISSUE	(1UL << 4)
 
+/*
+ * The ublk driver doesn't copy data between request pages and ublksrv's
+ * io buffer. Instead ublksrv reads or writes the request pages directly
+ * with pread()/pwrite() (or io_uring read/write, including against
+ * registered fixed buffers) on /dev/ublkcN, see UBLKSRV_IO_BUF_OFFSET.
+ *
+ * io buffer address has to be zero in io commands, and UBLK_F_NEED_GET_DATA
+ * is meaningless, so it is cleared.
+ */
+#define UBLK_F_USER_COPY	(1UL << 7)
+
 /* device state */
 #define UBLK_S_DEV_DEAD	0
 #define UBLK_S_DEV_LIVE	1
@@ -27,6 +27,31 @@ struct vhost_vring_file {
 
 };
 
+struct vhost_worker_state {
+	/*
+	 * For VHOST_NEW_WORKER the kernel will return the new vhost_worker id.
+	 * For VHOST_FREE_WORKER this must be set to the id of the vhost_worker
+	 * to free.
+	 */
+	unsigned int worker_id;
+};
+
+struct vhost_vring_worker {
+	/* vring index */
+	unsigned int index;
+	/* The id of the vhost_worker returned from VHOST_NEW_WORKER */
+	unsigned int worker_id;
+};
+
+#define VHOST_WORKER_CPU_ANY -1
+
+struct vhost_worker_affinity {
+	/* The id of the vhost_worker returned from VHOST_NEW_WORKER */
+	unsigned int worker_id;
+	/* CPU to run the worker on, or VHOST_WORKER_CPU_ANY */
+	int cpu;
+};
+
 struct vhost_vring_addr {
 	unsigned int index;
 	/* Option flags. */
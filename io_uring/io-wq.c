@@ -76,6 +76,7 @@ struct io_worker {
 struct io_wqe_acct {
 	unsigned nr_workers;
 	unsigned max_workers;
+	unsigned min_workers;
 	int index;
 	atomic_t nr_running;
 	raw_spinlock_t lock;
@@ -642,8 +643,9 @@ static int io_wqe_worker(void *data)
 			io_worker_handle_work(worker);
 
 		raw_spin_lock(&wqe->lock);
-		/* timed out, exit unless we're the last worker */
-		if (last_timeout && acct->nr_workers > 1) {
+		/* timed out, exit unless we're the last (or a reserved) worker */
+		if (last_timeout &&
+		    acct->nr_workers > max(acct->min_workers, 1U)) {
 			acct->nr_workers--;
 			raw_spin_unlock(&wqe->lock);
 			__set_current_state(TASK_RUNNING);
@@ -1402,14 +1404,77 @@ int io_wq_max_workers(struct io_wq *wq, int *new_count)
 			acct = &wqe->acct[i];
 			if (first_node)
 				prev[i] = max_t(int, acct->max_workers, prev[i]);
-			if (new_count[i])
+			if (new_count[i]) {
 				acct->max_workers = new_count[i];
+				acct->min_workers = min(acct->min_workers,
+							acct->max_workers);
+			}
+		}
+		raw_spin_unlock(&wqe->lock);
+		first_node = false;
+	}
+	rcu_read_unlock();
+
+	for (i = 0; i < IO_WQ_ACCT_NR; i++)
+		new_count[i] = prev[i];
+
+	return 0;
+}
+
+/*
+ * Set min number of workers per node that are kept around when idle, returns
+ * old value. If new_count is -1, then just return the old value. If called
+ * by the task owning the io_wq, the missing workers are created right away
+ * so that a burst of blocking work doesn't have to wait for thread creation.
+ */
+int io_wq_min_workers(struct io_wq *wq, int *new_count)
+{
+	int prev[IO_WQ_ACCT_NR];
+	bool first_node = true;
+	int i, node;
+
+	for (i = 0; i < IO_WQ_ACCT_NR; i++)
+		prev[i] = 0;
+
+	rcu_read_lock();
+	for_each_node(node) {
+		struct io_wqe *wqe = wq->wqes[node];
+		struct io_wqe_acct *acct;
+
+		raw_spin_lock(&wqe->lock);
+		for (i = 0; i < IO_WQ_ACCT_NR; i++) {
+			acct = &wqe->acct[i];
+			if (first_node)
+				prev[i] = max_t(int, acct->min_workers, prev[i]);
+			if (new_count[i] >= 0)
+				acct->min_workers = min_t(unsigned int, new_count[i],
+							  acct->max_workers);
 		}
 		raw_spin_unlock(&wqe->lock);
 		first_node = false;
 	}
 	rcu_read_unlock();
 
+	/* workers inherit from the creating task, only the owner can spawn */
+	if (wq->task != current)
+		goto out;
+
+	for_each_node(node) {
+		struct io_wqe *wqe = wq->wqes[node];
+
+		for (i = 0; i < IO_WQ_ACCT_NR; i++) {
+			struct io_wqe_acct *acct = &wqe->acct[i];
+			bool need;
+
+			do {
+				raw_spin_lock(&wqe->lock);
+				need = acct->nr_workers < acct->min_workers &&
+				       acct->nr_workers < acct->max_workers;
+				raw_spin_unlock(&wqe->lock);
+			} while (need && io_wqe_create_worker(wqe, acct));
+		}
+	}
+out:
 	for (i = 0; i < IO_WQ_ACCT_NR; i++)
 		new_count[i] = prev[i];
 
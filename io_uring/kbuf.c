@@ -7,6 +7,7 @@
 #include <linux/slab.h>
 #include <linux/namei.h>
 #include <linux/poll.h>
+#include <linux/seq_file.h>
 #include <linux/io_uring.h>
 
 #include <uapi/linux/io_uring.h>
@@ -136,8 +137,11 @@ static void __user *io_ring_buffer_select(struct io_kiocb *req, size_t *len,
 	struct io_uring_buf *buf;
 	__u16 head = bl->head;
 
-	if (unlikely(smp_load_acquire(&br->tail) == head))
+	if (unlikely(smp_load_acquire(&br->tail) == head)) {
+		bl->nr_empty++;
 		return NULL;
+	}
+	bl->nr_selected++;
 
 	head &= bl->mask;
 	if (head < IO_BUFFER_LIST_BUF_PER_PAGE) {
@@ -526,6 +530,8 @@ int io_register_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
 	bl->nr_entries = reg.ring_entries;
 	bl->buf_ring = br;
 	bl->mask = reg.ring_entries - 1;
+	bl->nr_selected = 0;
+	bl->nr_empty = 0;
 	io_buffer_add_list(ctx, bl, reg.bgid);
 	return 0;
 }
@@ -553,3 +559,32 @@ int io_unregister_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
 	}
 	return 0;
 }
+
+#ifdef CONFIG_PROC_FS
+static void io_kbuf_show_bl(struct io_buffer_list *bl, struct seq_file *m)
+{
+	__u16 tail;
+
+	if (!bl->buf_nr_pages)
+		return;
+
+	tail = READ_ONCE(bl->buf_ring->tail);
+	seq_printf(m, "%5u: entries:%u, avail:%u, selected:%u, empty:%u\n",
+		   bl->bgid, bl->nr_entries, (__u16)(tail - bl->head),
+		   bl->nr_selected, bl->nr_empty);
+}
+
+/* called with ->uring_lock held */
+void io_kbuf_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m)
+{
+	struct io_buffer_list *bl;
+	unsigned long index;
+	int i;
+
+	seq_puts(m, "BufRings:\n");
+	for (i = 0; ctx->io_bl && i < BGID_ARRAY; i++)
+		io_kbuf_show_bl(&ctx->io_bl[i], m);
+	xa_for_each(&ctx->io_bl_xa, index, bl)
+		io_kbuf_show_bl(bl, m);
+}
+#endif
@@ -23,6 +23,10 @@ struct io_buffer_list {
 	__u16 nr_entries;
 	__u16 head;
 	__u16 mask;
+
+	/* ring provided buffers handed out, and selections that found it empty */
+	__u32 nr_selected;
+	__u32 nr_empty;
 };
 
 struct io_buffer {
@@ -36,6 +40,8 @@ struct io_buffer {
 void __user *io_buffer_select(struct io_kiocb *req, size_t *len,
 			      unsigned int issue_flags);
 void io_destroy_buffers(struct io_ring_ctx *ctx);
+struct seq_file;
+void io_kbuf_show_fdinfo(struct io_ring_ctx *ctx, struct seq_file *m);
 
 int io_remove_buffers_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
 int io_remove_buffers(struct io_kiocb *req, unsigned int issue_flags);
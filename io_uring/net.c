@@ -6,6 +6,7 @@
 #include <linux/net.h>
 #include <linux/compat.h>
 #include <net/compat.h>
+#include <net/busy_poll.h>
 #include <linux/io_uring.h>
 
 #include <uapi/linux/io_uring.h>
@@ -50,6 +51,9 @@ struct io_connect {
 	bool				seen_econnaborted;
 };
 
+/* internal to io_sr_msg->flags, above the uapi IORING_RECVSEND_* bits */
+#define IORING_RECV_BUSY_POLLED		(1U << 15)
+
 struct io_sr_msg {
 	struct file			*file;
 	union {
@@ -732,6 +736,33 @@ static int io_recvmsg_multishot(struct socket *sock, struct io_sr_msg *io,
 			kmsg->controllen + err;
 }
 
+/*
+ * On the first nonblocking attempt, if the socket has busy polling enabled
+ * (SO_BUSY_POLL), spin on its NAPI context for up to sk_ll_usec before
+ * falling back to arming poll. Small messages that are only a few
+ * microseconds away then complete inline instead of paying for a wakeup
+ * and a task_work round trip. Returns true if data showed up.
+ */
+static bool io_recv_busy_poll(struct io_kiocb *req, struct socket *sock)
+{
+#ifdef CONFIG_NET_RX_BUSY_POLL
+	struct io_sr_msg *sr = io_kiocb_to_cmd(req, struct io_sr_msg);
+	struct sock *sk = sock->sk;
+
+	if (req->flags & REQ_F_POLLED || sr->flags & IORING_RECV_BUSY_POLLED)
+		return false;
+	if (!sk || !sk_can_busy_loop(sk))
+		return false;
+
+	/* only spin once per request */
+	sr->flags |= IORING_RECV_BUSY_POLLED;
+	sk_busy_loop(sk, 0);
+	return !skb_queue_empty_lockless(&sk->sk_receive_queue);
+#else
+	return false;
+#endif
+}
+
 int io_recvmsg(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_sr_msg *sr = io_kiocb_to_cmd(req, struct io_sr_msg);
@@ -796,8 +827,12 @@ int io_recvmsg(struct io_kiocb *req, unsigned int issue_flags)
 		if (flags & MSG_WAITALL && !kmsg->msg.msg_controllen)
 			min_ret = iov_iter_count(&kmsg->msg.msg_iter);
 
+retry_busy_poll:
 		ret = __sys_recvmsg_sock(sock, &kmsg->msg, sr->umsg,
 					 kmsg->uaddr, flags);
+		if (ret == -EAGAIN && force_nonblock &&
+		    io_recv_busy_poll(req, sock))
+			goto retry_busy_poll;
 	}
 
 	if (ret < min_ret) {
@@ -895,8 +930,12 @@ int io_recv(struct io_kiocb *req, unsigned int issue_flags)
 	if (flags & MSG_WAITALL)
 		min_ret = iov_iter_count(&msg.msg_iter);
 
+retry_busy_poll:
 	ret = sock_recvmsg(sock, &msg, flags);
 	if (ret < min_ret) {
+		if (ret == -EAGAIN && force_nonblock &&
+		    io_recv_busy_poll(req, sock))
+			goto retry_busy_poll;
 		if (ret == -EAGAIN && force_nonblock) {
 			if (issue_flags & IO_URING_F_MULTISHOT) {
 				io_kbuf_recycle(req, issue_flags);
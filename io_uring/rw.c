@@ -992,16 +992,18 @@ void io_rw_fail(struct io_kiocb *req)
 int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 {
 	struct io_wq_work_node *pos, *start, *prev;
-	unsigned int poll_flags = BLK_POLL_NOSLEEP;
+	unsigned int poll_flags = 0;
 	DEFINE_IO_COMP_BATCH(iob);
 	int nr_events = 0;
 
 	/*
 	 * Only spin for completions if we don't have multiple devices hanging
-	 * off our complete list.
+	 * off our complete list. Likewise, only allow a hybrid poll sleep
+	 * (see io_poll_delay) if everything we poll is behind the same queue,
+	 * otherwise we'd delay completions of other devices.
 	 */
 	if (ctx->poll_multi_queue || force_nonspin)
-		poll_flags |= BLK_POLL_ONESHOT;
+		poll_flags |= BLK_POLL_ONESHOT | BLK_POLL_NOSLEEP;
 
 	wq_list_for_each(pos, start, &ctx->iopoll_list) {
 		struct io_kiocb *req = container_of(pos, struct io_kiocb, comp_list);
@@ -1031,6 +1033,8 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 			return ret;
 		else if (ret)
 			poll_flags |= BLK_POLL_ONESHOT;
+		/* sleep at most once per reap pass */
+		poll_flags |= BLK_POLL_NOSLEEP;
 
 		/* iopoll may have completed current req */
 		if (!rq_list_empty(iob.req_list) ||
@@ -18,6 +18,8 @@
 #include "sqpoll.h"
 
 #define IORING_SQPOLL_CAP_ENTRIES_VALUE 8
+/* adaptive SQPOLL spins for this many typical gaps between submissions */
+#define IORING_SQPOLL_ADAPTIVE_MULT	2
 
 enum {
 	IO_SQ_THREAD_SHOULD_STOP = 0,
@@ -78,10 +80,59 @@ static __cold void io_sqd_update_thread_idle(struct io_sq_data *sqd)
 {
 	struct io_ring_ctx *ctx;
 	unsigned sq_thread_idle = 0;
+	bool sq_adaptive = true;
 
-	list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
+	list_for_each_entry(ctx, &sqd->ctx_list, sqd_list) {
 		sq_thread_idle = max(sq_thread_idle, ctx->sq_thread_idle);
+		if (!(ctx->flags & IORING_SETUP_SQ_ADAPTIVE))
+			sq_adaptive = false;
+	}
 	sqd->sq_thread_idle = sq_thread_idle;
+	sqd->sq_adaptive = sq_adaptive;
+}
+
+/*
+ * Adaptive idle: keep an average of how long the thread went without work
+ * before new submissions showed up. If that is well inside sq_thread_idle,
+ * spin for a couple of those gaps to catch the next burst; if submissions
+ * are further apart than that, spinning would not catch them anyway, so
+ * only spin for a tick and go to sleep.
+ */
+static void io_sqd_note_work(struct io_sq_data *sqd, bool busy)
+{
+	u64 now, gap;
+
+	if (!sqd->sq_adaptive)
+		return;
+
+	if (!busy) {
+		if (!sqd->sq_idle_start)
+			sqd->sq_idle_start = ktime_get_ns();
+		return;
+	}
+	if (!sqd->sq_idle_start)
+		return;
+
+	now = ktime_get_ns();
+	gap = min_t(u64, now - sqd->sq_idle_start,
+		    jiffies_to_nsecs(sqd->sq_thread_idle));
+	sqd->sq_idle_gap -= sqd->sq_idle_gap >> 3;
+	sqd->sq_idle_gap += gap >> 3;
+	sqd->sq_idle_start = 0;
+}
+
+static unsigned long io_sqd_thread_idle(struct io_sq_data *sqd)
+{
+	unsigned long idle;
+
+	if (!sqd->sq_adaptive)
+		return sqd->sq_thread_idle;
+
+	idle = nsecs_to_jiffies(sqd->sq_idle_gap * IORING_SQPOLL_ADAPTIVE_MULT);
+	if (idle >= sqd->sq_thread_idle)
+		return 1;
+
+	return max(idle, 1UL);
 }
 
 void io_sq_thread_finish(struct io_ring_ctx *ctx)
@@ -242,7 +293,7 @@ static int io_sq_thread(void *data)
 		if (io_sqd_events_pending(sqd) || signal_pending(current)) {
 			if (io_sqd_handle_event(sqd))
 				break;
-			timeout = jiffies + sqd->sq_thread_idle;
+			timeout = jiffies + io_sqd_thread_idle(sqd);
 		}
 
 		cap_entries = !list_is_singular(&sqd->ctx_list);
@@ -255,9 +306,10 @@ static int io_sq_thread(void *data)
 		if (io_run_task_work())
 			sqt_spin = true;
 
+		io_sqd_note_work(sqd, sqt_spin);
 		if (sqt_spin || !time_after(jiffies, timeout)) {
 			if (sqt_spin)
-				timeout = jiffies + sqd->sq_thread_idle;
+				timeout = jiffies + io_sqd_thread_idle(sqd);
 			if (unlikely(need_resched())) {
 				mutex_unlock(&sqd->lock);
 				cond_resched();
@@ -302,7 +354,7 @@ static int io_sq_thread(void *data)
 		}
 
 		finish_wait(&sqd->wait, &wait);
-		timeout = jiffies + sqd->sq_thread_idle;
+		timeout = jiffies + io_sqd_thread_idle(sqd);
 	}
 
 	io_uring_cancel_generic(true, sqd);
@@ -410,8 +462,8 @@ __cold int io_sq_offload_create(struct io_ring_ctx *ctx,
 		wake_up_new_task(tsk);
 		if (ret)
 			goto err;
-	} else if (p->flags & IORING_SETUP_SQ_AFF) {
-		/* Can't have SQ_AFF without SQPOLL */
+	} else if (p->flags & (IORING_SETUP_SQ_AFF | IORING_SETUP_SQ_ADAPTIVE)) {
+		/* Can't have SQ_AFF or SQ_ADAPTIVE without SQPOLL */
 		ret = -EINVAL;
 		goto err;
 	}
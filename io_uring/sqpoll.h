@@ -12,6 +12,10 @@ struct io_sq_data {
 	struct wait_queue_head	wait;
 
 	unsigned		sq_thread_idle;
+	/* all attached rings asked for IORING_SETUP_SQ_ADAPTIVE */
+	bool			sq_adaptive;
+	u64			sq_idle_start;
+	u64			sq_idle_gap;
 	int			sq_cpu;
 	pid_t			task_pid;
 	pid_t			task_tgid;
@@ -4,7 +4,9 @@
 #include <linux/bitmap.h>
 #include <linux/bpf.h>
 #include <linux/btf.h>
+#include <linux/cache.h>
 #include <linux/err.h>
+#include <linux/hash.h>
 #include <linux/jhash.h>
 #include <linux/random.h>
 #include <linux/btf_ids.h>
@@ -12,6 +14,14 @@
 #define BLOOM_CREATE_FLAG_MASK \
 	(BPF_F_NUMA_NODE | BPF_F_ZERO_SEED | BPF_F_ACCESS_MASK)
 
+#define BLOOM_NR_HASH_FUNCS_MASK	0xF
+#define BLOOM_EXTRA_MASK \
+	(BLOOM_NR_HASH_FUNCS_MASK | BPF_BLOOM_F_BLOCKED)
+
+/* A block of a blocked bloom filter is one cache line */
+#define BLOOM_BLOCK_SHIFT	(L1_CACHE_SHIFT + 3)
+#define BLOOM_BLOCK_BITS	(1U << BLOOM_BLOCK_SHIFT)
+
 struct bpf_bloom_filter {
 	struct bpf_map map;
 	u32 bitset_mask;
@@ -24,21 +34,69 @@ struct bpf_bloom_filter {
 	 */
 	u32 aligned_u32_count;
 	u32 nr_hash_funcs;
-	unsigned long bitset[];
+	/* Number of BLOOM_BLOCK_BITS blocks if blocked, else 0 */
+	u32 nr_blocks;
+	unsigned long bitset[] ____cacheline_aligned;
 };
 
+static u32 __hash(struct bpf_bloom_filter *bloom, void *value,
+		  u32 value_size, u32 index)
+{
+	if (bloom->aligned_u32_count)
+		return jhash2(value, bloom->aligned_u32_count,
+			      bloom->hash_seed + index);
+
+	return jhash(value, value_size, bloom->hash_seed + index);
+}
+
 static u32 hash(struct bpf_bloom_filter *bloom, void *value,
 		u32 value_size, u32 index)
 {
-	u32 h;
+	return __hash(bloom, value, value_size, index) & bloom->bitset_mask;
+}
 
-	if (bloom->aligned_u32_count)
-		h = jhash2(value, bloom->aligned_u32_count,
-			   bloom->hash_seed + index);
-	else
-		h = jhash(value, value_size, bloom->hash_seed + index);
+/* Returns the block of @value, and the first bit and step within it in @h
+ * and @delta. The block comes from the upper bits of the hash and the bits
+ * within it from the lower ones, so the two are independent. An odd @delta
+ * keeps the nr_hash_funcs probes on distinct bits.
+ */
+static unsigned long *blocked_hash(struct bpf_bloom_filter *bloom,
+				   void *value, u32 value_size,
+				   u32 *h, u32 *delta)
+{
+	u32 full = __hash(bloom, value, value_size, 0);
+	u32 block = ((u64)full * bloom->nr_blocks) >> 32;
+
+	*h = full;
+	*delta = hash_32(full, BLOOM_BLOCK_SHIFT) | 1;
+
+	return bloom->bitset + block * BITS_TO_LONGS(BLOOM_BLOCK_BITS);
+}
+
+static int blocked_peek_elem(struct bpf_bloom_filter *bloom, void *value)
+{
+	unsigned long *block;
+	u32 i, h, delta;
+
+	block = blocked_hash(bloom, value, bloom->map.value_size, &h, &delta);
+
+	for (i = 0; i < bloom->nr_hash_funcs; i++, h += delta) {
+		if (!test_bit(h & (BLOOM_BLOCK_BITS - 1), block))
+			return -ENOENT;
+	}
+
+	return 0;
+}
+
+static void blocked_push_elem(struct bpf_bloom_filter *bloom, void *value)
+{
+	unsigned long *block;
+	u32 i, h, delta;
+
+	block = blocked_hash(bloom, value, bloom->map.value_size, &h, &delta);
 
-	return h & bloom->bitset_mask;
+	for (i = 0; i < bloom->nr_hash_funcs; i++, h += delta)
+		set_bit(h & (BLOOM_BLOCK_BITS - 1), block);
 }
 
 static int bloom_map_peek_elem(struct bpf_map *map, void *value)
@@ -47,6 +105,9 @@ static int bloom_map_peek_elem(struct bpf_map *map, void *value)
 		container_of(map, struct bpf_bloom_filter, map);
 	u32 i, h;
 
+	if (bloom->nr_blocks)
+		return blocked_peek_elem(bloom, value);
+
 	for (i = 0; i < bloom->nr_hash_funcs; i++) {
 		h = hash(bloom, value, map->value_size, i);
 		if (!test_bit(h, bloom->bitset))
@@ -65,6 +126,11 @@ static int bloom_map_push_elem(struct bpf_map *map, void *value, u64 flags)
 	if (flags != BPF_ANY)
 		return -EINVAL;
 
+	if (bloom->nr_blocks) {
+		blocked_push_elem(bloom, value);
+		return 0;
+	}
+
 	for (i = 0; i < bloom->nr_hash_funcs; i++) {
 		h = hash(bloom, value, map->value_size, i);
 		set_bit(h, bloom->bitset);
@@ -93,6 +159,7 @@ static struct bpf_map *bloom_map_alloc(union bpf_attr *attr)
 	u32 bitset_bytes, bitset_mask, nr_hash_funcs, nr_bits;
 	int numa_node = bpf_map_attr_numa_node(attr);
 	struct bpf_bloom_filter *bloom;
+	bool blocked;
 
 	if (!bpf_capable())
 		return ERR_PTR(-EPERM);
@@ -102,12 +169,13 @@ static struct bpf_map *bloom_map_alloc(union bpf_attr *attr)
 	    attr->map_flags & ~BLOOM_CREATE_FLAG_MASK ||
 	    !bpf_map_flags_access_ok(attr->map_flags) ||
 	    /* The lower 4 bits of map_extra (0xF) specify the number
-	     * of hash functions
+	     * of hash functions, the bits above it flags
 	     */
-	    (attr->map_extra & ~0xF))
+	    (attr->map_extra & ~(u64)BLOOM_EXTRA_MASK))
 		return ERR_PTR(-EINVAL);
 
-	nr_hash_funcs = attr->map_extra;
+	blocked = attr->map_extra & BPF_BLOOM_F_BLOCKED;
+	nr_hash_funcs = attr->map_extra & BLOOM_NR_HASH_FUNCS_MASK;
 	if (nr_hash_funcs == 0)
 		/* Default to using 5 hash functions if unspecified */
 		nr_hash_funcs = 5;
@@ -133,7 +201,9 @@ static struct bpf_map *bloom_map_alloc(union bpf_attr *attr)
 		bitset_bytes = BITS_TO_BYTES(U32_MAX);
 		bitset_mask = U32_MAX;
 	} else {
-		if (nr_bits <= BITS_PER_LONG)
+		if (blocked && nr_bits <= BLOOM_BLOCK_BITS)
+			nr_bits = BLOOM_BLOCK_BITS;
+		else if (nr_bits <= BITS_PER_LONG)
 			nr_bits = BITS_PER_LONG;
 		else
 			nr_bits = roundup_pow_of_two(nr_bits);
@@ -151,6 +221,8 @@ static struct bpf_map *bloom_map_alloc(union bpf_attr *attr)
 
 	bloom->nr_hash_funcs = nr_hash_funcs;
 	bloom->bitset_mask = bitset_mask;
+	if (blocked)
+		bloom->nr_blocks = (bitset_mask >> BLOOM_BLOCK_SHIFT) + 1;
 
 	/* Check whether the value size is u32-aligned */
 	if ((attr->value_size & (sizeof(u32) - 1)) == 0)
@@ -29,17 +29,10 @@
  *
  * Note: the iter_prog is called with cgroup_mutex held.
  *
- * Currently only one session is supported, which means, depending on the
- * volume of data bpf program intends to send to user space, the number
- * of cgroups that can be walked is limited. For example, given the current
- * buffer size is 8 * PAGE_SIZE, if the program sends 64B data for each
- * cgroup, assuming PAGE_SIZE is 4kb, the total number of cgroups that can
- * be walked is 512. This is a limitation of cgroup_iter. If the output data
- * is larger than the kernel buffer size, after all data in the kernel buffer
- * is consumed by user space, the subsequent read() syscall will signal
- * EOPNOTSUPP. In order to work around, the user may have to update their
- * program to reduce the volume of data sent to output. For example, skip
- * some uninteresting cgroups.
+ * cgroup_mutex is dropped between read() calls. If the output doesn't fit
+ * in the kernel buffer, the iter keeps a reference on the cgroup it stopped
+ * at and the next read() resumes the walk from there. Cgroups created or
+ * removed between two reads may or may not be visited.
  */
 
 struct bpf_iter__cgroup {
@@ -49,6 +42,7 @@ struct bpf_iter__cgroup {
 
 struct cgroup_iter_priv {
 	struct cgroup_subsys_state *start_css;
+	struct cgroup_subsys_state *resume_css;
 	bool visited_all;
 	bool terminate;
 	int order;
@@ -60,15 +54,18 @@ static void *cgroup_iter_seq_start(struct seq_file *seq, loff_t *pos)
 
 	cgroup_lock();
 
-	/* cgroup_iter doesn't support read across multiple sessions. */
 	if (*pos > 0) {
-		if (p->visited_all)
+		struct cgroup_subsys_state *css = p->resume_css;
+
+		if (p->visited_all || !css)
 			return NULL;
 
-		/* Haven't visited all, but because cgroup_mutex has dropped,
-		 * return -EOPNOTSUPP to indicate incomplete iteration.
+		/* The css can't be freed before cgroup_mutex is dropped and
+		 * the walk can continue from it even if it went offline.
 		 */
-		return ERR_PTR(-EOPNOTSUPP);
+		p->resume_css = NULL;
+		css_put(css);
+		return css;
 	}
 
 	++*pos;
@@ -89,6 +86,12 @@ static void cgroup_iter_seq_stop(struct seq_file *seq, void *v)
 {
 	struct cgroup_iter_priv *p = seq->private;
 
+	/* remember where to resume if the walk got interrupted */
+	if (!IS_ERR_OR_NULL(v) && !p->terminate) {
+		p->resume_css = v;
+		css_get(p->resume_css);
+	}
+
 	cgroup_unlock();
 
 	/* pass NULL to the prog for post-processing */
@@ -171,6 +174,7 @@ static int cgroup_iter_seq_init(void *priv, struct bpf_iter_aux_info *aux)
 	 */
 	p->start_css = &cgrp->self;
 	css_get(p->start_css);
+	p->resume_css = NULL;
 	p->terminate = false;
 	p->visited_all = false;
 	p->order = aux->cgroup.order;
@@ -182,6 +186,8 @@ static void cgroup_iter_seq_fini(void *priv)
 	struct cgroup_iter_priv *p = (struct cgroup_iter_priv *)priv;
 
 	css_put(p->start_css);
+	if (p->resume_css)
+		css_put(p->resume_css);
 }
 
 static const struct bpf_iter_seq_info cgroup_iter_seq_info = {
@@ -32,6 +32,7 @@
 
 #include <linux/netdevice.h>   /* netif_receive_skb_list */
 #include <linux/etherdevice.h> /* eth_type_trans */
+#include <net/gro.h>           /* gro_normal_list */
 
 /* General idea: XDP packets getting XDP redirected to another CPU,
  * will maximum be stored/queued for one driver ->poll() call.  It is
@@ -73,6 +74,10 @@ struct bpf_cpu_map_entry {
 
 	struct work_struct kthread_stop_wq;
 	struct completion kthread_running;
+
+	/* GRO context of the kthread, never scheduled as a real NAPI */
+	struct napi_struct napi;
+	struct net_device gro_dev;
 };
 
 struct bpf_cpu_map {
@@ -307,6 +312,15 @@ static int cpu_map_kthread_run(void *data)
 {
 	struct bpf_cpu_map_entry *rcpu = data;
 
+	/* Frames built into skbs here go through GRO, like they would on
+	 * the RX CPU with a normal NAPI driver. The NAPI instance is only a
+	 * GRO context: it stays in SCHED state, is never polled and is kept
+	 * out of the busy-poll hash.
+	 */
+	init_dummy_netdev(&rcpu->gro_dev);
+	set_bit(NAPI_STATE_NO_BUSY_POLL, &rcpu->napi.state);
+	netif_napi_add(&rcpu->gro_dev, &rcpu->napi, NULL);
+
 	complete(&rcpu->kthread_running);
 	set_current_state(TASK_INTERRUPTIBLE);
 
@@ -317,7 +331,7 @@ static int cpu_map_kthread_run(void *data)
 	 */
 	while (!kthread_should_stop() || !__ptr_ring_empty(rcpu->queue)) {
 		struct xdp_cpumap_stats stats = {}; /* zero stats */
-		unsigned int kmem_alloc_drops = 0, sched = 0;
+		unsigned int kmem_alloc_drops = 0, sched = 0, gro_merged = 0;
 		gfp_t gfp = __GFP_ZERO | GFP_ATOMIC;
 		int i, n, m, nframes, xdp_n;
 		void *frames[CPUMAP_BATCH];
@@ -390,18 +404,33 @@ static int cpu_map_kthread_run(void *data)
 				continue;
 			}
 
-			list_add_tail(&skb->list, &list);
+			switch (napi_gro_receive(&rcpu->napi, skb)) {
+			case GRO_MERGED:
+			case GRO_MERGED_FREE:
+				gro_merged++;
+				break;
+			default:
+				break;
+			}
 		}
 		netif_receive_skb_list(&list);
 
+		/* Keep GRO packets across batches while more frames are
+		 * queued, otherwise flush everything before going idle.
+		 */
+		napi_gro_flush(&rcpu->napi, !__ptr_ring_empty(rcpu->queue));
+		gro_normal_list(&rcpu->napi);
+
 		/* Feedback loop via tracepoint */
 		trace_xdp_cpumap_kthread(rcpu->map_id, n, kmem_alloc_drops,
-					 sched, &stats);
+					 sched, &stats, gro_merged);
 
 		local_bh_enable(); /* resched point, may call do_softirq() */
 	}
 	__set_current_state(TASK_RUNNING);
 
+	__netif_napi_del(&rcpu->napi);
+
 	put_cpu_map_entry(rcpu);
 	return 0;
 }
@@ -133,6 +133,16 @@ static inline bool htab_is_prealloc(const struct bpf_htab *htab)
 	return !(htab->map.map_flags & BPF_F_NO_PREALLOC);
 }
 
+static inline u32 htab_map_extra_buckets(const union bpf_attr *attr)
+{
+	return lower_32_bits(attr->map_extra);
+}
+
+static inline u32 htab_map_extra_reserve(const union bpf_attr *attr)
+{
+	return upper_32_bits(attr->map_extra);
+}
+
 static void htab_init_buckets(struct bpf_htab *htab)
 {
 	unsigned int i;
@@ -447,6 +457,22 @@ static int htab_map_alloc_check(union bpf_attr *attr)
 	    attr->value_size == 0)
 		return -EINVAL;
 
+	/* map_extra optionally sets a smaller bucket count, e.g. for
+	 * BPF_F_NO_PREALLOC maps whose typical occupancy is far below
+	 * max_entries, trading longer chains for a smaller bucket array.
+	 */
+	if (htab_map_extra_buckets(attr) &&
+	    (!is_power_of_2(htab_map_extra_buckets(attr)) ||
+	     htab_map_extra_buckets(attr) >
+	     roundup_pow_of_two(attr->max_entries)))
+		return -EINVAL;
+
+	/* and, for BPF_F_NO_PREALLOC maps, a per-cpu element reserve */
+	if (htab_map_extra_reserve(attr) &&
+	    (prealloc || htab_map_extra_reserve(attr) >
+			 attr->max_entries / num_possible_cpus()))
+		return -EINVAL;
+
 	if ((u64)attr->key_size + attr->value_size >= KMALLOC_MAX_SIZE -
 	   sizeof(struct htab_elem))
 		/* if key_size + value_size is bigger, the user space won't be
@@ -497,6 +523,9 @@ static struct bpf_map *htab_map_alloc(union bpf_attr *attr)
 
 	/* hash table size must be power of 2 */
 	htab->n_buckets = roundup_pow_of_two(htab->map.max_entries);
+	if (htab_map_extra_buckets(attr))
+		htab->n_buckets = min(htab->n_buckets,
+				      htab_map_extra_buckets(attr));
 
 	htab->elem_size = sizeof(struct htab_elem) +
 			  round_up(htab->map.key_size, 8);
@@ -574,11 +603,14 @@ static struct bpf_map *htab_map_alloc(union bpf_attr *attr)
 		err = bpf_mem_alloc_init(&htab->ma, htab->elem_size, false);
 		if (err)
 			goto free_map_locked;
+		bpf_mem_alloc_reserve(&htab->ma, htab_map_extra_reserve(attr));
 		if (percpu) {
 			err = bpf_mem_alloc_init(&htab->pcpu_ma,
 						 round_up(htab->map.value_size, 8), true);
 			if (err)
 				goto free_map_locked;
+			bpf_mem_alloc_reserve(&htab->pcpu_ma,
+					      htab_map_extra_reserve(attr));
 		}
 	}
 
@@ -1537,6 +1569,41 @@ static void htab_map_free(struct bpf_map *map)
 	bpf_map_area_free(htab);
 }
 
+static u64 htab_map_mem_usage(const struct bpf_map *map)
+{
+	struct bpf_htab *htab = container_of(map, struct bpf_htab, map);
+	u32 value_size = round_up(htab->map.value_size, 8);
+	bool percpu = htab_is_percpu(htab);
+	u64 num_entries, usage;
+
+	usage = sizeof(struct bpf_htab);
+	usage += sizeof(struct bucket) * htab->n_buckets;
+	usage += sizeof(int) * num_possible_cpus() * HASHTAB_MAP_LOCK_COUNT;
+
+	if (htab_is_prealloc(htab)) {
+		num_entries = map->max_entries;
+		if (htab_has_extra_elems(htab))
+			num_entries += num_possible_cpus();
+		usage += htab->elem_size * num_entries;
+		if (percpu)
+			usage += value_size * num_possible_cpus() * num_entries;
+		return usage;
+	}
+
+	/* elements in use plus what the allocators keep cached */
+	num_entries = htab->use_percpu_counter ?
+		      percpu_counter_sum(&htab->pcount) :
+		      atomic_read(&htab->count);
+	usage += (htab->elem_size + sizeof(struct llist_node)) * num_entries;
+	if (percpu)
+		usage += (sizeof(struct llist_node) + sizeof(void *) +
+			  value_size * num_possible_cpus()) * num_entries;
+	usage += bpf_mem_alloc_cached_size(&htab->ma);
+	if (percpu)
+		usage += bpf_mem_alloc_cached_size(&htab->pcpu_ma);
+	return usage;
+}
+
 static void htab_map_seq_show_elem(struct bpf_map *map, void *key,
 				   struct seq_file *m)
 {
@@ -2207,6 +2274,7 @@ const struct bpf_map_ops htab_map_ops = {
 	.map_seq_show_elem = htab_map_seq_show_elem,
 	.map_set_for_each_callback_args = map_set_for_each_callback_args,
 	.map_for_each_callback = bpf_for_each_hash_elem,
+	.map_mem_usage = htab_map_mem_usage,
 	BATCH_OPS(htab),
 	.map_btf_id = &htab_map_btf_ids[0],
 	.iter_seq_info = &iter_seq_info,
@@ -2228,6 +2296,7 @@ const struct bpf_map_ops htab_lru_map_ops = {
 	.map_seq_show_elem = htab_map_seq_show_elem,
 	.map_set_for_each_callback_args = map_set_for_each_callback_args,
 	.map_for_each_callback = bpf_for_each_hash_elem,
+	.map_mem_usage = htab_map_mem_usage,
 	BATCH_OPS(htab_lru),
 	.map_btf_id = &htab_map_btf_ids[0],
 	.iter_seq_info = &iter_seq_info,
@@ -2379,6 +2448,7 @@ const struct bpf_map_ops htab_percpu_map_ops = {
 	.map_seq_show_elem = htab_percpu_map_seq_show_elem,
 	.map_set_for_each_callback_args = map_set_for_each_callback_args,
 	.map_for_each_callback = bpf_for_each_hash_elem,
+	.map_mem_usage = htab_map_mem_usage,
 	BATCH_OPS(htab_percpu),
 	.map_btf_id = &htab_map_btf_ids[0],
 	.iter_seq_info = &iter_seq_info,
@@ -2398,6 +2468,7 @@ const struct bpf_map_ops htab_lru_percpu_map_ops = {
 	.map_seq_show_elem = htab_percpu_map_seq_show_elem,
 	.map_set_for_each_callback_args = map_set_for_each_callback_args,
 	.map_for_each_callback = bpf_for_each_hash_elem,
+	.map_mem_usage = htab_map_mem_usage,
 	BATCH_OPS(htab_lru_percpu),
 	.map_btf_id = &htab_map_btf_ids[0],
 	.iter_seq_info = &iter_seq_info,
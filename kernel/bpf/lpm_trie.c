@@ -29,9 +29,24 @@ struct lpm_trie_node {
 	u8				data[];
 };
 
+/* Number of leading key bits resolved by the jump table */
+#define LPM_JUMP_BITS	8
+
+/* For each value of the first key byte, the node a lookup would reach after
+ * the first LPM_JUMP_BITS bits and the best match seen on the way there.
+ */
+struct lpm_trie_jump_table {
+	struct rcu_head rcu;
+	struct {
+		struct lpm_trie_node *start;
+		struct lpm_trie_node *found;
+	} slot[1 << LPM_JUMP_BITS];
+};
+
 struct lpm_trie {
 	struct bpf_map			map;
 	struct lpm_trie_node __rcu	*root;
+	struct lpm_trie_jump_table __rcu *jump;
 	size_t				n_entries;
 	size_t				max_prefixlen;
 	size_t				data_size;
@@ -230,11 +245,20 @@ static void *trie_lookup_elem(struct bpf_map *map, void *_key)
 	struct lpm_trie *trie = container_of(map, struct lpm_trie, map);
 	struct lpm_trie_node *node, *found = NULL;
 	struct bpf_lpm_trie_key *key = _key;
+	struct lpm_trie_jump_table *jump;
+
+	/* Start walking the trie from the root node, or skip the top levels
+	 * through the jump table if the key is long enough ...
+	 */
 
-	/* Start walking the trie from the root node ... */
+	node = rcu_dereference_check(trie->root, rcu_read_lock_bh_held());
+	jump = rcu_dereference_check(trie->jump, rcu_read_lock_bh_held());
+	if (jump && key->prefixlen >= LPM_JUMP_BITS) {
+		node = jump->slot[key->data[0]].start;
+		found = jump->slot[key->data[0]].found;
+	}
 
-	for (node = rcu_dereference_check(trie->root, rcu_read_lock_bh_held());
-	     node;) {
+	while (node) {
 		unsigned int next_bit;
 		size_t matchlen;
 
@@ -299,6 +323,55 @@ static struct lpm_trie_node *lpm_trie_node_alloc(const struct lpm_trie *trie,
 	return node;
 }
 
+static void lpm_trie_jump_fill(struct lpm_trie *trie,
+			       struct lpm_trie_jump_table *jump, u8 byte)
+{
+	struct lpm_trie_node *node, *found = NULL;
+
+	node = rcu_dereference_protected(trie->root,
+					 lockdep_is_held(&trie->lock));
+	while (node && node->prefixlen < LPM_JUMP_BITS) {
+		if ((node->data[0] ^ byte) >> (LPM_JUMP_BITS - node->prefixlen)) {
+			node = NULL;
+			break;
+		}
+
+		if (!(node->flags & LPM_TREE_NODE_FLAG_IM))
+			found = node;
+
+		node = rcu_dereference_protected(
+			node->child[extract_bit(&byte, node->prefixlen)],
+			lockdep_is_held(&trie->lock));
+	}
+
+	jump->slot[byte].start = node;
+	jump->slot[byte].found = found;
+}
+
+/* Called with trie->lock held after the trie was modified. The table is
+ * replaced as a whole so that lookups only ever see a consistent table;
+ * if the new one can't be allocated, lookups walk from the root instead.
+ */
+static void lpm_trie_jump_rebuild(struct lpm_trie *trie)
+{
+	struct lpm_trie_jump_table *jump, *old;
+	unsigned int i;
+
+	jump = bpf_map_kmalloc_node(&trie->map, sizeof(*jump),
+				    GFP_NOWAIT | __GFP_NOWARN,
+				    trie->map.numa_node);
+	if (jump) {
+		for (i = 0; i < ARRAY_SIZE(jump->slot); i++)
+			lpm_trie_jump_fill(trie, jump, i);
+	}
+
+	old = rcu_dereference_protected(trie->jump,
+					lockdep_is_held(&trie->lock));
+	rcu_assign_pointer(trie->jump, jump);
+	if (old)
+		kfree_rcu(old, rcu);
+}
+
 /* Called from syscall or from eBPF program */
 static int trie_update_elem(struct bpf_map *map,
 			    void *_key, void *value, u64 flags)
@@ -423,6 +496,8 @@ static int trie_update_elem(struct bpf_map *map,
 
 		kfree(new_node);
 		kfree(im_node);
+	} else {
+		lpm_trie_jump_rebuild(trie);
 	}
 
 	spin_unlock_irqrestore(&trie->lock, irq_flags);
@@ -521,6 +596,9 @@ static int trie_delete_elem(struct bpf_map *map, void *_key)
 	kfree_rcu(node, rcu);
 
 out:
+	if (!ret)
+		lpm_trie_jump_rebuild(trie);
+
 	spin_unlock_irqrestore(&trie->lock, irq_flags);
 
 	return ret;
@@ -609,6 +687,7 @@ static void trie_free(struct bpf_map *map)
 	}
 
 out:
+	kfree(rcu_dereference_protected(trie->jump, 1));
 	bpf_map_area_free(trie);
 }
 
@@ -411,6 +411,58 @@ int bpf_mem_alloc_init(struct bpf_mem_alloc *ma, int size, bool percpu)
 	return 0;
 }
 
+/* Make each cpu keep at least 'cnt' free objects, and prefill them now.
+ * Only valid for a single-size allocator, before it is used; lets a map
+ * that expects bursts of allocations absorb them from the cache while
+ * irq_work catches up.
+ */
+void bpf_mem_alloc_reserve(struct bpf_mem_alloc *ma, int cnt)
+{
+	struct bpf_mem_cache *c;
+	int cpu;
+
+	if (WARN_ON_ONCE(!ma->cache) || cnt <= 0)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		c = per_cpu_ptr(ma->cache, cpu);
+		if (cnt <= c->low_watermark)
+			continue;
+		c->low_watermark = cnt;
+		c->high_watermark = max(c->high_watermark, cnt * 3);
+		c->batch = max((c->high_watermark - c->low_watermark) / 4 * 3, 1);
+		alloc_bulk(c, cnt - c->free_cnt, cpu_to_node(cpu));
+	}
+}
+
+static u64 mem_cache_cached_size(struct bpf_mem_cache *c)
+{
+	/* Racy access to free_cnt. It doesn't need to be 100% accurate */
+	return (u64)READ_ONCE(c->free_cnt) *
+	       (c->percpu_size ? c->percpu_size +
+				 c->unit_size * num_possible_cpus() :
+				 c->unit_size);
+}
+
+/* Memory held in the per-cpu free lists, i.e. not handed out. */
+u64 bpf_mem_alloc_cached_size(struct bpf_mem_alloc *ma)
+{
+	struct bpf_mem_caches *cc;
+	u64 size = 0;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu) {
+		if (ma->cache) {
+			size += mem_cache_cached_size(per_cpu_ptr(ma->cache, cpu));
+		} else if (ma->caches) {
+			cc = per_cpu_ptr(ma->caches, cpu);
+			for (i = 0; i < NUM_CACHES; i++)
+				size += mem_cache_cached_size(&cc->cache[i]);
+		}
+	}
+	return size;
+}
+
 static void drain_mem_cache(struct bpf_mem_cache *c)
 {
 	struct llist_node *llnode, *t;
@@ -37,6 +37,10 @@ struct bpf_ringbuf {
 	u64 mask;
 	struct page **pages;
 	int nr_pages;
+	/* Notify the consumer when a committed record crosses this many
+	 * bytes past the consumer position.
+	 */
+	u32 wakeup_watermark;
 	spinlock_t spinlock ____cacheline_aligned_in_smp;
 	/* For user-space producer ring buffers, an atomic_t busy bit is used
 	 * to synchronize access to the ring buffers in the kernel, rather than
@@ -160,7 +164,9 @@ static void bpf_ringbuf_notify(struct irq_work *work)
 	wake_up_all(&rb->waitq);
 }
 
-static struct bpf_ringbuf *bpf_ringbuf_alloc(size_t data_sz, int numa_node)
+static struct bpf_ringbuf *bpf_ringbuf_alloc(size_t data_sz,
+					     u32 wakeup_watermark,
+					     int numa_node)
 {
 	struct bpf_ringbuf *rb;
 
@@ -174,6 +180,10 @@ static struct bpf_ringbuf *bpf_ringbuf_alloc(size_t data_sz, int numa_node)
 	init_irq_work(&rb->work, bpf_ringbuf_notify);
 
 	rb->mask = data_sz - 1;
+	/* A watermark of one byte wakes up the consumer as soon as the
+	 * record at its position is committed.
+	 */
+	rb->wakeup_watermark = max_t(u32, wakeup_watermark, 1);
 	rb->consumer_pos = 0;
 	rb->producer_pos = 0;
 
@@ -198,13 +208,17 @@ static struct bpf_map *ringbuf_map_alloc(union bpf_attr *attr)
 		return ERR_PTR(-E2BIG);
 #endif
 
+	if (attr->map_extra >= attr->max_entries)
+		return ERR_PTR(-EINVAL);
+
 	rb_map = bpf_map_area_alloc(sizeof(*rb_map), NUMA_NO_NODE);
 	if (!rb_map)
 		return ERR_PTR(-ENOMEM);
 
 	bpf_map_init_from_attr(&rb_map->map, attr);
 
-	rb_map->rb = bpf_ringbuf_alloc(attr->max_entries, rb_map->map.numa_node);
+	rb_map->rb = bpf_ringbuf_alloc(attr->max_entries, attr->map_extra,
+				       rb_map->map.numa_node);
 	if (!rb_map->rb) {
 		bpf_map_area_free(rb_map);
 		return ERR_PTR(-ENOMEM);
@@ -455,7 +469,7 @@ const struct bpf_func_proto bpf_ringbuf_reserve_proto = {
 
 static void bpf_ringbuf_commit(void *sample, u64 flags, bool discard)
 {
-	unsigned long rec_pos, cons_pos;
+	unsigned long rec_pos, cons_pos, rec_len;
 	struct bpf_ringbuf_hdr *hdr;
 	struct bpf_ringbuf *rb;
 	u32 new_len;
@@ -469,15 +483,22 @@ static void bpf_ringbuf_commit(void *sample, u64 flags, bool discard)
 	/* update record header with correct final size prefix */
 	xchg(&hdr->len, new_len);
 
-	/* if consumer caught up and is waiting for our record, notify about
-	 * new data availability
+	/* if our record brings the data pending past the consumer position
+	 * over the wakeup watermark, notify about new data availability; with
+	 * the default watermark, that is when the consumer caught up and is
+	 * waiting for our record
 	 */
 	rec_pos = (void *)hdr - (void *)rb->data;
 	cons_pos = smp_load_acquire(&rb->consumer_pos) & rb->mask;
+	rec_pos = (rec_pos - cons_pos) & rb->mask;
+	rec_len = round_up((new_len & ~BPF_RINGBUF_DISCARD_BIT) +
+			   BPF_RINGBUF_HDR_SZ, 8);
 
 	if (flags & BPF_RB_FORCE_WAKEUP)
 		irq_work_queue(&rb->work);
-	else if (cons_pos == rec_pos && !(flags & BPF_RB_NO_WAKEUP))
+	else if (rec_pos < rb->wakeup_watermark &&
+		 rec_pos + rec_len >= rb->wakeup_watermark &&
+		 !(flags & BPF_RB_NO_WAKEUP))
 		irq_work_queue(&rb->work);
 }
 
@@ -56,6 +56,7 @@ static DEFINE_SPINLOCK(link_idr_lock);
 
 int sysctl_unprivileged_bpf_disabled __read_mostly =
 	IS_BUILTIN(CONFIG_BPF_UNPRIV_DEFAULT_OFF) ? 2 : 0;
+unsigned int sysctl_bpf_verifier_max_states __read_mostly;
 
 static const struct bpf_map_ops * const bpf_map_types[] = {
 #define BPF_PROG_TYPE(_id, _name, prog_ctx_type, kern_ctx_type)
@@ -689,6 +690,9 @@ static unsigned long bpf_map_memory_footprint(const struct bpf_map *map)
 {
 	unsigned long size;
 
+	if (map->ops->map_mem_usage)
+		return map->ops->map_mem_usage(map);
+
 	size = round_up(map->key_size + bpf_map_value_size(map), 8);
 
 	return round_up(map->max_entries * size, PAGE_SIZE);
@@ -1090,6 +1094,11 @@ static int map_create(union bpf_attr *attr)
 	}
 
 	if (attr->map_type != BPF_MAP_TYPE_BLOOM_FILTER &&
+	    attr->map_type != BPF_MAP_TYPE_RINGBUF &&
+	    attr->map_type != BPF_MAP_TYPE_HASH &&
+	    attr->map_type != BPF_MAP_TYPE_PERCPU_HASH &&
+	    attr->map_type != BPF_MAP_TYPE_LRU_HASH &&
+	    attr->map_type != BPF_MAP_TYPE_LRU_PERCPU_HASH &&
 	    attr->map_extra != 0)
 		return -EINVAL;
 
@@ -5313,6 +5322,13 @@ static struct ctl_table bpf_syscall_table[] = {
 		.mode		= 0644,
 		.proc_handler	= bpf_stats_handler,
 	},
+	{
+		.procname	= "bpf_verifier_max_states",
+		.data		= &sysctl_bpf_verifier_max_states,
+		.maxlen		= sizeof(sysctl_bpf_verifier_max_states),
+		.mode		= 0644,
+		.proc_handler	= proc_douintvec,
+	},
 	{ }
 };
 
@@ -8,6 +8,7 @@
 #include <linux/fdtable.h>
 #include <linux/filter.h>
 #include <linux/btf_ids.h>
+#include <linux/sched/clock.h>
 #include "mmap_unlock_work.h"
 
 static const char * const iter_task_type_names[] = {
@@ -21,6 +22,8 @@ struct bpf_iter_seq_task_common {
 	enum bpf_iter_task_type	type;
 	u32 pid;
 	u32 pid_visiting;
+	bool changed_only;
+	u64 since;
 };
 
 struct bpf_iter_seq_task_info {
@@ -106,9 +109,9 @@ static struct task_struct *task_group_seq_get_next(struct bpf_iter_seq_task_comm
 	return next_task;
 }
 
-static struct task_struct *task_seq_get_next(struct bpf_iter_seq_task_common *common,
-					     u32 *tid,
-					     bool skip_if_dup_files)
+static struct task_struct *__task_seq_get_next(struct bpf_iter_seq_task_common *common,
+					       u32 *tid,
+					       bool skip_if_dup_files)
 {
 	struct task_struct *task = NULL;
 	struct pid *pid;
@@ -157,6 +160,44 @@ static struct task_struct *task_seq_get_next(struct bpf_iter_seq_task_common *co
 	return task;
 }
 
+/* Has @task been on a CPU since the previous iterator was created? */
+static bool task_seq_changed(struct bpf_iter_seq_task_common *common,
+			     struct task_struct *task)
+{
+#ifdef CONFIG_SCHED_INFO
+	if (!common->changed_only)
+		return true;
+
+	/*
+	 * A task that was already running when the previous iterator was
+	 * created has an older last_arrival, but a newer last_departure
+	 * once it got off the CPU.
+	 */
+	return task_curr(task) ||
+	       READ_ONCE(task->sched_info.last_arrival) >= common->since ||
+	       READ_ONCE(task->sched_info.last_departure) >= common->since;
+#else
+	return true;
+#endif
+}
+
+static struct task_struct *task_seq_get_next(struct bpf_iter_seq_task_common *common,
+					     u32 *tid,
+					     bool skip_if_dup_files)
+{
+	struct task_struct *task;
+
+	while ((task = __task_seq_get_next(common, tid, skip_if_dup_files))) {
+		if (task_seq_changed(common, task))
+			return task;
+
+		put_task_struct(task);
+		++*tid;
+	}
+
+	return NULL;
+}
+
 static void *task_seq_start(struct seq_file *seq, loff_t *pos)
 {
 	struct bpf_iter_seq_task_info *info = seq->private;
@@ -234,6 +275,16 @@ static int bpf_iter_attach_task(struct bpf_prog *prog,
 	if ((!!linfo->task.tid + !!linfo->task.pid + !!linfo->task.pid_fd) > 1)
 		return -EINVAL;
 
+	if (linfo->task.flags & ~BPF_ITER_TASK_F_CHANGED)
+		return -EINVAL;
+
+	if ((linfo->task.flags & BPF_ITER_TASK_F_CHANGED) &&
+	    !IS_ENABLED(CONFIG_SCHED_INFO))
+		return -EOPNOTSUPP;
+
+	aux->task.flags = linfo->task.flags;
+	atomic64_set(&aux->task.last_iter, 0);
+
 	aux->task.type = BPF_TASK_ITER_ALL;
 	if (linfo->task.tid != 0) {
 		aux->task.type = BPF_TASK_ITER_TID;
@@ -415,6 +466,12 @@ static int init_seq_pidns(void *priv_data, struct bpf_iter_aux_info *aux)
 	common->type = aux->task.type;
 	common->pid = aux->task.pid;
 
+	/* pick up where the previous iterator of this link started */
+	common->changed_only = aux->task.flags & BPF_ITER_TASK_F_CHANGED;
+	if (common->changed_only)
+		common->since = atomic64_xchg(&aux->task.last_iter,
+					      local_clock());
+
 	return 0;
 }
 
@@ -715,6 +772,8 @@ static void bpf_iter_task_show_fdinfo(const struct bpf_iter_aux_info *aux, struc
 		seq_printf(seq, "tid:\t%u\n", aux->task.pid);
 	else if (aux->task.type == BPF_TASK_ITER_TGID)
 		seq_printf(seq, "pid:\t%u\n", aux->task.pid);
+	if (aux->task.flags)
+		seq_printf(seq, "flags:\t%#x\n", aux->task.flags);
 }
 
 static struct bpf_iter_reg task_reg_info = {
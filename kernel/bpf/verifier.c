@@ -12166,6 +12166,7 @@ static int is_state_visited(struct bpf_verifier_env *env, int insn_idx)
 	struct bpf_verifier_state *cur = env->cur_state, *new;
 	int i, j, err, states_cnt = 0;
 	bool add_new_state = env->test_state_freq ? true : false;
+	u32 max_states;
 
 	cur->last_insn_idx = env->prev_insn_idx;
 	if (!env->insn_aux_data[insn_idx].prune_point)
@@ -12313,6 +12314,17 @@ static int is_state_visited(struct bpf_verifier_env *env, int insn_idx)
 	if (!add_new_state)
 		return push_jmp_history(env, cur);
 
+	/* Bound the memory a single load can pin in explored states, so that
+	 * an overly complex program fails early instead of exhausting memory
+	 * on small hosts.
+	 */
+	max_states = READ_ONCE(sysctl_bpf_verifier_max_states);
+	if (max_states && env->peak_states >= max_states) {
+		verbose(env, "verifier state limit %u reached at insn %d\n",
+			max_states, insn_idx);
+		return -E2BIG;
+	}
+
 	/* There were no equivalent states, remember the current one.
 	 * Technically the current state is not proven to be safe yet,
 	 * but it will either reach outer most bpf_exit (which means it's safe)
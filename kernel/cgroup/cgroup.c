@@ -59,6 +59,8 @@
 #include <linux/sched/cputime.h>
 #include <linux/sched/deadline.h>
 #include <linux/psi.h>
+#include <linux/memcontrol.h>
+#include <linux/swap.h>
 #include <net/sock.h>
 
 #define CREATE_TRACE_POINTS
@@ -3772,7 +3774,7 @@ static ssize_t pressure_write(struct kernfs_open_file *of, char *buf,
 	}
 
 	psi = cgroup_psi(cgrp);
-	new = psi_trigger_create(psi, buf, res, of->file, of);
+	new = psi_trigger_create(psi, buf, res, of->file, of, NULL);
 	if (IS_ERR(new)) {
 		cgroup_put(cgrp);
 		return PTR_ERR(new);
@@ -3885,6 +3887,213 @@ static void cgroup_pressure_release(struct kernfs_open_file *of)
 	psi_trigger_destroy(ctx->psi.trigger);
 }
 
+/*
+ * A memory pressure trigger owned by the cgroup itself rather than by an
+ * open file. When it fires, the cgroup either gets @nr_pages proactively
+ * reclaimed or, if @nr_pages is zero, frozen. This lets a board react to
+ * pressure within one trigger window instead of waiting on a userspace
+ * monitor which may itself be stalled.
+ */
+struct cgroup_psi_action {
+	struct cgroup *cgrp;
+	struct psi_trigger *trigger;
+	struct work_struct work;
+	unsigned long nr_pages;
+};
+
+/* Same retry budget as memory.reclaim */
+#define CGROUP_PSI_RECLAIM_RETRIES	16
+
+static void cgroup_psi_action_reclaim(struct cgroup_psi_action *pa)
+{
+#ifdef CONFIG_MEMCG
+	struct cgroup_subsys_state *css;
+	unsigned long nr_reclaimed = 0;
+	unsigned int nr_retries = CGROUP_PSI_RECLAIM_RETRIES;
+	struct mem_cgroup *memcg;
+
+	/*
+	 * Checked when the action was set up, but the memory controller may
+	 * have been disabled on the cgroup since. Nothing to reclaim then.
+	 */
+	css = cgroup_tryget_css(pa->cgrp, &memory_cgrp_subsys);
+	if (!css)
+		return;
+	memcg = mem_cgroup_from_css(css);
+
+	while (nr_reclaimed < pa->nr_pages) {
+		unsigned long reclaimed;
+
+		reclaimed = try_to_free_mem_cgroup_pages(memcg,
+					min(pa->nr_pages - nr_reclaimed,
+					    (unsigned long)SWAP_CLUSTER_MAX),
+					GFP_KERNEL,
+					MEMCG_RECLAIM_MAY_SWAP |
+					MEMCG_RECLAIM_PROACTIVE);
+		if (!reclaimed && !nr_retries--)
+			break;
+		nr_reclaimed += reclaimed;
+		cond_resched();
+	}
+
+	css_put(css);
+#endif
+}
+
+static bool cgroup_psi_action_can_reclaim(struct cgroup *cgrp)
+{
+#ifdef CONFIG_MEMCG
+	return cgroup_css(cgrp, &memory_cgrp_subsys);
+#else
+	return false;
+#endif
+}
+
+static void cgroup_psi_action_workfn(struct work_struct *work)
+{
+	struct cgroup_psi_action *pa = container_of(work,
+					struct cgroup_psi_action, work);
+
+	if (pa->nr_pages) {
+		cgroup_psi_action_reclaim(pa);
+		return;
+	}
+
+	mutex_lock(&cgroup_mutex);
+	if (!cgroup_is_dead(pa->cgrp))
+		cgroup_freeze(pa->cgrp, true);
+	mutex_unlock(&cgroup_mutex);
+}
+
+static void cgroup_psi_action_free(struct cgroup_psi_action *pa)
+{
+	if (!pa)
+		return;
+
+	/* No new work can be queued once the trigger is gone */
+	psi_trigger_destroy(pa->trigger);
+	cancel_work_sync(&pa->work);
+	kfree(pa);
+}
+
+static int cgroup_memory_pressure_action_show(struct seq_file *seq, void *v)
+{
+	struct cgroup *cgrp = seq_css(seq)->cgroup;
+	struct cgroup_psi_action *pa;
+
+	mutex_lock(&cgroup_mutex);
+	pa = cgrp->psi_action;
+	if (pa) {
+		struct psi_trigger *t = pa->trigger;
+
+		seq_printf(seq, "%s %llu %llu ",
+			   t->state == PSI_MEM_FULL ? "full" : "some",
+			   div_u64(t->threshold, NSEC_PER_USEC),
+			   div_u64(t->win.size, NSEC_PER_USEC));
+		if (pa->nr_pages)
+			seq_printf(seq, "reclaim %lu\n",
+				   pa->nr_pages << PAGE_SHIFT);
+		else
+			seq_puts(seq, "freeze\n");
+	} else {
+		seq_puts(seq, "none\n");
+	}
+	mutex_unlock(&cgroup_mutex);
+
+	return 0;
+}
+
+/*
+ * Format is "<some|full> <threshold_us> <window_us> reclaim <bytes>" or
+ * "<some|full> <threshold_us> <window_us> freeze", "none" removes it.
+ */
+static ssize_t cgroup_memory_pressure_action_write(struct kernfs_open_file *of,
+						   char *buf, size_t nbytes,
+						   loff_t off)
+{
+	struct cgroup_psi_action *pa = NULL, *old;
+	unsigned long nr_pages = 0;
+	struct cgroup *cgrp;
+	char action[8];
+	bool dead;
+	int pos;
+
+	buf = strstrip(buf);
+	if (strcmp(buf, "none")) {
+		if (sscanf(buf, "%*s %*u %*u %7s%n", action, &pos) != 1)
+			return -EINVAL;
+
+		if (!strcmp(action, "reclaim")) {
+			char *end;
+			u64 bytes;
+
+			if (!IS_ENABLED(CONFIG_MEMCG))
+				return -EOPNOTSUPP;
+			bytes = memparse(skip_spaces(buf + pos), &end);
+			if (*end != '\0')
+				return -EINVAL;
+			nr_pages = bytes >> PAGE_SHIFT;
+			if (!nr_pages)
+				return -EINVAL;
+		} else if (strcmp(action, "freeze") || buf[pos] != '\0') {
+			return -EINVAL;
+		}
+
+		pa = kzalloc(sizeof(*pa), GFP_KERNEL);
+		if (!pa)
+			return -ENOMEM;
+		INIT_WORK(&pa->work, cgroup_psi_action_workfn);
+		pa->nr_pages = nr_pages;
+	}
+
+	cgrp = cgroup_kn_lock_live(of->kn, false);
+	if (!cgrp) {
+		kfree(pa);
+		return -ENOENT;
+	}
+
+	/* Reclaim works on the cgroup's own memcg, not an ancestor's */
+	if (nr_pages && !cgroup_psi_action_can_reclaim(cgrp)) {
+		cgroup_kn_unlock(of->kn);
+		kfree(pa);
+		return -EOPNOTSUPP;
+	}
+
+	cgroup_get(cgrp);
+	cgroup_kn_unlock(of->kn);
+
+	/* Like pressure_write(), don't spawn psimon under cgroup_mutex */
+	if (pa) {
+		struct psi_trigger *t;
+
+		pa->cgrp = cgrp;
+		t = psi_trigger_create(cgroup_psi(cgrp), buf, PSI_MEM,
+				       of->file, NULL, &pa->work);
+		if (IS_ERR(t)) {
+			cgroup_put(cgrp);
+			kfree(pa);
+			return PTR_ERR(t);
+		}
+		pa->trigger = t;
+	}
+
+	mutex_lock(&cgroup_mutex);
+	dead = cgroup_is_dead(cgrp);
+	if (dead) {
+		old = pa;
+	} else {
+		old = cgrp->psi_action;
+		cgrp->psi_action = pa;
+	}
+	mutex_unlock(&cgroup_mutex);
+
+	/* The freeze work takes cgroup_mutex, flush it outside of it */
+	cgroup_psi_action_free(old);
+	cgroup_put(cgrp);
+
+	return dead ? -ENOENT : nbytes;
+}
+
 bool cgroup_psi_enabled(void)
 {
 	if (static_branch_likely(&psi_disabled))
@@ -3894,6 +4103,8 @@ bool cgroup_psi_enabled(void)
 }
 
 #else /* CONFIG_PSI */
+static inline void cgroup_psi_action_free(struct cgroup_psi_action *pa) {}
+
 bool cgroup_psi_enabled(void)
 {
 	return false;
@@ -5313,6 +5524,12 @@ static struct cftype cgroup_psi_files[] = {
 		.seq_show = cgroup_pressure_show,
 		.write = cgroup_pressure_write,
 	},
+	{
+		.name = "memory.pressure.action",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cgroup_memory_pressure_action_show,
+		.write = cgroup_memory_pressure_action_write,
+	},
 #endif /* CONFIG_PSI */
 	{ }	/* terminate */
 };
@@ -5374,6 +5591,7 @@ static void css_free_rwork_fn(struct work_struct *work)
 			 */
 			cgroup_put(cgroup_parent(cgrp));
 			kernfs_put(cgrp->kn);
+			cgroup_psi_action_free(cgrp->psi_action);
 			psi_cgroup_free(cgrp);
 			cgroup_rstat_exit(cgrp);
 			kfree(cgrp);
@@ -10,6 +10,14 @@
 static DEFINE_SPINLOCK(cgroup_rstat_lock);
 static DEFINE_PER_CPU(raw_spinlock_t, cgroup_rstat_cpu_lock);
 
+/*
+ * How old the stats shown to userspace may be.  Reading the stat files of
+ * many cgroups in a row then costs one flush of their common ancestor
+ * instead of one per cgroup, each of them walking all CPUs under the
+ * global cgroup_rstat_lock.
+ */
+#define CGROUP_RSTAT_FLUSH_STALENESS	(HZ / 10)
+
 static void cgroup_base_stat_flush(struct cgroup *cgrp, int cpu);
 
 static struct cgroup_rstat_cpu *cgroup_rstat_cpu(struct cgroup *cgrp, int cpu)
@@ -174,6 +182,7 @@ __diag_pop();
 static void cgroup_rstat_flush_locked(struct cgroup *cgrp, bool may_sleep)
 	__releases(&cgroup_rstat_lock) __acquires(&cgroup_rstat_lock)
 {
+	unsigned long start = jiffies;
 	int cpu;
 
 	lockdep_assert_held(&cgroup_rstat_lock);
@@ -184,6 +193,14 @@ static void cgroup_rstat_flush_locked(struct cgroup *cgrp, bool may_sleep)
 		struct cgroup *pos = NULL;
 		unsigned long flags;
 
+		/*
+		 * Nothing to pop if the subtree isn't on the updated list.
+		 * Racing with cgroup_rstat_updated() is fine, the update
+		 * would equally have been missed had it come a bit later.
+		 */
+		if (!data_race(cgroup_rstat_cpu(cgrp, cpu)->updated_next))
+			continue;
+
 		/*
 		 * The _irqsave() is needed because cgroup_rstat_lock is
 		 * spinlock_t which is a sleeping lock on PREEMPT_RT. Acquiring
@@ -216,6 +233,14 @@ static void cgroup_rstat_flush_locked(struct cgroup *cgrp, bool may_sleep)
 			spin_lock_irq(&cgroup_rstat_lock);
 		}
 	}
+
+	/*
+	 * Only now is the subtree fully flushed. The lock may have been
+	 * dropped above, and a reader checking the time before this point
+	 * must not skip its flush. The stats are as old as the start of
+	 * the flush though, so that is the time to record.
+	 */
+	WRITE_ONCE(cgrp->rstat_flush_time, start);
 }
 
 /**
@@ -240,6 +265,38 @@ void cgroup_rstat_flush(struct cgroup *cgrp)
 	spin_unlock_irq(&cgroup_rstat_lock);
 }
 
+/*
+ * Flushing a cgroup brings its whole subtree up to date, so the stats are
+ * fresh if @cgrp or any of its ancestors has been flushed lately.
+ */
+static bool cgroup_rstat_flushed_recently(struct cgroup *cgrp)
+{
+	unsigned long now = jiffies;
+
+	for (; cgrp; cgrp = cgroup_parent(cgrp))
+		if (time_before(now, READ_ONCE(cgrp->rstat_flush_time) +
+				     CGROUP_RSTAT_FLUSH_STALENESS))
+			return true;
+
+	return false;
+}
+
+/**
+ * cgroup_rstat_flush_ratelimited - flush stats in @cgrp's subtree if stale
+ * @cgrp: target cgroup
+ *
+ * Like cgroup_rstat_flush() but leaves the stats alone if they are at most
+ * CGROUP_RSTAT_FLUSH_STALENESS old.  Meant for showing stats to userspace,
+ * which can poll them at any rate.
+ *
+ * This function may block.
+ */
+void cgroup_rstat_flush_ratelimited(struct cgroup *cgrp)
+{
+	if (!cgroup_rstat_flushed_recently(cgrp))
+		cgroup_rstat_flush(cgrp);
+}
+
 /**
  * cgroup_rstat_flush_irqsafe - irqsafe version of cgroup_rstat_flush()
  * @cgrp: target cgroup
@@ -272,6 +329,25 @@ void cgroup_rstat_flush_hold(struct cgroup *cgrp)
 	cgroup_rstat_flush_locked(cgrp, true);
 }
 
+/**
+ * cgroup_rstat_flush_hold_ratelimited - ratelimited cgroup_rstat_flush_hold()
+ * @cgrp: target cgroup
+ *
+ * Like cgroup_rstat_flush_hold() but only flushes if the stats are stale,
+ * see cgroup_rstat_flush_ratelimited().  Must be paired with
+ * cgroup_rstat_flush_release().
+ *
+ * This function may block.
+ */
+void cgroup_rstat_flush_hold_ratelimited(struct cgroup *cgrp)
+	__acquires(&cgroup_rstat_lock)
+{
+	might_sleep();
+	spin_lock_irq(&cgroup_rstat_lock);
+	if (!cgroup_rstat_flushed_recently(cgrp))
+		cgroup_rstat_flush_locked(cgrp, true);
+}
+
 /**
  * cgroup_rstat_flush_release - release cgroup_rstat_flush_hold()
  */
@@ -292,6 +368,8 @@ int cgroup_rstat_init(struct cgroup *cgrp)
 			return -ENOMEM;
 	}
 
+	cgrp->rstat_flush_time = jiffies - CGROUP_RSTAT_FLUSH_STALENESS;
+
 	/* ->updated_children list is self terminated */
 	for_each_possible_cpu(cpu) {
 		struct cgroup_rstat_cpu *rstatc = cgroup_rstat_cpu(cgrp, cpu);
@@ -495,7 +573,7 @@ void cgroup_base_stat_cputime_show(struct seq_file *seq)
 #endif
 
 	if (cgroup_parent(cgrp)) {
-		cgroup_rstat_flush_hold(cgrp);
+		cgroup_rstat_flush_hold_ratelimited(cgrp);
 		usage = cgrp->bstat.cputime.sum_exec_runtime;
 		cputime_adjust(&cgrp->bstat.cputime, &cgrp->prev_cputime,
 			       &utime, &stime);
@@ -10097,6 +10097,10 @@ void ia64_set_curr_task(int cpu, struct task_struct *p)
 /* task_group_lock serializes the addition/removal of task groups */
 static DEFINE_SPINLOCK(task_group_lock);
 
+#if defined(CONFIG_UCLAMP_TASK_GROUP) && defined(CONFIG_PSI)
+static void cpu_uclamp_boost_workfn(struct work_struct *work);
+#endif
+
 static inline void alloc_uclamp_sched_group(struct task_group *tg,
 					    struct task_group *parent)
 {
@@ -10108,6 +10112,9 @@ static inline void alloc_uclamp_sched_group(struct task_group *tg,
 			      uclamp_none(clamp_id), false);
 		tg->uclamp[clamp_id] = parent->uclamp[clamp_id];
 	}
+#ifdef CONFIG_PSI
+	INIT_DELAYED_WORK(&tg->uclamp_boost_work, cpu_uclamp_boost_workfn);
+#endif
 #endif
 }
 
@@ -10325,6 +10332,10 @@ static void cpu_cgroup_css_released(struct cgroup_subsys_state *css)
 {
 	struct task_group *tg = css_tg(css);
 
+#if defined(CONFIG_UCLAMP_TASK_GROUP) && defined(CONFIG_PSI)
+	/* The worker dereferences tg->css.cgroup, stop it while it's valid */
+	cancel_delayed_work_sync(&tg->uclamp_boost_work);
+#endif
 	sched_release_group(tg);
 }
 
@@ -10387,6 +10398,16 @@ static void cpu_util_update_eff(struct cgroup_subsys_state *css)
 				eff[clamp_id] = uc_parent[clamp_id].value;
 			}
 		}
+#ifdef CONFIG_PSI
+		/* Under CPU pressure raise the protection up to the boost */
+		if (css_tg(css)->uclamp_boosted) {
+			unsigned int boost = css_tg(css)->uclamp_boost_util;
+
+			if (uc_parent)
+				boost = min(boost, uc_parent[UCLAMP_MIN].value);
+			eff[UCLAMP_MIN] = max(eff[UCLAMP_MIN], boost);
+		}
+#endif
 		/* Ensure protection is always capped by limit */
 		eff[UCLAMP_MIN] = min(eff[UCLAMP_MIN], eff[UCLAMP_MAX]);
 
@@ -10502,27 +10523,32 @@ static ssize_t cpu_uclamp_max_write(struct kernfs_open_file *of,
 	return cpu_uclamp_write(of, buf, nbytes, off, UCLAMP_MAX);
 }
 
+static void cpu_uclamp_print_value(struct seq_file *sf, u64 util_clamp,
+				   u64 percent)
+{
+	u32 rem;
+
+	if (util_clamp == SCHED_CAPACITY_SCALE) {
+		seq_puts(sf, "max\n");
+		return;
+	}
+
+	percent = div_u64_rem(percent, POW10(UCLAMP_PERCENT_SHIFT), &rem);
+	seq_printf(sf, "%llu.%0*u\n", percent, UCLAMP_PERCENT_SHIFT, rem);
+}
+
 static inline void cpu_uclamp_print(struct seq_file *sf,
 				    enum uclamp_id clamp_id)
 {
 	struct task_group *tg;
 	u64 util_clamp;
-	u64 percent;
-	u32 rem;
 
 	rcu_read_lock();
 	tg = css_tg(seq_css(sf));
 	util_clamp = tg->uclamp_req[clamp_id].value;
 	rcu_read_unlock();
 
-	if (util_clamp == SCHED_CAPACITY_SCALE) {
-		seq_puts(sf, "max\n");
-		return;
-	}
-
-	percent = tg->uclamp_pct[clamp_id];
-	percent = div_u64_rem(percent, POW10(UCLAMP_PERCENT_SHIFT), &rem);
-	seq_printf(sf, "%llu.%0*u\n", percent, UCLAMP_PERCENT_SHIFT, rem);
+	cpu_uclamp_print_value(sf, util_clamp, tg->uclamp_pct[clamp_id]);
 }
 
 static int cpu_uclamp_min_show(struct seq_file *sf, void *v)
@@ -10536,6 +10562,107 @@ static int cpu_uclamp_max_show(struct seq_file *sf, void *v)
 	cpu_uclamp_print(sf, UCLAMP_MAX);
 	return 0;
 }
+
+#ifdef CONFIG_PSI
+/* Re-evaluate the boost at the same rate PSI updates its averages */
+#define UCLAMP_BOOST_PERIOD	(2*HZ+1)
+
+/*
+ * Latency sensitive groups usually can't afford a permanently high
+ * uclamp.min, but they want one while they are fighting for CPU time.
+ * Sample the group's CPU "some" pressure and apply uclamp.min.boost as
+ * the minimum protection while it stays above uclamp.min.boost_pressure.
+ */
+static void cpu_uclamp_boost_workfn(struct work_struct *work)
+{
+	struct task_group *tg = container_of(to_delayed_work(work),
+					     struct task_group,
+					     uclamp_boost_work);
+	unsigned int threshold = READ_ONCE(tg->uclamp_boost_pressure);
+	bool boost = false;
+
+	if (threshold) {
+		struct psi_group *group = cgroup_psi(tg->css.cgroup);
+		unsigned long avg10;
+
+		avg10 = LOAD_INT(psi_avg10(group, PSI_CPU_SOME));
+		boost = avg10 >= threshold;
+	}
+
+	if (boost != tg->uclamp_boosted) {
+		mutex_lock(&uclamp_mutex);
+		rcu_read_lock();
+		tg->uclamp_boosted = boost;
+		cpu_util_update_eff(&tg->css);
+		rcu_read_unlock();
+		mutex_unlock(&uclamp_mutex);
+	}
+
+	if (threshold)
+		schedule_delayed_work(&tg->uclamp_boost_work,
+				      UCLAMP_BOOST_PERIOD);
+}
+
+static ssize_t cpu_uclamp_boost_write(struct kernfs_open_file *of,
+				      char *buf, size_t nbytes, loff_t off)
+{
+	struct uclamp_request req;
+	struct task_group *tg;
+
+	req = capacity_from_percent(buf);
+	if (req.ret)
+		return req.ret;
+
+	mutex_lock(&uclamp_mutex);
+	rcu_read_lock();
+
+	tg = css_tg(of_css(of));
+	tg->uclamp_boost_util = req.util;
+	tg->uclamp_boost_pct = req.percent;
+	if (tg->uclamp_boosted)
+		cpu_util_update_eff(of_css(of));
+
+	rcu_read_unlock();
+	mutex_unlock(&uclamp_mutex);
+
+	return nbytes;
+}
+
+static int cpu_uclamp_boost_show(struct seq_file *sf, void *v)
+{
+	struct task_group *tg = css_tg(seq_css(sf));
+
+	cpu_uclamp_print_value(sf, tg->uclamp_boost_util,
+			       tg->uclamp_boost_pct);
+	return 0;
+}
+
+static u64 cpu_uclamp_boost_pressure_read_u64(struct cgroup_subsys_state *css,
+					      struct cftype *cft)
+{
+	return READ_ONCE(css_tg(css)->uclamp_boost_pressure);
+}
+
+static int cpu_uclamp_boost_pressure_write_u64(struct cgroup_subsys_state *css,
+					       struct cftype *cft, u64 pressure)
+{
+	struct task_group *tg = css_tg(css);
+
+	if (pressure > 100)
+		return -ERANGE;
+	if (static_branch_likely(&psi_disabled))
+		return -EOPNOTSUPP;
+
+	if (pressure)
+		static_branch_enable(&sched_uclamp_used);
+
+	WRITE_ONCE(tg->uclamp_boost_pressure, pressure);
+	/* Evaluate now, this also drops an active boost when disabling */
+	mod_delayed_work(system_wq, &tg->uclamp_boost_work, 0);
+
+	return 0;
+}
+#endif /* CONFIG_PSI */
 #endif /* CONFIG_UCLAMP_TASK_GROUP */
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -11176,6 +11303,20 @@ static struct cftype cpu_files[] = {
 		.seq_show = cpu_uclamp_max_show,
 		.write = cpu_uclamp_max_write,
 	},
+#ifdef CONFIG_PSI
+	{
+		.name = "uclamp.min.boost",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cpu_uclamp_boost_show,
+		.write = cpu_uclamp_boost_write,
+	},
+	{
+		.name = "uclamp.min.boost_pressure",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_uclamp_boost_pressure_read_u64,
+		.write_u64 = cpu_uclamp_boost_pressure_write_u64,
+	},
+#endif
 #endif
 	{ }	/* terminate */
 };
@@ -6775,6 +6775,35 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 		}
 	}
 
+	/*
+	 * When the LLC spans several clusters, look in the target's cluster
+	 * first: the wakee keeps its cluster-local cache and stays close to
+	 * the waker.
+	 */
+	if (static_branch_unlikely(&sched_cluster_active)) {
+		struct sched_group *sg = sd->groups;
+
+		if (sg->flags & SD_CLUSTER) {
+			for_each_cpu_wrap(cpu, sched_group_span(sg), target + 1) {
+				if (!cpumask_test_cpu(cpu, cpus))
+					continue;
+
+				if (has_idle_core) {
+					i = select_idle_core(p, cpu, cpus, &idle_cpu);
+					if ((unsigned int)i < nr_cpumask_bits)
+						return i;
+				} else {
+					if (!--nr)
+						return -1;
+					idle_cpu = __select_idle_cpu(cpu, p);
+					if ((unsigned int)idle_cpu < nr_cpumask_bits)
+						goto done;
+				}
+			}
+			cpumask_andnot(cpus, cpus, sched_group_span(sg));
+		}
+	}
+
 	for_each_cpu_wrap(cpu, cpus, target + 1) {
 		if (has_idle_core) {
 			i = select_idle_core(p, cpu, cpus, &idle_cpu);
@@ -6793,6 +6822,7 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 	if (has_idle_core)
 		set_idle_cores(target, false);
 
+done:
 	if (sched_feat(SIS_PROP) && this_sd && !has_idle_core) {
 		time = cpu_clock(this) - time;
 
@@ -6808,6 +6838,49 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, bool
 	return idle_cpu;
 }
 
+/*
+ * Account idle @cpu as a candidate of select_idle_capacity(); returns true if
+ * the task fits it with all requirements.
+ */
+static inline bool select_idle_capacity_cpu(int cpu, unsigned long task_util,
+					    unsigned long util_min,
+					    unsigned long util_max,
+					    int *best_fits,
+					    unsigned long *best_cap,
+					    int *best_cpu)
+{
+	unsigned long cpu_cap = capacity_of(cpu);
+	int fits;
+
+	if (!available_idle_cpu(cpu) && !sched_idle_cpu(cpu))
+		return false;
+
+	fits = util_fits_cpu(task_util, util_min, util_max, cpu);
+
+	/* This CPU fits with all requirements */
+	if (fits > 0)
+		return true;
+	/*
+	 * Only the min performance hint (i.e. uclamp_min) doesn't fit.
+	 * Look for the CPU with best capacity.
+	 */
+	else if (fits < 0)
+		cpu_cap = capacity_orig_of(cpu) - thermal_load_avg(cpu_rq(cpu));
+
+	/*
+	 * First, select CPU which fits better (-1 being better than 0).
+	 * Then, select the one with best capacity at same level.
+	 */
+	if ((fits < *best_fits) ||
+	    ((fits == *best_fits) && (cpu_cap > *best_cap))) {
+		*best_cap = cpu_cap;
+		*best_cpu = cpu;
+		*best_fits = fits;
+	}
+
+	return false;
+}
+
 /*
  * Scan the asym_capacity domain for idle CPUs; pick the first idle one on which
  * the task fits. If no CPU is big enough, but there are idle ones, try to
@@ -6817,7 +6890,9 @@ static int
 select_idle_capacity(struct task_struct *p, struct sched_domain *sd, int target)
 {
 	unsigned long task_util, util_min, util_max, best_cap = 0;
-	int fits, best_fits = 0;
+	const struct cpumask *share = NULL;
+	struct sched_domain *sd_share;
+	int best_fits = 0;
 	int cpu, best_cpu = -1;
 	struct cpumask *cpus;
 
@@ -6828,34 +6903,32 @@ select_idle_capacity(struct task_struct *p, struct sched_domain *sd, int target)
 	util_min = uclamp_eff_value(p, UCLAMP_MIN);
 	util_max = uclamp_eff_value(p, UCLAMP_MAX);
 
-	for_each_cpu_wrap(cpu, cpus, target) {
-		unsigned long cpu_cap = capacity_of(cpu);
-
-		if (!available_idle_cpu(cpu) && !sched_idle_cpu(cpu))
-			continue;
+	/*
+	 * The capacity domain usually spans several clusters. Look at the
+	 * CPUs sharing the target's cache first, so that a wakee which fits
+	 * there stays on a warm cluster.
+	 */
+	sd_share = rcu_dereference(per_cpu(sd_llc, target));
+	if (sd_share && sd_share->span_weight < sd->span_weight)
+		share = sched_domain_span(sd_share);
 
-		fits = util_fits_cpu(task_util, util_min, util_max, cpu);
+	if (share) {
+		for_each_cpu_wrap(cpu, cpus, target) {
+			if (!cpumask_test_cpu(cpu, share))
+				continue;
+			if (select_idle_capacity_cpu(cpu, task_util, util_min,
+						     util_max, &best_fits,
+						     &best_cap, &best_cpu))
+				return cpu;
+		}
+		cpumask_andnot(cpus, cpus, share);
+	}
 
-		/* This CPU fits with all requirements */
-		if (fits > 0)
+	for_each_cpu_wrap(cpu, cpus, target) {
+		if (select_idle_capacity_cpu(cpu, task_util, util_min,
+					     util_max, &best_fits,
+					     &best_cap, &best_cpu))
 			return cpu;
-		/*
-		 * Only the min performance hint (i.e. uclamp_min) doesn't fit.
-		 * Look for the CPU with best capacity.
-		 */
-		else if (fits < 0)
-			cpu_cap = capacity_orig_of(cpu) - thermal_load_avg(cpu_rq(cpu));
-
-		/*
-		 * First, select CPU which fits better (-1 being better than 0).
-		 * Then, select the one with best capacity at same level.
-		 */
-		if ((fits < best_fits) ||
-		    ((fits == best_fits) && (cpu_cap > best_cap))) {
-			best_cap = cpu_cap;
-			best_cpu = cpu;
-			best_fits = fits;
-		}
 	}
 
 	return best_cpu;
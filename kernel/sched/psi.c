@@ -494,7 +494,9 @@ static u64 update_triggers(struct psi_group *group, u64 now, bool *update_total,
 			continue;
 
 		/* Generate an event */
-		if (cmpxchg(&t->event, 0, 1) == 0) {
+		if (t->action)
+			queue_work(system_unbound_wq, t->action);
+		else if (cmpxchg(&t->event, 0, 1) == 0) {
 			if (t->of)
 				kernfs_notify(t->of->kn);
 			else
@@ -1231,22 +1233,47 @@ void psi_cgroup_restart(struct psi_group *group)
 }
 #endif /* CONFIG_CGROUPS */
 
-int psi_show(struct seq_file *m, struct psi_group *group, enum psi_res res)
+/* Bring the averages up to date, the averaging work stops when idle */
+static void psi_update_avgs(struct psi_group *group)
 {
-	bool only_full = false;
-	int full;
 	u64 now;
 
-	if (static_branch_likely(&psi_disabled))
-		return -EOPNOTSUPP;
-
-	/* Update averages before reporting them */
 	mutex_lock(&group->avgs_lock);
 	now = sched_clock();
 	collect_percpu_times(group, PSI_AVGS, NULL);
 	if (now >= group->avg_next_update)
 		group->avg_next_update = update_averages(group, now);
 	mutex_unlock(&group->avgs_lock);
+}
+
+/**
+ * psi_avg10 - current 10s pressure average of a group
+ * @group: the psi group
+ * @state: one of the PSI_*_SOME or PSI_*_FULL states
+ *
+ * Returns the average in fixed point, as used by LOAD_INT() and
+ * LOAD_FRAC(), or 0 if psi is disabled.
+ */
+unsigned long psi_avg10(struct psi_group *group, enum psi_states state)
+{
+	if (static_branch_likely(&psi_disabled))
+		return 0;
+
+	psi_update_avgs(group);
+
+	return READ_ONCE(group->avg[state][0]);
+}
+
+int psi_show(struct seq_file *m, struct psi_group *group, enum psi_res res)
+{
+	bool only_full = false;
+	int full;
+
+	if (static_branch_likely(&psi_disabled))
+		return -EOPNOTSUPP;
+
+	/* Update averages before reporting them */
+	psi_update_avgs(group);
 
 #ifdef CONFIG_IRQ_TIME_ACCOUNTING
 	only_full = res == PSI_IRQ;
@@ -1278,7 +1305,8 @@ int psi_show(struct seq_file *m, struct psi_group *group, enum psi_res res)
 
 struct psi_trigger *psi_trigger_create(struct psi_group *group, char *buf,
 				       enum psi_res res, struct file *file,
-				       struct kernfs_open_file *of)
+				       struct kernfs_open_file *of,
+				       struct work_struct *action)
 {
 	struct psi_trigger *t;
 	enum psi_states state;
@@ -1339,6 +1367,7 @@ struct psi_trigger *psi_trigger_create(struct psi_group *group, char *buf,
 	t->event = 0;
 	t->last_event_time = 0;
 	t->of = of;
+	t->action = action;
 	if (!of)
 		init_waitqueue_head(&t->event_wait);
 	t->pending_event = false;
@@ -1545,7 +1574,7 @@ static ssize_t psi_write(struct file *file, const char __user *user_buf,
 		return -EBUSY;
 	}
 
-	new = psi_trigger_create(&psi_system, buf, res, file, NULL);
+	new = psi_trigger_create(&psi_system, buf, res, file, NULL, NULL);
 	if (IS_ERR(new)) {
 		mutex_unlock(&seq->lock);
 		return PTR_ERR(new);
@@ -416,6 +416,15 @@ struct task_group {
 	struct uclamp_se	uclamp_req[UCLAMP_CNT];
 	/* Effective clamp values used for a task group */
 	struct uclamp_se	uclamp[UCLAMP_CNT];
+#ifdef CONFIG_PSI
+	/* uclamp.min applied while the group is under CPU pressure */
+	unsigned int		uclamp_boost_pct;
+	unsigned int		uclamp_boost_util;
+	/* CPU "some" avg10 [%] which triggers the boost, 0 disables it */
+	unsigned int		uclamp_boost_pressure;
+	bool			uclamp_boosted;
+	struct delayed_work	uclamp_boost_work;
+#endif
 #endif
 
 };
@@ -1804,7 +1813,9 @@ DECLARE_PER_CPU(struct sched_domain_shared __rcu *, sd_llc_shared);
 DECLARE_PER_CPU(struct sched_domain __rcu *, sd_numa);
 DECLARE_PER_CPU(struct sched_domain __rcu *, sd_asym_packing);
 DECLARE_PER_CPU(struct sched_domain __rcu *, sd_asym_cpucapacity);
+DECLARE_PER_CPU(struct sched_domain __rcu *, sd_cluster);
 extern struct static_key_false sched_asym_cpucapacity;
+extern struct static_key_false sched_cluster_active;
 
 static __always_inline bool sched_asym_cpucap_active(void)
 {
@@ -273,8 +273,10 @@ static inline void sched_info_enqueue(struct rq *rq, struct task_struct *t)
  */
 static inline void sched_info_depart(struct rq *rq, struct task_struct *t)
 {
-	unsigned long long delta = rq_clock(rq) - t->sched_info.last_arrival;
+	unsigned long long now = rq_clock(rq);
+	unsigned long long delta = now - t->sched_info.last_arrival;
 
+	t->sched_info.last_departure = now;
 	rq_sched_info_depart(rq, delta);
 
 	if (task_is_running(t))
@@ -78,6 +78,7 @@
 #include <linux/slab.h>
 #include <linux/sched.h>
 #include <linux/sched/mm.h>
+#include <linux/sched/topology.h>
 #include <linux/mutex.h>
 #include <linux/rwsem.h>
 #include <linux/string.h>
@@ -4319,7 +4320,7 @@ int __dev_queue_xmit(struct sk_buff *skb, struct net_device *sb_dev)
 }
 EXPORT_SYMBOL(__dev_queue_xmit);
 
-int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
+int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id, bool more)
 {
 	struct net_device *dev = skb->dev;
 	struct sk_buff *orig_skb = skb;
@@ -4343,7 +4344,7 @@ int __dev_direct_xmit(struct sk_buff *skb, u16 queue_id)
 	dev_xmit_recursion_inc();
 	HARD_TX_LOCK(dev, txq, smp_processor_id());
 	if (!netif_xmit_frozen_or_drv_stopped(txq))
-		ret = netdev_start_xmit(skb, dev, txq, false);
+		ret = netdev_start_xmit(skb, dev, txq, more);
 	HARD_TX_UNLOCK(dev, txq);
 	dev_xmit_recursion_dec();
 
@@ -6398,6 +6399,29 @@ int dev_set_threaded(struct net_device *dev, bool threaded)
 }
 EXPORT_SYMBOL(dev_set_threaded);
 
+/**
+ *	dev_set_threaded_cpus - restrict the napi threads of a device
+ *	@dev: device
+ *	@mask: CPUs the threads may run on, all CPUs if empty
+ *
+ *	Each thread moves over the next time it is woken up.
+ */
+void dev_set_threaded_cpus(struct net_device *dev, const struct cpumask *mask)
+{
+	unsigned int i;
+
+	ASSERT_RTNL();
+
+	/* The napi threads read the mask without RTNL, see
+	 * napi_thread_place(), and pick it up once they see the new gen.
+	 */
+	for (i = 0; i < BITS_TO_LONGS(nr_cpumask_bits); i++)
+		WRITE_ONCE(cpumask_bits(dev->threaded_cpus)[i],
+			   cpumask_bits(mask)[i]);
+	/* Paired with smp_load_acquire() in napi_threaded_poll() */
+	smp_store_release(&dev->threaded_cpus_gen, dev->threaded_cpus_gen + 1);
+}
+
 void netif_napi_add_weight(struct net_device *dev, struct napi_struct *napi,
 			   int (*poll)(struct napi_struct *, int), int weight)
 {
@@ -6636,12 +6660,81 @@ static int napi_thread_wait(struct napi_struct *napi)
 	return -1;
 }
 
+/* Busy wakeups in a row after which a napi thread moves to the fastest CPUs */
+#define NAPI_THREAD_BUSY_THRESH	4
+
+struct napi_thread_masks {
+	cpumask_var_t	allowed;	/* affinity given to the thread */
+	cpumask_var_t	placed;		/* affinity last set here */
+	cpumask_var_t	mask;
+};
+
+/* Let the current napi thread run on the CPUs set for the device, or on the
+ * ones it was allowed before if none are, and only on those with the highest
+ * capacity among them if @fast is set. On asymmetric systems that keeps a
+ * loaded thread off the little cores, while an idle one goes back to the
+ * whole mask and lets the scheduler pick. Without a device mask and with
+ * symmetric CPUs the affinity is left alone.
+ */
+static void napi_thread_place(struct napi_struct *napi,
+			      struct napi_thread_masks *m, bool fast)
+{
+	unsigned long max_cap = 0;
+	unsigned int i;
+	int cpu;
+
+	/* Someone else changed the affinity, start from theirs */
+	if (!cpumask_equal(current->cpus_ptr, m->placed))
+		cpumask_copy(m->allowed, current->cpus_ptr);
+
+	/* Pairs with dev_set_threaded_cpus(), which may be rewriting the
+	 * mask under RTNL right now. A mix of the old and the new one is
+	 * only used until the next wakeup sees the gen it bumps after.
+	 */
+	for (i = 0; i < BITS_TO_LONGS(nr_cpumask_bits); i++)
+		cpumask_bits(m->mask)[i] =
+			READ_ONCE(cpumask_bits(napi->dev->threaded_cpus)[i]);
+
+	if (!cpumask_and(m->mask, m->mask, cpu_online_mask))
+		cpumask_copy(m->mask, m->allowed);
+
+	if (fast) {
+		for_each_cpu(cpu, m->mask)
+			max_cap = max(max_cap, arch_scale_cpu_capacity(cpu));
+		for_each_cpu(cpu, m->mask)
+			if (arch_scale_cpu_capacity(cpu) < max_cap)
+				cpumask_clear_cpu(cpu, m->mask);
+	}
+
+	if (cpumask_equal(m->mask, current->cpus_ptr))
+		return;
+
+	if (!set_cpus_allowed_ptr(current, m->mask))
+		cpumask_copy(m->placed, m->mask);
+}
+
 static int napi_threaded_poll(void *data)
 {
 	struct napi_struct *napi = data;
+	unsigned int busy = 0, gen = 0;
+	struct napi_thread_masks m = {};
+	bool fast = false, place;
 	void *have;
 
+	/* Without the masks the thread is simply left where it is */
+	place = zalloc_cpumask_var(&m.allowed, GFP_KERNEL) &&
+		zalloc_cpumask_var(&m.placed, GFP_KERNEL) &&
+		zalloc_cpumask_var(&m.mask, GFP_KERNEL);
+	if (place) {
+		cpumask_copy(m.allowed, current->cpus_ptr);
+		cpumask_copy(m.placed, current->cpus_ptr);
+	}
+
 	while (!napi_thread_wait(napi)) {
+		bool busy_wakeup = false;
+		unsigned int dev_gen;
+		bool want_fast;
+
 		for (;;) {
 			bool repoll = false;
 
@@ -6656,9 +6749,35 @@ static int napi_threaded_poll(void *data)
 			if (!repoll)
 				break;
 
+			busy_wakeup = true;
 			cond_resched();
 		}
+
+		if (!place)
+			continue;
+
+		/* A wakeup that used up the budget at least once counts as
+		 * busy. Move to the fast CPUs after a few of those in a row and
+		 * only go back once the thread has calmed down completely.
+		 */
+		if (busy_wakeup)
+			busy = min(busy + 1, 2 * NAPI_THREAD_BUSY_THRESH);
+		else if (busy)
+			busy--;
+		want_fast = fast ? busy > 0 : busy >= NAPI_THREAD_BUSY_THRESH;
+
+		/* Paired with smp_store_release() in dev_set_threaded_cpus() */
+		dev_gen = smp_load_acquire(&napi->dev->threaded_cpus_gen);
+		if (want_fast != fast || dev_gen != gen) {
+			fast = want_fast;
+			gen = dev_gen;
+			napi_thread_place(napi, &m, fast);
+		}
 	}
+
+	free_cpumask_var(m.mask);
+	free_cpumask_var(m.placed);
+	free_cpumask_var(m.allowed);
 	return 0;
 }
 
@@ -10048,6 +10167,8 @@ int register_netdevice(struct net_device *dev)
 	 */
 	dev->hw_features |= (NETIF_F_SOFT_FEATURES | NETIF_F_SOFT_FEATURES_OFF);
 	dev->features |= NETIF_F_SOFT_FEATURES;
+	if (IS_ENABLED(CONFIG_NET_GRO_FRAGLIST_DEFAULT))
+		dev->features |= NETIF_F_GRO_FRAGLIST;
 
 	if (dev->udp_tunnel_nic_info) {
 		dev->features |= NETIF_F_RX_UDP_TUNNEL_PORT;
@@ -10680,6 +10801,9 @@ struct net_device *alloc_netdev_mqs(int sizeof_priv, const char *name,
 	if (netif_alloc_rx_queues(dev))
 		goto free_all;
 
+	if (!zalloc_cpumask_var(&dev->threaded_cpus, GFP_KERNEL))
+		goto free_all;
+
 	strcpy(dev->name, name);
 	dev->name_assign_type = name_assign_type;
 	dev->group = INIT_NETDEV_GROUP;
@@ -10749,6 +10873,7 @@ void free_netdev(struct net_device *dev)
 	dev->core_stats = NULL;
 	free_percpu(dev->xdp_bulkq);
 	dev->xdp_bulkq = NULL;
+	free_cpumask_var(dev->threaded_cpus);
 
 	/*  Compatibility with error handling in drivers */
 	if (dev->reg_state == NETREG_UNINITIALIZED) {
@@ -11152,6 +11277,8 @@ static int dev_cpu_dead(unsigned int oldcpu)
 		input_queue_head_incr(oldsd);
 	}
 
+	napi_data_cache_cpu_dead(oldcpu);
+
 	return 0;
 }
 
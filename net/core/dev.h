@@ -4,6 +4,7 @@
 
 #include <linux/types.h>
 
+struct cpumask;
 struct net;
 struct net_device;
 struct netdev_bpf;
@@ -88,8 +89,10 @@ int dev_change_xdp_fd(struct net_device *dev, struct netlink_ext_ack *extack,
 int dev_change_tx_queue_len(struct net_device *dev, unsigned long new_len);
 void dev_set_group(struct net_device *dev, int new_group);
 int dev_change_carrier(struct net_device *dev, bool new_carrier);
+void dev_set_threaded_cpus(struct net_device *dev, const struct cpumask *mask);
 
 void __dev_set_rx_mode(struct net_device *dev);
+void napi_data_cache_cpu_dead(unsigned int cpu);
 
 static inline void netif_set_gso_max_size(struct net_device *dev,
 					  unsigned int size)
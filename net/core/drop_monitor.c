@@ -71,14 +71,27 @@ struct net_dm_hw_entries {
 	struct net_dm_hw_entry entries[];
 };
 
+struct net_dm_sw_entry {
+	void *pc;
+	enum skb_drop_reason reason;
+	u32 count;
+};
+
+struct net_dm_sw_entries {
+	u32 num_entries;
+	struct net_dm_sw_entry entries[];
+};
+
 struct per_cpu_dm_data {
-	spinlock_t		lock;	/* Protects 'skb', 'hw_entries' and
-					 * 'send_timer'
+	spinlock_t		lock;	/* Protects 'skb', 'hw_entries',
+					 * 'sw_entries' and 'send_timer'
 					 */
 	union {
 		struct sk_buff			*skb;
 		struct net_dm_hw_entries	*hw_entries;
 	};
+	struct net_dm_sw_entries *sw_entries;
+	u32			sample_count;
 	struct sk_buff_head	drop_queue;
 	struct work_struct	dm_alert_work;
 	struct timer_list	send_timer;
@@ -97,12 +110,13 @@ static DEFINE_PER_CPU(struct per_cpu_dm_data, dm_cpu_data);
 static DEFINE_PER_CPU(struct per_cpu_dm_data, dm_hw_cpu_data);
 
 static int dm_hit_limit = 64;
-static int dm_delay = 1;
 static unsigned long dm_hw_check_delta = 2*HZ;
 
 static enum net_dm_alert_mode net_dm_alert_mode = NET_DM_ALERT_MODE_SUMMARY;
 static u32 net_dm_trunc_len;
 static u32 net_dm_queue_len = 1000;
+static u32 net_dm_sample_rate;
+static u32 net_dm_alert_interval = MSEC_PER_SEC;
 
 struct net_dm_alert_ops {
 	void (*kfree_skb_probe)(void *ignore, struct sk_buff *skb,
@@ -252,7 +266,8 @@ static void trace_drop_common(struct sk_buff *skb, void *location)
 	msg->entries++;
 
 	if (!timer_pending(&data->send_timer)) {
-		data->send_timer.expires = jiffies + dm_delay * HZ;
+		data->send_timer.expires = jiffies +
+			msecs_to_jiffies(net_dm_alert_interval);
 		add_timer(&data->send_timer);
 	}
 
@@ -470,7 +485,8 @@ net_dm_hw_trap_summary_probe(void *ignore, const struct devlink *devlink,
 	hw_entries->num_entries++;
 
 	if (!timer_pending(&hw_data->send_timer)) {
-		hw_data->send_timer.expires = jiffies + dm_delay * HZ;
+		hw_data->send_timer.expires = jiffies +
+			msecs_to_jiffies(net_dm_alert_interval);
 		add_timer(&hw_data->send_timer);
 	}
 
@@ -486,23 +502,38 @@ static const struct net_dm_alert_ops net_dm_alert_summary_ops = {
 	.hw_trap_probe		= net_dm_hw_trap_summary_probe,
 };
 
-static void net_dm_packet_trace_kfree_skb_hit(void *ignore,
-					      struct sk_buff *skb,
-					      void *location,
-					      enum skb_drop_reason reason)
+/* Returns true for every net_dm_sample_rate-th drop on this CPU, or for all
+ * of them when sampling is off. The counter is only touched from the probes
+ * of the local CPU, a drop nested in an interrupt may skew it a little, which
+ * is fine for sampling.
+ */
+static bool net_dm_sample(struct per_cpu_dm_data *data)
+{
+	if (net_dm_sample_rate <= 1)
+		return true;
+
+	if (++data->sample_count < net_dm_sample_rate)
+		return false;
+
+	data->sample_count = 0;
+	return true;
+}
+
+static bool net_dm_packet_queue(struct per_cpu_dm_data *data,
+				struct sk_buff *skb, void *location,
+				enum skb_drop_reason reason)
 {
 	ktime_t tstamp = ktime_get_real();
-	struct per_cpu_dm_data *data;
 	struct net_dm_skb_cb *cb;
 	struct sk_buff *nskb;
 	unsigned long flags;
 
 	if (!skb_mac_header_was_set(skb))
-		return;
+		return false;
 
 	nskb = skb_clone(skb, GFP_ATOMIC);
 	if (!nskb)
-		return;
+		return false;
 
 	if (unlikely(reason >= SKB_DROP_REASON_MAX || reason <= 0))
 		reason = SKB_DROP_REASON_NOT_SPECIFIED;
@@ -514,8 +545,6 @@ static void net_dm_packet_trace_kfree_skb_hit(void *ignore,
 	 */
 	nskb->tstamp = tstamp;
 
-	data = this_cpu_ptr(&dm_cpu_data);
-
 	spin_lock_irqsave(&data->drop_queue.lock, flags);
 	if (skb_queue_len(&data->drop_queue) < net_dm_queue_len)
 		__skb_queue_tail(&data->drop_queue, nskb);
@@ -523,9 +552,7 @@ static void net_dm_packet_trace_kfree_skb_hit(void *ignore,
 		goto unlock_free;
 	spin_unlock_irqrestore(&data->drop_queue.lock, flags);
 
-	schedule_work(&data->dm_alert_work);
-
-	return;
+	return true;
 
 unlock_free:
 	spin_unlock_irqrestore(&data->drop_queue.lock, flags);
@@ -533,6 +560,21 @@ static void net_dm_packet_trace_kfree_skb_hit(void *ignore,
 	u64_stats_inc(&data->stats.dropped);
 	u64_stats_update_end(&data->stats.syncp);
 	consume_skb(nskb);
+	return false;
+}
+
+static void net_dm_packet_trace_kfree_skb_hit(void *ignore,
+					      struct sk_buff *skb,
+					      void *location,
+					      enum skb_drop_reason reason)
+{
+	struct per_cpu_dm_data *data = this_cpu_ptr(&dm_cpu_data);
+
+	if (!net_dm_sample(data))
+		return;
+
+	if (net_dm_packet_queue(data, skb, location, reason))
+		schedule_work(&data->dm_alert_work);
 }
 
 static void net_dm_packet_trace_napi_poll_hit(void *ignore,
@@ -1001,9 +1043,231 @@ static const struct net_dm_alert_ops net_dm_alert_packet_ops = {
 	.hw_trap_probe		= net_dm_hw_trap_packet_probe,
 };
 
+static struct net_dm_sw_entries *
+net_dm_sw_reset_per_cpu_data(struct per_cpu_dm_data *data)
+{
+	struct net_dm_sw_entries *sw_entries;
+	unsigned long flags;
+
+	sw_entries = kzalloc(struct_size(sw_entries, entries, dm_hit_limit),
+			     GFP_KERNEL);
+	if (!sw_entries)
+		mod_timer(&data->send_timer, jiffies + HZ / 10);
+
+	spin_lock_irqsave(&data->lock, flags);
+	swap(data->sw_entries, sw_entries);
+	spin_unlock_irqrestore(&data->lock, flags);
+
+	return sw_entries;
+}
+
+static size_t net_dm_sw_entry_size(const struct net_dm_sw_entry *sw_entry)
+{
+	       /* NET_DM_ATTR_SW_ENTRY nest */
+	return nla_total_size(0) +
+	       /* NET_DM_ATTR_PC */
+	       nla_total_size_64bit(sizeof(u64)) +
+	       /* NET_DM_ATTR_SYMBOL */
+	       nla_total_size(NET_DM_MAX_SYMBOL_LEN + 1) +
+	       /* NET_DM_ATTR_REASON */
+	       nla_total_size(strlen(drop_reasons[sw_entry->reason]) + 1) +
+	       /* NET_DM_ATTR_SW_DROP_COUNT */
+	       nla_total_size(sizeof(u32));
+}
+
+static size_t
+net_dm_sw_report_size(const struct net_dm_sw_entries *sw_entries)
+{
+	size_t size;
+	int i;
+
+	size = nlmsg_msg_size(GENL_HDRLEN + net_drop_monitor_family.hdrsize);
+	size = NLMSG_ALIGN(size) +
+	       /* Ancillary header */
+	       nla_total_size(sizeof(struct net_dm_alert_msg)) +
+	       /* NET_DM_ATTR_SW_ENTRIES nest */
+	       nla_total_size(0);
+
+	for (i = 0; i < sw_entries->num_entries; i++)
+		size += net_dm_sw_entry_size(&sw_entries->entries[i]);
+
+	return size;
+}
+
+static int net_dm_sw_entry_put(struct sk_buff *msg,
+			       const struct net_dm_sw_entry *sw_entry)
+{
+	char buf[NET_DM_MAX_SYMBOL_LEN];
+	struct nlattr *attr;
+
+	attr = nla_nest_start(msg, NET_DM_ATTR_SW_ENTRY);
+	if (!attr)
+		return -EMSGSIZE;
+
+	if (nla_put_u64_64bit(msg, NET_DM_ATTR_PC,
+			      (u64)(uintptr_t)sw_entry->pc, NET_DM_ATTR_PAD))
+		goto nla_put_failure;
+
+	snprintf(buf, sizeof(buf), "%pS", sw_entry->pc);
+	if (nla_put_string(msg, NET_DM_ATTR_SYMBOL, buf))
+		goto nla_put_failure;
+
+	if (nla_put_string(msg, NET_DM_ATTR_REASON,
+			   drop_reasons[sw_entry->reason]))
+		goto nla_put_failure;
+
+	if (nla_put_u32(msg, NET_DM_ATTR_SW_DROP_COUNT, sw_entry->count))
+		goto nla_put_failure;
+
+	nla_nest_end(msg, attr);
+
+	return 0;
+
+nla_put_failure:
+	nla_nest_cancel(msg, attr);
+	return -EMSGSIZE;
+}
+
+static int net_dm_sw_report_fill(struct sk_buff *msg,
+				 const struct net_dm_sw_entries *sw_entries)
+{
+	struct net_dm_alert_msg anc_hdr = { 0 };
+	struct nlattr *attr;
+	void *hdr;
+	int i, rc;
+
+	hdr = genlmsg_put(msg, 0, 0, &net_drop_monitor_family, 0,
+			  NET_DM_CMD_ALERT);
+	if (!hdr)
+		return -EMSGSIZE;
+
+	/* We need to put the ancillary header in order not to break user
+	 * space.
+	 */
+	if (nla_put(msg, NLA_UNSPEC, sizeof(anc_hdr), &anc_hdr))
+		goto nla_put_failure;
+
+	attr = nla_nest_start(msg, NET_DM_ATTR_SW_ENTRIES);
+	if (!attr)
+		goto nla_put_failure;
+
+	for (i = 0; i < sw_entries->num_entries; i++) {
+		rc = net_dm_sw_entry_put(msg, &sw_entries->entries[i]);
+		if (rc)
+			goto nla_put_failure;
+	}
+
+	nla_nest_end(msg, attr);
+	genlmsg_end(msg, hdr);
+
+	return 0;
+
+nla_put_failure:
+	genlmsg_cancel(msg, hdr);
+	return -EMSGSIZE;
+}
+
+static void net_dm_aggr_work(struct work_struct *work)
+{
+	struct net_dm_sw_entries *sw_entries;
+	struct per_cpu_dm_data *data;
+	struct sk_buff *msg;
+	int rc;
+
+	data = container_of(work, struct per_cpu_dm_data, dm_alert_work);
+
+	sw_entries = net_dm_sw_reset_per_cpu_data(data);
+	if (!sw_entries || !sw_entries->num_entries)
+		goto out;
+
+	msg = genlmsg_new(net_dm_sw_report_size(sw_entries), GFP_KERNEL);
+	if (!msg)
+		goto out;
+
+	rc = net_dm_sw_report_fill(msg, sw_entries);
+	if (rc) {
+		nlmsg_free(msg);
+		goto out;
+	}
+
+	genlmsg_multicast(&net_drop_monitor_family, msg, 0, 0, GFP_KERNEL);
+
+out:
+	kfree(sw_entries);
+	/* The sampled packets are only flushed together with the counters,
+	 * so that the probe never has to schedule the work on its own.
+	 */
+	net_dm_packet_work(work);
+}
+
+static void net_dm_aggr_trace_kfree_skb_hit(void *ignore,
+					    struct sk_buff *skb,
+					    void *location,
+					    enum skb_drop_reason reason)
+{
+	struct net_dm_sw_entries *sw_entries;
+	struct net_dm_sw_entry *sw_entry;
+	struct per_cpu_dm_data *data;
+	unsigned long flags;
+	bool sample;
+	int i;
+
+	if (unlikely(reason >= SKB_DROP_REASON_MAX || reason <= 0))
+		reason = SKB_DROP_REASON_NOT_SPECIFIED;
+
+	data = this_cpu_ptr(&dm_cpu_data);
+	spin_lock_irqsave(&data->lock, flags);
+	sample = net_dm_sample_rate && net_dm_sample(data);
+	sw_entries = data->sw_entries;
+
+	if (!sw_entries)
+		goto out;
+
+	for (i = 0; i < sw_entries->num_entries; i++) {
+		sw_entry = &sw_entries->entries[i];
+		if (sw_entry->pc == location && sw_entry->reason == reason) {
+			sw_entry->count++;
+			goto out;
+		}
+	}
+	if (sw_entries->num_entries == dm_hit_limit) {
+		u64_stats_update_begin(&data->stats.syncp);
+		u64_stats_inc(&data->stats.dropped);
+		u64_stats_update_end(&data->stats.syncp);
+		goto out;
+	}
+
+	sw_entry = &sw_entries->entries[sw_entries->num_entries];
+	sw_entry->pc = location;
+	sw_entry->reason = reason;
+	sw_entry->count = 1;
+	sw_entries->num_entries++;
+
+	if (!timer_pending(&data->send_timer)) {
+		data->send_timer.expires = jiffies +
+			msecs_to_jiffies(net_dm_alert_interval);
+		add_timer(&data->send_timer);
+	}
+
+out:
+	spin_unlock_irqrestore(&data->lock, flags);
+
+	if (sample)
+		net_dm_packet_queue(data, skb, location, reason);
+}
+
+static const struct net_dm_alert_ops net_dm_alert_aggr_ops = {
+	.kfree_skb_probe	= net_dm_aggr_trace_kfree_skb_hit,
+	.napi_poll_probe	= net_dm_packet_trace_napi_poll_hit,
+	.work_item_func		= net_dm_aggr_work,
+	.hw_work_item_func	= net_dm_hw_summary_work,
+	.hw_trap_probe		= net_dm_hw_trap_summary_probe,
+};
+
 static const struct net_dm_alert_ops *net_dm_alert_ops_arr[] = {
 	[NET_DM_ALERT_MODE_SUMMARY]	= &net_dm_alert_summary_ops,
 	[NET_DM_ALERT_MODE_PACKET]	= &net_dm_alert_packet_ops,
+	[NET_DM_ALERT_MODE_AGGREGATE]	= &net_dm_alert_aggr_ops,
 };
 
 #if IS_ENABLED(CONFIG_NET_DEVLINK)
@@ -1136,12 +1400,18 @@ static int net_dm_trace_on_set(struct netlink_ext_ack *extack)
 
 		INIT_WORK(&data->dm_alert_work, ops->work_item_func);
 		timer_setup(&data->send_timer, sched_send_work, 0);
+		data->sample_count = 0;
 		/* Allocate a new per-CPU skb for the summary alert message and
 		 * free the old one which might contain stale data from
-		 * previous tracing.
+		 * previous tracing. The aggregate mode keeps its counters in
+		 * a table instead.
 		 */
-		skb = reset_per_cpu_data(data);
-		consume_skb(skb);
+		if (net_dm_alert_mode == NET_DM_ALERT_MODE_AGGREGATE) {
+			kfree(net_dm_sw_reset_per_cpu_data(data));
+		} else {
+			skb = reset_per_cpu_data(data);
+			consume_skb(skb);
+		}
 	}
 
 	rc = register_trace_kfree_skb(ops->kfree_skb_probe, NULL);
@@ -1197,6 +1467,8 @@ static void net_dm_trace_off_set(void)
 		cancel_work_sync(&data->dm_alert_work);
 		while ((skb = __skb_dequeue(&data->drop_queue)))
 			consume_skb(skb);
+		kfree(data->sw_entries);
+		data->sw_entries = NULL;
 	}
 
 	module_put(THIS_MODULE);
@@ -1246,6 +1518,7 @@ static int net_dm_alert_mode_get_from_info(struct genl_info *info,
 	switch (val) {
 	case NET_DM_ALERT_MODE_SUMMARY:
 	case NET_DM_ALERT_MODE_PACKET:
+	case NET_DM_ALERT_MODE_AGGREGATE:
 		*p_alert_mode = val;
 		break;
 	default:
@@ -1291,6 +1564,23 @@ static void net_dm_queue_len_set(struct genl_info *info)
 	net_dm_queue_len = nla_get_u32(info->attrs[NET_DM_ATTR_QUEUE_LEN]);
 }
 
+static void net_dm_sample_rate_set(struct genl_info *info)
+{
+	if (!info->attrs[NET_DM_ATTR_SAMPLE_RATE])
+		return;
+
+	net_dm_sample_rate = nla_get_u32(info->attrs[NET_DM_ATTR_SAMPLE_RATE]);
+}
+
+static void net_dm_alert_interval_set(struct genl_info *info)
+{
+	if (!info->attrs[NET_DM_ATTR_ALERT_INTERVAL])
+		return;
+
+	net_dm_alert_interval =
+		nla_get_u32(info->attrs[NET_DM_ATTR_ALERT_INTERVAL]);
+}
+
 static int net_dm_cmd_config(struct sk_buff *skb,
 			struct genl_info *info)
 {
@@ -1310,6 +1600,10 @@ static int net_dm_cmd_config(struct sk_buff *skb,
 
 	net_dm_queue_len_set(info);
 
+	net_dm_sample_rate_set(info);
+
+	net_dm_alert_interval_set(info);
+
 	return 0;
 }
 
@@ -1391,6 +1685,12 @@ static int net_dm_config_fill(struct sk_buff *msg, struct genl_info *info)
 	if (nla_put_u32(msg, NET_DM_ATTR_QUEUE_LEN, net_dm_queue_len))
 		goto nla_put_failure;
 
+	if (nla_put_u32(msg, NET_DM_ATTR_SAMPLE_RATE, net_dm_sample_rate))
+		goto nla_put_failure;
+
+	if (nla_put_u32(msg, NET_DM_ATTR_ALERT_INTERVAL, net_dm_alert_interval))
+		goto nla_put_failure;
+
 	genlmsg_end(msg, hdr);
 
 	return 0;
@@ -1591,6 +1891,8 @@ static const struct nla_policy net_dm_nl_policy[NET_DM_ATTR_MAX + 1] = {
 	[NET_DM_ATTR_QUEUE_LEN] = { .type = NLA_U32 },
 	[NET_DM_ATTR_SW_DROPS]	= {. type = NLA_FLAG },
 	[NET_DM_ATTR_HW_DROPS]	= {. type = NLA_FLAG },
+	[NET_DM_ATTR_SAMPLE_RATE] = { .type = NLA_U32 },
+	[NET_DM_ATTR_ALERT_INTERVAL] = NLA_POLICY_MIN(NLA_U32, 1),
 };
 
 static const struct genl_small_ops dropmon_ops[] = {
@@ -1683,6 +1985,7 @@ static void net_dm_cpu_data_fini(int cpu)
 	 * to this struct and can free the skb inside it.
 	 */
 	consume_skb(data->skb);
+	kfree(data->sw_entries);
 	__net_dm_cpu_data_fini(data);
 }
 
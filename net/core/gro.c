@@ -295,6 +295,7 @@ static void napi_gro_complete(struct napi_struct *napi, struct sk_buff *skb)
 	struct packet_offload *ptype;
 	__be16 type = skb->protocol;
 	struct list_head *head = &offload_base;
+	struct softnet_data *sd;
 	int err = -ENOENT;
 
 	BUILD_BUG_ON(sizeof(struct napi_gro_cb) > sizeof(skb->cb));
@@ -322,6 +323,11 @@ static void napi_gro_complete(struct napi_struct *napi, struct sk_buff *skb)
 		return;
 	}
 
+	sd = this_cpu_ptr(&softnet_data);
+	sd->gro_merged += NAPI_GRO_CB(skb)->count;
+	if (skb_shinfo(skb)->gso_type & SKB_GSO_FRAGLIST)
+		sd->gro_fraglist += NAPI_GRO_CB(skb)->count;
+
 out:
 	gro_normal_one(napi, skb, NAPI_GRO_CB(skb)->count);
 }
@@ -254,8 +254,10 @@ static int neigh_forced_gc(struct neigh_table *tbl)
 	int max_clean = atomic_read(&tbl->gc_entries) -
 			READ_ONCE(tbl->gc_thresh2);
 	unsigned long tref = jiffies - 5 * HZ;
+	u64 tmax = ktime_get_ns() + NSEC_PER_MSEC;
 	struct neighbour *n, *tmp;
 	int shrunk = 0;
+	int loop = 0;
 
 	NEIGH_CACHE_STAT_INC(tbl, forced_gc_runs);
 
@@ -279,10 +281,19 @@ static int neigh_forced_gc(struct neigh_table *tbl)
 			if (shrunk >= max_clean)
 				break;
 		}
+
+		/* This runs from neighbour creation, don't let a huge table
+		 * hold everybody up for long.
+		 */
+		if (++loop == 16) {
+			if (ktime_get_ns() > tmax)
+				goto unlock;
+			loop = 0;
+		}
 	}
 
 	WRITE_ONCE(tbl->last_flush, jiffies);
-
+unlock:
 	write_unlock_bh(&tbl->lock);
 
 	return shrunk;
@@ -936,12 +947,36 @@ static void neigh_connect(struct neighbour *neigh)
 	WRITE_ONCE(neigh->output, neigh->ops->connected_output);
 }
 
+/* neigh_periodic_work() looks at no more than this many hash buckets per run
+ * and comes back correspondingly sooner, so that a large table still gets
+ * scanned every BASE_REACHABLE_TIME/2 without holding up everybody else.
+ */
+#define NEIGH_GC_MAX_BUCKETS	256
+
+static struct neigh_table *neigh_tables[NEIGH_NR_TABLES] __read_mostly;
+
+/* Next bucket neigh_periodic_work() looks at, per table */
+static unsigned int neigh_gc_next[NEIGH_NR_TABLES];
+
+static unsigned int *neigh_gc_cursor(struct neigh_table *tbl)
+{
+	int i;
+
+	for (i = 0; i < NEIGH_NR_TABLES; i++)
+		if (neigh_tables[i] == tbl)
+			return &neigh_gc_next[i];
+
+	return NULL;
+}
+
 static void neigh_periodic_work(struct work_struct *work)
 {
 	struct neigh_table *tbl = container_of(work, struct neigh_table, gc_work.work);
+	unsigned long delay = NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1;
+	unsigned int *cursor = neigh_gc_cursor(tbl);
+	unsigned int i, start, end;
 	struct neighbour *n;
 	struct neighbour __rcu **np;
-	unsigned int i;
 	struct neigh_hash_table *nht;
 
 	NEIGH_CACHE_STAT_INC(tbl, periodic_gc_runs);
@@ -963,10 +998,23 @@ static void neigh_periodic_work(struct work_struct *work)
 				neigh_rand_reach_time(NEIGH_VAR(p, BASE_REACHABLE_TIME));
 	}
 
-	if (atomic_read(&tbl->entries) < READ_ONCE(tbl->gc_thresh1))
+	if (atomic_read(&tbl->entries) < READ_ONCE(tbl->gc_thresh1)) {
+		if (cursor)
+			*cursor = 0;
 		goto out;
+	}
 
-	for (i = 0 ; i < (1 << nht->hash_shift); i++) {
+	start = 0;
+	end = 1 << nht->hash_shift;
+	if (cursor && end > NEIGH_GC_MAX_BUCKETS) {
+		/* Both are powers of two, so the slices tile the table */
+		delay = max(delay / (end / NEIGH_GC_MAX_BUCKETS), 1UL);
+		start = *cursor < end ? *cursor : 0;
+		end = start + NEIGH_GC_MAX_BUCKETS;
+		*cursor = end == 1 << nht->hash_shift ? 0 : end;
+	}
+
+	for (i = start; i < end; i++) {
 		np = &nht->hash_buckets[i];
 
 		while ((n = rcu_dereference_protected(*np,
@@ -1018,8 +1066,7 @@ static void neigh_periodic_work(struct work_struct *work)
 	 * ARP entry timeouts range from 1/2 BASE_REACHABLE_TIME to 3/2
 	 * BASE_REACHABLE_TIME.
 	 */
-	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work,
-			      NEIGH_VAR(&tbl->parms, BASE_REACHABLE_TIME) >> 1);
+	queue_delayed_work(system_power_efficient_wq, &tbl->gc_work, delay);
 	write_unlock_bh(&tbl->lock);
 }
 
@@ -1752,8 +1799,6 @@ static void neigh_parms_destroy(struct neigh_parms *parms)
 
 static struct lock_class_key neigh_table_proxy_queue_class;
 
-static struct neigh_table *neigh_tables[NEIGH_NR_TABLES] __read_mostly;
-
 void neigh_table_init(int index, struct neigh_table *tbl)
 {
 	unsigned long now = jiffies;
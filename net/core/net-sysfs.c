@@ -620,6 +620,59 @@ static ssize_t threaded_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(threaded);
 
+static ssize_t threaded_cpus_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct net_device *netdev = to_net_dev(dev);
+	ssize_t ret = -EINVAL;
+
+	if (!rtnl_trylock())
+		return restart_syscall();
+
+	if (dev_isalive(netdev))
+		ret = sysfs_emit(buf, "%*pb\n",
+				 cpumask_pr_args(netdev->threaded_cpus));
+
+	rtnl_unlock();
+	return ret;
+}
+
+static ssize_t threaded_cpus_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t len)
+{
+	struct net_device *netdev = to_net_dev(dev);
+	struct net *net = dev_net(netdev);
+	cpumask_var_t mask;
+	ssize_t ret;
+
+	if (!ns_capable(net->user_ns, CAP_NET_ADMIN))
+		return -EPERM;
+
+	if (!alloc_cpumask_var(&mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	ret = bitmap_parse(buf, len, cpumask_bits(mask), nr_cpumask_bits);
+	if (ret)
+		goto out;
+
+	if (!rtnl_trylock()) {
+		ret = restart_syscall();
+		goto out;
+	}
+
+	ret = -EINVAL;
+	if (dev_isalive(netdev)) {
+		dev_set_threaded_cpus(netdev, mask);
+		ret = len;
+	}
+	rtnl_unlock();
+out:
+	free_cpumask_var(mask);
+	return ret;
+}
+static DEVICE_ATTR_RW(threaded_cpus);
+
 static struct attribute *net_class_attrs[] __ro_after_init = {
 	&dev_attr_netdev_group.attr,
 	&dev_attr_type.attr,
@@ -653,6 +706,7 @@ static struct attribute *net_class_attrs[] __ro_after_init = {
 	&dev_attr_carrier_up_count.attr,
 	&dev_attr_carrier_down_count.attr,
 	&dev_attr_threaded.attr,
+	&dev_attr_threaded_cpus.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(net_class);
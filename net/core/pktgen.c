@@ -178,6 +178,8 @@
 /* Max number of internet mix entries that can be specified in imix_weights. */
 #define MAX_IMIX_ENTRIES 20
 #define IMIX_PRECISION 100 /* Precision of IMIX distribution */
+#define PKTGEN_LAT_BUCKETS 20 /* log2 usec buckets of the latency histogram */
+#define PKTGEN_LAT_DRAIN_MS 5000 /* wait for LATENCY skbs on remove_device */
 
 #define func_enter() pr_debug("entering %s\n", __func__);
 
@@ -200,6 +202,7 @@
 	pf(VID_RND)		/* Random VLAN ID */			\
 	pf(SVID_RND)		/* Random SVLAN ID */			\
 	pf(NODE)		/* Node memory alloc*/			\
+	pf(LATENCY)		/* skb release latency histogram */	\
 
 #define pf(flag)		flag##_SHIFT,
 enum pkt_flags {
@@ -249,6 +252,8 @@ struct imix_pkt {
 	u64 size;
 	u64 weight;
 	u64 count_so_far;
+	struct sk_buff *skb;	/* template, when clone_skb is set */
+	unsigned int clone_count;
 };
 
 struct flow_state {
@@ -358,6 +363,10 @@ struct pktgen_dev {
 	/* Maps 0-IMIX_PRECISION range to imix_entry based on probability*/
 	__u8 imix_distribution[IMIX_PRECISION];
 
+	/* LATENCY skbs not freed yet, and their latencies so far */
+	atomic_t lat_inflight;
+	atomic64_t lat_hist[PKTGEN_LAT_BUCKETS];
+
 	/* MPLS */
 	unsigned int nr_labels;	/* Depth of stack, 0 = no MPLS */
 	__be32 labels[MAX_MPLS_LABELS];
@@ -708,6 +717,17 @@ static int pktgen_if_show(struct seq_file *seq, void *v)
 		seq_puts(seq, "\n");
 	}
 
+	if (pkt_dev->flags & F_LATENCY) {
+		int i;
+
+		/* Each bucket is labelled with its lower bound */
+		seq_puts(seq, "     release_us: ");
+		for (i = 0; i < PKTGEN_LAT_BUCKETS; i++)
+			seq_printf(seq, "%u:%lld ", i ? 1U << (i - 1) : 0,
+				   atomic64_read(&pkt_dev->lat_hist[i]));
+		seq_puts(seq, "\n");
+	}
+
 	seq_printf(seq,
 		   "     started: %lluus  stopped: %lluus idle: %lluus\n",
 		   (unsigned long long) ktime_to_us(pkt_dev->started_at),
@@ -831,6 +851,20 @@ static int strn_len(const char __user * user_buffer, unsigned int maxlen)
 	return i;
 }
 
+static void pktgen_imix_free(struct pktgen_dev *pkt_dev)
+{
+	int i;
+
+	for (i = 0; i < pkt_dev->n_imix_entries; i++) {
+		struct imix_pkt *entry = &pkt_dev->imix_entries[i];
+
+		if (entry->skb == pkt_dev->skb)
+			pkt_dev->skb = NULL;
+		kfree_skb(entry->skb);
+		entry->skb = NULL;
+	}
+}
+
 /* Parses imix entries from user buffer.
  * The user buffer should consist of imix entries separated by spaces
  * where each entry consists of size and weight delimited by commas.
@@ -844,6 +878,7 @@ static ssize_t get_imix_entries(const char __user *buffer,
 	long len;
 	char c;
 
+	pktgen_imix_free(pkt_dev);
 	pkt_dev->n_imix_entries = 0;
 
 	do {
@@ -1056,8 +1091,9 @@ static ssize_t pktgen_if_write(struct file *file,
 	}
 
 	if (!strcmp(name, "imix_weights")) {
-		if (pkt_dev->clone_skb > 0)
-			return -EINVAL;
+		/* this frees the templates pktgen_xmit() is sending */
+		if (pkt_dev->running)
+			return -EBUSY;
 
 		len = get_imix_entries(&user_buffer[i], pkt_dev);
 		if (len < 0)
@@ -1191,15 +1227,13 @@ static ssize_t pktgen_if_write(struct file *file,
 		len = num_arg(&user_buffer[i], 10, &value);
 		if (len < 0)
 			return len;
-		/* clone_skb is not supported for netif_receive xmit_mode and
-		 * IMIX mode.
+		/* clone_skb is not supported for netif_receive xmit_mode.
+		 * In IMIX mode it applies to each size's template.
 		 */
 		if ((value > 0) &&
 		    ((pkt_dev->xmit_mode == M_NETIF_RECEIVE) ||
 		     !(pkt_dev->odev->priv_flags & IFF_TX_SKB_SHARING)))
 			return -ENOTSUPP;
-		if (value > 0 && pkt_dev->n_imix_entries > 0)
-			return -EINVAL;
 
 		i += len;
 		pkt_dev->clone_skb = value;
@@ -2587,7 +2621,7 @@ static void mod_cur_headers(struct pktgen_dev *pkt_dev)
 				t = pkt_dev->min_pkt_size;
 		}
 		pkt_dev->cur_pkt_size = t;
-	} else if (pkt_dev->n_imix_entries > 0) {
+	} else if (pkt_dev->n_imix_entries > 0 && !pkt_dev->clone_skb) {
 		struct imix_pkt *entry;
 		__u32 t = prandom_u32_max(IMIX_PRECISION);
 		__u8 entry_index = pkt_dev->imix_distribution[t];
@@ -2751,10 +2785,55 @@ static inline __be16 build_tci(unsigned int id, unsigned int cfi,
 	return htons(id | (cfi << 12) | (prio << 13));
 }
 
+static void pktgen_stamp_hdr(struct pktgen_hdr *pgh)
+{
+	struct timespec64 timestamp;
+
+	/*
+	 * pgh->tv_sec wraps in y2106 when interpreted as unsigned
+	 * as done by wireshark, or y2038 when interpreted as signed.
+	 * This is probably harmless, but if anyone wants to improve
+	 * it, we could introduce a variant that puts 64-bit nanoseconds
+	 * into the respective header bytes.
+	 * This would also be slightly faster to read.
+	 */
+	ktime_get_real_ts64(&timestamp);
+	pgh->tv_sec = htonl(timestamp.tv_sec);
+	pgh->tv_usec = htonl(timestamp.tv_nsec / NSEC_PER_USEC);
+}
+
+static struct pktgen_hdr *pktgen_skb_hdr(struct sk_buff *skb)
+{
+	return (struct pktgen_hdr *)(skb_transport_header(skb) +
+				     sizeof(struct udphdr));
+}
+
+/* Account the time from the last pktgen_stamp_hdr() of a LATENCY skb, done
+ * right before handing it to the device, to the device releasing it. That is
+ * the TX completion for most drivers, but drivers and qdiscs that
+ * skb_orphan() early run the destructor there, so this measures when the
+ * stack lets go of the skb, not when the packet left the wire.
+ */
+static void pktgen_lat_destructor(struct sk_buff *skb)
+{
+	struct pktgen_dev *pkt_dev = skb_shinfo(skb)->destructor_arg;
+	struct pktgen_hdr *pgh = pktgen_skb_hdr(skb);
+	struct timespec64 now;
+	s64 us;
+	int i;
+
+	ktime_get_real_ts64(&now);
+	us = (s64)(u32)(now.tv_sec - ntohl(pgh->tv_sec)) * USEC_PER_SEC +
+	     now.tv_nsec / NSEC_PER_USEC - ntohl(pgh->tv_usec);
+
+	i = us > 0 ? min_t(int, ilog2(us) + 1, PKTGEN_LAT_BUCKETS - 1) : 0;
+	atomic64_inc(&pkt_dev->lat_hist[i]);
+	atomic_dec(&pkt_dev->lat_inflight);
+}
+
 static void pktgen_finalize_skb(struct pktgen_dev *pkt_dev, struct sk_buff *skb,
 				int datalen)
 {
-	struct timespec64 timestamp;
 	struct pktgen_hdr *pgh;
 
 	pgh = skb_put(skb, sizeof(*pgh));
@@ -2816,17 +2895,7 @@ static void pktgen_finalize_skb(struct pktgen_dev *pkt_dev, struct sk_buff *skb,
 		pgh->tv_sec = 0;
 		pgh->tv_usec = 0;
 	} else {
-		/*
-		 * pgh->tv_sec wraps in y2106 when interpreted as unsigned
-		 * as done by wireshark, or y2038 when interpreted as signed.
-		 * This is probably harmless, but if anyone wants to improve
-		 * it, we could introduce a variant that puts 64-bit nanoseconds
-		 * into the respective header bytes.
-		 * This would also be slightly faster to read.
-		 */
-		ktime_get_real_ts64(&timestamp);
-		pgh->tv_sec = htonl(timestamp.tv_sec);
-		pgh->tv_usec = htonl(timestamp.tv_nsec / NSEC_PER_USEC);
+		pktgen_stamp_hdr(pgh);
 	}
 }
 
@@ -3126,11 +3195,15 @@ static struct sk_buff *fill_packet(struct net_device *odev,
 
 static void pktgen_clear_counters(struct pktgen_dev *pkt_dev)
 {
+	int i;
+
 	pkt_dev->seq_num = 1;
 	pkt_dev->idle_acc = 0;
 	pkt_dev->sofar = 0;
 	pkt_dev->tx_bytes = 0;
 	pkt_dev->errors = 0;
+	for (i = 0; i < PKTGEN_LAT_BUCKETS; i++)
+		atomic64_set(&pkt_dev->lat_hist[i], 0);
 }
 
 /* Set up structure for sending pkts, clear counters */
@@ -3324,6 +3397,7 @@ static int pktgen_stop_device(struct pktgen_dev *pkt_dev)
 	}
 
 	pkt_dev->running = 0;
+	pktgen_imix_free(pkt_dev);
 	kfree_skb(pkt_dev->skb);
 	pkt_dev->skb = NULL;
 	pkt_dev->stopped_at = ktime_get();
@@ -3428,7 +3502,8 @@ static void pktgen_wait_for_skb(struct pktgen_dev *pkt_dev)
 {
 	ktime_t idle_start = ktime_get();
 
-	while (refcount_read(&(pkt_dev->skb->users)) != 1) {
+	while (pkt_dev->skb ? refcount_read(&(pkt_dev->skb->users)) != 1 :
+	       atomic_read(&pkt_dev->lat_inflight)) {
 		if (signal_pending(current))
 			break;
 
@@ -3440,6 +3515,48 @@ static void pktgen_wait_for_skb(struct pktgen_dev *pkt_dev)
 	pkt_dev->idle_acc += ktime_to_ns(ktime_sub(ktime_get(), idle_start));
 }
 
+/* Latencies are only meaningful for skbs that are sent once and then freed
+ * by the device.
+ */
+static bool pktgen_lat_enabled(const struct pktgen_dev *pkt_dev)
+{
+	return (pkt_dev->flags & F_LATENCY) &&
+	       !(pkt_dev->flags & F_NO_TIMESTAMP) &&
+	       !pkt_dev->clone_skb &&
+	       pkt_dev->xmit_mode != M_NETIF_RECEIVE;
+}
+
+/* Switch to the template of a randomly picked IMIX size, rebuilding it once
+ * it has been sent clone_skb times. The templates own the skbs,
+ * pkt_dev->skb just points at one of them.
+ */
+static int pktgen_imix_next(struct net_device *odev,
+			    struct pktgen_dev *pkt_dev)
+{
+	__u8 entry_index =
+		pkt_dev->imix_distribution[prandom_u32_max(IMIX_PRECISION)];
+	struct imix_pkt *entry = &pkt_dev->imix_entries[entry_index];
+
+	if (!entry->skb || ++entry->clone_count >= pkt_dev->clone_skb) {
+		struct sk_buff *skb;
+
+		pkt_dev->cur_pkt_size = entry->size;
+		skb = fill_packet(odev, pkt_dev);
+		if (!skb)
+			return -ENOMEM;
+
+		kfree_skb(entry->skb);
+		entry->skb = skb;
+		entry->clone_count = 0;
+	}
+
+	entry->count_so_far++;
+	pkt_dev->skb = entry->skb;
+	pkt_dev->last_pkt_size = entry->skb->len;
+
+	return 0;
+}
+
 static void pktgen_xmit(struct pktgen_dev *pkt_dev)
 {
 	unsigned int burst = READ_ONCE(pkt_dev->burst);
@@ -3462,10 +3579,18 @@ static void pktgen_xmit(struct pktgen_dev *pkt_dev)
 		return;
 	}
 
-	/* If no skb or clone count exhausted then get new one */
-	if (!pkt_dev->skb || (pkt_dev->last_ok &&
-			      ++pkt_dev->clone_count >= pkt_dev->clone_skb)) {
-		/* build a new pkt */
+	if (pkt_dev->n_imix_entries > 0 && pkt_dev->clone_skb) {
+		/* retry the same template if the last send failed */
+		if ((!pkt_dev->skb || pkt_dev->last_ok) &&
+		    pktgen_imix_next(odev, pkt_dev)) {
+			pr_err("ERROR: couldn't allocate skb in fill_packet\n");
+			schedule();
+			return;
+		}
+	} else if (!pkt_dev->skb ||
+		   (pkt_dev->last_ok &&
+		    ++pkt_dev->clone_count >= pkt_dev->clone_skb)) {
+		/* If no skb or clone count exhausted then get new one */
 		kfree_skb(pkt_dev->skb);
 
 		pkt_dev->skb = fill_packet(odev, pkt_dev);
@@ -3477,11 +3602,20 @@ static void pktgen_xmit(struct pktgen_dev *pkt_dev)
 		}
 		pkt_dev->last_pkt_size = pkt_dev->skb->len;
 		pkt_dev->clone_count = 0;	/* reset counter */
+
+		if (pktgen_lat_enabled(pkt_dev)) {
+			skb_shinfo(pkt_dev->skb)->destructor_arg = pkt_dev;
+			pkt_dev->skb->destructor = pktgen_lat_destructor;
+			atomic_inc(&pkt_dev->lat_inflight);
+		}
 	}
 
 	if (pkt_dev->delay && pkt_dev->last_ok)
 		spin(pkt_dev, pkt_dev->next_tx);
 
+	if (pkt_dev->skb->destructor == pktgen_lat_destructor)
+		pktgen_stamp_hdr(pktgen_skb_hdr(pkt_dev->skb));
+
 	if (pkt_dev->xmit_mode == M_NETIF_RECEIVE) {
 		skb = pkt_dev->skb;
 		skb->protocol = eth_type_trans(skb, skb->dev);
@@ -3588,6 +3722,15 @@ static void pktgen_xmit(struct pktgen_dev *pkt_dev)
 out:
 	local_bh_enable();
 
+	/* Leave a sent LATENCY skb to the device, so that it is freed on
+	 * TX completion rather than when the next one gets built.
+	 */
+	if (pkt_dev->skb->destructor == pktgen_lat_destructor &&
+	    (pkt_dev->last_ok || pkt_dev->xmit_mode != M_START_XMIT)) {
+		consume_skb(pkt_dev->skb);
+		pkt_dev->skb = NULL;
+	}
+
 	/* If pkt_dev->count is zero, then run forever */
 	if ((pkt_dev->count != 0) && (pkt_dev->sofar >= pkt_dev->count)) {
 		pktgen_wait_for_skb(pkt_dev);
@@ -3887,9 +4030,33 @@ static void _rem_dev_from_if_list(struct pktgen_thread *t,
 	if_unlock(t);
 }
 
+/* Wait for the LATENCY skbs still queued on the device, which point back at
+ * pkt_dev. Returns false if pkt_dev must be leaked to them instead: they are
+ * stuck in a queue that isn't draining, and the module is pinned so that
+ * pktgen_lat_destructor() stays around. Only a module unload, which can't
+ * be refused, keeps waiting for as long as it takes.
+ */
+static bool pktgen_lat_drain(struct pktgen_dev *pkt_dev)
+{
+	unsigned long timeout = jiffies + msecs_to_jiffies(PKTGEN_LAT_DRAIN_MS);
+
+	while (atomic_read(&pkt_dev->lat_inflight)) {
+		if (time_after(jiffies, timeout) && try_module_get(THIS_MODULE)) {
+			pr_warn("%s: %d LATENCY skbs not released, leaking the device\n",
+				pkt_dev->odevname,
+				atomic_read(&pkt_dev->lat_inflight));
+			return false;
+		}
+		msleep(20);
+	}
+	return true;
+}
+
 static int pktgen_remove_device(struct pktgen_thread *t,
 				struct pktgen_dev *pkt_dev)
 {
+	bool drained;
+
 	pr_debug("remove_device pkt_dev=%p\n", pkt_dev);
 
 	if (pkt_dev->running) {
@@ -3897,6 +4064,8 @@ static int pktgen_remove_device(struct pktgen_thread *t,
 		pktgen_stop_device(pkt_dev);
 	}
 
+	drained = pktgen_lat_drain(pkt_dev);
+
 	/* Dis-associate from the interface */
 
 	if (pkt_dev->odev) {
@@ -3918,7 +4087,8 @@ static int pktgen_remove_device(struct pktgen_thread *t,
 	vfree(pkt_dev->flows);
 	if (pkt_dev->page)
 		put_page(pkt_dev->page);
-	kfree_rcu(pkt_dev, rcu);
+	if (drained)
+		kfree_rcu(pkt_dev, rcu);
 	return 0;
 }
 
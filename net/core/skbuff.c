@@ -79,6 +79,8 @@
 #include <linux/capability.h>
 #include <linux/user_namespace.h>
 #include <linux/indirect_call_wrapper.h>
+#include <linux/shrinker.h>
+#include <linux/workqueue.h>
 
 #include "dev.h"
 #include "sock_destructor.h"
@@ -191,11 +193,21 @@ static void *page_frag_alloc_1k(struct page_frag_1k *nc, gfp_t gfp_mask)
 
 #endif
 
+/* Heads of this size, big enough for a 1500 bytes MTU frame, are recycled
+ * through a per-cpu cache instead of going back to the page allocator.
+ * Requests down to NAPI_DATA_CACHE_MIN are rounded up to it.
+ */
+#define NAPI_DATA_CACHE_BUF	SZ_2K
+#define NAPI_DATA_CACHE_MIN	(NAPI_DATA_CACHE_BUF * 3 / 4)
+#define NAPI_DATA_CACHE_SIZE	64
+
 struct napi_alloc_cache {
 	struct page_frag_cache page;
 	struct page_frag_1k page_small;
 	unsigned int skb_count;
 	void *skb_cache[NAPI_SKB_CACHE_SIZE];
+	unsigned int data_count;
+	void *data_cache[NAPI_DATA_CACHE_SIZE];
 };
 
 static DEFINE_PER_CPU(struct page_frag_cache, netdev_alloc_cache);
@@ -680,6 +692,21 @@ struct sk_buff *__napi_alloc_skb(struct napi_struct *napi, unsigned int len,
 
 		data = page_frag_alloc_1k(&nc->page_small, gfp_mask);
 		pfmemalloc = NAPI_SMALL_PAGE_PFMEMALLOC(nc->page_small);
+	} else if (SKB_HEAD_ALIGN(len) > NAPI_DATA_CACHE_MIN &&
+		   SKB_HEAD_ALIGN(len) <= NAPI_DATA_CACHE_BUF) {
+		struct softnet_data *sd = this_cpu_ptr(&softnet_data);
+
+		len = NAPI_DATA_CACHE_BUF;
+
+		if (nc->data_count) {
+			data = nc->data_cache[--nc->data_count];
+			pfmemalloc = false;
+			sd->skb_data_cache_hit++;
+		} else {
+			data = page_frag_alloc(&nc->page, len, gfp_mask);
+			pfmemalloc = nc->page.pfmemalloc;
+			sd->skb_data_cache_miss++;
+		}
 	} else {
 		len = SKB_HEAD_ALIGN(len);
 
@@ -750,20 +777,120 @@ static void skb_clone_fraglist(struct sk_buff *skb)
 		skb_get(list);
 }
 
-static void skb_free_head(struct sk_buff *skb)
+/* Keep a dead head of the cached size for __napi_alloc_skb(). Any page
+ * fragment of that size will do, as long as it may be used for non
+ * emergency allocations on this node.
+ */
+static bool napi_data_cache_put(struct sk_buff *skb, unsigned char *head)
+{
+	struct napi_alloc_cache *nc = this_cpu_ptr(&napi_alloc_cache);
+	struct page *page;
+
+	if (skb_end_offset(skb) != SKB_WITH_OVERHEAD(NAPI_DATA_CACHE_BUF) ||
+	    nc->data_count == NAPI_DATA_CACHE_SIZE)
+		return false;
+
+	page = virt_to_head_page(head);
+	if (page_is_pfmemalloc(page) || page_to_nid(page) != numa_mem_id())
+		return false;
+
+	nc->data_cache[nc->data_count++] = head;
+	return true;
+}
+
+static void napi_data_cache_drain(struct napi_alloc_cache *nc)
+{
+	while (nc->data_count)
+		skb_free_frag(nc->data_cache[--nc->data_count]);
+}
+
+/* The softirq side of the cache is lockless, so under memory pressure each
+ * CPU is asked to give its heads back itself, with BHs off.
+ */
+static DEFINE_PER_CPU(struct work_struct, napi_data_cache_work);
+
+static void napi_data_cache_drain_work(struct work_struct *work)
+{
+	local_bh_disable();
+	napi_data_cache_drain(this_cpu_ptr(&napi_alloc_cache));
+	local_bh_enable();
+}
+
+static unsigned long napi_data_cache_shrink_count(struct shrinker *shrinker,
+						  struct shrink_control *sc)
+{
+	unsigned long count = 0;
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		/* Only an estimate, softirqs change it under us */
+		count += data_race(per_cpu(napi_alloc_cache, cpu).data_count);
+	}
+
+	return count ?: SHRINK_EMPTY;
+}
+
+static unsigned long napi_data_cache_shrink_scan(struct shrinker *shrinker,
+						 struct shrink_control *sc)
+{
+	unsigned long freed = 0;
+	unsigned int count;
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		/* Racy as above, the work drains whatever is there by then */
+		count = data_race(per_cpu(napi_alloc_cache, cpu).data_count);
+		if (!count)
+			continue;
+
+		queue_work_on(cpu, system_wq,
+			      per_cpu_ptr(&napi_data_cache_work, cpu));
+		freed += count;
+	}
+
+	return freed;
+}
+
+static struct shrinker napi_data_cache_shrinker = {
+	.count_objects	= napi_data_cache_shrink_count,
+	.scan_objects	= napi_data_cache_shrink_scan,
+	.seeks		= DEFAULT_SEEKS,
+};
+
+/* @cpu is gone, nothing can touch its cache anymore */
+void napi_data_cache_cpu_dead(unsigned int cpu)
+{
+	napi_data_cache_drain(per_cpu_ptr(&napi_alloc_cache, cpu));
+}
+
+static void __init napi_data_cache_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		INIT_WORK(per_cpu_ptr(&napi_data_cache_work, cpu),
+			  napi_data_cache_drain_work);
+
+	if (register_shrinker(&napi_data_cache_shrinker, "skb-data-cache"))
+		pr_warn("skb head cache won't be drained under memory pressure\n");
+}
+
+static void skb_free_head(struct sk_buff *skb, bool napi_safe)
 {
 	unsigned char *head = skb->head;
 
 	if (skb->head_frag) {
 		if (skb_pp_recycle(skb, head))
 			return;
+		if (napi_safe && napi_data_cache_put(skb, head))
+			return;
 		skb_free_frag(head);
 	} else {
 		kfree(head);
 	}
 }
 
-static void skb_release_data(struct sk_buff *skb)
+static void skb_release_data(struct sk_buff *skb, bool napi_safe)
 {
 	struct skb_shared_info *shinfo = skb_shinfo(skb);
 	int i;
@@ -788,7 +915,7 @@ static void skb_release_data(struct sk_buff *skb)
 	if (shinfo->frag_list)
 		kfree_skb_list(shinfo->frag_list);
 
-	skb_free_head(skb);
+	skb_free_head(skb, napi_safe);
 exit:
 	/* When we clone an SKB we copy the reycling bit. The pp_recycle
 	 * bit is only set on the head though, so in order to avoid races
@@ -849,11 +976,11 @@ void skb_release_head_state(struct sk_buff *skb)
 }
 
 /* Free everything but the sk_buff shell. */
-static void skb_release_all(struct sk_buff *skb)
+static void skb_release_all(struct sk_buff *skb, bool napi_safe)
 {
 	skb_release_head_state(skb);
 	if (likely(skb->head))
-		skb_release_data(skb);
+		skb_release_data(skb, napi_safe);
 }
 
 /**
@@ -867,7 +994,7 @@ static void skb_release_all(struct sk_buff *skb)
 
 void __kfree_skb(struct sk_buff *skb)
 {
-	skb_release_all(skb);
+	skb_release_all(skb, false);
 	kfree_skbmem(skb);
 }
 EXPORT_SYMBOL(__kfree_skb);
@@ -1047,7 +1174,7 @@ EXPORT_SYMBOL(consume_skb);
 void __consume_stateless_skb(struct sk_buff *skb)
 {
 	trace_consume_skb(skb);
-	skb_release_data(skb);
+	skb_release_data(skb, false);
 	kfree_skbmem(skb);
 }
 
@@ -1072,7 +1199,7 @@ static void napi_skb_cache_put(struct sk_buff *skb)
 
 void __kfree_skb_defer(struct sk_buff *skb)
 {
-	skb_release_all(skb);
+	skb_release_all(skb, true);
 	napi_skb_cache_put(skb);
 }
 
@@ -1110,7 +1237,7 @@ void napi_consume_skb(struct sk_buff *skb, int budget)
 		return;
 	}
 
-	skb_release_all(skb);
+	skb_release_all(skb, true);
 	napi_skb_cache_put(skb);
 }
 EXPORT_SYMBOL(napi_consume_skb);
@@ -1241,7 +1368,7 @@ EXPORT_SYMBOL_GPL(alloc_skb_for_msg);
  */
 struct sk_buff *skb_morph(struct sk_buff *dst, struct sk_buff *src)
 {
-	skb_release_all(dst);
+	skb_release_all(dst, false);
 	return __skb_clone(dst, src);
 }
 EXPORT_SYMBOL_GPL(skb_morph);
@@ -1869,9 +1996,9 @@ int pskb_expand_head(struct sk_buff *skb, int nhead, int ntail,
 		if (skb_has_frag_list(skb))
 			skb_clone_fraglist(skb);
 
-		skb_release_data(skb);
+		skb_release_data(skb, false);
 	} else {
-		skb_free_head(skb);
+		skb_free_head(skb, false);
 	}
 	off = (data + nhead) - skb->head;
 
@@ -2814,6 +2941,26 @@ static int __skb_send_sock(struct sock *sk, struct sk_buff *skb, int offset,
 		struct msghdr msg;
 
 		slen = min_t(int, len, skb_headlen(skb) - offset);
+
+		/* A page fragment head can be passed by reference like the
+		 * frags below, instead of being copied by sendmsg.
+		 */
+		if (skb->head_frag) {
+			struct page *page = virt_to_head_page(skb->head);
+
+			ret = INDIRECT_CALL_2(sendpage, kernel_sendpage_locked,
+					      sendpage_unlocked, sk, page,
+					      skb->data + offset -
+					      (unsigned char *)page_address(page),
+					      slen, MSG_DONTWAIT);
+			if (ret <= 0)
+				goto error;
+
+			offset += ret;
+			len -= ret;
+			continue;
+		}
+
 		kv.iov_base = skb->data + offset;
 		kv.iov_len = slen;
 		memset(&msg, 0, sizeof(msg));
@@ -4552,6 +4699,7 @@ void __init skb_init(void)
 						SLAB_HWCACHE_ALIGN|SLAB_PANIC,
 						NULL);
 	skb_extensions_init();
+	napi_data_cache_init();
 }
 
 static int
@@ -6227,12 +6375,12 @@ static int pskb_carve_inside_header(struct sk_buff *skb, const u32 off,
 			skb_frag_ref(skb, i);
 		if (skb_has_frag_list(skb))
 			skb_clone_fraglist(skb);
-		skb_release_data(skb);
+		skb_release_data(skb, false);
 	} else {
 		/* we can reuse existing recount- all we did was
 		 * relocate values
 		 */
-		skb_free_head(skb);
+		skb_free_head(skb, false);
 	}
 
 	skb->head = data;
@@ -6367,7 +6515,7 @@ static int pskb_carve_inside_nonlinear(struct sk_buff *skb, const u32 off,
 		kfree(data);
 		return -ENOMEM;
 	}
-	skb_release_data(skb);
+	skb_release_data(skb, false);
 
 	skb->head = data;
 	skb->head_frag = 0;
@@ -11,6 +11,8 @@
 #include <linux/rhashtable.h>
 #include <linux/workqueue.h>
 #include <linux/refcount.h>
+#include <linux/jhash.h>
+#include <linux/percpu.h>
 
 #include <linux/if_ether.h>
 #include <linux/in6.h>
@@ -98,15 +100,40 @@ struct fl_flow_tmplt {
 	struct tcf_chain *chain;
 };
 
+/* With many masks, software classification walks all of them and dissects
+ * the packet again for each one.  Once a classifier has FL_CACHE_MIN_MASKS
+ * masks, the result of the walk is cached per CPU, keyed by the packet's
+ * key dissected once with every flower key.  Any filter insertion, removal
+ * or replacement bumps cache_gen, which invalidates all cached results.
+ */
+#define FL_CACHE_SIZE		32
+#define FL_CACHE_MIN_MASKS	8
+
+struct fl_cache_entry {
+	struct fl_flow_key key;
+	struct cls_fl_filter *filter;	/* NULL if no filter matched */
+	u64 gen;
+};
+
+struct fl_cache {
+	struct fl_cache_entry entries[FL_CACHE_SIZE];
+};
+
 struct cls_fl_head {
 	struct rhashtable ht;
 	spinlock_t masks_lock; /* Protect masks list */
 	struct list_head masks;
+	unsigned int nr_masks;
 	struct list_head hw_filters;
 	struct rcu_work rwork;
 	struct idr handle_idr;
+	struct fl_cache __percpu *cache;
+	atomic64_t cache_gen;
 };
 
+static struct flow_dissector fl_cache_dissector __read_mostly;
+static DEFINE_PER_CPU(struct fl_flow_key, fl_cache_key);
+
 struct cls_fl_filter {
 	struct fl_flow_mask *mask;
 	struct rhash_head ht_node;
@@ -305,12 +332,28 @@ static u16 fl_ct_info_to_flower_map[] = {
 					TCA_FLOWER_KEY_CT_FLAGS_NEW,
 };
 
-static int fl_classify(struct sk_buff *skb, const struct tcf_proto *tp,
-		       struct tcf_result *res)
+static void fl_dissect(struct sk_buff *skb, struct flow_dissector *dissector,
+		       struct fl_flow_key *key, bool post_ct, u16 zone)
+{
+	skb_flow_dissect_meta(skb, dissector, key);
+	/* skb_flow_dissect() does not set n_proto in case an unknown
+	 * protocol, so do it rather here.
+	 */
+	key->basic.n_proto = skb_protocol(skb, false);
+	skb_flow_dissect_tunnel_info(skb, dissector, key);
+	skb_flow_dissect_ct(skb, dissector, key,
+			    fl_ct_info_to_flower_map,
+			    ARRAY_SIZE(fl_ct_info_to_flower_map),
+			    post_ct, zone);
+	skb_flow_dissect_hash(skb, dissector, key);
+	skb_flow_dissect(skb, dissector, key,
+			 FLOW_DISSECTOR_F_STOP_BEFORE_ENCAP);
+}
+
+static struct cls_fl_filter *fl_masks_lookup(struct cls_fl_head *head,
+					     struct sk_buff *skb,
+					     bool post_ct, u16 zone)
 {
-	struct cls_fl_head *head = rcu_dereference_bh(tp->root);
-	bool post_ct = tc_skb_cb(skb)->post_ct;
-	u16 zone = tc_skb_cb(skb)->zone;
 	struct fl_flow_key skb_key;
 	struct fl_flow_mask *mask;
 	struct cls_fl_filter *f;
@@ -318,30 +361,92 @@ static int fl_classify(struct sk_buff *skb, const struct tcf_proto *tp,
 	list_for_each_entry_rcu(mask, &head->masks, list) {
 		flow_dissector_init_keys(&skb_key.control, &skb_key.basic);
 		fl_clear_masked_range(&skb_key, mask);
-
-		skb_flow_dissect_meta(skb, &mask->dissector, &skb_key);
-		/* skb_flow_dissect() does not set n_proto in case an unknown
-		 * protocol, so do it rather here.
-		 */
-		skb_key.basic.n_proto = skb_protocol(skb, false);
-		skb_flow_dissect_tunnel_info(skb, &mask->dissector, &skb_key);
-		skb_flow_dissect_ct(skb, &mask->dissector, &skb_key,
-				    fl_ct_info_to_flower_map,
-				    ARRAY_SIZE(fl_ct_info_to_flower_map),
-				    post_ct, zone);
-		skb_flow_dissect_hash(skb, &mask->dissector, &skb_key);
-		skb_flow_dissect(skb, &mask->dissector, &skb_key,
-				 FLOW_DISSECTOR_F_STOP_BEFORE_ENCAP);
+		fl_dissect(skb, &mask->dissector, &skb_key, post_ct, zone);
 
 		f = fl_mask_lookup(mask, &skb_key);
-		if (f && !tc_skip_sw(f->flags)) {
-			*res = f->res;
-			return tcf_exts_exec(skb, &f->exts, res);
-		}
+		if (f && !tc_skip_sw(f->flags))
+			return f;
+	}
+	return NULL;
+}
+
+static struct cls_fl_filter *fl_cache_lookup(struct cls_fl_head *head,
+					     struct fl_cache *cache,
+					     struct sk_buff *skb,
+					     bool post_ct, u16 zone)
+{
+	struct fl_flow_key *key = this_cpu_ptr(&fl_cache_key);
+	struct fl_cache_entry *entry;
+	struct cls_fl_filter *f;
+	u64 gen;
+
+	/* Pairs with fl_cache_invalidate(): a result computed after reading
+	 * gen is only cached under that gen if no filter changed meanwhile.
+	 */
+	gen = atomic64_read_acquire(&head->cache_gen);
+
+	memset(key, 0, sizeof(*key));
+	fl_dissect(skb, &fl_cache_dissector, key, post_ct, zone);
+
+	entry = &this_cpu_ptr(cache)->entries[jhash2((u32 *)key,
+						     sizeof(*key) / sizeof(u32),
+						     0) % FL_CACHE_SIZE];
+	if (entry->gen == gen && !memcmp(&entry->key, key, sizeof(*key)))
+		return entry->filter;
+
+	f = fl_masks_lookup(head, skb, post_ct, zone);
+	entry->key = *key;
+	entry->filter = f;
+	entry->gen = gen;
+	return f;
+}
+
+static int fl_classify(struct sk_buff *skb, const struct tcf_proto *tp,
+		       struct tcf_result *res)
+{
+	struct cls_fl_head *head = rcu_dereference_bh(tp->root);
+	struct fl_cache *cache = READ_ONCE(head->cache);
+	bool post_ct = tc_skb_cb(skb)->post_ct;
+	u16 zone = tc_skb_cb(skb)->zone;
+	struct cls_fl_filter *f;
+
+	if (cache && READ_ONCE(head->nr_masks) >= FL_CACHE_MIN_MASKS)
+		f = fl_cache_lookup(head, cache, skb, post_ct, zone);
+	else
+		f = fl_masks_lookup(head, skb, post_ct, zone);
+
+	if (f) {
+		*res = f->res;
+		return tcf_exts_exec(skb, &f->exts, res);
 	}
 	return -1;
 }
 
+static void fl_cache_invalidate(struct cls_fl_head *head)
+{
+	/* Order the filter list update before the new gen, so that a
+	 * classifier that sees the new gen also sees the new filters.
+	 */
+	smp_mb__before_atomic();
+	atomic64_inc(&head->cache_gen);
+}
+
+static void fl_cache_enable(struct cls_fl_head *head)
+{
+	struct fl_cache __percpu *cache;
+
+	BUILD_BUG_ON(sizeof(struct fl_cache) > PCPU_MIN_UNIT_SIZE);
+
+	if (READ_ONCE(head->cache) ||
+	    READ_ONCE(head->nr_masks) < FL_CACHE_MIN_MASKS)
+		return;
+
+	/* Without the cache, classification just walks the masks. */
+	cache = alloc_percpu(struct fl_cache);
+	if (cache && cmpxchg(&head->cache, NULL, cache))
+		free_percpu(cache);
+}
+
 static int fl_init(struct tcf_proto *tp)
 {
 	struct cls_fl_head *head;
@@ -353,6 +458,7 @@ static int fl_init(struct tcf_proto *tp)
 	spin_lock_init(&head->masks_lock);
 	INIT_LIST_HEAD_RCU(&head->masks);
 	INIT_LIST_HEAD(&head->hw_filters);
+	atomic64_set(&head->cache_gen, 1);
 	rcu_assign_pointer(tp->root, head);
 	idr_init(&head->handle_idr);
 
@@ -394,6 +500,7 @@ static bool fl_mask_put(struct cls_fl_head *head, struct fl_flow_mask *mask)
 
 	spin_lock(&head->masks_lock);
 	list_del_rcu(&mask->list);
+	WRITE_ONCE(head->nr_masks, head->nr_masks - 1);
 	spin_unlock(&head->masks_lock);
 
 	tcf_queue_work(&mask->rwork, fl_mask_free_work);
@@ -552,6 +659,7 @@ static int __fl_delete(struct tcf_proto *tp, struct cls_fl_filter *f,
 	idr_remove(&head->handle_idr, f->handle);
 	list_del_rcu(&f->list);
 	spin_unlock(&tp->lock);
+	fl_cache_invalidate(head);
 
 	*last = fl_mask_put(head, f->mask);
 	if (!tc_skip_hw(f->flags))
@@ -569,6 +677,7 @@ static void fl_destroy_sleepable(struct work_struct *work)
 						rwork);
 
 	rhashtable_destroy(&head->ht);
+	free_percpu(head->cache);
 	kfree(head);
 	module_put(THIS_MODULE);
 }
@@ -2030,6 +2139,7 @@ static struct fl_flow_mask *fl_create_new_mask(struct cls_fl_head *head,
 
 	spin_lock(&head->masks_lock);
 	list_add_tail_rcu(&newmask->list, &head->masks);
+	WRITE_ONCE(head->nr_masks, head->nr_masks + 1);
 	spin_unlock(&head->masks_lock);
 
 	return newmask;
@@ -2316,6 +2426,8 @@ static int fl_change(struct net *net, struct sk_buff *in_skb,
 		list_add_tail_rcu(&fnew->list, &fnew->mask->filters);
 		spin_unlock(&tp->lock);
 	}
+	fl_cache_invalidate(head);
+	fl_cache_enable(head);
 
 	*arg = fnew;
 
@@ -2330,9 +2442,11 @@ static int fl_change(struct net *net, struct sk_buff *in_skb,
 	spin_unlock(&tp->lock);
 	if (!tc_skip_hw(fnew->flags))
 		fl_hw_destroy_filter(tp, fnew, rtnl_held, NULL);
-	if (in_ht)
+	if (in_ht) {
 		rhashtable_remove_fast(&fnew->mask->ht, &fnew->ht_node,
 				       fnew->mask->filter_ht_params);
+		fl_cache_invalidate(head);
+	}
 errout_mask:
 	fl_mask_put(head, fnew->mask);
 errout:
@@ -3458,6 +3572,11 @@ static struct tcf_proto_ops cls_fl_ops __read_mostly = {
 
 static int __init cls_fl_init(void)
 {
+	static struct fl_flow_key full_mask __initdata;
+
+	memset(&full_mask, 0xff, sizeof(full_mask));
+	fl_init_dissector(&fl_cache_dissector, &full_mask);
+
 	return register_tcf_proto_ops(&cls_fl_ops);
 }
 
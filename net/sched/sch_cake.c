@@ -80,6 +80,13 @@
 #define CAKE_FLOW_MASK 63
 #define CAKE_FLOW_NAT_FLAG 64
 
+/* Slack allowed on the shaper watchdog.  The shaper schedule is not reset
+ * when the timer fires late, so a late wakeup releases the packets that
+ * became due meanwhile in one qdisc run instead of taking one timer
+ * interrupt per packet.  The average rate is unchanged.
+ */
+#define CAKE_WATCHDOG_SLACK_NS (50 * NSEC_PER_USEC)
+
 /* struct cobalt_params - contains codel and blue parameters
  * @interval:	codel initial drop rate
  * @target:     maximum persistent sojourn time & blue update rate
@@ -1967,7 +1974,8 @@ static struct sk_buff *cake_dequeue(struct Qdisc *sch)
 			       ktime_to_ns(q->failsafe_next_packet));
 
 		sch->qstats.overlimits++;
-		qdisc_watchdog_schedule_ns(&q->watchdog, next);
+		qdisc_watchdog_schedule_range_ns(&q->watchdog, next,
+						 CAKE_WATCHDOG_SLACK_NS);
 		return NULL;
 	}
 
@@ -2199,7 +2207,8 @@ static struct sk_buff *cake_dequeue(struct Qdisc *sch)
 		u64 next = min(ktime_to_ns(q->time_next_packet),
 			       ktime_to_ns(q->failsafe_next_packet));
 
-		qdisc_watchdog_schedule_ns(&q->watchdog, next);
+		qdisc_watchdog_schedule_range_ns(&q->watchdog, next,
+						 CAKE_WATCHDOG_SLACK_NS);
 	} else if (!sch->q.qlen) {
 		int i;
 
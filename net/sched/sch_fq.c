@@ -50,6 +50,12 @@
 #include <net/tcp_states.h>
 #include <net/tcp.h>
 
+/* Kept out of the TCA_FQ_* uapi, whose next numbers belong to upstream */
+static unsigned int fq_pacing_granularity __read_mostly;
+module_param_named(pacing_granularity_ns, fq_pacing_granularity, uint, 0644);
+MODULE_PARM_DESC(pacing_granularity_ns,
+		 "send paced packets due within this many ns, for new fq qdiscs");
+
 struct fq_skb_cb {
 	u64	        time_to_send;
 };
@@ -132,6 +138,7 @@ struct fq_sched_data {
 	u64		stat_allocation_errors;
 
 	u32		timer_slack; /* hrtimer slack in ns */
+	u32		pacing_granularity; /* in ns */
 	struct qdisc_watchdog watchdog;
 };
 
@@ -498,16 +505,22 @@ static int fq_enqueue(struct sk_buff *skb, struct Qdisc *sch,
 
 static void fq_check_throttled(struct fq_sched_data *q, u64 now)
 {
-	unsigned long sample;
+	unsigned long sample = 0;
 	struct rb_node *p;
+	u64 due;
 
-	if (q->time_next_delayed_flow > now)
+	/* Flows due within pacing_granularity are released in the same
+	 * round, instead of each one arming the watchdog again.
+	 */
+	due = now + q->pacing_granularity;
+	if (q->time_next_delayed_flow > due)
 		return;
 
 	/* Update unthrottle latency EWMA.
 	 * This is cheap and can help diagnosing timer/latency problems.
 	 */
-	sample = (unsigned long)(now - q->time_next_delayed_flow);
+	if (now > q->time_next_delayed_flow)
+		sample = (unsigned long)(now - q->time_next_delayed_flow);
 	q->unthrottle_latency_ns -= q->unthrottle_latency_ns >> 3;
 	q->unthrottle_latency_ns += sample >> 3;
 
@@ -515,7 +528,7 @@ static void fq_check_throttled(struct fq_sched_data *q, u64 now)
 	while ((p = rb_first(&q->delayed)) != NULL) {
 		struct fq_flow *f = rb_entry(p, struct fq_flow, rate_node);
 
-		if (f->time_next_packet > now) {
+		if (f->time_next_packet > due) {
 			q->time_next_delayed_flow = f->time_next_packet;
 			break;
 		}
@@ -570,7 +583,7 @@ static struct sk_buff *fq_dequeue(struct Qdisc *sch)
 		u64 time_next_packet = max_t(u64, fq_skb_cb(skb)->time_to_send,
 					     f->time_next_packet);
 
-		if (now < time_next_packet) {
+		if (now + q->pacing_granularity < time_next_packet) {
 			head->first = f->next;
 			f->time_next_packet = time_next_packet;
 			fq_flow_set_throttled(q, f);
@@ -630,6 +643,13 @@ static struct sk_buff *fq_dequeue(struct Qdisc *sch)
 			len = NSEC_PER_SEC;
 			q->stat_pkts_too_long++;
 		}
+		/* Sent ahead of schedule because of pacing_granularity:
+		 * keep pacing from the intended departure time.
+		 */
+		if (now < f->time_next_packet) {
+			f->time_next_packet += len;
+			goto out;
+		}
 		/* Account for schedule/timers drifts.
 		 * f->time_next_packet was set when prior packet was sent,
 		 * and current time (@now) can be too late by tens of us.
@@ -947,6 +967,7 @@ static int fq_init(struct Qdisc *sch, struct nlattr *opt,
 	q->low_rate_threshold	= 550000 / 8;
 
 	q->timer_slack = 10 * NSEC_PER_USEC; /* 10 usec of hrtimer slack */
+	q->pacing_granularity = READ_ONCE(fq_pacing_granularity);
 
 	q->horizon = 10ULL * NSEC_PER_SEC; /* 10 seconds */
 	q->horizon_drop = 1; /* by default, drop packets beyond horizon */
@@ -511,15 +511,55 @@ static struct sk_buff *xsk_build_skb(struct xdp_sock *xs,
 	return skb;
 }
 
+/* Undo the completion ring reservation of an skb that was not sent */
+static void xsk_cancel_skb(struct xdp_sock *xs, struct sk_buff *skb)
+{
+	unsigned long flags;
+
+	skb->destructor = sock_wfree;
+	spin_lock_irqsave(&xs->pool->cq_lock, flags);
+	xskq_prod_cancel(xs->pool->cq);
+	spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
+	/* Free skb without triggering the perf drop trace */
+	consume_skb(skb);
+}
+
+/* Send the skb built from the Tx descriptor at @cons. If the driver is busy,
+ * the descriptor and any released after it go back on the Tx ring.
+ */
+static int xsk_xmit_skb(struct xdp_sock *xs, struct sk_buff *skb, u32 cons,
+			bool more)
+{
+	int err;
+
+	err = __dev_direct_xmit(skb, xs->queue_id, more);
+	if (err == NETDEV_TX_BUSY) {
+		/* Tell user-space to retry the send */
+		xsk_cancel_skb(xs, skb);
+		xs->tx->cached_cons = cons;
+		return -EAGAIN;
+	}
+
+	/* Ignore NET_XMIT_CN as packet might have been sent */
+	if (err == NET_XMIT_DROP) {
+		/* SKB completed but not sent */
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
 static int __xsk_generic_xmit(struct sock *sk)
 {
 	struct xdp_sock *xs = xdp_sk(sk);
+	struct sk_buff *skb, *pending = NULL;
 	u32 max_batch = TX_BATCH_SIZE;
+	u32 cons, pending_cons = 0;
 	bool sent_frame = false;
 	struct xdp_desc desc;
-	struct sk_buff *skb;
 	unsigned long flags;
 	int err = 0;
+	bool found;
 
 	mutex_lock(&xs->mutex);
 
@@ -532,10 +572,35 @@ static int __xsk_generic_xmit(struct sock *sk)
 	if (xs->queue_id >= xs->dev->real_num_tx_queues)
 		goto out;
 
-	while (xskq_cons_peek_desc(xs->tx, &desc, xs->pool)) {
+	/* Each skb is held back until the next one has been built, so the
+	 * driver is only asked to defer its doorbell when another frame
+	 * really follows, and the last frame handed to it rings it.
+	 */
+	for (;;) {
+		/* Don't refresh the ring while a frame is held back, as that
+		 * would publish the consumer past its descriptor.
+		 */
+		if (pending)
+			found = xskq_cons_read_desc(xs->tx, &desc, xs->pool);
+		else
+			found = xskq_cons_peek_desc(xs->tx, &desc, xs->pool);
+		if (!found) {
+			if (!pending) {
+				xs->tx->queue_empty_descs++;
+				break;
+			}
+
+			err = xsk_xmit_skb(xs, pending, pending_cons, false);
+			pending = NULL;
+			if (err)
+				goto out;
+			sent_frame = true;
+			continue;
+		}
+
 		if (max_batch-- == 0) {
 			err = -EAGAIN;
-			goto out;
+			break;
 		}
 
 		/* This is the backpressure mechanism for the Tx path.
@@ -546,7 +611,7 @@ static int __xsk_generic_xmit(struct sock *sk)
 		spin_lock_irqsave(&xs->pool->cq_lock, flags);
 		if (xskq_prod_reserve(xs->pool->cq)) {
 			spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
-			goto out;
+			break;
 		}
 		spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
 
@@ -556,34 +621,41 @@ static int __xsk_generic_xmit(struct sock *sk)
 			spin_lock_irqsave(&xs->pool->cq_lock, flags);
 			xskq_prod_cancel(xs->pool->cq);
 			spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
-			goto out;
-		}
-
-		err = __dev_direct_xmit(skb, xs->queue_id);
-		if  (err == NETDEV_TX_BUSY) {
-			/* Tell user-space to retry the send */
-			skb->destructor = sock_wfree;
-			spin_lock_irqsave(&xs->pool->cq_lock, flags);
-			xskq_prod_cancel(xs->pool->cq);
-			spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
-			/* Free skb without triggering the perf drop trace */
-			consume_skb(skb);
-			err = -EAGAIN;
-			goto out;
+			break;
 		}
 
+		cons = xs->tx->cached_cons;
 		xskq_cons_release(xs->tx);
-		/* Ignore NET_XMIT_CN as packet might have been sent */
-		if (err == NET_XMIT_DROP) {
-			/* SKB completed but not sent */
-			err = -EBUSY;
-			goto out;
+
+		if (pending) {
+			err = xsk_xmit_skb(xs, pending, pending_cons, true);
+			if (err == -EAGAIN) {
+				/* skb's descriptor went back on the ring too */
+				xsk_cancel_skb(xs, skb);
+				pending = NULL;
+				goto out;
+			}
+			if (!err)
+				sent_frame = true;
 		}
 
-		sent_frame = true;
+		pending = skb;
+		pending_cons = cons;
+		if (err)
+			break;
 	}
 
-	xs->tx->queue_empty_descs++;
+	/* The driver may be deferring its doorbell for the frames it got so
+	 * far, so the held back frame must be sent, with more cleared.
+	 */
+	if (pending) {
+		int ret = xsk_xmit_skb(xs, pending, pending_cons, false);
+
+		if (ret)
+			err = ret;
+		else
+			sent_frame = true;
+	}
 
 out:
 	if (sent_frame)
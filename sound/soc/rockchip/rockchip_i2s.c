@@ -21,6 +21,7 @@
 #include <sound/dmaengine_pcm.h>
 
 #include "rockchip_i2s.h"
+#include "rockchip_i2s_low_latency.h"
 
 #define DRV_NAME "rockchip-i2s"
 
@@ -347,6 +348,28 @@ static int rockchip_i2s_set_fmt(struct snd_soc_dai *cpu_dai,
 	return ret;
 }
 
+static void rockchip_i2s_set_fifo_level(struct rk_i2s_dev *i2s,
+					struct snd_pcm_substream *substream,
+					struct snd_pcm_hw_params *params)
+{
+	bool low_latency = rockchip_i2s_low_latency(params);
+	struct snd_dmaengine_dai_dma_data *dma_data;
+
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		regmap_update_bits(i2s->regmap, I2S_DMACR, I2S_DMACR_TDL_MASK,
+				   I2S_DMACR_TDL(low_latency ?
+						 I2S_LOW_LATENCY_TDL : 16));
+		dma_data = &i2s->playback_dma_data;
+	} else {
+		regmap_update_bits(i2s->regmap, I2S_DMACR, I2S_DMACR_RDL_MASK,
+				   I2S_DMACR_RDL(low_latency ?
+						 I2S_LOW_LATENCY_RDL : 16));
+		dma_data = &i2s->capture_dma_data;
+	}
+
+	rockchip_i2s_set_low_latency_dma(dma_data, low_latency);
+}
+
 static int rockchip_i2s_hw_params(struct snd_pcm_substream *substream,
 				  struct snd_pcm_hw_params *params,
 				  struct snd_soc_dai *dai)
@@ -447,10 +470,7 @@ static int rockchip_i2s_hw_params(struct snd_pcm_substream *substream,
 		regmap_write(i2s->grf, i2s->pins->reg_offset, val);
 	}
 
-	regmap_update_bits(i2s->regmap, I2S_DMACR, I2S_DMACR_TDL_MASK,
-			   I2S_DMACR_TDL(16));
-	regmap_update_bits(i2s->regmap, I2S_DMACR, I2S_DMACR_RDL_MASK,
-			   I2S_DMACR_RDL(16));
+	rockchip_i2s_set_fifo_level(i2s, substream, params);
 
 	val = I2S_CKR_TRCM_TXRX;
 	if (dai->driver->symmetric_rate && rtd->dai_link->symmetric_rate)
@@ -832,7 +852,9 @@ static int rockchip_i2s_probe(struct platform_device *pdev)
 		goto err_suspend;
 	}
 
-	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, 0);
+	/* the pl330 reports the residue per burst, the pointer is exact */
+	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL,
+					      SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP);
 	if (ret) {
 		dev_err(&pdev->dev, "Could not register PCM\n");
 		goto err_suspend;
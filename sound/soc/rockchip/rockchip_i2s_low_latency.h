@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * ALSA SoC Audio Layer - Rockchip I2S and I2S/TDM low-latency mode
+ *
+ * Streams with periods up to I2S_LOW_LATENCY_PERIOD_US run in low-latency
+ * mode: the DMAC completes their periods from its irq handler and the FIFO
+ * is kept fuller on playback and drained earlier on capture, so that it
+ * rides out more DMA service latency.
+ */
+
+#ifndef _ROCKCHIP_I2S_LOW_LATENCY_H
+#define _ROCKCHIP_I2S_LOW_LATENCY_H
+
+#include <linux/amba/pl330.h>
+#include <sound/dmaengine_pcm.h>
+#include <sound/pcm_params.h>
+
+#define I2S_LOW_LATENCY_PERIOD_US	2000
+#define I2S_LOW_LATENCY_TDL		24
+#define I2S_LOW_LATENCY_RDL		8
+
+static inline bool rockchip_i2s_low_latency(struct snd_pcm_hw_params *params)
+{
+	return (u64)params_period_size(params) * USEC_PER_SEC <=
+	       (u64)I2S_LOW_LATENCY_PERIOD_US * params_rate(params);
+}
+
+static inline void
+rockchip_i2s_set_low_latency_dma(struct snd_dmaengine_dai_dma_data *dma_data,
+				 bool low_latency)
+{
+	static struct pl330_slave_config low_latency_dma = {
+		.cyclic_irq = true,
+	};
+
+	if (low_latency) {
+		dma_data->peripheral_config = &low_latency_dma;
+		dma_data->peripheral_size = sizeof(low_latency_dma);
+	} else {
+		dma_data->peripheral_config = NULL;
+		dma_data->peripheral_size = 0;
+	}
+}
+
+#endif /* _ROCKCHIP_I2S_LOW_LATENCY_H */
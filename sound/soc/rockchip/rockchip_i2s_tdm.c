@@ -20,6 +20,7 @@
 #include <sound/dmaengine_pcm.h>
 #include <sound/pcm_params.h>
 
+#include "rockchip_i2s_low_latency.h"
 #include "rockchip_i2s_tdm.h"
 
 #define DRV_NAME "rockchip-i2s-tdm"
@@ -844,6 +845,35 @@ static int rockchip_i2s_trcm_mode(struct snd_pcm_substream *substream,
 	return 0;
 }
 
+/*
+ * Small periods get their completions from the DMAC irq handler, and
+ * FIFO thresholds that keep the TX FIFO fuller and drain the RX FIFO
+ * as soon as a burst is in, to ride out more DMA service latency.
+ */
+static void rockchip_i2s_tdm_set_fifo_level(struct rk_i2s_tdm_dev *i2s_tdm,
+					    struct snd_pcm_substream *substream,
+					    struct snd_pcm_hw_params *params)
+{
+	bool low_latency = rockchip_i2s_low_latency(params);
+	struct snd_dmaengine_dai_dma_data *dma_data;
+
+	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK) {
+		regmap_update_bits(i2s_tdm->regmap, I2S_DMACR,
+				   I2S_DMACR_TDL_MASK,
+				   I2S_DMACR_TDL(low_latency ?
+						 I2S_LOW_LATENCY_TDL : 16));
+		dma_data = &i2s_tdm->playback_dma_data;
+	} else {
+		regmap_update_bits(i2s_tdm->regmap, I2S_DMACR,
+				   I2S_DMACR_RDL_MASK,
+				   I2S_DMACR_RDL(low_latency ?
+						 I2S_LOW_LATENCY_RDL : 16));
+		dma_data = &i2s_tdm->capture_dma_data;
+	}
+
+	rockchip_i2s_set_low_latency_dma(dma_data, low_latency);
+}
+
 static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 				      struct snd_pcm_hw_params *params,
 				      struct snd_soc_dai *dai)
@@ -933,6 +963,8 @@ static int rockchip_i2s_tdm_hw_params(struct snd_pcm_substream *substream,
 				   val);
 	}
 
+	rockchip_i2s_tdm_set_fifo_level(i2s_tdm, substream, params);
+
 	return rockchip_i2s_io_multiplex(substream, dai);
 }
 
@@ -1694,7 +1726,9 @@ static int rockchip_i2s_tdm_probe(struct platform_device *pdev)
 		goto err_suspend;
 	}
 
-	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL, 0);
+	/* the pl330 reports the residue per burst, the pointer is exact */
+	ret = devm_snd_dmaengine_pcm_register(&pdev->dev, NULL,
+					      SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP);
 	if (ret) {
 		dev_err(&pdev->dev, "Could not register PCM\n");
 		goto err_suspend;
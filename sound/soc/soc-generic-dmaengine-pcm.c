@@ -142,6 +142,10 @@ dmaengine_pcm_set_runtime_hwparams(struct snd_soc_component *component,
 						  &hw,
 						  chan);
 
+	if ((pcm->flags & SND_DMAENGINE_PCM_FLAG_NO_PERIOD_WAKEUP) &&
+	    !(hw.info & SNDRV_PCM_INFO_BATCH))
+		hw.info |= SNDRV_PCM_INFO_NO_PERIOD_WAKEUP;
+
 	return snd_soc_set_runtime_hwparams(substream, &hw);
 }
 
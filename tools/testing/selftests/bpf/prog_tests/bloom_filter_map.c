@@ -32,6 +32,19 @@ static void test_fail_cases(void)
 	if (!ASSERT_LT(fd, 0, "bpf_map_create bloom filter invalid flags"))
 		close(fd);
 
+	/* Unknown map_extra flags */
+	opts.map_flags = 0;
+	opts.map_extra = 1ULL << 5;
+	fd = bpf_map_create(BPF_MAP_TYPE_BLOOM_FILTER, NULL, 0, sizeof(value), 100, &opts);
+	if (!ASSERT_LT(fd, 0, "bpf_map_create bloom filter invalid map_extra"))
+		close(fd);
+
+	/* Flags above the low 32 bits of map_extra */
+	opts.map_extra = 1ULL << 32;
+	fd = bpf_map_create(BPF_MAP_TYPE_BLOOM_FILTER, NULL, 0, sizeof(value), 100, &opts);
+	if (!ASSERT_LT(fd, 0, "bpf_map_create bloom filter invalid upper map_extra"))
+		close(fd);
+
 	fd = bpf_map_create(BPF_MAP_TYPE_BLOOM_FILTER, NULL, 0, sizeof(value), 100, NULL);
 	if (!ASSERT_GE(fd, 0, "bpf_map_create bloom filter"))
 		return;
@@ -80,6 +93,36 @@ static void test_success_cases(void)
 	close(fd);
 }
 
+static void test_blocked(void)
+{
+	LIBBPF_OPTS(bpf_map_create_opts, opts);
+	__u32 vals[1000];
+	int fd, err, i;
+
+	opts.map_extra = BPF_BLOOM_F_BLOCKED | 3;
+	fd = bpf_map_create(BPF_MAP_TYPE_BLOOM_FILTER, NULL, 0, sizeof(*vals),
+			    ARRAY_SIZE(vals), &opts);
+	if (!ASSERT_GE(fd, 0, "bpf_map_create blocked bloom filter"))
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(vals); i++) {
+		vals[i] = rand();
+		err = bpf_map_update_elem(fd, NULL, &vals[i], BPF_ANY);
+		if (!ASSERT_OK(err, "bpf_map_update_elem blocked bloom filter"))
+			goto done;
+	}
+
+	/* There must be no false negatives */
+	for (i = 0; i < ARRAY_SIZE(vals); i++) {
+		err = bpf_map_lookup_elem(fd, NULL, &vals[i]);
+		if (!ASSERT_OK(err, "bpf_map_lookup_elem blocked bloom filter"))
+			break;
+	}
+
+done:
+	close(fd);
+}
+
 static void check_bloom(struct bloom_filter_map *skel)
 {
 	struct bpf_link *link;
@@ -199,6 +242,7 @@ void test_bloom_filter_map(void)
 
 	test_fail_cases();
 	test_success_cases();
+	test_blocked();
 
 	err = setup_progs(&skel, &rand_vals, &nr_rand_vals);
 	if (err)
@@ -309,6 +309,72 @@ static void test_task_pidfd(void)
 	close(pidfd);
 }
 
+static int read_task_iter(struct bpf_link *link)
+{
+	char buf[16] = {};
+	int iter_fd, len;
+
+	iter_fd = bpf_iter_create(bpf_link__fd(link));
+	if (!ASSERT_GE(iter_fd, 0, "create_iter"))
+		return -1;
+
+	while ((len = read(iter_fd, buf, sizeof(buf))) > 0)
+		;
+	close(iter_fd);
+
+	return len;
+}
+
+static void test_task_changed(void)
+{
+	LIBBPF_OPTS(bpf_iter_attach_opts, opts);
+	union bpf_iter_link_info linfo;
+	struct bpf_iter_task *skel;
+	struct bpf_link *link;
+	int num_unknown_tid;
+
+	skel = bpf_iter_task__open_and_load();
+	if (!ASSERT_OK_PTR(skel, "bpf_iter_task__open_and_load"))
+		return;
+
+	skel->bss->tid = getpid();
+
+	memset(&linfo, 0, sizeof(linfo));
+	linfo.task.flags = BPF_ITER_TASK_F_CHANGED;
+	opts.link_info = &linfo;
+	opts.link_info_len = sizeof(linfo);
+
+	link = bpf_program__attach_iter(skel->progs.dump_task, &opts);
+	if (!link && errno == EOPNOTSUPP) {
+		/* kernel without CONFIG_SCHED_INFO */
+		test__skip();
+		goto out;
+	}
+	if (!ASSERT_OK_PTR(link, "attach_iter"))
+		goto out;
+
+	/* the first iterator sees everything */
+	if (!ASSERT_OK(read_task_iter(link), "read_first"))
+		goto free_link;
+	ASSERT_EQ(skel->bss->num_known_tid, 1, "check_first_num_known_tid");
+	ASSERT_GT(skel->bss->num_unknown_tid, 1, "check_first_num_unknown_tid");
+	num_unknown_tid = skel->bss->num_unknown_tid;
+
+	/* the second one at least us, we are running */
+	skel->bss->num_known_tid = 0;
+	skel->bss->num_unknown_tid = 0;
+	if (!ASSERT_OK(read_task_iter(link), "read_second"))
+		goto free_link;
+	ASSERT_EQ(skel->bss->num_known_tid, 1, "check_second_num_known_tid");
+	ASSERT_LT(skel->bss->num_unknown_tid, num_unknown_tid,
+		  "check_second_num_unknown_tid");
+
+free_link:
+	bpf_link__destroy(link);
+out:
+	bpf_iter_task__destroy(skel);
+}
+
 static void test_task_sleepable(void)
 {
 	struct bpf_iter_task *skel;
@@ -1574,6 +1640,8 @@ void test_bpf_iter(void)
 		test_task_pid();
 	if (test__start_subtest("task_pidfd"))
 		test_task_pidfd();
+	if (test__start_subtest("task_changed"))
+		test_task_changed();
 	if (test__start_subtest("task_sleepable"))
 		test_task_sleepable();
 	if (test__start_subtest("task_stack"))
@@ -47,8 +47,9 @@ static void cleanup_cgroups(void)
 		close(cg_fd[i]);
 }
 
-static void read_from_cgroup_iter(struct bpf_program *prog, int cgroup_fd,
-				  int order, const char *testname)
+static void __read_from_cgroup_iter(struct bpf_program *prog, int cgroup_fd,
+				    int order, const char *testname,
+				    size_t chunk)
 {
 	DECLARE_LIBBPF_OPTS(bpf_iter_attach_opts, opts);
 	union bpf_iter_link_info linfo;
@@ -75,7 +76,7 @@ static void read_from_cgroup_iter(struct bpf_program *prog, int cgroup_fd,
 	memset(buf, 0, sizeof(buf));
 	left = ARRAY_SIZE(buf);
 	p = buf;
-	while ((len = read(iter_fd, p, left)) > 0) {
+	while ((len = read(iter_fd, p, min(left, chunk))) > 0) {
 		p += len;
 		left -= len;
 	}
@@ -91,6 +92,12 @@ static void read_from_cgroup_iter(struct bpf_program *prog, int cgroup_fd,
 	bpf_link__destroy(link);
 }
 
+static void read_from_cgroup_iter(struct bpf_program *prog, int cgroup_fd,
+				  int order, const char *testname)
+{
+	__read_from_cgroup_iter(prog, cgroup_fd, order, testname, SIZE_MAX);
+}
+
 /* Invalid cgroup. */
 static void test_invalid_cgroup(struct cgroup_iter *skel)
 {
@@ -137,6 +144,21 @@ static void test_walk_preorder(struct cgroup_iter *skel)
 			      BPF_CGROUP_ITER_DESCENDANTS_PRE, "preorder");
 }
 
+/*
+ * Reads smaller than the output stop the walk after every cgroup, which
+ * must then resume where it left off on the next read().
+ */
+static void test_walk_preorder_resume(struct cgroup_iter *skel)
+{
+	snprintf(expected_output, sizeof(expected_output),
+		 PROLOGUE "%8llu\n%8llu\n%8llu\n" EPILOGUE,
+		 cg_id[PARENT], cg_id[CHILD1], cg_id[CHILD2]);
+
+	__read_from_cgroup_iter(skel->progs.cgroup_id_printer, cg_fd[PARENT],
+				BPF_CGROUP_ITER_DESCENDANTS_PRE,
+				"preorder_resume", strlen(PROLOGUE));
+}
+
 /* Postorder walk prints child and parent in order. */
 static void test_walk_postorder(struct cgroup_iter *skel)
 {
@@ -209,6 +231,8 @@ void test_cgroup_iter(void)
 		test_invalid_cgroup_spec(skel);
 	if (test__start_subtest("cgroup_iter__preorder"))
 		test_walk_preorder(skel);
+	if (test__start_subtest("cgroup_iter__preorder_resume"))
+		test_walk_preorder_resume(skel);
 	if (test__start_subtest("cgroup_iter__postorder"))
 		test_walk_postorder(skel);
 	if (test__start_subtest("cgroup_iter__ancestors_up_walk"))